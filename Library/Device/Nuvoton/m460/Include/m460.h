@@ -772,11 +772,11 @@ typedef volatile unsigned int   vu32;       ///< Define 32-bit unsigned volatile
 #include "gpio.h"
 #include "ccap.h"
 #include "ecap.h"
-#include "hbi.h"
 #include "eqei.h"
 #include "timer.h"
 #include "timer_pwm.h"
 #include "pdma.h"
+#include "hbi.h"
 #include "crypto.h"
 #include "trng.h"
 #include "fmc.h"
@@ -805,6 +805,8 @@ typedef volatile unsigned int   vu32;       ///< Define 32-bit unsigned volatile
 #include "hsotg.h"
 #include "psio.h"
 #include "bmc.h"
+#include "trace.h"
+#include "dlog.h"
 
 
 #ifdef __cplusplus
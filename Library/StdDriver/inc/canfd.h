@@ -360,11 +360,51 @@ typedef struct
     uint8_t             bBitRateSwitch;  /*!< Bit Rate Switch */
 } CANFD_TX_EVNT_ELEM_T;
 
+/* Acceptance list entry for CANFD_FltrCompile(), a single ID when u32IdLow == u32IdHigh */
+typedef struct
+{
+    uint32_t u32IdLow;                  /*!< First accepted ID */
+    uint32_t u32IdHigh;                 /*!< Last accepted ID */
+} CANFD_ID_RANGE_T;
+
+/* CANFD_FltrCompile() result for one ID type */
+typedef struct
+{
+    uint32_t u32RangeElems;             /*!< Range filter elements programmed */
+    uint32_t u32MaskElems;              /*!< Classic (ID and mask) filter elements programmed */
+    uint32_t u32DualElems;              /*!< Dual ID filter elements programmed */
+    uint32_t u32HwIds;                  /*!< IDs accepted by filter elements */
+    uint32_t u32SwIds;                  /*!< IDs left to the software filter */
+} CANFD_FLTR_REPORT_T;
+
+/* Compiled acceptance filter: filter elements plus software hash fallback */
+typedef struct
+{
+    uint32_t *pu32Hash;                 /*!< Software ID hash set, u32HashSize entries */
+    uint32_t u32HashSize;               /*!< Hash set size, power of two */
+    uint32_t u32HashCnt;                /*!< IDs in the hash set */
+    CANFD_ID_RANGE_T *psRange;          /*!< Software range list, sorted */
+    uint32_t u32RangeMax;               /*!< Range list size */
+    uint32_t u32RangeCnt;               /*!< Ranges in the range list */
+    uint32_t *pu32Work;                 /*!< Scratch buffer for CANFD_FltrCompile() */
+    uint32_t u32WorkSize;               /*!< Scratch buffer size in words */
+    CANFD_FLTR_REPORT_T asReport[2];    /*!< Compile result, indexed by E_CANFD_ID_TYPE */
+    uint32_t u32HwAccepted;             /*!< Frames accepted by filter elements */
+    uint32_t u32SwAccepted;             /*!< Frames accepted by the software filter */
+    uint32_t u32SwRejected;             /*!< Frames discarded by the software filter */
+} CANFD_FLTR_T;
+
 
 #define CANFD_TIMEOUT        SystemCoreClock    /*!< CANFD time-out counter (1 second time-out) */
 #define CANFD_OK             ( 0L)              /*!< CANFD operation OK */
 #define CANFD_ERR_FAIL       (-1L)              /*!< CANFD operation failed */
 #define CANFD_ERR_TIMEOUT    (-2L)              /*!< CANFD operation abort due to timeout error */
+#define CANFD_ERR_FLTR_WORK  (-3L)              /*!< CANFD_FltrCompile() scratch buffer too small */
+#define CANFD_ERR_FLTR_FULL  (-4L)              /*!< Software filter hash set or range list full */
+#define CANFD_ERR_FLTR_PARAM (-5L)              /*!< CANFD_FltrInit() hash set size not a power of two, or no storage */
+
+#define CANFD_FLTR_HW_FIFO   0ul                /*!< Rx FIFO receiving frames accepted by filter elements */
+#define CANFD_FLTR_SW_FIFO   1ul                /*!< Rx FIFO receiving non-matching frames for the software filter */
 
 
 void CANFD_Open(CANFD_T *canfd, CANFD_FD_T *psCanfdStr);
@@ -397,6 +437,9 @@ int32_t CANFD_RunToNormal(CANFD_T *canfd, uint8_t u8Enable);
 void CANFD_GetDefaultConfig(CANFD_FD_T *psConfig, uint8_t u8OpMode);
 void CANFD_ClearStatusFlag(CANFD_T *canfd, uint32_t u32InterruptFlag);
 uint32_t CANFD_GetStatusFlag(CANFD_T *canfd, uint32_t u32IntTypeFlag);
+int32_t CANFD_FltrInit(CANFD_FLTR_T *psFltr, uint32_t *pu32Hash, uint32_t u32HashSize, CANFD_ID_RANGE_T *psRange, uint32_t u32RangeMax, uint32_t *pu32Work, uint32_t u32WorkSize);
+int32_t CANFD_FltrCompile(CANFD_T *canfd, CANFD_FLTR_T *psFltr, E_CANFD_ID_TYPE eIdType, CANFD_ID_RANGE_T *psList, uint32_t u32Cnt);
+uint32_t CANFD_FltrCheck(CANFD_FLTR_T *psFltr, uint32_t u32FifoIdx, CANFD_FD_MSG_T *psMsg);
 
 /*@}*/ /* end of group CANFD_EXPORTED_FUNCTIONS */
 
@@ -986,6 +986,147 @@ extern "C"
 #define CLK_SPDSRETSEL_256K         (0x5UL << CLK_PMUCTL_SRETSEL_Pos)     /*!< 256K SRAM retention when chip enter SPD mode \hideinitializer */
 
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Idle Manager constant definitions.                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CLK_IDLE_SLEEP              0UL             /*!< Idle mode: CPU clock stopped, peripherals run \hideinitializer */
+#define CLK_IDLE_FWPD               1UL             /*!< Fast Wake-up Power-down mode \hideinitializer */
+#define CLK_IDLE_PD                 2UL             /*!< Normal Power-down mode \hideinitializer */
+#define CLK_IDLE_LLPD               3UL             /*!< Low Leakage Power-down mode, the deepest one that keeps SRAM and wakes without reset \hideinitializer */
+#define CLK_IDLE_MODE_CNT           4UL             /*!< Number of idle modes \hideinitializer */
+#define CLK_IDLE_NONE               0xFFFFFFFFUL    /*!< The window is too short for any idle mode \hideinitializer */
+#define CLK_IDLE_MAX_TICKS          0x800000UL      /*!< Longest idle period, timer clocks: half the 24-bit counter \hideinitializer */
+
+/**
+  * @brief Cost of an idle mode, microseconds.
+  */
+typedef struct
+{
+    uint32_t u32Entry;              /*!< From the decision to the mode reached */
+    uint32_t u32Exit;               /*!< From the wake-up event to the first instruction after WFI */
+    uint32_t u32MinStay;            /*!< Shortest stay that saves more energy than entry and exit cost */
+} CLK_IDLE_MODE_T;
+
+/**
+  * @brief Where the idle time went, since CLK_IdleInit().
+  */
+typedef struct
+{
+    uint32_t au32Entries[CLK_IDLE_MODE_CNT];    /*!< Idle periods spent in each mode */
+    uint64_t au64Time[CLK_IDLE_MODE_CNT];       /*!< Microseconds in each mode, entry and exit included */
+    uint32_t u32Short;              /*!< Windows too short to enter any mode */
+    uint32_t u32Vetoed;             /*!< Periods held in a shallower mode by CLK_IdleSetMaxMode() */
+    uint32_t u32Early;              /*!< Periods ended by another interrupt before the deadline */
+    uint32_t u32Late;               /*!< Periods the exit took longer than assumed: its latency was raised */
+    uint32_t u32MaxLate;            /*!< Worst excess of the exit latency, microseconds */
+} CLK_IDLE_STAT_T;
+
+/**
+  * @brief Tickless idle manager.
+  * @details Given the time until the next deadline, CLK_IdleEnter() picks the deepest mode whose
+  *          entry and exit latency and break-even stay fit the window and programs the timer to
+  *          wake the chip one exit latency before the deadline. The timer runs freely in
+  *          continuous mode from LXT or LIRC, which keep running in power-down, and
+  *          CLK_IdleGetTime() reads it as the time base that the tick count of the caller follows
+  *          across the sleeps; its IRQ handler must call CLK_IdleIRQHandler(). A wake-up found
+  *          late raises the exit latency of the mode, so the costs given by CLK_IdleSetMode()
+  *          need only be a first estimate. Standby and Deep Power-down are not used: they lose
+  *          SRAM and wake through a reset.
+  */
+typedef struct
+{
+    TIMER_T *psTimer;               /*!< Wake-up timer */
+    uint32_t u32TimerClk;           /*!< Its clock, Hz */
+    uint32_t u32MaxMode;            /*!< Deepest mode allowed */
+    volatile uint32_t u32Woken;     /*!< The timer ended the period */
+    uint32_t u32LastCnt;            /*!< Counter at the last reading of the time */
+    uint64_t u64Clocks;             /*!< Timer clocks counted until then */
+    CLK_IDLE_MODE_T asMode[CLK_IDLE_MODE_CNT];
+    CLK_IDLE_STAT_T sStat;
+} CLK_IDLE_T;
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Frequency Governor constant definitions.                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CLK_GOV_OK                  ( 0L)           /*!< Done \hideinitializer */
+#define CLK_GOV_ERR_PARAM           (-1L)           /*!< Invalid argument \hideinitializer */
+#define CLK_GOV_ERR_FULL            (-2L)           /*!< No room for another client \hideinitializer */
+
+#define CLK_GOV_MAX_LEVELS          8UL             /*!< Performance levels one governor can have \hideinitializer */
+#define CLK_GOV_MAX_CLIENTS         8UL             /*!< Drivers one governor can notify \hideinitializer */
+
+#define CLK_GOV_PRE_CHANGE          0UL             /*!< HCLK is about to change: finish or hold the transfer in progress \hideinitializer */
+#define CLK_GOV_POST_CHANGE         1UL             /*!< HCLK, PCLK and PLL have changed: derive the dividers again \hideinitializer */
+
+/**
+  * @brief   Notification of a level change, called with interrupts disabled.
+  * @param[in] pvPriv   Driver data given to CLK_GovRegister()
+  * @param[in] u32Event \ref CLK_GOV_PRE_CHANGE or \ref CLK_GOV_POST_CHANGE
+  * @param[in] u32Hclk  HCLK of the new level, Hz
+  */
+typedef void (*CLK_GOV_NOTIFY_T)(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk);
+
+/**
+  * @brief Performance level.
+  */
+typedef struct
+{
+    uint32_t u32Hclk;               /*!< HCLK from PLL, Hz, 50 MHz to 200 MHz */
+    uint32_t u32RunCurrent;         /*!< Supply current while running at this level, uA */
+    uint32_t u32IdleCurrent;        /*!< Supply current in Idle mode at this level, uA */
+} CLK_GOV_LEVEL_T;
+
+/**
+  * @brief Where the time and the charge went, since CLK_GovInit().
+  */
+typedef struct
+{
+    uint64_t au64Time[CLK_GOV_MAX_LEVELS];      /*!< Microseconds at each level */
+    uint64_t au64Busy[CLK_GOV_MAX_LEVELS];      /*!< Microseconds of them the CPU was running */
+    uint64_t au64Charge[CLK_GOV_MAX_LEVELS];    /*!< Charge drawn at each level, uA x us */
+    uint32_t u32Switches;           /*!< Level changes */
+    uint32_t u32Saturated;          /*!< Periods busy throughout at the top level: the load exceeds the chip */
+} CLK_GOV_STAT_T;
+
+/**
+  * @brief Driver notified of the level changes.
+  */
+typedef struct
+{
+    CLK_GOV_NOTIFY_T pfnNotify;
+    void *pvPriv;
+} CLK_GOV_CLIENT_T;
+
+/**
+  * @brief Frequency governor.
+  * @details The caller measures how long the CPU ran in each period, e.g. from the time its idle
+  *          loop spent in WFI, and passes it to CLK_GovUpdate(). A load at or above the up
+  *          threshold takes the top level at once; otherwise the governor picks the lowest level
+  *          that would run the same work under the target load, and steps down to it only after it
+  *          has been enough for the down delay, so a short lull does not cost a burst its speed.
+  *          The work done per period is kept and only the time it takes grows, which the idle time
+  *          at the faster level would have been. Each change runs CLK_SetCoreClock(), which also
+  *          sets the power level and the flash access cycles; the registered drivers are called
+  *          before and after it with interrupts disabled, so that no interrupt sees a baud rate or
+  *          a bus clock derived from the other frequency.
+  */
+typedef struct
+{
+    CLK_GOV_LEVEL_T asLevel[CLK_GOV_MAX_LEVELS];    /*!< In rising HCLK order */
+    uint32_t u32Levels;
+    uint32_t u32Level;              /*!< Current level */
+    uint32_t u32Hclk;               /*!< HCLK set for it, Hz */
+    uint32_t u32UpLoad;             /*!< Load, percent, at or above which the top level is taken */
+    uint32_t u32Target;             /*!< Load, percent, a lower level must keep under */
+    uint32_t u32DownDelay;          /*!< Periods a lower level must be enough for before stepping down */
+    uint32_t u32DownCnt;            /*!< Periods it has been so far */
+    uint32_t u32Clients;
+    CLK_GOV_CLIENT_T asClient[CLK_GOV_MAX_CLIENTS];
+    CLK_GOV_STAT_T sStat;
+} CLK_GOV_T;
+
+
 /*@}*/ /* end of group CLK_EXPORTED_CONSTANTS */
 
 /** @addtogroup CLK_EXPORTED_FUNCTIONS CLK Exported Functions
@@ -1238,6 +1379,18 @@ uint32_t CLK_GetModuleClockDivider(uint32_t u32ModuleIdx);
 void CLK_DisablePLLFN(void);
 uint32_t CLK_EnablePLLFN(uint32_t u32PllClkSrc, uint32_t u32PllFreq);
 uint32_t CLK_GetPLLFNClockFreq(void);
+void CLK_IdleInit(CLK_IDLE_T *psIdle, TIMER_T *psTimer, uint32_t u32TimerClk);
+void CLK_IdleSetMode(CLK_IDLE_T *psIdle, uint32_t u32Mode, uint32_t u32Entry, uint32_t u32Exit, uint32_t u32MinStay);
+void CLK_IdleSetMaxMode(CLK_IDLE_T *psIdle, uint32_t u32Mode);
+uint32_t CLK_IdleSelect(CLK_IDLE_T *psIdle, uint32_t u32WindowUs);
+uint32_t CLK_IdleEnter(CLK_IDLE_T *psIdle, uint32_t u32WindowUs);
+uint64_t CLK_IdleGetTime(CLK_IDLE_T *psIdle);
+void CLK_IdleIRQHandler(CLK_IDLE_T *psIdle);
+int32_t CLK_GovInit(CLK_GOV_T *psGov, const CLK_GOV_LEVEL_T *psLevel, uint32_t u32Levels);
+int32_t CLK_GovRegister(CLK_GOV_T *psGov, CLK_GOV_NOTIFY_T pfnNotify, void *pvPriv);
+void CLK_GovSetPolicy(CLK_GOV_T *psGov, uint32_t u32UpLoad, uint32_t u32Target, uint32_t u32DownDelay);
+uint32_t CLK_GovSetLevel(CLK_GOV_T *psGov, uint32_t u32Level);
+uint32_t CLK_GovUpdate(CLK_GOV_T *psGov, uint32_t u32BusyUs, uint32_t u32PeriodUs);
 
 /*@}*/ /* end of group CLK_EXPORTED_FUNCTIONS */
 
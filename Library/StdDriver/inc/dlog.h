@@ -0,0 +1,159 @@
+/**************************************************************************//**
+ * @file     dlog.h
+ * @version  V1.00
+ * @brief    Deferred binary log driver header file
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup DLOG_Driver DLOG Driver
+  @{
+*/
+
+/** @addtogroup DLOG_EXPORTED_CONSTANTS DLOG Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Return Code Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DLOG_OK                 ( 0L)           /*!<Done \hideinitializer */
+#define DLOG_ERR_PARAM          (-1L)           /*!<Invalid argument \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Record Constant Definitions                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define DLOG_TYPE_FMT           1UL             /*!<Format string address and arguments, see DLOG() \hideinitializer */
+#define DLOG_TYPE_TEXT          2UL             /*!<Text bytes, see DLOG_Text() \hideinitializer */
+#define DLOG_TYPE_INFO          3UL             /*!<Timestamp frequency and format version, first record after DLOG_Init() \hideinitializer */
+#define DLOG_TYPE_DROP          4UL             /*!<Records dropped since the previous DROP record, added by the drain \hideinitializer */
+
+#define DLOG_HDR_TYPE_Pos       28
+#define DLOG_HDR_TYPE_Msk       (0xFUL << DLOG_HDR_TYPE_Pos)
+#define DLOG_HDR_LEN_Pos        16
+#define DLOG_HDR_LEN_Msk        (0xFFUL << DLOG_HDR_LEN_Pos)    /*!<Arguments (FMT) or bytes (TEXT) \hideinitializer */
+#define DLOG_HDR_SEQ_Pos        8
+#define DLOG_HDR_SEQ_Msk        (0xFFUL << DLOG_HDR_SEQ_Pos)    /*!<Frame number, set by the drain \hideinitializer */
+#define DLOG_HDR_WORDS_Pos      0
+#define DLOG_HDR_WORDS_Msk      (0xFFUL << DLOG_HDR_WORDS_Pos)  /*!<Record words, header included \hideinitializer */
+
+#define DLOG_MAX_ARGS           8UL             /*!<Arguments of one DLOG() \hideinitializer */
+#define DLOG_TEXT_MAX           64UL            /*!<Bytes of one TEXT record; longer text takes several \hideinitializer */
+#define DLOG_MIN_WORDS          32UL            /*!<Smallest ring \hideinitializer */
+#define DLOG_SYNC               0xA5UL          /*!<Byte ahead of each record on the wire \hideinitializer */
+#define DLOG_VERSION            1UL             /*!<Record format version \hideinitializer */
+
+/**@}*/ /* end of group DLOG_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup DLOG_EXPORTED_STRUCTS DLOG Exported Structs
+  @{
+*/
+
+/**
+  * @details Log statistics since DLOG_Init().
+  */
+typedef struct
+{
+    uint32_t u32Dropped;            /*!< Records refused with the ring full */
+    uint32_t u32MaxUsed;            /*!< Highest ring fill seen by a writer, words */
+    uint32_t u32Drained;            /*!< Records sent, DROP records included */
+} DLOG_STAT_T;
+
+/**@}*/ /* end of group DLOG_EXPORTED_STRUCTS */
+
+
+/** @addtogroup DLOG_EXPORTED_FUNCTIONS DLOG Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Timestamp of the records
+  *
+  * @return     Free running 32-bit counter
+  *
+  * @details    DWT CYCCNT by default, enabled by DLOG_Init(). Define DLOG_TIMESTAMP() in the
+  *             project to use another counter; the INFO record still gives SystemCoreClock as
+  *             its frequency.
+  * \hideinitializer
+  */
+#ifndef DLOG_TIMESTAMP
+#define DLOG_TIMESTAMP()        (DWT->CYCCNT)
+#define DLOG_TIMESTAMP_DWT
+#endif
+
+/// @cond HIDDEN_SYMBOLS
+#define DLOG_CAT_(a, b)         a##b
+#define DLOG_CAT(a, b)          DLOG_CAT_(a, b)
+#define DLOG_NARG_(f, a1, a2, a3, a4, a5, a6, a7, a8, n, ...)   n
+#define DLOG_NARG(...)          DLOG_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+
+#define DLOG_ARGS(n, pcFmt, ...) \
+    do { const uint32_t au32DlogArg[] = { __VA_ARGS__ }; DLOG_Write((pcFmt), (n), au32DlogArg); } while(0)
+
+#define DLOG_0(pcFmt)           DLOG_Write((pcFmt), 0UL, NULL)
+#define DLOG_1(f, a)            DLOG_ARGS(1UL, f, (uint32_t)(a))
+#define DLOG_2(f, a, b)         DLOG_ARGS(2UL, f, (uint32_t)(a), (uint32_t)(b))
+#define DLOG_3(f, a, b, c)      DLOG_ARGS(3UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#define DLOG_4(f, a, b, c, d)   DLOG_ARGS(4UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+#define DLOG_5(f, a, b, c, d, e) \
+    DLOG_ARGS(5UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e))
+#define DLOG_6(f, a, b, c, d, e, g) \
+    DLOG_ARGS(6UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e), (uint32_t)(g))
+#define DLOG_7(f, a, b, c, d, e, g, h) \
+    DLOG_ARGS(7UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e), (uint32_t)(g), \
+              (uint32_t)(h))
+#define DLOG_8(f, a, b, c, d, e, g, h, i) \
+    DLOG_ARGS(8UL, f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e), (uint32_t)(g), \
+              (uint32_t)(h), (uint32_t)(i))
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Log a message without formatting it
+  *
+  * @param[in]  ...         A string literal format, then 0 ~ 8 integer, character or pointer arguments.
+  *
+  * @return     None
+  *
+  * @details    Records the address of the format and the arguments as 32-bit words; the host
+  *             decoder reads the format from the image (ELF/AXF) and formats the message there.
+  *             The format must therefore stay in the image: a literal or a const array. A %%s
+  *             argument is printed only if it points into the image as well. Floating point
+  *             arguments are not supported; log scaled integers instead.
+  *             Takes a few dozen cycles and never waits, from any interrupt priority; with the
+  *             ring full the message is counted as dropped.
+  * \hideinitializer
+  */
+#define DLOG(...)               DLOG_CAT(DLOG_, DLOG_NARG(__VA_ARGS__))(__VA_ARGS__)
+
+int32_t DLOG_Init(uint32_t *pu32Ring, uint32_t u32Words);
+void DLOG_Write(const char *pcFmt, uint32_t u32Argc, const uint32_t *pu32Argv);
+void DLOG_Text(const char *pcText, uint32_t u32Len);
+void DLOG_PutChar(int ch);
+uint32_t DLOG_Drain(UART_BUF_T *psPort);
+void DLOG_Flush(UART_T *uart);
+void DLOG_GetStats(DLOG_STAT_T *psStat);
+
+/**@}*/ /* end of group DLOG_EXPORTED_FUNCTIONS */
+
+/**@}*/ /* end of group DLOG_Driver */
+
+/**@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DLOG_H__ */
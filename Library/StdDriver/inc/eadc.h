@@ -103,6 +103,65 @@ extern "C"
 #define EADC_TIMEOUT_ERR                    (-1)    /*!< EADC operation abort due to timeout error \hideinitializer */
 #define EADC_CAL_ERR                        (-2)    /*!< EADC do calibration error \hideinitializer */
 #define EADC_CLKDIV_ERR                     (-3)    /*!< EADC clock frequency is faster than PCLK error \hideinitializer */
+#define EADC_STREAM_PARAM_ERR               (-4)    /*!< EADC stream configuration error \hideinitializer */
+#define EADC_STREAM_LATE_ERR                (-5)    /*!< EADC stream block was overwritten while the consumer held it \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* EADC Continuous Acquisition Definitions                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+#define EADC_STREAM_MAX_MODULES             19UL    /*!< Sample modules available to one stream \hideinitializer */
+
+/**
+  * @brief One block of the acquisition ring.
+  */
+typedef struct
+{
+    uint16_t *pu16Data;             /*!< u32BlockFrames frames of u32ModuleCnt samples, module 0 first */
+    uint32_t u32Seq;                /*!< Block sequence number since EADC_StreamStart() */
+    uint32_t u32Timestamp;          /*!< pfnGetTime() when PDMA completed the block */
+} EADC_STREAM_BLK_T;
+
+/**
+  * @brief Continuous acquisition configuration.
+  * @details All buffers are supplied by the caller and must be in SRAM. pu16Buf holds
+  *          u32BlockCnt * u32BlockFrames * u32ModuleCnt samples; psDesc and psBlk hold
+  *          u32BlockCnt entries.
+  */
+typedef struct
+{
+    PDMA_T *pdma;                   /*!< PDMA0 or PDMA1 */
+    uint32_t u32PdmaCh;             /*!< PDMA channel, 0 to 15 */
+    uint32_t u32ModuleCnt;          /*!< Sample modules 0 to u32ModuleCnt - 1 are used, one sample each per frame */
+    const uint32_t *pu32Channel;    /*!< Analog input channel of each sample module */
+    uint32_t u32TriggerSrc;         /*!< Trigger source of every module, e.g. \ref EADC_TIMER0_TRIGGER */
+    uint32_t u32BlockFrames;        /*!< Frames per block, at most 65536 / u32ModuleCnt */
+    uint32_t u32BlockCnt;           /*!< Blocks in the ring, at least 2 */
+    uint16_t *pu16Buf;              /*!< Sample storage */
+    DSCT_T *psDesc;                 /*!< Scatter-gather descriptors, one per block */
+    uint32_t u32ScatMode;           /*!< \ref PDMA_SCATBA_SET, or \ref PDMA_SCATBA_SHARED when another user owns SCATBA */
+    EADC_STREAM_BLK_T *psBlk;       /*!< Block records, one per block */
+    uint32_t (*pfnGetTime)(void);   /*!< Timestamp source, NULL to leave timestamps at 0 */
+} EADC_STREAM_CFG_T;
+
+/**
+  * @brief Continuous acquisition state and statistics.
+  * @details u32Head is written only by EADC_StreamIRQHandler() and u32Tail only by the
+  *          consumer, so the ring needs no locking between the PDMA interrupt and the thread.
+  */
+typedef struct
+{
+    EADC_T *eadc;
+    EADC_STREAM_CFG_T sCfg;
+    volatile uint32_t u32Head;      /*!< Blocks completed by PDMA */
+    volatile uint32_t u32Tail;      /*!< Blocks released by the consumer */
+    uint32_t u32BlockWords;         /*!< Samples per block */
+    uint32_t u32Overruns;           /*!< Blocks overwritten before the consumer fetched them */
+    uint32_t u32LateBlocks;         /*!< Blocks overwritten while the consumer still held them */
+    uint32_t u32MaxFill;            /*!< Highest number of completed, unreleased blocks seen */
+    uint32_t u32MaxLatency;         /*!< Highest pfnGetTime() delay from completion to fetch */
+    uint32_t u32TriggerOverruns;    /*!< Triggers lost because the converter was still busy (OVSTS) */
+    uint32_t u32MergedBlocks;       /*!< Blocks that completed before the PDMA interrupt of an earlier block ran */
+} EADC_STREAM_T;
 
 /*@}*/ /* end of group EADC_EXPORTED_CONSTANTS */
 
@@ -714,6 +773,13 @@ void EADC_Close(EADC_T *eadc);
 void EADC_ConfigSampleModule(EADC_T *eadc, uint32_t u32ModuleNum, uint32_t u32TriggerSrc, uint32_t u32Channel);
 void EADC_SetTriggerDelayTime(EADC_T *eadc, uint32_t u32ModuleNum, uint32_t u32TriggerDelayTime, uint32_t u32DelayClockDivider);
 void EADC_SetExtendSampleTime(EADC_T *eadc, uint32_t u32ModuleNum, uint32_t u32ExtendSampleTime);
+int32_t EADC_StreamOpen(EADC_T *eadc, EADC_STREAM_T *psStream, const EADC_STREAM_CFG_T *psCfg);
+void EADC_StreamStart(EADC_STREAM_T *psStream);
+void EADC_StreamStop(EADC_STREAM_T *psStream);
+void EADC_StreamIRQHandler(EADC_STREAM_T *psStream);
+EADC_STREAM_BLK_T *EADC_StreamGetBlock(EADC_STREAM_T *psStream);
+int32_t EADC_StreamReleaseBlock(EADC_STREAM_T *psStream);
+void EADC_StreamClearStats(EADC_STREAM_T *psStream);
 
 /*@}*/ /* end of group EADC_EXPORTED_FUNCTIONS */
 
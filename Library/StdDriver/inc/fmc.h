@@ -109,6 +109,50 @@ extern "C"
 #define FMC_TIMEOUT_CHKSUM          (SystemCoreClock<<1) /*!< Get checksum command time-out 2 s   \hideinitializer */
 #define FMC_TIMEOUT_CHKALLONE       (SystemCoreClock<<1) /*!< Check-all-one command time-out 2 s  \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* Dual Bank Firmware Update Constant Definitions                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define FMC_UPD_OK              ( 0L)           /*!< Nothing to do until more package data arrives */
+#define FMC_UPD_BUSY            ( 1L)           /*!< Flash or hash engine at work, poll again */
+#define FMC_UPD_DONE            ( 2L)           /*!< Image verified and committed to the inactive bank */
+#define FMC_UPD_ERR_FAIL        (-1L)           /*!< ISP command or hash DMA failed */
+#define FMC_UPD_ERR_PARAM       (-2L)           /*!< Invalid argument or call out of order */
+#define FMC_UPD_ERR_FORMAT      (-3L)           /*!< Corrupted package header or record */
+#define FMC_UPD_ERR_BASE        (-4L)           /*!< Delta package made for another image than the running one */
+#define FMC_UPD_ERR_CRC         (-5L)           /*!< Record CRC-32 mismatch */
+#define FMC_UPD_ERR_DIGEST      (-6L)           /*!< SHA-256 of the programmed image mismatch */
+
+#define FMC_UPD_PKG_MAGIC       0x4B50554EUL    /*!< Package header magic, "NUPK" */
+#define FMC_UPD_PKG_DELTA       0x1UL           /*!< Package flag: records copy from the running image */
+#define FMC_UPD_REC_COPY        0x01UL          /*!< Record: copy len bytes of the running image from offset arg */
+#define FMC_UPD_REC_INSERT      0x02UL          /*!< Record: len literal bytes follow the record */
+#define FMC_UPD_REC_MAX_LEN     0x00FFFFFFUL    /*!< Longest record */
+#define FMC_UPD_REC_TAG(op, len)    ((uint32_t)(op) | ((uint32_t)(len) << 8))   /*!< u32Tag of a record */
+
+#define FMC_UPD_TRL_MAGIC       0x4C52544EUL    /*!< Trailer magic, "NTRL" */
+#define FMC_UPD_TRL_COMMIT      0xC0117A11UL    /*!< Trailer commit word, programmed last */
+#define FMC_UPD_TRL_TRIED       0x7E1EDB00UL    /*!< Trailer word set on the first boot of the image */
+#define FMC_UPD_TRL_CONFIRMED   0xC0FF1A3DUL    /*!< Trailer word set by FMC_UpdConfirm() */
+
+#define FMC_UPD_BOOT_NONE       0UL             /*!< No committed image: the bank found running is kept */
+#define FMC_UPD_BOOT_CONFIRMED  1UL             /*!< Newest image, confirmed before */
+#define FMC_UPD_BOOT_TRIAL      2UL             /*!< Newest image, first boot: confirm it or it is dropped at the next boot */
+#define FMC_UPD_BOOT_ROLLBACK   3UL             /*!< Newest image failed its trial boot, the previous one is selected */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Key-Value Store Constant Definitions                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+#define FMC_KV_OK               ( 0L)           /*!< Done */
+#define FMC_KV_ERR_FAIL         (-1L)           /*!< ISP command failed or timed out */
+#define FMC_KV_ERR_PARAM        (-2L)           /*!< Invalid argument, or the store is not mounted */
+#define FMC_KV_ERR_NOT_FOUND    (-3L)           /*!< No value for the key */
+#define FMC_KV_ERR_FULL         (-4L)           /*!< No room left in the flash region or the index */
+
+#define FMC_KV_PAGE_MAGIC       0x50564B4EUL    /*!< Page header magic, "NKVP" */
+#define FMC_KV_KEY_NONE         0xFFFFFFFFUL    /*!< Reserved: the key of an erased record header */
+#define FMC_KV_MAX_LEN          1024UL          /*!< Longest value */
+#define FMC_KV_REC_SIZE(len)    (8UL + (((uint32_t)(len) + 11UL) & ~7UL))   /*!< Flash bytes of a record holding len bytes */
+
 /*@}*/ /* end of group FMC_EXPORTED_CONSTANTS */
 
 
@@ -142,6 +186,173 @@ extern "C"
 /*---------------------------------------------------------------------------------------------------------*/
 extern int32_t  g_FMC_i32ErrCode;
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Dual Bank Firmware Update                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief Update package header, the first bytes of a package.
+  * @details A package is this header and a sequence of records, all little-endian. Each record
+  *          is an \ref FMC_UPD_REC_T, followed by its literal bytes for \ref FMC_UPD_REC_INSERT.
+  *          The records produce the new image in order. A full image is one package of insert
+  *          records only; a delta package also copies ranges of the running image and is only
+  *          accepted by the image whose digest is au8BaseDigest.
+  */
+typedef struct
+{
+    uint32_t u32Magic;              /*!< \ref FMC_UPD_PKG_MAGIC */
+    uint32_t u32Flags;              /*!< \ref FMC_UPD_PKG_DELTA or 0 */
+    uint32_t u32Size;               /*!< New image size in bytes */
+    uint32_t u32Version;            /*!< Application defined, kept in the trailer */
+    uint8_t  au8BaseDigest[32];     /*!< SHA-256 of the image a delta package applies to */
+    uint8_t  au8Digest[32];         /*!< SHA-256 of the new image */
+    uint32_t u32HdrCrc;             /*!< CRC-32 of the header bytes before it */
+} FMC_UPD_PKG_T;
+
+/**
+  * @brief Update package record.
+  */
+typedef struct
+{
+    uint32_t u32Tag;                /*!< \ref FMC_UPD_REC_TAG(op, len) */
+    uint32_t u32Arg;                /*!< Offset in the running image of a copy record, 0 otherwise */
+    uint32_t u32Crc;                /*!< CRC-32 of the len bytes the record produces */
+} FMC_UPD_REC_T;
+
+/**
+  * @brief Image trailer, at the start of the last page of the slot in each bank.
+  * @details Every double word is programmed once from erased, the commit word last, so a
+  *          power failure at any point leaves either no image or a complete one.
+  */
+typedef struct
+{
+    uint32_t u32Magic;              /*!< \ref FMC_UPD_TRL_MAGIC */
+    uint32_t u32Seq;                /*!< Grows by one with each update; the highest committed one boots */
+    uint32_t u32Size;               /*!< Image size */
+    uint32_t u32Version;            /*!< u32Version of the package */
+    uint8_t  au8Digest[32];         /*!< SHA-256 of the image, verified before the commit */
+    uint32_t u32Commit;             /*!< \ref FMC_UPD_TRL_COMMIT */
+    uint32_t u32CommitSeq;          /*!< ~u32Seq */
+    uint32_t u32Tried;              /*!< \ref FMC_UPD_TRL_TRIED once booted */
+    uint32_t u32Resv0;
+    uint32_t u32Confirmed;          /*!< \ref FMC_UPD_TRL_CONFIRMED once confirmed */
+    uint32_t u32Resv1;
+} FMC_UPD_TRAILER_T;
+
+/**
+  * @brief Update statistics, since FMC_UpdBegin(). Times are pfnGetTime() ticks.
+  */
+typedef struct
+{
+    uint32_t u32RxBytes;            /*!< Package bytes taken by FMC_UpdWrite() */
+    uint32_t u32Stalls;             /*!< FMC_UpdWrite() calls that left bytes behind: both page buffers full */
+    uint32_t u32CopyBytes;          /*!< Image bytes copied from the running image */
+    uint32_t u32InsertBytes;        /*!< Image bytes taken from the package */
+    uint32_t u32Pages;              /*!< Image pages written to the inactive bank */
+    uint32_t u32Erases;             /*!< Pages erased */
+    uint32_t u32Programs;           /*!< Double words programmed */
+    uint32_t u32Kept;               /*!< Double words already holding their new value: neither erased nor programmed */
+    uint32_t u32UpdateTime;         /*!< FMC_UpdBegin() to the commit */
+    uint32_t u32BootTime;           /*!< Time FMC_UpdBoot() took, remap excluded */
+} FMC_UPD_STAT_T;
+
+/**
+  * @brief Firmware update of the inactive APROM bank while the image in the active one runs.
+  * @details Packages arrive in pieces of any size through FMC_UpdWrite(), from any transport.
+  *          The bytes they produce go through two page buffers; FMC_UpdPoll() erases and
+  *          programs the pages of the inactive bank, one ISP command per call, while the code
+  *          keeps running from the active bank. Each record is checked with the CRC engine as
+  *          it arrives and every programmed page is hashed by the SHA engine of CRPT, read back
+  *          from flash by its DMA, so the image is verified once its last page is written.
+  *          FMC_UpdBoot() then selects the newest image at the next boot. The update owns CRC and
+  *          SHA of CRPT while it runs; their clocks, ISP and APROM update must be enabled.
+  */
+typedef struct
+{
+    uint32_t u32SlotSize;           /*!< Bytes of each bank used: the image, then the trailer page */
+    uint32_t u32MapBase;            /*!< Bus address of APROM, FMC_APROM_BASE */
+    uint32_t (*pfnGetTime)(void);   /*!< Time source of the statistics, NULL to leave times at 0 */
+    int32_t  i32Result;             /*!< Last FMC_UpdPoll() result, errors are kept until FMC_UpdBegin() */
+    uint32_t u32Phase;              /*!< Flash side state */
+    uint32_t u32Bank;               /*!< Bank running, ISPSTS.FBS */
+    uint32_t u32BootState;          /*!< \ref FMC_UPD_BOOT_NONE ... \ref FMC_UPD_BOOT_ROLLBACK, set by FMC_UpdBoot() */
+    uint32_t u32StartTime;
+    FMC_UPD_PKG_T sPkg;
+    uint32_t u32PkgCnt;             /*!< Header bytes received */
+    FMC_UPD_REC_T sRec;
+    uint32_t u32RecCnt;             /*!< Record bytes received */
+    uint32_t u32RecLeft;            /*!< Image bytes the record still produces */
+    uint32_t u32Produced;           /*!< Image bytes produced */
+    uint32_t u32Fill;               /*!< Page buffer being filled */
+    uint32_t u32FillLen;
+    uint32_t u32Full;               /*!< Bit per page buffer filled and not yet written */
+    uint32_t u32Prog;               /*!< Page buffer being written */
+    uint32_t u32Page;               /*!< Image page being written */
+    uint32_t u32Step;               /*!< Next double word of the page or trailer to program */
+    FMC_UPD_TRAILER_T sTrl;         /*!< Trailer of the new image */
+    FMC_UPD_STAT_T sStat;
+    uint32_t au32Buf[2][FMC_FLASH_PAGE_SIZE / 4UL];
+} FMC_UPD_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Key-Value Store                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief RAM index entry of a key, one slot of the open addressing table given to FMC_KvInit().
+  */
+typedef struct
+{
+    uint32_t u32Key;
+    uint32_t u32Addr;               /*!< Flash address of the newest record of the key */
+    uint16_t u16Len;                /*!< Value length */
+    uint16_t u16Flags;              /*!< Slot in use, key deleted */
+} FMC_KV_ENTRY_T;
+
+/**
+  * @brief What the store did, since FMC_KvInit().
+  */
+typedef struct
+{
+    uint32_t u32Gets;               /*!< FMC_KvGet() calls that found a value */
+    uint32_t u32Sets;               /*!< Records appended by FMC_KvSet() and FMC_KvDelete() */
+    uint32_t u32Unchanged;          /*!< FMC_KvSet() calls with the value already stored: nothing written */
+    uint32_t u32Reads;              /*!< Double words read */
+    uint32_t u32Programs;           /*!< Double words programmed */
+    uint32_t u32Erases;             /*!< Pages erased */
+    uint32_t u32Rotations;          /*!< Pages opened for appending */
+    uint32_t u32Copies;             /*!< Live records moved out of the oldest page by compaction */
+    uint32_t u32Dropped;            /*!< Records found torn by FMC_KvMount(): power failed before their commit */
+} FMC_KV_STAT_T;
+
+/**
+  * @brief Log-structured key-value store for settings and counters in data flash.
+  * @details Values are appended as records to a ring of flash pages and found through an index in
+  *          RAM, so a change costs a few double word programs instead of a page erase and rewrite.
+  *          A record is a header double word {key, length}, the value padded with 0xFF and a
+  *          CRC-32 of key, length and value in the last word. It is programmed in order, and the
+  *          double word holding the CRC commits it: a record torn by a power failure fails its
+  *          CRC and the previous value of the key stays in effect. Each page starts with a header
+  *          double word {\ref FMC_KV_PAGE_MAGIC, sequence}; one page of the ring is always kept
+  *          erased. When the newest page is full the erased one gets the next sequence, the live
+  *          records of the oldest page are copied into it and the oldest page is erased, becoming
+  *          the spare. FMC_KvMount() rebuilds the index from flash and finishes or rolls back an
+  *          interrupted compaction. The region may be the data flash, at FMC_ReadDataFlashBaseAddr(),
+  *          or APROM pages the image does not use; ISP must be enabled, and APROM update too outside
+  *          data flash. Every call stalls the CPU for the ISP commands it issues.
+  */
+typedef struct
+{
+    uint32_t u32Base;               /*!< Flash address of the first page */
+    uint32_t u32Pages;              /*!< Pages of the ring */
+    FMC_KV_ENTRY_T *psIndex;        /*!< Index table */
+    uint32_t u32IndexSize;          /*!< Index slots, a power of two */
+    uint32_t u32Keys;               /*!< Index slots in use, deleted keys included */
+    uint32_t u32Live;               /*!< Flash bytes of the records the index refers to */
+    uint32_t u32Page;               /*!< Page being appended to */
+    uint32_t u32Seq;                /*!< Its sequence */
+    uint32_t u32Offset;             /*!< Its first free byte, 0 until FMC_KvMount() */
+    FMC_KV_STAT_T sStat;
+} FMC_KV_T;
+
 /** @addtogroup FMC_EXPORTED_FUNCTIONS FMC Exported Functions
   @{
 */
@@ -369,6 +580,18 @@ extern int32_t  FMC_WriteConfig(uint32_t u32Config[], uint32_t u32Count);
 extern uint32_t FMC_GetChkSum(uint32_t u32addr, uint32_t u32count);
 extern uint32_t FMC_CheckAllOne(uint32_t u32addr, uint32_t u32count);
 extern int32_t  FMC_RemapBank(uint32_t u32Bank);
+extern void     FMC_UpdInit(FMC_UPD_T *psUpd, uint32_t u32SlotSize, uint32_t (*pfnGetTime)(void));
+extern int32_t  FMC_UpdReadTrailer(FMC_UPD_T *psUpd, uint32_t u32Bank, FMC_UPD_TRAILER_T *psTrl);
+extern int32_t  FMC_UpdBegin(FMC_UPD_T *psUpd);
+extern int32_t  FMC_UpdWrite(FMC_UPD_T *psUpd, const uint8_t *pu8Data, uint32_t u32Len);
+extern int32_t  FMC_UpdPoll(FMC_UPD_T *psUpd);
+extern int32_t  FMC_UpdBoot(FMC_UPD_T *psUpd);
+extern int32_t  FMC_UpdConfirm(FMC_UPD_T *psUpd);
+extern int32_t  FMC_KvInit(FMC_KV_T *psKv, uint32_t u32Base, uint32_t u32Pages, FMC_KV_ENTRY_T *psIndex, uint32_t u32IndexSize);
+extern int32_t  FMC_KvMount(FMC_KV_T *psKv);
+extern int32_t  FMC_KvGet(FMC_KV_T *psKv, uint32_t u32Key, void *pvData, uint32_t u32Size);
+extern int32_t  FMC_KvSet(FMC_KV_T *psKv, uint32_t u32Key, const void *pvData, uint32_t u32Len);
+extern int32_t  FMC_KvDelete(FMC_KV_T *psKv, uint32_t u32Key);
 
 
 /*@}*/ /* end of group FMC_EXPORTED_FUNCTIONS */
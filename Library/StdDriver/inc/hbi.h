@@ -149,6 +149,117 @@ extern int32_t g_HBI_i32ErrCode;
 #define HBI_ERR_FAIL        (-1L)               /*!< HBI operation failed */
 #define HBI_ERR_TIMEOUT     (-2L)               /*!< HBI operation abort due to timeout error */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* HyperRAM Heap                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+#define HBI_HEAP_ALIGN          32UL                /*!< Alignment and size granularity of heap blocks */
+#define HBI_HEAP_MAX_CLASSES    6UL                 /*!< Size classes one heap can have */
+#define HBI_HEAP_CLASS_BLOCKS   64UL                /*!< Blocks one size class can have */
+#define HBI_HEAP_MAX_SPANS      32UL                /*!< Free and allocated spans the general area can be split into */
+#define HBI_HEAP_PENDING        PDMA_COPY_SLOTS     /*!< PDMA copies whose latency is tracked at once */
+
+#define HBI_HEAP_STORE          0UL                 /*!< Copy into the heap */
+#define HBI_HEAP_LOAD           1UL                 /*!< Copy out of the heap */
+#define HBI_HEAP_MOVE           2UL                 /*!< Any other copy, e.g. within the heap */
+
+/**
+  * @brief Size class of a heap, given to HBI_HeapInit().
+  * @details Examples: a 2 x 2304 x 4 byte PCM ring of I2S_MP3PLAYER, the 16 KB pools libjpeg
+  *          allocates while encoding, a 640 x 480 YUV422 CCAP frame of 614400 bytes.
+  */
+typedef struct
+{
+    uint32_t u32Size;               /*!< Block size in bytes, rounded up to \ref HBI_HEAP_ALIGN */
+    uint32_t u32Count;              /*!< Blocks reserved for the class, up to \ref HBI_HEAP_CLASS_BLOCKS */
+} HBI_HEAP_CLASS_T;
+
+/**
+  * @brief Blocks of one size class.
+  */
+typedef struct
+{
+    uint32_t u32Base;               /*!< Address of the first block */
+    uint32_t u32Size;               /*!< Block size */
+    uint32_t u32Count;              /*!< Blocks of the class */
+    uint32_t u32Used;               /*!< Blocks allocated */
+    uint32_t u32Peak;               /*!< Most blocks allocated at once */
+    uint32_t u32Spills;             /*!< Allocations of the class served by the general area: every block was in use */
+    uint32_t au32Free[HBI_HEAP_CLASS_BLOCKS / 32UL];    /*!< One bit per block, set when free */
+} HBI_HEAP_POOL_T;
+
+/**
+  * @brief Free or allocated part of the general area.
+  */
+typedef struct
+{
+    uint32_t u32Addr;
+    uint32_t u32Size;
+    uint32_t u32Used;               /*!< Allocated */
+} HBI_HEAP_SPAN_T;
+
+/**
+  * @brief Copy in flight on PDMA.
+  */
+typedef struct
+{
+    uint32_t u32Fence;              /*!< PDMA_MemCopy() fence */
+    uint32_t u32Start;              /*!< pfnGetTime() at HBI_HeapCopy() */
+    uint32_t u32Dir;                /*!< \ref HBI_HEAP_STORE, \ref HBI_HEAP_LOAD or \ref HBI_HEAP_MOVE */
+} HBI_HEAP_PEND_T;
+
+/**
+  * @brief Statistics of the copies in one direction.
+  */
+typedef struct
+{
+    uint32_t u32Copies;             /*!< HBI_HeapCopy() calls */
+    uint32_t u32Bytes;              /*!< Bytes copied */
+    uint32_t u32DmaBytes;           /*!< Bytes of u32Bytes moved by PDMA */
+    uint32_t u32Timed;              /*!< Copies seen complete, the count behind u32TotalTime */
+    uint32_t u32TotalTime;          /*!< pfnGetTime() ticks from HBI_HeapCopy() to completion, summed */
+    uint32_t u32MaxTime;            /*!< Longest of them */
+} HBI_HEAP_COPY_STAT_T;
+
+/**
+  * @brief Heap statistics, since HBI_HeapInit() or HBI_HeapClearStats().
+  */
+typedef struct
+{
+    uint32_t u32Allocs;             /*!< Successful HBI_HeapAlloc() calls */
+    uint32_t u32Frees;              /*!< Successful HBI_HeapFree() calls */
+    uint32_t u32Fails;              /*!< HBI_HeapAlloc() calls that returned NULL */
+    uint32_t u32InUse;              /*!< Bytes allocated, blocks rounded up */
+    uint32_t u32Peak;               /*!< Highest u32InUse */
+    uint32_t u32AreaInUse;          /*!< Bytes of u32InUse in the general area */
+    uint32_t u32AreaPeak;           /*!< Highest u32AreaInUse */
+    uint32_t u32LargestFree;        /*!< Largest free span of the general area, filled in by HBI_HeapGetStat() */
+    HBI_HEAP_COPY_STAT_T asCopy[3]; /*!< Indexed by \ref HBI_HEAP_STORE, \ref HBI_HEAP_LOAD and \ref HBI_HEAP_MOVE */
+} HBI_HEAP_STAT_T;
+
+/**
+  * @brief Allocator of a memory-mapped HyperRAM region.
+  * @details The region is split into a pool of fixed-size blocks per size class and a general
+  *          area behind them. A request takes a block of the smallest class it fits, or, beyond
+  *          the classes or with that class used up, the best fitting free span of the general
+  *          area. All bookkeeping stays in this structure, so neither allocating nor freeing
+  *          touches the HyperRAM. Not reentrant: use it from one context or under a lock.
+  */
+typedef struct
+{
+    uint32_t u32Base;               /*!< Region managed */
+    uint32_t u32Size;
+    PDMA_COPY_T *psCopy;            /*!< Copy service of HBI_HeapCopy(), NULL to copy with the CPU */
+    uint32_t (*pfnGetTime)(void);   /*!< Time source of the copy statistics, NULL to leave times at 0 */
+    uint32_t u32Classes;            /*!< Size classes, ascending */
+    uint32_t u32Spans;              /*!< Spans of the general area, by address */
+    uint32_t u32PendHead;           /*!< Oldest entry of asPend */
+    uint32_t u32PendCnt;            /*!< Entries of asPend in use */
+    HBI_HEAP_STAT_T sStat;
+    HBI_HEAP_POOL_T asPool[HBI_HEAP_MAX_CLASSES];
+    HBI_HEAP_SPAN_T asSpan[HBI_HEAP_MAX_SPANS];
+    HBI_HEAP_PEND_T asPend[HBI_HEAP_PENDING];
+} HBI_HEAP_T;
+
 
 /*---------------------------------------------------------------------------------------------------------*/
 /*  Define Macros and functions                                                                            */
@@ -290,6 +401,13 @@ void HBI_Write1Byte(uint32_t u32Addr, uint8_t u8Data);
 void HBI_Write2Byte(uint32_t u32Addr, uint16_t u16Data);
 void HBI_Write3Byte(uint32_t u32Addr, uint32_t u32Data);
 void HBI_Write4Byte(uint32_t u32Addr, uint32_t u32Data);
+int32_t HBI_HeapInit(HBI_HEAP_T *psHeap, uint32_t u32Base, uint32_t u32Size, const HBI_HEAP_CLASS_T *psClass, uint32_t u32Classes);
+void *HBI_HeapAlloc(HBI_HEAP_T *psHeap, uint32_t u32Size);
+int32_t HBI_HeapFree(HBI_HEAP_T *psHeap, void *pvBlock);
+uint32_t HBI_HeapCopy(HBI_HEAP_T *psHeap, void *pvDst, const void *pvSrc, uint32_t u32Len);
+int32_t HBI_HeapCopyWait(HBI_HEAP_T *psHeap, uint32_t u32Fence);
+void HBI_HeapGetStat(HBI_HEAP_T *psHeap, HBI_HEAP_STAT_T *psStat);
+void HBI_HeapClearStats(HBI_HEAP_T *psHeap);
 
 /*@}*/ /* end of group HBI_EXPORTED_FUNCTIONS */
 
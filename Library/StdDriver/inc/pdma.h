@@ -197,6 +197,160 @@ extern "C"
 #define PDMA_INT_TIMEOUT    0x00000002UL            /*!<Timeout Interrupt \hideinitializer */
 #define PDMA_INT_ALIGN      0x00000003UL            /*!<Transfer Alignment Interrupt  \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Scatter-Gather Base Constant Definitions                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PDMA_SCATBA_SET     0x00000000UL            /*!<Point SCATBA at the 64 KB window of the descriptors  \hideinitializer */
+#define PDMA_SCATBA_SHARED  0x00000001UL            /*!<SCATBA is owned by another user of the PDMA, only check the descriptors lie in its window  \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Channel Service Constant Definitions                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PDMA_SVC_CH_ANY         0x00000000UL        /*!<Allocate any free channel  \hideinitializer */
+#define PDMA_SVC_CH_STRIDE      0x00000001UL        /*!<Allocate a channel with stride registers (channel 0 ~ 5)  \hideinitializer */
+#define PDMA_SVC_CH_REPEAT      0x00000002UL        /*!<Allocate a channel with repeat registers (channel 0 ~ 1)  \hideinitializer */
+#define PDMA_SVC_CH_DIRECT      0x00000004UL        /*!<Allocate a channel programmed by its owner, whose flags PDMA_SvcIRQHandler() leaves alone  \hideinitializer */
+
+#define PDMA_SVC_STRIDE_CH_MAX  6UL                 /*!<Channels with stride registers  \hideinitializer */
+#define PDMA_SVC_REPEAT_CH_MAX  2UL                 /*!<Channels with repeat registers  \hideinitializer */
+
+#define PDMA_SVC_PENDING        (1L)                /*!<Transfer queued or running  \hideinitializer */
+#define PDMA_SVC_PARAM_ERR      (-1L)               /*!<Invalid channel, descriptor pool or transfer  \hideinitializer */
+#define PDMA_SVC_NOCH_ERR       (-2L)               /*!<No free channel with the requested capability  \hideinitializer */
+#define PDMA_SVC_NODESC_ERR     (-3L)               /*!<Descriptor pool exhausted, nothing was queued  \hideinitializer */
+#define PDMA_SVC_ABORT_ERR      (-4L)               /*!<Transfer ended by a target abort  \hideinitializer */
+#define PDMA_SVC_CANCEL_ERR     (-5L)               /*!<Transfer dropped by PDMA_SvcFreeCh()  \hideinitializer */
+
+/**
+  * @brief One contiguous piece of a chained transfer.
+  */
+typedef struct
+{
+    uint32_t u32SrcAddr;            /*!< Source address */
+    uint32_t u32DstAddr;            /*!< Destination address */
+    uint32_t u32TransCount;         /*!< Transfer count, 1 ~ 65536 items of the transfer width */
+} PDMA_SEG_T;
+
+typedef struct PDMA_XFER PDMA_XFER_T;
+
+/**
+  * @brief Completion callback, called from PDMA_SvcIRQHandler() (or PDMA_SvcFreeCh()).
+  * @details i32Status is 0, \ref PDMA_SVC_ABORT_ERR or \ref PDMA_SVC_CANCEL_ERR. The transfer
+  *          belongs to the caller again and may be submitted from the callback.
+  */
+typedef void (*PDMA_XFER_CB_T)(PDMA_XFER_T *psXfer, int32_t i32Status);
+
+/**
+  * @brief Queued transfer: one or more segments sharing request source and control settings.
+  * @details The fields above psNext are set by the caller, see PDMA_SvcInitXfer(). The rest belongs
+  *          to the service from PDMA_SvcSubmit() until the callback.
+  */
+struct PDMA_XFER
+{
+    const PDMA_SEG_T *psSeg;        /*!< Segments, transferred in order without software in between */
+    uint32_t u32SegCnt;             /*!< Number of segments, one descriptor each */
+    uint32_t u32Peripheral;         /*!< Request source, e.g. \ref PDMA_MEM or \ref PDMA_UART0_TX */
+    uint32_t u32Ctl;                /*!< PDMA_WIDTH_x | PDMA_SAR_x | PDMA_DAR_x | PDMA_REQ_x | PDMA_BURST_x */
+    uint32_t u32StrideLen;          /*!< Stride lengths (destination << 16 | source), see PDMA_SvcSetStride() */
+    uint32_t u32StrideCnt;          /*!< Transfer count per stride, 0 for no stride */
+    uint32_t u32RepeatInterval;     /*!< Repeat intervals (destination << 16 | source), see PDMA_SvcSetRepeat() */
+    uint32_t u32RepeatCnt;          /*!< Repeat count, 0 for no repeat */
+    PDMA_XFER_CB_T pfnDone;         /*!< Completion callback, may be NULL */
+    void *pvArg;                    /*!< Caller context */
+    PDMA_XFER_T *psNext;            /*!< Next transfer queued on the channel */
+    DSCT_T *psDesc;                 /*!< First descriptor of the chain */
+    DSCT_T *psDescLast;             /*!< Last descriptor of the chain */
+    uint32_t u32Bytes;              /*!< Bytes moved by the transfer */
+    uint32_t u32SubmitTime;         /*!< pfnGetTime() at PDMA_SvcSubmit() */
+    volatile int32_t i32Status;     /*!< \ref PDMA_SVC_PENDING until the callback, then its status */
+};
+
+/**
+  * @brief Per channel statistics, since PDMA_SvcAllocCh() or PDMA_SvcClearStats().
+  */
+typedef struct
+{
+    uint32_t u32Xfers;              /*!< Completed transfers */
+    uint32_t u32Errors;             /*!< Transfers ended by a target abort */
+    uint32_t u32Bytes;              /*!< Bytes of completed transfers */
+    uint32_t u32BusyTime;           /*!< pfnGetTime() ticks with a transfer running */
+    uint32_t u32MaxDepth;           /*!< Highest number of transfers queued, the running one included */
+    uint32_t u32MaxLatency;         /*!< Highest pfnGetTime() delay from submit to completion */
+    uint32_t u32StartTime;          /*!< pfnGetTime() when the statistics were cleared */
+} PDMA_SVC_STAT_T;
+
+/**
+  * @brief Per channel state of the service.
+  */
+typedef struct
+{
+    PDMA_XFER_T *psHead;            /*!< Running transfer, NULL when idle */
+    PDMA_XFER_T *psTail;            /*!< Last queued transfer */
+    uint32_t u32Depth;              /*!< Transfers queued, the running one included */
+    uint32_t u32RunTime;            /*!< pfnGetTime() when the running transfer was started */
+    PDMA_SVC_STAT_T sStat;
+} PDMA_SVC_CH_T;
+
+/**
+  * @brief Channel service state of one PDMA controller.
+  * @details The descriptor pool is supplied to PDMA_SvcInit() and must lie in one 64 KB window
+  *          of SRAM, the window selected by SCATBA.
+  */
+typedef struct PDMA_SVC
+{
+    PDMA_T *pdma;
+    uint32_t u32ChUsed;             /*!< Channels allocated through the service */
+    uint32_t u32ChReserved;         /*!< Channels the service never hands out */
+    uint32_t u32ChDirect;           /*!< Allocated channels taken with \ref PDMA_SVC_CH_DIRECT */
+    uint32_t u32DescBase;           /*!< SCATBA window */
+    DSCT_T *psDescFree;             /*!< Free descriptor list, linked through NEXT */
+    uint32_t u32DescNum;            /*!< Descriptors in the pool */
+    uint32_t u32DescFree;           /*!< Descriptors on the free list */
+    uint32_t u32DescMinFree;        /*!< Lowest u32DescFree seen */
+    uint32_t u32DescFails;          /*!< Submits rejected with \ref PDMA_SVC_NODESC_ERR */
+    uint32_t (*pfnGetTime)(void);   /*!< Time source of the statistics, NULL to leave times at 0 */
+    PDMA_SVC_CH_T asCh[PDMA_CH_MAX];
+} PDMA_SVC_T;
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Memory Copy Service Constant Definitions                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PDMA_COPY_SLOTS         8UL                 /*!<PDMA operations a copy service keeps in flight  \hideinitializer */
+#define PDMA_COPY_THRESHOLD     256UL               /*!<Default size from which copies go to PDMA, in bytes  \hideinitializer */
+#define PDMA_COPY_TIMEOUT_ERR   (-6L)               /*!<PDMA_CopyWait() gave up  \hideinitializer */
+
+/**
+  * @brief One PDMA operation of a copy service.
+  */
+typedef struct
+{
+    PDMA_XFER_T sXfer;
+    PDMA_SEG_T sSeg;
+    uint32_t u32Pattern;            /*!< Source word of PDMA_MemSet() */
+} PDMA_COPY_SLOT_T;
+
+/**
+  * @brief Memory copy service state.
+  * @details Operations queued on the channel complete in order, so one counter of completed
+  *          operations serves as fence for all of them. Must be in SRAM: PDMA reads the memset
+  *          pattern from it.
+  */
+typedef struct
+{
+    PDMA_SVC_T *psSvc;
+    uint32_t u32Ch;                 /*!< Memory to memory channel of the service */
+    uint32_t u32Threshold;          /*!< Smallest PDMA part of a copy, in bytes */
+    uint32_t u32Issued;             /*!< Fence of the newest PDMA operation */
+    volatile uint32_t u32Completed; /*!< Fence of the newest completed PDMA operation */
+    volatile int32_t i32Error;      /*!< First error since the last PDMA_CopyWait() */
+    uint32_t u32CpuOps;             /*!< Calls completed on the CPU entirely */
+    uint32_t u32CpuBytes;           /*!< Bytes moved by the CPU, PDMA calls' unaligned ends included */
+    uint32_t u32DmaOps;             /*!< PDMA operations queued */
+    uint32_t u32DmaBytes;           /*!< Bytes moved by PDMA */
+    uint32_t u32Fallbacks;          /*!< PDMA parts done on the CPU because every slot was in flight */
+    PDMA_COPY_SLOT_T asSlot[PDMA_COPY_SLOTS];
+} PDMA_COPY_T;
 
 /*@}*/ /* end of group PDMA_EXPORTED_CONSTANTS */
 
@@ -430,6 +584,24 @@ void PDMA_EnableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask);
 void PDMA_DisableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask);
 void PDMA_SetStride(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32DestLen, uint32_t u32SrcLen, uint32_t u32TransCount);
 void PDMA_SetRepeat(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32DestInterval, uint32_t u32SrcInterval, uint32_t u32RepeatCount);
+int32_t PDMA_SetScatterBase(PDMA_T *pdma, const DSCT_T *psDesc, uint32_t u32DescNum, uint32_t u32Mode);
+int32_t PDMA_SvcInit(PDMA_SVC_T *psSvc, PDMA_T *pdma, DSCT_T *psDescPool, uint32_t u32DescNum, uint32_t u32ScatMode, uint32_t u32ReservedMask, uint32_t (*pfnGetTime)(void));
+int32_t PDMA_SvcAllocCh(PDMA_SVC_T *psSvc, uint32_t u32Flags);
+int32_t PDMA_SvcFreeCh(PDMA_SVC_T *psSvc, uint32_t u32Ch);
+void PDMA_SvcInitXfer(PDMA_XFER_T *psXfer, const PDMA_SEG_T *psSeg, uint32_t u32SegCnt, uint32_t u32Peripheral, uint32_t u32Ctl, PDMA_XFER_CB_T pfnDone, void *pvArg);
+void PDMA_SvcSetStride(PDMA_XFER_T *psXfer, uint32_t u32DestLen, uint32_t u32SrcLen, uint32_t u32TransCount);
+void PDMA_SvcSetRepeat(PDMA_XFER_T *psXfer, uint32_t u32DestInterval, uint32_t u32SrcInterval, uint32_t u32RepeatCount);
+int32_t PDMA_SvcSubmit(PDMA_SVC_T *psSvc, uint32_t u32Ch, PDMA_XFER_T *psXfer);
+void PDMA_SvcIRQHandler(PDMA_SVC_T *psSvc);
+uint32_t PDMA_SvcGetLoad(PDMA_SVC_T *psSvc, uint32_t u32Ch);
+void PDMA_SvcClearStats(PDMA_SVC_T *psSvc, uint32_t u32Ch);
+int32_t PDMA_CopyInit(PDMA_COPY_T *psCopy, PDMA_SVC_T *psSvc, uint32_t u32Threshold);
+void PDMA_CopyDeInit(PDMA_COPY_T *psCopy);
+void PDMA_CopySetThreshold(PDMA_COPY_T *psCopy, uint32_t u32Threshold);
+uint32_t PDMA_MemCopy(PDMA_COPY_T *psCopy, void *pvDst, const void *pvSrc, uint32_t u32Len);
+uint32_t PDMA_MemSet(PDMA_COPY_T *psCopy, void *pvDst, uint8_t u8Value, uint32_t u32Len);
+uint32_t PDMA_CopyIsDone(PDMA_COPY_T *psCopy, uint32_t u32Fence);
+int32_t PDMA_CopyWait(PDMA_COPY_T *psCopy, uint32_t u32Fence);
 
 
 /*@}*/ /* end of group PDMA_EXPORTED_FUNCTIONS */
@@ -103,6 +103,113 @@ extern "C"
 #define SPII2S_LEFT_ZC_INT_MASK             (0x40U)                          /*!< Left channel zero cross interrupt mask \hideinitializer */
 #define SPII2S_SLAVE_ERR_INT_MASK           (0x80U)                          /*!< Bit clock loss interrupt mask \hideinitializer */
 
+/* SPI Transaction Queue */
+#define SPI_TXN_CMD_MAX            (8U)                               /*!< Command, address and dummy bytes of one transaction \hideinitializer */
+#define SPI_TXN_SEG_MAX            (4U)                               /*!< PDMA segments of the data phase, 65536 bytes each \hideinitializer */
+
+#define SPI_TXN_KEEP_CS            (0x01U)                            /*!< Leave the chip select active for the next transaction of the device \hideinitializer */
+#define SPI_TXN_DATA_DUAL          (0x02U)                            /*!< Data phase on two lines, QSPI0/QSPI1 only \hideinitializer */
+#define SPI_TXN_DATA_QUAD          (0x04U)                            /*!< Data phase on four lines, QSPI0/QSPI1 only \hideinitializer */
+
+#define SPI_BUS_PENDING            (1L)                               /*!< Transaction queued or running \hideinitializer */
+#define SPI_BUS_PARAM_ERR          (-1L)                              /*!< Invalid bus, device or transaction \hideinitializer */
+#define SPI_BUS_BUSY_ERR           (-2L)                              /*!< Transactions still queued on the bus \hideinitializer */
+#define SPI_BUS_PDMA_ERR           (-3L)                              /*!< PDMA channel, descriptor or transfer failure \hideinitializer */
+
+/**
+  * @brief Settings of one device on a shared bus, prepared by SPI_BusInitDev().
+  */
+typedef struct
+{
+    uint32_t u32Mode;               /*!< SPI_MODE_0 ~ SPI_MODE_3 */
+    uint32_t u32ClkDiv;             /*!< CLKDIV value of the device bus clock */
+    uint32_t u32BusClock;           /*!< Actual bus clock in Hz */
+    uint32_t u32SSLevel;            /*!< SPI_SS_ACTIVE_HIGH or SPI_SS_ACTIVE_LOW */
+    volatile uint32_t *pu32CsPin;   /*!< GPIO bit driving the chip select, e.g. &PB2, or NULL for the SS pin */
+} SPI_DEV_T;
+
+typedef struct SPI_TXN SPI_TXN_T;
+
+/**
+  * @brief Completion callback, called from the PDMA interrupt (or SPI_BusSubmit() when the
+  *        transaction cannot be started).
+  * @details i32Status is 0 or \ref SPI_BUS_PDMA_ERR. The transaction belongs to the caller again
+  *          and may be submitted from the callback.
+  */
+typedef void (*SPI_TXN_CB_T)(SPI_TXN_T *psTxn, int32_t i32Status);
+
+/**
+  * @brief Queued transaction: command phase on one line, then an optional data phase.
+  * @details The fields above psNext are set by the caller, see SPI_BusInitTxn(). The rest belongs
+  *          to the bus from SPI_BusSubmit() until the callback. The transaction and the data
+  *          buffers must be in SRAM, the command bytes are sent from au8Cmd by PDMA.
+  */
+struct SPI_TXN
+{
+    const SPI_DEV_T *psDev;             /*!< Target device */
+    uint8_t au8Cmd[SPI_TXN_CMD_MAX];    /*!< Command, address and dummy bytes */
+    uint32_t u32CmdLen;                 /*!< Bytes in au8Cmd, 0 for a data-only transaction */
+    const uint8_t *pu8Tx;               /*!< Data to send, NULL to send 0xFF */
+    uint8_t *pu8Rx;                     /*!< Data received, NULL to discard */
+    uint32_t u32Len;                    /*!< Data phase bytes, up to SPI_TXN_SEG_MAX * 65536 */
+    uint32_t u32Flags;                  /*!< SPI_TXN_KEEP_CS | SPI_TXN_DATA_DUAL | SPI_TXN_DATA_QUAD */
+    SPI_TXN_CB_T pfnDone;               /*!< Completion callback, may be NULL */
+    void *pvArg;                        /*!< Caller context */
+    SPI_TXN_T *psNext;                  /*!< Next transaction queued on the bus */
+    uint32_t u32SubmitTime;             /*!< pfnGetTime() of the PDMA service at SPI_BusSubmit() */
+    volatile int32_t i32Status;         /*!< \ref SPI_BUS_PENDING until the callback, then its status */
+};
+
+/**
+  * @brief Per bus statistics, since SPI_BusOpen() or SPI_BusClearStats().
+  * @details Times are in ticks of the pfnGetTime() given to PDMA_SvcInit().
+  */
+typedef struct
+{
+    uint32_t u32Txns;               /*!< Completed transactions */
+    uint32_t u32Errors;             /*!< Transactions completed with an error */
+    uint32_t u32Bytes;              /*!< Command and data bytes of completed transactions */
+    uint32_t u32ModeSwitches;       /*!< Device changes that reloaded mode and bus clock */
+    uint32_t u32BusyTime;           /*!< Ticks with a transaction running */
+    uint32_t u32MaxDepth;           /*!< Highest number of transactions queued, the running one included */
+    uint32_t u32MaxLatency;         /*!< Highest delay from submit to completion */
+    uint32_t u32TotalLatency;       /*!< Sum of the delays from submit to completion */
+    uint32_t u32StartTime;          /*!< pfnGetTime() when the statistics were cleared */
+} SPI_BUS_STAT_T;
+
+/**
+  * @brief Transaction queue of one SPI or QSPI controller.
+  * @details The controller is set up by SPI_Open() (or QSPI_Open()) as master with 8-bit data
+  *          and automatic slave select disabled. The bus owns two channels of the PDMA service.
+  *          The bus state must be in SRAM, PDMA reads u32Fill and writes u32Sink.
+  */
+typedef struct
+{
+    SPI_T *spi;                             /*!< SPI0 ~ SPI10, or QSPI0/QSPI1 cast to SPI_T */
+    PDMA_SVC_T *psSvc;                      /*!< PDMA channel service */
+    uint32_t u32Quad;                       /*!< The controller is a QSPI */
+    uint32_t u32TxCh;                       /*!< TX PDMA channel */
+    uint32_t u32RxCh;                       /*!< RX PDMA channel */
+    uint32_t u32TxReq;                      /*!< TX PDMA request source */
+    uint32_t u32RxReq;                      /*!< RX PDMA request source */
+    SPI_TXN_T *psHead;                      /*!< Running transaction, NULL when idle */
+    SPI_TXN_T *psTail;                      /*!< Last queued transaction */
+    uint32_t u32Depth;                      /*!< Transactions queued, the running one included */
+    const SPI_DEV_T *psCurDev;              /*!< Device whose mode and clock are loaded */
+    const SPI_DEV_T *psCsDev;               /*!< Device whose chip select is active */
+    uint32_t u32Phase;                      /*!< Phase of the running transaction */
+    uint32_t u32XferCnt;                    /*!< PDMA transfers of the phase not yet completed */
+    int32_t i32Error;                       /*!< First error of the running transaction */
+    uint32_t u32RunTime;                    /*!< pfnGetTime() when the running transaction was started */
+    uint32_t u32Fill;                       /*!< Sent when a transaction has no TX data */
+    uint32_t u32Sink;                       /*!< Receives discarded RX data */
+    PDMA_XFER_T sTxXfer;
+    PDMA_XFER_T sRxXfer;
+    PDMA_SEG_T asTxSeg[SPI_TXN_SEG_MAX];
+    PDMA_SEG_T asRxSeg[SPI_TXN_SEG_MAX];
+    SPI_BUS_STAT_T sStat;
+} SPI_BUS_T;
+
 /*@}*/ /* end of group SPI_EXPORTED_CONSTANTS */
 
 /** @addtogroup SPI_EXPORTED_FUNCTIONS SPI Exported Functions
@@ -603,6 +710,14 @@ uint32_t SPII2S_EnableMCLK(SPI_T *i2s, uint32_t u32BusClock);
 void SPII2S_DisableMCLK(SPI_T *i2s);
 void SPII2S_SetFIFO(SPI_T *i2s, uint32_t u32TxThreshold, uint32_t u32RxThreshold);
 
+int32_t SPI_BusOpen(SPI_BUS_T *psBus, SPI_T *spi, PDMA_SVC_T *psSvc);
+int32_t SPI_BusClose(SPI_BUS_T *psBus);
+int32_t SPI_BusInitDev(SPI_BUS_T *psBus, SPI_DEV_T *psDev, uint32_t u32SPIMode, uint32_t u32BusClock, uint32_t u32SSLevel, volatile uint32_t *pu32CsPin);
+void SPI_BusInitTxn(SPI_TXN_T *psTxn, const SPI_DEV_T *psDev, const uint8_t *pu8Cmd, uint32_t u32CmdLen, const uint8_t *pu8Tx, uint8_t *pu8Rx, uint32_t u32Len, uint32_t u32Flags, SPI_TXN_CB_T pfnDone, void *pvArg);
+int32_t SPI_BusSubmit(SPI_BUS_T *psBus, SPI_TXN_T *psTxn);
+uint32_t SPI_BusGetLoad(SPI_BUS_T *psBus);
+void SPI_BusClearStats(SPI_BUS_T *psBus);
+
 
 /*@}*/ /* end of group SPI_EXPORTED_FUNCTIONS */
 
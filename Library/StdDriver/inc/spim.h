@@ -140,6 +140,189 @@ E_MFGID;
 #define SPIM_ERR_FAIL           (-1L)               /*!< SPIM operation failed */
 #define SPIM_ERR_TIMEOUT        (-2L)               /*!< SPIM operation abort due to timeout error */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* SPIM Programming Engine                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SPIM_PRG_PAGE_SIZE      256UL               /*!< Flash page, the unit of one Page Write mode transfer */
+#define SPIM_PRG_PENDING        (1L)                /*!< Operation queued or running */
+
+#define SPIM_PRG_OP_ERASE       0UL                 /*!< Erase the block holding u32Addr */
+#define SPIM_PRG_OP_PROGRAM     1UL                 /*!< Program u32Len bytes from pu8Src */
+#define SPIM_PRG_OP_READ        2UL                 /*!< Read u32Len bytes into pu8Dst */
+
+#define SPIM_PRG_ERASE_SUSPEND  0x75U               /*!< Default erase suspend command (Winbond, GigaDevice; 0xB0 on MXIC) */
+#define SPIM_PRG_ERASE_RESUME   0x7AU               /*!< Default erase resume command (Winbond, GigaDevice; 0x30 on MXIC) */
+
+typedef struct SPIM_PRG_OP SPIM_PRG_OP_T;
+
+/**
+  * @brief Completion callback, called from SPIM_PrgPoll().
+  * @details i32Status is \ref SPIM_OK or \ref SPIM_ERR_TIMEOUT. The operation belongs to the
+  *          caller again and may be queued from the callback.
+  */
+typedef void (*SPIM_PRG_CB_T)(SPIM_PRG_OP_T *psOp, int32_t i32Status);
+
+/**
+  * @brief Queued erase, program or read, filled in by SPIM_PrgErase(), SPIM_PrgProgram() or SPIM_PrgRead().
+  * @details The operation and its data belong to the engine until the callback.
+  */
+struct SPIM_PRG_OP
+{
+    uint32_t u32Type;               /*!< SPIM_PRG_OP_ERASE, SPIM_PRG_OP_PROGRAM or SPIM_PRG_OP_READ */
+    uint32_t u32Addr;               /*!< Flash address */
+    uint32_t u32Len;                /*!< Bytes to program or read */
+    uint32_t u32ErsCmd;             /*!< OPCODE_SE_4K, OPCODE_BE_32K or OPCODE_BE_64K of an erase */
+    const uint8_t *pu8Src;          /*!< Data to program, anywhere the CPU or PDMA can read */
+    uint8_t *pu8Dst;                /*!< Read buffer in SRAM */
+    SPIM_PRG_CB_T pfnDone;          /*!< Completion callback, may be NULL */
+    void *pvArg;                    /*!< Caller context */
+    SPIM_PRG_OP_T *psNext;          /*!< Next operation of the same queue */
+    uint32_t u32SubmitTime;         /*!< pfnGetTime() when queued */
+    volatile int32_t i32Status;     /*!< \ref SPIM_PRG_PENDING until the callback, then its status */
+};
+
+/**
+  * @brief Programming engine statistics, since SPIM_PrgInit() or SPIM_PrgClearStats().
+  * @details Times are in ticks of pfnGetTime().
+  */
+typedef struct
+{
+    uint32_t u32Pages;              /*!< Page writes completed */
+    uint32_t u32ProgBytes;          /*!< Bytes programmed */
+    uint32_t u32ProgTime;           /*!< Ticks from the first page write of a program to the end of its last one */
+    uint32_t u32Erases;             /*!< Erases completed */
+    uint32_t u32EraseTime;          /*!< Ticks from erase command to erase done, suspended time excluded */
+    uint32_t u32Suspends;           /*!< Erases suspended for a read */
+    uint32_t u32Reads;              /*!< Reads completed */
+    uint32_t u32MaxReadLatency;     /*!< Highest delay from queueing a read to its completion */
+    uint32_t u32StageStalls;        /*!< Page writes that waited for their data to be staged */
+    uint32_t u32Errors;             /*!< Operations completed with an error */
+} SPIM_PRG_STAT_T;
+
+/**
+  * @brief Programming engine state.
+  * @details Erases and programs run in queue order, reads go first and suspend a running erase.
+  *          While the flash programs one page from one stage buffer, the next page is copied into
+  *          the other one. Must be in SRAM: SPIM reads the stage buffers by DMA.
+  */
+typedef struct
+{
+    uint32_t u32Is4ByteAddr;        /*!< Flash commands carry 4-byte addresses */
+    uint32_t u32WrCmd;              /*!< Page Write mode command, e.g. CMD_NORMAL_PAGE_PROGRAM */
+    uint32_t u32RdCmd;              /*!< Page Read mode command, e.g. CMD_DMA_FAST_READ */
+    PDMA_COPY_T *psCopy;            /*!< Stages pages by PDMA, NULL to stage them by CPU */
+    uint32_t (*pfnGetTime)(void);   /*!< Time source of the statistics, hold time and timeout, may be NULL */
+    uint8_t u8SuspendCmd;           /*!< Erase suspend command */
+    uint8_t u8ResumeCmd;            /*!< Erase resume command */
+    uint32_t u32ResumeHold;         /*!< Ticks an erase runs after a resume before it may be suspended again */
+    uint32_t u32Timeout;            /*!< Ticks one erase or page write may take, 0 for no limit */
+    SPIM_PRG_OP_T *psHead;          /*!< Erase or program in progress */
+    SPIM_PRG_OP_T *psTail;
+    SPIM_PRG_OP_T *psRdHead;        /*!< Reads waiting or running */
+    SPIM_PRG_OP_T *psRdTail;
+    uint32_t u32State;              /*!< What the flash and SPIM are busy with */
+    uint32_t u32Suspended;          /*!< The erase of psHead is suspended */
+    uint32_t u32InPoll;             /*!< SPIM_PrgPoll() is running */
+    uint32_t u32Done;               /*!< Bytes of psHead programmed */
+    uint32_t u32PageLen;            /*!< Bytes of the page write running */
+    uint32_t u32OpTime;             /*!< pfnGetTime() when psHead was started */
+    uint32_t u32BusyTime;           /*!< pfnGetTime() when the running erase, page write or read was started */
+    uint32_t u32ResumeTime;         /*!< pfnGetTime() when the erase was started or resumed */
+    SPIM_PRG_OP_T *psStage;         /*!< Program whose pages are being staged */
+    uint32_t u32StageOff;           /*!< Bytes of psStage staged */
+    uint32_t u32StageLen;           /*!< Bytes in the staged page, 0 when none is staged */
+    uint32_t u32StageFence;         /*!< PDMA_MemCopy() fence of the staged page */
+    uint32_t u32StageIdx;           /*!< Stage buffer of the staged page */
+    uint32_t u32Stalled;            /*!< The waiting page write is counted in u32StageStalls */
+    SPIM_PRG_STAT_T sStat;
+    uint32_t au32Stage[2][SPIM_PRG_PAGE_SIZE / 4UL];
+} SPIM_PRG_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* SPIM Flash Translation Layer                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SPIM_FTL_SECTOR_SIZE    512UL               /*!< Logical sector, also the unit of remapping */
+#define SPIM_FTL_BLOCK_SIZE     4096UL              /*!< Erase block, erased with OPCODE_SE_4K */
+#define SPIM_FTL_SLOTS          7UL                 /*!< Data slots per block; the first sector holds the block header and tags */
+#ifndef SPIM_FTL_MAX_BLOCKS
+#define SPIM_FTL_MAX_BLOCKS     512UL               /*!< Blocks one FTL can manage, sizes the RAM tables (2 MB) */
+#endif
+#define SPIM_FTL_MIN_SPARE      4UL                 /*!< Fewest spare blocks garbage collection can work with */
+#define SPIM_FTL_WL_THRESHOLD   16UL                /*!< Default erase count spread that starts static wear leveling */
+#define SPIM_FTL_ERASE_JOBS     4UL                 /*!< Erases that may be queued at once */
+
+/**
+  * @brief Per-block bookkeeping of the FTL.
+  */
+typedef struct
+{
+    uint32_t u32EraseCnt;           /*!< Erases of the block */
+    uint32_t u32Seq;                /*!< Sequence number of the newest sector in the block */
+    uint8_t  u8State;               /*!< Free, open or closed */
+    uint8_t  u8Valid;               /*!< Slots holding the current copy of a sector */
+    uint16_t u16Rsvd;
+} SPIM_FTL_BLK_T;
+
+/**
+  * @brief Queued erase of a block and the program of its new header behind it.
+  */
+typedef struct
+{
+    SPIM_PRG_OP_T sErase;
+    SPIM_PRG_OP_T sHdr;
+    uint32_t au32Hdr[3];            /*!< Magic, erase count and its complement */
+} SPIM_FTL_ERASE_T;
+
+/**
+  * @brief FTL statistics, since SPIM_FtlMount() or SPIM_FtlClearStats().
+  */
+typedef struct
+{
+    uint32_t u32HostReads;          /*!< Sectors read by the caller */
+    uint32_t u32HostWrites;         /*!< Sectors written by the caller */
+    uint32_t u32GcCopies;           /*!< Sectors moved by garbage collection and wear leveling */
+    uint32_t u32GcRuns;             /*!< Blocks reclaimed by garbage collection */
+    uint32_t u32WlMoves;            /*!< Blocks of cold data moved by static wear leveling */
+    uint32_t u32Erases;             /*!< Blocks erased */
+    uint32_t u32Errors;             /*!< Flash operations completed with an error */
+} SPIM_FTL_STAT_T;
+
+/**
+  * @brief Wear-leveled flash translation layer over a SPIM_PRG_T engine.
+  * @details Sectors are written log-structured into an open block and remapped one by one;
+  *          the whole map lives in RAM and is rebuilt from the block tags at mount, so there is
+  *          no on-flash table to keep consistent across a power failure. Host writes and the
+  *          sectors moved by garbage collection fill separate open blocks, which keeps cold data
+  *          apart from hot. Must be in SRAM: SPIM moves the headers, tags and garbage collection
+  *          buffer by DMA.
+  */
+typedef struct
+{
+    SPIM_PRG_T *psPrg;              /*!< Engine all flash accesses go through */
+    uint32_t u32Base;               /*!< Flash address of the first block, block aligned */
+    uint32_t u32Blocks;             /*!< Blocks managed */
+    uint32_t u32Sectors;            /*!< Logical sectors offered, (u32Blocks - spare) * SPIM_FTL_SLOTS */
+    void (*pfnIdle)(void);          /*!< Called while waiting for the flash, e.g. to yield; may be NULL */
+    uint32_t u32WlThreshold;        /*!< Erase count spread that starts static wear leveling, 0 for none */
+    uint32_t u32Mounted;            /*!< SPIM_FtlMount() succeeded */
+    uint32_t au32Open[2];           /*!< Blocks written to by the host and by garbage collection, u32Blocks when none */
+    uint32_t au32NextSlot[2];       /*!< Next slot of each open block, SPIM_FTL_SLOTS + 1 when full */
+    uint32_t u32Seq;                /*!< Sequence number of the next sector written */
+    uint32_t u32FreeCnt;            /*!< Blocks erased or queued for erase */
+    SPIM_FTL_STAT_T sStat;
+    SPIM_PRG_OP_T sDataOp;          /*!< Program of sector data */
+    SPIM_PRG_OP_T sTagOp;           /*!< Program of the tags committing it */
+    SPIM_PRG_OP_T sOpenOp;          /*!< Program of the mark of an opened block */
+    SPIM_PRG_OP_T sRdOp;
+    SPIM_FTL_ERASE_T asErase[SPIM_FTL_ERASE_JOBS];
+    uint32_t u32EraseIdx;           /*!< Next erase job to use */
+    uint32_t au32Tag[SPIM_FTL_SLOTS * 4UL];
+    uint32_t au32Mark[2];
+    uint32_t au32Buf[SPIM_FTL_BLOCK_SIZE / 4UL];
+    SPIM_FTL_BLK_T asBlk[SPIM_FTL_MAX_BLOCKS];
+    uint16_t au16Map[SPIM_FTL_MAX_BLOCKS * SPIM_FTL_SLOTS];
+} SPIM_FTL_T;
+
 
 /*@}*/ /* end of group SPIM_EXPORTED_CONSTANTS */
 
@@ -622,6 +805,23 @@ void SPIM_SetQuadEnable(int isEn, uint32_t u32NBit);
 
 void SPIM_WinbondUnlock(uint32_t u32NBit);
 
+int32_t SPIM_PrgInit(SPIM_PRG_T *psPrg, int is4ByteAddr, uint32_t u32WrCmd, uint32_t u32RdCmd, PDMA_COPY_T *psCopy);
+int32_t SPIM_PrgErase(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, uint8_t u8ErsCmd, SPIM_PRG_CB_T pfnDone, void *pvArg);
+int32_t SPIM_PrgProgram(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, const uint8_t *pu8Src, uint32_t u32Len, SPIM_PRG_CB_T pfnDone, void *pvArg);
+int32_t SPIM_PrgRead(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, uint8_t *pu8Dst, uint32_t u32Len, SPIM_PRG_CB_T pfnDone, void *pvArg);
+uint32_t SPIM_PrgPoll(SPIM_PRG_T *psPrg);
+uint32_t SPIM_PrgGetThroughput(SPIM_PRG_T *psPrg);
+void SPIM_PrgClearStats(SPIM_PRG_T *psPrg);
+
+int32_t SPIM_FtlInit(SPIM_FTL_T *psFtl, SPIM_PRG_T *psPrg, uint32_t u32Base, uint32_t u32Blocks, uint32_t u32Spare);
+int32_t SPIM_FtlMount(SPIM_FTL_T *psFtl);
+int32_t SPIM_FtlRead(SPIM_FTL_T *psFtl, uint32_t u32Sector, uint8_t *pu8Buf, uint32_t u32Count);
+int32_t SPIM_FtlWrite(SPIM_FTL_T *psFtl, uint32_t u32Sector, const uint8_t *pu8Buf, uint32_t u32Count);
+int32_t SPIM_FtlSync(SPIM_FTL_T *psFtl);
+uint32_t SPIM_FtlGetSectorCount(SPIM_FTL_T *psFtl);
+void SPIM_FtlGetWear(SPIM_FTL_T *psFtl, uint32_t *pu32Min, uint32_t *pu32Max);
+void SPIM_FtlClearStats(SPIM_FTL_T *psFtl);
+
 /*@}*/ /* end of group SPIM_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group SPIM_Driver */
@@ -0,0 +1,273 @@
+/**************************************************************************//**
+ * @file     trace.h
+ * @version  V1.00
+ * @brief    Cycle-stamped event trace driver header file
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup TRACE_Driver TRACE Driver
+  @{
+*/
+
+/** @addtogroup TRACE_EXPORTED_CONSTANTS TRACE Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Return Code Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_OK                ( 0L)           /*!<Done \hideinitializer */
+#define TRACE_ERR_PARAM         (-1L)           /*!<Invalid argument \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Ring Mode Constant Definitions                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_MODE_WRAP         0UL             /*!<Keep the newest records, overwriting the oldest \hideinitializer */
+#define TRACE_MODE_ONESHOT      1UL             /*!<Keep the first records, dropping the rest \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Module Constant Definitions                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_MOD_APP           0UL             /*!<Application trace points \hideinitializer */
+#define TRACE_MOD_EHCI          1UL             /*!<USB host EHCI driver \hideinitializer */
+#define TRACE_MOD_PDMA          2UL             /*!<PDMA channel service \hideinitializer */
+#define TRACE_MOD_I2S           3UL             /*!<I2S interrupt handlers \hideinitializer */
+#define TRACE_MOD_SDH           4UL             /*!<SD host driver \hideinitializer */
+#define TRACE_MOD_CANFD         5UL             /*!<CAN FD driver \hideinitializer */
+
+#define TRACE_MSK_APP           (1UL << TRACE_MOD_APP)      /*!<Application trace points in TRACE_MODULES \hideinitializer */
+#define TRACE_MSK_EHCI          (1UL << TRACE_MOD_EHCI)     /*!<EHCI trace points in TRACE_MODULES \hideinitializer */
+#define TRACE_MSK_PDMA          (1UL << TRACE_MOD_PDMA)     /*!<PDMA trace points in TRACE_MODULES \hideinitializer */
+#define TRACE_MSK_I2S           (1UL << TRACE_MOD_I2S)      /*!<I2S trace points in TRACE_MODULES \hideinitializer */
+#define TRACE_MSK_SDH           (1UL << TRACE_MOD_SDH)      /*!<SDH trace points in TRACE_MODULES \hideinitializer */
+#define TRACE_MSK_CANFD         (1UL << TRACE_MOD_CANFD)    /*!<CAN FD trace points in TRACE_MODULES \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Trace Point Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_EHCI_IRQ          0UL             /*!<EHCI_IRQHandler(), argument USTSR \hideinitializer */
+#define TRACE_EHCI_UTR_DONE     1UL             /*!<UTR completion callback, argument transferred length \hideinitializer */
+
+#define TRACE_PDMA_SVC_IRQ      0UL             /*!<PDMA_SvcIRQHandler(), argument finished channels \hideinitializer */
+#define TRACE_PDMA_XFER_DONE    1UL             /*!<Transfer completion callback, argument channel \hideinitializer */
+
+#define TRACE_I2S_IRQ           0UL             /*!<I2S or I2S PDMA interrupt handler of the application \hideinitializer */
+#define TRACE_I2S_UNDERRUN      1UL             /*!<Audio buffer not refilled in time, mark \hideinitializer */
+
+#define TRACE_SDH_IRQ           0UL             /*!<SDH interrupt handler of the application \hideinitializer */
+#define TRACE_SDH_READ          1UL             /*!<SDH_Read(), argument sector count \hideinitializer */
+#define TRACE_SDH_WRITE         2UL             /*!<SDH_Write(), argument sector count \hideinitializer */
+
+#define TRACE_CANFD_IRQ         0UL             /*!<CAN FD interrupt handler of the application \hideinitializer */
+#define TRACE_CANFD_TX          1UL             /*!<CANFD_TransmitTxMsg(), argument Tx buffer \hideinitializer */
+#define TRACE_CANFD_RX_FIFO     2UL             /*!<CANFD_ReadRxFifoMsg(), argument Rx FIFO \hideinitializer */
+#define TRACE_CANFD_RX_BUF      3UL             /*!<CANFD_ReadRxBufMsg(), argument Rx buffer \hideinitializer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Event Word Constant Definitions                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_TYPE_MARK         0UL             /*!<Single event \hideinitializer */
+#define TRACE_TYPE_ENTER        1UL             /*!<Start of a span \hideinitializer */
+#define TRACE_TYPE_EXIT         2UL             /*!<End of a span \hideinitializer */
+
+#define TRACE_EVT_TYPE_Pos      30
+#define TRACE_EVT_TYPE_Msk      (0x3UL << TRACE_EVT_TYPE_Pos)
+#define TRACE_EVT_MOD_Pos       24
+#define TRACE_EVT_MOD_Msk       (0x3FUL << TRACE_EVT_MOD_Pos)
+#define TRACE_EVT_POINT_Pos     16
+#define TRACE_EVT_POINT_Msk     (0xFFUL << TRACE_EVT_POINT_Pos)
+#define TRACE_EVT_ARG_Pos       0
+#define TRACE_EVT_ARG_Msk       (0xFFFFUL << TRACE_EVT_ARG_Pos)
+
+#define TRACE_MAGIC             0x4352544EUL    /*!<"NTRC", first word of a dump \hideinitializer */
+#define TRACE_VERSION           1UL             /*!<Dump format version \hideinitializer */
+
+/**@}*/ /* end of group TRACE_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup TRACE_EXPORTED_STRUCTS TRACE Exported Structs
+  @{
+*/
+
+/**
+  * @details One trace record. u32Cycles is TRACE_TIMESTAMP() when the record took its slot, so the
+  *          records of the ring are in time order whatever interrupt wrote them.
+  */
+typedef struct
+{
+    uint32_t u32Cycles;             /*!< Timestamp, CPU cycles */
+    uint32_t u32Event;              /*!< Type, module, point and argument, see TRACE_EVENT() */
+} TRACE_REC_T;
+
+/**
+  * @details Header of a dump, followed by u32Count records, oldest first. All words are little endian.
+  */
+typedef struct
+{
+    uint32_t u32Magic;              /*!< \ref TRACE_MAGIC */
+    uint32_t u32Version;            /*!< \ref TRACE_VERSION */
+    uint32_t u32Freq;               /*!< Timestamp frequency in Hz, SystemCoreClock at the dump */
+    uint32_t u32Count;              /*!< Records that follow */
+    uint32_t u32Lost;               /*!< Records overwritten (wrap mode) or dropped (one-shot mode), 0xFFFFFFFF at most */
+} TRACE_HDR_T;
+
+/**
+  * @brief Output function of TRACE_Dump().
+  */
+typedef void (*TRACE_PUT_T)(void *pvPriv, const void *pvData, uint32_t u32Len);
+
+/**@}*/ /* end of group TRACE_EXPORTED_STRUCTS */
+
+
+/** @addtogroup TRACE_EXPORTED_FUNCTIONS TRACE Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Timestamp of the records
+  *
+  * @return     Free running 32-bit counter
+  *
+  * @details    DWT CYCCNT by default, enabled by TRACE_Init(). It wraps after 2^32 cycles, 21 s at
+  *             200 MHz; the host decoder takes each gap between two records as shorter than that.
+  *             Define TRACE_TIMESTAMP() in the project to use another counter.
+  * \hideinitializer
+  */
+#ifndef TRACE_TIMESTAMP
+#define TRACE_TIMESTAMP()       (DWT->CYCCNT)
+#define TRACE_TIMESTAMP_DWT
+#endif
+
+/**
+  * @brief      Build an event word
+  *
+  * @param[in]  u32Type     \ref TRACE_TYPE_MARK, \ref TRACE_TYPE_ENTER or \ref TRACE_TYPE_EXIT.
+  * @param[in]  u32Mod      Module, TRACE_MOD_xxx.
+  * @param[in]  u32Point    Trace point of the module, 0 ~ 255.
+  * @param[in]  u32Arg      Argument, the low 16 bits are kept.
+  *
+  * @return     Event word of a \ref TRACE_REC_T
+  * \hideinitializer
+  */
+#define TRACE_EVENT(u32Type, u32Mod, u32Point, u32Arg) \
+    ((((uint32_t)(u32Type) << TRACE_EVT_TYPE_Pos) & TRACE_EVT_TYPE_Msk) | \
+     (((uint32_t)(u32Mod) << TRACE_EVT_MOD_Pos) & TRACE_EVT_MOD_Msk) | \
+     (((uint32_t)(u32Point) << TRACE_EVT_POINT_Pos) & TRACE_EVT_POINT_Msk) | \
+     ((uint32_t)(u32Arg) & TRACE_EVT_ARG_Msk))
+
+/*
+    TRACE_MODULES selects at compile time the modules whose trace points are built, e.g.
+    -DTRACE_MODULES="(TRACE_MSK_PDMA|TRACE_MSK_CANFD)". The trace points of the other modules
+    expand to nothing, arguments included, so a disabled module costs no cycle and no byte.
+*/
+#ifndef TRACE_MODULES
+#define TRACE_MODULES           0UL
+#endif
+
+/// @cond HIDDEN_SYMBOLS
+#if (TRACE_MODULES & TRACE_MSK_APP)
+#define TRACE_REC_APP(u32Event)     TRACE_Record(u32Event)
+#else
+#define TRACE_REC_APP(u32Event)
+#endif
+
+#if (TRACE_MODULES & TRACE_MSK_EHCI)
+#define TRACE_REC_EHCI(u32Event)    TRACE_Record(u32Event)
+#else
+#define TRACE_REC_EHCI(u32Event)
+#endif
+
+#if (TRACE_MODULES & TRACE_MSK_PDMA)
+#define TRACE_REC_PDMA(u32Event)    TRACE_Record(u32Event)
+#else
+#define TRACE_REC_PDMA(u32Event)
+#endif
+
+#if (TRACE_MODULES & TRACE_MSK_I2S)
+#define TRACE_REC_I2S(u32Event)     TRACE_Record(u32Event)
+#else
+#define TRACE_REC_I2S(u32Event)
+#endif
+
+#if (TRACE_MODULES & TRACE_MSK_SDH)
+#define TRACE_REC_SDH(u32Event)     TRACE_Record(u32Event)
+#else
+#define TRACE_REC_SDH(u32Event)
+#endif
+
+#if (TRACE_MODULES & TRACE_MSK_CANFD)
+#define TRACE_REC_CANFD(u32Event)   TRACE_Record(u32Event)
+#else
+#define TRACE_REC_CANFD(u32Event)
+#endif
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Record the start of a span
+  *
+  * @param[in]  mod         Module name: APP, EHCI, PDMA, I2S, SDH or CANFD.
+  * @param[in]  u32Point    Trace point, TRACE_<mod>_xxx or an application number.
+  * @param[in]  u32Arg      Argument, the low 16 bits are kept.
+  *
+  * @return     None
+  *
+  * @details    Spans nest: the host decoder pairs each TRACE_EXIT() with the innermost open
+  *             TRACE_ENTER() of the same point.
+  * \hideinitializer
+  */
+#define TRACE_ENTER(mod, u32Point, u32Arg)  TRACE_REC_##mod(TRACE_EVENT(TRACE_TYPE_ENTER, TRACE_MOD_##mod, (u32Point), (u32Arg)))
+
+/**
+  * @brief      Record the end of a span
+  *
+  * @param[in]  mod         Module name: APP, EHCI, PDMA, I2S, SDH or CANFD.
+  * @param[in]  u32Point    Trace point given to TRACE_ENTER().
+  * @param[in]  u32Arg      Argument, the low 16 bits are kept.
+  *
+  * @return     None
+  * \hideinitializer
+  */
+#define TRACE_EXIT(mod, u32Point, u32Arg)   TRACE_REC_##mod(TRACE_EVENT(TRACE_TYPE_EXIT, TRACE_MOD_##mod, (u32Point), (u32Arg)))
+
+/**
+  * @brief      Record a single event
+  *
+  * @param[in]  mod         Module name: APP, EHCI, PDMA, I2S, SDH or CANFD.
+  * @param[in]  u32Point    Trace point, TRACE_<mod>_xxx or an application number.
+  * @param[in]  u32Arg      Argument, the low 16 bits are kept.
+  *
+  * @return     None
+  * \hideinitializer
+  */
+#define TRACE_MARK(mod, u32Point, u32Arg)   TRACE_REC_##mod(TRACE_EVENT(TRACE_TYPE_MARK, TRACE_MOD_##mod, (u32Point), (u32Arg)))
+
+int32_t TRACE_Init(TRACE_REC_T *psRing, uint32_t u32Size, uint32_t u32Mode);
+void TRACE_Start(void);
+void TRACE_Stop(void);
+void TRACE_Record(uint32_t u32Event);
+uint32_t TRACE_Dump(TRACE_PUT_T pfnPut, void *pvPriv);
+
+/**@}*/ /* end of group TRACE_EXPORTED_FUNCTIONS */
+
+/**@}*/ /* end of group TRACE_Driver */
+
+/**@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H__ */
@@ -117,6 +117,84 @@ extern "C"
 #define UART_BAUD_MODE0     (0ul) /*!< Set UART Baudrate Mode is Mode0 \hideinitializer */
 #define UART_BAUD_MODE2     (UART_BAUD_BAUDM1_Msk | UART_BAUD_BAUDM0_Msk) /*!< Set UART Baudrate Mode is Mode2 \hideinitializer */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* UART Buffered Port Definitions                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define UART_BUF_NO_PDMA        0xFFFFFFFFUL    /*!< Direction served by the FIFO interrupts instead of a PDMA channel \hideinitializer */
+#define UART_BUF_PARAM_ERR      (-1L)           /*!< UART_BufOpen() configuration error \hideinitializer */
+#define UART_BUF_NOCH_ERR       (-2L)           /*!< UART_BufOpen() found no free PDMA channel in the service \hideinitializer */
+
+#define UART_BUF_EV_RX_IDLE     0x1UL           /*!< RX time-out after data (UART0~9 only) \hideinitializer */
+#define UART_BUF_EV_RX_HALF     0x2UL           /*!< Another half ring received \hideinitializer */
+#define UART_BUF_EV_TX_EMPTY    0x4UL           /*!< TX ring drained into the FIFO \hideinitializer */
+
+struct UART_BUF;
+struct PDMA_SVC;
+
+/**
+  * @brief Buffered port configuration.
+  * @details Exactly one of uart and uuart is set. The ring sizes are powers of two, at most
+  *          65536 bytes for a direction served by PDMA. Rings and psRxDesc must be in SRAM;
+  *          psRxDesc must share the 64 KB SCATBA window with the descriptor pool of the service.
+  *          UART_BufOpen() allocates the PDMA channels from psSvc as \ref PDMA_SVC_CH_DIRECT
+  *          channels, so PDMA_SvcIRQHandler() leaves their TDSTS flags to the port.
+  */
+typedef struct
+{
+    UART_T *uart;                   /*!< UART0 ~ UART9, or NULL */
+    UUART_T *uuart;                 /*!< UUART0, or NULL */
+    struct PDMA_SVC *psSvc;         /*!< PDMA channel service, unused when both directions use the FIFO interrupts */
+    uint32_t u32RxChFlags;          /*!< RX channel capability \ref PDMA_SVC_CH_ANY, or \ref UART_BUF_NO_PDMA */
+    uint32_t u32TxChFlags;          /*!< TX channel capability \ref PDMA_SVC_CH_ANY, or \ref UART_BUF_NO_PDMA */
+    uint8_t *pu8RxBuf;              /*!< RX ring */
+    uint32_t u32RxSize;             /*!< RX ring size */
+    uint8_t *pu8TxBuf;              /*!< TX ring */
+    uint32_t u32TxSize;             /*!< TX ring size */
+    DSCT_T *psRxDesc;               /*!< Two descriptors, one per ring half, PDMA RX only */
+    uint32_t u32RxTimeout;          /*!< RX time-out in bit times (TOIC, 1 ~ 255), 0 for 40 (about 3.5 characters) */
+    void (*pfnEvent)(struct UART_BUF *psBuf, uint32_t u32Events);   /*!< UART_BUF_EV_x from interrupt context, or NULL */
+} UART_BUF_CFG_T;
+
+/**
+  * @brief Buffered port statistics.
+  */
+typedef struct
+{
+    uint32_t u32RxOverruns;         /*!< Times the RX ring overflowed */
+    uint32_t u32RxDropped;          /*!< Bytes lost or discarded by RX ring overflows */
+    uint32_t u32FifoOverruns;       /*!< Hardware RX FIFO overflows (RXOVIF) */
+    uint32_t u32ParityErrs;         /*!< Parity errors */
+    uint32_t u32FrameErrs;          /*!< Framing errors */
+    uint32_t u32Breaks;             /*!< Break conditions */
+    uint32_t u32RxIdle;             /*!< RX time-outs */
+    uint32_t u32TxRefused;          /*!< Bytes UART_BufWrite() refused for lack of ring space */
+    uint32_t u32TxDmaRuns;          /*!< TX PDMA transfers started */
+} UART_BUF_STATS_T;
+
+/**
+  * @brief Buffered port state.
+  * @details The rings run freely and are masked with (size - 1). With PDMA the RX head is derived
+  *          from the remaining count of the channel and the number of completed ring halves, so
+  *          received bytes are readable at once without a flush. u32RxTail and u32TxHead are written
+  *          only by the thread, the other indexes in interrupt context or with interrupts masked.
+  */
+typedef struct UART_BUF
+{
+    UART_BUF_CFG_T sCfg;
+    PDMA_T *pdma;                   /*!< PDMA of the service, NULL without PDMA */
+    uint32_t u32RxCh;               /*!< RX PDMA channel, or \ref UART_BUF_NO_PDMA */
+    uint32_t u32TxCh;               /*!< TX PDMA channel, or \ref UART_BUF_NO_PDMA */
+    volatile uint32_t u32RxHead;    /*!< Bytes received */
+    volatile uint32_t u32RxTail;    /*!< Bytes consumed */
+    volatile uint32_t u32RxHalves;  /*!< PDMA RX: ring halves completed */
+    volatile uint32_t u32RxMark;    /*!< FIFO RX: head at the last \ref UART_BUF_EV_RX_HALF */
+    volatile uint32_t u32TxHead;    /*!< Bytes queued */
+    volatile uint32_t u32TxTail;    /*!< Bytes handed to the FIFO */
+    volatile uint32_t u32TxDmaLen;  /*!< PDMA TX: bytes in flight, 0 when idle */
+    volatile uint32_t u32TxNotify;  /*!< \ref UART_BUF_EV_TX_EMPTY owed since the last UART_BufWrite() */
+    UART_BUF_STATS_T sStats;
+} UART_BUF_T;
+
 
 /*@}*/ /* end of group UART_EXPORTED_CONSTANTS */
 
@@ -521,6 +599,17 @@ void UART_SelectRS485Mode(UART_T* uart, uint32_t u32Mode, uint32_t u32Addr);
 void UART_SelectLINMode(UART_T* uart, uint32_t u32Mode, uint32_t u32BreakLength);
 uint32_t UART_Write(UART_T* uart, uint8_t pu8TxBuf[], uint32_t u32WriteBytes);
 void UART_SelectSingleWireMode(UART_T *uart);
+int32_t UART_BufOpen(UART_BUF_T *psBuf, const UART_BUF_CFG_T *psCfg);
+void UART_BufClose(UART_BUF_T *psBuf);
+uint32_t UART_BufRead(UART_BUF_T *psBuf, uint8_t *pu8Data, uint32_t u32Len);
+uint32_t UART_BufPeek(UART_BUF_T *psBuf, uint8_t *pu8Data, uint32_t u32Len);
+uint32_t UART_BufWrite(UART_BUF_T *psBuf, const uint8_t *pu8Data, uint32_t u32Len);
+uint32_t UART_BufRxCount(UART_BUF_T *psBuf);
+uint32_t UART_BufTxSpace(UART_BUF_T *psBuf);
+uint32_t UART_BufTxPending(UART_BUF_T *psBuf);
+void UART_BufIRQHandler(UART_BUF_T *psBuf);
+void UART_BufPdmaIRQHandler(UART_BUF_T *psBuf);
+void UART_BufClearStats(UART_BUF_T *psBuf);
 
 
 
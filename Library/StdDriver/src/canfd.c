@@ -389,6 +389,21 @@ static void CANFD_SetTimingConfig(CANFD_T *psCanfd, const CANFD_TIMEING_CONFIG_T
         /* Get CANF D0 clock divider number */
         CLK->CLKDIV5 = (CLK->CLKDIV5 & ~CLK_CLKDIV5_CANFD0DIV_Msk) | CLK_CLKDIV5_CANFD0(psConfig->u8PreDivider) ;
     }
+    else if (psCanfd == (CANFD_T *)CANFD1)
+    {
+        /* Get CANF D1 clock divider number */
+        CLK->CLKDIV5 = (CLK->CLKDIV5 & ~CLK_CLKDIV5_CANFD1DIV_Msk) | CLK_CLKDIV5_CANFD1(psConfig->u8PreDivider) ;
+    }
+    else if (psCanfd == (CANFD_T *)CANFD2)
+    {
+        /* Get CANF D2 clock divider number */
+        CLK->CLKDIV5 = (CLK->CLKDIV5 & ~CLK_CLKDIV5_CANFD2DIV_Msk) | CLK_CLKDIV5_CANFD2(psConfig->u8PreDivider) ;
+    }
+    else if (psCanfd == (CANFD_T *)CANFD3)
+    {
+        /* Get CANF D3 clock divider number */
+        CLK->CLKDIV5 = (CLK->CLKDIV5 & ~CLK_CLKDIV5_CANFD3DIV_Msk) | CLK_CLKDIV5_CANFD3(psConfig->u8PreDivider) ;
+    }
 
     /* nominal bit rate */
     psCanfd->NBTP = (((psConfig->u8NominalRJumpwidth & 0x7F) - 1) << 25) +
@@ -573,7 +588,7 @@ void CANFD_Open(CANFD_T *psCanfd, CANFD_FD_T *psCanfdStr)
     if (psCanfd == (CANFD_T *)CANFD0)
     {
         //CLK_EnableModuleClock(CANFD0_MODULE);
-		CLK->AHBCLK1 |= BIT0;
+		CLK->AHBCLK1 |= CLK_AHBCLK1_CANFD0CKEN_Msk;
         //SYS_ResetModule(CANFD0_RST);
         NVIC_EnableIRQ(CANFD00_IRQn);
         NVIC_EnableIRQ(CANFD01_IRQn);
@@ -581,7 +596,7 @@ void CANFD_Open(CANFD_T *psCanfd, CANFD_FD_T *psCanfdStr)
 	else if (psCanfd == (CANFD_T *)CANFD1)
     {
         //CLK_EnableModuleClock(CANFD1_MODULE);
-		CLK->AHBCLK1 |= BIT1;
+		CLK->AHBCLK1 |= CLK_AHBCLK1_CANFD1CKEN_Msk;
         //SYS_ResetModule(CANFD1_RST);
         NVIC_EnableIRQ(CANFD10_IRQn);
         NVIC_EnableIRQ(CANFD11_IRQn);
@@ -589,7 +604,7 @@ void CANFD_Open(CANFD_T *psCanfd, CANFD_FD_T *psCanfdStr)
 	else if (psCanfd == (CANFD_T *)CANFD2)
     {
         //CLK_EnableModuleClock(CANFD2_MODULE);
-		CLK->AHBCLK1 |= BIT2;
+		CLK->AHBCLK1 |= CLK_AHBCLK1_CANFD2CKEN_Msk;
         //SYS_ResetModule(CANFD2_RST);
         NVIC_EnableIRQ(CANFD20_IRQn);
         NVIC_EnableIRQ(CANFD21_IRQn);
@@ -597,7 +612,7 @@ void CANFD_Open(CANFD_T *psCanfd, CANFD_FD_T *psCanfdStr)
 	else if (psCanfd == (CANFD_T *)CANFD3)
     {
         //CLK_EnableModuleClock(CANFD3_MODULE);
-		CLK->AHBCLK1 |= BIT3;
+		CLK->AHBCLK1 |= CLK_AHBCLK1_CANFD3CKEN_Msk;
         //SYS_ResetModule(CANFD3_RST);
         NVIC_EnableIRQ(CANFD30_IRQn);
         NVIC_EnableIRQ(CANFD31_IRQn);
@@ -640,7 +655,7 @@ void CANFD_Open(CANFD_T *psCanfd, CANFD_FD_T *psCanfdStr)
         CANFD_ConfigXIDFC(psCanfd, &psCanfdStr->sMRamStartAddr, &psCanfdStr->sElemSize);
 
     /*Configures the Tx Buffer element */
-    if (psCanfdStr->sElemSize.u32RxBuf != 0)
+    if (psCanfdStr->sElemSize.u32TxBuf != 0)
         CANFD_InitTxDBuf(psCanfd, &psCanfdStr->sMRamStartAddr, &psCanfdStr->sElemSize, eCANFD_BYTE64);
 
     /*Configures the Rx Buffer element */
@@ -684,28 +699,28 @@ void CANFD_Close(CANFD_T *psCanfd)
     if (psCanfd == (CANFD_T *)CANFD0)
     {
         //CLK_DisableModuleClock(CANFD0_MODULE);
-		CLK->AHBCLK1 |= BIT20;
+		CLK->AHBCLK1 &= ~CLK_AHBCLK1_CANFD0CKEN_Msk;
         NVIC_DisableIRQ(CANFD00_IRQn);
         NVIC_DisableIRQ(CANFD01_IRQn);
     }
 	else if (psCanfd == (CANFD_T *)CANFD1)
     {
         //CLK_DisableModuleClock(CANFD1_MODULE);
-		CLK->AHBCLK1 |= BIT21;
+		CLK->AHBCLK1 &= ~CLK_AHBCLK1_CANFD1CKEN_Msk;
         NVIC_DisableIRQ(CANFD10_IRQn);
         NVIC_DisableIRQ(CANFD11_IRQn);
     }
 	else if (psCanfd == (CANFD_T *)CANFD2)
     {
         //CLK_DisableModuleClock(CANFD2_MODULE);
-		CLK->AHBCLK1 |= BIT22;
+		CLK->AHBCLK1 &= ~CLK_AHBCLK1_CANFD2CKEN_Msk;
         NVIC_DisableIRQ(CANFD20_IRQn);
         NVIC_DisableIRQ(CANFD21_IRQn);
     }
 	else if (psCanfd == (CANFD_T *)CANFD3)
     {
         //CLK_DisableModuleClock(CANFD3_MODULE);
-		CLK->AHBCLK1 |= BIT23;
+		CLK->AHBCLK1 &= ~CLK_AHBCLK1_CANFD3CKEN_Msk;
         NVIC_DisableIRQ(CANFD30_IRQn);
         NVIC_DisableIRQ(CANFD31_IRQn);
     }
@@ -896,6 +911,8 @@ uint32_t CANFD_TransmitTxMsg(CANFD_T *psCanfd, uint32_t u32TxBufIdx, CANFD_FD_MS
     uint32_t u32Success = 0;
     uint32_t u32TimeOutCnt = CANFD_TIMEOUT;
 
+    TRACE_ENTER(CANFD, TRACE_CANFD_TX, u32TxBufIdx);
+
     /* write the message to the message buffer */
     u32Success = CANFD_TransmitDMsg(psCanfd, u32TxBufIdx, psTxMsg);
 
@@ -913,6 +930,8 @@ uint32_t CANFD_TransmitTxMsg(CANFD_T *psCanfd, uint32_t u32TxBufIdx, CANFD_FD_MS
         }
     }
 
+    TRACE_EXIT(CANFD, TRACE_CANFD_TX, u32Success);
+
     return u32Success;
 }
 
@@ -1315,6 +1334,8 @@ uint32_t CANFD_ReadRxBufMsg(CANFD_T *psCanfd, uint8_t u8MbIdx, CANFD_FD_MSG_T *p
     uint32_t newData = 0;
 	uint32_t u32SramBaseAddr;
 
+    TRACE_ENTER(CANFD, TRACE_CANFD_RX_BUF, u8MbIdx);
+
     if (u8MbIdx < CANFD_MAX_RX_BUF_ELEMS)
     {
         if (u8MbIdx < 32)
@@ -1335,14 +1356,16 @@ uint32_t CANFD_ReadRxBufMsg(CANFD_T *psCanfd, uint8_t u8MbIdx, CANFD_FD_MSG_T *p
 
             /* clear 'new data' flag */
             if (u8MbIdx < 32)
-                psCanfd->NDAT1 |= (1UL << u8MbIdx);
+                psCanfd->NDAT1 = (1UL << u8MbIdx);
             else
-                psCanfd->NDAT2 |= (1UL << (u8MbIdx - 32));
+                psCanfd->NDAT2 = (1UL << (u8MbIdx - 32));
 
             u32Success = 1;
         }
     }
 
+    TRACE_EXIT(CANFD, TRACE_CANFD_RX_BUF, u32Success);
+
     return u32Success;
 }
 
@@ -1370,6 +1393,8 @@ uint32_t CANFD_ReadRxFifoMsg(CANFD_T *psCanfd, uint8_t u8FifoIdx, CANFD_FD_MSG_T
     uint8_t msgLostBit;
 	uint32_t u32SramBaseAddr;
 
+    TRACE_ENTER(CANFD, TRACE_CANFD_RX_FIFO, u8FifoIdx);
+
     /* check for valid FIFO number */
     if (u8FifoIdx < CANFD_NUM_RX_FIFOS)
     {
@@ -1414,6 +1439,8 @@ uint32_t CANFD_ReadRxFifoMsg(CANFD_T *psCanfd, uint8_t u8FifoIdx, CANFD_FD_MSG_T
         }
     }
 
+    TRACE_EXIT(CANFD, TRACE_CANFD_RX_FIFO, u32Success);
+
     return u32Success;
 }
 
@@ -1750,7 +1777,7 @@ uint32_t CANFD_GetStatusFlag(CANFD_T *psCanfd, uint32_t u32IntTypeFlag)
 void CANFD_ClearStatusFlag(CANFD_T *psCanfd, uint32_t u32InterruptFlag)
 {
     /* Write 1 to clear status flag. */
-    psCanfd->IR |= u32InterruptFlag;
+    psCanfd->IR = u32InterruptFlag;
 }
 
 
@@ -1821,6 +1848,657 @@ int32_t CANFD_RunToNormal(CANFD_T *psCanfd, uint8_t u8Enable)
 }
 
 
+/* Key flag marking extended IDs in the software filter */
+#define CANFD_FLTR_XTD           (1ul << 31)
+/* Largest classic filter cube tried by the compiler, in don't-care bits */
+#define CANFD_FLTR_MAX_CUBE_BITS 12ul
+/* Hash set empty slot */
+#define CANFD_FLTR_HASH_EMPTY    0xFFFFFFFFul
+
+/* Filter element produced by CANFD_FltrCompile() */
+typedef struct
+{
+    uint32_t u32Id1;    /* range low, dual ID 1 or classic filter ID */
+    uint32_t u32Id2;    /* range high, dual ID 2 or classic filter mask */
+    uint32_t u32Type;   /* eCANFD_SID_FLTR_TYPE_RANGE/DUAL/CLASSIC, same encoding for XID */
+    uint32_t u32Ids;    /* IDs this element is accounted for */
+} CANFD_FLTR_ELEM_T;
+
+
+static void CANFD_FltrSortRange(CANFD_ID_RANGE_T *psList, uint32_t u32Cnt)
+{
+    uint32_t u32Gap, i, j;
+    CANFD_ID_RANGE_T sTmp;
+
+    for (u32Gap = u32Cnt / 2; u32Gap > 0; u32Gap /= 2)
+    {
+        for (i = u32Gap; i < u32Cnt; i++)
+        {
+            sTmp = psList[i];
+
+            for (j = i; (j >= u32Gap) && (psList[j - u32Gap].u32IdLow > sTmp.u32IdLow); j -= u32Gap)
+                psList[j] = psList[j - u32Gap];
+
+            psList[j] = sTmp;
+        }
+    }
+}
+
+
+static void CANFD_FltrSortElem(CANFD_FLTR_ELEM_T *psElem, uint32_t u32Cnt)
+{
+    uint32_t u32Gap, i, j;
+    CANFD_FLTR_ELEM_T sTmp;
+
+    /* most IDs per element first */
+    for (u32Gap = u32Cnt / 2; u32Gap > 0; u32Gap /= 2)
+    {
+        for (i = u32Gap; i < u32Cnt; i++)
+        {
+            sTmp = psElem[i];
+
+            for (j = i; (j >= u32Gap) && (psElem[j - u32Gap].u32Ids < sTmp.u32Ids); j -= u32Gap)
+                psElem[j] = psElem[j - u32Gap];
+
+            psElem[j] = sTmp;
+        }
+    }
+}
+
+
+/* Index of u32Id in the sorted single ID list (bit 31 is the "covered" mark), -1 if absent */
+static int32_t CANFD_FltrFindSingle(const uint32_t *pu32Single, uint32_t u32Cnt, uint32_t u32Id)
+{
+    uint32_t u32Lo = 0, u32Hi = u32Cnt, u32Mid, u32Val;
+
+    while (u32Lo < u32Hi)
+    {
+        u32Mid = (u32Lo + u32Hi) / 2;
+        u32Val = pu32Single[u32Mid] & ~CANFD_FLTR_XTD;
+
+        if (u32Val == u32Id)
+            return (int32_t)u32Mid;
+        else if (u32Val < u32Id)
+            u32Lo = u32Mid + 1;
+        else
+            u32Hi = u32Mid;
+    }
+
+    return -1;
+}
+
+
+/* Index of the range element covering exactly u32Size IDs from u32Low, -1 if absent. Range elements are sorted. */
+static int32_t CANFD_FltrFindBlock(const CANFD_FLTR_ELEM_T *psElem, uint32_t u32Cnt, uint32_t u32Low, uint32_t u32Size)
+{
+    uint32_t u32Lo = 0, u32Hi = u32Cnt, u32Mid;
+
+    while (u32Lo < u32Hi)
+    {
+        u32Mid = (u32Lo + u32Hi) / 2;
+
+        if (psElem[u32Mid].u32Id1 == u32Low)
+            return ((psElem[u32Mid].u32Id2 - u32Low + 1) == u32Size) ? (int32_t)u32Mid : -1;
+        else if (psElem[u32Mid].u32Id1 < u32Low)
+            u32Lo = u32Mid + 1;
+        else
+            u32Hi = u32Mid;
+    }
+
+    return -1;
+}
+
+
+static uint32_t CANFD_FltrBitCount(uint32_t u32Value)
+{
+    uint32_t u32Cnt = 0;
+
+    while (u32Value)
+    {
+        u32Value &= u32Value - 1;
+        u32Cnt++;
+    }
+
+    return u32Cnt;
+}
+
+
+static uint32_t CANFD_FltrHashIdx(uint32_t u32Key, uint32_t u32Size)
+{
+    uint32_t u32Hash = u32Key * 0x9E3779B1ul;
+
+    return (u32Hash ^ (u32Hash >> 16)) & (u32Size - 1);
+}
+
+
+static int32_t CANFD_FltrHashAdd(CANFD_FLTR_T *psFltr, uint32_t u32Key)
+{
+    uint32_t u32Idx;
+
+    if (psFltr->u32HashSize == 0)
+        return CANFD_ERR_FLTR_FULL;
+
+    u32Idx = CANFD_FltrHashIdx(u32Key, psFltr->u32HashSize);
+
+    while (psFltr->pu32Hash[u32Idx] != CANFD_FLTR_HASH_EMPTY)
+    {
+        if (psFltr->pu32Hash[u32Idx] == u32Key)
+            return CANFD_OK;
+
+        u32Idx = (u32Idx + 1) & (psFltr->u32HashSize - 1);
+    }
+
+    /* keep the load factor at 75% so that a miss terminates quickly */
+    if ((psFltr->u32HashCnt + 1) * 4 > psFltr->u32HashSize * 3)
+        return CANFD_ERR_FLTR_FULL;
+
+    psFltr->pu32Hash[u32Idx] = u32Key;
+    psFltr->u32HashCnt++;
+
+    return CANFD_OK;
+}
+
+
+/* Hand an element that did not fit the filter list over to the software filter */
+static int32_t CANFD_FltrAddSw(CANFD_FLTR_T *psFltr, const CANFD_FLTR_ELEM_T *psElem, uint32_t u32Xtd)
+{
+    uint32_t u32Sub, u32Mask, u32Low, u32Id;
+
+    if (psElem->u32Type == eCANFD_SID_FLTR_TYPE_RANGE)
+    {
+        if (psFltr->u32RangeCnt >= psFltr->u32RangeMax)
+            return CANFD_ERR_FLTR_FULL;
+
+        psFltr->psRange[psFltr->u32RangeCnt].u32IdLow = psElem->u32Id1 | u32Xtd;
+        psFltr->psRange[psFltr->u32RangeCnt].u32IdHigh = psElem->u32Id2 | u32Xtd;
+        psFltr->u32RangeCnt++;
+
+        return CANFD_OK;
+    }
+
+    if (psElem->u32Type == eCANFD_SID_FLTR_TYPE_DUAL)
+    {
+        if (CANFD_FltrHashAdd(psFltr, psElem->u32Id1 | u32Xtd) != CANFD_OK)
+            return CANFD_ERR_FLTR_FULL;
+
+        return CANFD_FltrHashAdd(psFltr, psElem->u32Id2 | u32Xtd);
+    }
+
+    /* classic filter: one range per block of the low don't-care bits, single IDs if there are none */
+    u32Mask = ~psElem->u32Id2 & (u32Xtd ? 0x1FFFFFFFul : 0x7FFul);
+    u32Low = u32Mask & ~(u32Mask + 1);
+    u32Mask &= ~u32Low;
+    u32Sub = u32Mask;
+
+    while (1)
+    {
+        u32Id = (psElem->u32Id1 & ~(u32Mask | u32Low)) | u32Sub | u32Xtd;
+
+        if (u32Low)
+        {
+            if (psFltr->u32RangeCnt >= psFltr->u32RangeMax)
+                return CANFD_ERR_FLTR_FULL;
+
+            psFltr->psRange[psFltr->u32RangeCnt].u32IdLow = u32Id;
+            psFltr->psRange[psFltr->u32RangeCnt].u32IdHigh = u32Id | u32Low;
+            psFltr->u32RangeCnt++;
+        }
+        else if (CANFD_FltrHashAdd(psFltr, u32Id) != CANFD_OK)
+        {
+            return CANFD_ERR_FLTR_FULL;
+        }
+
+        if (u32Sub == 0)
+            break;
+
+        u32Sub = (u32Sub - 1) & u32Mask;
+    }
+
+    return CANFD_OK;
+}
+
+
+/**
+ * @brief       Initialize a compiled acceptance filter.
+ *
+ * @param[in]   psFltr      The compiled filter.
+ * @param[in]   pu32Hash    Storage of the software ID hash set, NULL when u32HashSize is 0.
+ * @param[in]   u32HashSize Number of hash set entries, power of two. Up to 3/4 of them are used.
+ *                          0 leaves out the hash set: single IDs that do not fit the filter
+ *                          elements make CANFD_FltrCompile() fail with CANFD_ERR_FLTR_FULL.
+ * @param[in]   psRange     Storage of the software range list.
+ * @param[in]   u32RangeMax Number of range list entries.
+ * @param[in]   pu32Work    Scratch buffer used by CANFD_FltrCompile() only.
+ * @param[in]   u32WorkSize Scratch buffer size in words. 10 words per acceptance list entry are always enough.
+ *
+ * @retval      CANFD_OK                Ready for CANFD_FltrCompile().
+ * @retval      CANFD_ERR_FLTR_PARAM    u32HashSize is not 0 or a power of two, or pu32Hash is NULL.
+ *
+ * @details     Clears the software filter and the statistics. Call CANFD_FltrCompile()
+ *              afterwards once for standard IDs and/or once for extended IDs.
+ */
+int32_t CANFD_FltrInit(CANFD_FLTR_T *psFltr, uint32_t *pu32Hash, uint32_t u32HashSize, CANFD_ID_RANGE_T *psRange, uint32_t u32RangeMax, uint32_t *pu32Work, uint32_t u32WorkSize)
+{
+    uint32_t i;
+
+    memset(psFltr, 0, sizeof(CANFD_FLTR_T));
+
+    if ((u32HashSize & (u32HashSize - 1)) || (u32HashSize && (pu32Hash == NULL)))
+        return CANFD_ERR_FLTR_PARAM;
+
+    psFltr->pu32Hash = pu32Hash;
+    psFltr->u32HashSize = u32HashSize;
+    psFltr->psRange = psRange;
+    psFltr->u32RangeMax = u32RangeMax;
+    psFltr->pu32Work = pu32Work;
+    psFltr->u32WorkSize = u32WorkSize;
+
+    for (i = 0; i < u32HashSize; i++)
+        pu32Hash[i] = CANFD_FLTR_HASH_EMPTY;
+
+    return CANFD_OK;
+}
+
+
+/**
+ * @brief       Compile an acceptance list into filter elements and a software filter.
+ *
+ * @param[in]   psCanfd     The pointer to CAN FD module base address.
+ * @param[in]   psFltr      The filter initialized by CANFD_FltrInit().
+ * @param[in]   eIdType     eCANFD_SID or eCANFD_XID.
+ * @param[in]   psList      IDs and ID ranges to accept, in any order. Sorted and merged in place.
+ * @param[in]   u32Cnt      Number of entries in psList.
+ *
+ * @retval      CANFD_OK              Filter programmed.
+ * @retval      CANFD_ERR_FLTR_WORK   The scratch buffer is too small.
+ * @retval      CANFD_ERR_FLTR_FULL   The IDs left over do not fit into the software filter.
+ *
+ * @details     Overlapping and adjacent entries are merged first. Ranges of three or
+ *              more IDs become range elements, and aligned power-of-two ranges that
+ *              differ only in higher ID bits (e.g. one J1939 PGN from every source
+ *              address at every priority) are folded into one classic element. The
+ *              remaining single IDs are grouped into classic ID/mask elements where a
+ *              full power-of-two cube of them is accepted (found greedily, bit by bit),
+ *              and the rest are paired into dual ID elements. Elements are programmed in
+ *              the order of IDs covered, up to the list size set by CANFD_Open()
+ *              (SIDFC.LSS / XIDFC.LSE), with matching frames stored in CANFD_FLTR_HW_FIFO.
+ *              Elements that do not fit are moved into the software filter and
+ *              non-matching frames of this ID type are then stored in CANFD_FLTR_SW_FIFO
+ *              to be checked by CANFD_FltrCheck(); otherwise they are rejected. The
+ *              filter list of this ID type is owned by the compiler. Must be called
+ *              while the configuration change is enabled (before
+ *              CANFD_RunToNormal()).
+ */
+int32_t CANFD_FltrCompile(CANFD_T *psCanfd, CANFD_FLTR_T *psFltr, E_CANFD_ID_TYPE eIdType, CANFD_ID_RANGE_T *psList, uint32_t u32Cnt)
+{
+    uint32_t u32MaxId = (eIdType == eCANFD_XID) ? 0x1FFFFFFFul : 0x7FFul;
+    uint32_t u32Xtd = (eIdType == eCANFD_XID) ? CANFD_FLTR_XTD : 0;
+    uint32_t *pu32Single = psFltr->pu32Work;
+    CANFD_FLTR_ELEM_T *psElem;
+    CANFD_FLTR_REPORT_T *psReport = &psFltr->asReport[(eIdType == eCANFD_XID) ? 1 : 0];
+    uint32_t u32SramBaseAddr = _GetCanfdSramBaseAddr(psCanfd);
+    uint32_t u32Merged = 0, u32Single = 0, u32Elem = 0, u32ElemMax, u32Ranges, u32Size, u32Cap, u32Addr;
+    uint32_t i, j, u32Id, u32Mask, u32Bit, u32Sub, u32Uncovered;
+    int32_t i32Idx;
+
+    memset(psReport, 0, sizeof(CANFD_FLTR_REPORT_T));
+
+    /* drop invalid entries, sort and merge overlapping or adjacent ranges */
+    for (i = 0; i < u32Cnt; i++)
+    {
+        if ((psList[i].u32IdLow <= psList[i].u32IdHigh) && (psList[i].u32IdLow <= u32MaxId))
+        {
+            psList[u32Merged].u32IdLow = psList[i].u32IdLow;
+            psList[u32Merged].u32IdHigh = (psList[i].u32IdHigh > u32MaxId) ? u32MaxId : psList[i].u32IdHigh;
+            u32Merged++;
+        }
+    }
+
+    CANFD_FltrSortRange(psList, u32Merged);
+
+    for (i = 1, j = 0; i < u32Merged; i++)
+    {
+        if (psList[i].u32IdLow <= psList[j].u32IdHigh + 1)
+        {
+            if (psList[i].u32IdHigh > psList[j].u32IdHigh)
+                psList[j].u32IdHigh = psList[i].u32IdHigh;
+        }
+        else
+        {
+            psList[++j] = psList[i];
+        }
+    }
+
+    u32Merged = (u32Merged == 0) ? 0 : (j + 1);
+
+    /* single IDs (from ranges of one or two IDs) stay sorted */
+    for (i = 0, j = 0; i < u32Merged; i++)
+    {
+        if (psList[i].u32IdHigh - psList[i].u32IdLow < 2)
+            u32Single += psList[i].u32IdHigh - psList[i].u32IdLow + 1;
+        else
+            j++;
+    }
+
+    /* worst case: every range, a classic element seeded by every range and every single ID make an element */
+    u32ElemMax = 2 * j + u32Single;
+
+    if (u32Single + u32ElemMax * (sizeof(CANFD_FLTR_ELEM_T) / 4) > psFltr->u32WorkSize)
+        return CANFD_ERR_FLTR_WORK;
+
+    psElem = (CANFD_FLTR_ELEM_T *)&psFltr->pu32Work[u32Single];
+    u32Single = 0;
+
+    for (i = 0; i < u32Merged; i++)
+    {
+        if (psList[i].u32IdHigh - psList[i].u32IdLow < 2)
+        {
+            for (u32Id = psList[i].u32IdLow; u32Id <= psList[i].u32IdHigh; u32Id++)
+                pu32Single[u32Single++] = u32Id;
+        }
+        else
+        {
+            psElem[u32Elem].u32Id1 = psList[i].u32IdLow;
+            psElem[u32Elem].u32Id2 = psList[i].u32IdHigh;
+            psElem[u32Elem].u32Type = eCANFD_SID_FLTR_TYPE_RANGE;
+            psElem[u32Elem].u32Ids = psList[i].u32IdHigh - psList[i].u32IdLow + 1;
+            u32Elem++;
+        }
+    }
+
+    /* aligned power-of-two ranges that only differ in higher ID bits become one classic element */
+    u32Ranges = u32Elem;
+
+    for (i = 0; i < u32Ranges; i++)
+    {
+        u32Size = psElem[i].u32Id2 - psElem[i].u32Id1 + 1;
+
+        if ((psElem[i].u32Ids == 0) || (u32Size & (u32Size - 1)) || (psElem[i].u32Id1 & (u32Size - 1)))
+            continue;
+
+        u32Id = psElem[i].u32Id1;
+        u32Mask = 0;
+
+        for (u32Bit = u32Size; (u32Bit <= u32MaxId) && (CANFD_FltrBitCount(u32Mask) < CANFD_FLTR_MAX_CUBE_BITS); u32Bit <<= 1)
+        {
+            u32Sub = u32Mask;
+
+            while (1)
+            {
+                if (CANFD_FltrFindBlock(psElem, u32Ranges, ((u32Id & ~u32Mask) | u32Sub) ^ u32Bit, u32Size) < 0)
+                    break;
+
+                if (u32Sub == 0)
+                {
+                    u32Mask |= u32Bit;
+                    break;
+                }
+
+                u32Sub = (u32Sub - 1) & u32Mask;
+            }
+        }
+
+        if (u32Mask == 0) continue;
+
+        /* every range of the cube is replaced, including ones already merged into another cube */
+        u32Uncovered = 0;
+        u32Sub = u32Mask;
+
+        while (1)
+        {
+            i32Idx = CANFD_FltrFindBlock(psElem, u32Ranges, (u32Id & ~u32Mask) | u32Sub, u32Size);
+            u32Uncovered += psElem[i32Idx].u32Ids;
+            psElem[i32Idx].u32Ids = 0;
+
+            if (u32Sub == 0) break;
+
+            u32Sub = (u32Sub - 1) & u32Mask;
+        }
+
+        psElem[u32Elem].u32Id1 = u32Id & ~u32Mask;
+        psElem[u32Elem].u32Id2 = ~(u32Mask | (u32Size - 1)) & u32MaxId;
+        psElem[u32Elem].u32Type = eCANFD_SID_FLTR_TYPE_CLASSIC;
+        psElem[u32Elem].u32Ids = u32Uncovered;
+        u32Elem++;
+    }
+
+    /* grow a cube of accepted single IDs around every uncovered ID, one don't-care bit at a time */
+    for (i = 0; i < u32Single; i++)
+    {
+        if (pu32Single[i] & CANFD_FLTR_XTD) continue;
+
+        u32Id = pu32Single[i];
+        u32Mask = 0;
+
+        for (u32Bit = 1; (u32Bit <= u32MaxId) && (CANFD_FltrBitCount(u32Mask) < CANFD_FLTR_MAX_CUBE_BITS); u32Bit <<= 1)
+        {
+            /* the mirror image of the cube across u32Bit must be accepted too */
+            u32Sub = u32Mask;
+
+            while (1)
+            {
+                if (CANFD_FltrFindSingle(pu32Single, u32Single, ((u32Id & ~u32Mask) | u32Sub) ^ u32Bit) < 0)
+                    break;
+
+                if (u32Sub == 0)
+                {
+                    u32Mask |= u32Bit;
+                    break;
+                }
+
+                u32Sub = (u32Sub - 1) & u32Mask;
+            }
+        }
+
+        /* a classic element pays off over dual elements from three new IDs on */
+        if (CANFD_FltrBitCount(u32Mask) < 2) continue;
+
+        u32Uncovered = 0;
+        u32Sub = u32Mask;
+
+        while (1)
+        {
+            i32Idx = CANFD_FltrFindSingle(pu32Single, u32Single, (u32Id & ~u32Mask) | u32Sub);
+
+            if (!(pu32Single[i32Idx] & CANFD_FLTR_XTD)) u32Uncovered++;
+
+            if (u32Sub == 0) break;
+
+            u32Sub = (u32Sub - 1) & u32Mask;
+        }
+
+        if (u32Uncovered < 3) continue;
+
+        u32Sub = u32Mask;
+
+        while (1)
+        {
+            pu32Single[CANFD_FltrFindSingle(pu32Single, u32Single, (u32Id & ~u32Mask) | u32Sub)] |= CANFD_FLTR_XTD;
+
+            if (u32Sub == 0) break;
+
+            u32Sub = (u32Sub - 1) & u32Mask;
+        }
+
+        psElem[u32Elem].u32Id1 = u32Id & ~u32Mask;
+        psElem[u32Elem].u32Id2 = ~u32Mask & u32MaxId;
+        psElem[u32Elem].u32Type = eCANFD_SID_FLTR_TYPE_CLASSIC;
+        psElem[u32Elem].u32Ids = u32Uncovered;
+        u32Elem++;
+    }
+
+    /* pair the remaining single IDs into dual ID elements */
+    for (i = 0, j = 0xFFFFFFFFul; i < u32Single; i++)
+    {
+        if (pu32Single[i] & CANFD_FLTR_XTD) continue;
+
+        if (j == 0xFFFFFFFFul)
+        {
+            j = pu32Single[i];
+            continue;
+        }
+
+        psElem[u32Elem].u32Id1 = j;
+        psElem[u32Elem].u32Id2 = pu32Single[i];
+        psElem[u32Elem].u32Type = eCANFD_SID_FLTR_TYPE_DUAL;
+        psElem[u32Elem].u32Ids = 2;
+        u32Elem++;
+        j = 0xFFFFFFFFul;
+    }
+
+    if (j != 0xFFFFFFFFul)
+    {
+        psElem[u32Elem].u32Id1 = j;
+        psElem[u32Elem].u32Id2 = j;
+        psElem[u32Elem].u32Type = eCANFD_SID_FLTR_TYPE_DUAL;
+        psElem[u32Elem].u32Ids = 1;
+        u32Elem++;
+    }
+
+    CANFD_FltrSortElem(psElem, u32Elem);
+
+    /* ranges merged into classic elements sort last */
+    while ((u32Elem > 0) && (psElem[u32Elem - 1].u32Ids == 0))
+        u32Elem--;
+
+    /* program the filter list, elements beyond the list size go to the software filter */
+    if (eIdType == eCANFD_XID)
+    {
+        u32Cap = (psCanfd->XIDFC & CANFD_XIDFC_LSE_Msk) >> CANFD_XIDFC_LSE_Pos;
+        u32Addr = u32SramBaseAddr + (psCanfd->XIDFC & CANFD_XIDFC_FLESA_Msk);
+    }
+    else
+    {
+        u32Cap = (psCanfd->SIDFC & CANFD_SIDFC_LSS_Msk) >> CANFD_SIDFC_LSS_Pos;
+        u32Addr = u32SramBaseAddr + (psCanfd->SIDFC & CANFD_SIDFC_FLSSA_Msk);
+    }
+
+    for (i = 0; i < u32Cap; i++)
+    {
+        if (i >= u32Elem)
+        {
+            /* disable the unused elements */
+            if (eIdType == eCANFD_XID)
+            {
+                outpw(u32Addr + i * 8, 0);
+                outpw(u32Addr + i * 8 + 4, 0);
+            }
+            else
+            {
+                outpw(u32Addr + i * 4, 0);
+            }
+
+            continue;
+        }
+
+        if (eIdType == eCANFD_XID)
+        {
+            outpw(u32Addr + i * 8, ((uint32_t)eCANFD_FLTR_ELEM_STO_FIFO0 << 29) | psElem[i].u32Id1);
+            outpw(u32Addr + i * 8 + 4, (psElem[i].u32Type << 30) | psElem[i].u32Id2);
+        }
+        else
+        {
+            outpw(u32Addr + i * 4, (psElem[i].u32Type << 30) | ((uint32_t)eCANFD_FLTR_ELEM_STO_FIFO0 << 27) |
+                  (psElem[i].u32Id1 << 16) | psElem[i].u32Id2);
+        }
+
+        if (psElem[i].u32Type == eCANFD_SID_FLTR_TYPE_RANGE)
+            psReport->u32RangeElems++;
+        else if (psElem[i].u32Type == eCANFD_SID_FLTR_TYPE_CLASSIC)
+            psReport->u32MaskElems++;
+        else
+            psReport->u32DualElems++;
+
+        psReport->u32HwIds += psElem[i].u32Ids;
+    }
+
+    for (; i < u32Elem; i++)
+    {
+        if (CANFD_FltrAddSw(psFltr, &psElem[i], u32Xtd) != CANFD_OK)
+            return CANFD_ERR_FLTR_FULL;
+
+        psReport->u32SwIds += psElem[i].u32Ids;
+    }
+
+    CANFD_FltrSortRange(psFltr->psRange, psFltr->u32RangeCnt);
+
+    /* non-matching frames: software filter FIFO when needed, otherwise reject */
+    if (eIdType == eCANFD_XID)
+        psCanfd->GFC = (psCanfd->GFC & ~CANFD_GFC_ANFE_Msk) |
+                       ((psReport->u32SwIds ? eCANFD_ACC_NON_MATCH_FRM_RX_FIFO1 : eCANFD_REJ_NON_MATCH_FRM) << CANFD_GFC_ANFE_Pos);
+    else
+        psCanfd->GFC = (psCanfd->GFC & ~CANFD_GFC_ANFS_Msk) |
+                       ((psReport->u32SwIds ? eCANFD_ACC_NON_MATCH_FRM_RX_FIFO1 : eCANFD_REJ_NON_MATCH_FRM) << CANFD_GFC_ANFS_Pos);
+
+    return CANFD_OK;
+}
+
+
+/**
+ * @brief       Account a received frame and apply the software filter to it.
+ *
+ * @param[in]   psFltr      The compiled filter.
+ * @param[in]   u32FifoIdx  Rx FIFO the frame was read from.
+ * @param[in]   psMsg       The received frame.
+ *
+ * @return      1 if the frame is accepted, 0 if it has to be discarded.
+ *
+ * @details     Frames from CANFD_FLTR_HW_FIFO were accepted by a filter element and
+ *              are only counted. Frames from CANFD_FLTR_SW_FIFO are looked up in the
+ *              software hash set and range list.
+ */
+uint32_t CANFD_FltrCheck(CANFD_FLTR_T *psFltr, uint32_t u32FifoIdx, CANFD_FD_MSG_T *psMsg)
+{
+    uint32_t u32Key = psMsg->u32Id | ((psMsg->eIdType == eCANFD_XID) ? CANFD_FLTR_XTD : 0);
+    uint32_t u32Idx, u32Lo, u32Hi, u32Mid;
+
+    if (u32FifoIdx != CANFD_FLTR_SW_FIFO)
+    {
+        psFltr->u32HwAccepted++;
+        return 1;
+    }
+
+    if (psFltr->u32HashCnt)
+    {
+        u32Idx = CANFD_FltrHashIdx(u32Key, psFltr->u32HashSize);
+
+        while (psFltr->pu32Hash[u32Idx] != CANFD_FLTR_HASH_EMPTY)
+        {
+            if (psFltr->pu32Hash[u32Idx] == u32Key)
+            {
+                psFltr->u32SwAccepted++;
+                return 1;
+            }
+
+            u32Idx = (u32Idx + 1) & (psFltr->u32HashSize - 1);
+        }
+    }
+
+    /* last range starting at or below the key */
+    u32Lo = 0;
+    u32Hi = psFltr->u32RangeCnt;
+
+    while (u32Lo < u32Hi)
+    {
+        u32Mid = (u32Lo + u32Hi) / 2;
+
+        if (psFltr->psRange[u32Mid].u32IdLow <= u32Key)
+            u32Lo = u32Mid + 1;
+        else
+            u32Hi = u32Mid;
+    }
+
+    if ((u32Lo > 0) && (u32Key <= psFltr->psRange[u32Lo - 1].u32IdHigh))
+    {
+        psFltr->u32SwAccepted++;
+        return 1;
+    }
+
+    psFltr->u32SwRejected++;
+    return 0;
+}
+
+
 
 /*@}*/ /* end of group CANFD_EXPORTED_FUNCTIONS */
 
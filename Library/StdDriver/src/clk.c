@@ -7,6 +7,7 @@
  * @copyright Copyright (C) 2021 Nuvoton Technology Corp. All rights reserved.
  *****************************************************************************/
 
+#include <string.h>
 #include "NuMicro.h"
 
 /** @addtogroup Standard_Driver Standard Driver
@@ -1785,6 +1786,468 @@ uint32_t CLK_GetPLLFNClockFreq(void)
 }
 
 
+/* First estimates of the idle mode costs, microseconds, with HCLK from PLL at 200 MHz */
+static const CLK_IDLE_MODE_T s_asIdleModeDefault[CLK_IDLE_MODE_CNT] =
+{
+    {   1UL,   1UL,    0UL },       /* Idle: WFI only */
+    {   5UL,  15UL,   30UL },       /* FWPD: HIRC kept ready */
+    {  10UL,  60UL,  200UL },       /* PD: HXT and PLL restart */
+    {  20UL, 250UL, 20000UL },      /* LLPD: regulator back to normal mode as well */
+};
+
+/* Power-down mode of each idle mode */
+static const uint32_t s_au32IdlePDMode[CLK_IDLE_MODE_CNT] =
+{
+    0UL, CLK_PMUCTL_PDMSEL_FWPD, CLK_PMUCTL_PDMSEL_PD, CLK_PMUCTL_PDMSEL_LLPD
+};
+
+static uint32_t CLK_IdleUsToTicks(CLK_IDLE_T *psIdle, uint32_t u32Us)
+{
+    return (uint32_t)(((uint64_t)u32Us * psIdle->u32TimerClk) / 1000000UL);
+}
+
+static uint32_t CLK_IdleTicksToUs(CLK_IDLE_T *psIdle, uint32_t u32Ticks)
+{
+    return (uint32_t)(((uint64_t)u32Ticks * 1000000UL) / psIdle->u32TimerClk);
+}
+
+/* Extend the 24-bit counter into the time of the idle manager */
+static void CLK_IdleCount(CLK_IDLE_T *psIdle, uint32_t u32Cnt)
+{
+    psIdle->u64Clocks += (u32Cnt - psIdle->u32LastCnt) & TIMER_CNT_CNT_Msk;
+    psIdle->u32LastCnt = u32Cnt;
+}
+
+/**
+  * @brief      Initialize the tickless idle manager
+  * @param[out] psIdle      The idle manager
+  * @param[in]  psTimer     Wake-up timer. It could be TIMER0, TIMER1, TIMER2, TIMER3.
+  * @param[in]  u32TimerClk Clock of the timer in Hz, from LXT or LIRC to wake the chip from power-down.
+  * @return     None
+  * @details    This function starts the timer counting freely in continuous mode with wake-up enabled,
+  *             loads the default costs of the idle modes and allows all of them.
+  *             The timer clock must be enabled and selected before, and the timer interrupt enabled in NVIC.
+  */
+void CLK_IdleInit(CLK_IDLE_T *psIdle, TIMER_T *psTimer, uint32_t u32TimerClk)
+{
+    memset(psIdle, 0, sizeof(CLK_IDLE_T));
+    memcpy(psIdle->asMode, s_asIdleModeDefault, sizeof(s_asIdleModeDefault));
+    psIdle->psTimer = psTimer;
+    psIdle->u32TimerClk = u32TimerClk;
+    psIdle->u32MaxMode = CLK_IDLE_LLPD;
+
+    psTimer->CTL = 0UL;
+    psTimer->CMP = TIMER_CNT_CNT_Msk;
+    psTimer->INTSTS = TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk;
+    psTimer->CTL = TIMER_CONTINUOUS_MODE | TIMER_CTL_WKEN_Msk | TIMER_CTL_CNTEN_Msk;
+    psIdle->u32LastCnt = psTimer->CNT & TIMER_CNT_CNT_Msk;
+}
+
+/**
+  * @brief      Set the costs of an idle mode
+  * @param[in]  psIdle      The idle manager
+  * @param[in]  u32Mode     \ref CLK_IDLE_SLEEP, \ref CLK_IDLE_FWPD, \ref CLK_IDLE_PD or \ref CLK_IDLE_LLPD
+  * @param[in]  u32Entry    Entry latency, microseconds
+  * @param[in]  u32Exit     Exit latency, microseconds
+  * @param[in]  u32MinStay  Shortest stay worth entering the mode for, microseconds
+  * @return     None
+  * @details    Costs measured on the board replace the defaults, which suit HCLK from PLL.
+  */
+void CLK_IdleSetMode(CLK_IDLE_T *psIdle, uint32_t u32Mode, uint32_t u32Entry, uint32_t u32Exit, uint32_t u32MinStay)
+{
+    if(u32Mode < CLK_IDLE_MODE_CNT)
+    {
+        psIdle->asMode[u32Mode].u32Entry = u32Entry;
+        psIdle->asMode[u32Mode].u32Exit = u32Exit;
+        psIdle->asMode[u32Mode].u32MinStay = u32MinStay;
+    }
+}
+
+/**
+  * @brief      Limit the depth of the idle modes
+  * @param[in]  psIdle      The idle manager
+  * @param[in]  u32Mode     Deepest mode allowed, \ref CLK_IDLE_SLEEP to \ref CLK_IDLE_LLPD
+  * @return     None
+  * @details    A driver that needs its clock while idle, e.g. a UART receiving from HXT,
+  *             holds the chip in \ref CLK_IDLE_SLEEP until it is done.
+  */
+void CLK_IdleSetMaxMode(CLK_IDLE_T *psIdle, uint32_t u32Mode)
+{
+    psIdle->u32MaxMode = (u32Mode < CLK_IDLE_MODE_CNT) ? u32Mode : CLK_IDLE_LLPD;
+}
+
+/**
+  * @brief      Select the idle mode for a window
+  * @param[in]  psIdle      The idle manager
+  * @param[in]  u32WindowUs Microseconds until the next deadline
+  * @return     The deepest mode whose entry, exit and shortest stay fit the window, or \ref CLK_IDLE_NONE
+  * @details    The limit of CLK_IdleSetMaxMode() is not applied.
+  */
+uint32_t CLK_IdleSelect(CLK_IDLE_T *psIdle, uint32_t u32WindowUs)
+{
+    const CLK_IDLE_MODE_T *psMode;
+    uint32_t u32Mode = CLK_IDLE_MODE_CNT;
+
+    while(u32Mode-- > 0UL)
+    {
+        psMode = &psIdle->asMode[u32Mode];
+        if((uint64_t)psMode->u32Entry + psMode->u32Exit + psMode->u32MinStay <= u32WindowUs)
+        {
+            return u32Mode;
+        }
+    }
+
+    return CLK_IDLE_NONE;
+}
+
+/**
+  * @brief      Sleep until the next deadline or interrupt
+  * @param[in]  psIdle      The idle manager
+  * @param[in]  u32WindowUs Microseconds until the next deadline
+  * @return     Microseconds that passed, within a timer clock, 0 when the window is too short to sleep
+  * @details    This function enters the deepest mode allowed for the window, with the timer set to
+  *             end the period one exit latency before the deadline, and returns after the wake-up,
+  *             once the interrupt that caused it has been handled. Interrupts are disabled from the
+  *             timer setting to the WFI, so an event in between ends the period at once.
+  *             A tick count should follow CLK_IdleGetTime() rather than add up the return values:
+  *             the period starts between two timer clocks, so each one is off by up to a clock.
+  *             The register write-protection function should be disabled before using this function.
+  */
+uint32_t CLK_IdleEnter(CLK_IDLE_T *psIdle, uint32_t u32WindowUs)
+{
+    TIMER_T *psTimer = psIdle->psTimer;
+    CLK_IDLE_STAT_T *psStat = &psIdle->sStat;
+    uint32_t u32Mode, u32Exit, u32Ticks, u32Start, u32Cmp, u32End, u32Us, u32Late;
+
+    u32Mode = CLK_IdleSelect(psIdle, u32WindowUs);
+    if(u32Mode == CLK_IDLE_NONE)
+    {
+        psStat->u32Short++;
+        return 0UL;
+    }
+    if(u32Mode > psIdle->u32MaxMode)
+    {
+        u32Mode = psIdle->u32MaxMode;
+        psStat->u32Vetoed++;
+    }
+
+    /* Be running again at the deadline */
+    u32Exit = psIdle->asMode[u32Mode].u32Exit;
+    u32Ticks = (u32WindowUs > u32Exit) ? CLK_IdleUsToTicks(psIdle, u32WindowUs - u32Exit) : 0UL;
+    if(u32Ticks < 2UL)
+    {
+        psStat->u32Short++;
+        return 0UL;
+    }
+    if(u32Ticks > CLK_IDLE_MAX_TICKS)
+    {
+        u32Ticks = CLK_IDLE_MAX_TICKS;
+    }
+
+    __disable_irq();
+
+    psIdle->u32Woken = 0UL;
+    u32Start = psTimer->CNT & TIMER_CNT_CNT_Msk;
+    u32Cmp = (u32Start + u32Ticks) & TIMER_CNT_CNT_Msk;
+    if(u32Cmp < 2UL)
+    {
+        u32Cmp = 2UL;                                   /* CMP 0 and 1 are not allowed */
+    }
+    psTimer->CMP = u32Cmp;
+    psTimer->INTSTS = TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk;
+    psTimer->CTL |= TIMER_CTL_INTEN_Msk;
+
+    if(u32Mode == CLK_IDLE_SLEEP)
+    {
+        CLK_Idle();
+    }
+    else
+    {
+        CLK_SetPowerDownMode(s_au32IdlePDMode[u32Mode]);
+        CLK_PowerDown();
+    }
+
+    /* The interrupt that woke the chip is handled here */
+    __enable_irq();
+
+    u32End = psTimer->CNT & TIMER_CNT_CNT_Msk;
+    psTimer->CTL &= ~TIMER_CTL_INTEN_Msk;
+    CLK_IdleCount(psIdle, u32End);
+
+    u32Us = CLK_IdleTicksToUs(psIdle, (u32End - u32Start) & TIMER_CNT_CNT_Msk);
+    psStat->au32Entries[u32Mode]++;
+    psStat->au64Time[u32Mode] += u32Us;
+
+    if(!psIdle->u32Woken)
+    {
+        psStat->u32Early++;
+    }
+    else
+    {
+        /* The timer woke the chip at the match: whole clocks since then were spent leaving the mode */
+        u32Ticks = (u32End - u32Cmp) & TIMER_CNT_CNT_Msk;
+        u32Late = CLK_IdleTicksToUs(psIdle, u32Ticks);
+        if(u32Late > u32Exit)
+        {
+            psStat->u32Late++;
+            if(u32Late - u32Exit > psStat->u32MaxLate)
+            {
+                psStat->u32MaxLate = u32Late - u32Exit;
+            }
+            psIdle->asMode[u32Mode].u32Exit = CLK_IdleTicksToUs(psIdle, u32Ticks + 1UL);
+        }
+    }
+
+    return u32Us;
+}
+
+/**
+  * @brief      Read the time of the idle manager
+  * @param[in]  psIdle      The idle manager
+  * @return     Microseconds since CLK_IdleInit()
+  * @details    The time counts in power-down as well. It must be read at least once every
+  *             0x1000000 timer clocks, 512 seconds from LXT; CLK_IdleEnter() reads the timer
+  *             at each period.
+  */
+uint64_t CLK_IdleGetTime(CLK_IDLE_T *psIdle)
+{
+    CLK_IdleCount(psIdle, psIdle->psTimer->CNT & TIMER_CNT_CNT_Msk);
+
+    return (psIdle->u64Clocks * 1000000UL) / psIdle->u32TimerClk;
+}
+
+/**
+  * @brief      Timer interrupt of the idle manager
+  * @param[in]  psIdle      The idle manager
+  * @return     None
+  * @details    Call it from the IRQ handler of the wake-up timer.
+  */
+void CLK_IdleIRQHandler(CLK_IDLE_T *psIdle)
+{
+    TIMER_T *psTimer = psIdle->psTimer;
+
+    psTimer->INTSTS = TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk;
+    psTimer->CTL &= ~TIMER_CTL_INTEN_Msk;
+    psIdle->u32Woken = 1UL;
+}
+
+/**
+  * @brief      Initialize the frequency governor
+  * @param[out] psGov       The governor
+  * @param[in]  psLevel     Performance levels, in rising HCLK order, each from 50 MHz to 200 MHz
+  * @param[in]  u32Levels   Number of levels, 1 to \ref CLK_GOV_MAX_LEVELS
+  * @retval     CLK_GOV_OK         The top level is set
+  * @retval     CLK_GOV_ERR_PARAM  Invalid level table
+  * @details    This function sets HCLK to the top level and the default policy: the top level at
+  *             80% load, lower levels kept under 70% load, stepping down after 3 periods.
+  *             Drivers whose clock derives from HCLK or PLL register with CLK_GovRegister() after it.
+  *             The register write-protection function should be disabled before using this function.
+  */
+int32_t CLK_GovInit(CLK_GOV_T *psGov, const CLK_GOV_LEVEL_T *psLevel, uint32_t u32Levels)
+{
+    uint32_t i;
+
+    if((u32Levels == 0UL) || (u32Levels > CLK_GOV_MAX_LEVELS))
+    {
+        return CLK_GOV_ERR_PARAM;
+    }
+    for(i = 0UL; i < u32Levels; i++)
+    {
+        if((psLevel[i].u32Hclk < FREQ_50MHZ) || (psLevel[i].u32Hclk > FREQ_200MHZ) ||
+                ((i > 0UL) && (psLevel[i].u32Hclk <= psLevel[i - 1UL].u32Hclk)))
+        {
+            return CLK_GOV_ERR_PARAM;
+        }
+    }
+
+    memset(psGov, 0, sizeof(CLK_GOV_T));
+    memcpy(psGov->asLevel, psLevel, u32Levels * sizeof(CLK_GOV_LEVEL_T));
+    psGov->u32Levels = u32Levels;
+    psGov->u32UpLoad = 80UL;
+    psGov->u32Target = 70UL;
+    psGov->u32DownDelay = 3UL;
+
+    psGov->u32Level = u32Levels - 1UL;
+    psGov->u32Hclk = CLK_SetCoreClock(psLevel[u32Levels - 1UL].u32Hclk);
+
+    return CLK_GOV_OK;
+}
+
+/**
+  * @brief      Register a driver to notify of the level changes
+  * @param[in]  psGov       The governor
+  * @param[in]  pfnNotify   Called before and after each change, with interrupts disabled
+  * @param[in]  pvPriv      Passed to pfnNotify
+  * @retval     CLK_GOV_OK         Registered
+  * @retval     CLK_GOV_ERR_PARAM  pfnNotify is NULL
+  * @retval     CLK_GOV_ERR_FULL   \ref CLK_GOV_MAX_CLIENTS are registered already
+  * @details    Drivers are notified in the order they registered. On \ref CLK_GOV_PRE_CHANGE a
+  *             driver waits for its transfer in progress, e.g. UART_WAIT_TX_EMPTY(); on
+  *             \ref CLK_GOV_POST_CHANGE it derives its dividers from the new clocks, e.g. with
+  *             UART_SetLineConfig(), SPI_SetBusClock(), I2S_EnableMCLK() or TIMER_Open().
+  */
+int32_t CLK_GovRegister(CLK_GOV_T *psGov, CLK_GOV_NOTIFY_T pfnNotify, void *pvPriv)
+{
+    if(pfnNotify == NULL)
+    {
+        return CLK_GOV_ERR_PARAM;
+    }
+    if(psGov->u32Clients >= CLK_GOV_MAX_CLIENTS)
+    {
+        return CLK_GOV_ERR_FULL;
+    }
+
+    psGov->asClient[psGov->u32Clients].pfnNotify = pfnNotify;
+    psGov->asClient[psGov->u32Clients].pvPriv = pvPriv;
+    psGov->u32Clients++;
+
+    return CLK_GOV_OK;
+}
+
+/**
+  * @brief      Set the policy of the governor
+  * @param[in]  psGov         The governor
+  * @param[in]  u32UpLoad     Load, percent, at or above which the top level is taken
+  * @param[in]  u32Target     Load, percent, the work must stay under at a lower level
+  * @param[in]  u32DownDelay  Periods a lower level must be enough for before stepping down
+  * @return     None
+  * @details    A target close to 100% saves more and leaves less margin for a growing load:
+  *             a period over the up threshold at a lower level runs late by the missing cycles.
+  */
+void CLK_GovSetPolicy(CLK_GOV_T *psGov, uint32_t u32UpLoad, uint32_t u32Target, uint32_t u32DownDelay)
+{
+    psGov->u32UpLoad = (u32UpLoad > 100UL) ? 100UL : u32UpLoad;
+    psGov->u32Target = (u32Target > psGov->u32UpLoad) ? psGov->u32UpLoad : u32Target;
+    psGov->u32DownDelay = u32DownDelay;
+}
+
+/**
+  * @brief      Change the performance level
+  * @param[in]  psGov       The governor
+  * @param[in]  u32Level    New level; a level past the table selects the top one
+  * @return     HCLK set, Hz
+  * @details    With interrupts disabled, this function notifies the registered drivers of
+  *             \ref CLK_GOV_PRE_CHANGE, sets HCLK with CLK_SetCoreClock() and notifies them of
+  *             \ref CLK_GOV_POST_CHANGE. Interrupts stay disabled while the PLL locks.
+  *             The register write-protection function should be disabled before using this function.
+  */
+uint32_t CLK_GovSetLevel(CLK_GOV_T *psGov, uint32_t u32Level)
+{
+    uint32_t i, u32PriMask, u32Hclk;
+
+    if(u32Level >= psGov->u32Levels)
+    {
+        u32Level = psGov->u32Levels - 1UL;
+    }
+    if(u32Level == psGov->u32Level)
+    {
+        return psGov->u32Hclk;
+    }
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    for(i = 0UL; i < psGov->u32Clients; i++)
+    {
+        psGov->asClient[i].pfnNotify(psGov->asClient[i].pvPriv, CLK_GOV_PRE_CHANGE, psGov->asLevel[u32Level].u32Hclk);
+    }
+
+    u32Hclk = CLK_SetCoreClock(psGov->asLevel[u32Level].u32Hclk);
+    psGov->u32Level = u32Level;
+    psGov->u32Hclk = u32Hclk;
+
+    for(i = 0UL; i < psGov->u32Clients; i++)
+    {
+        psGov->asClient[i].pfnNotify(psGov->asClient[i].pvPriv, CLK_GOV_POST_CHANGE, u32Hclk);
+    }
+
+    __set_PRIMASK(u32PriMask);
+
+    psGov->sStat.u32Switches++;
+
+    return u32Hclk;
+}
+
+/**
+  * @brief      Account a period and choose the level of the next one
+  * @param[in]  psGov       The governor
+  * @param[in]  u32BusyUs   Microseconds the CPU was running in the period
+  * @param[in]  u32PeriodUs Length of the period, microseconds
+  * @return     Level for the next period, already set
+  * @details    The period is charged at the current level: running for the busy time and idle
+  *             for the rest. The cycles the work took, busy time by HCLK, decide the next level.
+  *             The length of the period should stay well above the time of a change, which
+  *             includes the PLL lock time.
+  */
+uint32_t CLK_GovUpdate(CLK_GOV_T *psGov, uint32_t u32BusyUs, uint32_t u32PeriodUs)
+{
+    CLK_GOV_STAT_T *psStat = &psGov->sStat;
+    const CLK_GOV_LEVEL_T *psLevel = &psGov->asLevel[psGov->u32Level];
+    uint32_t u32Top = psGov->u32Levels - 1UL;
+    uint32_t u32Level;
+    uint64_t u64Cycles;
+
+    if(u32PeriodUs == 0UL)
+    {
+        return psGov->u32Level;
+    }
+    if(u32BusyUs > u32PeriodUs)
+    {
+        u32BusyUs = u32PeriodUs;
+    }
+
+    psStat->au64Time[psGov->u32Level] += u32PeriodUs;
+    psStat->au64Busy[psGov->u32Level] += u32BusyUs;
+    psStat->au64Charge[psGov->u32Level] += (uint64_t)u32BusyUs * psLevel->u32RunCurrent +
+                                           (uint64_t)(u32PeriodUs - u32BusyUs) * psLevel->u32IdleCurrent;
+    if((psGov->u32Level == u32Top) && (u32BusyUs == u32PeriodUs))
+    {
+        psStat->u32Saturated++;
+    }
+
+    if((uint64_t)u32BusyUs * 100UL >= (uint64_t)psGov->u32UpLoad * u32PeriodUs)
+    {
+        u32Level = u32Top;
+        psGov->u32DownCnt = 0UL;
+    }
+    else
+    {
+        /* The lowest level that runs the same cycles under the target load, HCLK in kHz */
+        u64Cycles = (uint64_t)u32BusyUs * (psGov->u32Hclk / 1000UL) * 100UL;
+        for(u32Level = 0UL; u32Level < u32Top; u32Level++)
+        {
+            if(u64Cycles <= (uint64_t)psGov->u32Target * u32PeriodUs * (psGov->asLevel[u32Level].u32Hclk / 1000UL))
+            {
+                break;
+            }
+        }
+
+        if(u32Level < psGov->u32Level)
+        {
+            /* Step down once the lower level has been enough for the delay */
+            if(++psGov->u32DownCnt < psGov->u32DownDelay)
+            {
+                u32Level = psGov->u32Level;
+            }
+            else
+            {
+                psGov->u32DownCnt = 0UL;
+            }
+        }
+        else
+        {
+            psGov->u32DownCnt = 0UL;
+        }
+    }
+
+    if(u32Level != psGov->u32Level)
+    {
+        CLK_GovSetLevel(psGov, u32Level);
+    }
+
+    return psGov->u32Level;
+}
+
 /*@}*/ /* end of group CLK_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group CLK_Driver */
@@ -0,0 +1,455 @@
+/**************************************************************************//**
+ * @file     dlog.c
+ * @version  V1.00
+ * @brief    Deferred binary log driver source file
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup DLOG_Driver DLOG Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+#define DLOG_HDR(u32Type, u32Len, u32Words) \
+    (((u32Type) << DLOG_HDR_TYPE_Pos) | ((u32Len) << DLOG_HDR_LEN_Pos) | ((u32Words) << DLOG_HDR_WORDS_Pos))
+
+#define DLOG_REC_MAX_WORDS      (2UL + (DLOG_TEXT_MAX / 4UL))
+
+/*
+    A ring of words with one record after another; a record may run over the end of the buffer.
+    Writers of every priority reserve their words by moving s_u32Head with LDREX/STREX, fill them,
+    and store the header word last. The drain, the only reader, stops at a header still zero:
+    that record is reserved but not complete, and is sent at the next drain. It zeroes the words
+    it has sent before giving them back by moving s_u32Tail.
+*/
+static uint32_t *s_pu32Ring;
+static uint32_t s_u32Size;
+static volatile uint32_t s_u32Head;     /* Words reserved since DLOG_Init() */
+static volatile uint32_t s_u32Tail;     /* Words drained since DLOG_Init() */
+static volatile uint32_t s_u32Dropped;
+static volatile uint32_t s_u32MaxUsed;
+static uint32_t s_u32Drained;
+static volatile uint32_t s_u32DropAt;  /* s_u32Head at the last refused record */
+static uint32_t s_u32DropSent;          /* s_u32Dropped at the last DROP record */
+static uint32_t s_u32Seq;
+
+/*
+    Characters of DLOG_PutChar() gather into a line per context, one for thread mode and one for
+    handler mode, changed with interrupts masked. The handler line belongs to the exception that
+    wrote it; another exception records what is there before starting its own, so lines of
+    nested handlers are cut short rather than interleaved.
+*/
+typedef struct
+{
+    uint32_t u32Owner;                  /* IPSR of the writer */
+    uint32_t u32Len;
+    char acText[DLOG_TEXT_MAX];
+} DLOG_LINE_T;
+
+static DLOG_LINE_T s_asLine[2];         /* Thread mode, handler mode */
+
+static void DLOG_Drop(void)
+{
+    uint32_t u32Dropped;
+
+    do
+    {
+        u32Dropped = __LDREXW(&s_u32Dropped);
+    }
+    while(__STREXW(u32Dropped + 1UL, &s_u32Dropped) != 0UL);
+}
+
+/* Reserve u32Words words: returns the first one and its timestamp, or 0xFFFFFFFF with the ring full */
+static uint32_t DLOG_Reserve(uint32_t u32Words, uint32_t *pu32Time)
+{
+    uint32_t u32Head, u32Used;
+
+    do
+    {
+        u32Head = __LDREXW(&s_u32Head);
+        u32Used = u32Head + u32Words - s_u32Tail;
+
+        if(u32Used > s_u32Size)
+        {
+            __CLREX();
+            s_u32DropAt = u32Head;
+            DLOG_Drop();
+            return 0xFFFFFFFFUL;
+        }
+
+        *pu32Time = DLOG_TIMESTAMP();
+    }
+    while(__STREXW(u32Head + u32Words, &s_u32Head) != 0UL);
+
+    /* A preempted update may lower it again; the figure is for sizing the ring */
+    if(u32Used > s_u32MaxUsed)
+        s_u32MaxUsed = u32Used;
+
+    return u32Head;
+}
+
+static void DLOG_Commit(uint32_t u32Head, uint32_t u32Hdr)
+{
+    __DMB();
+    s_pu32Ring[u32Head & (s_u32Size - 1UL)] = u32Hdr;
+}
+
+static void DLOG_Put(uint32_t u32Head, uint32_t u32Word, uint32_t u32Value)
+{
+    s_pu32Ring[(u32Head + u32Word) & (s_u32Size - 1UL)] = u32Value;
+}
+
+static void DLOG_TextRec(const char *pcText, uint32_t u32Len)
+{
+    uint32_t u32Head, u32Time, u32Words = 2UL + ((u32Len + 3UL) / 4UL), u32Value, i;
+
+    if((s_pu32Ring == NULL) || ((u32Head = DLOG_Reserve(u32Words, &u32Time)) == 0xFFFFFFFFUL))
+        return;
+
+    DLOG_Put(u32Head, 1UL, u32Time);
+    for(i = 0UL; i < u32Len; i += 4UL)
+    {
+        u32Value = 0UL;
+        memcpy(&u32Value, &pcText[i], ((u32Len - i) < 4UL) ? (u32Len - i) : 4UL);
+        DLOG_Put(u32Head, 2UL + (i / 4UL), u32Value);
+    }
+    DLOG_Commit(u32Head, DLOG_HDR(DLOG_TYPE_TEXT, u32Len, u32Words));
+}
+
+/* Record a line of DLOG_PutChar(), interrupts masked */
+static void DLOG_LineOut(DLOG_LINE_T *psLine)
+{
+    DLOG_TextRec(psLine->acText, psLine->u32Len);
+    psLine->u32Len = 0UL;
+}
+
+/* Record the lines still open, for the drain not to hold back text without its '\n' */
+static void DLOG_LinesOut(void)
+{
+    uint32_t u32PriMask, i;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    for(i = 0UL; i < 2UL; i++)
+    {
+        if(s_asLine[i].u32Len != 0UL)
+            DLOG_LineOut(&s_asLine[i]);
+    }
+
+    __set_PRIMASK(u32PriMask);
+}
+
+/* One frame into pu8Frame: sync byte and the words, header with its sequence number */
+static uint32_t DLOG_Frame(uint8_t *pu8Frame, const uint32_t *pu32Rec, uint32_t u32Words)
+{
+    uint32_t u32Hdr = (pu32Rec[0] & ~DLOG_HDR_SEQ_Msk) | ((s_u32Seq++ << DLOG_HDR_SEQ_Pos) & DLOG_HDR_SEQ_Msk);
+    uint32_t i;
+
+    pu8Frame[0] = (uint8_t)DLOG_SYNC;
+    for(i = 0UL; i < u32Words; i++)
+    {
+        uint32_t u32Value = (i == 0UL) ? u32Hdr : pu32Rec[i];
+
+        /* Little endian on the wire, whatever the host */
+        pu8Frame[1UL + i * 4UL] = (uint8_t)u32Value;
+        pu8Frame[2UL + i * 4UL] = (uint8_t)(u32Value >> 8);
+        pu8Frame[3UL + i * 4UL] = (uint8_t)(u32Value >> 16);
+        pu8Frame[4UL + i * 4UL] = (uint8_t)(u32Value >> 24);
+    }
+    s_u32Drained++;
+
+    return 1UL + u32Words * 4UL;
+}
+
+/*
+    Next record of the ring, or the DROP record owed, copied to pu32Rec without releasing it.
+    The DROP record follows the records reserved before the last refusal.
+    Returns its words, 0 if there is none complete.
+*/
+static uint32_t DLOG_Peek(uint32_t *pu32Rec, uint32_t *pu32IsDrop)
+{
+    uint32_t u32Tail = s_u32Tail, u32Dropped = s_u32Dropped, u32Words, i;
+
+    *pu32IsDrop = (u32Dropped != s_u32DropSent) && ((int32_t)(u32Tail - s_u32DropAt) >= 0);
+    if(*pu32IsDrop)
+    {
+        pu32Rec[0] = DLOG_HDR(DLOG_TYPE_DROP, 0UL, 3UL);
+        pu32Rec[1] = DLOG_TIMESTAMP();
+        pu32Rec[2] = u32Dropped - s_u32DropSent;
+        return 3UL;
+    }
+
+    if(u32Tail == s_u32Head)
+        return 0UL;
+
+    pu32Rec[0] = s_pu32Ring[u32Tail & (s_u32Size - 1UL)];
+    if(pu32Rec[0] == 0UL)
+        return 0UL;
+
+    /* The header is read first: the words it covers are complete */
+    __DMB();
+    u32Words = (pu32Rec[0] & DLOG_HDR_WORDS_Msk) >> DLOG_HDR_WORDS_Pos;
+    for(i = 1UL; i < u32Words; i++)
+        pu32Rec[i] = s_pu32Ring[(u32Tail + i) & (s_u32Size - 1UL)];
+
+    return u32Words;
+}
+
+static void DLOG_Release(uint32_t u32Words, uint32_t u32IsDrop, const uint32_t *pu32Rec)
+{
+    uint32_t u32Tail = s_u32Tail, i;
+
+    if(u32IsDrop)
+    {
+        s_u32DropSent += pu32Rec[2];
+        return;
+    }
+
+    for(i = 0UL; i < u32Words; i++)
+        s_pu32Ring[(u32Tail + i) & (s_u32Size - 1UL)] = 0UL;
+
+    __DMB();
+    s_u32Tail = u32Tail + u32Words;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup DLOG_EXPORTED_FUNCTIONS DLOG Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Set up the log ring
+  *
+  * @param[in]  pu32Ring    Ring buffer.
+  * @param[in]  u32Words    Words of pu32Ring, a power of two, at least \ref DLOG_MIN_WORDS.
+  *
+  * @retval     DLOG_OK             Ring ready, holding the INFO record.
+  * @retval     DLOG_ERR_PARAM      Invalid buffer or size.
+  *
+  * @details    Enables the DWT cycle counter unless DLOG_TIMESTAMP() is defined by the project.
+  *             Call before any DLOG(); until then, messages are dropped without being counted.
+  */
+int32_t DLOG_Init(uint32_t *pu32Ring, uint32_t u32Words)
+{
+    uint32_t u32Head, u32Time;
+
+    if((pu32Ring == NULL) || (u32Words < DLOG_MIN_WORDS) || ((u32Words & (u32Words - 1UL)) != 0UL))
+        return DLOG_ERR_PARAM;
+
+    s_pu32Ring = NULL;
+    memset(pu32Ring, 0, u32Words * sizeof(uint32_t));
+    s_u32Size = u32Words;
+    s_u32Head = 0UL;
+    s_u32Tail = 0UL;
+    s_u32Dropped = 0UL;
+    s_u32DropAt = 0UL;
+    s_u32MaxUsed = 0UL;
+    s_u32Drained = 0UL;
+    s_u32DropSent = 0UL;
+    s_u32Seq = 0UL;
+    memset(s_asLine, 0, sizeof(s_asLine));
+
+#ifdef DLOG_TIMESTAMP_DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    s_pu32Ring = pu32Ring;
+
+    u32Head = DLOG_Reserve(4UL, &u32Time);
+    DLOG_Put(u32Head, 1UL, u32Time);
+    DLOG_Put(u32Head, 2UL, SystemCoreClock);
+    DLOG_Put(u32Head, 3UL, DLOG_VERSION);
+    DLOG_Commit(u32Head, DLOG_HDR(DLOG_TYPE_INFO, 0UL, 4UL));
+
+    return DLOG_OK;
+}
+
+/**
+  * @brief      Record a message, see DLOG()
+  *
+  * @param[in]  pcFmt       Format string, kept in the image.
+  * @param[in]  u32Argc     Arguments, 0 ~ \ref DLOG_MAX_ARGS; more are left out.
+  * @param[in]  pu32Argv    Arguments as 32-bit words.
+  *
+  * @return     None
+  *
+  * @details    Safe from any interrupt priority, never waits.
+  */
+void DLOG_Write(const char *pcFmt, uint32_t u32Argc, const uint32_t *pu32Argv)
+{
+    uint32_t u32Head, u32Time, i;
+
+    if(u32Argc > DLOG_MAX_ARGS)
+        u32Argc = DLOG_MAX_ARGS;
+
+    if((s_pu32Ring == NULL) || ((u32Head = DLOG_Reserve(3UL + u32Argc, &u32Time)) == 0xFFFFFFFFUL))
+        return;
+
+    DLOG_Put(u32Head, 1UL, u32Time);
+    DLOG_Put(u32Head, 2UL, (uint32_t)(uintptr_t)pcFmt);
+    for(i = 0UL; i < u32Argc; i++)
+        DLOG_Put(u32Head, 3UL + i, pu32Argv[i]);
+    DLOG_Commit(u32Head, DLOG_HDR(DLOG_TYPE_FMT, u32Argc, 3UL + u32Argc));
+}
+
+/**
+  * @brief      Record text
+  *
+  * @param[in]  pcText      Text, copied into the ring.
+  * @param[in]  u32Len      Bytes of pcText.
+  *
+  * @return     None
+  *
+  * @details    For output already formatted, such as printf() through retarget.c built with
+  *             DEBUG_DEFERRED_LOG. Takes one record per \ref DLOG_TEXT_MAX bytes. Safe from any
+  *             interrupt priority, never waits.
+  */
+void DLOG_Text(const char *pcText, uint32_t u32Len)
+{
+    uint32_t u32Part;
+
+    while(u32Len != 0UL)
+    {
+        u32Part = (u32Len > DLOG_TEXT_MAX) ? DLOG_TEXT_MAX : u32Len;
+        DLOG_TextRec(pcText, u32Part);
+        pcText += u32Part;
+        u32Len -= u32Part;
+    }
+}
+
+/**
+  * @brief      Record a character of text
+  *
+  * @param[in]  ch          Character.
+  *
+  * @return     None
+  *
+  * @details    The fputc() path of retarget.c built with DEBUG_DEFERRED_LOG. Characters gather
+  *             into a line, one for thread mode and one for interrupt handlers, recorded at '\\n',
+  *             when \ref DLOG_TEXT_MAX long, when another handler starts a line, or by the next
+  *             DLOG_Drain() or DLOG_Flush(). Safe from any interrupt priority; masks interrupts
+  *             for the time of a character, or of copying a line into the ring.
+  */
+void DLOG_PutChar(int ch)
+{
+    uint32_t u32Ipsr = __get_IPSR(), u32PriMask;
+    DLOG_LINE_T *psLine = &s_asLine[(u32Ipsr != 0UL) ? 1UL : 0UL];
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    if((psLine->u32Len != 0UL) && (psLine->u32Owner != u32Ipsr))
+        DLOG_LineOut(psLine);
+
+    psLine->u32Owner = u32Ipsr;
+    psLine->acText[psLine->u32Len++] = (char)ch;
+    if(((char)ch == '\n') || (psLine->u32Len == DLOG_TEXT_MAX))
+        DLOG_LineOut(psLine);
+
+    __set_PRIMASK(u32PriMask);
+}
+
+/**
+  * @brief      Send the complete records to a buffered UART port
+  *
+  * @param[in]  psPort      Port opened by UART_BufOpen(), with PDMA TX preferably.
+  *
+  * @return     Records moved to the TX ring of psPort
+  *
+  * @details    Moves whole records while they fit in the TX ring; the port sends them without
+  *             the CPU. Each goes out as \ref DLOG_SYNC and its words, little endian, the header
+  *             carrying a frame number. A DROP record reports the messages refused since the
+  *             previous one. Lines of DLOG_PutChar() still open are recorded first.
+  *             Call from one context only, typically the idle loop before sleeping:
+  *             the time spent is a copy per record, and it never waits for the UART.
+  */
+uint32_t DLOG_Drain(UART_BUF_T *psPort)
+{
+    uint32_t au32Rec[DLOG_REC_MAX_WORDS], u32Words, u32IsDrop, u32Len, u32Cnt = 0UL;
+    uint8_t au8Frame[1UL + DLOG_REC_MAX_WORDS * 4UL];
+
+    if(s_pu32Ring == NULL)
+        return 0UL;
+
+    DLOG_LinesOut();
+
+    while((u32Words = DLOG_Peek(au32Rec, &u32IsDrop)) != 0UL)
+    {
+        if(UART_BufTxSpace(psPort) < (1UL + u32Words * 4UL))
+            break;
+
+        u32Len = DLOG_Frame(au8Frame, au32Rec, u32Words);
+        DLOG_Release(u32Words, u32IsDrop, au32Rec);
+        UART_BufWrite(psPort, au8Frame, u32Len);
+        u32Cnt++;
+    }
+
+    return u32Cnt;
+}
+
+/**
+  * @brief      Send the complete records by polling a UART
+  *
+  * @param[in]  uart        UART0 ~ UART9.
+  *
+  * @return     None
+  *
+  * @details    Waits for the FIFO, for fault handlers and shutdown paths where the buffered
+  *             port can no longer run; stop its PDMA first, or the two streams interleave.
+  *             Lines of DLOG_PutChar() still open are recorded first.
+  */
+void DLOG_Flush(UART_T *uart)
+{
+    uint32_t au32Rec[DLOG_REC_MAX_WORDS], u32Words, u32IsDrop, u32Len, i;
+    uint8_t au8Frame[1UL + DLOG_REC_MAX_WORDS * 4UL];
+
+    if(s_pu32Ring == NULL)
+        return;
+
+    DLOG_LinesOut();
+
+    while((u32Words = DLOG_Peek(au32Rec, &u32IsDrop)) != 0UL)
+    {
+        u32Len = DLOG_Frame(au8Frame, au32Rec, u32Words);
+        DLOG_Release(u32Words, u32IsDrop, au32Rec);
+
+        for(i = 0UL; i < u32Len; i++)
+        {
+            while(uart->FIFOSTS & UART_FIFOSTS_TXFULL_Msk) {}
+            uart->DAT = au8Frame[i];
+        }
+    }
+}
+
+/**
+  * @brief      Get the log statistics
+  *
+  * @param[out] psStat      Statistics since DLOG_Init().
+  *
+  * @return     None
+  */
+void DLOG_GetStats(DLOG_STAT_T *psStat)
+{
+    psStat->u32Dropped = s_u32Dropped;
+    psStat->u32MaxUsed = s_u32MaxUsed;
+    psStat->u32Drained = s_u32Drained;
+}
+
+/**@}*/ /* end of group DLOG_EXPORTED_FUNCTIONS */
+
+/**@}*/ /* end of group DLOG_Driver */
+
+/**@}*/ /* end of group Standard_Driver */
@@ -246,6 +246,276 @@ void EADC_SetExtendSampleTime(EADC_T *eadc, uint32_t u32ModuleNum, uint32_t u32E
 
 }
 
+/**
+  * @brief Return the PDMA request source of an EADC module.
+  * @param[in] eadc The pointer of the specified EADC module.
+  * @return PDMA request source number.
+  */
+static uint32_t EADC_StreamReqSrc(EADC_T *eadc)
+{
+    if (eadc == EADC1)
+        return PDMA_EADC1_RX;
+    else if (eadc == EADC2)
+        return PDMA_EADC2_RX;
+    else
+        return PDMA_EADC0_RX;
+}
+
+/**
+  * @brief Load the scatter-gather descriptor of one stream block.
+  * @param[in] psStream The pointer of the stream.
+  * @param[in] u32Idx Block index.
+  * @return None
+  */
+static void EADC_StreamLoadDesc(EADC_STREAM_T *psStream, uint32_t u32Idx)
+{
+    EADC_STREAM_CFG_T *psCfg = &psStream->sCfg;
+    DSCT_T *psDesc = &psCfg->psDesc[u32Idx];
+    uint32_t u32Next = (u32Idx + 1UL == psCfg->u32BlockCnt) ? 0UL : (u32Idx + 1UL);
+
+    psDesc->SA = (uint32_t)&psStream->eadc->CURDAT;
+    psDesc->DA = (uint32_t)&psCfg->pu16Buf[u32Idx * psStream->u32BlockWords];
+    psDesc->NEXT = (uint32_t)&psCfg->psDesc[u32Next] - (psCfg->pdma->SCATBA & PDMA_SCATBA_SCATBA_Msk);
+    psDesc->CTL = ((psStream->u32BlockWords - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_WIDTH_16 |
+                  PDMA_SAR_FIX | PDMA_DAR_INC | PDMA_REQ_SINGLE | PDMA_BURST_1 |
+                  PDMA_TBINTDIS_ENABLE | PDMA_OP_SCATTER;
+}
+
+/**
+  * @brief Prepare continuous acquisition into a ring of PDMA blocks.
+  * @param[in] eadc The pointer of the specified EADC module, already opened with EADC_Open().
+  * @param[out] psStream The pointer of the stream state.
+  * @param[in] psCfg The pointer of the stream configuration, copied into psStream.
+  * @retval 0 Success.
+  * @retval EADC_STREAM_PARAM_ERR Invalid configuration, or the descriptors do not fit the PDMA
+  *         SCATBA window, see PDMA_SetScatterBase().
+  * @details Sample modules 0 ~ (u32ModuleCnt - 1) are bound to pu32Channel[] and the common trigger
+  *          and raise PDMA requests, so that every trigger adds one frame of u32ModuleCnt samples.
+  *          One scatter-gather descriptor per block is chained into a circle, so PDMA never stops
+  *          and no sample is lost between blocks. Acquisition starts with EADC_StreamStart().
+  */
+int32_t EADC_StreamOpen(EADC_T *eadc, EADC_STREAM_T *psStream, const EADC_STREAM_CFG_T *psCfg)
+{
+    PDMA_T *pdma = psCfg->pdma;
+    uint32_t u32Ch = psCfg->u32PdmaCh;
+    volatile uint32_t *pu32ReqSel;
+    uint32_t i;
+
+    if ((psCfg->u32ModuleCnt == 0UL) || (psCfg->u32ModuleCnt > EADC_STREAM_MAX_MODULES) ||
+            (psCfg->u32BlockFrames == 0UL) || (psCfg->u32BlockCnt < 2UL) || (u32Ch > 15UL) ||
+            (psCfg->u32BlockFrames * psCfg->u32ModuleCnt > (PDMA_DSCT_CTL_TXCNT_Msk >> PDMA_DSCT_CTL_TXCNT_Pos) + 1UL))
+        return EADC_STREAM_PARAM_ERR;
+
+    if (PDMA_SetScatterBase(pdma, psCfg->psDesc, psCfg->u32BlockCnt, psCfg->u32ScatMode) != 0)
+        return EADC_STREAM_PARAM_ERR;
+
+    psStream->eadc = eadc;
+    psStream->sCfg = *psCfg;
+    psStream->u32BlockWords = psCfg->u32BlockFrames * psCfg->u32ModuleCnt;
+    psStream->u32Head = 0UL;
+    psStream->u32Tail = 0UL;
+    EADC_StreamClearStats(psStream);
+
+    for (i = 0UL; i < psCfg->u32ModuleCnt; i++)
+        EADC_ConfigSampleModule(eadc, i, psCfg->u32TriggerSrc, psCfg->pu32Channel[i]);
+
+    /* Channel request source: four 8-bit fields per REQSEL register */
+    pu32ReqSel = &pdma->REQSEL0_3 + (u32Ch >> 2);
+    *pu32ReqSel = (*pu32ReqSel & ~(PDMA_REQSEL0_3_REQSRC0_Msk << ((u32Ch & 3UL) * 8UL))) |
+                  (EADC_StreamReqSrc(eadc) << ((u32Ch & 3UL) * 8UL));
+
+    return 0;
+}
+
+/**
+  * @brief Start continuous acquisition.
+  * @param[in] psStream The pointer of the stream prepared by EADC_StreamOpen().
+  * @return None
+  * @details The ring is emptied and the descriptor chain rebuilt. PDMA transfer done interrupt of
+  *          the channel is enabled; the application calls EADC_StreamIRQHandler() from PDMAn_IRQHandler
+  *          and enables the PDMA interrupt in NVIC.
+  */
+void EADC_StreamStart(EADC_STREAM_T *psStream)
+{
+    EADC_STREAM_CFG_T *psCfg = &psStream->sCfg;
+    PDMA_T *pdma = psCfg->pdma;
+    uint32_t u32Ch = psCfg->u32PdmaCh;
+    uint32_t u32Mask = (1UL << psCfg->u32ModuleCnt) - 1UL;
+    uint32_t i;
+
+    psStream->u32Head = 0UL;
+    psStream->u32Tail = 0UL;
+
+    for (i = 0UL; i < psCfg->u32BlockCnt; i++)
+        EADC_StreamLoadDesc(psStream, i);
+
+    pdma->DSCT[u32Ch].CTL = PDMA_OP_SCATTER;
+    pdma->DSCT[u32Ch].NEXT = (uint32_t)&psCfg->psDesc[0] - (pdma->SCATBA & PDMA_SCATBA_SCATBA_Msk);
+    pdma->TDSTS = (1UL << u32Ch);
+    pdma->INTEN |= (1UL << u32Ch);
+    pdma->CHCTL |= (1UL << u32Ch);
+
+    psStream->eadc->OVSTS = u32Mask;
+    EADC_ENABLE_SAMPLE_MODULE_PDMA(psStream->eadc, u32Mask);
+}
+
+/**
+  * @brief Stop continuous acquisition.
+  * @param[in] psStream The pointer of the stream.
+  * @return None
+  * @details Blocks already completed stay readable through EADC_StreamGetBlock().
+  */
+void EADC_StreamStop(EADC_STREAM_T *psStream)
+{
+    PDMA_T *pdma = psStream->sCfg.pdma;
+    uint32_t u32Ch = psStream->sCfg.u32PdmaCh;
+    uint32_t u32Mask = (1UL << psStream->sCfg.u32ModuleCnt) - 1UL;
+
+    EADC_DISABLE_SAMPLE_MODULE_PDMA(psStream->eadc, u32Mask);
+    pdma->INTEN &= ~(1UL << u32Ch);
+    pdma->CHCTL &= ~(1UL << u32Ch);
+    pdma->TDSTS = (1UL << u32Ch);
+}
+
+/**
+  * @brief Stream part of the PDMA interrupt handler.
+  * @param[in] psStream The pointer of the stream.
+  * @return None
+  * @details Call it from PDMAn_IRQHandler() when the transfer done flag of the stream channel is set.
+  *          Every block before the one PDMA is writing (CURSCAT of the channel) is stamped and published
+  *          by advancing u32Head, and the EADC trigger overrun flags are collected. Blocks that completed
+  *          together under one transfer done flag share the timestamp and are counted in u32MergedBlocks.
+  *          The descriptors stay valid, PDMA just moves on to the next one. Only this function writes u32Head.
+  */
+void EADC_StreamIRQHandler(EADC_STREAM_T *psStream)
+{
+    EADC_STREAM_CFG_T *psCfg = &psStream->sCfg;
+    PDMA_T *pdma = psCfg->pdma;
+    uint32_t u32Head = psStream->u32Head;
+    uint32_t u32Idx = u32Head % psCfg->u32BlockCnt;
+    uint32_t u32Ovf = psStream->eadc->OVSTS & ((1UL << psCfg->u32ModuleCnt) - 1UL);
+    uint32_t u32Cur, u32Done, u32Now;
+    EADC_STREAM_BLK_T *psBlk;
+
+    /* Clear first: a block finishing after the CURSCAT read raises the flag again */
+    pdma->TDSTS = (1UL << psCfg->u32PdmaCh);
+
+    /* PDMA loads the next table as soon as a block is done, so CURSCAT is the block being written */
+    u32Cur = (pdma->CURSCAT[psCfg->u32PdmaCh] - (uint32_t)psCfg->psDesc) / sizeof(DSCT_T);
+
+    if (u32Cur >= psCfg->u32BlockCnt)
+        u32Cur = u32Idx;
+
+    u32Done = (u32Cur + psCfg->u32BlockCnt - u32Idx) % psCfg->u32BlockCnt;
+    u32Now = (psCfg->pfnGetTime != NULL) ? psCfg->pfnGetTime() : 0UL;
+
+    if (u32Done > 1UL)
+        psStream->u32MergedBlocks += u32Done - 1UL;
+
+    for (; u32Done; u32Done--)
+    {
+        psBlk = &psCfg->psBlk[u32Idx];
+        psBlk->pu16Data = &psCfg->pu16Buf[u32Idx * psStream->u32BlockWords];
+        psBlk->u32Seq = u32Head;
+        psBlk->u32Timestamp = u32Now;
+        u32Head++;
+        u32Idx = (u32Idx + 1UL == psCfg->u32BlockCnt) ? 0UL : (u32Idx + 1UL);
+    }
+
+    if (u32Ovf)
+    {
+        psStream->eadc->OVSTS = u32Ovf;
+
+        for (; u32Ovf; u32Ovf &= (u32Ovf - 1UL))
+            psStream->u32TriggerOverruns++;
+    }
+
+    psStream->u32Head = u32Head;
+}
+
+/**
+  * @brief Fetch the oldest completed block.
+  * @param[in] psStream The pointer of the stream.
+  * @return The block, or NULL when no block has completed since the last release.
+  * @details The block stays owned by the caller until EADC_StreamReleaseBlock(). PDMA always writes
+  *          the block after the newest one, so at most (u32BlockCnt - 1) blocks can wait. Older blocks
+  *          have been overwritten: they are dropped, counted in u32Overruns, and the sequence number of
+  *          the returned block jumps accordingly.
+  */
+EADC_STREAM_BLK_T *EADC_StreamGetBlock(EADC_STREAM_T *psStream)
+{
+    EADC_STREAM_CFG_T *psCfg = &psStream->sCfg;
+    uint32_t u32Tail = psStream->u32Tail;
+    uint32_t u32Fill = psStream->u32Head - u32Tail;
+    EADC_STREAM_BLK_T *psBlk;
+    uint32_t u32Latency;
+
+    if (u32Fill == 0UL)
+        return NULL;
+
+    if (u32Fill > psCfg->u32BlockCnt - 1UL)
+    {
+        psStream->u32Overruns += u32Fill - (psCfg->u32BlockCnt - 1UL);
+        u32Tail += u32Fill - (psCfg->u32BlockCnt - 1UL);
+        u32Fill = psCfg->u32BlockCnt - 1UL;
+        psStream->u32Tail = u32Tail;
+    }
+
+    if (u32Fill > psStream->u32MaxFill)
+        psStream->u32MaxFill = u32Fill;
+
+    psBlk = &psCfg->psBlk[u32Tail % psCfg->u32BlockCnt];
+
+    if (psCfg->pfnGetTime != NULL)
+    {
+        u32Latency = psCfg->pfnGetTime() - psBlk->u32Timestamp;
+
+        if (u32Latency > psStream->u32MaxLatency)
+            psStream->u32MaxLatency = u32Latency;
+    }
+
+    return psBlk;
+}
+
+/**
+  * @brief Return the block fetched by EADC_StreamGetBlock() to PDMA.
+  * @param[in] psStream The pointer of the stream.
+  * @retval 0 The block data stayed intact while it was held.
+  * @retval EADC_STREAM_LATE_ERR PDMA had already started to overwrite the block; it is counted
+  *         in u32LateBlocks and its data should be discarded.
+  * @details Only this function and EADC_StreamGetBlock() write u32Tail.
+  */
+int32_t EADC_StreamReleaseBlock(EADC_STREAM_T *psStream)
+{
+    uint32_t u32Tail = psStream->u32Tail;
+    int32_t i32Ret = 0;
+
+    if (psStream->u32Head - u32Tail >= psStream->sCfg.u32BlockCnt)
+    {
+        psStream->u32LateBlocks++;
+        i32Ret = EADC_STREAM_LATE_ERR;
+    }
+
+    psStream->u32Tail = u32Tail + 1UL;
+
+    return i32Ret;
+}
+
+/**
+  * @brief Clear the stream statistics.
+  * @param[in] psStream The pointer of the stream.
+  * @return None
+  */
+void EADC_StreamClearStats(EADC_STREAM_T *psStream)
+{
+    psStream->u32Overruns = 0UL;
+    psStream->u32LateBlocks = 0UL;
+    psStream->u32MaxFill = 0UL;
+    psStream->u32MaxLatency = 0UL;
+    psStream->u32TriggerOverruns = 0UL;
+    psStream->u32MergedBlocks = 0UL;
+}
+
 /*@}*/ /* end of group EADC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group EADC_Driver */
@@ -8,6 +8,8 @@
 *****************************************************************************/
 
 #include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "NuMicro.h"
 
@@ -27,6 +29,735 @@
 
 int32_t g_FMC_i32ErrCode = 0; /*!< FMC global error code */
 
+/** @cond HIDDEN_SYMBOLS */
+
+/* Flash side phases of FMC_UPD_T */
+#define FMC_UPD_PH_TRAILER      0UL     /* Erasing the trailer page of the inactive bank */
+#define FMC_UPD_PH_WAIT         1UL     /* Waiting for a filled page buffer */
+#define FMC_UPD_PH_PROGRAM      2UL     /* Erasing, then programming the page */
+#define FMC_UPD_PH_HASH         3UL     /* SHA DMA reading the page back */
+#define FMC_UPD_PH_COMMIT       4UL     /* Programming the trailer */
+#define FMC_UPD_PH_DONE         5UL
+
+#define FMC_UPD_TRL_DWORDS      7UL     /* Trailer double words of the commit, up to u32CommitSeq */
+#define FMC_UPD_CRC_CTL         (CRC_32 | CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM | CRC_CTL_CRCEN_Msk)
+#define FMC_UPD_SHA_CTL         ((SHA_MODE_SHA256 << CRPT_HMAC_CTL_OPMODE_Pos) | (SHA_IN_OUT_SWAP << CRPT_HMAC_CTL_OUTSWAP_Pos))
+
+static uint32_t fmc_upd_time(FMC_UPD_T *psUpd)
+{
+    return (psUpd->pfnGetTime != NULL) ? psUpd->pfnGetTime() : 0UL;
+}
+
+static uint32_t fmc_upd_trailer_offset(FMC_UPD_T *psUpd)
+{
+    return psUpd->u32SlotSize - FMC_FLASH_PAGE_SIZE;
+}
+
+/* Bus address of a page of the inactive bank, mapped behind the active one */
+static const uint32_t *fmc_upd_inactive(FMC_UPD_T *psUpd, uint32_t u32Offset)
+{
+    return (const uint32_t *)(psUpd->u32MapBase + FMC_BANK_SIZE + u32Offset);
+}
+
+/* ISP commands are issued without waiting; FMC_UpdPoll() sees them complete */
+static void fmc_upd_erase(uint32_t u32Addr)
+{
+    FMC->ISPCMD = FMC_ISPCMD_PAGE_ERASE;
+    FMC->ISPADDR = u32Addr;
+    FMC->ISPTRG = FMC_ISPTRG_ISPGO_Msk;
+}
+
+static void fmc_upd_program(uint32_t u32Addr, uint32_t u32Data0, uint32_t u32Data1)
+{
+    FMC->ISPCMD = FMC_ISPCMD_PROGRAM_64;
+    FMC->ISPADDR = u32Addr;
+    FMC->MPDAT0 = u32Data0;
+    FMC->MPDAT1 = u32Data1;
+    FMC->ISPTRG = FMC_ISPTRG_ISPGO_Msk;
+}
+
+/* CRC-32 as zlib computes it */
+static void fmc_upd_crc_start(void)
+{
+    CRC->SEED = 0xFFFFFFFFUL;
+    CRC->POLYNOMIAL = 0x04C11DB7UL;
+    CRC->CTL = FMC_UPD_CRC_CTL | CRC_CPU_WDATA_32;
+    CRC->CTL |= CRC_CTL_CHKSINIT_Msk;
+}
+
+static void fmc_upd_crc(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    for(; u32Len >= 4UL; u32Len -= 4UL, pu8Data += 4)
+        CRC->DAT = __UNALIGNED_UINT32_READ(pu8Data);
+
+    if(u32Len)
+    {
+        CRC->CTL = FMC_UPD_CRC_CTL | CRC_CPU_WDATA_8;
+        while(u32Len--)
+            CRC->DAT = *pu8Data++;
+        CRC->CTL = FMC_UPD_CRC_CTL | CRC_CPU_WDATA_32;
+    }
+}
+
+/* Append image bytes to the page buffer being filled; returns the bytes taken, 0 when both buffers are full */
+static uint32_t fmc_upd_put(FMC_UPD_T *psUpd, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint8_t *pu8Buf = (uint8_t *)psUpd->au32Buf[psUpd->u32Fill];
+
+    if(psUpd->u32Full & (1UL << psUpd->u32Fill))
+        return 0UL;
+
+    if(u32Len > FMC_FLASH_PAGE_SIZE - psUpd->u32FillLen)
+        u32Len = FMC_FLASH_PAGE_SIZE - psUpd->u32FillLen;
+
+    memcpy(pu8Buf + psUpd->u32FillLen, pu8Data, u32Len);
+    fmc_upd_crc(pu8Data, u32Len);
+    psUpd->u32FillLen += u32Len;
+    psUpd->u32Produced += u32Len;
+
+    if((psUpd->u32FillLen == FMC_FLASH_PAGE_SIZE) || (psUpd->u32Produced == psUpd->sPkg.u32Size))
+    {
+        /* The tail of the last page stays erased */
+        memset(pu8Buf + psUpd->u32FillLen, 0xFF, FMC_FLASH_PAGE_SIZE - psUpd->u32FillLen);
+        psUpd->u32Full |= 1UL << psUpd->u32Fill;
+        psUpd->u32Fill ^= 1UL;
+        psUpd->u32FillLen = 0UL;
+    }
+
+    return u32Len;
+}
+
+static int32_t fmc_upd_check_pkg(FMC_UPD_T *psUpd)
+{
+    FMC_UPD_PKG_T *psPkg = &psUpd->sPkg;
+    FMC_UPD_TRAILER_T sTrl;
+    int32_t i32Ret;
+
+    fmc_upd_crc_start();
+    fmc_upd_crc((const uint8_t *)psPkg, sizeof(FMC_UPD_PKG_T) - 4UL);
+
+    if((psPkg->u32Magic != FMC_UPD_PKG_MAGIC) || (CRC->CHECKSUM != psPkg->u32HdrCrc) ||
+            (psPkg->u32Size == 0UL) || (psPkg->u32Size > fmc_upd_trailer_offset(psUpd)))
+        return FMC_UPD_ERR_FORMAT;
+
+    if(psPkg->u32Flags & FMC_UPD_PKG_DELTA)
+    {
+        i32Ret = FMC_UpdReadTrailer(psUpd, psUpd->u32Bank, &sTrl);
+        if(i32Ret == FMC_UPD_ERR_FAIL)
+            return i32Ret;
+        if((i32Ret != FMC_UPD_OK) || memcmp(sTrl.au8Digest, psPkg->au8BaseDigest, sizeof(sTrl.au8Digest)))
+            return FMC_UPD_ERR_BASE;
+    }
+
+    return FMC_UPD_OK;
+}
+
+/* Take package bytes, and produce the bytes of a pending copy record; returns the bytes taken */
+static int32_t fmc_upd_feed(FMC_UPD_T *psUpd, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    FMC_UPD_REC_T *psRec = &psUpd->sRec;
+    uint32_t u32Done = 0UL, u32Cnt, u32RecLen;
+    int32_t i32Ret;
+
+    for(;;)
+    {
+        if(psUpd->u32PkgCnt < sizeof(FMC_UPD_PKG_T))
+        {
+            if(u32Done == u32Len)
+                break;
+
+            u32Cnt = sizeof(FMC_UPD_PKG_T) - psUpd->u32PkgCnt;
+            if(u32Cnt > u32Len - u32Done)
+                u32Cnt = u32Len - u32Done;
+            memcpy((uint8_t *)&psUpd->sPkg + psUpd->u32PkgCnt, pu8Data + u32Done, u32Cnt);
+            psUpd->u32PkgCnt += u32Cnt;
+            u32Done += u32Cnt;
+
+            if((psUpd->u32PkgCnt == sizeof(FMC_UPD_PKG_T)) && ((i32Ret = fmc_upd_check_pkg(psUpd)) != FMC_UPD_OK))
+                return i32Ret;
+        }
+        else if(psUpd->u32RecLeft)
+        {
+            u32RecLen = psRec->u32Tag >> 8;
+
+            if((psRec->u32Tag & 0xFFUL) == FMC_UPD_REC_COPY)
+            {
+                u32Cnt = fmc_upd_put(psUpd, (const uint8_t *)(psUpd->u32MapBase + psRec->u32Arg + u32RecLen - psUpd->u32RecLeft),
+                                     psUpd->u32RecLeft);
+                psUpd->sStat.u32CopyBytes += u32Cnt;
+            }
+            else
+            {
+                if(u32Done == u32Len)
+                    break;
+
+                u32Cnt = fmc_upd_put(psUpd, pu8Data + u32Done,
+                                     (psUpd->u32RecLeft < u32Len - u32Done) ? psUpd->u32RecLeft : u32Len - u32Done);
+                psUpd->sStat.u32InsertBytes += u32Cnt;
+                u32Done += u32Cnt;
+            }
+
+            if(u32Cnt == 0UL)
+                break;
+
+            psUpd->u32RecLeft -= u32Cnt;
+            if((psUpd->u32RecLeft == 0UL) && (CRC->CHECKSUM != psRec->u32Crc))
+                return FMC_UPD_ERR_CRC;
+        }
+        else if(psUpd->u32Produced == psUpd->sPkg.u32Size)
+        {
+            /* Bytes past the last record do not belong to the package */
+            if(u32Done != u32Len)
+                return FMC_UPD_ERR_FORMAT;
+            break;
+        }
+        else
+        {
+            if(u32Done == u32Len)
+                break;
+
+            u32Cnt = sizeof(FMC_UPD_REC_T) - psUpd->u32RecCnt;
+            if(u32Cnt > u32Len - u32Done)
+                u32Cnt = u32Len - u32Done;
+            memcpy((uint8_t *)psRec + psUpd->u32RecCnt, pu8Data + u32Done, u32Cnt);
+            psUpd->u32RecCnt += u32Cnt;
+            u32Done += u32Cnt;
+
+            if(psUpd->u32RecCnt < sizeof(FMC_UPD_REC_T))
+                continue;
+
+            psUpd->u32RecCnt = 0UL;
+            u32RecLen = psRec->u32Tag >> 8;
+            if((u32RecLen == 0UL) || (u32RecLen > psUpd->sPkg.u32Size - psUpd->u32Produced))
+                return FMC_UPD_ERR_FORMAT;
+
+            if((psRec->u32Tag & 0xFFUL) == FMC_UPD_REC_COPY)
+            {
+                if(!(psUpd->sPkg.u32Flags & FMC_UPD_PKG_DELTA) || (psRec->u32Arg > fmc_upd_trailer_offset(psUpd)) ||
+                        (u32RecLen > fmc_upd_trailer_offset(psUpd) - psRec->u32Arg))
+                    return FMC_UPD_ERR_FORMAT;
+            }
+            else if((psRec->u32Tag & 0xFFUL) != FMC_UPD_REC_INSERT)
+            {
+                return FMC_UPD_ERR_FORMAT;
+            }
+
+            fmc_upd_crc_start();
+            psUpd->u32RecLeft = u32RecLen;
+        }
+    }
+
+    return (int32_t)u32Done;
+}
+
+/* A page needs an erase when a double word differs from its new value and is not erased */
+static uint32_t fmc_upd_need_erase(FMC_UPD_T *psUpd)
+{
+    const uint32_t *pu32Flash = fmc_upd_inactive(psUpd, psUpd->u32Page * FMC_FLASH_PAGE_SIZE);
+    const uint32_t *pu32Buf = psUpd->au32Buf[psUpd->u32Prog];
+    uint32_t i;
+
+    for(i = 0UL; i < FMC_FLASH_PAGE_SIZE / 4UL; i += 2UL)
+    {
+        if(((pu32Flash[i] != pu32Buf[i]) || (pu32Flash[i + 1] != pu32Buf[i + 1])) &&
+                ((pu32Flash[i] & pu32Flash[i + 1]) != 0xFFFFFFFFUL))
+            return 1UL;
+    }
+
+    return 0UL;
+}
+
+/* Program the next double word that does not hold its new value yet; 0 when the page is done */
+static uint32_t fmc_upd_program_next(FMC_UPD_T *psUpd)
+{
+    const uint32_t *pu32Flash = fmc_upd_inactive(psUpd, psUpd->u32Page * FMC_FLASH_PAGE_SIZE);
+    const uint32_t *pu32Buf = psUpd->au32Buf[psUpd->u32Prog];
+    uint32_t i;
+
+    for(i = psUpd->u32Step; i < FMC_FLASH_PAGE_SIZE / 4UL; i += 2UL)
+    {
+        if((pu32Flash[i] != pu32Buf[i]) || (pu32Flash[i + 1] != pu32Buf[i + 1]))
+        {
+            fmc_upd_program((psUpd->u32Bank ^ 1UL) * FMC_BANK_SIZE + psUpd->u32Page * FMC_FLASH_PAGE_SIZE + i * 4UL,
+                            pu32Buf[i], pu32Buf[i + 1]);
+            psUpd->u32Step = i + 2UL;
+            psUpd->sStat.u32Programs++;
+            return 1UL;
+        }
+        psUpd->sStat.u32Kept++;
+    }
+
+    psUpd->u32Step = i;
+    return 0UL;
+}
+
+/* Hash the page just written, read back from the inactive bank by the SHA DMA */
+static void fmc_upd_hash(FMC_UPD_T *psUpd)
+{
+    uint32_t u32Offset = psUpd->u32Page * FMC_FLASH_PAGE_SIZE;
+    uint32_t u32Len = psUpd->sPkg.u32Size - u32Offset;
+    uint32_t u32Mode = CRPT_HMAC_CTL_DMAEN_Msk;
+
+    if(u32Offset == 0UL)
+        CRPT->HMAC_CTL = FMC_UPD_SHA_CTL;
+    else
+        u32Mode |= CRPT_HMAC_CTL_DMACSCAD_Msk;
+
+    if(u32Len <= FMC_FLASH_PAGE_SIZE)
+        u32Mode |= CRPT_HMAC_CTL_DMALAST_Msk;
+    else
+        u32Len = FMC_FLASH_PAGE_SIZE;
+
+    CRPT->INTSTS = CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk;
+    CRPT->HMAC_SADDR = (uint32_t)fmc_upd_inactive(psUpd, u32Offset);
+    CRPT->HMAC_DMACNT = u32Len;
+    CRPT->HMAC_CTL = (CRPT->HMAC_CTL & ~(0x7UL << CRPT_HMAC_CTL_DMALAST_Pos)) | CRPT_HMAC_CTL_START_Msk | u32Mode;
+}
+
+/* The last page is hashed: check the digest and fill in the trailer to commit */
+static int32_t fmc_upd_seal(FMC_UPD_T *psUpd)
+{
+    uint32_t au32Digest[8];
+    uint32_t i;
+
+    for(i = 0UL; i < 8UL; i++)
+        au32Digest[i] = CRPT->HMAC_DGST[i];
+
+    if(memcmp(au32Digest, psUpd->sPkg.au8Digest, sizeof(au32Digest)))
+        return FMC_UPD_ERR_DIGEST;
+
+    psUpd->sTrl.u32Magic = FMC_UPD_TRL_MAGIC;
+    psUpd->sTrl.u32Size = psUpd->sPkg.u32Size;
+    psUpd->sTrl.u32Version = psUpd->sPkg.u32Version;
+    memcpy(psUpd->sTrl.au8Digest, au32Digest, sizeof(au32Digest));
+    psUpd->sTrl.u32Commit = FMC_UPD_TRL_COMMIT;
+    psUpd->sTrl.u32CommitSeq = ~psUpd->sTrl.u32Seq;
+
+    return FMC_UPD_OK;
+}
+
+static int32_t fmc_upd_step(FMC_UPD_T *psUpd)
+{
+    uint32_t u32Inactive = (psUpd->u32Bank ^ 1UL) * FMC_BANK_SIZE;
+    const uint32_t *pu32Trl = (const uint32_t *)&psUpd->sTrl;
+    const uint32_t *pu32Flash;
+    uint32_t i;
+    int32_t i32Ret;
+
+    if(FMC->ISPTRG & FMC_ISPTRG_ISPGO_Msk)
+        return FMC_UPD_BUSY;
+
+    if(FMC->ISPCTL & FMC_ISPCTL_ISPFF_Msk)
+    {
+        FMC->ISPCTL |= FMC_ISPCTL_ISPFF_Msk;
+        return FMC_UPD_ERR_FAIL;
+    }
+
+    /* Copy records need no package data: keep them going as page buffers come free */
+    if(psUpd->u32RecLeft && ((psUpd->sRec.u32Tag & 0xFFUL) == FMC_UPD_REC_COPY) &&
+            ((i32Ret = fmc_upd_feed(psUpd, NULL, 0UL)) < 0))
+        return i32Ret;
+
+    switch(psUpd->u32Phase)
+    {
+        case FMC_UPD_PH_TRAILER:
+            /* Invalidate the image of the inactive bank before any of it changes, once the header is accepted */
+            if(psUpd->u32PkgCnt < sizeof(FMC_UPD_PKG_T))
+                return FMC_UPD_OK;
+
+            psUpd->u32Phase = FMC_UPD_PH_WAIT;
+            pu32Flash = fmc_upd_inactive(psUpd, fmc_upd_trailer_offset(psUpd));
+            for(i = 0UL; i < FMC_FLASH_PAGE_SIZE / 4UL; i++)
+            {
+                if(pu32Flash[i] != 0xFFFFFFFFUL)
+                {
+                    fmc_upd_erase(u32Inactive + fmc_upd_trailer_offset(psUpd));
+                    psUpd->sStat.u32Erases++;
+                    return FMC_UPD_BUSY;
+                }
+            }
+        /* fall through */
+
+        case FMC_UPD_PH_WAIT:
+            if(!(psUpd->u32Full & (1UL << psUpd->u32Prog)))
+                return FMC_UPD_OK;
+
+            psUpd->u32Page = psUpd->sStat.u32Pages;
+            psUpd->u32Step = 0UL;
+            psUpd->u32Phase = FMC_UPD_PH_PROGRAM;
+            if(fmc_upd_need_erase(psUpd))
+            {
+                fmc_upd_erase(u32Inactive + psUpd->u32Page * FMC_FLASH_PAGE_SIZE);
+                psUpd->sStat.u32Erases++;
+                return FMC_UPD_BUSY;
+            }
+        /* fall through */
+
+        case FMC_UPD_PH_PROGRAM:
+            if(fmc_upd_program_next(psUpd))
+                return FMC_UPD_BUSY;
+
+            fmc_upd_hash(psUpd);
+            psUpd->u32Phase = FMC_UPD_PH_HASH;
+            return FMC_UPD_BUSY;
+
+        case FMC_UPD_PH_HASH:
+            if(!(CRPT->INTSTS & (CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk)))
+                return FMC_UPD_BUSY;
+
+            if((CRPT->INTSTS & CRPT_INTSTS_HMACEIF_Msk) || (CRPT->HMAC_STS & CRPT_HMAC_STS_DMAERR_Msk))
+            {
+                CRPT->INTSTS = CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk;
+                return FMC_UPD_ERR_FAIL;
+            }
+            CRPT->INTSTS = CRPT_INTSTS_HMACIF_Msk;
+
+            psUpd->u32Full &= ~(1UL << psUpd->u32Prog);
+            psUpd->u32Prog ^= 1UL;
+            psUpd->sStat.u32Pages++;
+            if(psUpd->sStat.u32Pages * FMC_FLASH_PAGE_SIZE < psUpd->sPkg.u32Size)
+            {
+                psUpd->u32Phase = FMC_UPD_PH_WAIT;
+                return FMC_UPD_BUSY;
+            }
+
+            if((i32Ret = fmc_upd_seal(psUpd)) != FMC_UPD_OK)
+                return i32Ret;
+            psUpd->u32Step = 0UL;
+            psUpd->u32Phase = FMC_UPD_PH_COMMIT;
+        /* fall through */
+
+        case FMC_UPD_PH_COMMIT:
+            /* In order, so the commit word is the last one programmed */
+            if(psUpd->u32Step < FMC_UPD_TRL_DWORDS)
+            {
+                i = psUpd->u32Step++;
+                fmc_upd_program(u32Inactive + fmc_upd_trailer_offset(psUpd) + i * 8UL, pu32Trl[2UL * i], pu32Trl[2UL * i + 1UL]);
+                return FMC_UPD_BUSY;
+            }
+
+            psUpd->sStat.u32UpdateTime = fmc_upd_time(psUpd) - psUpd->u32StartTime;
+            psUpd->u32Phase = FMC_UPD_PH_DONE;
+        /* fall through */
+
+        default:
+            return FMC_UPD_DONE;
+    }
+}
+
+/* Flags of FMC_KV_ENTRY_T */
+#define FMC_KV_ENTRY_USED       0x1U
+#define FMC_KV_ENTRY_DELETED    0x2U
+
+/* Record header word 1: length in bits 0..14, bit 15 for a deleted key, the complement in the upper half */
+#define FMC_KV_INFO_DELETED     0x8000UL
+#define FMC_KV_INFO_LEN_Msk     0x7FFFUL
+#define FMC_KV_INFO(lo)         ((uint32_t)(lo) | ((~(uint32_t)(lo) & 0xFFFFUL) << 16))
+
+/* CRC-32 as zlib computes it, 4 bits at a time. Not on the CRC engine: an update may hold it. */
+static const uint32_t s_au32KvCrcTbl[16] =
+{
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/* Feed the low u32Bytes bytes of a little-endian word */
+static uint32_t fmc_kv_crc(uint32_t u32Crc, uint32_t u32Word, uint32_t u32Bytes)
+{
+    for(; u32Bytes > 0UL; u32Bytes--, u32Word >>= 8)
+    {
+        u32Crc ^= u32Word & 0xFFUL;
+        u32Crc = (u32Crc >> 4) ^ s_au32KvCrcTbl[u32Crc & 0xFUL];
+        u32Crc = (u32Crc >> 4) ^ s_au32KvCrcTbl[u32Crc & 0xFUL];
+    }
+    return u32Crc;
+}
+
+/* Word of a value at byte u32Pos, 0xFF past its end */
+static uint32_t fmc_kv_word(const uint8_t *pu8Data, uint32_t u32Len, uint32_t u32Pos)
+{
+    uint32_t u32Word = 0xFFFFFFFFUL, i;
+
+    for(i = 0UL; (i < 4UL) && (u32Pos + i < u32Len); i++)
+        u32Word = (u32Word & ~(0xFFUL << (i * 8UL))) | ((uint32_t)pu8Data[u32Pos + i] << (i * 8UL));
+    return u32Word;
+}
+
+static uint32_t fmc_kv_page_addr(FMC_KV_T *psKv, uint32_t u32Page)
+{
+    return psKv->u32Base + u32Page * FMC_FLASH_PAGE_SIZE;
+}
+
+static int32_t fmc_kv_read(FMC_KV_T *psKv, uint32_t u32Addr, uint32_t au32Data[2])
+{
+    psKv->sStat.u32Reads++;
+    return (FMC_Read_64(u32Addr, &au32Data[0], &au32Data[1]) == 0) ? FMC_KV_OK : FMC_KV_ERR_FAIL;
+}
+
+static int32_t fmc_kv_program(FMC_KV_T *psKv, uint32_t u32Addr, uint32_t u32Data0, uint32_t u32Data1)
+{
+    psKv->sStat.u32Programs++;
+    return (FMC_Write8Bytes(u32Addr, u32Data0, u32Data1) == 0) ? FMC_KV_OK : FMC_KV_ERR_FAIL;
+}
+
+static int32_t fmc_kv_erase(FMC_KV_T *psKv, uint32_t u32Addr)
+{
+    psKv->sStat.u32Erases++;
+    return (FMC_Erase(u32Addr) == 0) ? FMC_KV_OK : FMC_KV_ERR_FAIL;
+}
+
+/* Page header at u32Addr: 1 when valid, with its sequence */
+static int32_t fmc_kv_page_seq(FMC_KV_T *psKv, uint32_t u32Addr, uint32_t *pu32Seq)
+{
+    uint32_t au32Hdr[2];
+
+    if(fmc_kv_read(psKv, u32Addr, au32Hdr) != FMC_KV_OK)
+        return FMC_KV_ERR_FAIL;
+
+    *pu32Seq = au32Hdr[1];
+    return ((au32Hdr[0] == FMC_KV_PAGE_MAGIC) && (au32Hdr[1] != 0UL) && (au32Hdr[1] != 0xFFFFFFFFUL)) ? 1L : 0L;
+}
+
+static uint32_t fmc_kv_hash(FMC_KV_T *psKv, uint32_t u32Key)
+{
+    uint32_t u32Hash = u32Key * 0x9E3779B1UL;
+
+    return (u32Hash ^ (u32Hash >> 16)) & (psKv->u32IndexSize - 1UL);
+}
+
+/* Index slot of the key, or the free slot ending its probe sequence */
+static uint32_t fmc_kv_slot(FMC_KV_T *psKv, uint32_t u32Key)
+{
+    uint32_t i = fmc_kv_hash(psKv, u32Key);
+
+    while((psKv->psIndex[i].u16Flags & FMC_KV_ENTRY_USED) && (psKv->psIndex[i].u32Key != u32Key))
+        i = (i + 1UL) & (psKv->u32IndexSize - 1UL);
+    return i;
+}
+
+/* Free an index slot, moving back the entries probed past it */
+static void fmc_kv_remove(FMC_KV_T *psKv, uint32_t u32Slot)
+{
+    FMC_KV_ENTRY_T *psIndex = psKv->psIndex;
+    uint32_t u32Mask = psKv->u32IndexSize - 1UL;
+    uint32_t j = u32Slot;
+
+    psKv->u32Live -= FMC_KV_REC_SIZE(psIndex[u32Slot].u16Len);
+    psKv->u32Keys--;
+
+    while(1)
+    {
+        j = (j + 1UL) & u32Mask;
+        if(!(psIndex[j].u16Flags & FMC_KV_ENTRY_USED))
+            break;
+
+        /* Entry j may fill the hole unless its home slot lies between the hole and j */
+        if(((j - fmc_kv_hash(psKv, psIndex[j].u32Key)) & u32Mask) >= ((j - u32Slot) & u32Mask))
+        {
+            psIndex[u32Slot] = psIndex[j];
+            u32Slot = j;
+        }
+    }
+    psIndex[u32Slot].u16Flags = 0U;
+}
+
+/* Point the key at its newest record */
+static int32_t fmc_kv_index(FMC_KV_T *psKv, uint32_t u32Key, uint32_t u32Addr, uint32_t u32Info)
+{
+    FMC_KV_ENTRY_T *psEntry = &psKv->psIndex[fmc_kv_slot(psKv, u32Key)];
+    uint32_t u32Len = u32Info & FMC_KV_INFO_LEN_Msk;
+
+    if(psEntry->u16Flags & FMC_KV_ENTRY_USED)
+    {
+        psKv->u32Live -= FMC_KV_REC_SIZE(psEntry->u16Len);
+    }
+    else
+    {
+        /* Keep probe sequences short */
+        if((psKv->u32Keys + 1UL) * 4UL > psKv->u32IndexSize * 3UL)
+            return FMC_KV_ERR_FULL;
+        psKv->u32Keys++;
+    }
+
+    psEntry->u32Key = u32Key;
+    psEntry->u32Addr = u32Addr;
+    psEntry->u16Len = (uint16_t)u32Len;
+    psEntry->u16Flags = (uint16_t)(FMC_KV_ENTRY_USED | ((u32Info & FMC_KV_INFO_DELETED) ? FMC_KV_ENTRY_DELETED : 0U));
+    psKv->u32Live += FMC_KV_REC_SIZE(u32Len);
+    return FMC_KV_OK;
+}
+
+/* Check the record at u32Addr against its CRC: 1 when committed, 0 when torn */
+static int32_t fmc_kv_check(FMC_KV_T *psKv, uint32_t u32Addr, uint32_t u32Key, uint32_t u32Info)
+{
+    uint32_t u32Len = u32Info & FMC_KV_INFO_LEN_Msk;
+    uint32_t u32CrcPos = FMC_KV_REC_SIZE(u32Len) - 12UL;
+    uint32_t u32Crc = fmc_kv_crc(fmc_kv_crc(0xFFFFFFFFUL, u32Key, 4UL), u32Info, 4UL);
+    uint32_t au32Data[2], u32Pos, i;
+
+    for(u32Pos = 0UL; u32Pos <= u32CrcPos; u32Pos += 8UL)
+    {
+        if(fmc_kv_read(psKv, u32Addr + 8UL + u32Pos, au32Data) != FMC_KV_OK)
+            return FMC_KV_ERR_FAIL;
+
+        for(i = 0UL; i < 2UL; i++)
+        {
+            if(u32Pos + i * 4UL == u32CrcPos)
+                return (au32Data[i] == ~u32Crc) ? 1L : 0L;
+            if(u32Pos + i * 4UL < u32Len)
+                u32Crc = fmc_kv_crc(u32Crc, au32Data[i], (u32Len - u32Pos - i * 4UL < 4UL) ? (u32Len - u32Pos - i * 4UL) : 4UL);
+        }
+    }
+    return 0L;
+}
+
+/* Replay the records of a page into the index; returns the offset of its first free byte */
+static int32_t fmc_kv_replay(FMC_KV_T *psKv, uint32_t u32Page)
+{
+    uint32_t u32PageAddr = fmc_kv_page_addr(psKv, u32Page);
+    uint32_t u32Offset = 8UL, u32Info, au32Hdr[2];
+    int32_t i32Ret;
+
+    while(u32Offset + FMC_KV_REC_SIZE(0) <= FMC_FLASH_PAGE_SIZE)
+    {
+        if(fmc_kv_read(psKv, u32PageAddr + u32Offset, au32Hdr) != FMC_KV_OK)
+            return FMC_KV_ERR_FAIL;
+
+        /* Records are programmed in order: an erased header ends the page */
+        if((au32Hdr[0] == 0xFFFFFFFFUL) && (au32Hdr[1] == 0xFFFFFFFFUL))
+            break;
+
+        /* A header torn while programmed hides where the next record starts: close the page */
+        u32Info = au32Hdr[1];
+        if(((u32Info >> 16) != (~u32Info & 0xFFFFUL)) || ((u32Info & FMC_KV_INFO_LEN_Msk) > FMC_KV_MAX_LEN) ||
+                (au32Hdr[0] == FMC_KV_KEY_NONE) ||
+                (u32Offset + FMC_KV_REC_SIZE(u32Info & FMC_KV_INFO_LEN_Msk) > FMC_FLASH_PAGE_SIZE))
+            return (int32_t)FMC_FLASH_PAGE_SIZE;
+
+        i32Ret = fmc_kv_check(psKv, u32PageAddr + u32Offset, au32Hdr[0], u32Info);
+        if(i32Ret < 0)
+            return i32Ret;
+
+        if(i32Ret == 0)
+        {
+            psKv->sStat.u32Dropped++;
+        }
+        else if(!(u32Info & FMC_KV_INFO_DELETED) ||
+                (psKv->psIndex[fmc_kv_slot(psKv, au32Hdr[0])].u16Flags & FMC_KV_ENTRY_USED))
+        {
+            /* A deletion with no older value left has nothing to hide */
+            i32Ret = fmc_kv_index(psKv, au32Hdr[0], u32PageAddr + u32Offset, u32Info);
+            if(i32Ret != FMC_KV_OK)
+                return i32Ret;
+        }
+
+        u32Offset += FMC_KV_REC_SIZE(u32Info & FMC_KV_INFO_LEN_Msk);
+    }
+    return (int32_t)u32Offset;
+}
+
+/* Open the erased page after the current one, then compact the oldest page into it and erase it */
+static int32_t fmc_kv_rotate(FMC_KV_T *psKv)
+{
+    uint32_t u32Next = (psKv->u32Page + 1UL) % psKv->u32Pages;
+    uint32_t u32OldAddr = fmc_kv_page_addr(psKv, (u32Next + 1UL) % psKv->u32Pages);
+    uint32_t u32Addr, u32Size, u32Seq, i, j, au32Data[2];
+    FMC_KV_ENTRY_T *psEntry;
+    int32_t i32Ret;
+
+    if(fmc_kv_program(psKv, fmc_kv_page_addr(psKv, u32Next), FMC_KV_PAGE_MAGIC, psKv->u32Seq + 1UL) != FMC_KV_OK)
+        return FMC_KV_ERR_FAIL;
+
+    psKv->u32Page = u32Next;
+    psKv->u32Seq++;
+    psKv->u32Offset = 8UL;
+    psKv->sStat.u32Rotations++;
+
+    /* Nothing to compact until the ring is full */
+    i32Ret = fmc_kv_page_seq(psKv, u32OldAddr, &u32Seq);
+    if(i32Ret <= 0)
+        return (i32Ret < 0) ? i32Ret : FMC_KV_OK;
+
+    /* The live records of a page always fit in an empty one */
+    for(i = 0UL; i < psKv->u32IndexSize;)
+    {
+        psEntry = &psKv->psIndex[i];
+        if(!(psEntry->u16Flags & FMC_KV_ENTRY_USED) || (psEntry->u32Addr - u32OldAddr >= FMC_FLASH_PAGE_SIZE))
+        {
+            i++;
+            continue;
+        }
+
+        /* No older record of the key is left to hide: drop the deletion. The slot is filled again. */
+        if(psEntry->u16Flags & FMC_KV_ENTRY_DELETED)
+        {
+            fmc_kv_remove(psKv, i);
+            continue;
+        }
+
+        u32Addr = fmc_kv_page_addr(psKv, psKv->u32Page) + psKv->u32Offset;
+        u32Size = FMC_KV_REC_SIZE(psEntry->u16Len);
+        for(j = 0UL; j < u32Size; j += 8UL)
+        {
+            if((fmc_kv_read(psKv, psEntry->u32Addr + j, au32Data) != FMC_KV_OK) ||
+                    (fmc_kv_program(psKv, u32Addr + j, au32Data[0], au32Data[1]) != FMC_KV_OK))
+                return FMC_KV_ERR_FAIL;
+        }
+
+        psEntry->u32Addr = u32Addr;
+        psKv->u32Offset += u32Size;
+        psKv->sStat.u32Copies++;
+        i++;
+    }
+
+    return fmc_kv_erase(psKv, u32OldAddr);
+}
+
+/* Append a record; returns its address in *pu32Addr */
+static int32_t fmc_kv_append(FMC_KV_T *psKv, uint32_t u32Key, uint32_t u32Info, const uint8_t *pu8Data, uint32_t *pu32Addr)
+{
+    uint32_t u32Len = u32Info & FMC_KV_INFO_LEN_Msk;
+    uint32_t u32Size = FMC_KV_REC_SIZE(u32Len);
+    uint32_t u32Crc = fmc_kv_crc(fmc_kv_crc(0xFFFFFFFFUL, u32Key, 4UL), u32Info, 4UL);
+    uint32_t u32Addr, u32Pos, au32Data[2], i;
+    int32_t i32Ret;
+
+    for(i = 0UL; psKv->u32Offset + u32Size > FMC_FLASH_PAGE_SIZE; i++)
+    {
+        if(i == psKv->u32Pages)
+            return FMC_KV_ERR_FULL;
+
+        i32Ret = fmc_kv_rotate(psKv);
+        if(i32Ret != FMC_KV_OK)
+            return i32Ret;
+    }
+
+    for(u32Pos = 0UL; u32Pos < u32Len; u32Pos += 4UL)
+        u32Crc = fmc_kv_crc(u32Crc, fmc_kv_word(pu8Data, u32Len, u32Pos), (u32Len - u32Pos < 4UL) ? (u32Len - u32Pos) : 4UL);
+
+    /* The space is taken even if a program fails: it is no longer erased */
+    u32Addr = fmc_kv_page_addr(psKv, psKv->u32Page) + psKv->u32Offset;
+    psKv->u32Offset += u32Size;
+    *pu32Addr = u32Addr;
+
+    if(fmc_kv_program(psKv, u32Addr, u32Key, u32Info) != FMC_KV_OK)
+        return FMC_KV_ERR_FAIL;
+
+    /* The double word holding the CRC, programmed last, commits the record */
+    for(u32Pos = 0UL; u32Pos < u32Size - 8UL; u32Pos += 8UL)
+    {
+        for(i = 0UL; i < 2UL; i++)
+            au32Data[i] = (u32Pos + i * 4UL == u32Size - 12UL) ? ~u32Crc : fmc_kv_word(pu8Data, u32Len, u32Pos + i * 4UL);
+
+        if(fmc_kv_program(psKv, u32Addr + 8UL + u32Pos, au32Data[0], au32Data[1]) != FMC_KV_OK)
+            return FMC_KV_ERR_FAIL;
+    }
+
+    return FMC_KV_OK;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
 /**
   * @brief Disable FMC ISP function.
   * @return None
@@ -1225,6 +1956,523 @@ int32_t FMC_RemapBank(uint32_t u32Bank)
 }
 
 
+
+/**
+  * @brief      Initialize a dual bank firmware update
+  * @param[in]  psUpd       Update state.
+  * @param[in]  u32SlotSize Bytes of each bank holding an image and its trailer page: a multiple of
+  *                         \ref FMC_FLASH_PAGE_SIZE, from two pages up to \ref FMC_BANK_SIZE.
+  *                         Both banks are laid out alike; the rest of a bank is left alone.
+  * @param[in]  pfnGetTime  Time source of the statistics, NULL to leave times at 0.
+  * @return     None
+  * @details    u32MapBase is set to \ref FMC_APROM_BASE; a host model may move it after this call.
+  *             FMC_UpdWrite() and FMC_UpdPoll() return \ref FMC_UPD_ERR_PARAM until FMC_UpdBegin().
+  */
+void FMC_UpdInit(FMC_UPD_T *psUpd, uint32_t u32SlotSize, uint32_t (*pfnGetTime)(void))
+{
+    memset(psUpd, 0, sizeof(FMC_UPD_T));
+    psUpd->u32SlotSize = u32SlotSize;
+    psUpd->u32MapBase = FMC_APROM_BASE;
+    psUpd->pfnGetTime = pfnGetTime;
+    psUpd->i32Result = FMC_UPD_ERR_PARAM;
+    psUpd->u32Phase = FMC_UPD_PH_DONE;
+}
+
+/**
+  * @brief      Read the trailer of the image in a bank
+  * @param[in]  psUpd       Update state, for the slot size.
+  * @param[in]  u32Bank     Physical bank, 0 or 1, whichever is mapped at \ref FMC_APROM_BASE.
+  * @param[out] psTrl       Trailer read.
+  * @retval     FMC_UPD_OK          The bank holds a committed image.
+  * @retval     FMC_UPD_ERR_FORMAT  No committed image.
+  * @retval     FMC_UPD_ERR_FAIL    ISP read time-out.
+  */
+int32_t FMC_UpdReadTrailer(FMC_UPD_T *psUpd, uint32_t u32Bank, FMC_UPD_TRAILER_T *psTrl)
+{
+    uint32_t *pu32Trl = (uint32_t *)psTrl;
+    uint32_t u32Addr = u32Bank * FMC_BANK_SIZE + fmc_upd_trailer_offset(psUpd);
+    uint32_t i;
+
+    for(i = 0UL; i < sizeof(FMC_UPD_TRAILER_T) / 4UL; i++)
+    {
+        pu32Trl[i] = FMC_Read(u32Addr + i * 4UL);
+        if(g_FMC_i32ErrCode != 0)
+            return FMC_UPD_ERR_FAIL;
+    }
+
+    if((psTrl->u32Magic != FMC_UPD_TRL_MAGIC) || (psTrl->u32Commit != FMC_UPD_TRL_COMMIT) ||
+            (psTrl->u32CommitSeq != ~psTrl->u32Seq) || (psTrl->u32Size > fmc_upd_trailer_offset(psUpd)))
+        return FMC_UPD_ERR_FORMAT;
+
+    return FMC_UPD_OK;
+}
+
+/**
+  * @brief      Start receiving a package into the inactive bank
+  * @param[in]  psUpd       Update state, set up by FMC_UpdInit().
+  * @retval     FMC_UPD_OK          Ready for FMC_UpdWrite().
+  * @retval     FMC_UPD_ERR_PARAM   Invalid slot size.
+  * @retval     FMC_UPD_ERR_FAIL    ISP read time-out.
+  * @details    Restarts any update in progress. The new image gets a sequence number above those
+  *             of both banks, so FMC_UpdBoot() prefers it once committed. Once the package header
+  *             is accepted, FMC_UpdPoll() erases the trailer of the inactive bank: from then on the
+  *             bank holds no image until the new one is committed.
+  */
+int32_t FMC_UpdBegin(FMC_UPD_T *psUpd)
+{
+    FMC_UPD_TRAILER_T sTrl;
+    uint32_t u32SlotSize = psUpd->u32SlotSize;
+    uint32_t u32MapBase = psUpd->u32MapBase;
+    uint32_t (*pfnGetTime)(void) = psUpd->pfnGetTime;
+    uint32_t u32Bank, u32Seq = 0UL;
+    int32_t i32Ret;
+
+    FMC_UpdInit(psUpd, u32SlotSize, pfnGetTime);
+    psUpd->u32MapBase = u32MapBase;
+
+    if((u32SlotSize < 2UL * FMC_FLASH_PAGE_SIZE) || (u32SlotSize > FMC_BANK_SIZE) || (u32SlotSize & (FMC_FLASH_PAGE_SIZE - 1UL)))
+        return FMC_UPD_ERR_PARAM;
+
+    psUpd->u32Bank = (FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos;
+    for(u32Bank = 0UL; u32Bank < 2UL; u32Bank++)
+    {
+        i32Ret = FMC_UpdReadTrailer(psUpd, u32Bank, &sTrl);
+        if(i32Ret == FMC_UPD_ERR_FAIL)
+            return i32Ret;
+        if((i32Ret == FMC_UPD_OK) && (sTrl.u32Seq > u32Seq))
+            u32Seq = sTrl.u32Seq;
+    }
+
+    psUpd->sTrl.u32Seq = u32Seq + 1UL;
+    psUpd->u32Phase = FMC_UPD_PH_TRAILER;
+    psUpd->i32Result = FMC_UPD_OK;
+    psUpd->u32StartTime = fmc_upd_time(psUpd);
+
+    return FMC_UPD_OK;
+}
+
+/**
+  * @brief      Pass package bytes to the update
+  * @param[in]  psUpd       Update state.
+  * @param[in]  pu8Data     Next bytes of the package, as received.
+  * @param[in]  u32Len      Number of bytes.
+  * @return     Bytes taken, fewer than u32Len when both page buffers wait for the flash: hand the
+  *             rest in again after FMC_UpdPoll(). A negative value is an error, kept until
+  *             FMC_UpdBegin(): \ref FMC_UPD_ERR_FORMAT, \ref FMC_UPD_ERR_BASE, \ref FMC_UPD_ERR_CRC,
+  *             \ref FMC_UPD_ERR_FAIL or \ref FMC_UPD_ERR_PARAM.
+  * @details    Splits the package into records in any chunking, checks each record against its
+  *             CRC-32 once its last byte is produced, and fills the page buffers. Never waits for
+  *             the flash, so it may run from the receive path of the transport.
+  */
+int32_t FMC_UpdWrite(FMC_UPD_T *psUpd, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    int32_t i32Ret;
+
+    if(psUpd->i32Result < 0)
+        return psUpd->i32Result;
+
+    i32Ret = fmc_upd_feed(psUpd, pu8Data, u32Len);
+    if(i32Ret < 0)
+    {
+        psUpd->i32Result = i32Ret;
+        return i32Ret;
+    }
+
+    psUpd->sStat.u32RxBytes += (uint32_t)i32Ret;
+    if((uint32_t)i32Ret < u32Len)
+        psUpd->sStat.u32Stalls++;
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Advance the flash side of the update
+  * @param[in]  psUpd       Update state.
+  * @retval     FMC_UPD_OK          All received data is in flash; waiting for more.
+  * @retval     FMC_UPD_BUSY        An ISP command or the hash is in progress.
+  * @retval     FMC_UPD_DONE        The image is verified and committed.
+  * @retval     <0                  The update failed, see FMC_UpdWrite(); kept until FMC_UpdBegin().
+  * @details    Each call issues at most one ISP command and returns without waiting for it:
+  *             it erases a page of the inactive bank when needed, programs the double words that
+  *             differ from the new image, and has the SHA engine read back each completed page.
+  *             After the last page the digest is compared with the package and the trailer is
+  *             programmed, its commit word last. Call it from the main loop or a periodic timer;
+  *             code keeps running from the active bank meanwhile.
+  */
+int32_t FMC_UpdPoll(FMC_UPD_T *psUpd)
+{
+    if((psUpd->i32Result < 0) || (psUpd->i32Result == FMC_UPD_DONE))
+        return psUpd->i32Result;
+
+    psUpd->i32Result = fmc_upd_step(psUpd);
+
+    return psUpd->i32Result;
+}
+
+/**
+  * @brief      Select the image to boot
+  * @param[in]  psUpd       Update state, set up by FMC_UpdInit().
+  * @return     Physical bank to run, or \ref FMC_UPD_ERR_FAIL on an ISP failure. u32BootState tells why.
+  * @details    The committed image with the highest sequence number is selected. On its first boot
+  *             its trailer is marked tried; an image found tried but not confirmed by FMC_UpdConfirm()
+  *             failed its trial, and the other committed image is selected instead. With no
+  *             committed image the bank running is kept.
+  *             The caller remaps when the bank returned is not the one running (ISPSTS.FBS):
+  *             FMC_RemapBank() and a CPU reset, from code both banks hold at the same address or
+  *             from SRAM. Selecting again after that returns the same bank, so the selection can
+  *             run at every boot whether or not the remap survived the reset.
+  */
+int32_t FMC_UpdBoot(FMC_UPD_T *psUpd)
+{
+    FMC_UPD_TRAILER_T asTrl[2];
+    uint32_t au32Valid[2];
+    uint32_t u32Start = fmc_upd_time(psUpd);
+    uint32_t u32Bank;
+    int32_t i32Ret;
+
+    psUpd->u32Bank = (FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos;
+    for(u32Bank = 0UL; u32Bank < 2UL; u32Bank++)
+    {
+        i32Ret = FMC_UpdReadTrailer(psUpd, u32Bank, &asTrl[u32Bank]);
+        if(i32Ret == FMC_UPD_ERR_FAIL)
+            return i32Ret;
+        au32Valid[u32Bank] = (i32Ret == FMC_UPD_OK) ? 1UL : 0UL;
+    }
+
+    if(!au32Valid[0] && !au32Valid[1])
+    {
+        psUpd->u32BootState = FMC_UPD_BOOT_NONE;
+        u32Bank = psUpd->u32Bank;
+    }
+    else
+    {
+        u32Bank = (!au32Valid[0] || (au32Valid[1] && (asTrl[1].u32Seq > asTrl[0].u32Seq))) ? 1UL : 0UL;
+
+        if(asTrl[u32Bank].u32Confirmed == FMC_UPD_TRL_CONFIRMED)
+        {
+            psUpd->u32BootState = FMC_UPD_BOOT_CONFIRMED;
+        }
+        else if(asTrl[u32Bank].u32Tried == FMC_UPD_TRL_TRIED)
+        {
+            /* Booted once and never confirmed: fall back, unless there is nothing to fall back to */
+            if(au32Valid[u32Bank ^ 1UL])
+            {
+                psUpd->u32BootState = FMC_UPD_BOOT_ROLLBACK;
+                u32Bank ^= 1UL;
+            }
+            else
+            {
+                psUpd->u32BootState = FMC_UPD_BOOT_TRIAL;
+            }
+        }
+        else
+        {
+            psUpd->u32BootState = FMC_UPD_BOOT_TRIAL;
+            if(FMC_Write8Bytes(u32Bank * FMC_BANK_SIZE + fmc_upd_trailer_offset(psUpd) + offsetof(FMC_UPD_TRAILER_T, u32Tried),
+                               FMC_UPD_TRL_TRIED, 0xFFFFFFFFUL) != 0)
+                return FMC_UPD_ERR_FAIL;
+        }
+    }
+
+    psUpd->sStat.u32BootTime = fmc_upd_time(psUpd) - u32Start;
+
+    return (int32_t)u32Bank;
+}
+
+/**
+  * @brief      Confirm the running image after its trial boot
+  * @param[in]  psUpd       Update state, set up by FMC_UpdInit().
+  * @retval     FMC_UPD_OK          Confirmed, now or before.
+  * @retval     FMC_UPD_ERR_PARAM   The running bank holds no committed image.
+  * @retval     FMC_UPD_ERR_FAIL    ISP failure.
+  * @details    Call once the new image has shown it works, e.g. after its self-test or its first
+  *             connection to the update server. The CPU stalls for one double word program.
+  */
+int32_t FMC_UpdConfirm(FMC_UPD_T *psUpd)
+{
+    FMC_UPD_TRAILER_T sTrl;
+    uint32_t u32Bank = (FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos;
+    int32_t i32Ret;
+
+    i32Ret = FMC_UpdReadTrailer(psUpd, u32Bank, &sTrl);
+    if(i32Ret != FMC_UPD_OK)
+        return (i32Ret == FMC_UPD_ERR_FAIL) ? i32Ret : FMC_UPD_ERR_PARAM;
+
+    if(sTrl.u32Confirmed == FMC_UPD_TRL_CONFIRMED)
+        return FMC_UPD_OK;
+
+    if(FMC_Write8Bytes(u32Bank * FMC_BANK_SIZE + fmc_upd_trailer_offset(psUpd) + offsetof(FMC_UPD_TRAILER_T, u32Confirmed),
+                       FMC_UPD_TRL_CONFIRMED, 0xFFFFFFFFUL) != 0)
+        return FMC_UPD_ERR_FAIL;
+
+    return FMC_UPD_OK;
+}
+
+/**
+  * @brief      Initialize a key-value store
+  * @param[in]  psKv         Store state.
+  * @param[in]  u32Base      Flash address of the region, \ref FMC_FLASH_PAGE_SIZE aligned.
+  * @param[in]  u32Pages     Pages of the region, at least 2. One is kept erased; the others hold up to
+  *                          (u32Pages - 1) * (\ref FMC_FLASH_PAGE_SIZE - 8 - record size) bytes of records.
+  * @param[in]  psIndex      RAM index, one entry per slot.
+  * @param[in]  u32IndexSize Index slots, a power of two: up to three quarters of them hold keys.
+  * @retval     FMC_KV_OK          Ready for FMC_KvMount().
+  * @retval     FMC_KV_ERR_PARAM   Invalid region or index.
+  */
+int32_t FMC_KvInit(FMC_KV_T *psKv, uint32_t u32Base, uint32_t u32Pages, FMC_KV_ENTRY_T *psIndex, uint32_t u32IndexSize)
+{
+    memset(psKv, 0, sizeof(FMC_KV_T));
+
+    if((u32Base & (FMC_FLASH_PAGE_SIZE - 1UL)) || (u32Pages < 2UL) || (psIndex == NULL) ||
+            (u32IndexSize < 4UL) || (u32IndexSize & (u32IndexSize - 1UL)))
+        return FMC_KV_ERR_PARAM;
+
+    psKv->u32Base = u32Base;
+    psKv->u32Pages = u32Pages;
+    psKv->psIndex = psIndex;
+    psKv->u32IndexSize = u32IndexSize;
+    return FMC_KV_OK;
+}
+
+/**
+  * @brief      Mount a key-value store: rebuild its index from flash
+  * @param[in]  psKv        Store state, set up by FMC_KvInit().
+  * @retval     FMC_KV_OK          Mounted.
+  * @retval     FMC_KV_ERR_PARAM   Not initialized.
+  * @retval     FMC_KV_ERR_FULL    More keys in flash than the index holds.
+  * @retval     FMC_KV_ERR_FAIL    ISP failure.
+  * @details    Call at every start, before any other call. Pages left neither valid nor erased by a
+  *             power failure are erased and records torn before their commit are skipped. A
+  *             compaction cut short is rolled back: the page it filled is erased and the oldest
+  *             page, still intact, is compacted again at the next rotation. An empty region is
+  *             formatted. The CPU stalls while the region is read, one ISP read per double word.
+  */
+int32_t FMC_KvMount(FMC_KV_T *psKv)
+{
+    uint32_t u32Page, u32Seq, u32Last, u32Next, u32NextSeq, i, au32Data[2];
+    int32_t i32Ret;
+
+    if(psKv->psIndex == NULL)
+        return FMC_KV_ERR_PARAM;
+
+    while(1)
+    {
+        memset(psKv->psIndex, 0, psKv->u32IndexSize * sizeof(FMC_KV_ENTRY_T));
+        psKv->u32Keys = 0UL;
+        psKv->u32Live = 0UL;
+        psKv->u32Offset = 0UL;
+
+        /* Erase the pages torn while erased or opened */
+        for(u32Page = 0UL; u32Page < psKv->u32Pages; u32Page++)
+        {
+            i32Ret = fmc_kv_page_seq(psKv, fmc_kv_page_addr(psKv, u32Page), &u32Seq);
+            if(i32Ret != 0)
+            {
+                if(i32Ret < 0)
+                    return i32Ret;
+                continue;
+            }
+
+            for(i = 0UL; i < FMC_FLASH_PAGE_SIZE; i += 8UL)
+            {
+                if(fmc_kv_read(psKv, fmc_kv_page_addr(psKv, u32Page) + i, au32Data) != FMC_KV_OK)
+                    return FMC_KV_ERR_FAIL;
+                if((au32Data[0] & au32Data[1]) != 0xFFFFFFFFUL)
+                {
+                    if(fmc_kv_erase(psKv, fmc_kv_page_addr(psKv, u32Page)) != FMC_KV_OK)
+                        return FMC_KV_ERR_FAIL;
+                    break;
+                }
+            }
+        }
+
+        /* Replay the valid pages, oldest first; the newest one is appended to */
+        for(u32Last = 0UL; ; u32Last = psKv->u32Seq)
+        {
+            u32Next = psKv->u32Pages;
+            u32NextSeq = 0xFFFFFFFFUL;
+            for(u32Page = 0UL; u32Page < psKv->u32Pages; u32Page++)
+            {
+                i32Ret = fmc_kv_page_seq(psKv, fmc_kv_page_addr(psKv, u32Page), &u32Seq);
+                if(i32Ret < 0)
+                    return i32Ret;
+                if((i32Ret > 0) && (u32Seq > u32Last) && (u32Seq < u32NextSeq))
+                {
+                    u32Next = u32Page;
+                    u32NextSeq = u32Seq;
+                }
+            }
+            if(u32Next == psKv->u32Pages)
+                break;
+
+            i32Ret = fmc_kv_replay(psKv, u32Next);
+            if(i32Ret < 0)
+                return i32Ret;
+
+            psKv->u32Page = u32Next;
+            psKv->u32Seq = u32NextSeq;
+            psKv->u32Offset = (uint32_t)i32Ret;
+        }
+
+        if(psKv->u32Offset == 0UL)
+        {
+            /* Empty region: every page is erased now */
+            if(fmc_kv_program(psKv, psKv->u32Base, FMC_KV_PAGE_MAGIC, 1UL) != FMC_KV_OK)
+                return FMC_KV_ERR_FAIL;
+            psKv->u32Page = 0UL;
+            psKv->u32Seq = 1UL;
+            psKv->u32Offset = 8UL;
+            return FMC_KV_OK;
+        }
+
+        /* The page after the newest one is the erased spare, unless a compaction was cut short */
+        i32Ret = fmc_kv_page_seq(psKv, fmc_kv_page_addr(psKv, (psKv->u32Page + 1UL) % psKv->u32Pages), &u32Seq);
+        if(i32Ret <= 0)
+            return i32Ret;
+
+        if(fmc_kv_erase(psKv, fmc_kv_page_addr(psKv, psKv->u32Page)) != FMC_KV_OK)
+            return FMC_KV_ERR_FAIL;
+    }
+}
+
+/**
+  * @brief      Read the value of a key
+  * @param[in]  psKv        Store state, mounted.
+  * @param[in]  u32Key      Key.
+  * @param[out] pvData      Value read, up to u32Size bytes.
+  * @param[in]  u32Size     Size of pvData.
+  * @retval     >=0                   Length of the value; only u32Size bytes are read if it is longer.
+  * @retval     FMC_KV_ERR_NOT_FOUND  No value for the key.
+  * @retval     FMC_KV_ERR_PARAM      Not mounted.
+  * @retval     FMC_KV_ERR_FAIL       ISP read time-out.
+  */
+int32_t FMC_KvGet(FMC_KV_T *psKv, uint32_t u32Key, void *pvData, uint32_t u32Size)
+{
+    FMC_KV_ENTRY_T *psEntry;
+    uint8_t *pu8Data = (uint8_t *)pvData;
+    uint32_t u32Len, u32Pos, i, au32Data[2];
+
+    if(psKv->u32Offset == 0UL)
+        return FMC_KV_ERR_PARAM;
+
+    psEntry = &psKv->psIndex[fmc_kv_slot(psKv, u32Key)];
+    if((psEntry->u16Flags & (FMC_KV_ENTRY_USED | FMC_KV_ENTRY_DELETED)) != FMC_KV_ENTRY_USED)
+        return FMC_KV_ERR_NOT_FOUND;
+
+    u32Len = (psEntry->u16Len < u32Size) ? psEntry->u16Len : u32Size;
+    for(u32Pos = 0UL; u32Pos < u32Len; u32Pos += 8UL)
+    {
+        if(fmc_kv_read(psKv, psEntry->u32Addr + 8UL + u32Pos, au32Data) != FMC_KV_OK)
+            return FMC_KV_ERR_FAIL;
+
+        for(i = 0UL; (i < 8UL) && (u32Pos + i < u32Len); i++)
+            pu8Data[u32Pos + i] = (uint8_t)(au32Data[i / 4UL] >> ((i % 4UL) * 8UL));
+    }
+
+    psKv->sStat.u32Gets++;
+    return (int32_t)psEntry->u16Len;
+}
+
+/**
+  * @brief      Store the value of a key
+  * @param[in]  psKv        Store state, mounted.
+  * @param[in]  u32Key      Key, any but \ref FMC_KV_KEY_NONE.
+  * @param[in]  pvData      Value.
+  * @param[in]  u32Len      Value length, up to \ref FMC_KV_MAX_LEN bytes, 0 for an empty value.
+  * @retval     FMC_KV_OK          Stored, or already stored: nothing is written then.
+  * @retval     FMC_KV_ERR_FULL    No room for the value, the previous one is kept.
+  * @retval     FMC_KV_ERR_PARAM   Invalid key or length, or not mounted.
+  * @retval     FMC_KV_ERR_FAIL    ISP failure.
+  * @details    Programs FMC_KV_REC_SIZE(u32Len) / 8 double words. When the page is full the next
+  *             one is opened and the oldest page is compacted and erased first. Once the call
+  *             returns the value survives a power failure; if the power fails before, the key
+  *             keeps its previous value.
+  */
+int32_t FMC_KvSet(FMC_KV_T *psKv, uint32_t u32Key, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    FMC_KV_ENTRY_T *psEntry;
+    uint32_t u32Live, u32Addr, u32Pos, au32Data[2];
+    int32_t i32Ret;
+
+    if((psKv->u32Offset == 0UL) || (u32Key == FMC_KV_KEY_NONE) || (u32Len > FMC_KV_MAX_LEN) ||
+            ((pvData == NULL) && (u32Len != 0UL)))
+        return FMC_KV_ERR_PARAM;
+
+    psEntry = &psKv->psIndex[fmc_kv_slot(psKv, u32Key)];
+    u32Live = psKv->u32Live + FMC_KV_REC_SIZE(u32Len);
+    if(psEntry->u16Flags & FMC_KV_ENTRY_USED)
+    {
+        u32Live -= FMC_KV_REC_SIZE(psEntry->u16Len);
+
+        /* Settings are often written back unchanged: compare before wearing the flash */
+        if(!(psEntry->u16Flags & FMC_KV_ENTRY_DELETED) && (psEntry->u16Len == u32Len))
+        {
+            for(u32Pos = 0UL; u32Pos < u32Len; u32Pos += 8UL)
+            {
+                if(fmc_kv_read(psKv, psEntry->u32Addr + 8UL + u32Pos, au32Data) != FMC_KV_OK)
+                    return FMC_KV_ERR_FAIL;
+                if((au32Data[0] != fmc_kv_word(pu8Data, u32Len, u32Pos)) ||
+                        ((u32Pos + 4UL < u32Len) && (au32Data[1] != fmc_kv_word(pu8Data, u32Len, u32Pos + 4UL))))
+                    break;
+            }
+            if(u32Pos >= u32Len)
+            {
+                psKv->sStat.u32Unchanged++;
+                return FMC_KV_OK;
+            }
+        }
+    }
+    else if((psKv->u32Keys + 1UL) * 4UL > psKv->u32IndexSize * 3UL)
+    {
+        return FMC_KV_ERR_FULL;
+    }
+
+    /* Enough room that compaction always frees a page for the record */
+    if(u32Live > (psKv->u32Pages - 1UL) * (FMC_FLASH_PAGE_SIZE - 8UL - FMC_KV_REC_SIZE(u32Len)))
+        return FMC_KV_ERR_FULL;
+
+    i32Ret = fmc_kv_append(psKv, u32Key, FMC_KV_INFO(u32Len), pu8Data, &u32Addr);
+    if(i32Ret != FMC_KV_OK)
+        return i32Ret;
+
+    psKv->sStat.u32Sets++;
+    return fmc_kv_index(psKv, u32Key, u32Addr, u32Len);
+}
+
+/**
+  * @brief      Delete a key
+  * @param[in]  psKv        Store state, mounted.
+  * @param[in]  u32Key      Key.
+  * @retval     FMC_KV_OK             Deleted.
+  * @retval     FMC_KV_ERR_NOT_FOUND  No value for the key.
+  * @retval     FMC_KV_ERR_PARAM      Not mounted.
+  * @retval     FMC_KV_ERR_FULL       No room for the deletion record.
+  * @retval     FMC_KV_ERR_FAIL       ISP failure.
+  * @details    Appends a deletion record of FMC_KV_REC_SIZE(0) bytes, dropped by the compaction of
+  *             its page.
+  */
+int32_t FMC_KvDelete(FMC_KV_T *psKv, uint32_t u32Key)
+{
+    FMC_KV_ENTRY_T *psEntry;
+    uint32_t u32Addr;
+    int32_t i32Ret;
+
+    if(psKv->u32Offset == 0UL)
+        return FMC_KV_ERR_PARAM;
+
+    psEntry = &psKv->psIndex[fmc_kv_slot(psKv, u32Key)];
+    if((psEntry->u16Flags & (FMC_KV_ENTRY_USED | FMC_KV_ENTRY_DELETED)) != FMC_KV_ENTRY_USED)
+        return FMC_KV_ERR_NOT_FOUND;
+
+    i32Ret = fmc_kv_append(psKv, u32Key, FMC_KV_INFO(FMC_KV_INFO_DELETED), NULL, &u32Addr);
+    if(i32Ret != FMC_KV_OK)
+        return i32Ret;
+
+    psKv->sStat.u32Sets++;
+    return fmc_kv_index(psKv, u32Key, u32Addr, FMC_KV_INFO_DELETED);
+}
+
 /*@}*/ /* end of group FMC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group FMC_Driver */
@@ -6,6 +6,7 @@
  * @copyright SPDX-License-Identifier: Apache-2.0
  * @copyright Copyright (C) 2020 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
+#include <string.h>
 #include "NuMicro.h"
 
 
@@ -19,6 +20,152 @@
 
 int32_t g_HBI_i32ErrCode = 0;       /*!< HBI global error code */
 
+/** @cond HIDDEN_SYMBOLS */
+
+static uint32_t hbi_heap_time(HBI_HEAP_T *psHeap)
+{
+    return (psHeap->pfnGetTime != NULL) ? psHeap->pfnGetTime() : 0UL;
+}
+
+static uint32_t hbi_heap_contains(HBI_HEAP_T *psHeap, uint32_t u32Addr)
+{
+    return ((u32Addr - psHeap->u32Base) < psHeap->u32Size) ? 1UL : 0UL;
+}
+
+static void hbi_heap_charge(HBI_HEAP_T *psHeap, uint32_t u32Size)
+{
+    psHeap->sStat.u32Allocs++;
+    psHeap->sStat.u32InUse += u32Size;
+    if(psHeap->sStat.u32InUse > psHeap->sStat.u32Peak)
+        psHeap->sStat.u32Peak = psHeap->sStat.u32InUse;
+}
+
+/* Time of a copy from HBI_HeapCopy() to now */
+static void hbi_heap_timed(HBI_HEAP_T *psHeap, uint32_t u32Dir, uint32_t u32Start)
+{
+    HBI_HEAP_COPY_STAT_T *psStat = &psHeap->sStat.asCopy[u32Dir];
+    uint32_t u32Time = hbi_heap_time(psHeap) - u32Start;
+
+    psStat->u32Timed++;
+    psStat->u32TotalTime += u32Time;
+    if(u32Time > psStat->u32MaxTime)
+        psStat->u32MaxTime = u32Time;
+}
+
+/* Time the tracked copies PDMA has completed; they complete in order */
+static void hbi_heap_retire(HBI_HEAP_T *psHeap)
+{
+    HBI_HEAP_PEND_T *psPend;
+
+    while(psHeap->u32PendCnt != 0UL)
+    {
+        psPend = &psHeap->asPend[psHeap->u32PendHead];
+        if(!PDMA_CopyIsDone(psHeap->psCopy, psPend->u32Fence))
+            break;
+
+        hbi_heap_timed(psHeap, psPend->u32Dir, psPend->u32Start);
+        psHeap->u32PendHead = (psHeap->u32PendHead + 1UL) % HBI_HEAP_PENDING;
+        psHeap->u32PendCnt--;
+    }
+}
+
+static void *hbi_heap_pool_alloc(HBI_HEAP_T *psHeap, HBI_HEAP_POOL_T *psPool)
+{
+    uint32_t i, u32Blk;
+
+    for(i = 0UL; psPool->au32Free[i] == 0UL; i++)
+        ;
+
+    u32Blk = (uint32_t)__CLZ(__RBIT(psPool->au32Free[i]));
+    psPool->au32Free[i] &= ~(1UL << u32Blk);
+    u32Blk += i * 32UL;
+
+    if(++psPool->u32Used > psPool->u32Peak)
+        psPool->u32Peak = psPool->u32Used;
+    hbi_heap_charge(psHeap, psPool->u32Size);
+
+    return (void *)(psPool->u32Base + u32Blk * psPool->u32Size);
+}
+
+/* Best fit over the free spans; the rest of the span stays free unless the span table is full */
+static void *hbi_heap_area_alloc(HBI_HEAP_T *psHeap, uint32_t u32Size)
+{
+    HBI_HEAP_SPAN_T *psSpan;
+    uint32_t i, u32Best = psHeap->u32Spans;
+
+    for(i = 0UL; i < psHeap->u32Spans; i++)
+    {
+        psSpan = &psHeap->asSpan[i];
+        if((psSpan->u32Used == 0UL) && (psSpan->u32Size >= u32Size) &&
+                ((u32Best == psHeap->u32Spans) || (psSpan->u32Size < psHeap->asSpan[u32Best].u32Size)))
+            u32Best = i;
+    }
+
+    if(u32Best == psHeap->u32Spans)
+        return NULL;
+
+    psSpan = &psHeap->asSpan[u32Best];
+    if((psSpan->u32Size > u32Size) && (psHeap->u32Spans < HBI_HEAP_MAX_SPANS))
+    {
+        memmove(psSpan + 2, psSpan + 1, (psHeap->u32Spans - u32Best - 1UL) * sizeof(HBI_HEAP_SPAN_T));
+        psSpan[1].u32Addr = psSpan->u32Addr + u32Size;
+        psSpan[1].u32Size = psSpan->u32Size - u32Size;
+        psSpan[1].u32Used = 0UL;
+        psSpan->u32Size = u32Size;
+        psHeap->u32Spans++;
+    }
+    psSpan->u32Used = 1UL;
+
+    psHeap->sStat.u32AreaInUse += psSpan->u32Size;
+    if(psHeap->sStat.u32AreaInUse > psHeap->sStat.u32AreaPeak)
+        psHeap->sStat.u32AreaPeak = psHeap->sStat.u32AreaInUse;
+    hbi_heap_charge(psHeap, psSpan->u32Size);
+
+    return (void *)psSpan->u32Addr;
+}
+
+static int32_t hbi_heap_area_free(HBI_HEAP_T *psHeap, uint32_t u32Addr)
+{
+    HBI_HEAP_SPAN_T *psSpan;
+    uint32_t u32Lo = 0UL, u32Hi = psHeap->u32Spans, i;
+
+    while(u32Lo < u32Hi)
+    {
+        i = (u32Lo + u32Hi) / 2UL;
+        if(psHeap->asSpan[i].u32Addr < u32Addr)
+            u32Lo = i + 1UL;
+        else
+            u32Hi = i;
+    }
+
+    i = u32Lo;
+    psSpan = &psHeap->asSpan[i];
+    if((i == psHeap->u32Spans) || (psSpan->u32Addr != u32Addr) || (psSpan->u32Used == 0UL))
+        return HBI_ERR_FAIL;
+
+    psSpan->u32Used = 0UL;
+    psHeap->sStat.u32AreaInUse -= psSpan->u32Size;
+    psHeap->sStat.u32InUse -= psSpan->u32Size;
+
+    /* Merge with the free neighbours */
+    if(((i + 1UL) < psHeap->u32Spans) && (psSpan[1].u32Used == 0UL))
+    {
+        psSpan->u32Size += psSpan[1].u32Size;
+        memmove(psSpan + 1, psSpan + 2, (psHeap->u32Spans - i - 2UL) * sizeof(HBI_HEAP_SPAN_T));
+        psHeap->u32Spans--;
+    }
+    if((i != 0UL) && (psSpan[-1].u32Used == 0UL))
+    {
+        psSpan[-1].u32Size += psSpan->u32Size;
+        memmove(psSpan, psSpan + 1, (psHeap->u32Spans - i - 1UL) * sizeof(HBI_HEAP_SPAN_T));
+        psHeap->u32Spans--;
+    }
+
+    return HBI_OK;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
 /** @addtogroup HBI_EXPORTED_FUNCTIONS HBI Exported Functions
   @{
 */
@@ -294,6 +441,286 @@ void HBI_Write4Byte(uint32_t u32Addr, uint32_t u32Data)
 }
 
 
+/**
+  * @brief      Initialize a heap over a memory-mapped HyperRAM region
+  * @param[in]  psHeap      Heap state.
+  * @param[in]  u32Base     Start of the region, e.g. \ref HYPER_RAM_MEM_MAP, a multiple of \ref HBI_HEAP_ALIGN.
+  * @param[in]  u32Size     Bytes of the region; a tail short of \ref HBI_HEAP_ALIGN is not used.
+  * @param[in]  psClass     Size classes in ascending block size, may be NULL when u32Classes is 0.
+  * @param[in]  u32Classes  Number of size classes, up to \ref HBI_HEAP_MAX_CLASSES.
+  * @retval     HBI_OK          Ready.
+  * @retval     HBI_ERR_FAIL    Invalid region or classes, or the classes do not fit the region.
+  * @details    The blocks of the classes are laid out from u32Base in class order, so each class
+  *             gets a contiguous pool; the rest of the region is the general area. Give frame
+  *             buffers, audio rings and codec work areas a class each, sized for the buffers that
+  *             are held at the same time, and leave the general area to the odd sizes.
+  *             psCopy and pfnGetTime may be set after this call; both are NULL.
+  *             HBI must have been set up for memory-mapped access.
+  */
+int32_t HBI_HeapInit(HBI_HEAP_T *psHeap, uint32_t u32Base, uint32_t u32Size, const HBI_HEAP_CLASS_T *psClass, uint32_t u32Classes)
+{
+    HBI_HEAP_POOL_T *psPool;
+    uint32_t i, j, u32Addr, u32End, u32BlkSize;
+
+    u32Size &= ~(HBI_HEAP_ALIGN - 1UL);
+    if((u32Base & (HBI_HEAP_ALIGN - 1UL)) || (u32Size == 0UL) || (u32Size > (0UL - u32Base)) ||
+            (u32Classes > HBI_HEAP_MAX_CLASSES) || ((psClass == NULL) && (u32Classes != 0UL)))
+        return HBI_ERR_FAIL;
+
+    memset(psHeap, 0, sizeof(HBI_HEAP_T));
+    psHeap->u32Base = u32Base;
+    psHeap->u32Size = u32Size;
+
+    u32Addr = u32Base;
+    u32End = u32Base + u32Size;
+    for(i = 0UL; i < u32Classes; i++)
+    {
+        psPool = &psHeap->asPool[i];
+        u32BlkSize = (psClass[i].u32Size + HBI_HEAP_ALIGN - 1UL) & ~(HBI_HEAP_ALIGN - 1UL);
+        if((u32BlkSize == 0UL) || (psClass[i].u32Count == 0UL) || (psClass[i].u32Count > HBI_HEAP_CLASS_BLOCKS) ||
+                ((i != 0UL) && (u32BlkSize <= psPool[-1].u32Size)) ||
+                (u32BlkSize > (u32End - u32Addr) / psClass[i].u32Count))
+            return HBI_ERR_FAIL;
+
+        psPool->u32Base = u32Addr;
+        psPool->u32Size = u32BlkSize;
+        psPool->u32Count = psClass[i].u32Count;
+        for(j = 0UL; j < psPool->u32Count; j++)
+            psPool->au32Free[j / 32UL] |= 1UL << (j % 32UL);
+
+        u32Addr += u32BlkSize * psPool->u32Count;
+    }
+    psHeap->u32Classes = u32Classes;
+
+    if(u32Addr != u32End)
+    {
+        psHeap->asSpan[0].u32Addr = u32Addr;
+        psHeap->asSpan[0].u32Size = u32End - u32Addr;
+        psHeap->u32Spans = 1UL;
+    }
+
+    return HBI_OK;
+}
+
+/**
+  * @brief      Allocate a block of HyperRAM
+  * @param[in]  psHeap      Heap.
+  * @param[in]  u32Size     Bytes needed.
+  * @return     Block aligned to \ref HBI_HEAP_ALIGN, NULL when u32Size is 0 or no block is free.
+  * @details    The block comes from the smallest class it fits. When every block of that class is
+  *             in use, or the request is larger than every class, it comes from the general area.
+  */
+void *HBI_HeapAlloc(HBI_HEAP_T *psHeap, uint32_t u32Size)
+{
+    HBI_HEAP_POOL_T *psPool;
+    void *pvBlock = NULL;
+    uint32_t i;
+
+    if((u32Size != 0UL) && (u32Size <= psHeap->u32Size))
+    {
+        u32Size = (u32Size + HBI_HEAP_ALIGN - 1UL) & ~(HBI_HEAP_ALIGN - 1UL);
+
+        for(i = 0UL; i < psHeap->u32Classes; i++)
+        {
+            psPool = &psHeap->asPool[i];
+            if(psPool->u32Size >= u32Size)
+            {
+                if(psPool->u32Used < psPool->u32Count)
+                    return hbi_heap_pool_alloc(psHeap, psPool);
+
+                psPool->u32Spills++;
+                break;
+            }
+        }
+
+        pvBlock = hbi_heap_area_alloc(psHeap, u32Size);
+    }
+
+    if(pvBlock == NULL)
+        psHeap->sStat.u32Fails++;
+
+    return pvBlock;
+}
+
+/**
+  * @brief      Free a block of HyperRAM
+  * @param[in]  psHeap      Heap.
+  * @param[in]  pvBlock     Block returned by HBI_HeapAlloc(), or NULL.
+  * @retval     HBI_OK          Freed, or pvBlock is NULL.
+  * @retval     HBI_ERR_FAIL    pvBlock is not an allocated block of the heap, e.g. freed before.
+  */
+int32_t HBI_HeapFree(HBI_HEAP_T *psHeap, void *pvBlock)
+{
+    HBI_HEAP_POOL_T *psPool;
+    uint32_t u32Addr = (uint32_t)pvBlock, u32Off, u32Blk, i;
+    int32_t i32Ret;
+
+    if(pvBlock == NULL)
+        return HBI_OK;
+
+    if(!hbi_heap_contains(psHeap, u32Addr))
+        return HBI_ERR_FAIL;
+
+    for(i = 0UL; i < psHeap->u32Classes; i++)
+    {
+        psPool = &psHeap->asPool[i];
+        u32Off = u32Addr - psPool->u32Base;
+        if(u32Off < psPool->u32Size * psPool->u32Count)
+        {
+            u32Blk = u32Off / psPool->u32Size;
+            if(((u32Off % psPool->u32Size) != 0UL) || (psPool->au32Free[u32Blk / 32UL] & (1UL << (u32Blk % 32UL))))
+                return HBI_ERR_FAIL;
+
+            psPool->au32Free[u32Blk / 32UL] |= 1UL << (u32Blk % 32UL);
+            psPool->u32Used--;
+            psHeap->sStat.u32InUse -= psPool->u32Size;
+            psHeap->sStat.u32Frees++;
+            return HBI_OK;
+        }
+    }
+
+    i32Ret = hbi_heap_area_free(psHeap, u32Addr);
+    if(i32Ret == HBI_OK)
+        psHeap->sStat.u32Frees++;
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Copy between SRAM and HyperRAM, or within either
+  * @param[in]  psHeap      Heap.
+  * @param[out] pvDst       Destination.
+  * @param[in]  pvSrc       Source.
+  * @param[in]  u32Len      Bytes to copy.
+  * @return     Fence for HBI_HeapCopyWait(); 0 when psCopy is NULL.
+  * @details    With psCopy set, the copy goes through PDMA_MemCopy(): the part from the copy
+  *             service threshold up is left to PDMA and may still be running on return, so
+  *             neither buffer may be touched before HBI_HeapCopyWait(). Otherwise the CPU copies
+  *             before returning. The time of each copy is taken from this call to the call of
+  *             HBI_HeapCopy() or HBI_HeapCopyWait() that sees it complete; wait for the copies
+  *             rather than poll them late when the latency figures matter.
+  */
+uint32_t HBI_HeapCopy(HBI_HEAP_T *psHeap, void *pvDst, const void *pvSrc, uint32_t u32Len)
+{
+    PDMA_COPY_T *psCopy = psHeap->psCopy;
+    HBI_HEAP_COPY_STAT_T *psStat;
+    HBI_HEAP_PEND_T *psPend;
+    uint32_t u32Dir, u32Start, u32DmaBytes, u32Fence;
+
+    if(hbi_heap_contains(psHeap, (uint32_t)pvDst))
+        u32Dir = hbi_heap_contains(psHeap, (uint32_t)pvSrc) ? HBI_HEAP_MOVE : HBI_HEAP_STORE;
+    else
+        u32Dir = hbi_heap_contains(psHeap, (uint32_t)pvSrc) ? HBI_HEAP_LOAD : HBI_HEAP_MOVE;
+
+    psStat = &psHeap->sStat.asCopy[u32Dir];
+    psStat->u32Copies++;
+    psStat->u32Bytes += u32Len;
+    u32Start = hbi_heap_time(psHeap);
+
+    if(psCopy == NULL)
+    {
+        memcpy(pvDst, pvSrc, u32Len);
+        hbi_heap_timed(psHeap, u32Dir, u32Start);
+        return 0UL;
+    }
+
+    hbi_heap_retire(psHeap);
+
+    u32DmaBytes = psCopy->u32DmaBytes;
+    u32Fence = PDMA_MemCopy(psCopy, pvDst, pvSrc, u32Len);
+    u32DmaBytes = psCopy->u32DmaBytes - u32DmaBytes;
+    psStat->u32DmaBytes += u32DmaBytes;
+
+    if(u32DmaBytes == 0UL)
+    {
+        hbi_heap_timed(psHeap, u32Dir, u32Start);
+    }
+    else
+    {
+        /* A PDMA slot was free for this copy, so the oldest tracked copy has completed */
+        if(psHeap->u32PendCnt == HBI_HEAP_PENDING)
+            hbi_heap_retire(psHeap);
+
+        psPend = &psHeap->asPend[(psHeap->u32PendHead + psHeap->u32PendCnt) % HBI_HEAP_PENDING];
+        psPend->u32Fence = u32Fence;
+        psPend->u32Start = u32Start;
+        psPend->u32Dir = u32Dir;
+        psHeap->u32PendCnt++;
+    }
+
+    return u32Fence;
+}
+
+/**
+  * @brief      Wait for HBI_HeapCopy() calls to complete
+  * @param[in]  psHeap      Heap.
+  * @param[in]  u32Fence    Fence returned by HBI_HeapCopy(); covers every earlier call as well.
+  * @retval     HBI_OK          Completed.
+  * @retval     HBI_ERR_FAIL    A PDMA transfer of the copy service failed since the last wait.
+  * @retval     HBI_ERR_TIMEOUT PDMA did not complete within one second.
+  */
+int32_t HBI_HeapCopyWait(HBI_HEAP_T *psHeap, uint32_t u32Fence)
+{
+    int32_t i32Err;
+
+    if(psHeap->psCopy == NULL)
+        return HBI_OK;
+
+    i32Err = PDMA_CopyWait(psHeap->psCopy, u32Fence);
+    hbi_heap_retire(psHeap);
+
+    if(i32Err == PDMA_COPY_TIMEOUT_ERR)
+        return HBI_ERR_TIMEOUT;
+
+    return (i32Err != 0) ? HBI_ERR_FAIL : HBI_OK;
+}
+
+/**
+  * @brief      Get the statistics of a heap
+  * @param[in]  psHeap      Heap.
+  * @param[out] psStat      Statistics; the per class figures are in psHeap->asPool.
+  * @return     None
+  */
+void HBI_HeapGetStat(HBI_HEAP_T *psHeap, HBI_HEAP_STAT_T *psStat)
+{
+    uint32_t i;
+
+    if(psHeap->psCopy != NULL)
+        hbi_heap_retire(psHeap);
+
+    *psStat = psHeap->sStat;
+    psStat->u32LargestFree = 0UL;
+    for(i = 0UL; i < psHeap->u32Spans; i++)
+    {
+        if((psHeap->asSpan[i].u32Used == 0UL) && (psHeap->asSpan[i].u32Size > psStat->u32LargestFree))
+            psStat->u32LargestFree = psHeap->asSpan[i].u32Size;
+    }
+}
+
+/**
+  * @brief      Clear the statistics of a heap
+  * @param[in]  psHeap      Heap.
+  * @return     None
+  * @details    The bytes in use are kept and the peaks restart from them. Copies still in flight
+  *             are not timed.
+  */
+void HBI_HeapClearStats(HBI_HEAP_T *psHeap)
+{
+    uint32_t i, u32InUse = psHeap->sStat.u32InUse, u32AreaInUse = psHeap->sStat.u32AreaInUse;
+
+    memset(&psHeap->sStat, 0, sizeof(psHeap->sStat));
+    psHeap->sStat.u32InUse = psHeap->sStat.u32Peak = u32InUse;
+    psHeap->sStat.u32AreaInUse = psHeap->sStat.u32AreaPeak = u32AreaInUse;
+    psHeap->u32PendCnt = 0UL;
+
+    for(i = 0UL; i < psHeap->u32Classes; i++)
+    {
+        psHeap->asPool[i].u32Peak = psHeap->asPool[i].u32Used;
+        psHeap->asPool[i].u32Spills = 0UL;
+    }
+}
+
+
 /*@}*/ /* end of group HBI_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group HBI_Driver */
@@ -6,6 +6,7 @@
  * SPDX-License-Identifier: Apache-2.0
  * @copyright (C) 2021 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
+#include <string.h>
 #include "NuMicro.h"
 
 
@@ -548,6 +549,860 @@ void PDMA_DisableInt(PDMA_T * pdma,uint32_t u32Ch, uint32_t u32Mask)
     }
 }
 
+/**
+ * @brief       Set the scatter-gather base for a block of descriptors
+ *
+ * @param[in]   pdma            The pointer of the specified PDMA module
+ * @param[in]   psDesc          First descriptor
+ * @param[in]   u32DescNum      Number of descriptors
+ * @param[in]   u32Mode         \ref PDMA_SCATBA_SET or \ref PDMA_SCATBA_SHARED
+ *
+ * @retval      0               The descriptors are addressable by NEXT offsets from SCATBA
+ * @retval      -1              The descriptors cross a 64 KB boundary, or lie outside the window of a shared SCATBA
+ *
+ * @details     SCATBA is one register for all channels and resets to the SRAM base, not to 0, so whether
+ *              another user already set it cannot be read back from it. The first user of the PDMA claims
+ *              it with \ref PDMA_SCATBA_SET; later users pass \ref PDMA_SCATBA_SHARED and keep their
+ *              descriptors in the same window.
+ */
+int32_t PDMA_SetScatterBase(PDMA_T *pdma, const DSCT_T *psDesc, uint32_t u32DescNum, uint32_t u32Mode)
+{
+    uint32_t u32Start = (uint32_t)psDesc;
+    uint32_t u32End = (uint32_t)&psDesc[u32DescNum] - 1UL;
+
+    if((u32DescNum == 0UL) || ((u32Start ^ u32End) & PDMA_SCATBA_SCATBA_Msk))
+        return -1;
+
+    if(u32Mode == PDMA_SCATBA_SET)
+        pdma->SCATBA = u32Start & PDMA_SCATBA_SCATBA_Msk;
+    else if((u32Start ^ pdma->SCATBA) & PDMA_SCATBA_SCATBA_Msk)
+        return -1;
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Channel Service                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define PDMA_SVC_CTL_MSK    (PDMA_DSCT_CTL_TXWIDTH_Msk | PDMA_DSCT_CTL_SAINC_Msk | PDMA_DSCT_CTL_DAINC_Msk | \
+                             PDMA_DSCT_CTL_TXTYPE_Msk | PDMA_DSCT_CTL_BURSIZE_Msk)
+
+static uint32_t PDMA_SvcNow(PDMA_SVC_T *psSvc)
+{
+    return (psSvc->pfnGetTime != NULL) ? psSvc->pfnGetTime() : 0UL;
+}
+
+/* Descriptor links, in free list and chain alike, are offsets from the SCATBA window as PDMA reads them */
+static DSCT_T *PDMA_SvcDescAt(PDMA_SVC_T *psSvc, uint32_t u32Offset)
+{
+    return (DSCT_T *)(psSvc->u32DescBase + u32Offset);
+}
+
+static uint32_t PDMA_SvcDescOffset(PDMA_SVC_T *psSvc, DSCT_T *psDesc)
+{
+    return (uint32_t)psDesc - psSvc->u32DescBase;
+}
+
+/**
+ * @brief       Take a chain of descriptors from the pool
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   psXfer          The transfer, u32SegCnt descriptors are taken
+ *
+ * @retval      0               psXfer->psDesc ~ psXfer->psDescLast hold the chain
+ * @retval      -1              Not enough free descriptors
+ *
+ * @details     The free list is linked through NEXT already, so the first u32SegCnt entries are the chain.
+ *              Call with interrupts disabled.
+ */
+static int32_t PDMA_SvcDescAlloc(PDMA_SVC_T *psSvc, PDMA_XFER_T *psXfer)
+{
+    DSCT_T *psDesc = psSvc->psDescFree;
+    uint32_t i;
+
+    if(psXfer->u32SegCnt > psSvc->u32DescFree)
+        return -1;
+
+    for(i = 1UL; i < psXfer->u32SegCnt; i++)
+        psDesc = PDMA_SvcDescAt(psSvc, psDesc->NEXT);
+
+    psXfer->psDesc = psSvc->psDescFree;
+    psXfer->psDescLast = psDesc;
+    psSvc->u32DescFree -= psXfer->u32SegCnt;
+    psSvc->psDescFree = (psSvc->u32DescFree != 0UL) ? PDMA_SvcDescAt(psSvc, psDesc->NEXT) : NULL;
+
+    if(psSvc->u32DescFree < psSvc->u32DescMinFree)
+        psSvc->u32DescMinFree = psSvc->u32DescFree;
+
+    return 0;
+}
+
+/* Return the chain of a finished transfer to the pool. Call with interrupts disabled. */
+static void PDMA_SvcDescFree(PDMA_SVC_T *psSvc, PDMA_XFER_T *psXfer)
+{
+    if(psSvc->psDescFree != NULL)
+        psXfer->psDescLast->NEXT = PDMA_SvcDescOffset(psSvc, psSvc->psDescFree);
+
+    psSvc->psDescFree = psXfer->psDesc;
+    psSvc->u32DescFree += psXfer->u32SegCnt;
+    psXfer->psDesc = NULL;
+    psXfer->psDescLast = NULL;
+}
+
+/* Load the channel with the head transfer of its queue and start it */
+static void PDMA_SvcStart(PDMA_SVC_T *psSvc, uint32_t u32Ch, PDMA_XFER_T *psXfer)
+{
+    PDMA_T *pdma = psSvc->pdma;
+
+    psSvc->asCh[u32Ch].u32RunTime = PDMA_SvcNow(psSvc);
+
+    if(psXfer->u32StrideCnt)
+        PDMA_SetStride(pdma, u32Ch, psXfer->u32StrideLen >> 16, psXfer->u32StrideLen & 0xFFFFUL, psXfer->u32StrideCnt);
+
+    if(psXfer->u32RepeatCnt)
+        PDMA_SetRepeat(pdma, u32Ch, psXfer->u32RepeatInterval >> 16, psXfer->u32RepeatInterval & 0xFFFFUL, psXfer->u32RepeatCnt);
+
+    PDMA_SetTransferMode(pdma, u32Ch, psXfer->u32Peripheral, 1UL, (uint32_t)psXfer->psDesc);
+    PDMA_Trigger(pdma, u32Ch);
+}
+
+/**
+ * @brief       Initialize the channel service of a PDMA controller
+ *
+ * @param[out]  psSvc           The pointer of the channel service state
+ * @param[in]   pdma            The pointer of the specified PDMA module
+ * @param[in]   psDescPool      Scatter-gather descriptors owned by the service
+ * @param[in]   u32DescNum      Number of descriptors in psDescPool
+ * @param[in]   u32ScatMode     \ref PDMA_SCATBA_SET to point SCATBA at the pool, or \ref PDMA_SCATBA_SHARED
+ *                              when another user of the PDMA already did
+ * @param[in]   u32ReservedMask Channels programmed directly by the application, never allocated
+ * @param[in]   pfnGetTime      Time source of the statistics, NULL if not needed
+ *
+ * @retval      0                   Success
+ * @retval      PDMA_SVC_PARAM_ERR  Empty pool, a pool across a 64 KB boundary, or with \ref PDMA_SCATBA_SHARED
+ *                                  a pool outside the window of SCATBA
+ *
+ * @details     The pool must stay in SRAM inside one 64 KB window, see PDMA_SetScatterBase(). The application
+ *              enables the PDMA clock and the PDMA interrupt in NVIC, and calls PDMA_SvcIRQHandler() from
+ *              PDMAn_IRQHandler().
+ */
+int32_t PDMA_SvcInit(PDMA_SVC_T *psSvc, PDMA_T *pdma, DSCT_T *psDescPool, uint32_t u32DescNum, uint32_t u32ScatMode, uint32_t u32ReservedMask, uint32_t (*pfnGetTime)(void))
+{
+    uint32_t i;
+
+    if(((uint32_t)psDescPool & 0x3UL) || (PDMA_SetScatterBase(pdma, psDescPool, u32DescNum, u32ScatMode) != 0))
+        return PDMA_SVC_PARAM_ERR;
+
+    memset(psSvc, 0, sizeof(PDMA_SVC_T));
+    psSvc->pdma = pdma;
+    psSvc->u32ChReserved = u32ReservedMask & PDMA_CHCTL_CHENn_Msk;
+    psSvc->u32DescBase = pdma->SCATBA & PDMA_SCATBA_SCATBA_Msk;
+    psSvc->pfnGetTime = pfnGetTime;
+
+    for(i = 0UL; i < u32DescNum; i++)
+        psDescPool[i].NEXT = (i + 1UL < u32DescNum) ? PDMA_SvcDescOffset(psSvc, &psDescPool[i + 1UL]) : 0UL;
+
+    psSvc->psDescFree = psDescPool;
+    psSvc->u32DescNum = u32DescNum;
+    psSvc->u32DescFree = u32DescNum;
+    psSvc->u32DescMinFree = u32DescNum;
+
+    return 0;
+}
+
+/**
+ * @brief       Allocate a PDMA channel
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   u32Flags        Required capability. Valid values are
+ *                - \ref PDMA_SVC_CH_ANY
+ *                - \ref PDMA_SVC_CH_STRIDE
+ *                - \ref PDMA_SVC_CH_REPEAT
+ *              optionally ORed with \ref PDMA_SVC_CH_DIRECT
+ *
+ * @return      Channel number, or PDMA_SVC_NOCH_ERR
+ *
+ * @details     The highest free channel that has the capability is taken, so the few channels with
+ *              stride and repeat registers are handed out last. The channel is enabled with its transfer
+ *              done interrupt, and may serve any number of request sources one transfer after another.
+ *              A \ref PDMA_SVC_CH_DIRECT channel is programmed by its owner instead of PDMA_SvcSubmit():
+ *              PDMA_SvcIRQHandler() leaves its TDSTS and ABTSTS flags to the owner's own handler.
+ */
+int32_t PDMA_SvcAllocCh(PDMA_SVC_T *psSvc, uint32_t u32Flags)
+{
+    PDMA_T *pdma = psSvc->pdma;
+    uint32_t u32PriMask, u32Free;
+    int32_t i32Ch;
+
+    if(u32Flags & PDMA_SVC_CH_REPEAT)
+        u32Free = (1UL << PDMA_SVC_REPEAT_CH_MAX) - 1UL;
+    else if(u32Flags & PDMA_SVC_CH_STRIDE)
+        u32Free = (1UL << PDMA_SVC_STRIDE_CH_MAX) - 1UL;
+    else
+        u32Free = PDMA_CHCTL_CHENn_Msk;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    u32Free &= ~(psSvc->u32ChUsed | psSvc->u32ChReserved);
+
+    for(i32Ch = (int32_t)PDMA_CH_MAX - 1; i32Ch >= 0; i32Ch--)
+    {
+        if(u32Free & (1UL << i32Ch))
+            break;
+    }
+
+    if(i32Ch >= 0)
+    {
+        psSvc->u32ChUsed |= (1UL << i32Ch);
+        if(u32Flags & PDMA_SVC_CH_DIRECT)
+            psSvc->u32ChDirect |= (1UL << i32Ch);
+        memset(&psSvc->asCh[i32Ch], 0, sizeof(PDMA_SVC_CH_T));
+        psSvc->asCh[i32Ch].sStat.u32StartTime = PDMA_SvcNow(psSvc);
+
+        pdma->DSCT[i32Ch].CTL = 0UL;
+        pdma->TDSTS = (1UL << i32Ch);
+        pdma->ABTSTS = (1UL << i32Ch);
+        pdma->INTEN |= (1UL << i32Ch);
+        pdma->CHCTL |= (1UL << i32Ch);
+    }
+
+    __set_PRIMASK(u32PriMask);
+
+    return (i32Ch >= 0) ? i32Ch : PDMA_SVC_NOCH_ERR;
+}
+
+/**
+ * @brief       Free a PDMA channel
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   u32Ch           Channel returned by PDMA_SvcAllocCh()
+ *
+ * @retval      0                   Success
+ * @retval      PDMA_SVC_PARAM_ERR  The channel is not allocated
+ *
+ * @details     The channel is stopped. Transfers still queued are completed with PDMA_SVC_CANCEL_ERR.
+ */
+int32_t PDMA_SvcFreeCh(PDMA_SVC_T *psSvc, uint32_t u32Ch)
+{
+    PDMA_T *pdma = psSvc->pdma;
+    PDMA_XFER_T *psXfer, *psNext;
+    uint32_t u32PriMask;
+
+    if((u32Ch >= PDMA_CH_MAX) || !(psSvc->u32ChUsed & (1UL << u32Ch)))
+        return PDMA_SVC_PARAM_ERR;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    pdma->INTEN &= ~(1UL << u32Ch);
+    pdma->CHCTL &= ~(1UL << u32Ch);
+    PDMA_RESET(pdma, u32Ch);
+    pdma->TDSTS = (1UL << u32Ch);
+    pdma->ABTSTS = (1UL << u32Ch);
+
+    psXfer = psSvc->asCh[u32Ch].psHead;
+
+    for(psNext = psXfer; psNext != NULL; psNext = psNext->psNext)
+        PDMA_SvcDescFree(psSvc, psNext);
+
+    psSvc->asCh[u32Ch].psHead = NULL;
+    psSvc->asCh[u32Ch].psTail = NULL;
+    psSvc->asCh[u32Ch].u32Depth = 0UL;
+    psSvc->u32ChUsed &= ~(1UL << u32Ch);
+    psSvc->u32ChDirect &= ~(1UL << u32Ch);
+
+    __set_PRIMASK(u32PriMask);
+
+    for(; psXfer != NULL; psXfer = psNext)
+    {
+        psNext = psXfer->psNext;
+        psXfer->i32Status = PDMA_SVC_CANCEL_ERR;
+
+        if(psXfer->pfnDone != NULL)
+            psXfer->pfnDone(psXfer, PDMA_SVC_CANCEL_ERR);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Prepare a chained transfer
+ *
+ * @param[out]  psXfer          The pointer of the transfer
+ * @param[in]   psSeg           Segments, must stay valid until PDMA_SvcSubmit() returns
+ * @param[in]   u32SegCnt       Number of segments
+ * @param[in]   u32Peripheral   Request source, e.g. \ref PDMA_MEM
+ * @param[in]   u32Ctl          Transfer width, address control, request type and burst size, e.g.
+ *                              (PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_FIX | PDMA_REQ_SINGLE | PDMA_BURST_1)
+ * @param[in]   pfnDone         Completion callback, may be NULL
+ * @param[in]   pvArg           Caller context, kept in psXfer->pvArg
+ *
+ * @return      None
+ *
+ * @details     Stride and repeat are cleared; see PDMA_SvcSetStride() and PDMA_SvcSetRepeat().
+ */
+void PDMA_SvcInitXfer(PDMA_XFER_T *psXfer, const PDMA_SEG_T *psSeg, uint32_t u32SegCnt, uint32_t u32Peripheral, uint32_t u32Ctl, PDMA_XFER_CB_T pfnDone, void *pvArg)
+{
+    memset(psXfer, 0, sizeof(PDMA_XFER_T));
+    psXfer->psSeg = psSeg;
+    psXfer->u32SegCnt = u32SegCnt;
+    psXfer->u32Peripheral = u32Peripheral;
+    psXfer->u32Ctl = u32Ctl;
+    psXfer->pfnDone = pfnDone;
+    psXfer->pvArg = pvArg;
+}
+
+/**
+ * @brief       Add stride to a transfer
+ *
+ * @param[in]   psXfer          The pointer of the transfer
+ * @param[in]   u32DestLen      Destination stride count
+ * @param[in]   u32SrcLen       Source stride count
+ * @param[in]   u32TransCount   Transfer count per stride, 0 to remove the stride
+ *
+ * @return      None
+ *
+ * @details     The values are programmed with PDMA_SetStride() when the transfer starts and apply to
+ *              every segment. The transfer can only run on a channel allocated with PDMA_SVC_CH_STRIDE.
+ */
+void PDMA_SvcSetStride(PDMA_XFER_T *psXfer, uint32_t u32DestLen, uint32_t u32SrcLen, uint32_t u32TransCount)
+{
+    psXfer->u32StrideLen = (u32DestLen << 16) | (u32SrcLen & 0xFFFFUL);
+    psXfer->u32StrideCnt = u32TransCount;
+}
+
+/**
+ * @brief       Add repeat to a transfer
+ *
+ * @param[in]   psXfer          The pointer of the transfer
+ * @param[in]   u32DestInterval Destination address interval count
+ * @param[in]   u32SrcInterval  Source address interval count
+ * @param[in]   u32RepeatCount  Repeat count, 0 to remove the repeat
+ *
+ * @return      None
+ *
+ * @details     The values are programmed with PDMA_SetRepeat() when the transfer starts. The transfer can
+ *              only run on a channel allocated with PDMA_SVC_CH_REPEAT.
+ */
+void PDMA_SvcSetRepeat(PDMA_XFER_T *psXfer, uint32_t u32DestInterval, uint32_t u32SrcInterval, uint32_t u32RepeatCount)
+{
+    psXfer->u32RepeatInterval = (u32DestInterval << 16) | (u32SrcInterval & 0xFFFFUL);
+    psXfer->u32RepeatCnt = u32RepeatCount;
+}
+
+/**
+ * @brief       Queue a transfer on a channel
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   u32Ch           Channel returned by PDMA_SvcAllocCh()
+ * @param[in]   psXfer          The transfer, owned by the service until its callback
+ *
+ * @retval      0                   Queued; started at once when the channel was idle
+ * @retval      PDMA_SVC_PARAM_ERR  Channel not allocated or direct, invalid transfer, or stride/repeat on a channel without it
+ * @retval      PDMA_SVC_NODESC_ERR Not enough free descriptors, nothing was queued
+ *
+ * @details     Every segment gets one descriptor. All but the last are scatter-gather tables with their table
+ *              interrupt disabled, so PDMA runs the whole chain without software and interrupts once at the end.
+ *              Transfers on one channel run in submit order; each is started from PDMA_SvcIRQHandler() when
+ *              the previous one completes. May be called from the completion callback.
+ */
+int32_t PDMA_SvcSubmit(PDMA_SVC_T *psSvc, uint32_t u32Ch, PDMA_XFER_T *psXfer)
+{
+    PDMA_SVC_CH_T *psCh;
+    DSCT_T *psDesc;
+    uint32_t u32PriMask, u32Width, u32Ctl, i;
+    int32_t i32Ret;
+
+    if((u32Ch >= PDMA_CH_MAX) || !(psSvc->u32ChUsed & (1UL << u32Ch)) || (psSvc->u32ChDirect & (1UL << u32Ch)) ||
+            (psXfer->u32SegCnt == 0UL) || (psXfer->u32Peripheral > 0x7FUL) || (psXfer->u32Ctl & ~PDMA_SVC_CTL_MSK) ||
+            (psXfer->u32StrideCnt && (u32Ch >= PDMA_SVC_STRIDE_CH_MAX)) ||
+            (psXfer->u32RepeatCnt && (u32Ch >= PDMA_SVC_REPEAT_CH_MAX)))
+        return PDMA_SVC_PARAM_ERR;
+
+    u32Width = 1UL << ((psXfer->u32Ctl & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+    psXfer->u32Bytes = 0UL;
+
+    for(i = 0UL; i < psXfer->u32SegCnt; i++)
+    {
+        if((psXfer->psSeg[i].u32TransCount == 0UL) ||
+                (psXfer->psSeg[i].u32TransCount > (PDMA_DSCT_CTL_TXCNT_Msk >> PDMA_DSCT_CTL_TXCNT_Pos) + 1UL))
+            return PDMA_SVC_PARAM_ERR;
+
+        psXfer->u32Bytes += psXfer->psSeg[i].u32TransCount * u32Width;
+    }
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    i32Ret = PDMA_SvcDescAlloc(psSvc, psXfer);
+
+    if(i32Ret != 0)
+        psSvc->u32DescFails++;
+
+    __set_PRIMASK(u32PriMask);
+
+    if(i32Ret != 0)
+        return PDMA_SVC_NODESC_ERR;
+
+    /* The chain is private to this transfer until it is queued */
+    u32Ctl = psXfer->u32Ctl | ((psXfer->u32StrideCnt || psXfer->u32RepeatCnt) ? PDMA_DSCT_CTL_STRIDEEN_Msk : 0UL);
+    psDesc = psXfer->psDesc;
+
+    for(i = 0UL; i < psXfer->u32SegCnt; i++)
+    {
+        psDesc->SA = psXfer->psSeg[i].u32SrcAddr;
+        psDesc->DA = psXfer->psSeg[i].u32DstAddr;
+
+        if(i + 1UL < psXfer->u32SegCnt)
+        {
+            psDesc->CTL = ((psXfer->psSeg[i].u32TransCount - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | u32Ctl |
+                          PDMA_TBINTDIS_DISABLE | PDMA_OP_SCATTER;
+            psDesc = PDMA_SvcDescAt(psSvc, psDesc->NEXT);
+        }
+        else
+        {
+            psDesc->CTL = ((psXfer->psSeg[i].u32TransCount - 1UL) << PDMA_DSCT_CTL_TXCNT_Pos) | u32Ctl |
+                          PDMA_TBINTDIS_ENABLE | PDMA_OP_BASIC;
+            psDesc->NEXT = 0UL;
+        }
+    }
+
+    psXfer->psNext = NULL;
+    psXfer->i32Status = PDMA_SVC_PENDING;
+    psXfer->u32SubmitTime = PDMA_SvcNow(psSvc);
+    psCh = &psSvc->asCh[u32Ch];
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    if(psCh->psHead == NULL)
+    {
+        psCh->psHead = psXfer;
+        psCh->psTail = psXfer;
+        PDMA_SvcStart(psSvc, u32Ch, psXfer);
+    }
+    else
+    {
+        psCh->psTail->psNext = psXfer;
+        psCh->psTail = psXfer;
+    }
+
+    if(++psCh->u32Depth > psCh->sStat.u32MaxDepth)
+        psCh->sStat.u32MaxDepth = psCh->u32Depth;
+
+    __set_PRIMASK(u32PriMask);
+
+    return 0;
+}
+
+/**
+ * @brief       Channel service part of the PDMA interrupt handler
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ *
+ * @return      None
+ *
+ * @details     Call it from PDMAn_IRQHandler(). For every service channel that finished or hit a target abort,
+ *              the descriptors go back to the pool, the next queued transfer is started, and only then the
+ *              callback of the finished one is called, so the channel does not wait for the callback.
+ *              Flags of channels outside the service, and of \ref PDMA_SVC_CH_DIRECT channels, are left to the
+ *              application.
+ */
+void PDMA_SvcIRQHandler(PDMA_SVC_T *psSvc)
+{
+    PDMA_T *pdma = psSvc->pdma;
+    uint32_t u32Mask = psSvc->u32ChUsed & ~psSvc->u32ChDirect;
+    uint32_t u32Abort, u32Done, u32Pend, u32Ch, u32Now, u32Latency;
+    PDMA_SVC_CH_T *psCh;
+    PDMA_XFER_T *psXfer;
+    int32_t i32Status;
+
+    TRACE_ENTER(PDMA, TRACE_PDMA_SVC_IRQ, 0);
+
+    u32Abort = pdma->ABTSTS & u32Mask;
+    u32Done = pdma->TDSTS & u32Mask;
+
+    if(u32Abort)
+        pdma->ABTSTS = u32Abort;
+
+    if(u32Done)
+        pdma->TDSTS = u32Done;
+
+    for(u32Pend = u32Abort | u32Done; u32Pend; u32Pend &= (u32Pend - 1UL))
+    {
+        u32Ch = (uint32_t)__CLZ(__RBIT(u32Pend));
+        psCh = &psSvc->asCh[u32Ch];
+        psXfer = psCh->psHead;
+
+        if(psXfer == NULL)
+            continue;
+
+        if(u32Abort & (1UL << u32Ch))
+        {
+            /* The channel stops on an abort; reset it so the next transfer starts clean */
+            PDMA_RESET(pdma, u32Ch);
+            pdma->CHCTL |= (1UL << u32Ch);
+            i32Status = PDMA_SVC_ABORT_ERR;
+            psCh->sStat.u32Errors++;
+        }
+        else
+        {
+            i32Status = 0;
+            psCh->sStat.u32Xfers++;
+            psCh->sStat.u32Bytes += psXfer->u32Bytes;
+        }
+
+        u32Now = PDMA_SvcNow(psSvc);
+        psCh->sStat.u32BusyTime += u32Now - psCh->u32RunTime;
+        u32Latency = u32Now - psXfer->u32SubmitTime;
+
+        if(u32Latency > psCh->sStat.u32MaxLatency)
+            psCh->sStat.u32MaxLatency = u32Latency;
+
+        PDMA_SvcDescFree(psSvc, psXfer);
+        psCh->psHead = psXfer->psNext;
+        psCh->u32Depth--;
+
+        if(psCh->psHead != NULL)
+            PDMA_SvcStart(psSvc, u32Ch, psCh->psHead);
+        else
+            psCh->psTail = NULL;
+
+        psXfer->psNext = NULL;
+        psXfer->i32Status = i32Status;
+
+        if(psXfer->pfnDone != NULL)
+        {
+            TRACE_ENTER(PDMA, TRACE_PDMA_XFER_DONE, u32Ch);
+            psXfer->pfnDone(psXfer, i32Status);
+            TRACE_EXIT(PDMA, TRACE_PDMA_XFER_DONE, u32Ch);
+        }
+    }
+
+    TRACE_EXIT(PDMA, TRACE_PDMA_SVC_IRQ, u32Abort | u32Done);
+}
+
+/**
+ * @brief       Get channel utilization
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   u32Ch           The selected channel
+ *
+ * @return      Share of time the channel had a transfer running since its statistics were cleared, in 1/1000
+ *
+ * @details     The running transfer counts up to now. Needs the pfnGetTime of PDMA_SvcInit().
+ */
+uint32_t PDMA_SvcGetLoad(PDMA_SVC_T *psSvc, uint32_t u32Ch)
+{
+    PDMA_SVC_CH_T *psCh = &psSvc->asCh[u32Ch];
+    uint32_t u32PriMask, u32Now, u32Busy, u32Elapsed;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    u32Now = PDMA_SvcNow(psSvc);
+    u32Busy = psCh->sStat.u32BusyTime + ((psCh->psHead != NULL) ? (u32Now - psCh->u32RunTime) : 0UL);
+    u32Elapsed = u32Now - psCh->sStat.u32StartTime;
+    __set_PRIMASK(u32PriMask);
+
+    return (u32Elapsed != 0UL) ? (uint32_t)(((uint64_t)u32Busy * 1000ULL) / u32Elapsed) : 0UL;
+}
+
+/**
+ * @brief       Clear channel statistics
+ *
+ * @param[in]   psSvc           The pointer of the channel service
+ * @param[in]   u32Ch           The selected channel
+ *
+ * @return      None
+ *
+ * @details     The queue depth high-water mark restarts from the current depth.
+ */
+void PDMA_SvcClearStats(PDMA_SVC_T *psSvc, uint32_t u32Ch)
+{
+    PDMA_SVC_CH_T *psCh = &psSvc->asCh[u32Ch];
+    uint32_t u32PriMask;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    memset(&psCh->sStat, 0, sizeof(PDMA_SVC_STAT_T));
+    psCh->sStat.u32StartTime = PDMA_SvcNow(psSvc);
+    psCh->sStat.u32MaxDepth = psCh->u32Depth;
+    psCh->u32RunTime = psCh->sStat.u32StartTime;
+    __set_PRIMASK(u32PriMask);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Memory Copy Service                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+static void PDMA_CopyDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    PDMA_COPY_T *psCopy = (PDMA_COPY_T *)psXfer->pvArg;
+
+    if((i32Status != 0) && (psCopy->i32Error == 0))
+        psCopy->i32Error = i32Status;
+
+    psCopy->u32Completed++;
+}
+
+/**
+ * @brief       Queue one PDMA operation of a copy service
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   u32Dst          Destination address, aligned to the width
+ * @param[in]   u32Src          Source address, aligned to the width; ignored for a fill
+ * @param[in]   u32Sar          \ref PDMA_SAR_INC for a copy, \ref PDMA_SAR_FIX for a fill from the pattern word of the slot
+ * @param[in]   u32Pattern      Pattern word of a fill
+ * @param[in]   u32Len          Bytes, a multiple of the width
+ * @param[in]   u32Width        \ref PDMA_WIDTH_16 or \ref PDMA_WIDTH_32
+ *
+ * @retval      0                       Queued; u32Issued is its fence
+ * @retval      PDMA_SVC_NODESC_ERR     Every slot is in flight
+ * @retval      Others                  Error of PDMA_SvcSubmit()
+ *
+ * @details     Fences count every operation and wrap through 0 together with u32Completed, so that
+ *              PDMA_CopyIsDone() compares them by their difference only.
+ */
+static int32_t PDMA_CopyQueue(PDMA_COPY_T *psCopy, uint32_t u32Dst, uint32_t u32Src, uint32_t u32Sar, uint32_t u32Pattern, uint32_t u32Len, uint32_t u32Width)
+{
+    uint32_t u32Fence = psCopy->u32Issued + 1UL;
+    PDMA_COPY_SLOT_T *psSlot;
+    uint32_t u32Ctl;
+    int32_t i32Ret;
+
+    /* Slots are reused in fence order; the one of u32Fence is free once u32Fence - SLOTS completed */
+    if(u32Fence - psCopy->u32Completed > PDMA_COPY_SLOTS)
+        return PDMA_SVC_NODESC_ERR;
+
+    psSlot = &psCopy->asSlot[u32Fence % PDMA_COPY_SLOTS];
+    psSlot->u32Pattern = u32Pattern;
+    psSlot->sSeg.u32DstAddr = u32Dst;
+    psSlot->sSeg.u32SrcAddr = (u32Sar == PDMA_SAR_INC) ? u32Src : (uint32_t)&psSlot->u32Pattern;
+    psSlot->sSeg.u32TransCount = u32Len >> (u32Width >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+    u32Ctl = u32Width | u32Sar | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128;
+
+    PDMA_SvcInitXfer(&psSlot->sXfer, &psSlot->sSeg, 1UL, PDMA_MEM, u32Ctl, PDMA_CopyDone, psCopy);
+
+    i32Ret = PDMA_SvcSubmit(psCopy->psSvc, psCopy->u32Ch, &psSlot->sXfer);
+
+    if(i32Ret != 0)
+        return i32Ret;
+
+    psCopy->u32Issued = u32Fence;
+    psCopy->u32DmaOps++;
+    psCopy->u32DmaBytes += u32Len;
+
+    return 0;
+}
+
+/**
+ * @brief       Queue the aligned body of a copy or fill, split at the transfer count limit
+ *
+ * @return      Bytes queued from the start of the body; the caller does the rest on the CPU
+ */
+static uint32_t PDMA_CopyBody(PDMA_COPY_T *psCopy, uint32_t u32Dst, uint32_t u32Src, uint32_t u32Sar, uint32_t u32Pattern, uint32_t u32Len, uint32_t u32Width)
+{
+    uint32_t u32Max = ((PDMA_DSCT_CTL_TXCNT_Msk >> PDMA_DSCT_CTL_TXCNT_Pos) + 1UL) << (u32Width >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+    uint32_t u32Done = 0UL, u32Part;
+
+    while(u32Done < u32Len)
+    {
+        u32Part = ((u32Len - u32Done) > u32Max) ? u32Max : (u32Len - u32Done);
+
+        if(PDMA_CopyQueue(psCopy, u32Dst + u32Done, u32Src + u32Done, u32Sar, u32Pattern, u32Part, u32Width) != 0)
+        {
+            psCopy->u32Fallbacks++;
+            break;
+        }
+
+        u32Done += u32Part;
+    }
+
+    return u32Done;
+}
+
+/**
+ * @brief       Initialize a memory copy service
+ *
+ * @param[out]  psCopy          The pointer of the copy service state, in SRAM
+ * @param[in]   psSvc           Channel service the memory to memory channel is taken from
+ * @param[in]   u32Threshold    Copies shorter than this many bytes stay on the CPU, 0 for \ref PDMA_COPY_THRESHOLD
+ *
+ * @retval      0                   Success
+ * @retval      PDMA_SVC_NOCH_ERR   No free channel
+ *
+ * @details     One channel is taken for the life of the service. Every copy and fill goes through it in order,
+ *              which is what makes a single fence counter sufficient.
+ */
+int32_t PDMA_CopyInit(PDMA_COPY_T *psCopy, PDMA_SVC_T *psSvc, uint32_t u32Threshold)
+{
+    int32_t i32Ch;
+
+    memset(psCopy, 0, sizeof(PDMA_COPY_T));
+    i32Ch = PDMA_SvcAllocCh(psSvc, PDMA_SVC_CH_ANY);
+
+    if(i32Ch < 0)
+        return i32Ch;
+
+    psCopy->psSvc = psSvc;
+    psCopy->u32Ch = (uint32_t)i32Ch;
+    PDMA_CopySetThreshold(psCopy, u32Threshold);
+
+    return 0;
+}
+
+/**
+ * @brief       Release the channel of a copy service
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ *
+ * @return      None
+ *
+ * @details     Operations still in flight are cancelled and complete their fences with an error.
+ */
+void PDMA_CopyDeInit(PDMA_COPY_T *psCopy)
+{
+    PDMA_SvcFreeCh(psCopy->psSvc, psCopy->u32Ch);
+}
+
+/**
+ * @brief       Set the size from which copies go to PDMA
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   u32Threshold    Bytes, 0 for \ref PDMA_COPY_THRESHOLD
+ *
+ * @return      None
+ *
+ * @details     The cross-over point depends on the memories involved; SampleCode/StdDriver/PDMA_MemCopyBench
+ *              measures it on the board.
+ */
+void PDMA_CopySetThreshold(PDMA_COPY_T *psCopy, uint32_t u32Threshold)
+{
+    psCopy->u32Threshold = (u32Threshold != 0UL) ? u32Threshold : PDMA_COPY_THRESHOLD;
+}
+
+/**
+ * @brief       Copy memory, on PDMA when it pays off
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   pvDst           Destination
+ * @param[in]   pvSrc           Source, not overlapping the destination
+ * @param[in]   u32Len          Bytes to copy
+ *
+ * @return      Fence covering this copy and every earlier call, for PDMA_CopyIsDone() and PDMA_CopyWait()
+ *
+ * @details     Copies whose aligned body is shorter than the threshold, and copies whose source and destination
+ *              differ in 16-bit alignment, are done by the CPU before the call returns. Otherwise the unaligned ends are copied
+ *              by the CPU and the body is queued to PDMA in 32-bit (or 16-bit) items; neither buffer may be
+ *              touched until the fence is reached. When every slot is in flight the rest is copied by the CPU
+ *              rather than waiting.
+ */
+uint32_t PDMA_MemCopy(PDMA_COPY_T *psCopy, void *pvDst, const void *pvSrc, uint32_t u32Len)
+{
+    uint32_t u32Dst = (uint32_t)pvDst, u32Src = (uint32_t)pvSrc;
+    uint32_t u32Width, u32Align, u32Head, u32Body, u32Done;
+
+    u32Width = ((u32Dst ^ u32Src) & 0x3UL) ? PDMA_WIDTH_16 : PDMA_WIDTH_32;
+    u32Align = 1UL << (u32Width >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+    u32Head = (u32Align - (u32Dst & (u32Align - 1UL))) & (u32Align - 1UL);
+    u32Body = (u32Len > u32Head) ? ((u32Len - u32Head) & ~(u32Align - 1UL)) : 0UL;
+
+    if((u32Body < psCopy->u32Threshold) || ((u32Dst ^ u32Src) & 0x1UL))
+    {
+        memcpy(pvDst, pvSrc, u32Len);
+        psCopy->u32CpuOps++;
+        psCopy->u32CpuBytes += u32Len;
+        return psCopy->u32Issued;
+    }
+
+    memcpy(pvDst, pvSrc, u32Head);
+    u32Done = PDMA_CopyBody(psCopy, u32Dst + u32Head, u32Src + u32Head, PDMA_SAR_INC, 0UL, u32Body, u32Width);
+    memcpy((uint8_t *)pvDst + u32Head + u32Done, (const uint8_t *)pvSrc + u32Head + u32Done, u32Len - u32Head - u32Done);
+    psCopy->u32CpuBytes += u32Len - u32Done;
+
+    return psCopy->u32Issued;
+}
+
+/**
+ * @brief       Fill memory, on PDMA when it pays off
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   pvDst           Destination
+ * @param[in]   u8Value         Fill byte
+ * @param[in]   u32Len          Bytes to fill
+ *
+ * @return      Fence covering this fill and every earlier call
+ *
+ * @details     Same dispatch as PDMA_MemCopy(). PDMA repeats a 32-bit pattern word kept in the slot of the
+ *              operation, so fills with different values can be in flight together.
+ */
+uint32_t PDMA_MemSet(PDMA_COPY_T *psCopy, void *pvDst, uint8_t u8Value, uint32_t u32Len)
+{
+    uint32_t u32Dst = (uint32_t)pvDst;
+    uint32_t u32Head, u32Body, u32Done;
+
+    u32Head = (4UL - (u32Dst & 0x3UL)) & 0x3UL;
+    u32Body = (u32Len > u32Head) ? ((u32Len - u32Head) & ~0x3UL) : 0UL;
+
+    if(u32Body < psCopy->u32Threshold)
+    {
+        memset(pvDst, u8Value, u32Len);
+        psCopy->u32CpuOps++;
+        psCopy->u32CpuBytes += u32Len;
+        return psCopy->u32Issued;
+    }
+
+    memset(pvDst, u8Value, u32Head);
+    u32Done = PDMA_CopyBody(psCopy, u32Dst + u32Head, 0UL, PDMA_SAR_FIX, u8Value * 0x01010101UL, u32Body, PDMA_WIDTH_32);
+    memset((uint8_t *)pvDst + u32Head + u32Done, u8Value, u32Len - u32Head - u32Done);
+    psCopy->u32CpuBytes += u32Len - u32Done;
+
+    return psCopy->u32Issued;
+}
+
+/**
+ * @brief       Check a fence
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   u32Fence        Fence returned by PDMA_MemCopy() or PDMA_MemSet()
+ *
+ * @retval      1               Every operation up to the fence has completed
+ * @retval      0               Still in flight
+ */
+uint32_t PDMA_CopyIsDone(PDMA_COPY_T *psCopy, uint32_t u32Fence)
+{
+    return ((int32_t)(psCopy->u32Completed - u32Fence) >= 0) ? 1UL : 0UL;
+}
+
+/**
+ * @brief       Wait for a fence
+ *
+ * @param[in]   psCopy          The pointer of the copy service
+ * @param[in]   u32Fence        Fence returned by PDMA_MemCopy() or PDMA_MemSet()
+ *
+ * @retval      0                       Every operation up to the fence has completed
+ * @retval      PDMA_SVC_ABORT_ERR      An operation since the previous wait ended with a target abort
+ * @retval      PDMA_SVC_CANCEL_ERR     An operation since the previous wait was cancelled by PDMA_CopyDeInit()
+ * @retval      PDMA_COPY_TIMEOUT_ERR   The fence was not reached within about one second
+ *
+ * @details     Needs the PDMA interrupt, which completes the operations. The error is reported once.
+ */
+int32_t PDMA_CopyWait(PDMA_COPY_T *psCopy, uint32_t u32Fence)
+{
+    uint32_t u32TimeOutCnt = SystemCoreClock; /* 1 second time-out */
+    int32_t i32Err;
+
+    while(!PDMA_CopyIsDone(psCopy, u32Fence))
+    {
+        if(--u32TimeOutCnt == 0UL)
+            return PDMA_COPY_TIMEOUT_ERR;
+    }
+
+    i32Err = psCopy->i32Error;
+    psCopy->i32Error = 0;
+
+    return i32Err;
+}
+
 /*@}*/ /* end of group PDMA_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group PDMA_Driver */
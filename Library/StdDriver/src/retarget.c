@@ -467,6 +467,11 @@ uint32_t ProcessHardFault(uint32_t lr, uint32_t msp, uint32_t psp)
     }
 
 
+#if defined(DEBUG_DEFERRED_LOG)
+    /* The report above went to the log ring; send it out before stopping */
+    DLOG_Flush(DEBUG_PORT);
+#endif
+
     /* Or *sp to remove compiler warning */
     while(1U | *sp) {}
 
@@ -494,7 +499,14 @@ int32_t SH_Return(int32_t n32In_R0, int32_t n32In_R1, int32_t *pn32Out_R0)
  *
  * @details  Send a target char to UART debug port .
  */
-#ifndef NONBLOCK_PRINTF
+#if defined(DEBUG_DEFERRED_LOG)
+/* Into the deferred log ring, sent by DLOG_Drain() from the idle loop */
+void SendChar_ToUART(int ch)
+{
+    DLOG_PutChar(ch);
+}
+
+#elif !defined(NONBLOCK_PRINTF)
 void SendChar_ToUART(int ch)
 {
     if((char)ch == '\n')
@@ -746,6 +758,10 @@ int fputc(int ch, FILE *stream)
 #if !defined(OS_USE_SEMIHOSTING)
 int _write(int fd, char *ptr, int len)
 {
+#if defined(DEBUG_DEFERRED_LOG)
+    DLOG_Text(ptr, (uint32_t)len);
+    return len;
+#else
     int i = len;
 
     while(i--)
@@ -761,6 +777,7 @@ int _write(int fd, char *ptr, int len)
 
     }
     return len;
+#endif
 }
 
 int _read(int fd, char *ptr, int len)
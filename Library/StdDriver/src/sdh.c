@@ -1119,17 +1119,8 @@ uint32_t SDH_Probe(SDH_T *sdh)
     return 0ul;
 }
 
-/**
- *  @brief  This function use to read data from SD card.
- *
- *  @param[in]     sdh           Select SDH0 or SDH1.
- *  @param[out]    pu8BufAddr    The buffer to receive the data from SD card.
- *  @param[in]     u32StartSec   The start read sector address.
- *  @param[in]     u32SecCount   The the read sector number of data
- *
- *  @return None
- */
-uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+/** @cond HIDDEN_SYMBOLS */
+static uint32_t SDH_ReadBlocks(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
 {
     uint32_t volatile bIsSendCmd = FALSE, buf;
     uint32_t volatile reg;
@@ -1282,23 +1273,32 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
 
     return Successful;
 }
-
+/** @endcond HIDDEN_SYMBOLS */
 
 /**
- *  @brief  This function use to write data to SD card.
+ *  @brief  This function use to read data from SD card.
  *
- *  @param[in]    sdh           Select SDH0 or SDH1.
- *  @param[in]    pu8BufAddr    The buffer to send the data to SD card.
- *  @param[in]    u32StartSec   The start write sector address.
- *  @param[in]    u32SecCount   The the write sector number of data.
+ *  @param[in]     sdh           Select SDH0 or SDH1.
+ *  @param[out]    pu8BufAddr    The buffer to receive the data from SD card.
+ *  @param[in]     u32StartSec   The start read sector address.
+ *  @param[in]     u32SecCount   The the read sector number of data
  *
- *  @return   \ref SDH_SELECT_ERROR : u32SecCount is zero. \n
- *            \ref SDH_NO_SD_CARD : SD card be removed. \n
- *            \ref SDH_CRC_ERROR : CRC error happen. \n
- *            \ref SDH_CRC7_ERROR : CRC7 error happen. \n
- *            \ref Successful : Write data to SD card success.
+ *  @return None
  */
-uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    uint32_t u32Status;
+
+    TRACE_ENTER(SDH, TRACE_SDH_READ, u32SecCount);
+    u32Status = SDH_ReadBlocks(sdh, pu8BufAddr, u32StartSec, u32SecCount);
+    TRACE_EXIT(SDH, TRACE_SDH_READ, u32Status);
+
+    return u32Status;
+}
+
+
+/** @cond HIDDEN_SYMBOLS */
+static uint32_t SDH_WriteBlocks(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
 {
     uint32_t volatile bIsSendCmd = FALSE;
     uint32_t volatile reg;
@@ -1437,6 +1437,32 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
 
     return Successful;
 }
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+ *  @brief  This function use to write data to SD card.
+ *
+ *  @param[in]    sdh           Select SDH0 or SDH1.
+ *  @param[in]    pu8BufAddr    The buffer to send the data to SD card.
+ *  @param[in]    u32StartSec   The start write sector address.
+ *  @param[in]    u32SecCount   The the write sector number of data.
+ *
+ *  @return   \ref SDH_SELECT_ERROR : u32SecCount is zero. \n
+ *            \ref SDH_NO_SD_CARD : SD card be removed. \n
+ *            \ref SDH_CRC_ERROR : CRC error happen. \n
+ *            \ref SDH_CRC7_ERROR : CRC7 error happen. \n
+ *            \ref Successful : Write data to SD card success.
+ */
+uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    uint32_t u32Status;
+
+    TRACE_ENTER(SDH, TRACE_SDH_WRITE, u32SecCount);
+    u32Status = SDH_WriteBlocks(sdh, pu8BufAddr, u32StartSec, u32SecCount);
+    TRACE_EXIT(SDH, TRACE_SDH_WRITE, u32Status);
+
+    return u32Status;
+}
 
 /*@}*/ /* end of group SDH_EXPORTED_FUNCTIONS */
 
@@ -6,6 +6,7 @@
  * @copyright SPDX-License-Identifier: Apache-2.0
  * @copyright Copyright (C) 2021 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
+#include <string.h>
 #include "NuMicro.h"
 
 /** @addtogroup Standard_Driver Standard Driver
@@ -2120,6 +2121,633 @@ void SPII2S_SetFIFO(SPI_T *i2s, uint32_t u32TxThreshold, uint32_t u32RxThreshold
                    (u32RxThreshold << SPI_FIFOCTL_RXTH_Pos);
 }
 
+/** @cond HIDDEN_SYMBOLS */
+
+#define SPI_BUS_PHASE_CMD   0UL
+#define SPI_BUS_PHASE_DATA  1UL
+
+#define SPI_BUS_SEG_LEN     65536UL
+#define SPI_BUS_LINE_MSK    (QSPI_CTL_DUALIOEN_Msk | QSPI_CTL_QUADIOEN_Msk | QSPI_CTL_DATDIR_Msk)
+#define SPI_BUS_TXN_FLAGS   (SPI_TXN_KEEP_CS | SPI_TXN_DATA_DUAL | SPI_TXN_DATA_QUAD)
+
+/* Controllers served by SPI_BusOpen() and their PDMA TX request sources, RX is the next one */
+static SPI_T * const s_apsBusSpi[] =
+{
+    (SPI_T *)QSPI0, (SPI_T *)QSPI1, SPI0, SPI1, SPI2, SPI3, SPI4, SPI5, SPI6, SPI7, SPI8, SPI9, SPI10
+};
+
+static const uint8_t s_au8BusTxReq[] =
+{
+    PDMA_QSPI0_TX, PDMA_QSPI1_TX, PDMA_SPI0_TX, PDMA_SPI1_TX, PDMA_SPI2_TX, PDMA_SPI3_TX, PDMA_SPI4_TX,
+    PDMA_SPI5_TX, PDMA_SPI6_TX, PDMA_SPI7_TX, PDMA_SPI8_TX, PDMA_SPI9_TX, PDMA_SPI10_TX
+};
+
+static void SPI_BusXferDone(PDMA_XFER_T *psXfer, int32_t i32Status);
+
+static uint32_t SPI_BusNow(SPI_BUS_T *psBus)
+{
+    return (psBus->psSvc->pfnGetTime != NULL) ? psBus->psSvc->pfnGetTime() : 0UL;
+}
+
+/**
+  * @brief  Move the chip select to another device.
+  * @param[in]  psBus The pointer of the bus.
+  * @param[in]  psDev Device to select, NULL to release the selected one.
+  * @return None
+  */
+static void SPI_BusCs(SPI_BUS_T *psBus, const SPI_DEV_T *psDev)
+{
+    const SPI_DEV_T *psOld = psBus->psCsDev;
+
+    if(psOld == psDev)
+        return;
+
+    if(psOld != NULL)
+    {
+        if(psOld->pu32CsPin != NULL)
+            *psOld->pu32CsPin = (psOld->u32SSLevel == SPI_SS_ACTIVE_HIGH) ? 0UL : 1UL;
+        else
+            psBus->spi->SSCTL &= ~SPI_SSCTL_SS_Msk;
+    }
+
+    if(psDev != NULL)
+    {
+        if(psDev->pu32CsPin != NULL)
+            *psDev->pu32CsPin = (psDev->u32SSLevel == SPI_SS_ACTIVE_HIGH) ? 1UL : 0UL;
+        else
+            psBus->spi->SSCTL |= SPI_SSCTL_SS_Msk;
+    }
+
+    psBus->psCsDev = psDev;
+}
+
+/**
+  * @brief  Replace a PDMA channel whose transfer has to be dropped.
+  * @param[in]  psBus The pointer of the bus.
+  * @param[in,out]  pu32Ch The channel, set to the new one.
+  * @return None
+  * @details The PDMA service stops a queued transfer only when its channel is freed. The queued
+  *          transfer completes with PDMA_SVC_CANCEL_ERR, which SPI_BusXferDone() only counts.
+  */
+static void SPI_BusRenewCh(SPI_BUS_T *psBus, uint32_t *pu32Ch)
+{
+    int32_t i32Ch;
+
+    PDMA_SvcFreeCh(psBus->psSvc, *pu32Ch);
+    i32Ch = PDMA_SvcAllocCh(psBus->psSvc, PDMA_SVC_CH_ANY);
+
+    /* Without a channel the following transactions fail in PDMA_SvcSubmit() */
+    *pu32Ch = (i32Ch >= 0) ? (uint32_t)i32Ch : PDMA_CH_MAX;
+}
+
+/**
+  * @brief  Stop the phase of the running transaction.
+  * @param[in]  psBus The pointer of the bus.
+  * @return None
+  */
+static void SPI_BusAbort(SPI_BUS_T *psBus)
+{
+    SPI_T *spi = psBus->spi;
+
+    spi->PDMACTL = SPI_PDMACTL_PDMARST_Msk;
+
+    if(psBus->sTxXfer.i32Status == PDMA_SVC_PENDING)
+        SPI_BusRenewCh(psBus, &psBus->u32TxCh);
+
+    if(psBus->sRxXfer.i32Status == PDMA_SVC_PENDING)
+        SPI_BusRenewCh(psBus, &psBus->u32RxCh);
+
+    psBus->u32XferCnt = 0UL;
+    SPI_ClearTxFIFO(spi);
+    SPI_ClearRxFIFO(spi);
+}
+
+/**
+  * @brief  Start the current phase of the running transaction.
+  * @param[in]  psBus The pointer of the bus.
+  * @retval 0 The phase runs.
+  * @retval SPI_BUS_PDMA_ERR A PDMA transfer was not accepted, SPI_BusAbort() drops the other one.
+  * @details The command phase is always on one line. A data phase on two or four lines moves data
+  *          in one direction: output has no RX transfer, input still needs TX data to clock the bus.
+  */
+static int32_t SPI_BusPhase(SPI_BUS_T *psBus)
+{
+    SPI_T *spi = psBus->spi;
+    SPI_TXN_T *psTxn = psBus->psHead;
+    uint32_t u32Lines = 0UL, u32Len, u32Src, u32Dst, u32TxCtl, u32RxCtl, u32SegCnt, u32Cnt, i;
+
+    if(psBus->u32Phase == SPI_BUS_PHASE_CMD)
+    {
+        u32Len = psTxn->u32CmdLen;
+        u32Src = (uint32_t)psTxn->au8Cmd;
+        u32TxCtl = PDMA_SAR_INC;
+        u32Dst = (uint32_t)&psBus->u32Sink;
+        u32RxCtl = PDMA_DAR_FIX;
+    }
+    else
+    {
+        u32Len = psTxn->u32Len;
+
+        if(psTxn->u32Flags & (SPI_TXN_DATA_DUAL | SPI_TXN_DATA_QUAD))
+            u32Lines = ((psTxn->u32Flags & SPI_TXN_DATA_DUAL) ? QSPI_CTL_DUALIOEN_Msk : QSPI_CTL_QUADIOEN_Msk) |
+                       ((psTxn->pu8Tx != NULL) ? QSPI_CTL_DATDIR_Msk : 0UL);
+
+        u32Src = (psTxn->pu8Tx != NULL) ? (uint32_t)psTxn->pu8Tx : (uint32_t)&psBus->u32Fill;
+        u32TxCtl = (psTxn->pu8Tx != NULL) ? PDMA_SAR_INC : PDMA_SAR_FIX;
+        u32Dst = (psTxn->pu8Rx != NULL) ? (uint32_t)psTxn->pu8Rx : (uint32_t)&psBus->u32Sink;
+        u32RxCtl = (psTxn->pu8Rx != NULL) ? PDMA_DAR_INC : PDMA_DAR_FIX;
+    }
+
+    /* The shifter is idle between phases */
+    if(psBus->u32Quad)
+        spi->CTL = (spi->CTL & ~SPI_BUS_LINE_MSK) | u32Lines;
+
+    for(i = 0UL, u32SegCnt = 0UL; i < u32Len; i += u32Cnt, u32SegCnt++)
+    {
+        u32Cnt = ((u32Len - i) > SPI_BUS_SEG_LEN) ? SPI_BUS_SEG_LEN : (u32Len - i);
+        psBus->asTxSeg[u32SegCnt].u32SrcAddr = u32Src + ((u32TxCtl == PDMA_SAR_INC) ? i : 0UL);
+        psBus->asTxSeg[u32SegCnt].u32DstAddr = (uint32_t)&spi->TX;
+        psBus->asTxSeg[u32SegCnt].u32TransCount = u32Cnt;
+        psBus->asRxSeg[u32SegCnt].u32SrcAddr = (uint32_t)&spi->RX;
+        psBus->asRxSeg[u32SegCnt].u32DstAddr = u32Dst + ((u32RxCtl == PDMA_DAR_INC) ? i : 0UL);
+        psBus->asRxSeg[u32SegCnt].u32TransCount = u32Cnt;
+    }
+
+    SPI_ClearRxFIFO(spi);
+    psBus->u32XferCnt = 0UL;
+
+    if(!(u32Lines & QSPI_CTL_DATDIR_Msk))
+    {
+        PDMA_SvcInitXfer(&psBus->sRxXfer, psBus->asRxSeg, u32SegCnt, psBus->u32RxReq,
+                         PDMA_WIDTH_8 | PDMA_SAR_FIX | u32RxCtl | PDMA_REQ_SINGLE, SPI_BusXferDone, psBus);
+
+        if(PDMA_SvcSubmit(psBus->psSvc, psBus->u32RxCh, &psBus->sRxXfer) != 0)
+            return SPI_BUS_PDMA_ERR;
+
+        psBus->u32XferCnt++;
+    }
+
+    PDMA_SvcInitXfer(&psBus->sTxXfer, psBus->asTxSeg, u32SegCnt, psBus->u32TxReq,
+                     PDMA_WIDTH_8 | u32TxCtl | PDMA_DAR_FIX | PDMA_REQ_SINGLE, SPI_BusXferDone, psBus);
+
+    if(PDMA_SvcSubmit(psBus->psSvc, psBus->u32TxCh, &psBus->sTxXfer) != 0)
+        return SPI_BUS_PDMA_ERR;
+
+    psBus->u32XferCnt++;
+
+    /* Nothing moves before the requests are enabled, the phase may complete from here on */
+    spi->PDMACTL = ((u32Lines & QSPI_CTL_DATDIR_Msk) ? 0UL : SPI_PDMACTL_RXPDMAEN_Msk) | SPI_PDMACTL_TXPDMAEN_Msk;
+
+    return 0;
+}
+
+/**
+  * @brief  Load the device settings and start the transaction at the head of the queue.
+  * @param[in]  psBus The pointer of the bus.
+  * @retval 0 The transaction runs.
+  * @retval SPI_BUS_PDMA_ERR The first phase could not be started.
+  */
+static int32_t SPI_BusStart(SPI_BUS_T *psBus)
+{
+    SPI_T *spi = psBus->spi;
+    SPI_TXN_T *psTxn = psBus->psHead;
+    const SPI_DEV_T *psDev = psTxn->psDev;
+
+    /* Mode and clock change with every chip select inactive */
+    if(psBus->psCsDev != psDev)
+        SPI_BusCs(psBus, NULL);
+
+    if(psBus->psCurDev != psDev)
+    {
+        spi->CTL = (spi->CTL & ~(SPI_CTL_CLKPOL_Msk | SPI_CTL_TXNEG_Msk | SPI_CTL_RXNEG_Msk)) | psDev->u32Mode;
+        spi->CLKDIV = psDev->u32ClkDiv;
+        psBus->psCurDev = psDev;
+        psBus->sStat.u32ModeSwitches++;
+    }
+
+    SPI_BusCs(psBus, psDev);
+    psBus->i32Error = 0;
+    psBus->u32RunTime = SPI_BusNow(psBus);
+    psBus->u32Phase = (psTxn->u32CmdLen != 0UL) ? SPI_BUS_PHASE_CMD : SPI_BUS_PHASE_DATA;
+
+    return SPI_BusPhase(psBus);
+}
+
+/**
+  * @brief  Take the running transaction off the queue.
+  * @param[in]  psBus The pointer of the bus.
+  * @return The transaction, its status is in psBus->i32Error.
+  * @details The chip select stays active only for a successful SPI_TXN_KEEP_CS transaction.
+  */
+static SPI_TXN_T *SPI_BusRetire(SPI_BUS_T *psBus)
+{
+    SPI_TXN_T *psTxn = psBus->psHead;
+    uint32_t u32PriMask, u32Now, u32Latency;
+
+    if(psBus->u32Quad)
+        psBus->spi->CTL &= ~SPI_BUS_LINE_MSK;
+
+    if((psBus->i32Error != 0) || !(psTxn->u32Flags & SPI_TXN_KEEP_CS))
+        SPI_BusCs(psBus, NULL);
+
+    u32Now = SPI_BusNow(psBus);
+    u32Latency = u32Now - psTxn->u32SubmitTime;
+
+    if(psBus->i32Error == 0)
+    {
+        psBus->sStat.u32Txns++;
+        psBus->sStat.u32Bytes += psTxn->u32CmdLen + psTxn->u32Len;
+    }
+    else
+        psBus->sStat.u32Errors++;
+
+    psBus->sStat.u32BusyTime += u32Now - psBus->u32RunTime;
+    psBus->sStat.u32TotalLatency += u32Latency;
+
+    if(u32Latency > psBus->sStat.u32MaxLatency)
+        psBus->sStat.u32MaxLatency = u32Latency;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    psBus->psHead = psTxn->psNext;
+
+    if(psBus->psHead == NULL)
+        psBus->psTail = NULL;
+
+    psBus->u32Depth--;
+    __set_PRIMASK(u32PriMask);
+
+    psTxn->psNext = NULL;
+
+    return psTxn;
+}
+
+/**
+  * @brief  Start queued transactions in turn until one runs.
+  * @param[in]  psBus The pointer of the bus.
+  * @return Transactions that could not be started, linked through psNext, to be reported.
+  */
+static SPI_TXN_T *SPI_BusKick(SPI_BUS_T *psBus)
+{
+    SPI_TXN_T *psFail = NULL, *psLast = NULL, *psTxn;
+
+    while(psBus->psHead != NULL)
+    {
+        if(SPI_BusStart(psBus) == 0)
+            break;
+
+        SPI_BusAbort(psBus);
+        psBus->i32Error = SPI_BUS_PDMA_ERR;
+        psTxn = SPI_BusRetire(psBus);
+
+        if(psLast != NULL)
+            psLast->psNext = psTxn;
+        else
+            psFail = psTxn;
+
+        psLast = psTxn;
+    }
+
+    return psFail;
+}
+
+static void SPI_BusReport(SPI_TXN_T *psTxn, int32_t i32Status)
+{
+    SPI_TXN_T *psNext;
+
+    for(; psTxn != NULL; psTxn = psNext)
+    {
+        psNext = psTxn->psNext;
+        psTxn->psNext = NULL;
+        psTxn->i32Status = i32Status;
+
+        if(psTxn->pfnDone != NULL)
+            psTxn->pfnDone(psTxn, i32Status);
+    }
+}
+
+/**
+  * @brief  Continue after the PDMA transfers of a phase completed.
+  * @param[in]  psBus The pointer of the bus.
+  * @return None
+  * @details The next transaction is started before the callback of the finished one, which keeps
+  *          the bus busy while the callback runs.
+  */
+static void SPI_BusPhaseEnd(SPI_BUS_T *psBus)
+{
+    SPI_T *spi = psBus->spi;
+    SPI_TXN_T *psTxn, *psFail;
+    uint32_t u32TimeOutCnt;
+    int32_t i32Status;
+
+    spi->PDMACTL = 0UL;
+
+    /* An output phase completes when PDMA filled the TX FIFO, not when the last bit left */
+    if(psBus->u32Quad && (spi->CTL & QSPI_CTL_DATDIR_Msk))
+    {
+        for(u32TimeOutCnt = SystemCoreClock / 1000UL; SPI_IS_BUSY(spi) && u32TimeOutCnt; u32TimeOutCnt--) {}
+
+        SPI_ClearRxFIFO(spi);
+    }
+
+    if((psBus->i32Error == 0) && (psBus->u32Phase == SPI_BUS_PHASE_CMD) && (psBus->psHead->u32Len != 0UL))
+    {
+        psBus->u32Phase = SPI_BUS_PHASE_DATA;
+
+        if(SPI_BusPhase(psBus) == 0)
+            return;
+
+        SPI_BusAbort(psBus);
+        psBus->i32Error = SPI_BUS_PDMA_ERR;
+    }
+
+    i32Status = psBus->i32Error;
+    psTxn = SPI_BusRetire(psBus);
+    psFail = SPI_BusKick(psBus);
+    SPI_BusReport(psTxn, i32Status);
+    SPI_BusReport(psFail, SPI_BUS_PDMA_ERR);
+}
+
+/**
+  * @brief  Completion callback of the TX and RX transfers of a phase.
+  * @param[in]  psXfer The transfer.
+  * @param[in]  i32Status Status from the PDMA service.
+  * @return None
+  */
+static void SPI_BusXferDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    SPI_BUS_T *psBus = (SPI_BUS_T *)psXfer->pvArg;
+
+    /* Dropped by SPI_BusAbort(), whose caller goes on */
+    if(i32Status == PDMA_SVC_CANCEL_ERR)
+        return;
+
+    if(i32Status != 0)
+    {
+        SPI_BusAbort(psBus);
+        psBus->i32Error = SPI_BUS_PDMA_ERR;
+    }
+    else if(--psBus->u32XferCnt != 0UL)
+        return;
+
+    SPI_BusPhaseEnd(psBus);
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Set up the transaction queue of a SPI or QSPI controller.
+  * @param[out]  psBus The pointer of the bus state.
+  * @param[in]  spi SPI0 ~ SPI10, or QSPI0/QSPI1 cast to (SPI_T *).
+  * @param[in]  psSvc PDMA channel service, its pfnGetTime is the time source of the statistics.
+  * @retval 0 Success.
+  * @retval SPI_BUS_PARAM_ERR spi is not a SPI or QSPI controller.
+  * @retval SPI_BUS_PDMA_ERR The PDMA service has not two free channels.
+  * @details The controller is opened before as master with 8-bit data, e.g. SPI_Open(spi, SPI_MASTER,
+  *          SPI_MODE_0, 8, u32BusClock). Automatic slave selection is turned off, the bus drives the
+  *          chip selects. The PDMA interrupt handler calls PDMA_SvcIRQHandler(psSvc).
+  */
+int32_t SPI_BusOpen(SPI_BUS_T *psBus, SPI_T *spi, PDMA_SVC_T *psSvc)
+{
+    uint32_t i;
+    int32_t i32TxCh, i32RxCh;
+
+    for(i = 0UL; (i < sizeof(s_apsBusSpi) / sizeof(s_apsBusSpi[0])) && (s_apsBusSpi[i] != spi); i++) {}
+
+    if(i == sizeof(s_apsBusSpi) / sizeof(s_apsBusSpi[0]))
+        return SPI_BUS_PARAM_ERR;
+
+    i32TxCh = PDMA_SvcAllocCh(psSvc, PDMA_SVC_CH_ANY);
+
+    if(i32TxCh < 0)
+        return SPI_BUS_PDMA_ERR;
+
+    i32RxCh = PDMA_SvcAllocCh(psSvc, PDMA_SVC_CH_ANY);
+
+    if(i32RxCh < 0)
+    {
+        PDMA_SvcFreeCh(psSvc, (uint32_t)i32TxCh);
+        return SPI_BUS_PDMA_ERR;
+    }
+
+    memset(psBus, 0, sizeof(SPI_BUS_T));
+    psBus->spi = spi;
+    psBus->psSvc = psSvc;
+    psBus->u32Quad = (i < 2UL) ? 1UL : 0UL;
+    psBus->u32TxCh = (uint32_t)i32TxCh;
+    psBus->u32RxCh = (uint32_t)i32RxCh;
+    psBus->u32TxReq = s_au8BusTxReq[i];
+    psBus->u32RxReq = s_au8BusTxReq[i] + 1UL;
+    psBus->u32Fill = 0xFFFFFFFFUL;
+    psBus->sStat.u32StartTime = SPI_BusNow(psBus);
+
+    spi->SSCTL &= ~(SPI_SSCTL_AUTOSS_Msk | SPI_SSCTL_SS_Msk);
+    spi->PDMACTL = 0UL;
+
+    if(psBus->u32Quad)
+        spi->CTL &= ~SPI_BUS_LINE_MSK;
+
+    SPI_ClearTxFIFO(spi);
+    SPI_ClearRxFIFO(spi);
+
+    return 0;
+}
+
+/**
+  * @brief  Release the PDMA channels of an idle bus.
+  * @param[in]  psBus The pointer of the bus.
+  * @retval 0 Success.
+  * @retval SPI_BUS_BUSY_ERR Transactions are still queued.
+  * @details A chip select kept active by SPI_TXN_KEEP_CS is released. The controller stays open.
+  */
+int32_t SPI_BusClose(SPI_BUS_T *psBus)
+{
+    if(psBus->psHead != NULL)
+        return SPI_BUS_BUSY_ERR;
+
+    SPI_BusCs(psBus, NULL);
+    psBus->spi->PDMACTL = 0UL;
+    PDMA_SvcFreeCh(psBus->psSvc, psBus->u32TxCh);
+    PDMA_SvcFreeCh(psBus->psSvc, psBus->u32RxCh);
+
+    return 0;
+}
+
+/**
+  * @brief  Prepare the settings of a device on the bus.
+  * @param[in]  psBus The pointer of the bus.
+  * @param[out]  psDev The pointer of the device settings.
+  * @param[in]  u32SPIMode The transfer timing of the device. (SPI_MODE_0, SPI_MODE_1, SPI_MODE_2, SPI_MODE_3)
+  * @param[in]  u32BusClock The expected frequency of the device bus clock in Hz.
+  * @param[in]  u32SSLevel Active level of the chip select. (SPI_SS_ACTIVE_HIGH, SPI_SS_ACTIVE_LOW)
+  * @param[in]  pu32CsPin GPIO bit driving the chip select, e.g. &PB2, or NULL for the SS pin of the controller.
+  * @retval 0 Success, psDev->u32BusClock holds the actual bus clock.
+  * @retval SPI_BUS_BUSY_ERR Transactions are queued, the clock divider is in use.
+  * @details The divider is computed by SPI_SetBusClock() (or QSPI_SetBusClock()) on the idle controller,
+  *          then the loaded one is restored. The chip select is driven inactive. At most one device
+  *          of a bus uses the SS pin, the others need a GPIO output each.
+  * @note   A bus clock at or above HCLK switches the clock source of the controller to PCLK, which
+  *          changes the bus clock of devices set up before.
+  */
+int32_t SPI_BusInitDev(SPI_BUS_T *psBus, SPI_DEV_T *psDev, uint32_t u32SPIMode, uint32_t u32BusClock, uint32_t u32SSLevel, volatile uint32_t *pu32CsPin)
+{
+    SPI_T *spi = psBus->spi;
+    uint32_t u32ClkDiv;
+
+    if(psBus->psHead != NULL)
+        return SPI_BUS_BUSY_ERR;
+
+    SPI_BusCs(psBus, NULL);
+
+    u32ClkDiv = spi->CLKDIV;
+    psDev->u32BusClock = psBus->u32Quad ? QSPI_SetBusClock((QSPI_T *)spi, u32BusClock) : SPI_SetBusClock(spi, u32BusClock);
+    psDev->u32ClkDiv = spi->CLKDIV;
+    spi->CLKDIV = u32ClkDiv;
+
+    psDev->u32Mode = u32SPIMode & (SPI_CTL_CLKPOL_Msk | SPI_CTL_TXNEG_Msk | SPI_CTL_RXNEG_Msk);
+    psDev->u32SSLevel = u32SSLevel & SPI_SSCTL_SSACTPOL_Msk;
+    psDev->pu32CsPin = pu32CsPin;
+
+    if(pu32CsPin != NULL)
+        *pu32CsPin = (psDev->u32SSLevel == SPI_SS_ACTIVE_HIGH) ? 0UL : 1UL;
+    else
+        spi->SSCTL = (spi->SSCTL & ~SPI_SSCTL_SSACTPOL_Msk) | psDev->u32SSLevel;
+
+    /* The settings of psDev may have changed, reload them with the next transaction */
+    psBus->psCurDev = NULL;
+
+    return 0;
+}
+
+/**
+  * @brief  Prepare a transaction.
+  * @param[out]  psTxn The pointer of the transaction.
+  * @param[in]  psDev Target device.
+  * @param[in]  pu8Cmd Command, address and dummy bytes sent on one line, copied into psTxn.
+  * @param[in]  u32CmdLen Bytes in pu8Cmd, 0 ~ SPI_TXN_CMD_MAX.
+  * @param[in]  pu8Tx Data to send, NULL to send 0xFF.
+  * @param[out]  pu8Rx Buffer of the received data, NULL to discard it.
+  * @param[in]  u32Len Data phase bytes, 0 for a command-only transaction.
+  * @param[in]  u32Flags SPI_TXN_KEEP_CS, SPI_TXN_DATA_DUAL, SPI_TXN_DATA_QUAD or 0.
+  * @param[in]  pfnDone Completion callback, may be NULL.
+  * @param[in]  pvArg Caller context, kept in psTxn->pvArg.
+  * @return None
+  * @details A transaction built once can be submitted again as long as its buffers stay valid.
+  *          A data phase on two or four lines moves data in one direction, so exactly one of
+  *          pu8Tx and pu8Rx is set.
+  */
+void SPI_BusInitTxn(SPI_TXN_T *psTxn, const SPI_DEV_T *psDev, const uint8_t *pu8Cmd, uint32_t u32CmdLen,
+                    const uint8_t *pu8Tx, uint8_t *pu8Rx, uint32_t u32Len, uint32_t u32Flags, SPI_TXN_CB_T pfnDone, void *pvArg)
+{
+    memset(psTxn, 0, sizeof(SPI_TXN_T));
+    psTxn->psDev = psDev;
+
+    if((pu8Cmd != NULL) && (u32CmdLen <= SPI_TXN_CMD_MAX))
+        memcpy(psTxn->au8Cmd, pu8Cmd, u32CmdLen);
+
+    psTxn->u32CmdLen = u32CmdLen;
+    psTxn->pu8Tx = pu8Tx;
+    psTxn->pu8Rx = pu8Rx;
+    psTxn->u32Len = u32Len;
+    psTxn->u32Flags = u32Flags;
+    psTxn->pfnDone = pfnDone;
+    psTxn->pvArg = pvArg;
+}
+
+/**
+  * @brief  Queue a transaction.
+  * @param[in]  psBus The pointer of the bus.
+  * @param[in]  psTxn The transaction, see SPI_BusInitTxn().
+  * @retval 0 Queued, psTxn->pfnDone is called when it completes.
+  * @retval SPI_BUS_PARAM_ERR Invalid transaction, nothing was queued.
+  * @details Transactions run in submit order. Between transactions of different devices the chip
+  *          select moves and the mode and clock of the next device are loaded; consecutive
+  *          transactions of one device keep them. Can be called from the completion callback.
+  *          When the bus is idle the transaction starts here, and a failure to start it calls
+  *          pfnDone with SPI_BUS_PDMA_ERR before returning.
+  */
+int32_t SPI_BusSubmit(SPI_BUS_T *psBus, SPI_TXN_T *psTxn)
+{
+    uint32_t u32Lines = psTxn->u32Flags & (SPI_TXN_DATA_DUAL | SPI_TXN_DATA_QUAD);
+    uint32_t u32PriMask, u32Start;
+
+    if((psTxn->psDev == NULL) || (psTxn->u32CmdLen > SPI_TXN_CMD_MAX) ||
+            ((psTxn->u32CmdLen == 0UL) && (psTxn->u32Len == 0UL)) ||
+            (psTxn->u32Len > SPI_TXN_SEG_MAX * SPI_BUS_SEG_LEN) || (psTxn->u32Flags & ~SPI_BUS_TXN_FLAGS) ||
+            (u32Lines && (!psBus->u32Quad || (u32Lines == (SPI_TXN_DATA_DUAL | SPI_TXN_DATA_QUAD)) ||
+                          ((psTxn->pu8Tx == NULL) == (psTxn->pu8Rx == NULL)))))
+        return SPI_BUS_PARAM_ERR;
+
+    psTxn->psNext = NULL;
+    psTxn->i32Status = SPI_BUS_PENDING;
+    psTxn->u32SubmitTime = SPI_BusNow(psBus);
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    u32Start = (psBus->psHead == NULL) ? 1UL : 0UL;
+
+    if(u32Start)
+        psBus->psHead = psTxn;
+    else
+        psBus->psTail->psNext = psTxn;
+
+    psBus->psTail = psTxn;
+    psBus->u32Depth++;
+
+    if(psBus->u32Depth > psBus->sStat.u32MaxDepth)
+        psBus->sStat.u32MaxDepth = psBus->u32Depth;
+
+    __set_PRIMASK(u32PriMask);
+
+    /* Only the submit that finds the bus idle starts it, later ones are started by completions */
+    if(u32Start)
+        SPI_BusReport(SPI_BusKick(psBus), SPI_BUS_PDMA_ERR);
+
+    return 0;
+}
+
+/**
+  * @brief  Get bus utilization.
+  * @param[in]  psBus The pointer of the bus.
+  * @return Share of time a transaction was running since the statistics were cleared, in 1/1000.
+  * @details The running transaction counts up to now. Needs the pfnGetTime of PDMA_SvcInit().
+  *          The throughput is psBus->sStat.u32Bytes over the same time.
+  */
+uint32_t SPI_BusGetLoad(SPI_BUS_T *psBus)
+{
+    uint32_t u32PriMask, u32Now, u32Busy, u32Elapsed;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    u32Now = SPI_BusNow(psBus);
+    u32Busy = psBus->sStat.u32BusyTime + ((psBus->psHead != NULL) ? (u32Now - psBus->u32RunTime) : 0UL);
+    u32Elapsed = u32Now - psBus->sStat.u32StartTime;
+    __set_PRIMASK(u32PriMask);
+
+    return (u32Elapsed != 0UL) ? (uint32_t)(((uint64_t)u32Busy * 1000ULL) / u32Elapsed) : 0UL;
+}
+
+/**
+  * @brief  Clear bus statistics.
+  * @param[in]  psBus The pointer of the bus.
+  * @return None
+  * @details The queue depth high-water mark restarts from the current depth. The busy time of the
+  *          running transaction counts from now.
+  */
+void SPI_BusClearStats(SPI_BUS_T *psBus)
+{
+    uint32_t u32PriMask;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    memset(&psBus->sStat, 0, sizeof(SPI_BUS_STAT_T));
+    psBus->sStat.u32MaxDepth = psBus->u32Depth;
+    psBus->sStat.u32StartTime = SPI_BusNow(psBus);
+    psBus->u32RunTime = psBus->sStat.u32StartTime;
+    __set_PRIMASK(u32PriMask);
+}
+
 /*@}*/ /* end of group SPI_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group SPI_Driver */
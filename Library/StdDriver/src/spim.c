@@ -1356,6 +1356,1332 @@ void SPIM_ExitDirectMapMode(void)
 }
 
 
+/** @cond HIDDEN_SYMBOLS */
+
+#define SPIM_PRG_IDLE           0UL     /* Nothing running on the flash */
+#define SPIM_PRG_PAGE           1UL     /* Page write running */
+#define SPIM_PRG_ERASE          2UL     /* Erase running */
+#define SPIM_PRG_SUSPENDING     3UL     /* Suspend command sent, the erase has not stopped yet */
+#define SPIM_PRG_READ           4UL     /* Page Read mode transfer running */
+
+static uint32_t spim_prg_now(SPIM_PRG_T *psPrg)
+{
+    return (psPrg->pfnGetTime != NULL) ? psPrg->pfnGetTime() : 0UL;
+}
+
+/**
+  * @brief      Send a one byte command (erase suspend/resume).
+  * @param      u8Cmd       Command.
+  * @return     None.
+  */
+static void spim_prg_send_cmd(uint8_t u8Cmd)
+{
+    uint8_t cmdBuf[1];
+
+    cmdBuf[0] = u8Cmd;
+    SPIM_SET_SS_EN(1);                          /* CS activated.    */
+    SwitchNBitOutput(1UL);
+    spim_write(cmdBuf, sizeof (cmdBuf));
+    SPIM_SET_SS_EN(0);                          /* CS deactivated.  */
+}
+
+static int32_t spim_prg_queue(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T **ppsHead, SPIM_PRG_OP_T **ppsTail, SPIM_PRG_OP_T *psOp)
+{
+    uint32_t u32PriMask;
+
+    psOp->psNext = NULL;
+    psOp->i32Status = SPIM_PRG_PENDING;
+    psOp->u32SubmitTime = spim_prg_now(psPrg);
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    if (*ppsHead == NULL)
+    {
+        *ppsHead = psOp;
+    }
+    else
+    {
+        (*ppsTail)->psNext = psOp;
+    }
+    *ppsTail = psOp;
+
+    __set_PRIMASK(u32PriMask);
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Take the first operation off a queue and call its callback.
+  * @param      psPrg       Engine.
+  * @param      ppsHead     psHead or psRdHead.
+  * @param      ppsTail     psTail or psRdTail.
+  * @param      i32Status   Status of the operation.
+  * @return     None.
+  */
+static void spim_prg_retire(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T **ppsHead, SPIM_PRG_OP_T **ppsTail, int32_t i32Status)
+{
+    SPIM_PRG_OP_T *psOp = *ppsHead;
+    uint32_t u32PriMask;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    *ppsHead = psOp->psNext;
+    if (*ppsHead == NULL)
+    {
+        *ppsTail = NULL;
+    }
+
+    __set_PRIMASK(u32PriMask);
+
+    if (ppsHead == &psPrg->psHead)
+    {
+        psPrg->u32Done = 0UL;
+
+        if (psPrg->psStage == psOp)
+        {
+            psPrg->psStage = NULL;
+        }
+    }
+
+    if (i32Status != SPIM_OK)
+    {
+        psPrg->sStat.u32Errors++;
+    }
+
+    psOp->i32Status = i32Status;
+    if (psOp->pfnDone != NULL)
+    {
+        psOp->pfnDone(psOp, i32Status);
+    }
+}
+
+/**
+  * @brief      Give up the erase or program in progress.
+  * @param      psPrg       Engine.
+  * @return     None.
+  * @details    Pages staged for it, or for programs behind it, are staged again from the next program.
+  */
+static void spim_prg_fail(SPIM_PRG_T *psPrg)
+{
+    psPrg->u32State = SPIM_PRG_IDLE;
+    psPrg->u32Suspended = 0UL;
+    psPrg->psStage = NULL;
+    psPrg->u32StageLen = 0UL;
+    spim_prg_retire(psPrg, &psPrg->psHead, &psPrg->psTail, SPIM_ERR_TIMEOUT);
+}
+
+static uint32_t spim_prg_timed_out(SPIM_PRG_T *psPrg, uint32_t u32Now)
+{
+    return ((psPrg->u32Timeout != 0UL) && ((u32Now - psPrg->u32BusyTime) > psPrg->u32Timeout)) ? 1UL : 0UL;
+}
+
+/**
+  * @brief      Copy the next page to program into the free stage buffer.
+  * @param      psPrg       Engine.
+  * @return     None.
+  * @details    Pages are staged in queue order; erases in between are skipped, they do not
+  *             change what is programmed next.
+  */
+static void spim_prg_stage(SPIM_PRG_T *psPrg)
+{
+    SPIM_PRG_OP_T *psOp = psPrg->psStage;
+    uint8_t *pu8Buf;
+    uint32_t u32Len;
+
+    if (psPrg->u32StageLen != 0UL)
+    {
+        return;
+    }
+
+    if ((psOp == NULL) || (psPrg->u32StageOff == psOp->u32Len))
+    {
+        psOp = (psOp == NULL) ? psPrg->psHead : psOp->psNext;
+
+        while ((psOp != NULL) && (psOp->u32Type != SPIM_PRG_OP_PROGRAM))
+        {
+            psOp = psOp->psNext;
+        }
+
+        if (psOp == NULL)
+        {
+            return;
+        }
+
+        psPrg->psStage = psOp;
+        psPrg->u32StageOff = 0UL;
+    }
+
+    /* Up to the end of the flash page */
+    u32Len = SPIM_PRG_PAGE_SIZE - ((psOp->u32Addr + psPrg->u32StageOff) % SPIM_PRG_PAGE_SIZE);
+    if (u32Len > (psOp->u32Len - psPrg->u32StageOff))
+    {
+        u32Len = psOp->u32Len - psPrg->u32StageOff;
+    }
+
+    pu8Buf = (uint8_t *)psPrg->au32Stage[psPrg->u32StageIdx];
+
+    if (psPrg->psCopy != NULL)
+    {
+        psPrg->u32StageFence = PDMA_MemCopy(psPrg->psCopy, pu8Buf, &psOp->pu8Src[psPrg->u32StageOff], u32Len);
+    }
+    else
+    {
+        memcpy(pu8Buf, &psOp->pu8Src[psPrg->u32StageOff], u32Len);
+    }
+
+    psPrg->u32StageLen = u32Len;
+    psPrg->u32StageOff += u32Len;
+}
+
+/**
+  * @brief      Write the staged page, which is the next one of psHead.
+  * @param      psPrg       Engine.
+  * @return     None.
+  */
+static void spim_prg_start_page(SPIM_PRG_T *psPrg)
+{
+    uint32_t u32Now = spim_prg_now(psPrg);
+
+    if (psPrg->u32Done == 0UL)
+    {
+        psPrg->u32OpTime = u32Now;
+    }
+    psPrg->u32BusyTime = u32Now;
+    psPrg->u32PageLen = psPrg->u32StageLen;
+    psPrg->u32Stalled = 0UL;
+
+    SPIM_SET_OPMODE(SPIM_CTL0_OPMODE_PAGEWRITE);/* Switch to Page Write mode.   */
+    SPIM_SET_SPIM_MODE(psPrg->u32WrCmd);        /* SPIM mode.       */
+    SPIM_SET_4BYTE_ADDR_EN(psPrg->u32Is4ByteAddr);  /* Enable/disable 4-Byte Address.  */
+
+    SPIM->SRAMADDR = (uint32_t) psPrg->au32Stage[psPrg->u32StageIdx];  /* SRAM address.  */
+    SPIM->DMACNT = psPrg->u32PageLen;            /* Transfer length. */
+    SPIM->FADDR = psPrg->psHead->u32Addr + psPrg->u32Done;  /* Flash address. */
+    SPIM_SET_GO();                               /* Go.              */
+
+    psPrg->u32State = SPIM_PRG_PAGE;
+    psPrg->u32StageLen = 0UL;
+    psPrg->u32StageIdx ^= 1UL;
+
+    /* The flash programs for hundreds of microseconds, time to fetch the next page */
+    spim_prg_stage(psPrg);
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Initialize a programming engine.
+  * @param      psPrg       Engine, in SRAM.
+  * @param      is4ByteAddr 4-byte address or not.
+  * @param      u32WrCmd    Page Write mode command: CMD_NORMAL_PAGE_PROGRAM, CMD_NORMAL_PAGE_PROGRAM_4B,
+  *                         CMD_QUAD_PAGE_PROGRAM_WINBOND or CMD_QUAD_PAGE_PROGRAM_MXIC.
+  * @param      u32RdCmd    Page Read mode command, e.g. CMD_DMA_FAST_READ.
+  * @param      psCopy      Copy service staging the pages by PDMA, or NULL to stage them by CPU.
+  * @retval     SPIM_OK          Engine ready.
+  * @retval     SPIM_ERR_FAIL    u32WrCmd is CMD_QUAD_PAGE_PROGRAM_EON, which needs QPI mode around each page.
+  * @details    Quad Enable is set once here for quad commands. pfnGetTime, u8SuspendCmd, u8ResumeCmd,
+  *             u32ResumeHold and u32Timeout may be changed after this call; pfnGetTime is NULL and
+  *             the suspend commands are \ref SPIM_PRG_ERASE_SUSPEND and \ref SPIM_PRG_ERASE_RESUME.
+  */
+int32_t SPIM_PrgInit(SPIM_PRG_T *psPrg, int is4ByteAddr, uint32_t u32WrCmd, uint32_t u32RdCmd, PDMA_COPY_T *psCopy)
+{
+    if (u32WrCmd == CMD_QUAD_PAGE_PROGRAM_EON)
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    memset(psPrg, 0, sizeof (SPIM_PRG_T));
+    psPrg->u32Is4ByteAddr = is4ByteAddr ? 1UL : 0UL;
+    psPrg->u32WrCmd = u32WrCmd;
+    psPrg->u32RdCmd = u32RdCmd;
+    psPrg->psCopy = psCopy;
+    psPrg->u8SuspendCmd = SPIM_PRG_ERASE_SUSPEND;
+    psPrg->u8ResumeCmd = SPIM_PRG_ERASE_RESUME;
+
+    if ((u32WrCmd == CMD_QUAD_PAGE_PROGRAM_WINBOND) || (u32WrCmd == CMD_QUAD_PAGE_PROGRAM_MXIC) ||
+            (u32RdCmd == CMD_DMA_FAST_READ_QUAD_OUTPUT) || (u32RdCmd == CMD_DMA_NORMAL_QUAD_READ) ||
+            (u32RdCmd == CMD_DMA_FAST_QUAD_READ))
+    {
+        SPIM_SetQuadEnable(1, 1UL);              /* Set Quad Enable. */
+    }
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Queue a block erase.
+  * @param      psPrg       Engine.
+  * @param      psOp        Operation, owned by the engine until the callback.
+  * @param      u32Addr     Block to erase which contains the u32Addr.
+  * @param      u8ErsCmd    OPCODE_SE_4K, OPCODE_BE_32K or OPCODE_BE_64K.
+  * @param      pfnDone     Completion callback, may be NULL.
+  * @param      pvArg       Caller context stored in psOp->pvArg.
+  * @retval     SPIM_OK          Queued, runs after the erases and programs queued before.
+  * @retval     SPIM_ERR_FAIL    Unknown erase command.
+  */
+int32_t SPIM_PrgErase(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, uint8_t u8ErsCmd, SPIM_PRG_CB_T pfnDone, void *pvArg)
+{
+    if ((u8ErsCmd != OPCODE_SE_4K) && (u8ErsCmd != OPCODE_BE_32K) && (u8ErsCmd != OPCODE_BE_64K))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    psOp->u32Type = SPIM_PRG_OP_ERASE;
+    psOp->u32Addr = u32Addr;
+    psOp->u32Len = 0UL;
+    psOp->u32ErsCmd = u8ErsCmd;
+    psOp->pu8Src = NULL;
+    psOp->pu8Dst = NULL;
+    psOp->pfnDone = pfnDone;
+    psOp->pvArg = pvArg;
+
+    return spim_prg_queue(psPrg, &psPrg->psHead, &psPrg->psTail, psOp);
+}
+
+/**
+  * @brief      Queue a program of any length, split at page boundaries.
+  * @param      psPrg       Engine.
+  * @param      psOp        Operation, owned by the engine until the callback.
+  * @param      u32Addr     Start address to write.
+  * @param      pu8Src      Data, read page by page while the program runs; must stay unchanged
+  *                         until the callback.
+  * @param      u32Len      Number of bytes to write.
+  * @param      pfnDone     Completion callback, may be NULL.
+  * @param      pvArg       Caller context stored in psOp->pvArg.
+  * @retval     SPIM_OK          Queued, runs after the erases and programs queued before.
+  * @retval     SPIM_ERR_FAIL    No data.
+  */
+int32_t SPIM_PrgProgram(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, const uint8_t *pu8Src, uint32_t u32Len,
+                        SPIM_PRG_CB_T pfnDone, void *pvArg)
+{
+    if ((pu8Src == NULL) || (u32Len == 0UL))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    psOp->u32Type = SPIM_PRG_OP_PROGRAM;
+    psOp->u32Addr = u32Addr;
+    psOp->u32Len = u32Len;
+    psOp->u32ErsCmd = 0UL;
+    psOp->pu8Src = pu8Src;
+    psOp->pu8Dst = NULL;
+    psOp->pfnDone = pfnDone;
+    psOp->pvArg = pvArg;
+
+    return spim_prg_queue(psPrg, &psPrg->psHead, &psPrg->psTail, psOp);
+}
+
+/**
+  * @brief      Queue a read by Page Read mode.
+  * @param      psPrg       Engine.
+  * @param      psOp        Operation, owned by the engine until the callback.
+  * @param      u32Addr     Start address to read.
+  * @param      pu8Dst      Receive buffer in SRAM.
+  * @param      u32Len      Number of bytes to read.
+  * @param      pfnDone     Completion callback, may be NULL.
+  * @param      pvArg       Caller context stored in psOp->pvArg.
+  * @retval     SPIM_OK          Queued.
+  * @retval     SPIM_ERR_FAIL    No buffer, or more bytes than one DMA transfer takes.
+  * @details    Reads run before the erases and programs waiting: a running page write is
+  *             finished first, a running erase is suspended once it ran u32ResumeHold ticks.
+  *             The block being erased reads back undefined data while suspended.
+  */
+int32_t SPIM_PrgRead(SPIM_PRG_T *psPrg, SPIM_PRG_OP_T *psOp, uint32_t u32Addr, uint8_t *pu8Dst, uint32_t u32Len,
+                     SPIM_PRG_CB_T pfnDone, void *pvArg)
+{
+    if ((pu8Dst == NULL) || (u32Len == 0UL) || (u32Len > SPIM_DMACNT_DMACNT_Msk))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    psOp->u32Type = SPIM_PRG_OP_READ;
+    psOp->u32Addr = u32Addr;
+    psOp->u32Len = u32Len;
+    psOp->u32ErsCmd = 0UL;
+    psOp->pu8Src = NULL;
+    psOp->pu8Dst = pu8Dst;
+    psOp->pfnDone = pfnDone;
+    psOp->pvArg = pvArg;
+
+    return spim_prg_queue(psPrg, &psPrg->psRdHead, &psPrg->psRdTail, psOp);
+}
+
+/**
+  * @brief      Advance the programming engine.
+  * @param      psPrg       Engine.
+  * @return     0 when every queued operation is done, 1 while work is left.
+  * @details    Never waits for the flash: it checks SPIM and the flash status once, starts what
+  *             can be started and returns. Call it from the main loop, a periodic timer or the
+  *             PDMA/SPIM interrupt; a call made while another one runs returns at once.
+  *             Callbacks run from here.
+  */
+uint32_t SPIM_PrgPoll(SPIM_PRG_T *psPrg)
+{
+    SPIM_PRG_OP_T *psOp;
+    uint32_t u32PriMask, u32InPoll, u32Now, u32Run = 1UL;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+    u32InPoll = psPrg->u32InPoll;
+    psPrg->u32InPoll = 1UL;
+    __set_PRIMASK(u32PriMask);
+
+    if (u32InPoll)
+    {
+        return 1UL;
+    }
+
+    while (u32Run)
+    {
+        u32Run = 0UL;
+        u32Now = spim_prg_now(psPrg);
+
+        switch (psPrg->u32State)
+        {
+        case SPIM_PRG_READ:
+            if (SPIM_IS_BUSY())
+            {
+                break;
+            }
+
+            psOp = psPrg->psRdHead;
+            psPrg->sStat.u32Reads++;
+            if ((u32Now - psOp->u32SubmitTime) > psPrg->sStat.u32MaxReadLatency)
+            {
+                psPrg->sStat.u32MaxReadLatency = u32Now - psOp->u32SubmitTime;
+            }
+
+            psPrg->u32State = SPIM_PRG_IDLE;
+            spim_prg_retire(psPrg, &psPrg->psRdHead, &psPrg->psRdTail, SPIM_OK);
+            u32Run = 1UL;
+            break;
+
+        case SPIM_PRG_PAGE:
+            /* Page Write mode may free SPIM before the flash has finished: WIP tells */
+            if (SPIM_IS_BUSY() || !spim_is_write_done(1UL))
+            {
+                if (spim_prg_timed_out(psPrg, u32Now))
+                {
+                    spim_prg_fail(psPrg);
+                    u32Run = 1UL;
+                }
+                break;
+            }
+
+            psPrg->sStat.u32Pages++;
+            psPrg->sStat.u32ProgBytes += psPrg->u32PageLen;
+            psPrg->u32Done += psPrg->u32PageLen;
+            psPrg->u32State = SPIM_PRG_IDLE;
+
+            if (psPrg->u32Done == psPrg->psHead->u32Len)
+            {
+                psPrg->sStat.u32ProgTime += u32Now - psPrg->u32OpTime;
+                spim_prg_retire(psPrg, &psPrg->psHead, &psPrg->psTail, SPIM_OK);
+            }
+            u32Run = 1UL;
+            break;
+
+        case SPIM_PRG_ERASE:
+            if (spim_is_write_done(1UL))
+            {
+                psPrg->sStat.u32Erases++;
+                psPrg->sStat.u32EraseTime += u32Now - psPrg->u32BusyTime;
+                psPrg->u32State = SPIM_PRG_IDLE;
+                spim_prg_retire(psPrg, &psPrg->psHead, &psPrg->psTail, SPIM_OK);
+                u32Run = 1UL;
+            }
+            else if ((psPrg->psRdHead != NULL) && ((u32Now - psPrg->u32ResumeTime) >= psPrg->u32ResumeHold))
+            {
+                spim_prg_send_cmd(psPrg->u8SuspendCmd);
+                psPrg->sStat.u32Suspends++;
+                psPrg->sStat.u32EraseTime += u32Now - psPrg->u32BusyTime;
+                psPrg->u32BusyTime = u32Now;
+                psPrg->u32State = SPIM_PRG_SUSPENDING;
+                u32Run = 1UL;
+            }
+            else if (spim_prg_timed_out(psPrg, u32Now))
+            {
+                spim_prg_fail(psPrg);
+                u32Run = 1UL;
+            }
+            break;
+
+        case SPIM_PRG_SUSPENDING:
+            /* WIP also clears when the erase finished instead, the resume is then ignored */
+            if (spim_is_write_done(1UL))
+            {
+                psPrg->u32Suspended = 1UL;
+                psPrg->u32State = SPIM_PRG_IDLE;
+                u32Run = 1UL;
+            }
+            else if (spim_prg_timed_out(psPrg, u32Now))
+            {
+                spim_prg_fail(psPrg);
+                u32Run = 1UL;
+            }
+            break;
+
+        default:
+            /* A timed out page write may still hold SPIM */
+            if (SPIM_IS_BUSY())
+            {
+                break;
+            }
+
+            if (psPrg->psRdHead != NULL)
+            {
+                psOp = psPrg->psRdHead;
+                psPrg->u32State = SPIM_PRG_READ;
+                SPIM_DMA_Read(psOp->u32Addr, (int)psPrg->u32Is4ByteAddr, psOp->u32Len, psOp->pu8Dst, psPrg->u32RdCmd, 0);
+                break;
+            }
+
+            if (psPrg->u32Suspended)
+            {
+                spim_prg_send_cmd(psPrg->u8ResumeCmd);
+                psPrg->u32Suspended = 0UL;
+                psPrg->u32BusyTime = u32Now;
+                psPrg->u32ResumeTime = u32Now;
+                psPrg->u32State = SPIM_PRG_ERASE;
+                break;
+            }
+
+            psOp = psPrg->psHead;
+            if (psOp == NULL)
+            {
+                break;
+            }
+
+            if (psOp->u32Type == SPIM_PRG_OP_ERASE)
+            {
+                SPIM_EraseBlock(psOp->u32Addr, (int)psPrg->u32Is4ByteAddr, (uint8_t)psOp->u32ErsCmd, 1UL, 0);
+                psPrg->u32BusyTime = u32Now;
+                psPrg->u32ResumeTime = u32Now;
+                psPrg->u32State = SPIM_PRG_ERASE;
+
+                /* Fetch the first page of the next program during the erase */
+                spim_prg_stage(psPrg);
+                break;
+            }
+
+            if (psPrg->u32StageLen == 0UL)
+            {
+                psPrg->u32Stalled = 1UL;
+                psPrg->sStat.u32StageStalls++;
+                spim_prg_stage(psPrg);
+            }
+
+            if ((psPrg->psCopy != NULL) && !PDMA_CopyIsDone(psPrg->psCopy, psPrg->u32StageFence))
+            {
+                if (!psPrg->u32Stalled)
+                {
+                    psPrg->u32Stalled = 1UL;
+                    psPrg->sStat.u32StageStalls++;
+                }
+                break;
+            }
+
+            spim_prg_start_page(psPrg);
+            break;
+        }
+    }
+
+    u32Run = ((psPrg->u32State != SPIM_PRG_IDLE) || psPrg->u32Suspended ||
+              (psPrg->psHead != NULL) || (psPrg->psRdHead != NULL)) ? 1UL : 0UL;
+    psPrg->u32InPoll = 0UL;
+
+    return u32Run;
+}
+
+/**
+  * @brief      Get the programming throughput.
+  * @param      psPrg       Engine.
+  * @return     Bytes programmed per 1000 ticks of pfnGetTime() since the statistics were cleared,
+  *             KB/s with a microsecond time source. Erases are not part of it.
+  */
+uint32_t SPIM_PrgGetThroughput(SPIM_PRG_T *psPrg)
+{
+    return (psPrg->sStat.u32ProgTime != 0UL) ?
+           (uint32_t)(((uint64_t)psPrg->sStat.u32ProgBytes * 1000ULL) / psPrg->sStat.u32ProgTime) : 0UL;
+}
+
+/**
+  * @brief      Clear the statistics of a programming engine.
+  * @param      psPrg       Engine.
+  * @return     None.
+  */
+void SPIM_PrgClearStats(SPIM_PRG_T *psPrg)
+{
+    memset(&psPrg->sStat, 0, sizeof (psPrg->sStat));
+}
+
+
+/** @cond HIDDEN_SYMBOLS */
+
+#define SPIM_FTL_MAGIC          0x4C54464EUL    /* "NFTL", first word of the block header */
+#define SPIM_FTL_MARK_OFF       12UL            /* Sequence number and its complement, programmed when the block is opened */
+#define SPIM_FTL_TAG_OFF        64UL            /* Tag of slot 1: sector number, sequence number, each with its complement */
+#define SPIM_FTL_TAG_LEN        16UL
+#define SPIM_FTL_META_LEN       (SPIM_FTL_TAG_OFF + SPIM_FTL_SLOTS * SPIM_FTL_TAG_LEN)
+#define SPIM_FTL_GC_LOW         2UL             /* Free blocks kept: one for each open block */
+#define SPIM_FTL_UNMAPPED       0xFFFFU
+#define SPIM_FTL_NONE           0xFFFFFFFFUL
+
+#define SPIM_FTL_BLK_FREE       0U              /* Erased, or queued for erase */
+#define SPIM_FTL_BLK_OPEN       1U              /* Being written */
+#define SPIM_FTL_BLK_CLOSED     2U              /* Written, holds current and stale sectors */
+#define SPIM_FTL_BLK_DIRTY      3U              /* Found at mount, must be erased */
+#define SPIM_FTL_BLK_BLANK      4U              /* Found at mount, erased but without header */
+
+#define SPIM_FTL_HOST           0UL             /* Write stream of the caller */
+#define SPIM_FTL_GC             1UL             /* Write stream of garbage collection and wear leveling */
+
+/* Map entry of a slot: slot 0 is the header sector, so slots number 1 to SPIM_FTL_SLOTS */
+#define SPIM_FTL_PHYS(blk, slot)    ((blk) * (SPIM_FTL_SLOTS + 1UL) + (slot))
+
+static uint32_t spim_ftl_addr(SPIM_FTL_T *psFtl, uint32_t u32Blk, uint32_t u32Off)
+{
+    return psFtl->u32Base + u32Blk * SPIM_FTL_BLOCK_SIZE + u32Off;
+}
+
+static void spim_ftl_done(SPIM_PRG_OP_T *psOp, int32_t i32Status)
+{
+    if (i32Status != SPIM_OK)
+    {
+        ((SPIM_FTL_T *)psOp->pvArg)->sStat.u32Errors++;
+    }
+}
+
+/**
+  * @brief      Drive the engine until an operation is done.
+  * @param      psFtl       FTL.
+  * @param      psOp        Operation; one never queued counts as done.
+  * @return     Status of the operation.
+  */
+static int32_t spim_ftl_wait(SPIM_FTL_T *psFtl, SPIM_PRG_OP_T *psOp)
+{
+    while (psOp->i32Status == SPIM_PRG_PENDING)
+    {
+        if (SPIM_PrgPoll(psFtl->psPrg) && (psFtl->pfnIdle != NULL))
+        {
+            psFtl->pfnIdle();
+        }
+    }
+
+    return psOp->i32Status;
+}
+
+static int32_t spim_ftl_read(SPIM_FTL_T *psFtl, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    if (SPIM_PrgRead(psFtl->psPrg, &psFtl->sRdOp, u32Addr, pu8Buf, u32Len, spim_ftl_done, psFtl) != SPIM_OK)
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    return spim_ftl_wait(psFtl, &psFtl->sRdOp);
+}
+
+/**
+  * @brief      Queue the erase of a block and the program of its new header.
+  * @param      psFtl       FTL.
+  * @param      u32Blk      Block.
+  * @param      u32EraseCnt Erase count to record.
+  * @param      u32Erase    0 when the block is known to be blank and only needs the header.
+  * @return     None.
+  * @details    The block is free at once: whatever is programmed into it later is queued behind
+  *             the erase. Only sectors already copied elsewhere are left in it, so nothing reads it.
+  */
+static void spim_ftl_erase(SPIM_FTL_T *psFtl, uint32_t u32Blk, uint32_t u32EraseCnt, uint32_t u32Erase)
+{
+    SPIM_FTL_ERASE_T *psJob = &psFtl->asErase[psFtl->u32EraseIdx];
+    SPIM_FTL_BLK_T *psBlk = &psFtl->asBlk[u32Blk];
+
+    psFtl->u32EraseIdx = (psFtl->u32EraseIdx + 1UL) % SPIM_FTL_ERASE_JOBS;
+
+    /* Jobs complete in queue order, the one reused is the oldest */
+    spim_ftl_wait(psFtl, &psJob->sHdr);
+
+    psJob->au32Hdr[0] = SPIM_FTL_MAGIC;
+    psJob->au32Hdr[1] = u32EraseCnt;
+    psJob->au32Hdr[2] = ~u32EraseCnt;
+
+    if (u32Erase)
+    {
+        SPIM_PrgErase(psFtl->psPrg, &psJob->sErase, spim_ftl_addr(psFtl, u32Blk, 0UL), OPCODE_SE_4K, spim_ftl_done, psFtl);
+        psFtl->sStat.u32Erases++;
+    }
+    SPIM_PrgProgram(psFtl->psPrg, &psJob->sHdr, spim_ftl_addr(psFtl, u32Blk, 0UL), (uint8_t *)psJob->au32Hdr,
+                    sizeof (psJob->au32Hdr), spim_ftl_done, psFtl);
+
+    psBlk->u32EraseCnt = u32EraseCnt;
+    psBlk->u32Seq = SPIM_FTL_NONE;
+    psBlk->u8State = SPIM_FTL_BLK_FREE;
+    psBlk->u8Valid = 0U;
+    psFtl->u32FreeCnt++;
+
+    /* Start it now, it runs on while the caller goes on */
+    SPIM_PrgPoll(psFtl->psPrg);
+}
+
+/**
+  * @brief      Close the open block of a write stream and open a free one.
+  * @param      psFtl       FTL.
+  * @param      u32Stream   SPIM_FTL_HOST or SPIM_FTL_GC.
+  * @retval     SPIM_OK          Block opened.
+  * @retval     SPIM_ERR_FAIL    No free block.
+  * @details    Dynamic wear leveling: host writes get the least worn free block, the cold data
+  *             garbage collection moves gets the most worn one, which it will rarely erase again.
+  */
+static int32_t spim_ftl_open(SPIM_FTL_T *psFtl, uint32_t u32Stream)
+{
+    uint32_t i, u32Blk = psFtl->u32Blocks;
+
+    for (i = 0UL; i < psFtl->u32Blocks; i++)
+    {
+        if ((psFtl->asBlk[i].u8State == SPIM_FTL_BLK_FREE) &&
+                ((u32Blk == psFtl->u32Blocks) ||
+                 ((u32Stream == SPIM_FTL_HOST) ? (psFtl->asBlk[i].u32EraseCnt < psFtl->asBlk[u32Blk].u32EraseCnt) :
+                  (psFtl->asBlk[i].u32EraseCnt > psFtl->asBlk[u32Blk].u32EraseCnt))))
+        {
+            u32Blk = i;
+        }
+    }
+
+    if (u32Blk == psFtl->u32Blocks)
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    if (psFtl->au32Open[u32Stream] < psFtl->u32Blocks)
+    {
+        psFtl->asBlk[psFtl->au32Open[u32Stream]].u8State = SPIM_FTL_BLK_CLOSED;
+    }
+
+    /* The mark tells the mount the block is no longer free, even before a tag is programmed */
+    spim_ftl_wait(psFtl, &psFtl->sOpenOp);
+    psFtl->au32Mark[0] = psFtl->u32Seq;
+    psFtl->au32Mark[1] = ~psFtl->u32Seq;
+    SPIM_PrgProgram(psFtl->psPrg, &psFtl->sOpenOp, spim_ftl_addr(psFtl, u32Blk, SPIM_FTL_MARK_OFF), (uint8_t *)psFtl->au32Mark,
+                    sizeof (psFtl->au32Mark), spim_ftl_done, psFtl);
+
+    psFtl->asBlk[u32Blk].u32Seq = psFtl->u32Seq;
+    psFtl->asBlk[u32Blk].u8State = SPIM_FTL_BLK_OPEN;
+    psFtl->asBlk[u32Blk].u8Valid = 0U;
+    psFtl->u32FreeCnt--;
+    psFtl->au32Open[u32Stream] = u32Blk;
+    psFtl->au32NextSlot[u32Stream] = 1UL;
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Write sectors into the next slots of an open block and remap them.
+  * @param      psFtl       FTL.
+  * @param      u32Stream   SPIM_FTL_HOST or SPIM_FTL_GC.
+  * @param      au32Lsn     Sector numbers.
+  * @param      pu8Buf      Their data, back to back.
+  * @param      u32Count    Number of sectors, no more than the open block has slots left.
+  * @return     SPIM_OK, or the error of the program.
+  */
+static int32_t spim_ftl_put(SPIM_FTL_T *psFtl, uint32_t u32Stream, const uint32_t au32Lsn[], const uint8_t *pu8Buf,
+                            uint32_t u32Count)
+{
+    uint32_t u32Blk = psFtl->au32Open[u32Stream], u32Slot = psFtl->au32NextSlot[u32Stream];
+    uint32_t i, u32Old;
+    int32_t i32Ret;
+
+    for (i = 0UL; i < u32Count; i++)
+    {
+        psFtl->au32Tag[i * 4UL] = au32Lsn[i];
+        psFtl->au32Tag[i * 4UL + 1UL] = ~au32Lsn[i];
+        psFtl->au32Tag[i * 4UL + 2UL] = psFtl->u32Seq;
+        psFtl->au32Tag[i * 4UL + 3UL] = ~psFtl->u32Seq;
+        psFtl->asBlk[u32Blk].u32Seq = psFtl->u32Seq++;
+    }
+
+    /* The tags follow the data: a tag on the flash means its sector is complete */
+    SPIM_PrgProgram(psFtl->psPrg, &psFtl->sDataOp, spim_ftl_addr(psFtl, u32Blk, u32Slot * SPIM_FTL_SECTOR_SIZE), pu8Buf,
+                    u32Count * SPIM_FTL_SECTOR_SIZE, spim_ftl_done, psFtl);
+    SPIM_PrgProgram(psFtl->psPrg, &psFtl->sTagOp, spim_ftl_addr(psFtl, u32Blk, SPIM_FTL_TAG_OFF + (u32Slot - 1UL) * SPIM_FTL_TAG_LEN),
+                    (uint8_t *)psFtl->au32Tag, u32Count * SPIM_FTL_TAG_LEN, spim_ftl_done, psFtl);
+    psFtl->au32NextSlot[u32Stream] += u32Count;
+
+    i32Ret = spim_ftl_wait(psFtl, &psFtl->sTagOp);
+    if (i32Ret == SPIM_OK)
+    {
+        i32Ret = psFtl->sDataOp.i32Status;
+    }
+    if (i32Ret != SPIM_OK)
+    {
+        return i32Ret;
+    }
+
+    for (i = 0UL; i < u32Count; i++)
+    {
+        u32Old = psFtl->au16Map[au32Lsn[i]];
+        if (u32Old != SPIM_FTL_UNMAPPED)
+        {
+            psFtl->asBlk[u32Old / (SPIM_FTL_SLOTS + 1UL)].u8Valid--;
+        }
+        psFtl->au16Map[au32Lsn[i]] = (uint16_t)SPIM_FTL_PHYS(u32Blk, u32Slot + i);
+    }
+    psFtl->asBlk[u32Blk].u8Valid += (uint8_t)u32Count;
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Move the current sectors of a closed block to the garbage collection stream and erase it.
+  * @param      psFtl       FTL.
+  * @param      u32Blk      Block.
+  * @return     SPIM_OK, or the error that stopped the move; the block is then left as it is.
+  */
+static int32_t spim_ftl_relocate(SPIM_FTL_T *psFtl, uint32_t u32Blk)
+{
+    uint8_t *pu8Buf = (uint8_t *)psFtl->au32Buf;
+    uint32_t au32Lsn[SPIM_FTL_SLOTS];
+    uint32_t i, u32Lsn, u32Room, u32Cnt = 0UL;
+    int32_t i32Ret;
+
+    if (psFtl->asBlk[u32Blk].u8Valid != 0U)
+    {
+        if ((i32Ret = spim_ftl_read(psFtl, spim_ftl_addr(psFtl, u32Blk, 0UL), pu8Buf, SPIM_FTL_BLOCK_SIZE)) != SPIM_OK)
+        {
+            return i32Ret;
+        }
+
+        /* Keep the slots the map still points to, packed behind the header sector */
+        for (i = 1UL; i <= SPIM_FTL_SLOTS; i++)
+        {
+            u32Lsn = psFtl->au32Buf[(SPIM_FTL_TAG_OFF + (i - 1UL) * SPIM_FTL_TAG_LEN) / 4UL];
+
+            if ((u32Lsn < psFtl->u32Sectors) && (psFtl->au16Map[u32Lsn] == SPIM_FTL_PHYS(u32Blk, i)))
+            {
+                au32Lsn[u32Cnt++] = u32Lsn;
+                if (i != u32Cnt)
+                {
+                    memcpy(&pu8Buf[u32Cnt * SPIM_FTL_SECTOR_SIZE], &pu8Buf[i * SPIM_FTL_SECTOR_SIZE], SPIM_FTL_SECTOR_SIZE);
+                }
+            }
+        }
+
+        for (i = 0UL; i < u32Cnt; i += u32Room)
+        {
+            if ((psFtl->au32NextSlot[SPIM_FTL_GC] > SPIM_FTL_SLOTS) && ((i32Ret = spim_ftl_open(psFtl, SPIM_FTL_GC)) != SPIM_OK))
+            {
+                return i32Ret;
+            }
+
+            u32Room = SPIM_FTL_SLOTS + 1UL - psFtl->au32NextSlot[SPIM_FTL_GC];
+            if (u32Room > (u32Cnt - i))
+            {
+                u32Room = u32Cnt - i;
+            }
+
+            if ((i32Ret = spim_ftl_put(psFtl, SPIM_FTL_GC, &au32Lsn[i], &pu8Buf[(i + 1UL) * SPIM_FTL_SECTOR_SIZE], u32Room)) != SPIM_OK)
+            {
+                return i32Ret;
+            }
+            psFtl->sStat.u32GcCopies += u32Room;
+        }
+    }
+
+    spim_ftl_erase(psFtl, u32Blk, psFtl->asBlk[u32Blk].u32EraseCnt + 1UL, 1UL);
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Static wear leveling: free the least worn closed block once the spread is too wide.
+  * @param      psFtl       FTL.
+  * @return     SPIM_OK, or the error of the move.
+  * @details    Cold data pins its block at a low erase count; moving it out lets the block take
+  *             writes again, while the data joins the other cold data in the garbage collection stream.
+  */
+static int32_t spim_ftl_level(SPIM_FTL_T *psFtl)
+{
+    uint32_t i, u32Max = 0UL, u32Cold = psFtl->u32Blocks;
+    int32_t i32Ret;
+
+    if (psFtl->u32WlThreshold == 0UL)
+    {
+        return SPIM_OK;
+    }
+
+    for (i = 0UL; i < psFtl->u32Blocks; i++)
+    {
+        if (psFtl->asBlk[i].u32EraseCnt > u32Max)
+        {
+            u32Max = psFtl->asBlk[i].u32EraseCnt;
+        }
+
+        if ((psFtl->asBlk[i].u8State == SPIM_FTL_BLK_CLOSED) &&
+                ((u32Cold == psFtl->u32Blocks) || (psFtl->asBlk[i].u32EraseCnt < psFtl->asBlk[u32Cold].u32EraseCnt)))
+        {
+            u32Cold = i;
+        }
+    }
+
+    if ((u32Cold == psFtl->u32Blocks) || ((u32Max - psFtl->asBlk[u32Cold].u32EraseCnt) <= psFtl->u32WlThreshold))
+    {
+        return SPIM_OK;
+    }
+
+    if ((i32Ret = spim_ftl_relocate(psFtl, u32Cold)) == SPIM_OK)
+    {
+        psFtl->sStat.u32WlMoves++;
+    }
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Garbage collection: reclaim blocks until SPIM_FTL_GC_LOW are free.
+  * @param      psFtl       FTL.
+  * @retval     SPIM_OK          Enough free blocks.
+  * @retval     SPIM_ERR_FAIL    No block to reclaim.
+  * @details    Greedy: the closed block with the fewest current sectors costs the fewest copies.
+  *             With SPIM_FTL_MIN_SPARE spare blocks, two of them open, one always has a stale slot. Static wear
+  *             leveling runs after a collection, so it costs at most one move per reclaimed block.
+  */
+static int32_t spim_ftl_collect(SPIM_FTL_T *psFtl)
+{
+    uint32_t i, u32Victim, u32Runs = 0UL;
+    int32_t i32Ret;
+
+    while (psFtl->u32FreeCnt < SPIM_FTL_GC_LOW)
+    {
+        u32Victim = psFtl->u32Blocks;
+
+        for (i = 0UL; i < psFtl->u32Blocks; i++)
+        {
+            if ((psFtl->asBlk[i].u8State == SPIM_FTL_BLK_CLOSED) &&
+                    ((u32Victim == psFtl->u32Blocks) ||
+                     (psFtl->asBlk[i].u8Valid < psFtl->asBlk[u32Victim].u8Valid) ||
+                     ((psFtl->asBlk[i].u8Valid == psFtl->asBlk[u32Victim].u8Valid) &&
+                      (psFtl->asBlk[i].u32EraseCnt < psFtl->asBlk[u32Victim].u32EraseCnt))))
+            {
+                u32Victim = i;
+            }
+        }
+
+        if ((u32Victim == psFtl->u32Blocks) || (psFtl->asBlk[u32Victim].u8Valid == SPIM_FTL_SLOTS))
+        {
+            return SPIM_ERR_FAIL;
+        }
+
+        if ((i32Ret = spim_ftl_relocate(psFtl, u32Victim)) != SPIM_OK)
+        {
+            return i32Ret;
+        }
+
+        psFtl->sStat.u32GcRuns++;
+        u32Runs++;
+    }
+
+    return (u32Runs != 0UL) ? spim_ftl_level(psFtl) : SPIM_OK;
+}
+
+static uint32_t spim_ftl_is_blank(SPIM_FTL_T *psFtl, uint32_t u32Blk)
+{
+    uint32_t i, j;
+
+    for (i = 0UL; i < SPIM_FTL_BLOCK_SIZE; i += SPIM_FTL_SECTOR_SIZE)
+    {
+        if (spim_ftl_read(psFtl, spim_ftl_addr(psFtl, u32Blk, i), (uint8_t *)psFtl->au32Buf, SPIM_FTL_SECTOR_SIZE) != SPIM_OK)
+        {
+            return 0UL;
+        }
+
+        for (j = 0UL; j < (SPIM_FTL_SECTOR_SIZE / 4UL); j++)
+        {
+            if (psFtl->au32Buf[j] != 0xFFFFFFFFUL)
+            {
+                return 0UL;
+            }
+        }
+    }
+
+    return 1UL;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Initialize a flash translation layer.
+  * @param      psFtl       FTL, in SRAM.
+  * @param      psPrg       Programming engine set up by SPIM_PrgInit(); the FTL drives it with SPIM_PrgPoll().
+  * @param      u32Base     Flash address of the area, a multiple of \ref SPIM_FTL_BLOCK_SIZE.
+  * @param      u32Blocks   Blocks of \ref SPIM_FTL_BLOCK_SIZE in the area, up to \ref SPIM_FTL_MAX_BLOCKS.
+  * @param      u32Spare    Blocks kept back for garbage collection, at least \ref SPIM_FTL_MIN_SPARE;
+  *                         more spare blocks lower the write amplification.
+  * @retval     SPIM_OK          Ready for SPIM_FtlMount().
+  * @retval     SPIM_ERR_FAIL    Invalid area.
+  * @details    pfnIdle and u32WlThreshold may be changed after this call; pfnIdle is NULL and
+  *             u32WlThreshold is \ref SPIM_FTL_WL_THRESHOLD.
+  */
+int32_t SPIM_FtlInit(SPIM_FTL_T *psFtl, SPIM_PRG_T *psPrg, uint32_t u32Base, uint32_t u32Blocks, uint32_t u32Spare)
+{
+    if ((psPrg == NULL) || ((u32Base % SPIM_FTL_BLOCK_SIZE) != 0UL) || (u32Blocks > SPIM_FTL_MAX_BLOCKS) ||
+            (u32Spare < SPIM_FTL_MIN_SPARE) || (u32Spare >= u32Blocks))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    memset(psFtl, 0, sizeof (SPIM_FTL_T));
+    psFtl->psPrg = psPrg;
+    psFtl->u32Base = u32Base;
+    psFtl->u32Blocks = u32Blocks;
+    psFtl->u32Sectors = (u32Blocks - u32Spare) * SPIM_FTL_SLOTS;
+    psFtl->u32WlThreshold = SPIM_FTL_WL_THRESHOLD;
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Mount the flash translation layer: scan the blocks and rebuild the map.
+  * @param      psFtl       FTL.
+  * @retval     SPIM_OK          Mounted.
+  * @retval     SPIM_ERR_FAIL    A block could not be read.
+  * @details    Each block starts with a header sector: magic, erase count and, once the block was
+  *             opened for writing, a mark, each word followed by its complement, then one tag per
+  *             slot with the sector number and the sequence number of the write. The copy with the
+  *             highest sequence number is current. What a power failure leaves behind is recognized
+  *             and reclaimed: a slot whose tag is missing or torn is not mapped, a block whose header
+  *             is torn is erased again with the average erase count. The blocks that were open are
+  *             not written any further; new ones are opened on the first write.
+  *             Erased flash mounts as an empty device.
+  */
+int32_t SPIM_FtlMount(SPIM_FTL_T *psFtl)
+{
+    uint32_t *pu32Hdr = psFtl->au32Buf, *pu32Tag;
+    SPIM_FTL_BLK_T *psBlk;
+    uint32_t i, j, u32Lsn, u32Seq, u32Old, u32OldBlk, u32Sum = 0UL, u32Known = 0UL, u32Avg;
+
+    psFtl->u32Mounted = 0UL;
+    for (i = 0UL; i < 2UL; i++)
+    {
+        psFtl->au32Open[i] = psFtl->u32Blocks;
+        psFtl->au32NextSlot[i] = SPIM_FTL_SLOTS + 1UL;
+    }
+    psFtl->u32Seq = 0UL;
+    psFtl->u32FreeCnt = 0UL;
+    memset(psFtl->au16Map, 0xFF, sizeof (psFtl->au16Map));
+    memset(&psFtl->sStat, 0, sizeof (psFtl->sStat));
+
+    for (i = 0UL; i < psFtl->u32Blocks; i++)
+    {
+        psBlk = &psFtl->asBlk[i];
+        memset(psBlk, 0, sizeof (SPIM_FTL_BLK_T));
+        psBlk->u32Seq = SPIM_FTL_NONE;
+
+        if (spim_ftl_read(psFtl, spim_ftl_addr(psFtl, i, 0UL), (uint8_t *)pu32Hdr, SPIM_FTL_META_LEN) != SPIM_OK)
+        {
+            return SPIM_ERR_FAIL;
+        }
+
+        if ((pu32Hdr[0] != SPIM_FTL_MAGIC) || (pu32Hdr[1] != ~pu32Hdr[2]))
+        {
+            psBlk->u8State = spim_ftl_is_blank(psFtl, i) ? SPIM_FTL_BLK_BLANK : SPIM_FTL_BLK_DIRTY;
+            psBlk->u32EraseCnt = SPIM_FTL_NONE;
+            continue;
+        }
+
+        psBlk->u32EraseCnt = pu32Hdr[1];
+        u32Sum += pu32Hdr[1];
+        u32Known++;
+
+        if ((pu32Hdr[3] == SPIM_FTL_NONE) && (pu32Hdr[4] == SPIM_FTL_NONE))
+        {
+            psBlk->u8State = SPIM_FTL_BLK_FREE;
+            psFtl->u32FreeCnt++;
+            continue;
+        }
+
+        if (pu32Hdr[3] != ~pu32Hdr[4])
+        {
+            psBlk->u8State = SPIM_FTL_BLK_DIRTY;
+            continue;
+        }
+
+        psBlk->u8State = SPIM_FTL_BLK_CLOSED;
+        psBlk->u32Seq = pu32Hdr[3];
+
+        for (j = 1UL; j <= SPIM_FTL_SLOTS; j++)
+        {
+            pu32Tag = &pu32Hdr[(SPIM_FTL_TAG_OFF + (j - 1UL) * SPIM_FTL_TAG_LEN) / 4UL];
+            u32Lsn = pu32Tag[0];
+            u32Seq = pu32Tag[2];
+
+            if ((u32Lsn >= psFtl->u32Sectors) || (u32Lsn != ~pu32Tag[1]) || (u32Seq != ~pu32Tag[3]))
+            {
+                continue;
+            }
+
+            if (u32Seq > psBlk->u32Seq)
+            {
+                psBlk->u32Seq = u32Seq;
+            }
+
+            /* Slots of one block are in write order; a block whose newest sector is older loses */
+            u32Old = psFtl->au16Map[u32Lsn];
+            if (u32Old != SPIM_FTL_UNMAPPED)
+            {
+                u32OldBlk = u32Old / (SPIM_FTL_SLOTS + 1UL);
+
+                if ((u32OldBlk != i) && (psFtl->asBlk[u32OldBlk].u32Seq > u32Seq))
+                {
+                    /* Only blocks that were open together interleave: look at the tag of that copy */
+                    if (spim_ftl_read(psFtl, spim_ftl_addr(psFtl, u32OldBlk, SPIM_FTL_TAG_OFF + ((u32Old % (SPIM_FTL_SLOTS + 1UL)) - 1UL) *
+                                                           SPIM_FTL_TAG_LEN), (uint8_t *)psFtl->au32Tag, SPIM_FTL_TAG_LEN) != SPIM_OK)
+                    {
+                        return SPIM_ERR_FAIL;
+                    }
+
+                    if (psFtl->au32Tag[2] > u32Seq)
+                    {
+                        continue;
+                    }
+                }
+                psFtl->asBlk[u32OldBlk].u8Valid--;
+            }
+
+            psFtl->au16Map[u32Lsn] = (uint16_t)SPIM_FTL_PHYS(i, j);
+            psBlk->u8Valid++;
+        }
+
+        if (psBlk->u32Seq >= psFtl->u32Seq)
+        {
+            psFtl->u32Seq = psBlk->u32Seq + 1UL;
+        }
+    }
+
+    u32Avg = (u32Known != 0UL) ? (u32Sum / u32Known) : 0UL;
+
+    for (i = 0UL; i < psFtl->u32Blocks; i++)
+    {
+        psBlk = &psFtl->asBlk[i];
+
+        if (psBlk->u8State == SPIM_FTL_BLK_BLANK)
+        {
+            spim_ftl_erase(psFtl, i, u32Avg, 0UL);
+        }
+        else if (psBlk->u8State == SPIM_FTL_BLK_DIRTY)
+        {
+            spim_ftl_erase(psFtl, i, ((psBlk->u32EraseCnt != SPIM_FTL_NONE) ? psBlk->u32EraseCnt : u32Avg) + 1UL, 1UL);
+        }
+    }
+
+    psFtl->u32Mounted = 1UL;
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Read sectors.
+  * @param      psFtl       FTL.
+  * @param      u32Sector   First sector.
+  * @param      pu8Buf      Receive buffer in SRAM; one that is not word aligned is filled through
+  *                         the FTL buffer, one sector per transfer.
+  * @param      u32Count    Number of sectors.
+  * @retval     SPIM_OK          Read; sectors never written read as 0xFF.
+  * @retval     SPIM_ERR_FAIL    Not mounted or out of range.
+  * @retval     SPIM_ERR_TIMEOUT The flash did not answer.
+  * @details    A queued erase is suspended for the read.
+  */
+int32_t SPIM_FtlRead(SPIM_FTL_T *psFtl, uint32_t u32Sector, uint8_t *pu8Buf, uint32_t u32Count)
+{
+    uint32_t u32Phys, u32Run;
+    int32_t i32Ret;
+
+    if (!psFtl->u32Mounted || (u32Count > psFtl->u32Sectors) || (u32Sector > (psFtl->u32Sectors - u32Count)))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    while (u32Count != 0UL)
+    {
+        u32Phys = psFtl->au16Map[u32Sector];
+
+        if (u32Phys == SPIM_FTL_UNMAPPED)
+        {
+            memset(pu8Buf, 0xFF, SPIM_FTL_SECTOR_SIZE);
+            u32Run = 1UL;
+        }
+        else if (((uint32_t)pu8Buf & 3UL) != 0UL)
+        {
+            u32Run = 1UL;
+            i32Ret = spim_ftl_read(psFtl, spim_ftl_addr(psFtl, u32Phys / (SPIM_FTL_SLOTS + 1UL),
+                                   (u32Phys % (SPIM_FTL_SLOTS + 1UL)) * SPIM_FTL_SECTOR_SIZE),
+                                   (uint8_t *)psFtl->au32Buf, SPIM_FTL_SECTOR_SIZE);
+            if (i32Ret != SPIM_OK)
+            {
+                return i32Ret;
+            }
+            memcpy(pu8Buf, psFtl->au32Buf, SPIM_FTL_SECTOR_SIZE);
+        }
+        else
+        {
+            /* Sectors written together sit in consecutive slots: one transfer for all of them */
+            for (u32Run = 1UL; (u32Run < u32Count) && (((u32Phys % (SPIM_FTL_SLOTS + 1UL)) + u32Run) <= SPIM_FTL_SLOTS) &&
+                    (psFtl->au16Map[u32Sector + u32Run] == (u32Phys + u32Run)); u32Run++)
+            {
+            }
+
+            i32Ret = spim_ftl_read(psFtl, spim_ftl_addr(psFtl, u32Phys / (SPIM_FTL_SLOTS + 1UL),
+                                   (u32Phys % (SPIM_FTL_SLOTS + 1UL)) * SPIM_FTL_SECTOR_SIZE),
+                                   pu8Buf, u32Run * SPIM_FTL_SECTOR_SIZE);
+            if (i32Ret != SPIM_OK)
+            {
+                return i32Ret;
+            }
+        }
+
+        psFtl->sStat.u32HostReads += u32Run;
+        u32Sector += u32Run;
+        u32Count -= u32Run;
+        pu8Buf += u32Run * SPIM_FTL_SECTOR_SIZE;
+    }
+
+    return SPIM_OK;
+}
+
+/**
+  * @brief      Write sectors.
+  * @param      psFtl       FTL.
+  * @param      u32Sector   First sector.
+  * @param      pu8Buf      Data; with a PDMA copy service in the engine, somewhere PDMA reads.
+  * @param      u32Count    Number of sectors.
+  * @retval     SPIM_OK          Written and committed: the data survives a power failure.
+  * @retval     SPIM_ERR_FAIL    Not mounted, out of range or no space could be reclaimed.
+  * @retval     SPIM_ERR_TIMEOUT The flash did not answer.
+  * @details    Sectors are remapped to the next free slots, so a rewrite never erases in place.
+  *             Garbage collection runs once the write is committed if the free blocks ran low;
+  *             the erase it queues finishes in the background: reads suspend it, the next write
+  *             waits for it.
+  */
+int32_t SPIM_FtlWrite(SPIM_FTL_T *psFtl, uint32_t u32Sector, const uint8_t *pu8Buf, uint32_t u32Count)
+{
+    uint32_t au32Lsn[SPIM_FTL_SLOTS];
+    uint32_t i, u32Room;
+    int32_t i32Ret;
+
+    if (!psFtl->u32Mounted || (u32Count > psFtl->u32Sectors) || (u32Sector > (psFtl->u32Sectors - u32Count)))
+    {
+        return SPIM_ERR_FAIL;
+    }
+
+    while (u32Count != 0UL)
+    {
+        if ((i32Ret = spim_ftl_collect(psFtl)) != SPIM_OK)
+        {
+            return i32Ret;
+        }
+
+        if ((psFtl->au32NextSlot[SPIM_FTL_HOST] > SPIM_FTL_SLOTS) && ((i32Ret = spim_ftl_open(psFtl, SPIM_FTL_HOST)) != SPIM_OK))
+        {
+            return i32Ret;
+        }
+
+        u32Room = SPIM_FTL_SLOTS + 1UL - psFtl->au32NextSlot[SPIM_FTL_HOST];
+        if (u32Room > u32Count)
+        {
+            u32Room = u32Count;
+        }
+
+        for (i = 0UL; i < u32Room; i++)
+        {
+            au32Lsn[i] = u32Sector + i;
+        }
+
+        if ((i32Ret = spim_ftl_put(psFtl, SPIM_FTL_HOST, au32Lsn, pu8Buf, u32Room)) != SPIM_OK)
+        {
+            return i32Ret;
+        }
+
+        psFtl->sStat.u32HostWrites += u32Room;
+        u32Sector += u32Room;
+        u32Count -= u32Room;
+        pu8Buf += u32Room * SPIM_FTL_SECTOR_SIZE;
+    }
+
+    /* Reclaim now rather than at the start of the next write, which then finds the erase done */
+    return spim_ftl_collect(psFtl);
+}
+
+/**
+  * @brief      Wait for the erases queued in the background.
+  * @param      psFtl       FTL.
+  * @retval     SPIM_OK          Nothing left in flight.
+  * @retval     SPIM_ERR_TIMEOUT An erase or header program failed.
+  */
+int32_t SPIM_FtlSync(SPIM_FTL_T *psFtl)
+{
+    uint32_t i;
+    int32_t i32Ret = SPIM_OK;
+
+    for (i = 0UL; i < SPIM_FTL_ERASE_JOBS; i++)
+    {
+        if ((spim_ftl_wait(psFtl, &psFtl->asErase[i].sErase) != SPIM_OK) ||
+                (spim_ftl_wait(psFtl, &psFtl->asErase[i].sHdr) != SPIM_OK))
+        {
+            i32Ret = SPIM_ERR_TIMEOUT;
+        }
+    }
+
+    return i32Ret;
+}
+
+/**
+  * @brief      Get the number of logical sectors.
+  * @param      psFtl       FTL.
+  * @return     Sectors of \ref SPIM_FTL_SECTOR_SIZE bytes.
+  */
+uint32_t SPIM_FtlGetSectorCount(SPIM_FTL_T *psFtl)
+{
+    return psFtl->u32Sectors;
+}
+
+/**
+  * @brief      Get the lowest and highest erase count of the blocks.
+  * @param      psFtl       FTL.
+  * @param      pu32Min     Lowest erase count.
+  * @param      pu32Max     Highest erase count.
+  * @return     None.
+  */
+void SPIM_FtlGetWear(SPIM_FTL_T *psFtl, uint32_t *pu32Min, uint32_t *pu32Max)
+{
+    uint32_t i;
+
+    *pu32Min = SPIM_FTL_NONE;
+    *pu32Max = 0UL;
+
+    for (i = 0UL; i < psFtl->u32Blocks; i++)
+    {
+        if (psFtl->asBlk[i].u32EraseCnt < *pu32Min)
+        {
+            *pu32Min = psFtl->asBlk[i].u32EraseCnt;
+        }
+        if (psFtl->asBlk[i].u32EraseCnt > *pu32Max)
+        {
+            *pu32Max = psFtl->asBlk[i].u32EraseCnt;
+        }
+    }
+}
+
+/**
+  * @brief      Clear the statistics of a flash translation layer.
+  * @param      psFtl       FTL.
+  * @return     None.
+  */
+void SPIM_FtlClearStats(SPIM_FTL_T *psFtl)
+{
+    memset(&psFtl->sStat, 0, sizeof (psFtl->sStat));
+}
+
+
 /*@}*/ /* end of group SPIM_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group SPIM_Driver */
@@ -0,0 +1,212 @@
+/**************************************************************************//**
+ * @file     trace.c
+ * @version  V1.00
+ * @brief    Cycle-stamped event trace driver source file
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include "NuMicro.h"
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup TRACE_Driver TRACE Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+/*
+    One ring per core; the M460 has one core. Writers of every priority share it without
+    masking interrupts: a record takes its slot by moving the head with LDREX/STREX, and
+    an interrupt that records in between clears the exclusive monitor, so the interrupted
+    writer retries with a new timestamp and the next slot.
+*/
+static TRACE_REC_T *s_psRing;
+static uint32_t s_u32Size;
+static uint32_t s_u32Mode;
+static volatile uint32_t s_u32Head;     /* Records taken since TRACE_Init(), slot is s_u32Head % s_u32Size */
+static volatile uint32_t s_u32Laps;     /* Wrap mode: times s_u32Head went through 0 */
+static volatile uint32_t s_u32Dropped;  /* One-shot mode: records refused with the ring full */
+static volatile uint32_t s_u32On;
+
+static void TRACE_Drop(void)
+{
+    uint32_t u32Dropped;
+
+    do
+    {
+        u32Dropped = __LDREXW(&s_u32Dropped);
+    }
+    while(__STREXW(u32Dropped + 1UL, &s_u32Dropped) != 0UL);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup TRACE_EXPORTED_FUNCTIONS TRACE Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Set up the trace ring
+  *
+  * @param[in]  psRing      Record buffer.
+  * @param[in]  u32Size     Records of psRing, a power of two, at least 2.
+  * @param[in]  u32Mode     \ref TRACE_MODE_WRAP or \ref TRACE_MODE_ONESHOT.
+  *
+  * @retval     TRACE_OK            Ring ready, recording stopped.
+  * @retval     TRACE_ERR_PARAM     Invalid buffer, size or mode.
+  *
+  * @details    Enables the DWT cycle counter unless TRACE_TIMESTAMP() is defined by the project.
+  */
+int32_t TRACE_Init(TRACE_REC_T *psRing, uint32_t u32Size, uint32_t u32Mode)
+{
+    if((psRing == NULL) || (u32Size < 2UL) || ((u32Size & (u32Size - 1UL)) != 0UL) || (u32Mode > TRACE_MODE_ONESHOT))
+        return TRACE_ERR_PARAM;
+
+    s_u32On = 0UL;
+    s_psRing = psRing;
+    s_u32Size = u32Size;
+    s_u32Mode = u32Mode;
+    s_u32Head = 0UL;
+    s_u32Laps = 0UL;
+    s_u32Dropped = 0UL;
+
+#ifdef TRACE_TIMESTAMP_DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    return TRACE_OK;
+}
+
+/**
+  * @brief      Start recording
+  *
+  * @return     None
+  */
+void TRACE_Start(void)
+{
+    if(s_psRing != NULL)
+        s_u32On = 1UL;
+}
+
+/**
+  * @brief      Stop recording
+  *
+  * @return     None
+  *
+  * @details    The ring keeps its records until TRACE_Init(); recording can start again.
+  */
+void TRACE_Stop(void)
+{
+    s_u32On = 0UL;
+}
+
+/**
+  * @brief      Record an event
+  *
+  * @param[in]  u32Event    Event word, see TRACE_EVENT().
+  *
+  * @return     None
+  *
+  * @details    Called by TRACE_ENTER(), TRACE_EXIT() and TRACE_MARK(). Safe from any interrupt
+  *             priority. The record is filled after its slot is taken, so dump the ring from
+  *             thread mode, after TRACE_Stop(), not from an interrupt that may have preempted
+  *             a writer.
+  */
+void TRACE_Record(uint32_t u32Event)
+{
+    TRACE_REC_T *psRec;
+    uint32_t u32Head, u32Cycles;
+
+    if(s_u32On == 0UL)
+        return;
+
+    do
+    {
+        u32Head = __LDREXW(&s_u32Head);
+
+        if((s_u32Mode == TRACE_MODE_ONESHOT) && (u32Head >= s_u32Size))
+        {
+            __CLREX();
+            TRACE_Drop();
+            return;
+        }
+
+        u32Cycles = TRACE_TIMESTAMP();
+    }
+    while(__STREXW(u32Head + 1UL, &s_u32Head) != 0UL);
+
+    /* Only the writer of this slot moves the head through 0, so it counts the lap alone */
+    if(u32Head == 0xFFFFFFFFUL)
+        s_u32Laps++;
+
+    psRec = &s_psRing[u32Head & (s_u32Size - 1UL)];
+    psRec->u32Cycles = u32Cycles;
+    psRec->u32Event = u32Event;
+}
+
+/**
+  * @brief      Write out the ring
+  *
+  * @param[in]  pfnPut      Output function, called with the \ref TRACE_HDR_T, then with the records
+  *                         in one or two runs, oldest first.
+  * @param[in]  pvPriv      Passed to pfnPut.
+  *
+  * @return     Records written
+  *
+  * @details    The output is the input of the host decoder, see
+  *             SampleCode/StdDriver/TRACE_HotPath/HostTool/trace_decode.c.
+  *             The head counts records modulo 2^32; with the lap count the ring stays full
+  *             after it wraps, and the lost count saturates once it no longer fits.
+  */
+uint32_t TRACE_Dump(TRACE_PUT_T pfnPut, void *pvPriv)
+{
+    TRACE_HDR_T sHdr;
+    uint32_t u32Head = s_u32Head, u32Laps = s_u32Laps, u32Dropped = s_u32Dropped, u32First, u32Idx, u32Run;
+
+    if(s_psRing == NULL)
+        return 0UL;
+
+    sHdr.u32Magic = TRACE_MAGIC;
+    sHdr.u32Version = TRACE_VERSION;
+    sHdr.u32Freq = SystemCoreClock;
+    sHdr.u32Count = ((u32Laps != 0UL) || (u32Head >= s_u32Size)) ? s_u32Size : u32Head;
+    u32First = u32Head - sHdr.u32Count;
+
+    /* Overwritten: u32First + 2^32 * u32Laps, which fits only before the head passes the ring size again */
+    if((u32Laps > 1UL) || ((u32Laps == 1UL) && (u32Head >= sHdr.u32Count)))
+        sHdr.u32Lost = 0xFFFFFFFFUL;
+    else
+        sHdr.u32Lost = u32First;
+
+    sHdr.u32Lost += u32Dropped;
+    if(sHdr.u32Lost < u32Dropped)
+        sHdr.u32Lost = 0xFFFFFFFFUL;
+
+    pfnPut(pvPriv, &sHdr, sizeof(sHdr));
+
+    /* From the oldest slot to the end of the buffer, then from its start */
+    u32Idx = u32First & (s_u32Size - 1UL);
+    u32Run = s_u32Size - u32Idx;
+    if(u32Run > sHdr.u32Count)
+        u32Run = sHdr.u32Count;
+
+    if(u32Run != 0UL)
+        pfnPut(pvPriv, &s_psRing[u32Idx], u32Run * sizeof(TRACE_REC_T));
+
+    if(sHdr.u32Count > u32Run)
+        pfnPut(pvPriv, &s_psRing[0], (sHdr.u32Count - u32Run) * sizeof(TRACE_REC_T));
+
+    return sHdr.u32Count;
+}
+
+/**@}*/ /* end of group TRACE_EXPORTED_FUNCTIONS */
+
+/**@}*/ /* end of group TRACE_Driver */
+
+/**@}*/ /* end of group Standard_Driver */
@@ -8,6 +8,7 @@
 *****************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include "NuMicro.h"
 
 /** @addtogroup Standard_Driver Standard Driver
@@ -663,6 +664,712 @@ void UART_SelectSingleWireMode(UART_T *uart)
     uart->FUNCSEL = ((uart->FUNCSEL & (~UART_FUNCSEL_FUNCSEL_Msk)) | UART_FUNCSEL_SINGLE_WIRE);
 }
 
+/** @cond HIDDEN_SYMBOLS */
+
+#define UART_BUF_RX_PDMA(psBuf)     ((psBuf)->u32RxCh != UART_BUF_NO_PDMA)
+#define UART_BUF_TX_PDMA(psBuf)     ((psBuf)->u32TxCh != UART_BUF_NO_PDMA)
+
+/* Capability flags UART_BufOpen() passes on to PDMA_SvcAllocCh() */
+#define UART_BUF_CH_FLAGS_MSK       (PDMA_SVC_CH_STRIDE | PDMA_SVC_CH_REPEAT)
+
+/* PDMA request source of a buffered port, u32Rx = 1 for RX */
+static uint32_t UART_BufReqSrc(const UART_BUF_CFG_T *psCfg, uint32_t u32Rx)
+{
+    uint32_t u32Idx;
+
+    if(psCfg->uuart != NULL)
+        return (u32Rx ? PDMA_USCI0_RX : PDMA_USCI0_TX);
+
+    /* UART0 ~ UART9 are 4 KB apart; the request sources come in three groups */
+    u32Idx = ((uint32_t)psCfg->uart - UART0_BASE) >> 12;
+
+    if(u32Idx < 6ul)
+        return PDMA_UART0_TX + u32Idx * 2ul + u32Rx;
+    else if(u32Idx < 8ul)
+        return PDMA_UART6_TX + (u32Idx - 6ul) * 2ul + u32Rx;
+    else
+        return PDMA_UART8_TX + (u32Idx - 8ul) * 2ul + u32Rx;
+}
+
+static void UART_BufSetReqSrc(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32ReqSrc)
+{
+    volatile uint32_t *pu32ReqSel = &pdma->REQSEL0_3 + (u32Ch >> 2);
+    uint32_t u32Shift = (u32Ch & 0x3ul) * 8ul;
+
+    *pu32ReqSel = (*pu32ReqSel & ~(PDMA_REQSEL0_3_REQSRC0_Msk << u32Shift)) | (u32ReqSrc << u32Shift);
+}
+
+/* Current RX head. With PDMA it is rebuilt from the ring halves completed and the count left in the
+   running half; a half finished but not yet counted by UART_BufPdmaIRQHandler() is still in TDSTS. */
+static uint32_t UART_BufRxHead(UART_BUF_T *psBuf)
+{
+    PDMA_T *pdma = psBuf->pdma;
+    uint32_t u32Ch = psBuf->u32RxCh;
+    uint32_t u32Half = psBuf->sCfg.u32RxSize >> 1;
+    uint32_t u32PriMask, u32Done, u32Cnt, u32Head;
+
+    if(!UART_BUF_RX_PDMA(psBuf))
+        return psBuf->u32RxHead;
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    /* TXCNT reloads when the next half starts: retry until TDSTS is the same on both sides of it */
+    do
+    {
+        u32Done = pdma->TDSTS & (1ul << u32Ch);
+        u32Cnt = (pdma->DSCT[u32Ch].CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos;
+    }
+    while(u32Done != (pdma->TDSTS & (1ul << u32Ch)));
+
+    u32Head = (psBuf->u32RxHalves + (u32Done ? 1ul : 0ul)) * u32Half + u32Half - (u32Cnt + 1ul);
+    psBuf->u32RxHead = u32Head;
+
+    __set_PRIMASK(u32PriMask);
+
+    return u32Head;
+}
+
+/* Bytes readable. When PDMA has lapped the reader the ring content is partly overwritten: all of it
+   is discarded and the reader restarts from the head. */
+static uint32_t UART_BufRxAvail(UART_BUF_T *psBuf)
+{
+    uint32_t u32Head = UART_BufRxHead(psBuf);
+    uint32_t u32Cnt = u32Head - psBuf->u32RxTail;
+
+    if(u32Cnt > psBuf->sCfg.u32RxSize)
+    {
+        psBuf->sStats.u32RxOverruns++;
+        psBuf->sStats.u32RxDropped += u32Cnt;
+        psBuf->u32RxTail = u32Head;
+        u32Cnt = 0ul;
+    }
+
+    return u32Cnt;
+}
+
+static uint32_t UART_BufCopyOut(UART_BUF_T *psBuf, uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Size = psBuf->sCfg.u32RxSize;
+    uint32_t u32Idx = psBuf->u32RxTail & (u32Size - 1ul);
+    uint32_t u32Cnt = UART_BufRxAvail(psBuf);
+    uint32_t u32Part, u32Overruns;
+
+    if(u32Len > u32Cnt)
+        u32Len = u32Cnt;
+
+    if(u32Len == 0ul)
+        return 0ul;
+
+    u32Part = u32Size - u32Idx;
+    if(u32Part > u32Len)
+        u32Part = u32Len;
+
+    memcpy(pu8Data, &psBuf->sCfg.pu8RxBuf[u32Idx], u32Part);
+    memcpy(pu8Data + u32Part, psBuf->sCfg.pu8RxBuf, u32Len - u32Part);
+
+    /* PDMA may have overwritten the start of what was just copied */
+    u32Overruns = psBuf->sStats.u32RxOverruns;
+    (void)UART_BufRxAvail(psBuf);
+    if(u32Overruns != psBuf->sStats.u32RxOverruns)
+        return 0ul;
+
+    return u32Len;
+}
+
+/* FIFO RX: move the received bytes into the ring, interrupt context */
+static void UART_BufRxDrain(UART_BUF_T *psBuf, uint32_t *pu32Events)
+{
+    UART_T *uart = psBuf->sCfg.uart;
+    UUART_T *uuart = psBuf->sCfg.uuart;
+    uint32_t u32Size = psBuf->sCfg.u32RxSize;
+    uint32_t u32Head = psBuf->u32RxHead;
+    uint32_t u32Lost = 0ul;
+    uint8_t u8Data;
+
+    for(;;)
+    {
+        if(uart != NULL)
+        {
+            if(uart->FIFOSTS & UART_FIFOSTS_RXEMPTY_Msk)
+                break;
+            u8Data = (uint8_t)uart->DAT;
+        }
+        else
+        {
+            if(uuart->BUFSTS & UUART_BUFSTS_RXEMPTY_Msk)
+                break;
+            u8Data = (uint8_t)uuart->RXDAT;
+        }
+
+        if(u32Head - psBuf->u32RxTail < u32Size)
+        {
+            psBuf->sCfg.pu8RxBuf[u32Head & (u32Size - 1ul)] = u8Data;
+            u32Head++;
+        }
+        else
+        {
+            u32Lost++;
+        }
+    }
+
+    psBuf->u32RxHead = u32Head;
+
+    if(u32Lost)
+    {
+        psBuf->sStats.u32RxOverruns++;
+        psBuf->sStats.u32RxDropped += u32Lost;
+    }
+
+    if(u32Head - psBuf->u32RxMark >= (u32Size >> 1))
+    {
+        psBuf->u32RxMark = u32Head;
+        *pu32Events |= UART_BUF_EV_RX_HALF;
+    }
+}
+
+/* Hand queued TX bytes to the hardware, interrupt context or interrupts masked */
+static void UART_BufTxKick(UART_BUF_T *psBuf)
+{
+    const UART_BUF_CFG_T *psCfg = &psBuf->sCfg;
+    PDMA_T *pdma = psBuf->pdma;
+    uint32_t u32Ch = psBuf->u32TxCh;
+    uint32_t u32Mask = psCfg->u32TxSize - 1ul;
+    uint32_t u32Head = psBuf->u32TxHead;
+    uint32_t u32Tail = psBuf->u32TxTail;
+    uint32_t u32Len;
+
+    if(UART_BUF_TX_PDMA(psBuf))
+    {
+        if((psBuf->u32TxDmaLen != 0ul) || (u32Head == u32Tail))
+            return;
+
+        /* One contiguous run per transfer; the rest follows from the transfer done interrupt */
+        u32Len = u32Head - u32Tail;
+        if(u32Len > psCfg->u32TxSize - (u32Tail & u32Mask))
+            u32Len = psCfg->u32TxSize - (u32Tail & u32Mask);
+
+        pdma->DSCT[u32Ch].SA = (uint32_t)&psCfg->pu8TxBuf[u32Tail & u32Mask];
+        pdma->DSCT[u32Ch].DA = (psCfg->uart != NULL) ? (uint32_t)&psCfg->uart->DAT : (uint32_t)&psCfg->uuart->TXDAT;
+        pdma->DSCT[u32Ch].CTL = ((u32Len - 1ul) << PDMA_DSCT_CTL_TXCNT_Pos) |
+                                PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_FIX | PDMA_REQ_SINGLE | PDMA_OP_BASIC;
+        psBuf->u32TxDmaLen = u32Len;
+        psBuf->sStats.u32TxDmaRuns++;
+
+        pdma->CHCTL |= (1ul << u32Ch);
+        if(psCfg->uart != NULL)
+            psCfg->uart->INTEN |= UART_INTEN_TXPDMAEN_Msk;
+        else
+            psCfg->uuart->PDMACTL |= UUART_PDMACTL_TXPDMAEN_Msk;
+    }
+    else if(psCfg->uart != NULL)
+    {
+        while((u32Tail != u32Head) && !(psCfg->uart->FIFOSTS & UART_FIFOSTS_TXFULL_Msk))
+        {
+            psCfg->uart->DAT = psCfg->pu8TxBuf[u32Tail & u32Mask];
+            u32Tail++;
+        }
+        psBuf->u32TxTail = u32Tail;
+
+        /* THRE also reports the FIFO drained after the ring emptied */
+        if((u32Tail != u32Head) || psBuf->u32TxNotify)
+            psCfg->uart->INTEN |= UART_INTEN_THREIEN_Msk;
+        else
+            psCfg->uart->INTEN &= ~UART_INTEN_THREIEN_Msk;
+    }
+    else
+    {
+        while((u32Tail != u32Head) && !(psCfg->uuart->BUFSTS & UUART_BUFSTS_TXFULL_Msk))
+        {
+            psCfg->uuart->TXDAT = psCfg->pu8TxBuf[u32Tail & u32Mask];
+            u32Tail++;
+        }
+        psBuf->u32TxTail = u32Tail;
+    }
+}
+
+/* Report UART_BUF_EV_TX_EMPTY once the ring drained after a write */
+static void UART_BufTxCheckEmpty(UART_BUF_T *psBuf, uint32_t *pu32Events)
+{
+    if(psBuf->u32TxNotify && (psBuf->u32TxTail == psBuf->u32TxHead) && (psBuf->u32TxDmaLen == 0ul))
+    {
+        psBuf->u32TxNotify = 0ul;
+        *pu32Events |= UART_BUF_EV_TX_EMPTY;
+    }
+}
+
+static void UART_BufRxStart(UART_BUF_T *psBuf)
+{
+    const UART_BUF_CFG_T *psCfg = &psBuf->sCfg;
+    PDMA_T *pdma = psBuf->pdma;
+    DSCT_T *psDesc = psCfg->psRxDesc;
+    uint32_t u32Ch = psBuf->u32RxCh;
+    uint32_t u32Half = psCfg->u32RxSize >> 1;
+    uint32_t u32Base = pdma->SCATBA & PDMA_SCATBA_SCATBA_Msk;
+    uint32_t u32Ctl = ((u32Half - 1ul) << PDMA_DSCT_CTL_TXCNT_Pos) |
+                      PDMA_WIDTH_8 | PDMA_SAR_FIX | PDMA_DAR_INC | PDMA_REQ_SINGLE | PDMA_OP_SCATTER;
+    uint32_t i;
+
+    /* Two tables chained to each other, one per ring half: each half raises a transfer done */
+    for(i = 0ul; i < 2ul; i++)
+    {
+        psDesc[i].CTL = u32Ctl;
+        psDesc[i].SA = (psCfg->uart != NULL) ? (uint32_t)&psCfg->uart->DAT : (uint32_t)&psCfg->uuart->RXDAT;
+        psDesc[i].DA = (uint32_t)&psCfg->pu8RxBuf[i * u32Half];
+        psDesc[i].NEXT = (uint32_t)&psDesc[i ^ 1ul] - u32Base;
+    }
+
+    PDMA_RESET(pdma, u32Ch);
+    UART_BufSetReqSrc(pdma, u32Ch, UART_BufReqSrc(psCfg, 1ul));
+
+    /* The channel loads the first table itself; TXCNT is primed so the head reads 0 until then */
+    pdma->DSCT[u32Ch].CTL = u32Ctl;
+    pdma->DSCT[u32Ch].NEXT = (uint32_t)&psDesc[0] - u32Base;
+
+    pdma->TDSTS = (1ul << u32Ch);
+    pdma->INTEN |= (1ul << u32Ch);
+    pdma->CHCTL |= (1ul << u32Ch);
+
+    if(psCfg->uart != NULL)
+        psCfg->uart->INTEN |= UART_INTEN_RXPDMAEN_Msk;
+    else
+        psCfg->uuart->PDMACTL |= UUART_PDMACTL_PDMAEN_Msk | UUART_PDMACTL_RXPDMAEN_Msk;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+ *    @brief        Open a ring-buffered UART port
+ *
+ *    @param[out]   psBuf       The pointer of the port state.
+ *    @param[in]    psCfg       The pointer of the port configuration, copied into psBuf.
+ *
+ *    @retval       0                       Port running
+ *    @retval       UART_BUF_PARAM_ERR      Configuration rejected, nothing touched
+ *    @retval       UART_BUF_NOCH_ERR       The service has no free channel for a PDMA direction, nothing touched
+ *
+ *    @details      The port must already be clocked, pinned and opened with UART_Open() or
+ *                  UUART_Open(), and psSvc set up with PDMA_SvcInit(). The function allocates the
+ *                  PDMA channels, resets the FIFOs, programs the RX time-out, starts the RX PDMA
+ *                  channel over the ring and enables the port interrupts. The caller enables the NVIC
+ *                  lines and calls UART_BufIRQHandler() from the port handler, and
+ *                  UART_BufPdmaIRQHandler() next to PDMA_SvcIRQHandler() from the PDMA handler.
+ *                  Without RX PDMA the RX FIFO trigger level is set to 8 bytes so the time-out
+ *                  collects the end of a frame; USCI UART has no time-out and never reports
+ *                  \ref UART_BUF_EV_RX_IDLE.
+ */
+int32_t UART_BufOpen(UART_BUF_T *psBuf, const UART_BUF_CFG_T *psCfg)
+{
+    PDMA_SVC_T *psSvc = psCfg->psSvc;
+    uint32_t u32RxPdma = (psCfg->u32RxChFlags != UART_BUF_NO_PDMA);
+    uint32_t u32TxPdma = (psCfg->u32TxChFlags != UART_BUF_NO_PDMA);
+    uint32_t u32DescEnd;
+    int32_t i32RxCh = 0, i32TxCh = 0;
+
+    if(((psCfg->uart == NULL) == (psCfg->uuart == NULL)) ||
+            (psCfg->pu8RxBuf == NULL) || (psCfg->pu8TxBuf == NULL) ||
+            (psCfg->u32RxSize < 2ul) || (psCfg->u32RxSize & (psCfg->u32RxSize - 1ul)) ||
+            (psCfg->u32TxSize == 0ul) || (psCfg->u32TxSize & (psCfg->u32TxSize - 1ul)) ||
+            (psCfg->u32RxTimeout > 255ul))
+        return UART_BUF_PARAM_ERR;
+
+    if((u32RxPdma || u32TxPdma) && (psSvc == NULL))
+        return UART_BUF_PARAM_ERR;
+
+    if(u32RxPdma && ((psCfg->u32RxChFlags & ~UART_BUF_CH_FLAGS_MSK) || (psCfg->u32RxSize > 65536ul) || (psCfg->psRxDesc == NULL)))
+        return UART_BUF_PARAM_ERR;
+
+    if(u32TxPdma && ((psCfg->u32TxChFlags & ~UART_BUF_CH_FLAGS_MSK) || (psCfg->u32TxSize > 65536ul)))
+        return UART_BUF_PARAM_ERR;
+
+    if(u32RxPdma)
+    {
+        /* The RX tables are chained through NEXT offsets from the SCATBA window of the service */
+        u32DescEnd = (uint32_t)&psCfg->psRxDesc[2] - 1ul;
+        if((((uint32_t)psCfg->psRxDesc ^ psSvc->u32DescBase) & PDMA_SCATBA_SCATBA_Msk) ||
+                ((u32DescEnd ^ psSvc->u32DescBase) & PDMA_SCATBA_SCATBA_Msk))
+            return UART_BUF_PARAM_ERR;
+
+        i32RxCh = PDMA_SvcAllocCh(psSvc, psCfg->u32RxChFlags | PDMA_SVC_CH_DIRECT);
+        if(i32RxCh < 0)
+            return UART_BUF_NOCH_ERR;
+    }
+
+    if(u32TxPdma)
+    {
+        i32TxCh = PDMA_SvcAllocCh(psSvc, psCfg->u32TxChFlags | PDMA_SVC_CH_DIRECT);
+        if(i32TxCh < 0)
+        {
+            if(u32RxPdma)
+                (void)PDMA_SvcFreeCh(psSvc, (uint32_t)i32RxCh);
+            return UART_BUF_NOCH_ERR;
+        }
+    }
+
+    memset(psBuf, 0, sizeof(UART_BUF_T));
+    psBuf->sCfg = *psCfg;
+    psBuf->pdma = (u32RxPdma || u32TxPdma) ? psSvc->pdma : NULL;
+    psBuf->u32RxCh = u32RxPdma ? (uint32_t)i32RxCh : UART_BUF_NO_PDMA;
+    psBuf->u32TxCh = u32TxPdma ? (uint32_t)i32TxCh : UART_BUF_NO_PDMA;
+    if(psBuf->sCfg.u32RxTimeout == 0ul)
+        psBuf->sCfg.u32RxTimeout = 40ul;
+
+    if(psCfg->uart != NULL)
+    {
+        psCfg->uart->INTEN &= ~(UART_INTEN_RDAIEN_Msk | UART_INTEN_THREIEN_Msk | UART_INTEN_RLSIEN_Msk |
+                                UART_INTEN_RXTOIEN_Msk | UART_INTEN_BUFERRIEN_Msk |
+                                UART_INTEN_TXPDMAEN_Msk | UART_INTEN_RXPDMAEN_Msk);
+        psCfg->uart->FIFO = (psCfg->uart->FIFO & ~UART_FIFO_RFITL_Msk) | UART_FIFO_RXRST_Msk | UART_FIFO_TXRST_Msk |
+                            (u32RxPdma ? UART_FIFO_RFITL_1BYTE : UART_FIFO_RFITL_8BYTES);
+        UART_SetTimeoutCnt(psCfg->uart, psBuf->sCfg.u32RxTimeout);
+        psCfg->uart->FIFOSTS = UART_FIFOSTS_RXOVIF_Msk | UART_FIFOSTS_PEF_Msk | UART_FIFOSTS_FEF_Msk | UART_FIFOSTS_BIF_Msk;
+    }
+    else
+    {
+        psCfg->uuart->PDMACTL = 0ul;
+        psCfg->uuart->BUFCTL |= UUART_BUFCTL_RXCLR_Msk | UUART_BUFCTL_TXCLR_Msk | UUART_BUFCTL_RXOVIEN_Msk;
+        psCfg->uuart->BUFSTS = UUART_BUFSTS_RXOVIF_Msk;
+        psCfg->uuart->PROTSTS = UUART_PROTSTS_PARITYERR_Msk | UUART_PROTSTS_FRMERR_Msk | UUART_PROTSTS_BREAK_Msk |
+                                UUART_PROTSTS_RXENDIF_Msk | UUART_PROTSTS_TXENDIF_Msk;
+        psCfg->uuart->PROTIEN |= UUART_PROTIEN_RLSIEN_Msk;
+    }
+
+    if(u32RxPdma)
+        UART_BufRxStart(psBuf);
+
+    if(u32TxPdma)
+    {
+        /* PDMA_SvcAllocCh() left the channel idle with its transfer done interrupt enabled */
+        UART_BufSetReqSrc(psBuf->pdma, psBuf->u32TxCh, UART_BufReqSrc(psCfg, 0ul));
+        if(psCfg->uuart != NULL)
+            psCfg->uuart->PDMACTL |= UUART_PDMACTL_PDMAEN_Msk;
+    }
+
+    if(psCfg->uart != NULL)
+    {
+        psCfg->uart->INTEN |= UART_INTEN_RLSIEN_Msk | UART_INTEN_BUFERRIEN_Msk | UART_INTEN_RXTOIEN_Msk |
+                              (u32RxPdma ? 0ul : UART_INTEN_RDAIEN_Msk);
+    }
+    else
+    {
+        psCfg->uuart->INTEN |= (u32RxPdma ? 0ul : UUART_INTEN_RXENDIEN_Msk) |
+                               (u32TxPdma ? 0ul : UUART_INTEN_TXENDIEN_Msk);
+    }
+
+    return 0;
+}
+
+/**
+ *    @brief        Close a ring-buffered UART port
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       None
+ *
+ *    @details      Returns the PDMA channels to the service and disables the interrupts enabled by
+ *                  UART_BufOpen(). Bytes still in the rings are abandoned.
+ */
+void UART_BufClose(UART_BUF_T *psBuf)
+{
+    const UART_BUF_CFG_T *psCfg = &psBuf->sCfg;
+
+    if(psCfg->uart != NULL)
+    {
+        psCfg->uart->INTEN &= ~(UART_INTEN_RDAIEN_Msk | UART_INTEN_THREIEN_Msk | UART_INTEN_RLSIEN_Msk |
+                                UART_INTEN_RXTOIEN_Msk | UART_INTEN_BUFERRIEN_Msk |
+                                UART_INTEN_TXPDMAEN_Msk | UART_INTEN_RXPDMAEN_Msk);
+    }
+    else
+    {
+        psCfg->uuart->PDMACTL = 0ul;
+        psCfg->uuart->INTEN &= ~(UUART_INTEN_RXENDIEN_Msk | UUART_INTEN_TXENDIEN_Msk);
+        psCfg->uuart->PROTIEN &= ~UUART_PROTIEN_RLSIEN_Msk;
+        psCfg->uuart->BUFCTL &= ~UUART_BUFCTL_RXOVIEN_Msk;
+    }
+
+    if(UART_BUF_RX_PDMA(psBuf))
+        (void)PDMA_SvcFreeCh(psCfg->psSvc, psBuf->u32RxCh);
+
+    if(UART_BUF_TX_PDMA(psBuf))
+        (void)PDMA_SvcFreeCh(psCfg->psSvc, psBuf->u32TxCh);
+
+    psBuf->u32RxCh = UART_BUF_NO_PDMA;
+    psBuf->u32TxCh = UART_BUF_NO_PDMA;
+    psBuf->u32TxDmaLen = 0ul;
+}
+
+/**
+ *    @brief        Read received bytes without blocking
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *    @param[out]   pu8Data     The buffer receiving the bytes.
+ *    @param[in]    u32Len      The maximum byte count to read.
+ *
+ *    @return       Bytes read, 0 when nothing is pending
+ *
+ *    @details      With RX PDMA the bytes are readable as soon as the PDMA stored them; no time-out
+ *                  or flush is needed. When the ring overflowed, its content is discarded and counted
+ *                  in u32RxOverruns / u32RxDropped.
+ */
+uint32_t UART_BufRead(UART_BUF_T *psBuf, uint8_t *pu8Data, uint32_t u32Len)
+{
+    u32Len = UART_BufCopyOut(psBuf, pu8Data, u32Len);
+    psBuf->u32RxTail += u32Len;
+
+    return u32Len;
+}
+
+/**
+ *    @brief        Copy received bytes without consuming them
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *    @param[out]   pu8Data     The buffer receiving the bytes.
+ *    @param[in]    u32Len      The maximum byte count to copy.
+ *
+ *    @return       Bytes copied
+ *
+ *    @details      Same as UART_BufRead() but the bytes stay in the ring.
+ */
+uint32_t UART_BufPeek(UART_BUF_T *psBuf, uint8_t *pu8Data, uint32_t u32Len)
+{
+    return UART_BufCopyOut(psBuf, pu8Data, u32Len);
+}
+
+/**
+ *    @brief        Queue bytes for transmission without blocking
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *    @param[in]    pu8Data     The bytes to send.
+ *    @param[in]    u32Len      The byte count.
+ *
+ *    @return       Bytes queued; the remainder is counted in u32TxRefused
+ *
+ *    @details      \ref UART_BUF_EV_TX_EMPTY is raised once when the ring has drained after the call.
+ */
+uint32_t UART_BufWrite(UART_BUF_T *psBuf, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Size = psBuf->sCfg.u32TxSize;
+    uint32_t u32Head = psBuf->u32TxHead;
+    uint32_t u32Idx = u32Head & (u32Size - 1ul);
+    uint32_t u32Cnt = u32Size - (u32Head - psBuf->u32TxTail);
+    uint32_t u32Part, u32PriMask;
+
+    if(u32Cnt > u32Len)
+        u32Cnt = u32Len;
+
+    psBuf->sStats.u32TxRefused += u32Len - u32Cnt;
+
+    if(u32Cnt == 0ul)
+        return 0ul;
+
+    u32Part = u32Size - u32Idx;
+    if(u32Part > u32Cnt)
+        u32Part = u32Cnt;
+
+    memcpy(&psBuf->sCfg.pu8TxBuf[u32Idx], pu8Data, u32Part);
+    memcpy(psBuf->sCfg.pu8TxBuf, pu8Data + u32Part, u32Cnt - u32Part);
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    psBuf->u32TxHead = u32Head + u32Cnt;
+    psBuf->u32TxNotify = 1ul;
+    UART_BufTxKick(psBuf);
+
+    __set_PRIMASK(u32PriMask);
+
+    return u32Cnt;
+}
+
+/**
+ *    @brief        Get the number of received bytes waiting in the RX ring
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       Readable byte count
+ */
+uint32_t UART_BufRxCount(UART_BUF_T *psBuf)
+{
+    return UART_BufRxAvail(psBuf);
+}
+
+/**
+ *    @brief        Get the free space of the TX ring
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       Bytes UART_BufWrite() can accept
+ */
+uint32_t UART_BufTxSpace(UART_BUF_T *psBuf)
+{
+    return psBuf->sCfg.u32TxSize - (psBuf->u32TxHead - psBuf->u32TxTail);
+}
+
+/**
+ *    @brief        Get the number of queued TX bytes not yet handed to the hardware
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       Pending byte count, including a PDMA transfer in flight
+ *
+ *    @details      Bytes already in the TX FIFO are not counted; check UART_IS_TX_EMPTY() before
+ *                  turning an RS-485 driver around.
+ */
+uint32_t UART_BufTxPending(UART_BUF_T *psBuf)
+{
+    return psBuf->u32TxHead - psBuf->u32TxTail;
+}
+
+/**
+ *    @brief        Buffered port interrupt service
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       None
+ *
+ *    @details      Call from the UARTn or USCIn interrupt handler. Counts the line errors, moves
+ *                  FIFO data when PDMA is not used and reports the RX time-out as
+ *                  \ref UART_BUF_EV_RX_IDLE.
+ */
+void UART_BufIRQHandler(UART_BUF_T *psBuf)
+{
+    UART_T *uart = psBuf->sCfg.uart;
+    UUART_T *uuart = psBuf->sCfg.uuart;
+    uint32_t u32Events = 0ul;
+    uint32_t u32Sts, u32Err;
+
+    if(uart != NULL)
+    {
+        u32Sts = uart->INTSTS;
+
+        u32Err = uart->FIFOSTS & (UART_FIFOSTS_RXOVIF_Msk | UART_FIFOSTS_PEF_Msk | UART_FIFOSTS_FEF_Msk | UART_FIFOSTS_BIF_Msk);
+        if(u32Err)
+        {
+            if(u32Err & UART_FIFOSTS_RXOVIF_Msk)
+                psBuf->sStats.u32FifoOverruns++;
+            if(u32Err & UART_FIFOSTS_PEF_Msk)
+                psBuf->sStats.u32ParityErrs++;
+            if(u32Err & UART_FIFOSTS_FEF_Msk)
+                psBuf->sStats.u32FrameErrs++;
+            if(u32Err & UART_FIFOSTS_BIF_Msk)
+                psBuf->sStats.u32Breaks++;
+            uart->FIFOSTS = u32Err;
+        }
+
+        if(!UART_BUF_RX_PDMA(psBuf) && (u32Sts & (UART_INTSTS_RDAINT_Msk | UART_INTSTS_RXTOINT_Msk)))
+            UART_BufRxDrain(psBuf, &u32Events);
+
+        if(u32Sts & (UART_INTSTS_RXTOINT_Msk | UART_INTSTS_HWTOINT_Msk))
+        {
+            uart->INTSTS = UART_INTSTS_RXTOIF_Msk | UART_INTSTS_HWTOIF_Msk;
+            psBuf->sStats.u32RxIdle++;
+            u32Events |= UART_BUF_EV_RX_IDLE;
+        }
+
+        if(!UART_BUF_TX_PDMA(psBuf) && (u32Sts & UART_INTSTS_THREINT_Msk))
+        {
+            UART_BufTxKick(psBuf);
+            if(psBuf->u32TxTail == psBuf->u32TxHead)
+            {
+                UART_BufTxCheckEmpty(psBuf, &u32Events);
+                uart->INTEN &= ~UART_INTEN_THREIEN_Msk;
+            }
+        }
+    }
+    else
+    {
+        u32Sts = uuart->PROTSTS;
+        uuart->PROTSTS = u32Sts & (UUART_PROTSTS_PARITYERR_Msk | UUART_PROTSTS_FRMERR_Msk | UUART_PROTSTS_BREAK_Msk |
+                                   UUART_PROTSTS_RXENDIF_Msk | UUART_PROTSTS_TXENDIF_Msk);
+
+        if(u32Sts & UUART_PROTSTS_PARITYERR_Msk)
+            psBuf->sStats.u32ParityErrs++;
+        if(u32Sts & UUART_PROTSTS_FRMERR_Msk)
+            psBuf->sStats.u32FrameErrs++;
+        if(u32Sts & UUART_PROTSTS_BREAK_Msk)
+            psBuf->sStats.u32Breaks++;
+
+        if(uuart->BUFSTS & UUART_BUFSTS_RXOVIF_Msk)
+        {
+            psBuf->sStats.u32FifoOverruns++;
+            uuart->BUFSTS = UUART_BUFSTS_RXOVIF_Msk;
+        }
+
+        if(!UART_BUF_RX_PDMA(psBuf) && (u32Sts & UUART_PROTSTS_RXENDIF_Msk))
+            UART_BufRxDrain(psBuf, &u32Events);
+
+        if(!UART_BUF_TX_PDMA(psBuf) && (u32Sts & UUART_PROTSTS_TXENDIF_Msk))
+        {
+            UART_BufTxKick(psBuf);
+            UART_BufTxCheckEmpty(psBuf, &u32Events);
+        }
+    }
+
+    if(u32Events && (psBuf->sCfg.pfnEvent != NULL))
+        psBuf->sCfg.pfnEvent(psBuf, u32Events);
+}
+
+/**
+ *    @brief        Buffered port PDMA interrupt service
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       None
+ *
+ *    @details      Call from the PDMA interrupt handler, next to PDMA_SvcIRQHandler() of the service
+ *                  the channels came from; either may run first. Counts the completed RX ring halves
+ *                  and starts the next TX run. An RX half must be counted before the following one
+ *                  completes, otherwise the head falls half a ring behind.
+ */
+void UART_BufPdmaIRQHandler(UART_BUF_T *psBuf)
+{
+    const UART_BUF_CFG_T *psCfg = &psBuf->sCfg;
+    PDMA_T *pdma = psBuf->pdma;
+    uint32_t u32Events = 0ul;
+    uint32_t u32Sts;
+
+    if(pdma == NULL)
+        return;
+
+    u32Sts = pdma->TDSTS;
+
+    if(UART_BUF_RX_PDMA(psBuf) && (u32Sts & (1ul << psBuf->u32RxCh)))
+    {
+        pdma->TDSTS = (1ul << psBuf->u32RxCh);
+        psBuf->u32RxHalves++;
+        u32Events |= UART_BUF_EV_RX_HALF;
+    }
+
+    if(UART_BUF_TX_PDMA(psBuf) && (u32Sts & (1ul << psBuf->u32TxCh)))
+    {
+        pdma->TDSTS = (1ul << psBuf->u32TxCh);
+        if(psCfg->uart != NULL)
+            psCfg->uart->INTEN &= ~UART_INTEN_TXPDMAEN_Msk;
+        else
+            psCfg->uuart->PDMACTL &= ~UUART_PDMACTL_TXPDMAEN_Msk;
+
+        psBuf->u32TxTail += psBuf->u32TxDmaLen;
+        psBuf->u32TxDmaLen = 0ul;
+        UART_BufTxKick(psBuf);
+        UART_BufTxCheckEmpty(psBuf, &u32Events);
+    }
+
+    if(u32Events && (psCfg->pfnEvent != NULL))
+        psCfg->pfnEvent(psBuf, u32Events);
+}
+
+/**
+ *    @brief        Clear the statistics of a buffered port
+ *
+ *    @param[in]    psBuf       The pointer of the port state.
+ *
+ *    @return       None
+ */
+void UART_BufClearStats(UART_BUF_T *psBuf)
+{
+    memset(&psBuf->sStats, 0, sizeof(psBuf->sStats));
+}
+
 /*@}*/ /* end of group UART_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group UART_Driver */
@@ -0,0 +1,159 @@
+/**************************************************************************//**
+ * @file     cdc_acm.h
+ * @version  V1.00
+ * @brief    USB device CDC-ACM class with lock-free rings and bulk IN batching.
+ *
+ * @details  The class core (cdc_acm.c) owns one TX and one RX ring per port
+ *           and decides what goes on the bus; it does not touch any USB
+ *           register. The controller ports move the data:
+ *             - usbd_cdc_acm.c   : USBD (full speed), copies through the EP SRAM.
+ *             - hsusbd_cdc_acm.c : HSUSBD (high speed), moves the data by DMA.
+ *
+ *           Bulk IN batching: data written by the application is held until a
+ *           full max-packet can be sent, or until CDC_ACM_Flush() is called,
+ *           or until it has waited u16FlushTicks calls of CDC_ACM_Tick().
+ *           A transfer whose last packet is exactly max-packet sized is
+ *           terminated by a zero length packet under the same rules.
+ *
+ *           Each ring has one producer and one consumer and needs no lock:
+ *           TX is written by the application and read by the port, RX is
+ *           written by the port and read by the application.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __CDC_ACM_H__
+#define __CDC_ACM_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!<Define CDC Class Specific Request */
+#define CDC_SET_LINE_CODE           0x20
+#define CDC_GET_LINE_CODE           0x21
+#define CDC_SET_CONTROL_LINE_STATE  0x22
+
+#define CDC_ACM_TX_NONE         0xFFFFFFFFUL    /*!< CDC_ACM_TxPrepare(): nothing to send */
+
+/* Port transfer states (CDC_ACM_T::u8TxState / u8RxState) */
+#define CDC_ACM_ST_IDLE         0       /*!< Endpoint idle */
+#define CDC_ACM_ST_DMA          1       /*!< Data moving between ring and endpoint buffer */
+#define CDC_ACM_ST_BUSY         2       /*!< IN packet or zero length packet waiting for the host */
+#define CDC_ACM_ST_HOLD         3       /*!< OUT data waiting for ring space */
+#define CDC_ACM_ST_ZLP          4       /*!< Zero length packet waiting for the IN buffer to drain */
+
+/**
+  * @brief   Single-producer/single-consumer byte ring.
+  * @details u32Head and u32Tail run freely and are masked with (u32Size - 1);
+  *          u32Size MUST be a power of two.
+  */
+typedef struct
+{
+    uint8_t           *pu8Buf;
+    uint32_t          u32Size;
+    volatile uint32_t u32Head;      /*!< Written by the producer only */
+    volatile uint32_t u32Tail;      /*!< Written by the consumer only */
+} CDC_RING_T;
+
+#pragma pack(push)
+#pragma pack(1)
+/*!<CDC line coding, as carried by SET_LINE_CODE / GET_LINE_CODE */
+typedef struct
+{
+    uint32_t  u32DTERate;     /* Baud rate    */
+    uint8_t   u8CharFormat;   /* stop bit     */
+    uint8_t   u8ParityType;   /* parity       */
+    uint8_t   u8DataBits;     /* data bits    */
+} CDC_LINE_CODING_T;
+#pragma pack(pop)
+
+typedef struct
+{
+    uint32_t  u32TxBytes;       /*!< Bytes handed to the bulk IN endpoint */
+    uint32_t  u32TxXfers;       /*!< Bulk IN transfers started (DMA runs or FS packets) */
+    uint32_t  u32TxZlps;        /*!< Zero length packets sent */
+    uint32_t  u32TxBounce;      /*!< IN packets copied through the bounce buffer at the ring wrap */
+    uint32_t  u32TxOverflow;    /*!< Bytes refused by CDC_ACM_Write() for lack of ring space */
+    uint32_t  u32RxBytes;       /*!< Bytes received on the bulk OUT endpoint */
+    uint32_t  u32RxBounce;      /*!< OUT packets copied through the bounce buffer at the ring wrap */
+    uint32_t  u32RxHold;        /*!< OUT packets left NAKed because the RX ring was full */
+} CDC_ACM_STATS_T;
+
+struct CDC_ACM;
+
+typedef void (*CDC_ACM_CB_T)(struct CDC_ACM *psCdc);
+
+/*!<CDC-ACM port instance */
+typedef struct CDC_ACM
+{
+    CDC_RING_T          sTx;            /*!< Device to host */
+    CDC_RING_T          sRx;            /*!< Host to device */
+    CDC_LINE_CODING_T   sLineCoding;
+    uint16_t            u16CtrlSignal;  /*!< SET_CONTROL_LINE_STATE wValue (bit0 DTR, bit1 RTS) */
+    uint16_t            u16FlushTicks;  /*!< Hold a partial IN packet for at most this many ticks, 0 = no hold */
+    volatile uint16_t   u16TxAge;       /*!< Ticks since the last IN transfer */
+    volatile uint8_t    u8TxFlush;      /*!< Flush requested, send the partial packet now */
+    uint8_t             u8TxZlp;        /*!< Last IN packet was full, a terminator is owed */
+    uint32_t            u32MaxPkt;      /*!< Bulk max packet size at the current bus speed */
+    uint32_t            u32MaxXfer;     /*!< Largest bulk IN transfer per start, multiple of u32MaxPkt */
+    uint8_t             *pu8Bounce;     /*!< 2 x u32MaxPkt bytes, word aligned, for packets crossing a ring end */
+    CDC_ACM_CB_T        pfnKick;        /*!< Port: (re)start the endpoints, set by the port open function */
+    CDC_ACM_CB_T        pfnLineCoding;  /*!< Application: SET_LINE_CODE received, may be NULL */
+    uint8_t             u8IfNum;        /*!< Communication interface number (wIndex of class requests) */
+    uint8_t             u8EpIn;         /*!< Bulk IN hardware endpoint */
+    uint8_t             u8EpOut;        /*!< Bulk OUT hardware endpoint */
+    volatile uint8_t    u8TxState;      /*!< Port private */
+    volatile uint8_t    u8RxState;      /*!< Port private */
+    uint32_t            u32TxLen;       /*!< Port private, length of the IN transfer in progress */
+    uint32_t            u32RxLen;       /*!< Port private, length of the OUT transfer in progress */
+    uint8_t             *pu8RxDst;      /*!< Port private, destination of the OUT transfer in progress */
+    CDC_ACM_STATS_T     sStats;
+} CDC_ACM_T;
+
+/* Bounce buffer halves, TX and RX may be in flight at the same time */
+#define CDC_ACM_TX_BOUNCE(psCdc)    ((psCdc)->pu8Bounce)
+#define CDC_ACM_RX_BOUNCE(psCdc)    ((psCdc)->pu8Bounce + (psCdc)->u32MaxPkt)
+
+/*-------------------------------------------------------------*/
+/* Application interface (cdc_acm.c) */
+void     CDC_ACM_Init(CDC_ACM_T *psCdc, uint8_t *pu8TxBuf, uint32_t u32TxSize,
+                      uint8_t *pu8RxBuf, uint32_t u32RxSize, uint8_t *pu8Bounce);
+uint32_t CDC_ACM_Write(CDC_ACM_T *psCdc, const uint8_t *pu8Data, uint32_t u32Len);
+uint32_t CDC_ACM_Read(CDC_ACM_T *psCdc, uint8_t *pu8Data, uint32_t u32Len);
+uint32_t CDC_ACM_TxSpace(CDC_ACM_T *psCdc);
+uint32_t CDC_ACM_RxCount(CDC_ACM_T *psCdc);
+void     CDC_ACM_Flush(CDC_ACM_T *psCdc);
+void     CDC_ACM_Tick(CDC_ACM_T *psCdc);
+
+/* Port interface (cdc_acm.c) */
+void     CDC_ACM_Reset(CDC_ACM_T *psCdc, uint32_t u32MaxPkt, uint32_t u32MaxXfer);
+uint32_t CDC_ACM_TxPrepare(CDC_ACM_T *psCdc, uint8_t **ppu8Data);
+void     CDC_ACM_TxDone(CDC_ACM_T *psCdc, uint32_t u32Len);
+uint8_t *CDC_ACM_RxPrepare(CDC_ACM_T *psCdc, uint32_t u32Len);
+void     CDC_ACM_RxDone(CDC_ACM_T *psCdc, uint8_t *pu8Data, uint32_t u32Len);
+
+/* USBD full speed port (usbd_cdc_acm.c) */
+void     USBD_CDC_Open(CDC_ACM_T *psCdc, uint32_t u32EpIn, uint32_t u32EpOut, uint32_t u32IfNum, uint32_t u32MaxPkt);
+void     USBD_CDC_Reset(CDC_ACM_T *psCdc);
+void     USBD_CDC_EpInHandler(CDC_ACM_T *psCdc);
+void     USBD_CDC_EpOutHandler(CDC_ACM_T *psCdc);
+int32_t  USBD_CDC_ClassRequest(CDC_ACM_T *psCdc);
+void     USBD_CDC_CtrlOutDone(CDC_ACM_T *psCdc);
+
+/* HSUSBD high speed port (hsusbd_cdc_acm.c) */
+void     HSUSBD_CDC_Open(CDC_ACM_T *psCdc, uint32_t u32EpIn, uint32_t u32EpOut, uint32_t u32IfNum);
+void     HSUSBD_CDC_Reset(CDC_ACM_T *psCdc);
+void     HSUSBD_CDC_EpInHandler(CDC_ACM_T *psCdc, uint32_t u32IntSts);
+void     HSUSBD_CDC_EpOutHandler(CDC_ACM_T *psCdc, uint32_t u32IntSts);
+void     HSUSBD_CDC_DmaDone(CDC_ACM_T *psCdc);
+int32_t  HSUSBD_CDC_ClassRequest(CDC_ACM_T *psCdc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CDC_ACM_H__ */
@@ -0,0 +1,325 @@
+/**************************************************************************//**
+ * @file     usbd_fw.h
+ * @version  V1.00
+ * @brief    Descriptor-table driven USB device framework.
+ *
+ * @details  A composite device is described by two tables instead of the
+ *           hand written EPn_BUF_BASE/EPn_BUF_LEN defines and switch ladders:
+ *
+ *           1. An endpoint table (X-macro) in the device header:
+ *
+ *              #define MY_EP_TABLE(X) \
+ *                  X(VCOM_IN,  EP2, 0x81, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+ *                  X(VCOM_OUT, EP3, 0x02, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+ *                  X(VCOM_INT, EP4, 0x83, USBD_FW_EP_INT,   8, 1,                  0) \
+ *                  X(HID_IN,   EP5, 0x84, USBD_FW_EP_INT,  64, 1,                  1)
+ *              USBD_FW_LAYOUT(MY_EP_TABLE, 64)
+ *
+ *              X(name, hardware EP, address, type, max packet, depth, function)
+ *
+ *              USBD_FW_LAYOUT() computes at compile time, as enumerators:
+ *                USBD_FW_EP_<name>     index of the endpoint in the table
+ *                USBD_FW_BASE_<name>   buffer offset in the packet SRAM
+ *                USBD_FW_DEPTH_<name>  packets the buffer holds
+ *                USBD_FW_SRAM_USED     bytes used, checked against USBD_FW_SRAM_SIZE
+ *              and USBD_FW_EP_DEFINE() emits the constant runtime table in
+ *              one C file.
+ *
+ *              Buffers are packed back to back at the controller granularity
+ *              (8 bytes USBD, 4 bytes HSUSBD), the control buffer first. An
+ *              endpoint with depth USBD_FW_DEPTH_AUTO gets a second packet
+ *              if it still fits after every fixed depth endpoint and every
+ *              AUTO endpoint before it in the table, so list the endpoints
+ *              that need the throughput first. On USBD a depth of 2 is the
+ *              hardware double buffer: the second buffer belongs to a spare
+ *              hardware endpoint taken from EP24 downwards with the same
+ *              address, as USBD_VCOM_SerialEmulator_DoubleBuffer pairs them.
+ *              On HSUSBD the depth is the FIFO size in packets.
+ *
+ *           2. A function table, one USBD_FW_FUNC_T per class instance with
+ *              the interfaces it owns and its USBD_FW_CLASS_T operations.
+ *              Class and vendor requests are routed to the function owning
+ *              the interface or endpoint in wIndex and then looked up in the
+ *              request table of its class; endpoint events go to the
+ *              function named in the endpoint table.
+ *
+ *           Standard requests stay in the StdDriver (USBD_StandardRequest /
+ *           HSUSBD_StandardRequest); the ports plug USBD_FW_ClassRequest /
+ *           HSUSBD_FW_ClassRequest in as the class request callback.
+ *
+ *           The layout defaults to USBD; define USBD_FW_HSUSBD before this
+ *           header is included to lay out the HSUSBD endpoint buffer.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __USBD_FW_H__
+#define __USBD_FW_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Endpoint table                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_FW_EP_BULK         0       /*!< Bulk endpoint */
+#define USBD_FW_EP_INT          1       /*!< Interrupt endpoint */
+#define USBD_FW_EP_ISO          2       /*!< Isochronous endpoint */
+
+#define USBD_FW_DEPTH_AUTO      0       /*!< Second packet if the SRAM has room */
+#define USBD_FW_NO_EP           0xFF    /*!< No hardware endpoint / not in the table */
+
+#define USBD_FW_MAX_EP          24      /*!< Endpoints a table can hold besides control */
+
+#ifdef USBD_FW_HSUSBD
+#ifndef USBD_FW_SRAM_SIZE
+#define USBD_FW_SRAM_SIZE       4096    /*!< HSUSBD endpoint buffer, EPBUFST[11:0] */
+#endif
+#define USBD_FW_BUF_ALIGN       4
+#define USBD_FW_MAX_DEPTH       8
+/* CEP buffer at 0 */
+#define USBD_FW_CTRL_SIZE(mps)  USBD_FW_ROUND((mps), USBD_FW_BUF_ALIGN)
+#else
+#ifndef USBD_FW_SRAM_SIZE
+#define USBD_FW_SRAM_SIZE       512     /*!< USBD packet SRAM, BUFSEG[8:3] */
+#endif
+#define USBD_FW_BUF_ALIGN       8
+#define USBD_FW_MAX_DEPTH       2
+/* SETUP packet at 0, EP0 and EP1 share the buffer after it */
+#define USBD_FW_CTRL_SIZE(mps)  (8 + USBD_FW_ROUND((mps), USBD_FW_BUF_ALIGN))
+#endif
+
+#define USBD_FW_ROUND(n, a)     ((((n) + (a) - 1) / (a)) * (a))
+#define USBD_FW_PKT(mps)        USBD_FW_ROUND((mps), USBD_FW_BUF_ALIGN)
+
+/** @cond HIDDEN_SYMBOLS */
+#define USBD_FW_X_INDEX(name, hw, addr, type, mps, depth, func) \
+    USBD_FW_EP_##name,
+
+#define USBD_FW_X_MIN(name, hw, addr, type, mps, depth, func) \
+    + USBD_FW_PKT(mps) * (((depth) == USBD_FW_DEPTH_AUTO) ? 1 : (depth))
+
+/* Running sum of the packets granted to AUTO endpoints, first fit in table order */
+#define USBD_FW_X_GRANT(name, hw, addr, type, mps, depth, func) \
+    USBD_FW_GRANT_##name, \
+    USBD_FW_GRANTEND_##name = USBD_FW_GRANT_##name - 1 + \
+        ((((depth) == USBD_FW_DEPTH_AUTO) && \
+          (USBD_FW_MIN_SIZE + USBD_FW_GRANT_##name + USBD_FW_PKT(mps) <= USBD_FW_SRAM_SIZE)) ? USBD_FW_PKT(mps) : 0),
+
+#define USBD_FW_X_DEPTH(name, hw, addr, type, mps, depth, func) \
+    USBD_FW_DEPTH_##name = ((depth) != USBD_FW_DEPTH_AUTO) ? (depth) : \
+        ((USBD_FW_GRANTEND_##name + 1 != USBD_FW_GRANT_##name) ? 2 : 1),
+
+#define USBD_FW_X_BASE(name, hw, addr, type, mps, depth, func) \
+    USBD_FW_BASE_##name, \
+    USBD_FW_BASEEND_##name = USBD_FW_BASE_##name - 1 + USBD_FW_PKT(mps) * USBD_FW_DEPTH_##name,
+
+/* Running count of the USBD double buffered endpoints, each takes a spare hardware endpoint */
+#define USBD_FW_X_PAIR(name, hw, addr, type, mps, depth, func) \
+    USBD_FW_PAIR_##name, \
+    USBD_FW_PAIREND_##name = USBD_FW_PAIR_##name - 1 + ((USBD_FW_DEPTH_##name == 2) ? 1 : 0),
+
+#define USBD_FW_X_CHECK(name, hw, addr, type, mps, depth, func) \
+    char name[(((depth) <= USBD_FW_MAX_DEPTH) && ((mps) > 0) && ((mps) <= 1024)) ? 1 : -1];
+
+#ifdef USBD_FW_HSUSBD
+#define USBD_FW_X_HW2(name)     USBD_FW_NO_EP
+#else
+#define USBD_FW_X_HW2(name)     ((USBD_FW_DEPTH_##name == 2) ? (USBD_MAX_EP - 1 - USBD_FW_PAIR_##name) : USBD_FW_NO_EP)
+#endif
+
+#define USBD_FW_X_ENTRY(name, hw, addr, type, mps, depth, func) \
+    { (uint8_t)(hw), (uint8_t)USBD_FW_X_HW2(name), (uint8_t)(addr), (uint8_t)(type), \
+      (uint8_t)USBD_FW_DEPTH_##name, (uint8_t)(func), (uint16_t)(mps), \
+      (uint16_t)USBD_FW_BASE_##name, (uint16_t)(USBD_FW_PKT(mps) * USBD_FW_DEPTH_##name) },
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief      Compute the endpoint buffer layout of an endpoint table.
+  * @param[in]  TABLE   X-macro endpoint table.
+  * @param[in]  CTRLMPS Control endpoint max packet size.
+  * @details    Use once, in the device header. A table that does not fit in
+  *             USBD_FW_SRAM_SIZE, a depth above USBD_FW_MAX_DEPTH or a bad
+  *             max packet size fails to compile.
+  */
+#define USBD_FW_LAYOUT(TABLE, CTRLMPS) \
+    enum { TABLE(USBD_FW_X_INDEX) USBD_FW_EP_NUM }; \
+    enum { USBD_FW_CTRL_BASE = 0, USBD_FW_CTRL_LEN = USBD_FW_CTRL_SIZE(CTRLMPS) }; \
+    enum { USBD_FW_MIN_SIZE = USBD_FW_CTRL_SIZE(CTRLMPS) TABLE(USBD_FW_X_MIN) }; \
+    enum { USBD_FW_GRANT_BEGIN_ = -1, TABLE(USBD_FW_X_GRANT) USBD_FW_GRANT_USED }; \
+    enum { TABLE(USBD_FW_X_DEPTH) USBD_FW_DEPTH_END_ }; \
+    enum { USBD_FW_BASE_BEGIN_ = USBD_FW_CTRL_SIZE(CTRLMPS) - 1, TABLE(USBD_FW_X_BASE) USBD_FW_SRAM_USED }; \
+    enum { USBD_FW_PAIR_BEGIN_ = -1, TABLE(USBD_FW_X_PAIR) USBD_FW_PAIR_NUM }; \
+    typedef struct { TABLE(USBD_FW_X_CHECK) } USBD_FW_CHECK_T; \
+    typedef char USBD_FW_SRAM_CHECK_T[(USBD_FW_SRAM_USED <= USBD_FW_SRAM_SIZE) ? 1 : -1]
+
+/**
+  * @brief      Define the runtime endpoint table of a laid out endpoint table.
+  * @param[in]  VAR     Name of the USBD_FW_EP_T array.
+  * @param[in]  TABLE   The X-macro endpoint table given to USBD_FW_LAYOUT().
+  */
+#define USBD_FW_EP_DEFINE(VAR, TABLE) \
+    const USBD_FW_EP_T VAR[USBD_FW_EP_NUM] = { TABLE(USBD_FW_X_ENTRY) }
+
+/*!<Endpoint of the runtime table */
+typedef struct
+{
+    uint8_t  u8HwEp;        /*!< USBD EP2~EP24 or HSUSBD EPA~EPL */
+    uint8_t  u8HwEp2;       /*!< USBD double buffer: hardware endpoint of the second buffer */
+    uint8_t  u8Addr;        /*!< Endpoint address, bit 7 set for IN */
+    uint8_t  u8Type;        /*!< USBD_FW_EP_BULK/INT/ISO */
+    uint8_t  u8Depth;       /*!< Packets the buffer holds */
+    uint8_t  u8Func;        /*!< Index of the owning function */
+    uint16_t u16MaxPkt;     /*!< Max packet size */
+    uint16_t u16Base;       /*!< Buffer offset in the packet SRAM */
+    uint16_t u16Len;        /*!< Buffer length, u8Depth packets */
+} USBD_FW_EP_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Function table                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_FW_REQ_IN          0x80    /*!< Request type: device to host */
+#define USBD_FW_REQ_OUT         0x00    /*!< Request type: host to device */
+#define USBD_FW_REQ_CLASS       0x20    /*!< Request type: class */
+#define USBD_FW_REQ_VENDOR      0x40    /*!< Request type: vendor */
+
+/*!<SETUP packet */
+typedef struct
+{
+    uint8_t  bmRequestType;
+    uint8_t  bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} USBD_FW_SETUP_T;
+
+struct USBD_FW_FUNC;
+struct USBD_FW_DEV;
+
+/**
+  * @brief  Request handler. Starts the data or status stage with USBD_FW_CtrlIn(),
+  *         USBD_FW_CtrlOut() or USBD_FW_CtrlAck() and returns 0, or returns a
+  *         negative value to stall the request.
+  */
+typedef int32_t (*USBD_FW_REQ_CB_T)(struct USBD_FW_FUNC *psFunc, const USBD_FW_SETUP_T *psSetup);
+
+/*!<Entry of a class request table */
+typedef struct
+{
+    uint8_t  u8Type;        /*!< Direction and type bits of bmRequestType, e.g. USBD_FW_REQ_IN | USBD_FW_REQ_CLASS */
+    uint8_t  u8Request;     /*!< bRequest */
+    USBD_FW_REQ_CB_T pfnHandler;
+} USBD_FW_REQ_T;
+
+/*!<Class operations, unused ones are NULL */
+typedef struct
+{
+    const USBD_FW_REQ_T *psReq;     /*!< Class and vendor requests */
+    uint32_t u32ReqNum;
+    /*! Bus reset, the endpoints have just been configured again */
+    void (*pfnReset)(struct USBD_FW_FUNC *psFunc);
+    /*! Event on endpoint u32Ep of the table. USBD: the packet buffer is USBD_FW_EpBuf().
+        HSUSBD: u32IntSts are the enabled EPINTSTS flags, the class clears them. */
+    void (*pfnEpEvent)(struct USBD_FW_FUNC *psFunc, uint32_t u32Ep, uint32_t u32IntSts);
+    /*! Data stage of USBD_FW_CtrlOut() received */
+    void (*pfnCtrlOutDone)(struct USBD_FW_FUNC *psFunc, const USBD_FW_SETUP_T *psSetup);
+    /*! SET_INTERFACE on one of its interfaces */
+    void (*pfnSetInterface)(struct USBD_FW_FUNC *psFunc, uint32_t u32IfNum, uint32_t u32AltIf);
+    /*! HSUSBD DMA done, the class checks whether the transfer was its own */
+    void (*pfnDmaDone)(struct USBD_FW_FUNC *psFunc);
+} USBD_FW_CLASS_T;
+
+/*!<Class instance, owns the interfaces u8IfFirst ~ u8IfFirst + u8IfCount - 1 */
+typedef struct USBD_FW_FUNC
+{
+    const USBD_FW_CLASS_T *psClass;
+    uint8_t  u8IfFirst;
+    uint8_t  u8IfCount;
+    uint8_t  au8Reserved[2];
+    void    *pvCtx;                 /*!< Class instance data */
+    struct USBD_FW_DEV *psDev;      /*!< Set by the framework */
+} USBD_FW_FUNC_T;
+
+/*!<Controller port, control transfer stages */
+typedef struct
+{
+    void (*pfnCtrlIn)(const uint8_t *pu8Buf, uint32_t u32Len);
+    void (*pfnCtrlOut)(uint8_t *pu8Buf, uint32_t u32Len);
+    void (*pfnCtrlAck)(void);
+    void (*pfnCtrlStall)(void);
+} USBD_FW_PORT_T;
+
+/*!<Device instance, one per controller */
+typedef struct USBD_FW_DEV
+{
+    const USBD_FW_PORT_T *psPort;
+    const USBD_FW_EP_T *psEp;
+    uint32_t u32EpNum;
+    USBD_FW_FUNC_T *const *ppsFunc;
+    uint32_t u32FuncNum;
+    USBD_FW_SETUP_T sSetup;             /*!< Request in progress */
+    USBD_FW_FUNC_T *psCtrlOut;          /*!< Owner of a control OUT data stage in progress */
+    uint32_t u32CtrlOutLeft;
+    uint8_t  au8HwMap[32];              /*!< Hardware endpoint -> table index or USBD_FW_NO_EP */
+    uint32_t u32DbNext;                 /*!< USBD double buffer: bit n, next IN buffer of endpoint n is the second */
+    uint32_t u32DbCur;                  /*!< USBD double buffer: bit n, last event of endpoint n was on the second */
+    uint8_t  au8InBusy[USBD_FW_MAX_EP]; /*!< USBD: IN buffers armed per endpoint */
+    volatile uint8_t u8Suspend;
+} USBD_FW_DEV_T;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Core, controller independent (usbd_fw.c)                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t  USBD_FW_Bind(USBD_FW_DEV_T *psDev, const USBD_FW_PORT_T *psPort,
+                      const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                      USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum);
+void     USBD_FW_Setup(USBD_FW_DEV_T *psDev, const uint8_t *pu8Setup);
+void     USBD_FW_SetInterface(USBD_FW_DEV_T *psDev, uint32_t u32IfNum, uint32_t u32AltIf);
+void     USBD_FW_CtrlOutDone(USBD_FW_DEV_T *psDev);
+void     USBD_FW_EpEvent(USBD_FW_DEV_T *psDev, uint32_t u32HwEp, uint32_t u32IntSts);
+void     USBD_FW_Reset(USBD_FW_DEV_T *psDev);
+void     USBD_FW_DmaDone(USBD_FW_DEV_T *psDev);
+uint32_t USBD_FW_FindEp(USBD_FW_DEV_T *psDev, uint32_t u32Addr);
+
+void     USBD_FW_CtrlIn(USBD_FW_FUNC_T *psFunc, const uint8_t *pu8Buf, uint32_t u32Len);
+void     USBD_FW_CtrlOut(USBD_FW_FUNC_T *psFunc, uint8_t *pu8Buf, uint32_t u32Len);
+void     USBD_FW_CtrlAck(USBD_FW_FUNC_T *psFunc);
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* USBD port (usbd_fw_port.c)                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+extern USBD_FW_DEV_T g_sUsbdFw;
+
+int32_t  USBD_FW_Init(const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                      USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum);
+void     USBD_FW_ConfigEp(void);
+void     USBD_FW_ClassRequest(void);
+void     USBD_FW_SetInterfaceReq(uint32_t u32AltInterface);
+void     USBD_FW_IRQHandler(void);
+
+uint8_t *USBD_FW_EpBuf(uint32_t u32Ep);
+uint32_t USBD_FW_EpRxLen(uint32_t u32Ep);
+uint32_t USBD_FW_EpInFree(uint32_t u32Ep);
+void     USBD_FW_EpSubmit(uint32_t u32Ep, uint32_t u32Len);
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* HSUSBD port (hsusbd_fw_port.c)                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+extern USBD_FW_DEV_T g_sHsusbdFw;
+
+int32_t  HSUSBD_FW_Init(const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                        USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum, uint32_t u32CepMaxPkt);
+void     HSUSBD_FW_ConfigEp(uint32_t u32HighSpeed);
+void     HSUSBD_FW_ClassRequest(void);
+void     HSUSBD_FW_SetInterfaceReq(uint32_t u32AltInterface);
+void     HSUSBD_FW_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_FW_H__ */
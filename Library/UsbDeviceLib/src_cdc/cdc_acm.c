@@ -0,0 +1,355 @@
+/**************************************************************************//**
+ * @file     cdc_acm.c
+ * @version  V1.00
+ * @brief    USB device CDC-ACM class core: rings, bulk IN batching and ZLP.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "cdc_acm.h"
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup UsbDeviceLib USB Device Library
+  @{
+*/
+
+/** @addtogroup CDC_ACM_EXPORTED_FUNCTIONS CDC-ACM Exported Functions
+  @{
+*/
+
+static uint32_t RingCount(CDC_RING_T *psRing)
+{
+    return psRing->u32Head - psRing->u32Tail;
+}
+
+/* Copy out of the ring from u32Pos on, across the wrap if needed */
+static void RingCopyOut(CDC_RING_T *psRing, uint32_t u32Pos, uint8_t *pu8Dst, uint32_t u32Len)
+{
+    uint32_t u32Idx = u32Pos & (psRing->u32Size - 1);
+    uint32_t u32First = psRing->u32Size - u32Idx;
+
+    if(u32First > u32Len)
+        u32First = u32Len;
+    memcpy(pu8Dst, &psRing->pu8Buf[u32Idx], u32First);
+    memcpy(pu8Dst + u32First, psRing->pu8Buf, u32Len - u32First);
+}
+
+/* Copy into the ring from u32Pos on, across the wrap if needed */
+static void RingCopyIn(CDC_RING_T *psRing, uint32_t u32Pos, const uint8_t *pu8Src, uint32_t u32Len)
+{
+    uint32_t u32Idx = u32Pos & (psRing->u32Size - 1);
+    uint32_t u32First = psRing->u32Size - u32Idx;
+
+    if(u32First > u32Len)
+        u32First = u32Len;
+    memcpy(&psRing->pu8Buf[u32Idx], pu8Src, u32First);
+    memcpy(psRing->pu8Buf, pu8Src + u32First, u32Len - u32First);
+}
+
+/**
+  * @brief      Initialize a CDC-ACM instance
+  * @param[in]  psCdc      Instance to initialize.
+  * @param[in]  pu8TxBuf   TX ring storage (device to host).
+  * @param[in]  u32TxSize  TX ring size, power of two.
+  * @param[in]  pu8RxBuf   RX ring storage (host to device).
+  * @param[in]  u32RxSize  RX ring size, power of two, at least one max-packet.
+  * @param[in]  pu8Bounce  Bounce buffer, word aligned, twice the largest bulk max-packet size.
+  * @return     None
+  * @details    Line coding defaults to 115200-8n1. The endpoints are bound later
+  *             by USBD_CDC_Open() or HSUSBD_CDC_Open().
+  */
+void CDC_ACM_Init(CDC_ACM_T *psCdc, uint8_t *pu8TxBuf, uint32_t u32TxSize,
+                  uint8_t *pu8RxBuf, uint32_t u32RxSize, uint8_t *pu8Bounce)
+{
+    memset(psCdc, 0, sizeof(CDC_ACM_T));
+    psCdc->sTx.pu8Buf = pu8TxBuf;
+    psCdc->sTx.u32Size = u32TxSize;
+    psCdc->sRx.pu8Buf = pu8RxBuf;
+    psCdc->sRx.u32Size = u32RxSize;
+    psCdc->pu8Bounce = pu8Bounce;
+    psCdc->sLineCoding.u32DTERate = 115200;
+    psCdc->sLineCoding.u8DataBits = 8;
+}
+
+/**
+  * @brief      Queue data for the host
+  * @param[in]  psCdc    CDC-ACM instance.
+  * @param[in]  pu8Data  Data to send.
+  * @param[in]  u32Len   Number of bytes.
+  * @return     Number of bytes queued, less than u32Len when the TX ring is full.
+  * @details    Never blocks. Data shorter than a max-packet stays in the ring
+  *             until more follows, CDC_ACM_Flush() is called or the hold time
+  *             set by u16FlushTicks expires.
+  */
+uint32_t CDC_ACM_Write(CDC_ACM_T *psCdc, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    CDC_RING_T *psRing = &psCdc->sTx;
+    uint32_t u32Head = psRing->u32Head;
+    uint32_t u32Space = psRing->u32Size - (u32Head - psRing->u32Tail);
+
+    if(u32Len > u32Space)
+    {
+        psCdc->sStats.u32TxOverflow += u32Len - u32Space;
+        u32Len = u32Space;
+    }
+    if(u32Len == 0)
+        return 0;
+
+    /* Restart the hold time when the first byte of a new packet arrives */
+    if((u32Head == psRing->u32Tail) && (psCdc->u8TxZlp == 0))
+        psCdc->u16TxAge = 0;
+
+    RingCopyIn(psRing, u32Head, pu8Data, u32Len);
+    __DMB();                            /* data before index */
+    psRing->u32Head = u32Head + u32Len;
+
+    if(psCdc->pfnKick)
+        psCdc->pfnKick(psCdc);
+    return u32Len;
+}
+
+/**
+  * @brief      Fetch data received from the host
+  * @param[in]  psCdc    CDC-ACM instance.
+  * @param[out] pu8Data  Destination.
+  * @param[in]  u32Len   Size of the destination.
+  * @return     Number of bytes copied.
+  * @details    Never blocks. Freeing ring space resumes a bulk OUT endpoint
+  *             that was held for lack of space.
+  */
+uint32_t CDC_ACM_Read(CDC_ACM_T *psCdc, uint8_t *pu8Data, uint32_t u32Len)
+{
+    CDC_RING_T *psRing = &psCdc->sRx;
+    uint32_t u32Tail = psRing->u32Tail;
+    uint32_t u32Count = psRing->u32Head - u32Tail;
+
+    __DMB();                            /* index before data */
+    if(u32Len > u32Count)
+        u32Len = u32Count;
+    if(u32Len == 0)
+        return 0;
+
+    RingCopyOut(psRing, u32Tail, pu8Data, u32Len);
+    __DMB();
+    psRing->u32Tail = u32Tail + u32Len;
+
+    if((psCdc->u8RxState == CDC_ACM_ST_HOLD) && psCdc->pfnKick)
+        psCdc->pfnKick(psCdc);
+    return u32Len;
+}
+
+/**
+  * @brief      Free space in the TX ring
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     Bytes CDC_ACM_Write() accepts without truncation.
+  */
+uint32_t CDC_ACM_TxSpace(CDC_ACM_T *psCdc)
+{
+    return psCdc->sTx.u32Size - RingCount(&psCdc->sTx);
+}
+
+/**
+  * @brief      Received bytes waiting in the RX ring
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     Bytes CDC_ACM_Read() can return.
+  */
+uint32_t CDC_ACM_RxCount(CDC_ACM_T *psCdc)
+{
+    return RingCount(&psCdc->sRx);
+}
+
+/**
+  * @brief      Send everything queued so far without waiting for a full packet
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  */
+void CDC_ACM_Flush(CDC_ACM_T *psCdc)
+{
+    psCdc->u8TxFlush = 1;
+    if(psCdc->pfnKick)
+        psCdc->pfnKick(psCdc);
+}
+
+/**
+  * @brief      Advance the IN hold timer
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call at a fixed rate (e.g. every 1 ms) from thread context or from an
+  *             interrupt at the USB interrupt priority. When a partial packet or an
+  *             owed zero length packet has waited u16FlushTicks ticks, the port is
+  *             kicked to send it.
+  */
+void CDC_ACM_Tick(CDC_ACM_T *psCdc)
+{
+    if(psCdc->u16TxAge != 0xFFFF)
+        psCdc->u16TxAge++;
+
+    if((psCdc->u16TxAge == psCdc->u16FlushTicks) && psCdc->pfnKick &&
+            (RingCount(&psCdc->sTx) || psCdc->u8TxZlp))
+        psCdc->pfnKick(psCdc);
+}
+
+/**
+  * @brief      Restart the transfer state after a bus reset or speed change
+  * @param[in]  psCdc       CDC-ACM instance.
+  * @param[in]  u32MaxPkt   Bulk max packet size at the current speed.
+  * @param[in]  u32MaxXfer  Largest IN transfer the port starts at once.
+  * @return     None
+  * @details    Data queued in the rings is kept.
+  */
+void CDC_ACM_Reset(CDC_ACM_T *psCdc, uint32_t u32MaxPkt, uint32_t u32MaxXfer)
+{
+    psCdc->u32MaxPkt = u32MaxPkt;
+    psCdc->u32MaxXfer = u32MaxXfer - (u32MaxXfer % u32MaxPkt);
+    psCdc->u8TxZlp = 0;
+    psCdc->u8TxFlush = 0;
+    psCdc->u8TxState = CDC_ACM_ST_IDLE;
+    psCdc->u8RxState = CDC_ACM_ST_IDLE;
+}
+
+/**
+  * @brief      Select the next bulk IN transfer
+  * @param[in]  psCdc     CDC-ACM instance.
+  * @param[out] ppu8Data  Start of the data, in the ring or in the bounce buffer.
+  * @return     Transfer length, 0 for a zero length packet or CDC_ACM_TX_NONE.
+  * @details    Full packets are returned as soon as they are queued, as many as
+  *             fit contiguously into u32MaxXfer. A partial packet, or the zero
+  *             length packet owed after a transfer ending on a full packet, is
+  *             returned only once flushed or held for u16FlushTicks ticks.
+  *             The port calls CDC_ACM_TxDone() once the data has left *ppu8Data.
+  */
+uint32_t CDC_ACM_TxPrepare(CDC_ACM_T *psCdc, uint8_t **ppu8Data)
+{
+    CDC_RING_T *psRing = &psCdc->sTx;
+    uint32_t u32Tail = psRing->u32Tail;
+    uint32_t u32Count = psRing->u32Head - u32Tail;
+    uint32_t u32Idx = u32Tail & (psRing->u32Size - 1);
+    uint32_t u32Contig = psRing->u32Size - u32Idx;
+    uint32_t u32Len;
+
+    __DMB();                            /* index before data */
+    if(u32Contig > u32Count)
+        u32Contig = u32Count;
+
+    if(u32Count >= psCdc->u32MaxPkt)
+    {
+        if(u32Contig >= psCdc->u32MaxPkt)
+        {
+            u32Len = (u32Contig > psCdc->u32MaxXfer) ? psCdc->u32MaxXfer : u32Contig;
+            u32Len -= u32Len % psCdc->u32MaxPkt;
+            *ppu8Data = &psRing->pu8Buf[u32Idx];
+        }
+        else
+        {
+            /* One packet across the ring end */
+            u32Len = psCdc->u32MaxPkt;
+            RingCopyOut(psRing, u32Tail, CDC_ACM_TX_BOUNCE(psCdc), u32Len);
+            *ppu8Data = CDC_ACM_TX_BOUNCE(psCdc);
+            psCdc->sStats.u32TxBounce++;
+        }
+        return u32Len;
+    }
+
+    if((u32Count == 0) && (psCdc->u8TxZlp == 0))
+    {
+        psCdc->u8TxFlush = 0;           /* Nothing left to flush */
+        return CDC_ACM_TX_NONE;
+    }
+
+    /* Partial packet or owed ZLP: wait for more data unless flushed or held long enough */
+    if((psCdc->u8TxFlush == 0) && (psCdc->u16TxAge < psCdc->u16FlushTicks))
+        return CDC_ACM_TX_NONE;
+
+    if(u32Count == 0)
+    {
+        *ppu8Data = CDC_ACM_TX_BOUNCE(psCdc);
+        return 0;
+    }
+
+    if(u32Contig < u32Count)
+    {
+        RingCopyOut(psRing, u32Tail, CDC_ACM_TX_BOUNCE(psCdc), u32Count);
+        *ppu8Data = CDC_ACM_TX_BOUNCE(psCdc);
+        psCdc->sStats.u32TxBounce++;
+    }
+    else
+        *ppu8Data = &psRing->pu8Buf[u32Idx];
+    return u32Count;
+}
+
+/**
+  * @brief      Release the data of a bulk IN transfer
+  * @param[in]  psCdc   CDC-ACM instance.
+  * @param[in]  u32Len  Length returned by CDC_ACM_TxPrepare().
+  * @return     None
+  */
+void CDC_ACM_TxDone(CDC_ACM_T *psCdc, uint32_t u32Len)
+{
+    __DMB();                            /* data consumed before index */
+    psCdc->sTx.u32Tail += u32Len;
+
+    psCdc->sStats.u32TxBytes += u32Len;
+    psCdc->sStats.u32TxXfers++;
+    if(u32Len == 0)
+        psCdc->sStats.u32TxZlps++;
+
+    /* A short packet or ZLP ends the host transfer, a full one leaves it open */
+    psCdc->u8TxZlp = (u32Len && ((u32Len % psCdc->u32MaxPkt) == 0)) ? 1 : 0;
+    if(psCdc->u8TxZlp == 0)
+        psCdc->u8TxFlush = 0;
+    psCdc->u16TxAge = 0;
+}
+
+/**
+  * @brief      Find room for a bulk OUT packet
+  * @param[in]  psCdc   CDC-ACM instance.
+  * @param[in]  u32Len  Packet length, at most one max-packet.
+  * @return     Where to put the packet, or NULL when the RX ring is too full.
+  * @details    Returns the ring itself when the space is contiguous, the bounce
+  *             buffer otherwise. Pass the result to CDC_ACM_RxDone().
+  */
+uint8_t *CDC_ACM_RxPrepare(CDC_ACM_T *psCdc, uint32_t u32Len)
+{
+    CDC_RING_T *psRing = &psCdc->sRx;
+    uint32_t u32Head = psRing->u32Head;
+    uint32_t u32Idx = u32Head & (psRing->u32Size - 1);
+
+    if((psRing->u32Size - (u32Head - psRing->u32Tail)) < u32Len)
+        return NULL;
+
+    if((psRing->u32Size - u32Idx) >= u32Len)
+        return &psRing->pu8Buf[u32Idx];
+
+    psCdc->sStats.u32RxBounce++;
+    return CDC_ACM_RX_BOUNCE(psCdc);
+}
+
+/**
+  * @brief      Publish a bulk OUT packet to the application
+  * @param[in]  psCdc    CDC-ACM instance.
+  * @param[in]  pu8Data  Pointer returned by CDC_ACM_RxPrepare().
+  * @param[in]  u32Len   Bytes received.
+  * @return     None
+  */
+void CDC_ACM_RxDone(CDC_ACM_T *psCdc, uint8_t *pu8Data, uint32_t u32Len)
+{
+    CDC_RING_T *psRing = &psCdc->sRx;
+    uint32_t u32Head = psRing->u32Head;
+
+    if(pu8Data == CDC_ACM_RX_BOUNCE(psCdc))
+        RingCopyIn(psRing, u32Head, pu8Data, u32Len);
+    __DMB();                            /* data before index */
+    psRing->u32Head = u32Head + u32Len;
+    psCdc->sStats.u32RxBytes += u32Len;
+}
+
+/*@}*/ /* end of group CDC_ACM_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group UsbDeviceLib */
+
+/*@}*/ /* end of group Library */
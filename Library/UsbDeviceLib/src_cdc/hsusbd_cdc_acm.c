@@ -0,0 +1,337 @@
+/**************************************************************************//**
+ * @file     hsusbd_cdc_acm.c
+ * @version  V1.00
+ * @brief    CDC-ACM port for the HSUSBD high speed device controller.
+ *
+ * @details  Bulk data moves between the rings and the endpoint buffers by the
+ *           HSUSBD DMA. A bulk IN transfer covers up to HSUSBD_CDC_MAX_DMA_LEN
+ *           bytes of full packets; the last packet of a transfer is closed
+ *           with SHORTTXEN when short, or followed by a ZEROLEN packet when the
+ *           class core asks for one. The DMA engine is shared, so TX and RX
+ *           take turns, with a waiting OUT packet served first.
+ *
+ *           The application MUST enable HSUSBD_BUSINTEN_DMADONEIEN_Msk and call
+ *           HSUSBD_CDC_DmaDone() on DMADONEIF. No other HSUSBD DMA user may run
+ *           while the port is open. The application side enters the port with
+ *           USBD20_IRQn masked.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "cdc_acm.h"
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup UsbDeviceLib USB Device Library
+  @{
+*/
+
+/** @addtogroup CDC_ACM_EXPORTED_FUNCTIONS CDC-ACM Exported Functions
+  @{
+*/
+
+#define HSUSBD_CDC_MAX_DMA_LEN  0x1000  /* Largest bulk IN DMA run */
+#define HSUSBD_CDC_DMA_ALIGN    4       /* DMA address alignment */
+
+#define HSUSBD_CDC_RX_INT   (HSUSBD_EPINTEN_RXPKIEN_Msk | HSUSBD_EPINTEN_SHORTRXIEN_Msk)
+
+/* USB endpoint number the hardware endpoint is configured for, as DMACTL wants it */
+static uint32_t HSUSBD_CDC_EpNum(uint32_t u32Ep)
+{
+    return (HSUSBD->EP[u32Ep].EPCFG & HSUSBD_EPCFG_EPNUM_Msk) >> HSUSBD_EPCFG_EPNUM_Pos;
+}
+
+static void HSUSBD_CDC_SendZlp(CDC_ACM_T *psCdc)
+{
+    HSUSBD_CLR_EP_INT_FLAG(psCdc->u8EpIn, HSUSBD_EPINTSTS_TXPKIF_Msk);
+    HSUSBD->EP[psCdc->u8EpIn].EPRSPCTL = (HSUSBD->EP[psCdc->u8EpIn].EPRSPCTL & 0x10) | HSUSBD_EP_RSPCTL_ZEROLEN;
+    CDC_ACM_TxDone(psCdc, 0);
+    psCdc->u8TxState = CDC_ACM_ST_BUSY;
+    HSUSBD_ENABLE_EP_INT(psCdc->u8EpIn, HSUSBD_EPINTEN_TXPKIEN_Msk);
+}
+
+static void HSUSBD_CDC_TxStart(CDC_ACM_T *psCdc)
+{
+    uint8_t *pu8Data;
+    uint32_t u32Len;
+
+    u32Len = CDC_ACM_TxPrepare(psCdc, &pu8Data);
+    if(u32Len == CDC_ACM_TX_NONE)
+        return;
+
+    if(u32Len == 0)
+    {
+        /* A zero length packet may only follow once the last full packet has left */
+        HSUSBD_CLR_EP_INT_FLAG(psCdc->u8EpIn, HSUSBD_EPINTSTS_BUFEMPTYIF_Msk);
+        if(HSUSBD->EP[psCdc->u8EpIn].EPDATCNT & 0xffff)
+        {
+            psCdc->u8TxState = CDC_ACM_ST_ZLP;
+            HSUSBD_ENABLE_EP_INT(psCdc->u8EpIn, HSUSBD_EPINTEN_BUFEMPTYIEN_Msk);
+        }
+        else
+            HSUSBD_CDC_SendZlp(psCdc);
+        return;
+    }
+
+    if((uint32_t)pu8Data & (HSUSBD_CDC_DMA_ALIGN - 1))
+    {
+        /* Ring tail left unaligned by a short packet, send at most one packet from the bounce buffer */
+        if(u32Len > psCdc->u32MaxPkt)
+            u32Len = psCdc->u32MaxPkt;
+        memcpy(CDC_ACM_TX_BOUNCE(psCdc), pu8Data, u32Len);
+        pu8Data = CDC_ACM_TX_BOUNCE(psCdc);
+        psCdc->sStats.u32TxBounce++;
+    }
+
+    psCdc->u32TxLen = u32Len;
+    psCdc->u8TxState = CDC_ACM_ST_DMA;
+    HSUSBD_SET_DMA_READ(HSUSBD_CDC_EpNum(psCdc->u8EpIn));
+    HSUSBD_SET_DMA_ADDR((uint32_t)pu8Data);
+    HSUSBD_SET_DMA_LEN(u32Len);
+    HSUSBD_ENABLE_DMA();
+}
+
+static void HSUSBD_CDC_RxStart(CDC_ACM_T *psCdc)
+{
+    uint32_t u32Len = HSUSBD->EP[psCdc->u8EpOut].EPDATCNT & 0xffff;
+    uint8_t *pu8Dst;
+
+    if(u32Len == 0)
+    {
+        /* Zero length packet from the host, nothing to move */
+        psCdc->u8RxState = CDC_ACM_ST_IDLE;
+        HSUSBD_ENABLE_EP_INT(psCdc->u8EpOut, HSUSBD_CDC_RX_INT);
+        return;
+    }
+
+    pu8Dst = CDC_ACM_RxPrepare(psCdc, u32Len);
+    if(pu8Dst == NULL)
+        return;     /* Stay in HOLD, CDC_ACM_Read() kicks the port */
+
+    if((uint32_t)pu8Dst & (HSUSBD_CDC_DMA_ALIGN - 1))
+    {
+        /* CDC_ACM_RxDone() copies the bounce buffer into the ring */
+        pu8Dst = CDC_ACM_RX_BOUNCE(psCdc);
+        psCdc->sStats.u32RxBounce++;
+    }
+
+    psCdc->pu8RxDst = pu8Dst;
+    psCdc->u32RxLen = u32Len;
+    psCdc->u8RxState = CDC_ACM_ST_DMA;
+    HSUSBD_SET_DMA_WRITE(HSUSBD_CDC_EpNum(psCdc->u8EpOut));
+    HSUSBD_SET_DMA_ADDR((uint32_t)pu8Dst);
+    HSUSBD_SET_DMA_LEN(u32Len);
+    HSUSBD_ENABLE_DMA();
+}
+
+static void HSUSBD_CDC_Service(CDC_ACM_T *psCdc)
+{
+    /* One DMA at a time */
+    if((psCdc->u8TxState == CDC_ACM_ST_DMA) || (psCdc->u8RxState == CDC_ACM_ST_DMA))
+        return;
+
+    /* A waiting OUT packet holds the host off, serve it first */
+    if(psCdc->u8RxState == CDC_ACM_ST_HOLD)
+    {
+        HSUSBD_CDC_RxStart(psCdc);
+        if(psCdc->u8RxState == CDC_ACM_ST_DMA)
+            return;
+    }
+
+    if(psCdc->u8TxState == CDC_ACM_ST_IDLE)
+        HSUSBD_CDC_TxStart(psCdc);
+}
+
+static void HSUSBD_CDC_Kick(CDC_ACM_T *psCdc)
+{
+    /* Called from thread context, keep the USB handlers out while the state changes */
+    NVIC_DisableIRQ(USBD20_IRQn);
+    HSUSBD_CDC_Service(psCdc);
+    NVIC_EnableIRQ(USBD20_IRQn);
+}
+
+/**
+  * @brief      Bind a CDC-ACM instance to HSUSBD endpoints
+  * @param[in]  psCdc     Instance initialized by CDC_ACM_Init().
+  * @param[in]  u32EpIn   Bulk IN hardware endpoint, e.g. EPA.
+  * @param[in]  u32EpOut  Bulk OUT hardware endpoint, e.g. EPB.
+  * @param[in]  u32IfNum  Communication interface number.
+  * @return     None
+  * @details    The endpoints MUST be configured, HSUSBD_CDC_Reset() reads the
+  *             max packet size back from them.
+  */
+void HSUSBD_CDC_Open(CDC_ACM_T *psCdc, uint32_t u32EpIn, uint32_t u32EpOut, uint32_t u32IfNum)
+{
+    psCdc->u8EpIn = (uint8_t)u32EpIn;
+    psCdc->u8EpOut = (uint8_t)u32EpOut;
+    psCdc->u8IfNum = (uint8_t)u32IfNum;
+    psCdc->pfnKick = HSUSBD_CDC_Kick;
+    HSUSBD_CDC_Reset(psCdc);
+}
+
+/**
+  * @brief      Restart the bulk endpoints after a USB bus reset
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call after HSUSBD_ResetDMA() and the endpoint configuration for
+  *             the new bus speed.
+  */
+void HSUSBD_CDC_Reset(CDC_ACM_T *psCdc)
+{
+    CDC_ACM_Reset(psCdc, HSUSBD->EP[psCdc->u8EpIn].EPMPS & HSUSBD_EPMPS_EPMPS_Msk, HSUSBD_CDC_MAX_DMA_LEN);
+    HSUSBD_ENABLE_EP_INT(psCdc->u8EpIn, 0);
+    HSUSBD_ENABLE_EP_INT(psCdc->u8EpOut, HSUSBD_CDC_RX_INT);
+}
+
+/**
+  * @brief      Bulk IN endpoint event
+  * @param[in]  psCdc     CDC-ACM instance.
+  * @param[in]  u32IntSts EPINTSTS & EPINTEN of the bulk IN endpoint.
+  * @return     None
+  * @details    Clears the flags itself.
+  */
+void HSUSBD_CDC_EpInHandler(CDC_ACM_T *psCdc, uint32_t u32IntSts)
+{
+    HSUSBD_ENABLE_EP_INT(psCdc->u8EpIn, 0);
+    HSUSBD_CLR_EP_INT_FLAG(psCdc->u8EpIn, u32IntSts);
+
+    if(psCdc->u8TxState == CDC_ACM_ST_ZLP)
+        HSUSBD_CDC_SendZlp(psCdc);      /* Buffer drained */
+    else if(psCdc->u8TxState == CDC_ACM_ST_BUSY)
+        psCdc->u8TxState = CDC_ACM_ST_IDLE;
+
+    HSUSBD_CDC_Service(psCdc);
+}
+
+/**
+  * @brief      Bulk OUT endpoint event
+  * @param[in]  psCdc     CDC-ACM instance.
+  * @param[in]  u32IntSts EPINTSTS & EPINTEN of the bulk OUT endpoint.
+  * @return     None
+  * @details    Clears the flags itself. The packet stays in the endpoint
+  *             buffer, NAKing further OUT tokens, until it is moved by DMA.
+  */
+void HSUSBD_CDC_EpOutHandler(CDC_ACM_T *psCdc, uint32_t u32IntSts)
+{
+    HSUSBD_ENABLE_EP_INT(psCdc->u8EpOut, 0);
+    HSUSBD_CLR_EP_INT_FLAG(psCdc->u8EpOut, u32IntSts);
+
+    psCdc->u8RxState = CDC_ACM_ST_HOLD;
+    HSUSBD_CDC_Service(psCdc);
+
+    /* Still held with the DMA free: the RX ring is full */
+    if((psCdc->u8RxState == CDC_ACM_ST_HOLD) && (psCdc->u8TxState != CDC_ACM_ST_DMA))
+        psCdc->sStats.u32RxHold++;
+}
+
+/**
+  * @brief      HSUSBD DMA finished
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call from USBD20_IRQHandler() on DMADONEIF.
+  */
+void HSUSBD_CDC_DmaDone(CDC_ACM_T *psCdc)
+{
+    if(psCdc->u8TxState == CDC_ACM_ST_DMA)
+    {
+        CDC_ACM_TxDone(psCdc, psCdc->u32TxLen);
+        if(psCdc->u32TxLen % psCdc->u32MaxPkt)
+        {
+            /* Close the short packet and wait for it to leave before the next transfer */
+            HSUSBD_CLR_EP_INT_FLAG(psCdc->u8EpIn, HSUSBD_EPINTSTS_BUFEMPTYIF_Msk);
+            HSUSBD->EP[psCdc->u8EpIn].EPRSPCTL = (HSUSBD->EP[psCdc->u8EpIn].EPRSPCTL & 0x10) | HSUSBD_EP_RSPCTL_SHORTTXEN;
+            psCdc->u8TxState = CDC_ACM_ST_BUSY;
+            HSUSBD_ENABLE_EP_INT(psCdc->u8EpIn, HSUSBD_EPINTEN_BUFEMPTYIEN_Msk);
+        }
+        else
+            psCdc->u8TxState = CDC_ACM_ST_IDLE;     /* Full packets go out by themselves */
+    }
+    else if(psCdc->u8RxState == CDC_ACM_ST_DMA)
+    {
+        CDC_ACM_RxDone(psCdc, psCdc->pu8RxDst, psCdc->u32RxLen);
+        psCdc->u8RxState = CDC_ACM_ST_IDLE;
+        HSUSBD_ENABLE_EP_INT(psCdc->u8EpOut, HSUSBD_CDC_RX_INT);
+    }
+
+    HSUSBD_CDC_Service(psCdc);
+}
+
+/**
+  * @brief      Handle a CDC class request
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @retval     0      Request handled (answered or stalled).
+  * @retval     -1     Request is addressed to another interface.
+  * @details    Call from the class request callback given to HSUSBD_Open().
+  *             SET_LINE_CODE is reported through pfnLineCoding.
+  */
+int32_t HSUSBD_CDC_ClassRequest(CDC_ACM_T *psCdc)
+{
+    if((gUsbCmd.wIndex & 0xff) != psCdc->u8IfNum)
+        return -1;
+
+    if(gUsbCmd.bmRequestType & 0x80)    /* request data transfer direction */
+    {
+        // Device to host
+        switch(gUsbCmd.bRequest)
+        {
+            case CDC_GET_LINE_CODE:
+            {
+                HSUSBD_PrepareCtrlIn((uint8_t *)&psCdc->sLineCoding, 7);
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_INTKIEN_Msk);
+                break;
+            }
+            default:
+            {
+                /* Setup error, stall the device */
+                HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_STALLEN_Msk);
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Host to device
+        switch(gUsbCmd.bRequest)
+        {
+            case CDC_SET_CONTROL_LINE_STATE:
+            {
+                psCdc->u16CtrlSignal = gUsbCmd.wValue;
+                /* Status stage */
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+                HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+                break;
+            }
+            case CDC_SET_LINE_CODE:
+            {
+                HSUSBD_CtrlOut((uint8_t *)&psCdc->sLineCoding, 7);
+                /* Status stage */
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+                HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+
+                if(psCdc->pfnLineCoding)
+                    psCdc->pfnLineCoding(psCdc);
+                break;
+            }
+            default:
+            {
+                /* Setup error, stall the device */
+                HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_STALLEN_Msk);
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/*@}*/ /* end of group CDC_ACM_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group UsbDeviceLib */
+
+/*@}*/ /* end of group Library */
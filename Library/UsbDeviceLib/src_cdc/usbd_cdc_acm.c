@@ -0,0 +1,227 @@
+/**************************************************************************//**
+ * @file     usbd_cdc_acm.c
+ * @version  V1.00
+ * @brief    CDC-ACM port for the USBD full speed device controller.
+ *
+ * @details  Bulk IN and bulk OUT go through the endpoint SRAM one packet at a
+ *           time, so u32MaxXfer equals u32MaxPkt on this port. The application
+ *           side (CDC_ACM_Write/Read/Flush/Tick) enters the port with USBD_IRQn
+ *           masked.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "cdc_acm.h"
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup UsbDeviceLib USB Device Library
+  @{
+*/
+
+/** @addtogroup CDC_ACM_EXPORTED_FUNCTIONS CDC-ACM Exported Functions
+  @{
+*/
+
+/* Move the packet waiting in the bulk OUT endpoint into the RX ring */
+static void USBD_CDC_RxPacket(CDC_ACM_T *psCdc)
+{
+    uint32_t u32Len = USBD_GET_PAYLOAD_LEN(psCdc->u8EpOut);
+    uint8_t *pu8Dst = CDC_ACM_RxPrepare(psCdc, u32Len);
+
+    if(pu8Dst == NULL)
+    {
+        /* Leave the endpoint NAKing until CDC_ACM_Read() frees space */
+        if(psCdc->u8RxState != CDC_ACM_ST_HOLD)
+            psCdc->sStats.u32RxHold++;
+        psCdc->u8RxState = CDC_ACM_ST_HOLD;
+        return;
+    }
+
+    USBD_MemCopy(pu8Dst, (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(psCdc->u8EpOut)), u32Len);
+    CDC_ACM_RxDone(psCdc, pu8Dst, u32Len);
+    psCdc->u8RxState = CDC_ACM_ST_IDLE;
+
+    /* Ready for the next packet */
+    USBD_SET_PAYLOAD_LEN(psCdc->u8EpOut, psCdc->u32MaxPkt);
+}
+
+static void USBD_CDC_Service(CDC_ACM_T *psCdc)
+{
+    uint8_t *pu8Data;
+    uint32_t u32Len;
+
+    if(psCdc->u8TxState == CDC_ACM_ST_IDLE)
+    {
+        u32Len = CDC_ACM_TxPrepare(psCdc, &pu8Data);
+        if(u32Len != CDC_ACM_TX_NONE)
+        {
+            /* The packet is in the endpoint SRAM once copied, release it from the ring now */
+            USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(psCdc->u8EpIn)), pu8Data, u32Len);
+            CDC_ACM_TxDone(psCdc, u32Len);
+            psCdc->u8TxState = CDC_ACM_ST_BUSY;
+            USBD_SET_PAYLOAD_LEN(psCdc->u8EpIn, u32Len);
+        }
+    }
+
+    if(psCdc->u8RxState == CDC_ACM_ST_HOLD)
+        USBD_CDC_RxPacket(psCdc);
+}
+
+static void USBD_CDC_Kick(CDC_ACM_T *psCdc)
+{
+    /* Called from thread context, keep the USB handlers out while the state changes */
+    NVIC_DisableIRQ(USBD_IRQn);
+    USBD_CDC_Service(psCdc);
+    NVIC_EnableIRQ(USBD_IRQn);
+}
+
+/**
+  * @brief      Bind a CDC-ACM instance to USBD endpoints
+  * @param[in]  psCdc     Instance initialized by CDC_ACM_Init().
+  * @param[in]  u32EpIn   Bulk IN hardware endpoint, e.g. EP2.
+  * @param[in]  u32EpOut  Bulk OUT hardware endpoint, e.g. EP3.
+  * @param[in]  u32IfNum  Communication interface number.
+  * @param[in]  u32MaxPkt Bulk max packet size, 64 at full speed.
+  * @return     None
+  * @details    The endpoints MUST be configured and have their buffers set.
+  *             Arms the bulk OUT endpoint.
+  */
+void USBD_CDC_Open(CDC_ACM_T *psCdc, uint32_t u32EpIn, uint32_t u32EpOut, uint32_t u32IfNum, uint32_t u32MaxPkt)
+{
+    psCdc->u8EpIn = (uint8_t)u32EpIn;
+    psCdc->u8EpOut = (uint8_t)u32EpOut;
+    psCdc->u8IfNum = (uint8_t)u32IfNum;
+    psCdc->u32MaxPkt = u32MaxPkt;
+    psCdc->pfnKick = USBD_CDC_Kick;
+    USBD_CDC_Reset(psCdc);
+}
+
+/**
+  * @brief      Restart the bulk endpoints after a USB bus reset
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  */
+void USBD_CDC_Reset(CDC_ACM_T *psCdc)
+{
+    CDC_ACM_Reset(psCdc, psCdc->u32MaxPkt, psCdc->u32MaxPkt);
+    USBD_SET_PAYLOAD_LEN(psCdc->u8EpOut, psCdc->u32MaxPkt);
+}
+
+/**
+  * @brief      Bulk IN endpoint event
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call from USBD_IRQHandler() after clearing the endpoint flag.
+  */
+void USBD_CDC_EpInHandler(CDC_ACM_T *psCdc)
+{
+    psCdc->u8TxState = CDC_ACM_ST_IDLE;
+    USBD_CDC_Service(psCdc);
+}
+
+/**
+  * @brief      Bulk OUT endpoint event
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call from USBD_IRQHandler() after clearing the endpoint flag.
+  */
+void USBD_CDC_EpOutHandler(CDC_ACM_T *psCdc)
+{
+    USBD_CDC_RxPacket(psCdc);
+}
+
+/**
+  * @brief      Handle a CDC class request
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @retval     0      Request handled (answered or stalled).
+  * @retval     -1     Request is addressed to another interface.
+  * @details    Call from the class request callback given to USBD_Open().
+  */
+int32_t USBD_CDC_ClassRequest(CDC_ACM_T *psCdc)
+{
+    uint8_t au8Buf[8];
+
+    USBD_GetSetupPacket(au8Buf);
+
+    if(au8Buf[4] != psCdc->u8IfNum)
+        return -1;
+
+    if(au8Buf[0] & 0x80)    /* request data transfer direction */
+    {
+        // Device to host
+        switch(au8Buf[1])
+        {
+            case CDC_GET_LINE_CODE:
+            {
+                USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)), (uint8_t *)&psCdc->sLineCoding, 7);
+                /* Data stage */
+                USBD_SET_DATA1(EP0);
+                USBD_SET_PAYLOAD_LEN(EP0, 7);
+                /* Status stage */
+                USBD_PrepareCtrlOut(0, 0);
+                break;
+            }
+            default:
+            {
+                /* Setup error, stall the device */
+                USBD_SetStall(0);
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Host to device
+        switch(au8Buf[1])
+        {
+            case CDC_SET_CONTROL_LINE_STATE:
+            {
+                psCdc->u16CtrlSignal = (uint16_t)((au8Buf[3] << 8) | au8Buf[2]);
+                /* Status stage */
+                USBD_SET_DATA1(EP0);
+                USBD_SET_PAYLOAD_LEN(EP0, 0);
+                break;
+            }
+            case CDC_SET_LINE_CODE:
+            {
+                USBD_PrepareCtrlOut((uint8_t *)&psCdc->sLineCoding, 7);
+                /* Status stage */
+                USBD_SET_DATA1(EP0);
+                USBD_SET_PAYLOAD_LEN(EP0, 0);
+                break;
+            }
+            default:
+            {
+                /* Setup error, stall the device */
+                USBD_SetStall(0);
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief      Control OUT data stage finished
+  * @param[in]  psCdc  CDC-ACM instance.
+  * @return     None
+  * @details    Call from USBD_IRQHandler() right after USBD_CtrlOut(). Reports
+  *             a new line coding through pfnLineCoding.
+  */
+void USBD_CDC_CtrlOutDone(CDC_ACM_T *psCdc)
+{
+    if((g_usbd_SetupPacket[1] == CDC_SET_LINE_CODE) && (g_usbd_SetupPacket[4] == psCdc->u8IfNum) &&
+            psCdc->pfnLineCoding)
+        psCdc->pfnLineCoding(psCdc);
+}
+
+/*@}*/ /* end of group CDC_ACM_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group UsbDeviceLib */
+
+/*@}*/ /* end of group Library */
@@ -0,0 +1,374 @@
+/**************************************************************************//**
+ * @file     hsusbd_fw_port.c
+ * @version  V1.00
+ * @brief    USB device framework, HSUSBD (high speed) port.
+ *
+ * @details  Usage:
+ *               HSUSBD_Open(&gsHSInfo, HSUSBD_FW_ClassRequest, HSUSBD_FW_SetInterfaceReq);
+ *               HSUSBD_SetVendorRequest(HSUSBD_FW_ClassRequest);
+ *               HSUSBD_FW_Init(g_asMyEp, USBD_FW_EP_NUM, g_apsMyFunc, n, CEP_MAX_PKT_SIZE);
+ *           and USBD20_IRQHandler() calls HSUSBD_FW_IRQHandler().
+ *
+ *           The endpoint buffers come from a table laid out with
+ *           USBD_FW_HSUSBD defined. The max packet size of the table is the
+ *           high speed one; at full speed bulk and interrupt endpoints drop
+ *           to 64 bytes and keep their buffer, which then holds more packets.
+ *           Classes enable their own EPINTEN bits and clear the flags they
+ *           are given in pfnEpEvent.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "usbd_fw.h"
+
+USBD_FW_DEV_T g_sHsusbdFw;
+
+static uint32_t s_u32CepMaxPkt = 64;
+
+/* USBD_FW_EP_BULK/INT/ISO */
+static const uint32_t s_au32EpType[] =
+{
+    HSUSBD_EP_CFG_TYPE_BULK,
+    HSUSBD_EP_CFG_TYPE_INT,
+    HSUSBD_EP_CFG_TYPE_ISO
+};
+
+/* Largest full speed packet per type */
+static const uint16_t s_au16FsMaxPkt[] = { 64, 64, 1023 };
+
+static void HSUSBD_FW_PortCtrlAck(void)
+{
+    /* Status stage */
+    HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+    HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+    HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+}
+
+static void HSUSBD_FW_PortCtrlIn(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    HSUSBD_PrepareCtrlIn((uint8_t *)pu8Buf, u32Len);
+    HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+    HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_INTKIEN_Msk);
+}
+
+static void HSUSBD_FW_PortCtrlOut(uint8_t *pu8Buf, uint32_t u32Len)
+{
+    /* The data stage is polled, it is complete on return */
+    HSUSBD_CtrlOut(pu8Buf, u32Len);
+    HSUSBD_FW_PortCtrlAck();
+    USBD_FW_CtrlOutDone(&g_sHsusbdFw);
+}
+
+static void HSUSBD_FW_PortCtrlStall(void)
+{
+    /* Setup error, stall the device */
+    HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_STALLEN_Msk);
+}
+
+static const USBD_FW_PORT_T s_sHsusbdFwPort =
+{
+    HSUSBD_FW_PortCtrlIn,
+    HSUSBD_FW_PortCtrlOut,
+    HSUSBD_FW_PortCtrlAck,
+    HSUSBD_FW_PortCtrlStall
+};
+
+/**
+  * @brief      Attach the tables and configure the controller for high speed.
+  * @retval     0   Success.
+  * @retval     -1  The tables do not fit together, see USBD_FW_Bind().
+  */
+int32_t HSUSBD_FW_Init(const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                       USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum, uint32_t u32CepMaxPkt)
+{
+    uint32_t i, u32GIntEn = HSUSBD_GINTEN_USBIEN_Msk | HSUSBD_GINTEN_CEPIEN_Msk;
+
+    if(USBD_FW_Bind(&g_sHsusbdFw, &s_sHsusbdFwPort, psEp, u32EpNum, ppsFunc, u32FuncNum) != 0)
+        return -1;
+
+    for(i = 0; i < u32EpNum; i++)
+    {
+        if(psEp[i].u8HwEp >= HSUSBD_MAX_EP)
+            return -1;
+        u32GIntEn |= HSUSBD_GINTEN_EPAIEN_Msk << psEp[i].u8HwEp;
+    }
+    s_u32CepMaxPkt = u32CepMaxPkt;
+
+    /* Configure USB controller */
+    HSUSBD_ENABLE_USB_INT(u32GIntEn);
+    /* Enable BUS interrupt */
+    HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+    /* Reset Address to 0 */
+    HSUSBD_SET_ADDR(0);
+
+    /* Control endpoint at the start of the buffer */
+    HSUSBD_SetEpBufAddr(CEP, 0, s_u32CepMaxPkt);
+    HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+
+    HSUSBD_FW_ConfigEp(1);
+    return 0;
+}
+
+/**
+  * @brief      Configure the table endpoints for the bus speed.
+  * @param[in]  u32HighSpeed    1: high speed packet sizes, 0: full speed.
+  */
+void HSUSBD_FW_ConfigEp(uint32_t u32HighSpeed)
+{
+    const USBD_FW_EP_T *psEp;
+    uint32_t i, u32MaxPkt;
+
+    for(i = 0; i < g_sHsusbdFw.u32EpNum; i++)
+    {
+        psEp = &g_sHsusbdFw.psEp[i];
+        u32MaxPkt = psEp->u16MaxPkt;
+        if(!u32HighSpeed && (u32MaxPkt > s_au16FsMaxPkt[psEp->u8Type]))
+            u32MaxPkt = s_au16FsMaxPkt[psEp->u8Type];
+
+        HSUSBD_SetEpBufAddr(psEp->u8HwEp, psEp->u16Base, psEp->u16Len);
+        HSUSBD_SET_MAX_PAYLOAD(psEp->u8HwEp, u32MaxPkt);
+        HSUSBD_ConfigEp(psEp->u8HwEp, psEp->u8Addr & 0xFul, s_au32EpType[psEp->u8Type],
+                        (psEp->u8Addr & 0x80) ? HSUSBD_EP_CFG_DIR_IN : HSUSBD_EP_CFG_DIR_OUT);
+    }
+}
+
+/**
+  * @brief      Class and vendor request callback for HSUSBD_Open()/HSUSBD_SetVendorRequest().
+  */
+void HSUSBD_FW_ClassRequest(void)
+{
+    uint8_t au8Setup[8];
+
+    au8Setup[0] = gUsbCmd.bmRequestType;
+    au8Setup[1] = gUsbCmd.bRequest;
+    au8Setup[2] = (uint8_t)gUsbCmd.wValue;
+    au8Setup[3] = (uint8_t)(gUsbCmd.wValue >> 8);
+    au8Setup[4] = (uint8_t)gUsbCmd.wIndex;
+    au8Setup[5] = (uint8_t)(gUsbCmd.wIndex >> 8);
+    au8Setup[6] = (uint8_t)gUsbCmd.wLength;
+    au8Setup[7] = (uint8_t)(gUsbCmd.wLength >> 8);
+    USBD_FW_Setup(&g_sHsusbdFw, au8Setup);
+}
+
+/**
+  * @brief      Set interface callback for HSUSBD_Open().
+  */
+void HSUSBD_FW_SetInterfaceReq(uint32_t u32AltInterface)
+{
+    USBD_FW_SetInterface(&g_sHsusbdFw, gUsbCmd.wIndex & 0xFF, u32AltInterface);
+}
+
+/**
+  * @brief      HSUSBD interrupt service, call from USBD20_IRQHandler().
+  */
+void HSUSBD_FW_IRQHandler(void)
+{
+    __IO uint32_t IrqStL, IrqSt;
+    uint32_t i;
+
+    IrqStL = HSUSBD->GINTSTS & HSUSBD->GINTEN;    /* get interrupt status */
+
+    if(!IrqStL)    return;
+
+    /* USB interrupt */
+    if(IrqStL & HSUSBD_GINTSTS_USBIF_Msk)
+    {
+        IrqSt = HSUSBD->BUSINTSTS & HSUSBD->BUSINTEN;
+
+        if(IrqSt & HSUSBD_BUSINTSTS_SOFIF_Msk)
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_SOFIF_Msk);
+
+        if(IrqSt & HSUSBD_BUSINTSTS_RSTIF_Msk)
+        {
+            HSUSBD_SwReset();
+
+            HSUSBD_ResetDMA();
+            for(i = 0; i < g_sHsusbdFw.u32EpNum; i++)
+                HSUSBD->EP[g_sHsusbdFw.psEp[i].u8HwEp].EPRSPCTL = HSUSBD_EPRSPCTL_FLUSH_Msk;
+
+            HSUSBD_FW_ConfigEp((HSUSBD->OPER & 0x04) ? 1 : 0);  /* high speed? */
+            USBD_FW_Reset(&g_sHsusbdFw);
+            g_sHsusbdFw.u8Suspend = 0;
+
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            HSUSBD_SET_ADDR(0);
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_SUSPENDIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_RSTIF_Msk);
+            HSUSBD_CLR_CEP_INT_FLAG(0x1ffc);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_RESUMEIF_Msk)
+        {
+            g_sHsusbdFw.u8Suspend = 0;
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_SUSPENDIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_RESUMEIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_SUSPENDIF_Msk)
+        {
+            g_sHsusbdFw.u8Suspend = 1;
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_SUSPENDIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_HISPDIF_Msk)
+        {
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_HISPDIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_DMADONEIF_Msk)
+        {
+            g_hsusbd_DmaDone = 1;
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_DMADONEIF_Msk);
+            USBD_FW_DmaDone(&g_sHsusbdFw);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_PHYCLKVLDIF_Msk)
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_PHYCLKVLDIF_Msk);
+
+        if(IrqSt & HSUSBD_BUSINTSTS_VBUSDETIF_Msk)
+        {
+            if(HSUSBD_IS_ATTACHED())
+            {
+                /* USB Plug In */
+                HSUSBD_ENABLE_USB();
+            }
+            else
+            {
+                /* USB Un-plug */
+                HSUSBD_DISABLE_USB();
+            }
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_VBUSDETIF_Msk);
+        }
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_CEPIF_Msk)
+    {
+        IrqSt = HSUSBD->CEPINTSTS & HSUSBD->CEPINTEN;
+
+        if(IrqSt & HSUSBD_CEPINTSTS_SETUPTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_SETUPTKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_SETUPPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_SETUPPKIF_Msk);
+            HSUSBD_ProcessSetupPacket();
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_OUTTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_OUTTKIF_Msk);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_INTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+            if(!(IrqSt & HSUSBD_CEPINTSTS_STSDONEIF_Msk))
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_TXPKIEN_Msk);
+                HSUSBD_CtrlIn();
+            }
+            else
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_TXPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            }
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_PINGIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_PINGIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_TXPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+            HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+            if(g_hsusbd_CtrlInSize)
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_INTKIEN_Msk);
+            }
+            else
+            {
+                if(g_hsusbd_CtrlZero == 1)
+                    HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_ZEROLEN);
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            }
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_RXPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_RXPKIF_Msk);
+            HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_NAKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_NAKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_STALLIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STALLIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_ERRIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_ERRIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_STSDONEIF_Msk)
+        {
+            HSUSBD_UpdateDeviceState();
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_BUFFULLIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_BUFFULLIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_BUFEMPTYIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_BUFEMPTYIF_Msk);
+            return;
+        }
+    }
+
+    /* EPA ~ EPL, routed through the endpoint table */
+    for(i = 0; i < HSUSBD_MAX_EP; i++)
+    {
+        if(IrqStL & (HSUSBD_GINTSTS_EPAIF_Msk << i))
+        {
+            IrqSt = HSUSBD->EP[i].EPINTSTS & HSUSBD->EP[i].EPINTEN;
+            if(g_sHsusbdFw.au8HwMap[i] == USBD_FW_NO_EP)
+                HSUSBD_CLR_EP_INT_FLAG(i, IrqSt);
+            else
+                USBD_FW_EpEvent(&g_sHsusbdFw, i, IrqSt);
+        }
+    }
+}
@@ -0,0 +1,281 @@
+/**************************************************************************//**
+ * @file     usbd_fw.c
+ * @version  V1.00
+ * @brief    USB device framework core: request routing and endpoint event
+ *           dispatch through the function and endpoint tables.
+ *
+ * @details  Nothing here touches a register; the control transfer stages go
+ *           through the USBD_FW_PORT_T of the controller port.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "usbd_fw.h"
+
+#define USBD_FW_RECIP_MSK       0x1F
+#define USBD_FW_RECIP_DEVICE    0x00
+#define USBD_FW_RECIP_IF        0x01
+#define USBD_FW_RECIP_EP        0x02
+#define USBD_FW_TYPE_MSK        0xE0    /* direction and type */
+
+/**
+  * @brief      Attach the endpoint and function tables to a device.
+  * @param[in]  psDev       Device instance.
+  * @param[in]  psPort      Control transfer stages of the controller.
+  * @param[in]  psEp        Endpoint table, see USBD_FW_EP_DEFINE().
+  * @param[in]  u32EpNum    Entries in psEp.
+  * @param[in]  ppsFunc     Function table, indexed by the function field of the endpoint table.
+  * @param[in]  u32FuncNum  Entries in ppsFunc.
+  * @retval     0   Success.
+  * @retval     -1  Two entries use the same hardware endpoint, or one names a missing function.
+  */
+int32_t USBD_FW_Bind(USBD_FW_DEV_T *psDev, const USBD_FW_PORT_T *psPort,
+                     const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                     USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum)
+{
+    uint32_t i;
+
+    if(u32EpNum > USBD_FW_MAX_EP)
+        return -1;
+
+    memset(psDev, 0, sizeof(USBD_FW_DEV_T));
+    memset(psDev->au8HwMap, USBD_FW_NO_EP, sizeof(psDev->au8HwMap));
+    psDev->psPort = psPort;
+    psDev->psEp = psEp;
+    psDev->u32EpNum = u32EpNum;
+    psDev->ppsFunc = ppsFunc;
+    psDev->u32FuncNum = u32FuncNum;
+
+    for(i = 0; i < u32EpNum; i++)
+    {
+        if((psEp[i].u8Func >= u32FuncNum) || (psEp[i].u8HwEp >= sizeof(psDev->au8HwMap)) ||
+                (psDev->au8HwMap[psEp[i].u8HwEp] != USBD_FW_NO_EP))
+            return -1;
+        psDev->au8HwMap[psEp[i].u8HwEp] = (uint8_t)i;
+    }
+
+    /* Second buffers of double buffered endpoints must not collide with the table */
+    for(i = 0; i < u32EpNum; i++)
+    {
+        if(psEp[i].u8HwEp2 == USBD_FW_NO_EP)
+            continue;
+        if((psEp[i].u8HwEp2 >= sizeof(psDev->au8HwMap)) || (psDev->au8HwMap[psEp[i].u8HwEp2] != USBD_FW_NO_EP))
+            return -1;
+        psDev->au8HwMap[psEp[i].u8HwEp2] = (uint8_t)i;
+    }
+
+    for(i = 0; i < u32FuncNum; i++)
+        ppsFunc[i]->psDev = psDev;
+
+    return 0;
+}
+
+/**
+  * @brief      Find the table index of an endpoint address.
+  * @return     Index, or USBD_FW_NO_EP.
+  */
+uint32_t USBD_FW_FindEp(USBD_FW_DEV_T *psDev, uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for(i = 0; i < psDev->u32EpNum; i++)
+    {
+        if(psDev->psEp[i].u8Addr == (uint8_t)u32Addr)
+            return i;
+    }
+    return USBD_FW_NO_EP;
+}
+
+static USBD_FW_FUNC_T *USBD_FW_FindIf(USBD_FW_DEV_T *psDev, uint32_t u32IfNum)
+{
+    USBD_FW_FUNC_T *psFunc;
+    uint32_t i;
+
+    for(i = 0; i < psDev->u32FuncNum; i++)
+    {
+        psFunc = psDev->ppsFunc[i];
+        if((u32IfNum >= psFunc->u8IfFirst) && (u32IfNum < (uint32_t)psFunc->u8IfFirst + psFunc->u8IfCount))
+            return psFunc;
+    }
+    return NULL;
+}
+
+static const USBD_FW_REQ_T *USBD_FW_FindReq(const USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    const USBD_FW_REQ_T *psReq = psFunc->psClass->psReq;
+    uint32_t i;
+
+    for(i = 0; i < psFunc->psClass->u32ReqNum; i++)
+    {
+        if((psReq[i].u8Request == psSetup->bRequest) &&
+                (psReq[i].u8Type == (psSetup->bmRequestType & USBD_FW_TYPE_MSK)))
+            return &psReq[i];
+    }
+    return NULL;
+}
+
+/**
+  * @brief      Route a class or vendor SETUP packet.
+  * @param[in]  psDev       Device instance.
+  * @param[in]  pu8Setup    The 8 bytes SETUP packet.
+  * @details    Interface recipient: the function owning the interface.
+  *             Endpoint recipient: the function owning the endpoint.
+  *             Device recipient: the first function whose table has the request.
+  *             The request is stalled when no handler takes it.
+  */
+void USBD_FW_Setup(USBD_FW_DEV_T *psDev, const uint8_t *pu8Setup)
+{
+    USBD_FW_SETUP_T *psSetup = &psDev->sSetup;
+    USBD_FW_FUNC_T *psFunc = NULL;
+    const USBD_FW_REQ_T *psReq = NULL;
+    uint32_t i;
+
+    psSetup->bmRequestType = pu8Setup[0];
+    psSetup->bRequest = pu8Setup[1];
+    psSetup->wValue = (uint16_t)(pu8Setup[2] | (pu8Setup[3] << 8));
+    psSetup->wIndex = (uint16_t)(pu8Setup[4] | (pu8Setup[5] << 8));
+    psSetup->wLength = (uint16_t)(pu8Setup[6] | (pu8Setup[7] << 8));
+    psDev->psCtrlOut = NULL;
+
+    switch(psSetup->bmRequestType & USBD_FW_RECIP_MSK)
+    {
+        case USBD_FW_RECIP_IF:
+            psFunc = USBD_FW_FindIf(psDev, psSetup->wIndex & 0xFF);
+            break;
+        case USBD_FW_RECIP_EP:
+            i = USBD_FW_FindEp(psDev, psSetup->wIndex & 0xFF);
+            if(i != USBD_FW_NO_EP)
+                psFunc = psDev->ppsFunc[psDev->psEp[i].u8Func];
+            break;
+        case USBD_FW_RECIP_DEVICE:
+            for(i = 0; (i < psDev->u32FuncNum) && (psReq == NULL); i++)
+            {
+                psFunc = psDev->ppsFunc[i];
+                psReq = USBD_FW_FindReq(psFunc, psSetup);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if((psFunc != NULL) && (psReq == NULL))
+        psReq = USBD_FW_FindReq(psFunc, psSetup);
+
+    if((psReq == NULL) || (psReq->pfnHandler(psFunc, psSetup) < 0))
+        psDev->psPort->pfnCtrlStall();
+}
+
+/**
+  * @brief      SET_INTERFACE, forwarded to the function owning the interface.
+  */
+void USBD_FW_SetInterface(USBD_FW_DEV_T *psDev, uint32_t u32IfNum, uint32_t u32AltIf)
+{
+    USBD_FW_FUNC_T *psFunc = USBD_FW_FindIf(psDev, u32IfNum);
+
+    if((psFunc != NULL) && (psFunc->psClass->pfnSetInterface != NULL))
+        psFunc->psClass->pfnSetInterface(psFunc, u32IfNum, u32AltIf);
+}
+
+/**
+  * @brief      Send the data stage of a device to host request, at most wLength bytes.
+  */
+void USBD_FW_CtrlIn(USBD_FW_FUNC_T *psFunc, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    USBD_FW_DEV_T *psDev = psFunc->psDev;
+
+    if(u32Len > psDev->sSetup.wLength)
+        u32Len = psDev->sSetup.wLength;
+    psDev->psPort->pfnCtrlIn(pu8Buf, u32Len);
+}
+
+/**
+  * @brief      Receive the data stage of a host to device request into pu8Buf.
+  * @details    pfnCtrlOutDone of the class is called once the data is in,
+  *             from the port interrupt (USBD) or before this returns (HSUSBD).
+  */
+void USBD_FW_CtrlOut(USBD_FW_FUNC_T *psFunc, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    USBD_FW_DEV_T *psDev = psFunc->psDev;
+
+    if(u32Len > psDev->sSetup.wLength)
+        u32Len = psDev->sSetup.wLength;
+    psDev->psCtrlOut = psFunc;
+    psDev->u32CtrlOutLeft = u32Len;
+    psDev->psPort->pfnCtrlOut(pu8Buf, u32Len);
+}
+
+/**
+  * @brief      Complete a request without data stage.
+  */
+void USBD_FW_CtrlAck(USBD_FW_FUNC_T *psFunc)
+{
+    psFunc->psDev->psPort->pfnCtrlAck();
+}
+
+/**
+  * @brief      Called by the port when the control OUT data stage is complete.
+  */
+void USBD_FW_CtrlOutDone(USBD_FW_DEV_T *psDev)
+{
+    USBD_FW_FUNC_T *psFunc = psDev->psCtrlOut;
+
+    psDev->psCtrlOut = NULL;
+    psDev->u32CtrlOutLeft = 0;
+    if((psFunc != NULL) && (psFunc->psClass->pfnCtrlOutDone != NULL))
+        psFunc->psClass->pfnCtrlOutDone(psFunc, &psDev->sSetup);
+}
+
+/**
+  * @brief      Called by the port on an event of hardware endpoint u32HwEp.
+  * @retval     None. Events of endpoints outside the table are dropped.
+  */
+void USBD_FW_EpEvent(USBD_FW_DEV_T *psDev, uint32_t u32HwEp, uint32_t u32IntSts)
+{
+    USBD_FW_FUNC_T *psFunc;
+    uint32_t u32Ep;
+
+    if(u32HwEp >= sizeof(psDev->au8HwMap))
+        return;
+    u32Ep = psDev->au8HwMap[u32HwEp];
+    if(u32Ep == USBD_FW_NO_EP)
+        return;
+
+    psFunc = psDev->ppsFunc[psDev->psEp[u32Ep].u8Func];
+    if(psFunc->psClass->pfnEpEvent != NULL)
+        psFunc->psClass->pfnEpEvent(psFunc, u32Ep, u32IntSts);
+}
+
+/**
+  * @brief      Called by the port after a bus reset, once the endpoints are configured.
+  */
+void USBD_FW_Reset(USBD_FW_DEV_T *psDev)
+{
+    USBD_FW_FUNC_T *psFunc;
+    uint32_t i;
+
+    psDev->psCtrlOut = NULL;
+    psDev->u32CtrlOutLeft = 0;
+    for(i = 0; i < psDev->u32FuncNum; i++)
+    {
+        psFunc = psDev->ppsFunc[i];
+        if(psFunc->psClass->pfnReset != NULL)
+            psFunc->psClass->pfnReset(psFunc);
+    }
+}
+
+/**
+  * @brief      Called by the port on DMA done, every function with a pfnDmaDone sees it.
+  */
+void USBD_FW_DmaDone(USBD_FW_DEV_T *psDev)
+{
+    USBD_FW_FUNC_T *psFunc;
+    uint32_t i;
+
+    for(i = 0; i < psDev->u32FuncNum; i++)
+    {
+        psFunc = psDev->ppsFunc[i];
+        if(psFunc->psClass->pfnDmaDone != NULL)
+            psFunc->psClass->pfnDmaDone(psFunc);
+    }
+}
@@ -0,0 +1,343 @@
+/**************************************************************************//**
+ * @file     usbd_fw_port.c
+ * @version  V1.00
+ * @brief    USB device framework, USBD (full speed) port.
+ *
+ * @details  Usage:
+ *               USBD_Open(&gsInfo, USBD_FW_ClassRequest, USBD_FW_SetInterfaceReq);
+ *               USBD_SetVendorRequest(USBD_FW_ClassRequest);
+ *               USBD_FW_Init(g_asMyEp, USBD_FW_EP_NUM, g_apsMyFunc, n);
+ *           and USBD_IRQHandler() calls USBD_FW_IRQHandler().
+ *
+ *           Classes move packets with USBD_FW_EpBuf()/USBD_FW_EpSubmit(),
+ *           which hide the double buffer: an IN endpoint of depth 2 takes a
+ *           second packet while the first one is on the bus, an OUT endpoint
+ *           of depth 2 receives into the other buffer while the class reads.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "usbd_fw.h"
+
+USBD_FW_DEV_T g_sUsbdFw;
+
+extern uint8_t g_usbd_SetupPacket[];
+
+static void USBD_FW_PortCtrlIn(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    /* Data stage, then status stage */
+    USBD_PrepareCtrlIn((uint8_t *)pu8Buf, u32Len);
+    USBD_PrepareCtrlOut(0, 0);
+}
+
+static void USBD_FW_PortCtrlOut(uint8_t *pu8Buf, uint32_t u32Len)
+{
+    USBD_PrepareCtrlOut(pu8Buf, u32Len);
+
+    /* Status stage */
+    USBD_SET_DATA1(EP0);
+    USBD_SET_PAYLOAD_LEN(EP0, 0);
+}
+
+static void USBD_FW_PortCtrlAck(void)
+{
+    /* Status stage */
+    USBD_SET_DATA1(EP0);
+    USBD_SET_PAYLOAD_LEN(EP0, 0);
+}
+
+static void USBD_FW_PortCtrlStall(void)
+{
+    /* Setup error, stall the device */
+    USBD_SET_EP_STALL(EP0);
+    USBD_SET_EP_STALL(EP1);
+}
+
+static const USBD_FW_PORT_T s_sUsbdFwPort =
+{
+    USBD_FW_PortCtrlIn,
+    USBD_FW_PortCtrlOut,
+    USBD_FW_PortCtrlAck,
+    USBD_FW_PortCtrlStall
+};
+
+/* Hardware endpoint of the buffer the class works on */
+static uint32_t USBD_FW_CurHwEp(uint32_t u32Ep)
+{
+    const USBD_FW_EP_T *psEp = &g_sUsbdFw.psEp[u32Ep];
+    uint32_t u32Bits = (psEp->u8Addr & 0x80) ? g_sUsbdFw.u32DbNext : g_sUsbdFw.u32DbCur;
+
+    return (u32Bits & (1ul << u32Ep)) ? psEp->u8HwEp2 : psEp->u8HwEp;
+}
+
+/**
+  * @brief      Attach the tables and configure the endpoints.
+  * @retval     0   Success.
+  * @retval     -1  The tables do not fit together, see USBD_FW_Bind().
+  */
+int32_t USBD_FW_Init(const USBD_FW_EP_T *psEp, uint32_t u32EpNum,
+                     USBD_FW_FUNC_T *const *ppsFunc, uint32_t u32FuncNum)
+{
+    if(USBD_FW_Bind(&g_sUsbdFw, &s_sUsbdFwPort, psEp, u32EpNum, ppsFunc, u32FuncNum) != 0)
+        return -1;
+
+    USBD_FW_ConfigEp();
+    return 0;
+}
+
+/**
+  * @brief      Configure the control and table endpoints, also after every bus reset.
+  */
+void USBD_FW_ConfigEp(void)
+{
+    const USBD_FW_EP_T *psEp;
+    uint32_t i, u32Cfg, u32Pkt;
+
+    /* SETUP packet at 0, EP0 and EP1 share the control buffer after it */
+    USBD->STBUFSEG = 0;
+    USBD_CONFIG_EP(EP0, USBD_CFG_CSTALL | USBD_CFG_EPMODE_IN | 0);
+    USBD_SET_EP_BUF_ADDR(EP0, 8);
+    USBD_CONFIG_EP(EP1, USBD_CFG_CSTALL | USBD_CFG_EPMODE_OUT | 0);
+    USBD_SET_EP_BUF_ADDR(EP1, 8);
+
+    for(i = 0; i < g_sUsbdFw.u32EpNum; i++)
+    {
+        psEp = &g_sUsbdFw.psEp[i];
+        u32Cfg = ((psEp->u8Addr & 0x80) ? USBD_CFG_EPMODE_IN : USBD_CFG_EPMODE_OUT) | (psEp->u8Addr & 0xFul);
+        if(psEp->u8Type == USBD_FW_EP_ISO)
+            u32Cfg |= USBD_CFG_TYPE_ISO;
+        u32Pkt = psEp->u16Len / psEp->u8Depth;
+
+        if(psEp->u8HwEp2 != USBD_FW_NO_EP)
+        {
+            USBD_CONFIG_EP(psEp->u8HwEp, u32Cfg | USBD_CFG_DB_EN | USBD_CFG_DBTGACTIVE);
+            USBD_CONFIG_EP(psEp->u8HwEp2, u32Cfg | USBD_CFG_DB_EN);
+            USBD_SET_EP_BUF_ADDR(psEp->u8HwEp2, psEp->u16Base + u32Pkt);
+        }
+        else
+        {
+            USBD_CONFIG_EP(psEp->u8HwEp, u32Cfg);
+        }
+        USBD_SET_EP_BUF_ADDR(psEp->u8HwEp, psEp->u16Base);
+
+        /* OUT endpoints are armed right away */
+        if((psEp->u8Addr & 0x80) == 0)
+        {
+            USBD_SET_PAYLOAD_LEN(psEp->u8HwEp, psEp->u16MaxPkt);
+            if(psEp->u8HwEp2 != USBD_FW_NO_EP)
+                USBD_SET_PAYLOAD_LEN(psEp->u8HwEp2, psEp->u16MaxPkt);
+        }
+        g_sUsbdFw.au8InBusy[i] = 0;
+    }
+    g_sUsbdFw.u32DbNext = 0;
+    g_sUsbdFw.u32DbCur = 0;
+}
+
+/**
+  * @brief      Class and vendor request callback for USBD_Open()/USBD_SetVendorRequest().
+  */
+void USBD_FW_ClassRequest(void)
+{
+    uint8_t au8Buf[8];
+
+    USBD_GetSetupPacket(au8Buf);
+    USBD_FW_Setup(&g_sUsbdFw, au8Buf);
+}
+
+/**
+  * @brief      Set interface callback for USBD_Open().
+  */
+void USBD_FW_SetInterfaceReq(uint32_t u32AltInterface)
+{
+    USBD_FW_SetInterface(&g_sUsbdFw, g_usbd_SetupPacket[4], u32AltInterface);
+}
+
+/**
+  * @brief      Packet buffer of endpoint u32Ep in the USBD SRAM.
+  * @details    IN: the buffer to fill for the next USBD_FW_EpSubmit().
+  *             OUT: the buffer holding the packet of the last event.
+  */
+uint8_t *USBD_FW_EpBuf(uint32_t u32Ep)
+{
+    return (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(USBD_FW_CurHwEp(u32Ep)));
+}
+
+/**
+  * @brief      Length of the OUT packet of the last event on endpoint u32Ep.
+  */
+uint32_t USBD_FW_EpRxLen(uint32_t u32Ep)
+{
+    return USBD_GET_PAYLOAD_LEN(USBD_FW_CurHwEp(u32Ep));
+}
+
+/**
+  * @brief      IN buffers of endpoint u32Ep free for USBD_FW_EpSubmit().
+  */
+uint32_t USBD_FW_EpInFree(uint32_t u32Ep)
+{
+    return g_sUsbdFw.psEp[u32Ep].u8Depth - g_sUsbdFw.au8InBusy[u32Ep];
+}
+
+/**
+  * @brief      IN: send the u32Len bytes written to USBD_FW_EpBuf().
+  *             OUT: hand the buffer back, ready for a packet of up to u32Len bytes.
+  */
+void USBD_FW_EpSubmit(uint32_t u32Ep, uint32_t u32Len)
+{
+    const USBD_FW_EP_T *psEp = &g_sUsbdFw.psEp[u32Ep];
+
+    USBD_SET_PAYLOAD_LEN(USBD_FW_CurHwEp(u32Ep), u32Len);
+    if(psEp->u8Addr & 0x80)
+    {
+        g_sUsbdFw.au8InBusy[u32Ep]++;
+        if(psEp->u8HwEp2 != USBD_FW_NO_EP)
+            g_sUsbdFw.u32DbNext ^= (1ul << u32Ep);
+    }
+}
+
+static void USBD_FW_HwEpEvent(uint32_t u32HwEp)
+{
+    const USBD_FW_EP_T *psEp;
+    uint32_t u32Ep = g_sUsbdFw.au8HwMap[u32HwEp];
+
+    if(u32Ep == USBD_FW_NO_EP)
+        return;
+
+    psEp = &g_sUsbdFw.psEp[u32Ep];
+    if(psEp->u8Addr & 0x80)
+    {
+        if(g_sUsbdFw.au8InBusy[u32Ep])
+            g_sUsbdFw.au8InBusy[u32Ep]--;
+    }
+    else if(u32HwEp == psEp->u8HwEp2)
+    {
+        g_sUsbdFw.u32DbCur |= (1ul << u32Ep);
+    }
+    else
+    {
+        g_sUsbdFw.u32DbCur &= ~(1ul << u32Ep);
+    }
+
+    USBD_FW_EpEvent(&g_sUsbdFw, u32HwEp, 0);
+}
+
+/**
+  * @brief      USBD interrupt service, call from USBD_IRQHandler().
+  */
+void USBD_FW_IRQHandler(void)
+{
+    uint32_t u32IntSts = USBD_GET_INT_FLAG();
+    uint32_t u32State = USBD_GET_BUS_STATE();
+    uint32_t u32EpSts, u32Len, i;
+
+//------------------------------------------------------------------
+    if(u32IntSts & USBD_INTSTS_FLDET)
+    {
+        // Floating detect
+        USBD_CLR_INT_FLAG(USBD_INTSTS_FLDET);
+
+        if(USBD_IS_ATTACHED())
+        {
+            /* USB Plug In */
+            USBD_ENABLE_USB();
+        }
+        else
+        {
+            /* USB Un-plug */
+            USBD_DISABLE_USB();
+        }
+    }
+
+//------------------------------------------------------------------
+    if(u32IntSts & USBD_INTSTS_WAKEUP)
+    {
+        /* Clear event flag */
+        USBD_CLR_INT_FLAG(USBD_INTSTS_WAKEUP);
+    }
+
+//------------------------------------------------------------------
+    if(u32IntSts & USBD_INTSTS_BUS)
+    {
+        /* Clear event flag */
+        USBD_CLR_INT_FLAG(USBD_INTSTS_BUS);
+
+        if(u32State & USBD_STATE_USBRST)
+        {
+            /* Bus reset */
+            USBD_ENABLE_USB();
+            USBD_SwReset();
+            USBD_FW_ConfigEp();
+            USBD_FW_Reset(&g_sUsbdFw);
+            g_sUsbdFw.u8Suspend = 0;
+        }
+        if(u32State & USBD_STATE_SUSPEND)
+        {
+            /* Enable USB but disable PHY */
+            g_sUsbdFw.u8Suspend = 1;
+            USBD_DISABLE_PHY();
+        }
+        if(u32State & USBD_STATE_RESUME)
+        {
+            /* Enable USB and enable PHY */
+            USBD_ENABLE_USB();
+            g_sUsbdFw.u8Suspend = 0;
+        }
+    }
+
+//------------------------------------------------------------------
+    if(u32IntSts & USBD_INTSTS_USB)
+    {
+        // USB event
+        if(u32IntSts & USBD_INTSTS_SETUP)
+        {
+            /* Clear event flag */
+            USBD_CLR_INT_FLAG(USBD_INTSTS_SETUP);
+
+            /* Clear the data IN/OUT ready flag of control end-points */
+            USBD_STOP_TRANSACTION(EP0);
+            USBD_STOP_TRANSACTION(EP1);
+
+            USBD_ProcessSetupPacket();
+        }
+
+        if(u32IntSts & USBD_INTSTS_EP0)
+        {
+            /* Clear event flag */
+            USBD_CLR_INT_FLAG(USBD_INTSTS_EP0);
+            // control IN
+            USBD_CtrlIn();
+        }
+
+        if(u32IntSts & USBD_INTSTS_EP1)
+        {
+            /* Clear event flag */
+            USBD_CLR_INT_FLAG(USBD_INTSTS_EP1);
+
+            // control OUT, the class hears about it once the whole data stage is in
+            u32Len = USBD_GET_PAYLOAD_LEN(EP1);
+            USBD_CtrlOut();
+            if(g_sUsbdFw.psCtrlOut != NULL)
+            {
+                g_sUsbdFw.u32CtrlOutLeft -= (u32Len < g_sUsbdFw.u32CtrlOutLeft) ? u32Len : g_sUsbdFw.u32CtrlOutLeft;
+                if(g_sUsbdFw.u32CtrlOutLeft == 0)
+                    USBD_FW_CtrlOutDone(&g_sUsbdFw);
+            }
+        }
+
+        // EP2 ~ EP24, the low twelve also show up in INTSTS
+        u32EpSts = USBD_GET_EP_INT_FLAG() & ~(USBD_EPINTSTS_EP0 | USBD_EPINTSTS_EP1);
+        if(u32EpSts)
+        {
+            USBD_CLR_EP_INT_FLAG(u32EpSts);
+            USBD_CLR_INT_FLAG((u32EpSts & 0xFFFul) << USBD_INTSTS_EPEVT0_Pos);
+
+            for(i = 2; i < USBD_MAX_EP; i++)
+            {
+                if(u32EpSts & (1ul << i))
+                    USBD_FW_HwEpEvent(i);
+            }
+        }
+    }
+}
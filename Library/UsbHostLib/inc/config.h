@@ -40,6 +40,21 @@
                                                unconditionally reclaim iTD/isTD scheduled
                                                in just elapsed EHCI_ISO_RCLM_RANGE ms.    */
 
+//#define ENABLE_EHCI_IRQ_STATS             /* Collect EHCI interrupt duration and call 
+                                               back latency in DWT cycles. Read with 
+                                               usbh_ehci_irq_stats().                     */
+
+#define ENUM_ATTACH_DELAY_MS   100          /* Delay after port reset before the first 
+                                               request to address 0. USB 2.0 requires at 
+                                               least 10 ms reset recovery time.           */
+
+#define ENUM_RESET_DELAY_MS    100          /* Delay after the second port reset before 
+                                               SET ADDRESS.                               */
+
+#define ENUM_SET_ADDR_DELAY_MS 100          /* Delay after SET ADDRESS. USB 2.0 requires 
+                                               at least 2 ms. Other devices can use 
+                                               address 0 during this delay.               */
+
 #define MAX_DESC_BUFF_SIZE     512          /* To hold the configuration descriptor, USB 
                                                core will allocate a buffer with this size
                                                for each connected device. USB core does 
@@ -57,6 +72,7 @@
 #define MAX_ALT_PER_IFACE      8       /*!< maximum number of alternative interfaces per interface    */
 #define MAX_EP_PER_IFACE       6       /*!< maximum number of endpoints per interface                 */
 #define MAX_HUB_DEVICE         8       /*!< Maximum number of hub devices                             */
+#define MAX_ENUM_DEVICE        4       /*!< Maximum number of devices being enumerated concurrently   */
 
 /* Host controller hardware transfer descriptors memory pool. ED/TD/ITD of OHCI and QH/QTD of EHCI
    are all allocated from this pool. Allocated unit size is determined by MEM_POOL_UNIT_SIZE.
@@ -100,7 +100,7 @@ typedef struct qh_t
      */
     qTD_T       *dummy;                     /* point to the inactive dummy qTD            */
     qTD_T       *qtd_list;                  /* currently linked qTD transfers             */
-    qTD_T       *done_list;                 /* currently linked qTD transfers             */
+    struct qh_t *next_active;               /* point to the next QH in active list        */
     struct qh_t *next;                      /* point to the next QH in remove list        */
 }  QH_T;
 
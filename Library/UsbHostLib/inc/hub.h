@@ -114,6 +114,7 @@ DESC_HUB_T;
 /* 4 can support up to 32 port hubs                */
 /* Note!! If modeifed to 4, "uint16_t sc_bitmap"   */
 /*        MUST be changed as "uint32_t sc_bitmap"  */
+/*        and "uint32_t pend_bitmap".              */
 
 typedef struct hub_dev_t
 {
@@ -121,6 +122,7 @@ typedef struct hub_dev_t
     UTR_T      *utr;                   /*!< Interrupt in UTR of this hub          \hideinitializer */
     uint8_t    buff[HUB_STATUS_MAX_BYTE];   /*!< Interrupt in buffer              \hideinitializer */
     uint16_t   sc_bitmap;              /*!< Hub and Port Status Change Bitmap     \hideinitializer */
+    uint16_t   pend_bitmap;            /*!< Connected ports waiting to be enumerated \hideinitializer */
     uint8_t    bNbrPorts;              /*!< Number of ports                       \hideinitializer */
     uint8_t    bPwrOn2PwrGood;         /*!< Hub power on to power good time       \hideinitializer */
     char       pos_id[MAX_HUB_DEVICE+1];   /*!< Hub position identifier           \hideinitializer */
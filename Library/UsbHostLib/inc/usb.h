@@ -333,6 +333,7 @@ typedef struct udev_t
     uint8_t       dev_num;              /*!< device number                         \hideinitializer */
     int8_t        cur_conf;             /*!< Currentll selected configuration      \hideinitializer */
     SPEED_E       speed;                /*!< device speed (low/full/high)          \hideinitializer */
+    uint32_t      enum_time;            /*!< Time spent on enumeration in ms       \hideinitializer */
     /*
      *  The followings are lightweight USB stack internal used .
     */
@@ -452,6 +453,9 @@ extern void disconnect_device(UDEV_T *);
 extern int  usbh_register_driver(UDEV_DRV_T *driver);
 extern EP_INFO_T * usbh_iface_find_ep(IFACE_T *iface, uint8_t ep_addr, uint8_t dir_type);
 extern int  usbh_reset_device(UDEV_T *);
+extern int  usbh_enum_ready(HC_DRV_T *hc_driver);
+extern int  usbh_enum_poll(void);
+extern int  usbh_enum_pending(void);
 
 /*
  *  USB Standard Request functions
@@ -463,6 +467,7 @@ extern int usbh_set_interface(IFACE_T *iface, uint16_t alt_setting);
 extern int usbh_clear_halt(UDEV_T *udev, uint16_t ep_addr);
 
 extern int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t *buff, uint32_t *xfer_len, uint32_t timeout);
+extern int usbh_ctrl_xfer_async(UTR_T *utr, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t *buff);
 extern int usbh_bulk_xfer(UTR_T *utr);
 extern int usbh_int_xfer(UTR_T *utr);
 extern int usbh_iso_xfer(UTR_T *utr);
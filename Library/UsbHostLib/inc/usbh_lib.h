@@ -124,6 +124,18 @@ typedef void (HID_IW_FUNC)(struct usbhid_dev *hdev, uint16_t ep_addr, int status
 struct uac_dev_t;
 typedef int (UAC_CB_FUNC)(struct uac_dev_t *dev, uint8_t *data, int len);    /*!< audio in callback function \hideinitializer */
 
+/*! EHCI interrupt statistics. Cycle counts are CPU cycles measured with DWT CYCCNT.      */
+typedef struct ehci_irq_stats_t
+{
+    uint32_t  irq_cnt;                      /*!< Number of EHCI interrupts handled            */
+    uint32_t  irq_cycles;                   /*!< Total cycles spent in EHCI_IRQHandler        */
+    uint32_t  irq_cycles_max;               /*!< Longest EHCI_IRQHandler execution            */
+    uint32_t  cb_latency_max;               /*!< Longest time from IRQ entry to a UTR call back */
+    uint32_t  qh_scanned;                   /*!< Number of QHs inspected for completion       */
+    uint32_t  qtd_retired;                  /*!< Number of qTDs retired                       */
+    uint32_t  utr_done;                     /*!< Number of UTRs completed                     */
+} EHCI_IRQ_STATS_T;
+
 /*@}*/ /* end of group USBH_EXPORTED_STRUCT */
 
 /** @addtogroup USBH_EXPORTED_FUNCTIONS USB Host Exported Functions
@@ -137,10 +149,12 @@ typedef int (UAC_CB_FUNC)(struct uac_dev_t *dev, uint8_t *data, int len);    /*!
 /*------------------------------------------------------------------*/
 extern void usbh_core_init(void);
 extern int  usbh_pooling_hubs(void);
+extern int  usbh_pooling_hubs_async(void);
 extern void usbh_install_conn_callback(CONN_FUNC *conn_func, CONN_FUNC *disconn_func);
 extern void usbh_suspend(void);
 extern void usbh_resume(void);
 extern struct udev_t * usbh_find_device(char *hub_id, int port);
+extern int  usbh_ehci_irq_stats(EHCI_IRQ_STATS_T *stats, int clear);
 
 /**
  * @brief  A function return current tick count.
@@ -22,6 +22,24 @@ static QH_T   *_H_qh;                       /* head of reclamation list
 static qTD_T  *_ghost_qtd;                  /* used as a terminator qTD                   */
 static QH_T *qh_remove_list;
 
+/*
+ *  Only QHs with linked qTDs are inspected on interrupt. A QH enters the active list when
+ *  a qTD is linked to its empty qtd_list and leaves it once its qtd_list drains.
+ */
+static QH_T   *qh_active_list;              /* QHs having qTDs linked                     */
+static QH_T   *qh_active_tail;              /* the last QH of qh_active_list              */
+static QH_T   *qh_scanning;                 /* QH being scanned by scan_qh()              */
+static qTD_T  *qtd_done_list;               /* retired qTDs waiting for an IAA doorbell   */
+static qTD_T  *qtd_iaa_list;                /* retired qTDs to be freed on the next IAA   */
+
+#ifdef ENABLE_EHCI_IRQ_STATS
+static EHCI_IRQ_STATS_T  _ehci_stats;
+static uint32_t  _ehci_irq_t0;              /* DWT cycle count on EHCI_IRQHandler entry   */
+#define EHCI_STATS_ADD(x, n)    (_ehci_stats.x += (n))
+#else
+#define EHCI_STATS_ADD(x, n)
+#endif
+
 extern ISO_EP_T  *iso_ep_list;              /* list of activated isochronous pipes        */
 extern int ehci_iso_xfer(UTR_T *utr);       /* EHCI isochronous transfer function         */
 extern int ehci_quit_iso_xfer(UTR_T *utr, EP_INFO_T *ep);
@@ -265,6 +283,17 @@ static int  ehci_init(void)
     /*  Initialize asynchronous list                                                      */
     /*------------------------------------------------------------------------------------*/
     qh_remove_list = NULL;
+    qh_active_list = NULL;
+    qh_active_tail = NULL;
+    qh_scanning = NULL;
+    qtd_done_list = NULL;
+    qtd_iaa_list = NULL;
+
+#ifdef ENABLE_EHCI_IRQ_STATS
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;  /* DWT cycle counter for statistics  */
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    memset(&_ehci_stats, 0, sizeof(_ehci_stats));
+#endif
 
     /* Create the QH list head with H-bit 1 */
     _H_qh = alloc_ehci_QH();
@@ -387,6 +416,21 @@ static void move_qh_to_remove_list(QH_T *qh)
     ENABLE_EHCI_IRQ();
 }
 
+static void remove_qh_from_active_list(QH_T *qh, QH_T *qh_prev)
+{
+    if(qh_prev == NULL)
+        qh_active_list = qh->next_active;
+    else
+        qh_prev->next_active = qh->next_active;
+
+    if(qh_active_tail == qh)
+        qh_active_tail = qh_prev;
+    qh->next_active = NULL;
+}
+
+/*
+ *  Must be called with EHCI interrupt disabled or in EHCI interrupt context.
+ */
 static void append_to_qtd_list_of_QH(QH_T *qh, qTD_T *qtd)
 {
     qTD_T  *q;
@@ -394,6 +438,17 @@ static void append_to_qtd_list_of_QH(QH_T *qh, qTD_T *qtd)
     if(qh->qtd_list == NULL)
     {
         qh->qtd_list = qtd;
+
+        /* QH being scanned is still in active list, see scan_active_list()           */
+        if(qh != qh_scanning)
+        {
+            qh->next_active = NULL;         /* add QH to the tail of active list          */
+            if(qh_active_list == NULL)
+                qh_active_list = qh;
+            else
+                qh_active_tail->next_active = qh;
+            qh_active_tail = qh;
+        }
     }
     else
     {
@@ -559,8 +614,10 @@ static int ehci_ctrl_xfer(UTR_T *utr)
     qtd_setup->qh = qh;
     //qtd_setup->utr = utr;
     write_qtd_bptr(qtd_setup, (uint32_t)&utr->setup, 8);
+    DISABLE_EHCI_IRQ();
     append_to_qtd_list_of_QH(qh, qtd_setup);
     qtd_setup->Token = (8 << 16) | QTD_ERR_COUNTER | QTD_PID_SETUP | QTD_STS_ACTIVE;
+    ENABLE_EHCI_IRQ();
 
     /*------------------------------------------------------------------------------------*/
     /* prepare DATA stage qTD                                                             */
@@ -578,8 +635,10 @@ static int ehci_ctrl_xfer(UTR_T *utr)
         qtd_data->qh = qh;
         //qtd_data->utr = utr;
         write_qtd_bptr(qtd_data, (uint32_t)utr->buff, utr->data_len);
+        DISABLE_EHCI_IRQ();
         append_to_qtd_list_of_QH(qh, qtd_data);
         qtd_data->Token = QTD_DT | (utr->data_len << 16) | token;
+        ENABLE_EHCI_IRQ();
     }
     else
     {
@@ -599,8 +658,10 @@ static int ehci_ctrl_xfer(UTR_T *utr)
 
     qtd_status->qh = qh;
     //qtd_status->utr = utr;
+    DISABLE_EHCI_IRQ();
     append_to_qtd_list_of_QH(qh, qtd_status);
     qtd_status->Token = QTD_DT | QTD_IOC | token;
+    ENABLE_EHCI_IRQ();
 
     /*------------------------------------------------------------------------------------*/
     /* Update QH overlay                                                                  */
@@ -624,15 +685,21 @@ static int ehci_ctrl_xfer(UTR_T *utr)
     return 0;
 }
 
+/*
+ *  Bulk transfers are queued behind the dummy qTD of the QH, the same way as interrupt
+ *  transfers. The first qTD of a new UTR is written into the current dummy qTD, which
+ *  the controller already points to, and is activated last. Any number of UTRs may be
+ *  in flight on one endpoint; they complete in submission order.
+ */
 static int ehci_bulk_xfer(UTR_T *utr)
 {
     UDEV_T     *udev;
     EP_INFO_T  *ep = utr->ep;
     QH_T       *qh;
-    qTD_T      *qtd, *qtd_pre;
+    qTD_T      *qtd, *qtd_first, *qtd_next, *dummy_qtd;
     uint32_t   data_len, xfer_len;
     uint8_t    *buff;
-    uint32_t   token;
+    uint32_t   token, first_token;
     int        is_new_qh = 0;
 
     //USB_debug("Bulk XFER =>\n");
@@ -640,106 +707,121 @@ static int ehci_bulk_xfer(UTR_T *utr)
 
     udev = utr->udev;
 
+    dummy_qtd = alloc_ehci_qTD(NULL);       /* the dummy qTD that will end this UTR       */
+    if(dummy_qtd == NULL)
+        return USBH_ERR_MEMORY_OUT;
+
     if(ep->hw_pipe != NULL)
     {
-        qh = (QH_T *)ep->hw_pipe ;
-        if(qh->qtd_list)
-        {
-            return USBH_ERR_EHCI_QH_BUSY;
-        }
+        qh = (QH_T *)ep->hw_pipe;
     }
     else
     {
         qh = alloc_ehci_QH();
-        if(qh == NULL)
+        qtd = alloc_ehci_qTD(NULL);         /* initial dummy qTD of the new QH            */
+        if((qh == NULL) || (qtd == NULL))
+        {
+            if(qh)
+                free_ehci_QH(qh);
+            if(qtd)
+                free_ehci_qTD(qtd);
+            free_ehci_qTD(dummy_qtd);
             return USBH_ERR_MEMORY_OUT;
+        }
         is_new_qh = 1;
         write_qh(udev, ep, qh);
-        ep->hw_pipe = (void *)qh;           /* associate QH with endpoint                 */
+
+        qh->dummy = qtd;
+        qh->OL_Next_qTD = (uint32_t)qtd;
+        qh->OL_Alt_Next_qTD = QTD_LIST_END;
+        qh->OL_Token = (ep->bToggle) ? QTD_DT : 0;     /* !Active & !Halted, keep toggle  */
     }
 
+    if((ep->bEndpointAddress & EP_ADDR_DIR_MASK) == EP_ADDR_DIR_OUT)
+        token = QTD_ERR_COUNTER | QTD_PID_OUT;
+    else
+        token = QTD_ERR_COUNTER | QTD_PID_IN;
+
     /*------------------------------------------------------------------------------------*/
-    /* Prepare qTDs                                                                       */
+    /* Prepare qTDs. The first one is the current dummy of QH.                            */
     /*------------------------------------------------------------------------------------*/
     data_len = utr->data_len;
     buff = utr->buff;
-    qtd_pre = NULL;
+    qtd_first = qh->dummy;
+    qtd = qtd_first;
+    first_token = 0;
 
-    while(data_len > 0)
+    do
     {
-        qtd = alloc_ehci_qTD(utr);
-        if(qtd == NULL)                     /* failed to allocate a qTD                   */
-        {
-            qtd = qh->qtd_list;
-            while(qtd != NULL)
-            {
-                qtd_pre = qtd;
-                qtd = qtd->next;
-                free_ehci_qTD(qtd_pre);
-            }
-            if(is_new_qh)
-            {
-                free_ehci_QH(qh);
-                ep->hw_pipe = NULL;
-            }
-            return USBH_ERR_MEMORY_OUT;
-        }
-
-        if((ep->bEndpointAddress & EP_ADDR_DIR_MASK) == EP_ADDR_DIR_OUT)
-            token = QTD_ERR_COUNTER | QTD_PID_OUT | QTD_STS_ACTIVE;
-        else
-            token = QTD_ERR_COUNTER | QTD_PID_IN | QTD_STS_ACTIVE;
-
         if(data_len > 0x4000)               /* force maximum x'fer length 16K per qTD     */
             xfer_len = 0x4000;
         else
-            xfer_len = data_len;            /* remaining data length < 4K                 */
+            xfer_len = data_len;            /* remaining data length < 16K                */
 
+        qtd->utr = utr;
         qtd->qh = qh;
-        qtd->Next_qTD = (uint32_t)_ghost_qtd;
-        qtd->Alt_Next_qTD = QTD_LIST_END; //(uint32_t)_ghost_qtd;
+        qtd->Alt_Next_qTD = (uint32_t)dummy_qtd;  /* short packet ends this UTR           */
         write_qtd_bptr(qtd, (uint32_t)buff, xfer_len);
-        append_to_qtd_list_of_QH(qh, qtd);
-        qtd->Token = (xfer_len << 16) | token;
 
         buff += xfer_len;                   /* advanced buffer pointer                    */
         data_len -= xfer_len;
 
         if(data_len == 0)                   /* is this the latest qTD?                   */
         {
-            qtd->Token |= QTD_IOC;          /* ask to raise an interrupt on the last qTD  */
-            qtd->Next_qTD = (uint32_t)_ghost_qtd;     /* qTD list end                     */
+            qtd_next = dummy_qtd;
+            token |= QTD_IOC;               /* ask to raise an interrupt on the last qTD  */
+        }
+        else
+        {
+            qtd_next = alloc_ehci_qTD(utr);
+            if(qtd_next == NULL)            /* failed to allocate a qTD                   */
+            {
+                qtd = qtd_first->next;
+                while(qtd != NULL)
+                {
+                    qtd_next = qtd->next;
+                    free_ehci_qTD(qtd);
+                    qtd = qtd_next;
+                }
+                qtd_first->next = NULL;
+                qtd_first->utr = NULL;
+                free_ehci_qTD(dummy_qtd);
+                if(is_new_qh)
+                {
+                    free_ehci_qTD(qh->dummy);
+                    free_ehci_QH(qh);
+                }
+                return USBH_ERR_MEMORY_OUT;
+            }
         }
 
-        if(qtd_pre != NULL)
-            qtd_pre->Next_qTD = (uint32_t)qtd;
-        qtd_pre = qtd;
-    }
-
-    //USB_debug("utr=0x%x, qh=0x%x, qtd=0x%x\n", (int)utr, (int)qh, (int)qh->qtd_list);
+        qtd->Next_qTD = (uint32_t)qtd_next;
+        qtd->next = (qtd_next == dummy_qtd) ? NULL : qtd_next;
 
-    qtd = qh->qtd_list;
+        if(qtd == qtd_first)
+            first_token = (xfer_len << 16) | token | QTD_STS_ACTIVE;
+        else
+            qtd->Token = (xfer_len << 16) | token | QTD_STS_ACTIVE;
 
-//    qh->Curr_qTD = 0; //(uint32_t)qtd;
-    qh->OL_Next_qTD = (uint32_t)qtd;
-//  qh->OL_Alt_Next_qTD = QTD_LIST_END;
+        qtd = qtd_next;
+    }
+    while(data_len > 0);
 
     /*------------------------------------------------------------------------------------*/
-    /* Link QH and start asynchronous transfer                                            */
+    /* Append to QH and activate                                                          */
     /*------------------------------------------------------------------------------------*/
+    DISABLE_EHCI_IRQ();
+    append_to_qtd_list_of_QH(qh, qtd_first);
+    qh->dummy = dummy_qtd;                  /* give the new dummy qTD                     */
+    qtd_first->Token = first_token;         /* hand the whole chain to controller         */
+
     if(is_new_qh)
     {
-        memcpy(&(qh->OL_Bptr[0]), &(qtd->Bptr[0]), 20);
-        qh->Curr_qTD = (uint32_t)qtd;
-
-        qh->OL_Token = 0; //qtd->Token;
-
-        if(utr->ep->bToggle)
-            qh->OL_Token |= QTD_DT;
-
+        ep->hw_pipe = (void *)qh;           /* associate QH with endpoint                 */
         qh->HLink = _H_qh->HLink;
         _H_qh->HLink = QH_HLNK_QH(qh);
     }
+    ENABLE_EHCI_IRQ();
 
     /*  Start transfer */
     _ehci->UCMDR |= HSUSBH_UCMDR_ASEN_Msk;      /* start asynchronous transfer            */
@@ -830,9 +912,13 @@ static int ehci_int_xfer(UTR_T *utr)
 
     qtd->qh = qh;
     qtd->Alt_Next_qTD = QTD_LIST_END;
+    qtd->next = NULL;
     write_qtd_bptr(qtd, (uint32_t)utr->buff, utr->data_len);
+
+    DISABLE_EHCI_IRQ();
     append_to_qtd_list_of_QH(qh, qtd);
     qtd->Token = QTD_IOC | (utr->data_len << 16) | token | QTD_STS_ACTIVE;
+    ENABLE_EHCI_IRQ();
 
     // printf("ehci_int_xfer - qh: 0x%x, 0x%x, 0x%x\n", (int)qh, (int)qh->Chrst, (int)qh->Cap);
 
@@ -912,134 +998,148 @@ static int visit_qtd(qTD_T *qtd)
     return 0;
 }
 
-static void scan_asynchronous_list()
+/*
+ *  Retire the completed qTDs at the head of the qTD list of a QH and call back each UTR
+ *  whose last qTD was retired. The controller executes the qTDs of a QH strictly in list
+ *  order, so the scan stops at the first qTD still owned by the controller and UTRs
+ *  complete in the order they were submitted.
+ */
+static void scan_qh(QH_T *qh)
 {
-    QH_T    *qh, *qh_tmp;
-    qTD_T   *q_pre, *qtd, *qtd_tmp;
+    qTD_T   *qtd;
     UTR_T   *utr;
+    int     is_last;
 
-    qh =  QH_PTR(_H_qh->HLink);
-    while(qh != _H_qh)
+    while((qtd = qh->qtd_list) != NULL)
     {
-        // USB_debug("Scan qh=0x%x, 0x%x\n", (int)qh, qh->OL_Token);
+        if(!visit_qtd(qtd))
+            break;                               /* not completed yet                     */
 
-        utr = NULL;
-        qtd = qh->qtd_list;
-        while(qtd != NULL)
+        utr = qtd->utr;
+        qh->qtd_list = qtd->next;                /* unlink the qTD from qtd_list          */
+        qtd->next = qtd_done_list;               /* push this qTD to done list            */
+        qtd_done_list = qtd;
+        EHCI_STATS_ADD(qtd_retired, 1);
+
+        /*
+         *  On a short packet the controller took the Alt_Next_qTD pointer to the next UTR;
+         *  on an error it halted the QH. Either way the remaining qTDs of this UTR will not
+         *  be executed, retire them too.
+         */
+        if((qtd->Token & (QTD_STS_HALT | QTD_STS_DATA_BUFF_ERR | QTD_STS_BABBLE | QTD_STS_XactErr | QTD_STS_MISS_MF)) ||
+                ((QTD_TODO_LEN(qtd->Token) != 0) && (qtd->Alt_Next_qTD != QTD_LIST_END)))
         {
-            if(visit_qtd(qtd))                   /* if TRUE, reclaim this qtd             */
-            {
-                /* qTD is completed, will remove it      */
-                utr = qtd->utr;
-                if(qtd == qh->qtd_list)
-                    qh->qtd_list = qtd->next;    /* unlink the qTD from qtd_list          */
-                else
-                    q_pre->next = qtd->next;     /* unlink the qTD from qtd_list          */
-
-                qtd_tmp = qtd;                   /* remember this qTD for freeing later   */
-                qtd = qtd->next;                 /* advance to the next qTD               */
-
-                qtd_tmp->next = qh->done_list;   /* push this qTD to QH's done list       */
-                qh->done_list = qtd_tmp;
-            }
-            else
+            while(((qtd = qh->qtd_list) != NULL) && (qtd->utr == utr))
             {
-                q_pre = qtd;                     /* remember this qTD as a preceder       */
-                qtd = qtd->next;                 /* advance to next qTD                   */
+                qtd->Token &= ~QTD_STS_ACTIVE;
+                qh->qtd_list = qtd->next;
+                qtd->next = qtd_done_list;
+                qtd_done_list = qtd;
+                EHCI_STATS_ADD(qtd_retired, 1);
             }
         }
 
-        qh_tmp = qh;
-        qh = QH_PTR(qh->HLink);                  /* advance to the next QH                */
-
-        /* If all TDs are done, call-back to requester and then remove this QH.           */
-        if((qh_tmp->qtd_list == NULL) && utr)
-        {
-            // printf("T %d [%d]\n", (qh_tmp->Chrst>>8)&0xf, (qh_tmp->OL_Token&QTD_DT) ? 1 : 0);
-            if(qh_tmp->OL_Token & QTD_DT)
-                utr->ep->bToggle = 1;
-            else
-                utr->ep->bToggle = 0;
+        is_last = ((qh->qtd_list == NULL) || (qh->qtd_list->utr != utr));
+        if(!is_last)
+            continue;
 
-            utr->bIsTransferDone = 1;
-            if(utr->func)
-                utr->func(utr);
+        /* Data toggle is only meaningful in the overlay when nothing else is queued      */
+        if(qh->qtd_list == NULL)
+            utr->ep->bToggle = (qh->OL_Token & QTD_DT) ? 1 : 0;
 
-            _ehci->UCMDR |= HSUSBH_UCMDR_IAAD_Msk;   /* trigger IAA to reclaim done_list  */
+#ifdef ENABLE_EHCI_IRQ_STATS
+        _ehci_stats.utr_done++;
+        if(DWT->CYCCNT - _ehci_irq_t0 > _ehci_stats.cb_latency_max)
+            _ehci_stats.cb_latency_max = DWT->CYCCNT - _ehci_irq_t0;
+#endif
+        utr->bIsTransferDone = 1;
+        if(utr->func)
+        {
+            TRACE_ENTER(EHCI, TRACE_EHCI_UTR_DONE, utr->xfer_len);
+            utr->func(utr);                      /* may queue the next UTR of this QH     */
+            TRACE_EXIT(EHCI, TRACE_EHCI_UTR_DONE, utr->xfer_len);
         }
     }
 }
 
-static void scan_periodic_frame_list()
+static int is_qh_in_remove_list(QH_T *qh)
 {
-    QH_T    *qh;
-    qTD_T   *qtd, *qNext;
-    UTR_T   *utr;
+    QH_T    *q;
 
-    /*------------------------------------------------------------------------------------*/
-    /* Scan interrupt frame list                                                          */
-    /*------------------------------------------------------------------------------------*/
-    qh =  _Iqh[NUM_IQH - 1];
-    while(qh != NULL)
+    for(q = qh_remove_list; q != NULL; q = q->next)
     {
-        qtd = qh->qtd_list;
-
-        if(qtd == NULL)
-        {
-            /* empty QH                                   */
-            qh = QH_PTR(qh->HLink);         /* advance to the next QH                     */
-            continue;
-        }
-
-        while(qtd != NULL)
-        {
-            qNext = qtd->next;
-
-            if(visit_qtd(qtd))                  /* if TRUE, reclaim this qtd                  */
-            {
-                qh->qtd_list = qtd->next;       /* proceed to next qTD or NULL                */
-                qtd->next = qh->done_list;      /* push qTD into the done list                */
-                qh->done_list = qtd;            /* move qTD to done list                      */
-            }
-            qtd = qNext;
-        }
+        if(q == qh)
+            return 1;
+    }
+    return 0;
+}
 
-        qtd = qh->done_list;
+/*
+ *  Scan the QHs that have qTDs linked, asynchronous and interrupt alike. Cost is in
+ *  proportion to the number of endpoints under transfer plus the completed qTDs, not to
+ *  the number of endpoints in the schedule.
+ */
+static void scan_active_list(void)
+{
+    QH_T    *qh, *qh_prev, *qh_next;
 
-        while(qtd != NULL)
+    qh_prev = NULL;
+    qh = qh_active_list;
+    while(qh != NULL)
+    {
+        /* A QH in remove list is unlinked from hardware and will be aborted on IAA       */
+        if((qh_remove_list == NULL) || !is_qh_in_remove_list(qh))
         {
-            utr = qtd->utr;
-
-            if(qh->OL_Token & QTD_DT)
-                utr->ep->bToggle = 1;
-            else
-                utr->ep->bToggle = 0;
-
-            utr->bIsTransferDone = 1;
-            if(utr->func)
-                utr->func(utr);
-
-            _ehci->UCMDR |= HSUSBH_UCMDR_IAAD_Msk;   /* trigger IAA to reclaim done_list  */
-
-            qtd = qtd->next;
+            qh_scanning = qh;
+            scan_qh(qh);
+            qh_scanning = NULL;
+            EHCI_STATS_ADD(qh_scanned, 1);
         }
 
-        qh = QH_PTR(qh->HLink);                  /* advance to the next QH                */
+        qh_next = qh->next_active;               /* call back may have appended QHs       */
+        if(qh->qtd_list == NULL)
+            remove_qh_from_active_list(qh, qh_prev);
+        else
+            qh_prev = qh;
+        qh = qh_next;
     }
+}
 
-    /*------------------------------------------------------------------------------------*/
-    /* Scan isochronous frame list                                                          */
-    /*------------------------------------------------------------------------------------*/
+/*
+ *  Ring the IAA doorbell for qTDs retired so far. The controller may still hold a
+ *  retired qTD in QH overlay, so qTDs are freed only after an IAA rung after their
+ *  retirement completes. Do nothing if a doorbell is still in progress; iaad_remove_qh()
+ *  rings again.
+ */
+static void ring_iaa_doorbell(void)
+{
+    qTD_T   *qtd;
+
+    if((qtd_done_list == NULL) || (qtd_iaa_list != NULL) || (_ehci->UCMDR & HSUSBH_UCMDR_IAAD_Msk))
+        return;
 
-    scan_isochronous_list();
+    qtd = qtd_done_list;
+    qtd_done_list = NULL;
+    qtd_iaa_list = qtd;
+    _ehci->UCMDR |= HSUSBH_UCMDR_IAAD_Msk;       /* trigger IAA to reclaim qTDs           */
 }
 
 void iaad_remove_qh()
 {
-    QH_T    *qh;
+    QH_T    *qh, *q, *q_prev;
     qTD_T   *qtd;
     UTR_T   *utr;
 
+    /*------------------------------------------------------------------------------------*/
+    /* Free qTDs retired before the IAA doorbell                                          */
+    /*------------------------------------------------------------------------------------*/
+    while(qtd_iaa_list != NULL)
+    {
+        qtd = qtd_iaa_list;
+        qtd_iaa_list = qtd->next;
+        free_ehci_qTD(qtd);
+    }
+
     /*------------------------------------------------------------------------------------*/
     /* Remove all QHs in qh_remove_list...                                                */
     /*------------------------------------------------------------------------------------*/
@@ -1050,65 +1150,52 @@ void iaad_remove_qh()
 
         // USB_debug("iaad_remove_qh - remove QH 0x%x\n", (int)qh);
 
-        while(qh->done_list)                /* we can free the qTDs now                   */
-        {
-            qtd = qh->done_list;
-            qh->done_list = qtd->next;
-            free_ehci_qTD(qtd);
-        }
-
-        if(qh->qtd_list != NULL)            /* still have incomplete qTDs?               */
+        if(qh->qtd_list != NULL)            /* still in active list?                      */
         {
-            utr = qh->qtd_list->utr;
-            while(qh->qtd_list)
+            for(q = qh_active_list, q_prev = NULL; q != NULL; q_prev = q, q = q->next_active)
             {
-                qtd = qh->qtd_list;
-                qh->qtd_list = qtd->next;
-                free_ehci_qTD(qtd);
+                if(q == qh)
+                {
+                    remove_qh_from_active_list(qh, q_prev);
+                    break;
+                }
             }
-            utr->status = USBH_ERR_ABORT;
-            utr->bIsTransferDone = 1;
-            if(utr->func)
-                utr->func(utr);             /* call back                                  */
         }
-        free_ehci_QH(qh);                   /* free the QH                                */
-    }
 
-    /*------------------------------------------------------------------------------------*/
-    /* Free all qTD in done_list of each asynchronous QH                                  */
-    /*------------------------------------------------------------------------------------*/
-    qh =  QH_PTR(_H_qh->HLink);
-    while(qh != _H_qh)
-    {
-        while(qh->done_list)                /* we can free the qTDs now                   */
+        while(qh->qtd_list != NULL)         /* abort all incomplete UTRs, in order       */
         {
-            qtd = qh->done_list;
-            qh->done_list = qtd->next;
+            qtd = qh->qtd_list;
+            utr = qtd->utr;
+            qh->qtd_list = qtd->next;
             free_ehci_qTD(qtd);
-        }
-        qh = QH_PTR(qh->HLink);                  /* advance to the next QH                */
-    }
 
-    /*------------------------------------------------------------------------------------*/
-    /* Free all qTD in done_list of each QH of periodic frame list                        */
-    /*------------------------------------------------------------------------------------*/
-    qh =  _Iqh[NUM_IQH - 1];
-    while(qh != NULL)
-    {
-        while(qh->done_list)                /* we can free the qTDs now                   */
-        {
-            qtd = qh->done_list;
-            qh->done_list = qtd->next;
-            free_ehci_qTD(qtd);
+            if((qh->qtd_list == NULL) || (qh->qtd_list->utr != utr))
+            {
+                utr->status = USBH_ERR_ABORT;
+                utr->bIsTransferDone = 1;
+                if(utr->func)
+                    utr->func(utr);         /* call back                                  */
+            }
         }
-        qh = QH_PTR(qh->HLink);                  /* advance to the next QH                */
+        if(qh->dummy != NULL)
+            free_ehci_qTD(qh->dummy);
+        free_ehci_QH(qh);                   /* free the QH                                */
     }
+
+    ring_iaa_doorbell();                    /* for qTDs retired after the last doorbell   */
 }
 
 //static irqreturn_t ehci_irq (struct usb_hcd *hcd)
 void EHCI_IRQHandler(void)
 {
     uint32_t  intsts;
+#ifdef ENABLE_EHCI_IRQ_STATS
+    uint32_t  cycles;
+
+    _ehci_irq_t0 = DWT->CYCCNT;
+#endif
+
+    TRACE_ENTER(EHCI, TRACE_EHCI_IRQ, 0);
 
     intsts = _ehci->USTSR;
     _ehci->USTSR = intsts;                  /* clear interrupt status                     */
@@ -1120,19 +1207,54 @@ void EHCI_IRQHandler(void)
         // USB_error("Transfer error!\n");
     }
 
-    if(intsts & HSUSBH_USTSR_USBINT_Msk)
+    /* Handle IAA first. qTDs retired below are not covered by this doorbell.           */
+    if(intsts & HSUSBH_USTSR_IAA_Msk)
     {
-        /* some transfers completed, travel asynchronous */
-        /* and periodic lists to find and reclaim them.  */
-        scan_asynchronous_list();
-
-        scan_periodic_frame_list();
+        iaad_remove_qh();
     }
 
-    if(intsts & HSUSBH_USTSR_IAA_Msk)
+    if(intsts & HSUSBH_USTSR_USBINT_Msk)
     {
-        iaad_remove_qh();
+        /* some transfers completed, travel active QHs  */
+        /* and isochronous endpoints to reclaim them.    */
+        scan_active_list();
+
+        scan_isochronous_list();
+
+        ring_iaa_doorbell();
     }
+
+#ifdef ENABLE_EHCI_IRQ_STATS
+    cycles = DWT->CYCCNT - _ehci_irq_t0;
+    _ehci_stats.irq_cnt++;
+    _ehci_stats.irq_cycles += cycles;
+    if(cycles > _ehci_stats.irq_cycles_max)
+        _ehci_stats.irq_cycles_max = cycles;
+#endif
+
+    TRACE_EXIT(EHCI, TRACE_EHCI_IRQ, intsts);
+}
+
+/*
+ *  Read EHCI interrupt statistics. Clear the statistics after read if clear is non-zero.
+ *  Returns USBH_ERR_NOT_SUPPORTED if ENABLE_EHCI_IRQ_STATS is not defined in config.h.
+ */
+int usbh_ehci_irq_stats(EHCI_IRQ_STATS_T *stats, int clear)
+{
+#ifdef ENABLE_EHCI_IRQ_STATS
+    DISABLE_EHCI_IRQ();
+    if(stats != NULL)
+        *stats = _ehci_stats;
+    if(clear)
+        memset(&_ehci_stats, 0, sizeof(_ehci_stats));
+    ENABLE_EHCI_IRQ();
+    return 0;
+#else
+    (void)clear;
+    if(stats != NULL)
+        memset(stats, 0, sizeof(*stats));
+    return USBH_ERR_NOT_SUPPORTED;
+#endif
 }
 
 static UDEV_T * ehci_find_device_by_port(int port)
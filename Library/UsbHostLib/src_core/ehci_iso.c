@@ -186,6 +186,18 @@ static int  review_sitd(siTD_T *sitd)
     return 1;                               /* to be reclaimed                            */
 }
 
+/*
+ *  iTDs/siTDs of an iso endpoint are linked in schedule order. Once one scheduled in a
+ *  future frame is met, the rest are scheduled even later and need not be inspected.
+ */
+static __inline int is_future_frame(uint32_t frnidx)
+{
+    uint32_t   now_frame = (_ehci->UFINDR >> 3) & 0x3FF;
+    uint32_t   ahead = (frnidx + FL_SIZE - now_frame) % FL_SIZE;
+
+    return ((ahead != 0) && (ahead < FL_SIZE / 2));
+}
+
 /*
  *  Some iTD/siTD may be scheduled but not serviced due to time missed.
  *  This function scan several earlier frames and drop unserviced iTD/siTD if found.
@@ -252,6 +264,10 @@ void scan_isochronous_list(void)
                 free_ehci_iTD(itd);
                 itd = p;
             }
+            else if(is_future_frame(itd->sched_frnidx))
+            {
+                break;                      /* the rest are not serviced yet              */
+            }
             else
             {
                 itd_pre = itd;
@@ -310,6 +326,10 @@ void scan_isochronous_list(void)
                 free_ehci_siTD(sitd);
                 sitd = sp;
             }
+            else if(is_future_frame(sitd->sched_frnidx))
+            {
+                break;                       /* the rest are not serviced yet              */
+            }
             else
             {
                 sitd_pre = sitd;
@@ -444,6 +444,17 @@ static int  port_connect_change(HUB_DEV_T *hub, int port, uint16_t wPortStatus)
             disconnect_device(udev);
         }
 
+        /*
+         *  Another device of this bus is still at address 0. Leave the port disabled
+         *  and retry it in hub_polling().
+         */
+        if(!usbh_enum_ready(hub->iface->udev->hc_driver))
+        {
+            hub->pend_bitmap |= (1 << port);
+            return 0;
+        }
+        hub->pend_bitmap &= ~(1 << port);
+
         /*
          * New device connected. Do a port reset first.
          */
@@ -490,6 +501,7 @@ static int  port_connect_change(HUB_DEV_T *hub, int port, uint16_t wPortStatus)
         /*
          *  Device disconnected
          */
+        hub->pend_bitmap &= ~(1 << port);
         udev = usbh_find_device(hub->pos_id, port);
         if(udev != NULL)
         {
@@ -551,6 +563,31 @@ static int  port_status_change(HUB_DEV_T *hub, int port)
     return 0;
 }
 
+/*
+ *  Retry the connected ports which were waiting for address 0 to be free.
+ */
+static void  port_pending_connect(HUB_DEV_T *hub)
+{
+    uint16_t    wPortStatus, wPortChange;
+    int         port;
+
+    for(port = 1; port <= hub->bNbrPorts; port++)
+    {
+        if(!(hub->pend_bitmap & (1 << port)))
+            continue;
+
+        if(!usbh_enum_ready(hub->iface->udev->hc_driver))
+            return;
+
+        if(get_port_status(hub, port, &wPortStatus, &wPortChange) < 0)
+        {
+            USB_error("Failed to get Hub [%s] port %d status!\n", hub->pos_id, port);
+            return;
+        }
+        port_connect_change(hub, port, wPortStatus);
+    }
+}
+
 static  volatile  uint8_t   _hub_polling_mutex = 0;
 
 static int  hub_polling(void)
@@ -566,6 +603,9 @@ static int  hub_polling(void)
 
     for(i = 0; i < MAX_HUB_DEVICE; i++)
     {
+        if((g_hub_dev[i].iface != NULL) && (g_hub_dev[i].pend_bitmap))
+            port_pending_connect(&g_hub_dev[i]);
+
         if((g_hub_dev[i].iface != NULL) && (g_hub_dev[i].sc_bitmap))
         {
             /*
@@ -621,14 +661,15 @@ void usbh_hub_init(void)
 /**
   * @brief    Let USB stack polls all root hubs and downstream hubs. If there's any hub port
   *           change found, USB stack will manage the hub events in this function call.
-  *           In this function, USB stack enumerates newly connected devices and remove staff
-  *           of disconnected devices. User's application should periodically invoke this
-  *           function.
+  *           USB stack starts enumerating newly connected devices and remove staff of
+  *           disconnected devices, then advances the enumeration of all connected devices by
+  *           one step. This function does not wait for enumeration delays, and is suitable
+  *           for an application which has other jobs to do in its main loop.
   * @return   There's hub port change or not.
   * @retval   0   No any hub port status changes found.
-  * @retval   1   There's hub port status changes.
+  * @retval   1   There's hub port status changes, or a device completed enumeration.
   */
-int  usbh_pooling_hubs(void)
+int  usbh_pooling_hubs_async(void)
 {
     int   ret, change = 0;
 
@@ -661,6 +702,34 @@ int  usbh_pooling_hubs(void)
     }
     while(ret == 1);
 
+    if(usbh_enum_poll())
+        change = 1;
+
+    return change;
+}
+
+/**
+  * @brief    Let USB stack polls all root hubs and downstream hubs. If there's any hub port
+  *           change found, USB stack will manage the hub events in this function call.
+  *           In this function, USB stack enumerates newly connected devices and remove staff
+  *           of disconnected devices. User's application should periodically invoke this
+  *           function. Devices found in this call are enumerated concurrently and this
+  *           function returns after all of them have completed enumeration.
+  * @return   There's hub port change or not.
+  * @retval   0   No any hub port status changes found.
+  * @retval   1   There's hub port status changes.
+  */
+int  usbh_pooling_hubs(void)
+{
+    int   change = 0;
+
+    do
+    {
+        if(usbh_pooling_hubs_async())
+            change = 1;
+    }
+    while(usbh_enum_pending());
+
     return change;
 }
 
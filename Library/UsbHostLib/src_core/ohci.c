@@ -344,6 +344,7 @@ static int ohci_ctrl_xfer(UTR_T *utr)
     ED_T    *ed;
     TD_T    *td_setup, *td_data, *td_status;
     uint32_t  info;
+    int     is_new_ed = 0;
 
     udev = utr->udev;
 
@@ -370,6 +371,7 @@ static int ohci_ctrl_xfer(UTR_T *utr)
     /* Check if there's any transfer pending on this endpoint... */
     if(udev->ep0.hw_pipe == NULL)
     {
+        is_new_ed = 1;
         ed = alloc_ohci_ED();
         if(ed == NULL)
         {
@@ -430,10 +432,9 @@ static int ohci_ctrl_xfer(UTR_T *utr)
     /*------------------------------------------------------------------------------------*/
     /* prepare ED                                                                         */
     /*------------------------------------------------------------------------------------*/
-    ed->TailP = 0;
-    ed->HeadP = (uint32_t)td_setup;
     ed->Info = ed_make_info(udev, NULL);
-    ed->NextED = 0;
+    ed->TailP = 0;
+    ed->HeadP = (uint32_t)td_setup;         /* written last, ED may already be in list    */
 
     //TD_debug("TD SETUP [0x%x]: 0x%x, 0x%x, 0x%x, 0x%x\n", (int)td_setup, td_setup->Info, td_setup->CBP, td_setup->BE, td_setup->NextTD);
     //if (td_data)
@@ -453,7 +454,13 @@ static int ohci_ctrl_xfer(UTR_T *utr)
     /*  Start transfer                                                                    */
     /*------------------------------------------------------------------------------------*/
     DISABLE_OHCI_IRQ();
-    _ohci->HcControlHeadED = (uint32_t)ed;                   /* Link ED to OHCI           */
+    if(is_new_ed)
+    {
+        /* Control EDs of all devices stay in the control list until removed, so that     */
+        /* control transfers to different devices can be in progress at the same time.   */
+        ed->NextED = _ohci->HcControlHeadED;
+        _ohci->HcControlHeadED = (uint32_t)ed;               /* Link ED to OHCI           */
+    }
     _ohci->HcControl |= USBH_HcControl_CLE_Msk;              /* enable control list       */
     ENABLE_OHCI_IRQ();
     _ohci->HcCommandStatus = USBH_HcCommandStatus_CLF_Msk;   /* start Control list        */
@@ -461,107 +468,127 @@ static int ohci_ctrl_xfer(UTR_T *utr)
     return 0;
 }
 
+/*
+ *  Bulk TDs are queued behind the dummy TD pointed to by TailP, the same way as interrupt
+ *  transfers, so that more than one UTR can be in flight on an endpoint. The HC stops at
+ *  the dummy TD; moving TailP to the new dummy TD hands the whole TD chain to the HC.
+ */
 static int ohci_bulk_xfer(UTR_T *utr)
 {
     UDEV_T     *udev = utr->udev;
     EP_INFO_T  *ep = utr->ep;
     ED_T       *ed;
-    TD_T       *td, *td_p, *td_list = NULL;
-    uint32_t   info;
+    TD_T       *td, *td_first, *td_next, *td_new;
+    uint32_t   info, td_info;
     uint32_t   data_len, xfer_len;
     int8_t     bIsNewED = 0;
     uint8_t    *buff;
 
+    td_new = alloc_ohci_TD(NULL);           /* allocate a TD for the new dummy TD         */
+    if(td_new == NULL)
+        return USBH_ERR_MEMORY_OUT;
+
     /*------------------------------------------------------------------------------------*/
-    /*  Check if there's uncompleted transfer on this endpoint...                         */
-    /*  Prepare ED                                                                        */
+    /*  Find if this ED was already in the list                                           */
     /*------------------------------------------------------------------------------------*/
     info = ed_make_info(udev, ep);
 
-    /* Check if there's any transfer pending on this endpoint... */
     ed = (ED_T *)_ohci->HcBulkHeadED;       /* get the head of bulk endpoint list         */
     while(ed != NULL)
     {
-        if(ed->Info == info)                /* have transfer of this EP not completed?    */
-        {
-            if((ed->HeadP & 0xFFFFFFF0) != (ed->TailP & 0xFFFFFFF0))
-                return USBH_ERR_OHCI_EP_BUSY;     /* endpoint is busy                     */
-            else
-                break;                      /* ED already there...                        */
-        }
+        if(ed->Info == info)
+            break;                          /* ED already there...                        */
         ed = (ED_T *)ed->NextED;
     }
 
-    if(ed == NULL)
+    if(ed == NULL)                          /* ED not found, create it                    */
     {
         bIsNewED = 1;
         ed = alloc_ohci_ED();               /* allocate an Endpoint Descriptor            */
         if(ed == NULL)
+        {
+            free_ohci_TD(td_new);
             return USBH_ERR_MEMORY_OUT;
+        }
         ed->Info = info;
-        ed->HeadP = 0;
+
+        td = alloc_ohci_TD(NULL);           /* allocate the initial  dummy TD for ED      */
+        if(td == NULL)
+        {
+            free_ohci_ED(ed);
+            free_ohci_TD(td_new);
+            return USBH_ERR_MEMORY_OUT;
+        }
+        ed->HeadP = (uint32_t)td;           /* Let both HeadP and TailP point to dummy TD */
+        ed->TailP = ed->HeadP;
         ED_debug("Link BULK ED 0x%x: 0x%x 0x%x 0x%x 0x%x\n", (int)ed, ed->Info, ed->TailP, ed->HeadP, ed->NextED);
     }
 
-    ep->hw_pipe = (void *)ed;
-
     /*------------------------------------------------------------------------------------*/
-    /*  Prepare TDs                                                                       */
+    /*  Prepare TDs. The first one is the current dummy TD of ED.                         */
     /*------------------------------------------------------------------------------------*/
+    if((ep->bEndpointAddress & EP_ADDR_DIR_MASK) == EP_ADDR_DIR_OUT)
+        info = (TD_CC | TD_R | TD_DP_OUT | TD_TYPE_BULK);
+    else
+        info = (TD_CC | TD_R | TD_DP_IN | TD_TYPE_BULK);
+
+    info &= ~(1 << 25);                     /* Data toggle from ED toggleCarry bit        */
+
     utr->td_cnt = 0;
     data_len = utr->data_len;
     buff = utr->buff;
+    td_first = (TD_T *)(ed->TailP & ~0xf);  /* TailP always point to the dummy TD         */
+    td = td_first;
 
     do
     {
-        if((ep->bEndpointAddress & EP_ADDR_DIR_MASK) == EP_ADDR_DIR_OUT)
-            info = (TD_CC | TD_R | TD_DP_OUT | TD_TYPE_BULK);
-        else
-            info = (TD_CC | TD_R | TD_DP_IN | TD_TYPE_BULK);
-
-        info &= ~(1 << 25);                 /* Data toggle from ED toggleCarry bit        */
-
         if(data_len > 4096)                 /* maximum transfer length is 4K for each TD  */
             xfer_len = 4096;
         else
             xfer_len = data_len;            /* remaining data length < 4K                 */
 
-        td = alloc_ohci_TD(utr);            /* allocate a TD                              */
-        if(td == NULL)
-            goto mem_out;
-        /* fill this TD                               */
-        write_td(td, info, buff, xfer_len);
+        /*
+         *  A short packet in an IN TD other than the last one must not run into the next
+         *  TD, which may belong to the next UTR. Let the HC halt the ED with DataUnderrun
+         *  instead; td_done() will skip the rest of this UTR and restart the ED.
+         */
+        td_info = info;
+        if(((ep->bEndpointAddress & EP_ADDR_DIR_MASK) == EP_ADDR_DIR_IN) && (data_len > xfer_len))
+            td_info &= ~TD_R;
+
+        write_td(td, td_info, buff, xfer_len);
         td->ed = ed;
+        td->utr = utr;
 
         utr->td_cnt++;                      /* increase TD count, for recalim counter     */
 
         buff += xfer_len;                   /* advanced buffer pointer                    */
         data_len -= xfer_len;
 
-        /* chain to end of TD list */
-        if(td_list == NULL)
+        if(data_len == 0)
         {
-            td_list = td;
+            td_next = td_new;               /* the last TD is chained to new dummy TD     */
         }
         else
         {
-            td_p = td_list;
-            while(td_p->NextTD != 0)
-                td_p = (TD_T *)td_p->NextTD;
-            td_p->NextTD = (uint32_t)td;
+            td_next = alloc_ohci_TD(utr);   /* allocate a TD                              */
+            if(td_next == NULL)
+                goto mem_out;
         }
+        td->NextTD = (uint32_t)td_next;
+        td = td_next;
     }
     while(data_len > 0);
 
     /*------------------------------------------------------------------------------------*/
     /*  Start transfer                                                                    */
     /*------------------------------------------------------------------------------------*/
+    ep->hw_pipe = (void *)ed;
     utr->status = 0;
     DISABLE_OHCI_IRQ();
-    ed->HeadP = (ed->HeadP & 0x2) | (uint32_t)td_list;       /* keep toggleCarry bit      */
+    ed->TailP = (uint32_t)td_new;           /* hand the TD chain to HC                    */
     if(bIsNewED)
     {
-        ed->HeadP = (uint32_t)td_list;
         /* Link ED to OHCI Bulk List */
         ed->NextED = _ohci->HcBulkHeadED;
         _ohci->HcBulkHeadED = (uint32_t)ed;
@@ -573,13 +600,21 @@ static int ohci_bulk_xfer(UTR_T *utr)
     return 0;
 
 mem_out:
-    while(td_list != NULL)
+    td = (TD_T *)td_first->NextTD;
+    while(td != NULL)
     {
-        td = td_list;
-        td_list = (TD_T *)td_list->NextTD;
+        td_next = (TD_T *)td->NextTD;
         free_ohci_TD(td);
+        td = td_next;
+    }
+    td_first->NextTD = 0;
+    td_first->utr = NULL;
+    free_ohci_TD(td_new);
+    if(bIsNewED)
+    {
+        free_ohci_TD(td_first);
+        free_ohci_ED(ed);
     }
-    free_ohci_ED(ed);
     return USBH_ERR_MEMORY_OUT;
 }
 
@@ -595,7 +630,7 @@ static int ohci_int_xfer(UTR_T *utr)
     if(utr->data_len > 64)              /* USB 1.1 interrupt transfer maximum packet size is 64 */
         return USBH_ERR_INVALID_PARAM;
 
-    td_new = alloc_ohci_TD(utr);        /* allocate a TD for dummy TD                     */
+    td_new = alloc_ohci_TD(NULL);       /* allocate a TD for dummy TD                     */
     if(td_new == NULL)
         return USBH_ERR_MEMORY_OUT;
 
@@ -868,6 +903,10 @@ static int ohci_rh_polling(void)
         if((_ohci->HcRhPortStatus[i] & USBH_HcRhPortStatus_CSC_Msk) == 0)
             continue;
 
+        /* The other port has a device at address 0. Keep CSC and check it again later.  */
+        if((_ohci->HcRhPortStatus[i] & USBH_HcRhPortStatus_CCS_Msk) && !usbh_enum_ready(&ohci_driver))
+            continue;
+
         /*--------------------------------------------------------------------------------*/
         /*  connect status change                                                         */
         /*--------------------------------------------------------------------------------*/
@@ -1004,6 +1043,27 @@ void td_done(TD_T *td)
                     utr->xfer_len += td->CBP - td->buff_start;
                 break;
         }
+
+        /*
+         *  Short packet in a bulk IN TD with TD_R cleared. The HC has halted the ED at the
+         *  next TD of this UTR. Skip the rest TDs of this UTR and restart the ED.
+         */
+        if(((info & TD_TYPE_Msk) == TD_TYPE_BULK) && (cc == CC_DATA_UNDERRUN) && !(info & TD_R))
+        {
+            ED_T    *ed = td->ed;
+            TD_T    *td_p, *td_n;
+
+            td_p = (TD_T *)(ed->HeadP & TD_ADDR_MASK);
+            while((td_p != (TD_T *)(ed->TailP & TD_ADDR_MASK)) && (td_p->utr == utr))
+            {
+                td_n = (TD_T *)td_p->NextTD;
+                free_ohci_TD(td_p);
+                utr->td_cnt--;
+                td_p = td_n;
+            }
+            ed->HeadP = (ed->HeadP & 0x2) | (uint32_t)td_p;  /* keep toggleCarry, clear Halt */
+            _ohci->HcCommandStatus = USBH_HcCommandStatus_BLF_Msk;
+        }
     }
 
 td_out:
@@ -1119,6 +1179,9 @@ static void remove_ed()
                     free_ohci_TD(td);
                     td = td_next;
 
+                    if(utr == NULL)         /* the dummy TD                               */
+                        continue;
+
                     utr->td_cnt--;
                     if(utr->td_cnt == 0)
                     {
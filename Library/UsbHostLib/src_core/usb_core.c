@@ -217,6 +217,45 @@ int  usbh_register_driver(UDEV_DRV_T *udrv)
     return USBH_ERR_MEMORY_OUT;        /* reached MAX_UDEV_DRIVER limitation, aborted */
 }
 
+/**
+  * @brief    Issue an USB request in control transfer. This function will return immediately after
+  *           issued the control transfer. USB stack will later set utr->bIsTransferDone and call
+  *           back utr->func(), if not NULL, once the control transfer was done or aborted. The
+  *           call back is invoked in interrupt context.
+  * @param[in]  utr             The control transfer request. utr->udev must be the target device.
+  *                             utr->func and utr->context are left for caller to set.
+  * @param[in]  bmRequestType   Characteristics of request
+  * @param[in]  bRequest        Specific request
+  * @param[in]  wValue          Word-sized field that varies according to request
+  * @param[in]  wIndex          Word-sized field that varies according to request
+  * @param[in]  wLength         Number of bytes to transfer if there is a Data stage
+  * @param[in]  buff            Data buffer used in data stage
+  * @retval   0     Transfer issued. Result will be in utr->status and utr->xfer_len.
+  * @retval   < 0   Failed. Refer to error code definitions.
+  */
+int usbh_ctrl_xfer_async(UTR_T *utr, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                         uint16_t wIndex, uint16_t wLength, uint8_t *buff)
+{
+    UDEV_T     *udev = utr->udev;
+    int        status;
+
+    utr->setup.bmRequestType = bmRequestType;
+    utr->setup.bRequest   = bRequest;
+    utr->setup.wValue     = wValue;
+    utr->setup.wIndex     = wIndex;
+    utr->setup.wLength    = wLength;
+
+    utr->buff = buff;
+    utr->data_len = wLength;
+    utr->xfer_len = 0;
+    utr->status = 0;
+    utr->bIsTransferDone = 0;
+    status = udev->hc_driver->ctrl_xfer(utr);
+    if(status < 0)
+        udev->ep0.hw_pipe = NULL;
+    return status;
+}
+
 /**
   * @brief    Execute an USB request in control transfer. This function returns after the request
   *           was done or aborted.
@@ -227,7 +266,6 @@ int  usbh_register_driver(UDEV_DRV_T *udrv)
   * @param[in]  wIndex          Word-sized field that varies according to request
   * @param[in]  wLength         Number of bytes to transfer if there is a Data stage
   * @param[in]  buff            Data buffer used in data stage
-  * @param[in]  data_len        Length of data to be transmitted/received
   * @param[out] xfer_len        Transmitted/received length of data
   * @param[in]  timeout         Time-out limit (in 10ms - timer tick) of this transfer
   * @retval   0     Transfer success
@@ -249,19 +287,9 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
     if(utr == NULL)
         return USBH_ERR_MEMORY_OUT;
 
-    utr->setup.bmRequestType = bmRequestType;
-    utr->setup.bRequest   = bRequest;
-    utr->setup.wValue     = wValue;
-    utr->setup.wIndex     = wIndex;
-    utr->setup.wLength    = wLength;
-
-    utr->buff = buff;
-    utr->data_len = wLength;
-    utr->bIsTransferDone = 0;
-    status = udev->hc_driver->ctrl_xfer(utr);
+    status = usbh_ctrl_xfer_async(utr, bmRequestType, bRequest, wValue, wIndex, wLength, buff);
     if(status < 0)
     {
-        udev->ep0.hw_pipe = NULL;
         free_utr(utr);
         return status;
     }
@@ -932,124 +960,375 @@ void print_usb_string(char *lead, uint8_t *str)
     USB_debug("\n");
 }
 
-int  connect_device(UDEV_T *udev)
+/*----------------------------------------------------------------------------------------*/
+/*  Device enumeration engine                                                             */
+/*                                                                                        */
+/*  A newly connected device is enumerated by a state machine advanced from               */
+/*  usbh_enum_poll(). Control transfers are issued with usbh_ctrl_xfer_async() and delays */
+/*  are timed with get_ticks(), so several devices can be enumerated at the same time.    */
+/*  Only one device per host controller can be at address 0, so hub ports wait for        */
+/*  usbh_enum_ready() before being reset.                                                 */
+/*----------------------------------------------------------------------------------------*/
+
+enum
 {
-    DESC_CONF_T  *conf;
-    uint32_t     read_len;
-    int          ret;
-
-    USB_debug("Connect device =>\n");
-
-    delay_us(100 * 1000);                   /* initially, give 100 ms delay               */
-
-    usbh_get_device_descriptor(udev, &udev->descriptor);
+    ENUM_ST_IDLE = 0,                       /* free slot                                  */
+    ENUM_ST_ATTACH,                         /* wait after port reset                      */
+    ENUM_ST_GET_DESC0,                      /* GET DESCRIPTOR at address 0                */
+    ENUM_ST_RESET,                          /* wait after the second port reset           */
+    ENUM_ST_SET_ADDR,                       /* SET ADDRESS                                */
+    ENUM_ST_ADDRESSED,                      /* wait after SET ADDRESS                     */
+    ENUM_ST_GET_DESC,                       /* GET DESCRIPTOR (device)                    */
+    ENUM_ST_GET_CONF_HDR,                   /* GET DESCRIPTOR (configuration, 9 bytes)    */
+    ENUM_ST_GET_CONF,                       /* GET DESCRIPTOR (configuration, total)      */
+    ENUM_ST_SET_CONF,                       /* SET CONFIGURATION                          */
+    ENUM_ST_WAKEUP                          /* SET FEATURE (remote wakeup)                */
+};
+
+typedef struct
+{
+    UDEV_T      *udev;                      /* device being enumerated, NULL if free      */
+    UTR_T       *utr;                       /* control transfer in progress               */
+    uint8_t     state;                      /* ENUM_ST_*                                  */
+    uint8_t     retry;                      /* GET DESCRIPTOR retry count                 */
+    uint8_t     dev_num;                    /* address to be assigned                     */
+    uint32_t    t_start;                    /* tick when enumeration started              */
+    uint32_t    t0;                         /* tick when delay or transfer started        */
+    uint32_t    timeout;                    /* delay or transfer time-out in ticks        */
+} ENUM_DEV_T;
+
+static ENUM_DEV_T  _enum_dev[MAX_ENUM_DEVICE];
+static volatile uint8_t  _enum_polling_mutex = 0;
+
+static int enum_delay(ENUM_DEV_T *e, int state, int ms)
+{
+    e->state = state;
+    e->t0 = get_ticks();
+    e->timeout = ms / 10;                   /* get_ticks() counts in 10 ms                */
+    return 0;
+}
 
-    reset_device(udev);
+static int enum_ctrl(ENUM_DEV_T *e, int state, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                     uint16_t wLength, uint8_t *buff, uint32_t timeout)
+{
+    int   ret;
 
-    delay_us(100 * 1000);
+    e->state = state;
+    e->utr = alloc_utr(e->udev);
+    if(e->utr == NULL)
+        return USBH_ERR_MEMORY_OUT;
 
-    ret = usbh_set_address(udev);
+    ret = usbh_ctrl_xfer_async(e->utr, bmRequestType, bRequest, wValue, 0, wLength, buff);
     if(ret < 0)
     {
-        USB_debug("Set address command failed!!\n");
+        free_utr(e->utr);
+        e->utr = NULL;
         return ret;
     }
+    e->t0 = get_ticks();
+    e->timeout = timeout;
+    return 0;
+}
 
-    delay_us(100 * 1000);                   /* after set address, give 100 ms delay       */
+static int enum_get_device_descriptor(ENUM_DEV_T *e, int state, uint32_t timeout)
+{
+    return enum_ctrl(e, state, REQ_TYPE_IN | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
+                     USB_REQ_GET_DESCRIPTOR, ((USB_DT_STANDARD | USB_DT_DEVICE) << 8),
+                     sizeof(DESC_DEV_T), (uint8_t *)&e->udev->descriptor, timeout);
+}
 
-    USB_debug("New %s device address %d assigned.\n", (udev->speed == SPEED_HIGH) ? "high-speed" : ((udev->speed == SPEED_FULL) ? "full-speed" : "low-speed"), udev->dev_num);
+static int enum_get_config_descriptor(ENUM_DEV_T *e, int state, uint16_t len)
+{
+    return enum_ctrl(e, state, REQ_TYPE_IN | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
+                     USB_REQ_GET_DESCRIPTOR, ((USB_DT_STANDARD | USB_DT_CONFIGURATION) << 8),
+                     len, e->udev->cfd_buff, 200);
+}
 
-    /* Get device descriptor again with new device address */
-    ret = usbh_get_device_descriptor(udev, &udev->descriptor);
-    if(ret < 0)
+/*
+ *  The current state of <e> has completed with <status>, which is the control transfer
+ *  result or 0 for an elapsed delay. Start the next step.
+ *  Return 1 if enumeration done, 0 if next step started, or < 0 if failed.
+ */
+static int enum_step(ENUM_DEV_T *e, int status)
+{
+    UDEV_T       *udev = e->udev;
+    DESC_CONF_T  *conf = (DESC_CONF_T *)udev->cfd_buff;
+    int          ret;
+
+    switch(e->state)
     {
-        free_dev_address(udev->dev_num);
+    case ENUM_ST_ATTACH:
+        return enum_get_device_descriptor(e, ENUM_ST_GET_DESC0, 10);
+
+    case ENUM_ST_GET_DESC0:
+        /* Result ignored. This request only lets device report its ep0 packet size.    */
+        reset_device(udev);
+        return enum_delay(e, ENUM_ST_RESET, ENUM_RESET_DELAY_MS);
+
+    case ENUM_ST_RESET:
+        e->dev_num = alloc_dev_address();
+        ret = enum_ctrl(e, ENUM_ST_SET_ADDR, REQ_TYPE_OUT | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
+                        USB_REQ_SET_ADDRESS, e->dev_num, 0, NULL, 100);
+        if(ret < 0)
+            free_dev_address(e->dev_num);   /* not submitted, udev->dev_num is still 0    */
         return ret;
-    }
+
+    case ENUM_ST_SET_ADDR:
+        if(status < 0)
+        {
+            USB_debug("Set address command failed!!\n");
+            free_dev_address(e->dev_num);
+            return status;
+        }
+        udev->dev_num = e->dev_num;         /* address 0 is free for other devices now    */
+
+        USB_debug("New %s device address %d assigned.\n", (udev->speed == SPEED_HIGH) ? "high-speed" : ((udev->speed == SPEED_FULL) ? "full-speed" : "low-speed"), udev->dev_num);
+
+        return enum_delay(e, ENUM_ST_ADDRESSED, ENUM_SET_ADDR_DELAY_MS);
+
+    case ENUM_ST_ADDRESSED:
+        e->retry = 0;
+        return enum_get_device_descriptor(e, ENUM_ST_GET_DESC, 10);
+
+    case ENUM_ST_GET_DESC:
+        if(status < 0)
+        {
+            USB_debug("Get device descriptor failed - %d, retry!\n", status);
+            if(++e->retry < 3)
+                return enum_get_device_descriptor(e, ENUM_ST_GET_DESC, 10);
+            return status;
+        }
 
 #if  defined(DUMP_DESCRIPTOR) && defined(ENABLE_DEBUG_MSG)
-    dump_device_descriptor(&udev->descriptor);
+        dump_device_descriptor(&udev->descriptor);
 #endif
 
-    if(udev->descriptor.bNumConfigurations != 1)
-    {
-        USB_debug("Warning! This device has multiple configurations [%d]. \n", udev->descriptor.bNumConfigurations);
-    }
+        if(udev->descriptor.bNumConfigurations != 1)
+        {
+            USB_debug("Warning! This device has multiple configurations [%d]. \n", udev->descriptor.bNumConfigurations);
+        }
 
-    conf = (DESC_CONF_T *)usbh_alloc_mem(MAX_DESC_BUFF_SIZE);
-    if(conf == NULL)
-    {
-        free_dev_address(udev->dev_num);
-        return USBH_ERR_MEMORY_OUT;
-    }
+        udev->cfd_buff = (uint8_t *)usbh_alloc_mem(MAX_DESC_BUFF_SIZE);
+        if(udev->cfd_buff == NULL)
+            return USBH_ERR_MEMORY_OUT;
 
-    udev->cfd_buff = (uint8_t *)conf;
+        return enum_get_config_descriptor(e, ENUM_ST_GET_CONF_HDR, 9);
 
-    /* Get configuration descriptor again with new device address */
-    ret = usbh_get_config_descriptor(udev, (uint8_t *)conf, MAX_DESC_BUFF_SIZE);
-    if(ret < 0)
-    {
-        free_dev_address(udev->dev_num);
-        return ret;
-    }
+    case ENUM_ST_GET_CONF_HDR:
+        if(status < 0)
+            return status;
+
+        if(conf->wTotalLength > MAX_DESC_BUFF_SIZE)
+        {
+            USB_error("Device configuration %d length > %d!\n", conf->wTotalLength, MAX_DESC_BUFF_SIZE);
+            return USBH_ERR_DATA_OVERRUN;
+        }
+        return enum_get_config_descriptor(e, ENUM_ST_GET_CONF, conf->wTotalLength);
+
+    case ENUM_ST_GET_CONF:
+        if(status < 0)
+            return status;
 
 #if  defined(DUMP_DESCRIPTOR) && defined(ENABLE_DEBUG_MSG)
-    dump_config_descriptor(conf);
+        dump_config_descriptor(conf);
 #endif
 
-#if 0  /* printf string descriptors, for debug only */
-    str_buff = (uint8_t *)usbh_alloc_mem(MAX_DESC_BUFF_SIZE);
-    if(udev->descriptor.iManufacturer != 0)
-    {
-        usbh_get_string_descriptor(udev, udev->descriptor.iManufacturer, str_buff, MAX_DESC_BUFF_SIZE);
-        print_usb_string("Manufactor: ", str_buff);
-    }
-    if(udev->descriptor.iProduct != 0)
-    {
-        usbh_get_string_descriptor(udev, udev->descriptor.iProduct, str_buff, MAX_DESC_BUFF_SIZE);
-        print_usb_string("Product: ", str_buff);
+        /* Always select the first configuration */
+        return enum_ctrl(e, ENUM_ST_SET_CONF, REQ_TYPE_OUT | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
+                         USB_REQ_SET_CONFIGURATION, conf->bConfigurationValue, 0, NULL, 300);
+
+    case ENUM_ST_SET_CONF:
+        if(status < 0)
+        {
+            USB_debug("Set configuration %d failed!\n", conf->bConfigurationValue);
+            return status;
+        }
+        udev->cur_conf = (int8_t)conf->bConfigurationValue;
+
+        /* Parse the configuration/interface/endpoint descriptors and find corresponding drivers. */
+        ret = usbh_parse_configuration(udev, (uint8_t *)conf);
+        if(ret < 0)
+        {
+            USB_debug("Parse configuration %d failed!\n", conf->bConfigurationValue);
+            return ret;
+        }
+
+        if((conf->bmAttributes & (1 << 5)) == 0)
+            return 1;
+
+        /* If this configuration supports remote wakeup, enable it.                           */
+        return enum_ctrl(e, ENUM_ST_WAKEUP, REQ_TYPE_OUT | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
+                         USB_REQ_SET_FEATURE, 0x01, 0, NULL, 300);
+
+    case ENUM_ST_WAKEUP:
+        if(status < 0)
+        {
+            USB_debug("Device does not accept remote wakeup enable command.\n");
+        }
+        return 1;
+
+    default:
+        return USBH_ERR_INVALID_PARAM;
     }
-    if(udev->descriptor.iSerialNumber != 0)
+}
+
+static void enum_stop_xfer(ENUM_DEV_T *e)
+{
+    if(e->utr == NULL)
+        return;
+
+    usbh_quit_utr(e->utr);
+    free_utr(e->utr);
+    e->utr = NULL;
+    e->udev->ep0.hw_pipe = NULL;
+}
+
+static ENUM_DEV_T * enum_find(UDEV_T *udev)
+{
+    int   i;
+
+    for(i = 0; i < MAX_ENUM_DEVICE; i++)
     {
-        usbh_get_string_descriptor(udev, udev->descriptor.iSerialNumber, str_buff, MAX_DESC_BUFF_SIZE);
-        print_usb_string("Serial Number: ", str_buff);
+        if(_enum_dev[i].udev == udev)
+            return &_enum_dev[i];
     }
-    usbh_free_mem(str_buff, MAX_DESC_BUFF_SIZE);
-#endif
+    return NULL;
+}
 
-    /* Always select the first configuration */
-    ret = usbh_set_configuration(udev, conf->bConfigurationValue);
-    if(ret < 0)
+/*
+ *  Can a newly connected device under <hc_driver> be reset and enumerated now?
+ *  Return 0 if another device of this bus is still at address 0 or no free slot.
+ */
+int  usbh_enum_ready(HC_DRV_T *hc_driver)
+{
+    int   i;
+
+    if(enum_find(NULL) == NULL)
+        return 0;
+
+    for(i = 0; i < MAX_ENUM_DEVICE; i++)
     {
-        USB_debug("Set configuration %d failed!\n", conf->bConfigurationValue);
-        free_dev_address(udev->dev_num);
-        return ret;
+        if((_enum_dev[i].udev != NULL) && (_enum_dev[i].udev->hc_driver == hc_driver) &&
+                (_enum_dev[i].udev->dev_num == 0))
+            return 0;
     }
+    return 1;
+}
 
-    /* Parse the configuration/interface/endpoint descriptors and find corresponding drivers. */
-    ret = usbh_parse_configuration(udev, (uint8_t *)conf);
-    if(ret < 0)
+/*
+ *  Number of devices being enumerated. Return 0 if called from inside usbh_enum_poll(),
+ *  for example, by a driver probe, so that a caller waiting on it does not dead lock.
+ */
+int  usbh_enum_pending(void)
+{
+    int   i, cnt = 0;
+
+    if(_enum_polling_mutex)
+        return 0;
+
+    for(i = 0; i < MAX_ENUM_DEVICE; i++)
     {
-        USB_debug("Parse configuration %d failed!\n", conf->bConfigurationValue);
-        free_dev_address(udev->dev_num);
-        return ret;
+        if(_enum_dev[i].udev != NULL)
+            cnt++;
     }
+    return cnt;
+}
 
-    if(conf->bmAttributes & (1 << 5))
+/*
+ *  Advance all devices being enumerated.
+ *  Return 1 if any device finished enumeration (either success or failed).
+ */
+int  usbh_enum_poll(void)
+{
+    ENUM_DEV_T   *e;
+    UDEV_T       *udev;
+    int          i, ret, change = 0;
+
+    if(_enum_polling_mutex)
+        return 0;
+
+    _enum_polling_mutex = 1;
+
+    for(i = 0; i < MAX_ENUM_DEVICE; i++)
     {
-        /* If this configuration supports remote wakeup, enable it.                           */
-        if(usbh_ctrl_xfer(udev, REQ_TYPE_OUT | REQ_TYPE_STD_DEV | REQ_TYPE_TO_DEV,
-                          USB_REQ_SET_FEATURE, 0x01, 0x0000, 0x0000,
-                          NULL, &read_len, 300) < 0)
+        e = &_enum_dev[i];
+        udev = e->udev;
+        if(udev == NULL)
+            continue;
+
+        if(e->utr != NULL)
         {
-            USB_debug("Device does not accept remote wakeup enable command.\n");
+            if(e->utr->bIsTransferDone)
+            {
+                ret = e->utr->status;
+                free_utr(e->utr);
+                e->utr = NULL;
+            }
+            else if(get_ticks() - e->t0 > e->timeout)
+            {
+                enum_stop_xfer(e);
+                ret = USBH_ERR_TIMEOUT;
+            }
+            else
+                continue;                   /* transfer in progress                       */
+        }
+        else
+        {
+            if(get_ticks() - e->t0 <= e->timeout)
+                continue;                   /* delay not elapsed                          */
+            ret = 0;
         }
+
+        ret = enum_step(e, ret);
+        if(ret == 0)
+            continue;
+
+        /*--------------------------------------------------------------------------------*/
+        /*  Enumeration finished                                                          */
+        /*--------------------------------------------------------------------------------*/
+        enum_stop_xfer(e);
+        e->udev = NULL;
+        change = 1;
+
+        if(ret < 0)
+        {
+            USB_error("connect_device error! [%d]\n", ret);
+            usbh_quit_xfer(udev, &(udev->ep0));
+            free_dev_address(udev->dev_num);
+            free_device(udev);
+            continue;
+        }
+
+        udev->enum_time = (get_ticks() - e->t_start) * 10;
+        USB_debug("Device address %d enumerated in %d ms.\n", udev->dev_num, udev->enum_time);
+
+        if(g_conn_func)
+            g_conn_func(udev, 0);
     }
+    _enum_polling_mutex = 0;
+    return change;
+}
 
-    if(g_conn_func)
-        g_conn_func(udev, 0);
+/*
+ *  Start enumerating a device whose port has just been reset. The device must be at
+ *  address 0 and usbh_enum_ready() must have returned 1 before the port reset.
+ *  Enumeration continues in usbh_enum_poll(). If failed, the device will be freed there.
+ */
+int  connect_device(UDEV_T *udev)
+{
+    ENUM_DEV_T   *e;
 
-    return ret;
+    USB_debug("Connect device =>\n");
+
+    e = enum_find(NULL);
+    if(e == NULL)
+        return USBH_ERR_MEMORY_OUT;
+
+    memset(e, 0, sizeof(*e));
+    e->udev = udev;
+    e->t_start = get_ticks();
+    enum_delay(e, ENUM_ST_ATTACH, ENUM_ATTACH_DELAY_MS);
+    return 0;
 }
 
 int  usbh_reset_device(UDEV_T *udev)
@@ -1159,10 +1438,20 @@ int  usbh_reset_device(UDEV_T *udev)
 void disconnect_device(UDEV_T *udev)
 {
     IFACE_T      *iface;
+    ENUM_DEV_T   *e;
 
     USB_debug("disconnect device...\n");
 
-    if(g_disconn_func)
+    e = enum_find(udev);
+    if(e != NULL)
+    {
+        /* Device removed before enumeration completed. It was never reported connected. */
+        enum_stop_xfer(e);
+        if(e->state == ENUM_ST_SET_ADDR)
+            free_dev_address(e->dev_num);
+        e->udev = NULL;
+    }
+    else if(g_disconn_func)
         g_disconn_func(udev, 0);
 
     usbh_quit_xfer(udev, &(udev->ep0));    /* Quit control transfer if hw_pipe is not NULL.  */
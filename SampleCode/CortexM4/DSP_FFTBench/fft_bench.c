@@ -0,0 +1,542 @@
+/**************************************************************************//**
+ * @file     fft_bench.c
+ * @version  V1.00
+ * @brief    Time every CMSIS-DSP FFT variant over 64 to 4096 points and measure
+ *           its accuracy against a double-precision reference.
+ *
+ * @details  Each transform is fed the same test signal (three tones plus
+ *           uniform noise, peak below 0.6 so no fixed-point input saturates).
+ *           The SNR compares the output with a double-precision FFT of that
+ *           input, after a least-squares gain match that removes the 1/N style
+ *           output scaling of the q15/q31 transforms. Fixed-point SNR therefore
+ *           includes input quantization and internal downscaling noise, which
+ *           is what an application sees.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <math.h>
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#include "fft_bench.h"
+
+#define FFTB_SIZE_CNT       7       /* 64, 128, ..., 4096 */
+#define FFTB_PI             3.14159265358979323846
+
+/* Radix-8 kernel and bit reversal used by arm_cfft_f32(), not declared in arm_math.h */
+extern void arm_radix8_butterfly_f32(float32_t *pSrc, uint16_t fftLen, const float32_t *pCoef, uint16_t twidCoefModifier);
+extern void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable);
+
+typedef enum
+{
+    eFFTB_F32,
+    eFFTB_Q31,
+    eFFTB_Q15
+} E_FFTB_TYPE;
+
+typedef enum
+{
+    eFFTB_CPLX_INPLACE,     /* N complex bins, in place in s_uBuf */
+    eFFTB_REAL_FULL,        /* complex bins 0..N/2 at the start of s_uOut */
+    eFFTB_REAL_PACKED       /* arm_rfft_fast_f32 layout: DC and Nyquist real parts first */
+} E_FFTB_LAYOUT;
+
+typedef struct
+{
+    const char *pcName;
+    E_FFTB_TYPE eType;
+    E_FFTB_LAYOUT eLayout;
+    int32_t (*pfnInit)(uint32_t u32Len);    /* returns -1 if the length is not supported */
+    void (*pfnRun)(void);
+} FFTB_VARIANT_T;
+
+/* Work buffers, sized for the largest complex transform and the 2N-word rfft outputs */
+static union
+{
+    float32_t af32[FFTB_MAX_LEN * 2];
+    q31_t aq31[FFTB_MAX_LEN * 2];
+    q15_t aq15[FFTB_MAX_LEN * 2];
+} s_uBuf, s_uOut;
+
+static float32_t s_af32In[FFTB_MAX_LEN * 2];    /* test signal, interleaved re/im */
+static double s_adRef[FFTB_MAX_LEN * 2];        /* reference spectrum */
+static uint32_t s_u32RefLen, s_u32RefReal;
+
+/* Transform instances, one live at a time */
+static union
+{
+    arm_cfft_radix2_instance_f32 sRadix2F32;
+    arm_cfft_radix4_instance_f32 sRadix4F32;
+    arm_cfft_radix2_instance_q31 sRadix2Q31;
+    arm_cfft_radix4_instance_q31 sRadix4Q31;
+    arm_cfft_radix2_instance_q15 sRadix2Q15;
+    arm_cfft_radix4_instance_q15 sRadix4Q15;
+    arm_rfft_fast_instance_f32 sRfftFastF32;
+    arm_rfft_instance_q31 sRfftQ31;
+    arm_rfft_instance_q15 sRfftQ15;
+    struct
+    {
+        arm_rfft_instance_f32 sRfft;
+        arm_cfft_radix4_instance_f32 sCfft;
+    } sRfftF32;
+} s_uInst;
+
+static const arm_cfft_instance_f32 *s_psCfftF32;
+static const arm_cfft_instance_q31 *s_psCfftQ31;
+static const arm_cfft_instance_q15 *s_psCfftQ15;
+static uint32_t s_u32Len;
+
+static uint32_t s_au32Ticks[16][FFTB_SIZE_CNT];
+static float s_afSnr[16][FFTB_SIZE_CNT];
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Variant init/run wrappers                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+static int32_t CfftConstInit(uint32_t u32Len)
+{
+    switch (u32Len)
+    {
+        case 64:
+            s_psCfftF32 = &arm_cfft_sR_f32_len64;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len64;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len64;
+            break;
+
+        case 128:
+            s_psCfftF32 = &arm_cfft_sR_f32_len128;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len128;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len128;
+            break;
+
+        case 256:
+            s_psCfftF32 = &arm_cfft_sR_f32_len256;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len256;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len256;
+            break;
+
+        case 512:
+            s_psCfftF32 = &arm_cfft_sR_f32_len512;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len512;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len512;
+            break;
+
+        case 1024:
+            s_psCfftF32 = &arm_cfft_sR_f32_len1024;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len1024;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len1024;
+            break;
+
+        case 2048:
+            s_psCfftF32 = &arm_cfft_sR_f32_len2048;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len2048;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len2048;
+            break;
+
+        case 4096:
+            s_psCfftF32 = &arm_cfft_sR_f32_len4096;
+            s_psCfftQ31 = &arm_cfft_sR_q31_len4096;
+            s_psCfftQ15 = &arm_cfft_sR_q15_len4096;
+            break;
+
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+static int32_t Radix8Init(uint32_t u32Len)
+{
+    /* the bare radix-8 kernel only handles powers of 8 */
+    if ((u32Len != 64) && (u32Len != 512) && (u32Len != 4096))
+        return -1;
+
+    return CfftConstInit(u32Len);
+}
+
+static int32_t Radix2F32Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix2_init_f32(&s_uInst.sRadix2F32, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t Radix4F32Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix4_init_f32(&s_uInst.sRadix4F32, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t RfftF32Init(uint32_t u32Len)
+{
+    return (arm_rfft_init_f32(&s_uInst.sRfftF32.sRfft, &s_uInst.sRfftF32.sCfft, u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t RfftFastF32Init(uint32_t u32Len)
+{
+    return (arm_rfft_fast_init_f32(&s_uInst.sRfftFastF32, (uint16_t)u32Len) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t Radix2Q31Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix2_init_q31(&s_uInst.sRadix2Q31, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t Radix4Q31Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix4_init_q31(&s_uInst.sRadix4Q31, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t RfftQ31Init(uint32_t u32Len)
+{
+    return (arm_rfft_init_q31(&s_uInst.sRfftQ31, u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t Radix2Q15Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix2_init_q15(&s_uInst.sRadix2Q15, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t Radix4Q15Init(uint32_t u32Len)
+{
+    return (arm_cfft_radix4_init_q15(&s_uInst.sRadix4Q15, (uint16_t)u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static int32_t RfftQ15Init(uint32_t u32Len)
+{
+    return (arm_rfft_init_q15(&s_uInst.sRfftQ15, u32Len, 0, 1) == ARM_MATH_SUCCESS) ? 0 : -1;
+}
+
+static void Radix2F32Run(void)
+{
+    arm_cfft_radix2_f32(&s_uInst.sRadix2F32, s_uBuf.af32);
+}
+
+static void Radix4F32Run(void)
+{
+    arm_cfft_radix4_f32(&s_uInst.sRadix4F32, s_uBuf.af32);
+}
+
+static void Radix8F32Run(void)
+{
+    arm_radix8_butterfly_f32(s_uBuf.af32, (uint16_t)s_u32Len, s_psCfftF32->pTwiddle, 1);
+    arm_bitreversal_32((uint32_t *)s_uBuf.af32, s_psCfftF32->bitRevLength, s_psCfftF32->pBitRevTable);
+}
+
+static void CfftF32Run(void)
+{
+    arm_cfft_f32(s_psCfftF32, s_uBuf.af32, 0, 1);
+}
+
+static void RfftF32Run(void)
+{
+    arm_rfft_f32(&s_uInst.sRfftF32.sRfft, s_uBuf.af32, s_uOut.af32);
+}
+
+static void RfftFastF32Run(void)
+{
+    arm_rfft_fast_f32(&s_uInst.sRfftFastF32, s_uBuf.af32, s_uOut.af32, 0);
+}
+
+static void Radix2Q31Run(void)
+{
+    arm_cfft_radix2_q31(&s_uInst.sRadix2Q31, s_uBuf.aq31);
+}
+
+static void Radix4Q31Run(void)
+{
+    arm_cfft_radix4_q31(&s_uInst.sRadix4Q31, s_uBuf.aq31);
+}
+
+static void CfftQ31Run(void)
+{
+    arm_cfft_q31(s_psCfftQ31, s_uBuf.aq31, 0, 1);
+}
+
+static void RfftQ31Run(void)
+{
+    arm_rfft_q31(&s_uInst.sRfftQ31, s_uBuf.aq31, s_uOut.aq31);
+}
+
+static void Radix2Q15Run(void)
+{
+    arm_cfft_radix2_q15(&s_uInst.sRadix2Q15, s_uBuf.aq15);
+}
+
+static void Radix4Q15Run(void)
+{
+    arm_cfft_radix4_q15(&s_uInst.sRadix4Q15, s_uBuf.aq15);
+}
+
+static void CfftQ15Run(void)
+{
+    arm_cfft_q15(s_psCfftQ15, s_uBuf.aq15, 0, 1);
+}
+
+static void RfftQ15Run(void)
+{
+    arm_rfft_q15(&s_uInst.sRfftQ15, s_uBuf.aq15, s_uOut.aq15);
+}
+
+static const FFTB_VARIANT_T s_asVariant[] =
+{
+    {"arm_cfft_radix2_f32",  eFFTB_F32, eFFTB_CPLX_INPLACE, Radix2F32Init,   Radix2F32Run},
+    {"arm_cfft_radix4_f32",  eFFTB_F32, eFFTB_CPLX_INPLACE, Radix4F32Init,   Radix4F32Run},
+    {"arm_radix8_f32",       eFFTB_F32, eFFTB_CPLX_INPLACE, Radix8Init,      Radix8F32Run},
+    {"arm_cfft_f32",         eFFTB_F32, eFFTB_CPLX_INPLACE, CfftConstInit,   CfftF32Run},
+    {"arm_cfft_radix2_q31",  eFFTB_Q31, eFFTB_CPLX_INPLACE, Radix2Q31Init,   Radix2Q31Run},
+    {"arm_cfft_radix4_q31",  eFFTB_Q31, eFFTB_CPLX_INPLACE, Radix4Q31Init,   Radix4Q31Run},
+    {"arm_cfft_q31",         eFFTB_Q31, eFFTB_CPLX_INPLACE, CfftConstInit,   CfftQ31Run},
+    {"arm_cfft_radix2_q15",  eFFTB_Q15, eFFTB_CPLX_INPLACE, Radix2Q15Init,   Radix2Q15Run},
+    {"arm_cfft_radix4_q15",  eFFTB_Q15, eFFTB_CPLX_INPLACE, Radix4Q15Init,   Radix4Q15Run},
+    {"arm_cfft_q15",         eFFTB_Q15, eFFTB_CPLX_INPLACE, CfftConstInit,   CfftQ15Run},
+    {"arm_rfft_f32",         eFFTB_F32, eFFTB_REAL_FULL,    RfftF32Init,     RfftF32Run},
+    {"arm_rfft_fast_f32",    eFFTB_F32, eFFTB_REAL_PACKED,  RfftFastF32Init, RfftFastF32Run},
+    {"arm_rfft_q31",         eFFTB_Q31, eFFTB_REAL_FULL,    RfftQ31Init,     RfftQ31Run},
+    {"arm_rfft_q15",         eFFTB_Q15, eFFTB_REAL_FULL,    RfftQ15Init,     RfftQ15Run},
+};
+
+#define FFTB_VARIANT_CNT    (sizeof(s_asVariant) / sizeof(s_asVariant[0]))
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Test signal and double-precision reference                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+static void MakeSignal(uint32_t u32Len)
+{
+    uint32_t i, u32Seed = 12345;
+    double dPhase;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        dPhase = 2.0 * FFTB_PI * (double)i / (double)u32Len;
+
+        u32Seed = u32Seed * 1664525u + 1013904223u;
+        s_af32In[2 * i] = (float32_t)(0.25 * sin(dPhase * 5.0) + 0.15 * cos(dPhase * (double)(u32Len / 8) + 0.3)
+                                      + 0.05 * ((double)(u32Seed >> 8) / 16777216.0 - 0.5));
+        u32Seed = u32Seed * 1664525u + 1013904223u;
+        s_af32In[2 * i + 1] = (float32_t)(0.2 * sin(dPhase * (double)(u32Len / 3) + 1.1)
+                                          + 0.05 * ((double)(u32Seed >> 8) / 16777216.0 - 0.5));
+    }
+}
+
+/* Iterative radix-2 FFT in double precision on s_adRef */
+static void MakeReference(uint32_t u32Len, uint32_t u32Real)
+{
+    uint32_t i, j, k, u32Half, u32Bit;
+    double dRe, dIm, dWr, dWi, dTr, dTi;
+
+    if ((s_u32RefLen == u32Len) && (s_u32RefReal == u32Real))
+        return;
+
+    /* real transforms take only the real part of the test signal */
+    for (i = 0, j = 0; i < u32Len; i++)
+    {
+        s_adRef[2 * j] = (double)s_af32In[2 * i];
+        s_adRef[2 * j + 1] = u32Real ? 0.0 : (double)s_af32In[2 * i + 1];
+
+        for (u32Bit = u32Len >> 1; j & u32Bit; u32Bit >>= 1)
+            j ^= u32Bit;
+
+        j |= u32Bit;
+    }
+
+    for (u32Half = 1; u32Half < u32Len; u32Half <<= 1)
+    {
+        for (k = 0; k < u32Half; k++)
+        {
+            dWr = cos(-FFTB_PI * (double)k / (double)u32Half);
+            dWi = sin(-FFTB_PI * (double)k / (double)u32Half);
+
+            for (i = k; i < u32Len; i += 2 * u32Half)
+            {
+                j = i + u32Half;
+                dTr = dWr * s_adRef[2 * j] - dWi * s_adRef[2 * j + 1];
+                dTi = dWr * s_adRef[2 * j + 1] + dWi * s_adRef[2 * j];
+                dRe = s_adRef[2 * i];
+                dIm = s_adRef[2 * i + 1];
+                s_adRef[2 * i] = dRe + dTr;
+                s_adRef[2 * i + 1] = dIm + dTi;
+                s_adRef[2 * j] = dRe - dTr;
+                s_adRef[2 * j + 1] = dIm - dTi;
+            }
+        }
+    }
+
+    s_u32RefLen = u32Len;
+    s_u32RefReal = u32Real;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Format conversion                                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+static void LoadInput(const FFTB_VARIANT_T *psVar, uint32_t u32Len)
+{
+    uint32_t i, u32Cnt, u32Step;
+
+    /* complex transforms take interleaved re/im, real transforms only the re part */
+    u32Cnt = (psVar->eLayout == eFFTB_CPLX_INPLACE) ? (2 * u32Len) : u32Len;
+    u32Step = (psVar->eLayout == eFFTB_CPLX_INPLACE) ? 1 : 2;
+
+    for (i = 0; i < u32Cnt; i++)
+    {
+        float32_t f32Val = s_af32In[i * u32Step];
+
+        if (psVar->eType == eFFTB_F32)
+            s_uBuf.af32[i] = f32Val;
+        else if (psVar->eType == eFFTB_Q31)
+            s_uBuf.aq31[i] = (q31_t)lrint((double)f32Val * 2147483648.0);
+        else
+            s_uBuf.aq15[i] = (q15_t)lrint((double)f32Val * 32768.0);
+    }
+}
+
+static double ReadWord(const FFTB_VARIANT_T *psVar, const void *pvBuf, uint32_t u32Idx)
+{
+    if (psVar->eType == eFFTB_F32)
+        return (double)((const float32_t *)pvBuf)[u32Idx];
+    else if (psVar->eType == eFFTB_Q31)
+        return (double)((const q31_t *)pvBuf)[u32Idx] / 2147483648.0;
+    else
+        return (double)((const q15_t *)pvBuf)[u32Idx] / 32768.0;
+}
+
+static void ReadBin(const FFTB_VARIANT_T *psVar, uint32_t u32Len, uint32_t u32Bin, double *pdRe, double *pdIm)
+{
+    if (psVar->eLayout == eFFTB_CPLX_INPLACE)
+    {
+        *pdRe = ReadWord(psVar, &s_uBuf, 2 * u32Bin);
+        *pdIm = ReadWord(psVar, &s_uBuf, 2 * u32Bin + 1);
+    }
+    else if ((psVar->eLayout == eFFTB_REAL_PACKED) && ((u32Bin == 0) || (u32Bin == u32Len / 2)))
+    {
+        *pdRe = ReadWord(psVar, &s_uOut, (u32Bin == 0) ? 0 : 1);
+        *pdIm = 0.0;
+    }
+    else
+    {
+        *pdRe = ReadWord(psVar, &s_uOut, 2 * u32Bin);
+        *pdIm = ReadWord(psVar, &s_uOut, 2 * u32Bin + 1);
+    }
+}
+
+/* SNR in dB of the output against s_adRef after a least-squares gain match */
+static float CalcSnr(const FFTB_VARIANT_T *psVar, uint32_t u32Len)
+{
+    uint32_t k, u32Bins;
+    double dRe, dIm, dCross = 0.0, dOutPwr = 0.0, dRefPwr = 0.0, dErrPwr = 0.0, dGain;
+
+    u32Bins = (psVar->eLayout == eFFTB_CPLX_INPLACE) ? u32Len : (u32Len / 2 + 1);
+
+    for (k = 0; k < u32Bins; k++)
+    {
+        ReadBin(psVar, u32Len, k, &dRe, &dIm);
+        dCross += dRe * s_adRef[2 * k] + dIm * s_adRef[2 * k + 1];
+        dOutPwr += dRe * dRe + dIm * dIm;
+        dRefPwr += s_adRef[2 * k] * s_adRef[2 * k] + s_adRef[2 * k + 1] * s_adRef[2 * k + 1];
+    }
+
+    if (dOutPwr == 0.0)
+        return 0.0f;
+
+    dGain = dCross / dOutPwr;
+
+    for (k = 0; k < u32Bins; k++)
+    {
+        ReadBin(psVar, u32Len, k, &dRe, &dIm);
+        dRe = s_adRef[2 * k] - dGain * dRe;
+        dIm = s_adRef[2 * k + 1] - dGain * dIm;
+        dErrPwr += dRe * dRe + dIm * dIm;
+    }
+
+    if (dErrPwr == 0.0)
+        return 999.9f;
+
+    return (float)(10.0 * log10(dRefPwr / dErrPwr));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Report                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void PrintTable(const char *pcTitle, uint32_t u32Snr)
+{
+    uint32_t v, s;
+
+    printf("\n%s\n", pcTitle);
+    printf("%-22s", "transform");
+
+    for (s = 0; s < FFTB_SIZE_CNT; s++)
+        printf("%9u", FFTB_MIN_LEN << s);
+
+    printf("\n");
+
+    for (v = 0; v < FFTB_VARIANT_CNT; v++)
+    {
+        printf("%-22s", s_asVariant[v].pcName);
+
+        for (s = 0; s < FFTB_SIZE_CNT; s++)
+        {
+            if (s_au32Ticks[v][s] == 0)
+                printf("%9s", "-");
+            else if (u32Snr)
+                printf("%9.1f", (double)s_afSnr[v][s]);
+            else
+                printf("%9u", s_au32Ticks[v][s]);
+        }
+
+        printf("\n");
+    }
+}
+
+/**
+  * @brief      Run all FFT variants over all lengths and print the results
+  * @param[in]  u32Repeat   Number of timed runs per variant and length; the fastest is reported
+  * @param[in]  pcTickUnit  Name of the FFTB_GetTicks() unit for the table title
+  * @return     None
+  * @details    Input loading and instance init are outside the timed region, so
+  *             the figures are the transform call alone. Unsupported lengths are
+  *             shown as "-".
+  */
+void FFTB_Run(uint32_t u32Repeat, const char *pcTickUnit)
+{
+    const FFTB_VARIANT_T *psVar;
+    uint32_t v, s, r, u32Len, u32Start, u32Ticks, u32Best;
+    char acTitle[64];
+
+    for (s = 0; s < FFTB_SIZE_CNT; s++)
+    {
+        u32Len = FFTB_MIN_LEN << s;
+        s_u32Len = u32Len;
+        MakeSignal(u32Len);
+        s_u32RefLen = 0;
+
+        for (v = 0; v < FFTB_VARIANT_CNT; v++)
+        {
+            psVar = &s_asVariant[v];
+            s_au32Ticks[v][s] = 0;
+
+            if (psVar->pfnInit(u32Len) != 0)
+                continue;
+
+            u32Best = 0xFFFFFFFFul;
+
+            for (r = 0; r < u32Repeat; r++)
+            {
+                LoadInput(psVar, u32Len);
+                u32Start = FFTB_GetTicks();
+                psVar->pfnRun();
+                u32Ticks = FFTB_GetTicks() - u32Start;
+
+                if (u32Ticks < u32Best)
+                    u32Best = u32Ticks;
+            }
+
+            /* a zero reading would print as "unsupported" */
+            s_au32Ticks[v][s] = u32Best ? u32Best : 1;
+
+            MakeReference(u32Len, (psVar->eLayout != eFFTB_CPLX_INPLACE));
+            s_afSnr[v][s] = CalcSnr(psVar, u32Len);
+        }
+    }
+
+    snprintf(acTitle, sizeof(acTitle), "Execution time (%s, best of %u)", pcTickUnit, u32Repeat);
+    PrintTable(acTitle, 0);
+    PrintTable("SNR versus double-precision FFT (dB)", 1);
+}
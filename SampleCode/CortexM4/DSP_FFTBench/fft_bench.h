@@ -0,0 +1,36 @@
+/**************************************************************************//**
+ * @file     fft_bench.h
+ * @version  V1.00
+ * @brief    CMSIS-DSP FFT benchmark shared by the M4 and host builds.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __FFT_BENCH_H__
+#define __FFT_BENCH_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define FFTB_MIN_LEN        64      /*!< Smallest benchmarked transform length */
+#define FFTB_MAX_LEN        4096    /*!< Largest benchmarked transform length */
+
+/**
+  * @brief      Read the free-running benchmark counter
+  * @return     Current counter value. Only differences are used, so it may wrap.
+  * @details    Provided by the platform main: DWT cycle counter on the M4,
+  *             monotonic nanoseconds on the host.
+  */
+uint32_t FFTB_GetTicks(void);
+
+void FFTB_Run(uint32_t u32Repeat, const char *pcTickUnit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FFT_BENCH_H__ */
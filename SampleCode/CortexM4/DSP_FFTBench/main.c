@@ -0,0 +1,95 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Benchmark the CMSIS-DSP FFT variants on the Cortex-M4: cycle count
+ *           and SNR versus a double-precision reference for 64 to 4096 points.
+ *
+ * @details  The same benchmark builds on a Linux host, see
+ *           SampleCode/HostSim/DSP_FFTBench.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+#include "fft_bench.h"
+
+#define BENCH_REPEAT        3
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Set XT1_OUT(PF.2) and XT1_IN(PF.3) to input mode */
+    PF->MODE &= ~(GPIO_MODE_MODE2_Msk | GPIO_MODE_MODE3_Msk);
+
+    /* Enable External XTAL (4~24 MHz) */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Waiting for 12MHz clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Set both PCLK0 and PCLK1 as HCLK/2 */
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+
+    /* Set core clock as PLL_CLOCK from PLL */
+    CLK_SetCoreClock(FREQ_200MHZ);
+
+    /* Enable IP clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select IP clock source */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT, CLK_CLKDIV0_UART0(1));
+
+    /* Update System Core Clock */
+    /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock. */
+    SystemCoreClockUpdate();
+
+
+    /* Set GPB multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+}
+
+void UART_Init()
+{
+    UART_Open(UART0, 115200);
+}
+
+uint32_t FFTB_GetTicks(void)
+{
+    return DWT->CYCCNT;
+}
+
+int main()
+{
+    SYS_Init();
+    UART_Init();
+
+    printf("\n\n");
+    printf("+----------------------------------------+\n");
+    printf("|      DSP FFT Benchmark Sample Code     |\n");
+    printf("+----------------------------------------+\n");
+    printf("CPU @ %u Hz\n", SystemCoreClock);
+
+    /* Enable the DWT cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    FFTB_Run(BENCH_REPEAT, "cycles");
+
+    printf("\nDone.\n");
+
+    while(1);
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,286 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Stream four EADC channels through PDMA ping-pong buffers into the
+ *           multichannel filter engine and report the CPU load per stage.
+ *
+ * @details  TIMER0 triggers sample modules 0~3 (EADC0_CH0~CH3, PB.0~PB.3) at
+ *           16 kHz. Every conversion raises a PDMA request; PDMA0 channel 2
+ *           reads EADC0->CURDAT into an interleaved ping-pong buffer using two
+ *           scatter-gather descriptors that point at each other. Each filled
+ *           half is decimated by 4, band-passed and low-passed per channel.
+ *
+ *           The same engine is checked on a PC in SampleCode/HostSim/DSP_StreamFilter.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+#include "stream_filter.h"
+
+#define ADC_CHANNELS        4
+#define SAMPLE_RATE         16000
+#define BLOCK_SIZE          256
+#define DECIM_FACTOR        4
+#define DECIM_TAPS          32
+#define FIR_TAPS            31
+#define PDMA_CH             2
+
+static SFLT_T s_sFlt;
+static q15_t s_ai16Decim[DECIM_TAPS];
+static float32_t s_af32Biquad[2 * 5];
+static float32_t s_af32Fir[FIR_TAPS];
+
+/* Interleaved ping-pong buffer written by PDMA */
+static q15_t s_ai16PingPong[2][ADC_CHANNELS * BLOCK_SIZE] __ALIGNED(4);
+static DSCT_T s_asDesc[2] __ALIGNED(4);
+
+static volatile uint32_t s_u32FilledCnt = 0;     /* halves completed by PDMA */
+static volatile uint32_t s_u32Overrun = 0;
+
+void SYS_Init(void);
+void UART0_Init(void);
+void PDMA0_IRQHandler(void);
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* PDMA interrupt handler: one half of the ping-pong buffer is full                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+void PDMA0_IRQHandler(void)
+{
+    if (PDMA_GET_TD_STS(PDMA0) & (1 << PDMA_CH))
+    {
+        PDMA_CLR_TD_FLAG(PDMA0, (1 << PDMA_CH));
+        s_u32FilledCnt++;
+    }
+}
+
+void SYS_Init(void)
+{
+    /* Set PF multi-function pins for XT1_OUT(PF.2) and XT1_IN(PF.3) */
+    SET_XT1_OUT_PF2();
+    SET_XT1_IN_PF3();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable GPIO B clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPBCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable EADC0 module clock */
+    CLK_EnableModuleClock(EADC0_MODULE);
+
+    /* Set EADC0 clock divider as 12 */
+    CLK_SetModuleClock(EADC0_MODULE, CLK_CLKSEL0_EADC0SEL_PLL_DIV2, CLK_CLKDIV0_EADC0(12));
+
+    /* Enable Timer 0 module clock */
+    CLK_EnableModuleClock(TMR0_MODULE);
+
+    /* Select timer 0 module clock source as HXT */
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HXT, 0);
+
+    /* Enable PDMA0 clock source */
+    CLK_EnableModuleClock(PDMA0_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Set multi-function pins for EADC0 channels. */
+    SET_EADC0_CH0_PB0();
+    SET_EADC0_CH1_PB1();
+    SET_EADC0_CH2_PB2();
+    SET_EADC0_CH3_PB3();
+
+    /* Disable digital input path of EADC analog pin to prevent leakage */
+    GPIO_DISABLE_DIGITAL_PATH(PB, BIT3 | BIT2 | BIT1 | BIT0);
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+static uint32_t GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* PDMA0 channel 2: EADC0->CURDAT to the ping-pong buffer, descriptors 0 and 1 chained in a ring           */
+/*---------------------------------------------------------------------------------------------------------*/
+static void PDMA_PingPongInit(void)
+{
+    uint32_t i, u32Ctl;
+
+    SYS_ResetModule(PDMA0_RST);
+
+    PDMA_Open(PDMA0, 1 << PDMA_CH);
+
+    /* EADC requests must use single transfer type */
+    u32Ctl = ((ADC_CHANNELS * BLOCK_SIZE - 1) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_WIDTH_16 | PDMA_SAR_FIX | PDMA_DAR_INC |
+             PDMA_REQ_SINGLE | PDMA_BURST_1 | PDMA_TBINTDIS_ENABLE | PDMA_OP_SCATTER;
+
+    for (i = 0; i < 2; i++)
+    {
+        s_asDesc[i].CTL = u32Ctl;
+        s_asDesc[i].SA = (uint32_t)&EADC0->CURDAT;
+        s_asDesc[i].DA = (uint32_t)s_ai16PingPong[i];
+        s_asDesc[i].NEXT = (uint32_t)&s_asDesc[i ^ 1] - PDMA0->SCATBA;
+    }
+
+    PDMA_SetTransferMode(PDMA0, PDMA_CH, PDMA_EADC0_RX, TRUE, (uint32_t)&s_asDesc[0]);
+
+    PDMA_EnableInt(PDMA0, PDMA_CH, PDMA_INT_TRANS_DONE);
+    NVIC_EnableIRQ(PDMA0_IRQn);
+}
+
+static int32_t EADC_StreamInit(void)
+{
+    uint32_t u32Module;
+
+    if (EADC_Open(EADC0, EADC_CTL_DIFFEN_SINGLE_END) != 0)
+        return -1;
+
+    /* Sample module n converts channel n on every TIMER0 trigger and requests PDMA */
+    for (u32Module = 0; u32Module < ADC_CHANNELS; u32Module++)
+        EADC_ConfigSampleModule(EADC0, u32Module, EADC_TIMER0_TRIGGER, u32Module);
+
+    EADC_ENABLE_SAMPLE_MODULE_PDMA(EADC0, (1 << ADC_CHANNELS) - 1);
+
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, SAMPLE_RATE);
+    TIMER0->TRGCTL |= TIMER_TRGCTL_TRGEADC_Msk;
+
+    return 0;
+}
+
+int32_t main(void)
+{
+    static const char *apcStage[eSFLT_STAGE_CNT] = {"deinterleave", "decimate", "q15->f32", "biquad", "fir"};
+    SFLT_CFG_T sCfg = {0};
+    uint32_t u32Processed = 0, s;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, IP clock and multi-function I/O */
+    SYS_Init();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    printf("\nSystem clock rate: %d Hz", SystemCoreClock);
+
+    printf("\n+----------------------------------------------------------------------+\n");
+    printf("|     %d-channel EADC -> PDMA ping-pong -> streaming filter engine      |\n", ADC_CHANNELS);
+    printf("+----------------------------------------------------------------------+\n");
+
+    /* Enable the DWT cycle counter for the stage profiling */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* 16 kHz -> 4 kHz, 300..1500 Hz band of interest, 1.2 kHz output lowpass */
+    SFLT_DesignLowpassQ15(s_ai16Decim, DECIM_TAPS, 0.9f / (2.0f * DECIM_FACTOR));
+    SFLT_DesignBandpass(&s_af32Biquad[0], 400.0f / 4000.0f, 0.7f);
+    SFLT_DesignBandpass(&s_af32Biquad[5], 900.0f / 4000.0f, 0.7f);
+    SFLT_DesignLowpassF32(s_af32Fir, FIR_TAPS, 1200.0f / 4000.0f);
+
+    sCfg.u32Channels = ADC_CHANNELS;
+    sCfg.u32BlockSize = BLOCK_SIZE;
+    sCfg.u32SampleRate = SAMPLE_RATE;
+    sCfg.u32DecimFactor = DECIM_FACTOR;
+    sCfg.u32DecimTaps = DECIM_TAPS;
+    sCfg.pi16DecimCoef = s_ai16Decim;
+    sCfg.u32BiquadStages = 2;
+    sCfg.pf32BiquadCoef = s_af32Biquad;
+    sCfg.u32FirTaps = FIR_TAPS;
+    sCfg.pf32FirCoef = s_af32Fir;
+    sCfg.pfnGetTicks = GetCycles;
+    sCfg.u32TickHz = SystemCoreClock;
+
+    if (SFLT_Init(&s_sFlt, &sCfg) != SFLT_OK)
+    {
+        printf("Filter configuration error.\n");
+        goto lexit;
+    }
+
+    PDMA_PingPongInit();
+
+    if (EADC_StreamInit() != 0)
+    {
+        printf("EADC open error.\n");
+        goto lexit;
+    }
+
+    TIMER_Start(TIMER0);
+
+    while (1)
+    {
+        const float32_t *pf32Out;
+        uint32_t u32Len;
+
+        while (u32Processed == s_u32FilledCnt);
+
+        /* PDMA is two halves ahead: the half to be read has been overwritten */
+        if ((s_u32FilledCnt - u32Processed) > 1)
+        {
+            s_u32Overrun++;
+            u32Processed = s_u32FilledCnt - 1;
+        }
+
+        SFLT_ProcessBlock(&s_sFlt, s_ai16PingPong[u32Processed & 1]);
+        u32Processed++;
+
+        /* Report about once a second */
+        if ((u32Processed % (SAMPLE_RATE / BLOCK_SIZE)) == 0)
+        {
+            pf32Out = SFLT_GetOutput(&s_sFlt, 0, &u32Len);
+
+            printf("\nblocks %u, overruns %u, CH0 last output %d/32768\n", u32Processed, s_u32Overrun,
+                   (int32_t)(pf32Out[u32Len - 1] * 32768.0f));
+
+            for (s = 0; s < eSFLT_STAGE_CNT; s++)
+            {
+                uint32_t u32Load = (uint32_t)(SFLT_GetStageLoad(&s_sFlt, (E_SFLT_STAGE)s) * 100.0f);
+
+                printf("  %-14s %2u.%02u %%  max %u cycles\n", apcStage[s], u32Load / 100, u32Load % 100, s_sFlt.au32MaxTicks[s]);
+            }
+
+            SFLT_ResetStats(&s_sFlt);
+        }
+    }
+
+lexit:
+
+    while (1);
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,355 @@
+/**************************************************************************//**
+ * @file     stream_filter.c
+ * @version  V1.00
+ * @brief    Multichannel block-streaming filter engine on CMSIS-DSP kernels.
+ *
+ * @details  One call to SFLT_ProcessBlock() consumes one interleaved q15 block
+ *           as written by PDMA (the ping or the pong half) and runs
+ *           deinterleave -> q15 decimating FIR -> q15 to float -> biquad
+ *           cascade -> FIR on every channel. Every stage reads the buffer the
+ *           previous stage wrote, so no data is copied between kernels. Stages
+ *           are run stage-major over all channels, which keeps one kernel hot in
+ *           the cache and lets each stage be timed once per block.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <string.h>
+#include <math.h>
+#include "stream_filter.h"
+
+static uint32_t SFLT_GetTicks(SFLT_T *psFlt)
+{
+    return (psFlt->sCfg.pfnGetTicks != NULL) ? psFlt->sCfg.pfnGetTicks() : 0;
+}
+
+/* Charge the ticks since *pu32Mark to eStage and move the mark */
+static void SFLT_Account(SFLT_T *psFlt, E_SFLT_STAGE eStage, uint32_t *pu32Mark)
+{
+    uint32_t u32Now = SFLT_GetTicks(psFlt);
+    uint32_t u32Ticks = u32Now - *pu32Mark;
+
+    psFlt->au64Ticks[eStage] += u32Ticks;
+
+    if (u32Ticks > psFlt->au32MaxTicks[eStage])
+        psFlt->au32MaxTicks[eStage] = u32Ticks;
+
+    *pu32Mark = u32Now;
+}
+
+/**
+  * @brief      Split an interleaved block into the per-channel input buffers
+  * @param[in]  psFlt       The engine
+  * @param[in]  pi16Block   Interleaved block, sample n of channel c at [n * channels + c]
+  * @return     None
+  * @details    With an even channel count and a word-aligned block, one word
+  *             holds the same sample of two adjacent channels. Two such words
+  *             from consecutive frames are repacked with PKHBT/PKHTB into one
+  *             word per channel, so four samples move with two loads and two
+  *             stores. Other layouts fall back to halfword copies.
+  */
+static void SFLT_Deinterleave(SFLT_T *psFlt, const q15_t *pi16Block)
+{
+    const uint32_t u32Chs = psFlt->sCfg.u32Channels;
+    const uint32_t u32Len = psFlt->sCfg.u32BlockSize;
+    uint32_t c, n;
+
+    if (((u32Chs & 1u) == 0) && (((uintptr_t)pi16Block & 3u) == 0))
+    {
+        const uint32_t u32Stride = u32Chs / 2;    /* words per frame */
+
+        for (c = 0; c < u32Chs; c += 2)
+        {
+            const int32_t *pi32Src = (const int32_t *)(pi16Block + c);
+            int32_t *pi32Lo = (int32_t *)psFlt->asCh[c].ai16In;
+            int32_t *pi32Hi = (int32_t *)psFlt->asCh[c + 1].ai16In;
+            int32_t i32W0, i32W1;
+
+            for (n = u32Len / 2; n > 0; n--)
+            {
+                i32W0 = pi32Src[0];
+                i32W1 = pi32Src[u32Stride];
+                pi32Src += 2 * u32Stride;
+
+                *pi32Lo++ = (int32_t)__PKHBT(i32W0, i32W1, 16);
+                *pi32Hi++ = (int32_t)__PKHTB(i32W1, i32W0, 16);
+            }
+        }
+    }
+    else
+    {
+        for (c = 0; c < u32Chs; c++)
+        {
+            const q15_t *pi16Src = pi16Block + c;
+            q15_t *pi16Dst = psFlt->asCh[c].ai16In;
+
+            for (n = u32Len; n > 0; n--)
+            {
+                *pi16Dst++ = *pi16Src;
+                pi16Src += u32Chs;
+            }
+        }
+    }
+}
+
+/**
+  * @brief      Initialize the filter engine
+  * @param[out] psFlt   The engine
+  * @param[in]  psCfg   Channel, block and filter configuration. Copied; coefficient arrays must stay valid.
+  * @retval     SFLT_OK         Success
+  * @retval     SFLT_ERR_PARAM  The configuration exceeds the SFLT_MAX_* capacity or is inconsistent
+  * @details    Clears all filter states and statistics.
+  */
+int32_t SFLT_Init(SFLT_T *psFlt, const SFLT_CFG_T *psCfg)
+{
+    SFLT_CH_T *psCh;
+    uint32_t c, u32OutLen;
+    float32_t *pf32Cur, *pf32Next, *pf32Tmp;
+
+    if ((psCfg->u32Channels == 0) || (psCfg->u32Channels > SFLT_MAX_CHANNELS) ||
+            (psCfg->u32BlockSize == 0) || (psCfg->u32BlockSize > SFLT_MAX_BLOCK) || (psCfg->u32BlockSize & 1u) ||
+            (psCfg->u32DecimFactor == 0) || (psCfg->u32DecimFactor > 255) || (psCfg->u32BlockSize % psCfg->u32DecimFactor) ||
+            (psCfg->u32BiquadStages > SFLT_MAX_BIQUADS) || (psCfg->u32FirTaps > SFLT_MAX_FIR_TAPS))
+        return SFLT_ERR_PARAM;
+
+    if ((psCfg->u32DecimFactor > 1) && ((psCfg->u32DecimTaps == 0) || (psCfg->u32DecimTaps > SFLT_MAX_DECIM_TAPS)))
+        return SFLT_ERR_PARAM;
+
+    memset(psFlt, 0, sizeof(SFLT_T));
+    psFlt->sCfg = *psCfg;
+    u32OutLen = psCfg->u32BlockSize / psCfg->u32DecimFactor;
+    psFlt->u32OutLen = u32OutLen;
+
+    for (c = 0; c < psCfg->u32Channels; c++)
+    {
+        psCh = &psFlt->asCh[c];
+
+        if (psCfg->u32DecimFactor > 1)
+        {
+            if (arm_fir_decimate_init_q15(&psCh->sDecim, (uint16_t)psCfg->u32DecimTaps, (uint8_t)psCfg->u32DecimFactor,
+                                          (q15_t *)psCfg->pi16DecimCoef, psCh->ai16DecimState, psCfg->u32BlockSize) != ARM_MATH_SUCCESS)
+                return SFLT_ERR_PARAM;
+        }
+
+        /* the float stages ping-pong between the two channel buffers */
+        pf32Cur = psCh->af32BufA;
+        pf32Next = psCh->af32BufB;
+
+        if (psCfg->u32BiquadStages)
+        {
+            arm_biquad_cascade_df2T_init_f32(&psCh->sBiquad, (uint8_t)psCfg->u32BiquadStages,
+                                             (float32_t *)psCfg->pf32BiquadCoef, psCh->af32BiquadState);
+            pf32Tmp = pf32Cur;
+            pf32Cur = pf32Next;
+            pf32Next = pf32Tmp;
+        }
+
+        if (psCfg->u32FirTaps)
+        {
+            arm_fir_init_f32(&psCh->sFir, (uint16_t)psCfg->u32FirTaps, (float32_t *)psCfg->pf32FirCoef,
+                             psCh->af32FirState, u32OutLen);
+            pf32Cur = pf32Next;
+        }
+
+        psCh->pf32Out = pf32Cur;
+    }
+
+    return SFLT_OK;
+}
+
+/**
+  * @brief      Filter one interleaved block on all channels
+  * @param[in]  psFlt       The engine
+  * @param[in]  pi16Block   Interleaved q15 block of u32BlockSize frames. Word aligned for the SIMD deinterleave.
+  * @return     None
+  * @details    Call from thread context once PDMA has filled a half of the
+  *             ping-pong buffer; the other half may be written meanwhile. The
+  *             results are valid until the next call, see SFLT_GetOutput().
+  *             With a single channel the block is used in place.
+  */
+void SFLT_ProcessBlock(SFLT_T *psFlt, const q15_t *pi16Block)
+{
+    const SFLT_CFG_T *psCfg = &psFlt->sCfg;
+    SFLT_CH_T *psCh;
+    q15_t *pi16Src;
+    float32_t *pf32Src, *pf32Dst;
+    uint32_t c, u32Mark;
+
+    u32Mark = SFLT_GetTicks(psFlt);
+
+    if (psCfg->u32Channels > 1)
+        SFLT_Deinterleave(psFlt, pi16Block);
+
+    SFLT_Account(psFlt, eSFLT_STAGE_DEINTERLEAVE, &u32Mark);
+
+    if (psCfg->u32DecimFactor > 1)
+    {
+        for (c = 0; c < psCfg->u32Channels; c++)
+        {
+            psCh = &psFlt->asCh[c];
+            pi16Src = (psCfg->u32Channels > 1) ? psCh->ai16In : (q15_t *)pi16Block;
+            arm_fir_decimate_q15(&psCh->sDecim, pi16Src, psCh->ai16Decim, psCfg->u32BlockSize);
+        }
+
+        SFLT_Account(psFlt, eSFLT_STAGE_DECIMATE, &u32Mark);
+    }
+
+    for (c = 0; c < psCfg->u32Channels; c++)
+    {
+        psCh = &psFlt->asCh[c];
+
+        if (psCfg->u32DecimFactor > 1)
+            pi16Src = psCh->ai16Decim;
+        else
+            pi16Src = (psCfg->u32Channels > 1) ? psCh->ai16In : (q15_t *)pi16Block;
+
+        arm_q15_to_float(pi16Src, psCh->af32BufA, psFlt->u32OutLen);
+    }
+
+    SFLT_Account(psFlt, eSFLT_STAGE_CONVERT, &u32Mark);
+
+    /* biquad A -> B, then FIR from whichever buffer holds the data into the other */
+    if (psCfg->u32BiquadStages)
+    {
+        for (c = 0; c < psCfg->u32Channels; c++)
+        {
+            psCh = &psFlt->asCh[c];
+            arm_biquad_cascade_df2T_f32(&psCh->sBiquad, psCh->af32BufA, psCh->af32BufB, psFlt->u32OutLen);
+        }
+
+        SFLT_Account(psFlt, eSFLT_STAGE_BIQUAD, &u32Mark);
+    }
+
+    if (psCfg->u32FirTaps)
+    {
+        for (c = 0; c < psCfg->u32Channels; c++)
+        {
+            psCh = &psFlt->asCh[c];
+            pf32Src = psCfg->u32BiquadStages ? psCh->af32BufB : psCh->af32BufA;
+            pf32Dst = psCfg->u32BiquadStages ? psCh->af32BufA : psCh->af32BufB;
+            arm_fir_f32(&psCh->sFir, pf32Src, pf32Dst, psFlt->u32OutLen);
+        }
+
+        SFLT_Account(psFlt, eSFLT_STAGE_FIR, &u32Mark);
+    }
+
+    psFlt->u32Blocks++;
+}
+
+/**
+  * @brief      Get the filtered output of one channel
+  * @param[in]  psFlt       The engine
+  * @param[in]  u32Ch       Channel index
+  * @param[out] pu32Len     Number of output samples, may be NULL
+  * @return     Output of the last enabled stage for the latest block
+  */
+const float32_t *SFLT_GetOutput(SFLT_T *psFlt, uint32_t u32Ch, uint32_t *pu32Len)
+{
+    if (pu32Len != NULL)
+        *pu32Len = psFlt->u32OutLen;
+
+    return psFlt->asCh[u32Ch].pf32Out;
+}
+
+/**
+  * @brief      Get the average CPU load of one stage
+  * @param[in]  psFlt       The engine
+  * @param[in]  eStage      Stage
+  * @return     Percentage of real time spent in the stage over all channels
+  * @details    Real time per block is u32BlockSize / u32SampleRate. Returns 0
+  *             if profiling is disabled or no block was processed.
+  */
+float SFLT_GetStageLoad(SFLT_T *psFlt, E_SFLT_STAGE eStage)
+{
+    const SFLT_CFG_T *psCfg = &psFlt->sCfg;
+    double dPeriodTicks;
+
+    if ((psFlt->u32Blocks == 0) || (psCfg->pfnGetTicks == NULL) || (psCfg->u32SampleRate == 0))
+        return 0.0f;
+
+    dPeriodTicks = (double)psCfg->u32BlockSize * (double)psCfg->u32TickHz / (double)psCfg->u32SampleRate;
+
+    return (float)(100.0 * (double)psFlt->au64Ticks[eStage] / ((double)psFlt->u32Blocks * dPeriodTicks));
+}
+
+/**
+  * @brief      Clear the block count and the per-stage tick statistics
+  * @param[in]  psFlt   The engine
+  * @return     None
+  */
+void SFLT_ResetStats(SFLT_T *psFlt)
+{
+    psFlt->u32Blocks = 0;
+    memset(psFlt->au64Ticks, 0, sizeof(psFlt->au64Ticks));
+    memset(psFlt->au32MaxTicks, 0, sizeof(psFlt->au32MaxTicks));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Coefficient design helpers                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/**
+  * @brief      Design a Hamming-windowed sinc lowpass FIR
+  * @param[out] pf32Coef    u32Taps coefficients (symmetric, so already in CMSIS order)
+  * @param[in]  u32Taps     Filter length
+  * @param[in]  f32Cutoff   Cutoff frequency as a fraction of the sample rate (0 to 0.5)
+  * @return     None
+  * @details    The DC gain is normalized to 1.
+  */
+void SFLT_DesignLowpassF32(float32_t *pf32Coef, uint32_t u32Taps, float32_t f32Cutoff)
+{
+    uint32_t i;
+    double dX, dSum = 0.0, dMid = ((double)u32Taps - 1.0) / 2.0;
+
+    for (i = 0; i < u32Taps; i++)
+    {
+        dX = (double)i - dMid;
+        pf32Coef[i] = (float32_t)(((dX == 0.0) ? (2.0 * f32Cutoff) : (sin(2.0 * PI * f32Cutoff * dX) / (PI * dX)))
+                                  * (0.54 - 0.46 * cos(2.0 * PI * (double)i / ((double)u32Taps - 1.0))));
+        dSum += pf32Coef[i];
+    }
+
+    for (i = 0; i < u32Taps; i++)
+        pf32Coef[i] = (float32_t)(pf32Coef[i] / dSum);
+}
+
+/**
+  * @brief      Design a Hamming-windowed sinc lowpass FIR in q15
+  * @param[out] pi16Coef    u32Taps coefficients (at most SFLT_MAX_DECIM_TAPS)
+  * @param[in]  u32Taps     Filter length
+  * @param[in]  f32Cutoff   Cutoff frequency as a fraction of the sample rate (0 to 0.5)
+  * @return     None
+  */
+void SFLT_DesignLowpassQ15(q15_t *pi16Coef, uint32_t u32Taps, float32_t f32Cutoff)
+{
+    float32_t af32Coef[SFLT_MAX_DECIM_TAPS];
+    uint32_t i;
+
+    if (u32Taps > SFLT_MAX_DECIM_TAPS)
+        u32Taps = SFLT_MAX_DECIM_TAPS;
+
+    SFLT_DesignLowpassF32(af32Coef, u32Taps, f32Cutoff);
+
+    for (i = 0; i < u32Taps; i++)
+        pi16Coef[i] = (q15_t)__SSAT((int32_t)lroundf(af32Coef[i] * 32768.0f), 16);
+}
+
+/**
+  * @brief      Design one biquad bandpass section (0 dB peak gain)
+  * @param[out] pf32Coef    5 coefficients in CMSIS df2T order {b0, b1, b2, -a1, -a2}
+  * @param[in]  f32Center   Center frequency as a fraction of the sample rate
+  * @param[in]  f32Q        Quality factor
+  * @return     None
+  */
+void SFLT_DesignBandpass(float32_t *pf32Coef, float32_t f32Center, float32_t f32Q)
+{
+    double dW0 = 2.0 * PI * f32Center;
+    double dAlpha = sin(dW0) / (2.0 * f32Q);
+    double dA0 = 1.0 + dAlpha;
+
+    pf32Coef[0] = (float32_t)(dAlpha / dA0);
+    pf32Coef[1] = 0.0f;
+    pf32Coef[2] = (float32_t)(-dAlpha / dA0);
+    pf32Coef[3] = (float32_t)(2.0 * cos(dW0) / dA0);
+    pf32Coef[4] = (float32_t)(-(1.0 - dAlpha) / dA0);
+}
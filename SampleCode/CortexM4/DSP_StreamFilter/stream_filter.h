@@ -0,0 +1,123 @@
+/**************************************************************************//**
+ * @file     stream_filter.h
+ * @version  V1.00
+ * @brief    Multichannel block-streaming filter engine on CMSIS-DSP kernels.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __STREAM_FILTER_H__
+#define __STREAM_FILTER_H__
+
+#include "arm_math.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Capacity. Override before including this header to trade RAM for channels or taps.                    */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef SFLT_MAX_CHANNELS
+#define SFLT_MAX_CHANNELS       8       /*!< Interleaved channels per block */
+#endif
+#ifndef SFLT_MAX_BLOCK
+#define SFLT_MAX_BLOCK          256     /*!< Samples per channel in one ping or pong block (even) */
+#endif
+#ifndef SFLT_MAX_DECIM_TAPS
+#define SFLT_MAX_DECIM_TAPS     64      /*!< Decimation FIR taps */
+#endif
+#ifndef SFLT_MAX_BIQUADS
+#define SFLT_MAX_BIQUADS        4       /*!< Second-order sections in the biquad cascade */
+#endif
+#ifndef SFLT_MAX_FIR_TAPS
+#define SFLT_MAX_FIR_TAPS       64      /*!< Output FIR taps */
+#endif
+
+#define SFLT_OK                 ( 0L)   /*!< Success */
+#define SFLT_ERR_PARAM          (-1L)   /*!< Configuration exceeds the capacity or is inconsistent */
+
+/**
+  * @brief  Processing stages, in pipeline order. Used to read the per-stage CPU load.
+  */
+typedef enum
+{
+    eSFLT_STAGE_DEINTERLEAVE = 0,       /*!< Split the interleaved q15 block into channels */
+    eSFLT_STAGE_DECIMATE,               /*!< arm_fir_decimate_q15() */
+    eSFLT_STAGE_CONVERT,                /*!< arm_q15_to_float() */
+    eSFLT_STAGE_BIQUAD,                 /*!< arm_biquad_cascade_df2T_f32() */
+    eSFLT_STAGE_FIR,                    /*!< arm_fir_f32() */
+    eSFLT_STAGE_CNT
+} E_SFLT_STAGE;
+
+/**
+  * @brief  Engine configuration. All channels share the coefficients, each has its own state.
+  * @details Coefficients follow the CMSIS-DSP conventions: FIR taps in time-reversed order,
+  *          five {b0, b1, b2, a1, a2} per biquad section with the a terms negated.
+  *          A stage with zero taps/sections (decimation factor 1) is skipped.
+  */
+typedef struct
+{
+    uint32_t u32Channels;               /*!< Channels interleaved in the input block */
+    uint32_t u32BlockSize;              /*!< Samples per channel in one block, multiple of u32DecimFactor */
+    uint32_t u32SampleRate;             /*!< Input rate per channel in Hz, for the load figures */
+    uint32_t u32DecimFactor;            /*!< Decimation factor M, 1 disables the decimator */
+    uint32_t u32DecimTaps;              /*!< Decimation FIR length */
+    const q15_t *pi16DecimCoef;         /*!< Decimation FIR coefficients */
+    uint32_t u32BiquadStages;           /*!< Biquad sections, 0 disables the stage */
+    const float32_t *pf32BiquadCoef;    /*!< 5 coefficients per section */
+    uint32_t u32FirTaps;                /*!< Output FIR length, 0 disables the stage */
+    const float32_t *pf32FirCoef;       /*!< Output FIR coefficients */
+    uint32_t (*pfnGetTicks)(void);      /*!< Free-running tick counter for profiling, NULL to disable */
+    uint32_t u32TickHz;                 /*!< pfnGetTicks() rate, e.g. SystemCoreClock for DWT->CYCCNT */
+} SFLT_CFG_T;
+
+/**
+  * @brief  Per-channel buffers and kernel instances.
+  * @details Each stage writes straight into the input buffer of the next one;
+  *          the float stages alternate between af32BufA and af32BufB.
+  */
+typedef struct
+{
+    arm_fir_decimate_instance_q15 sDecim;
+    arm_biquad_cascade_df2T_instance_f32 sBiquad;
+    arm_fir_instance_f32 sFir;
+    float32_t af32BufA[SFLT_MAX_BLOCK];
+    float32_t af32BufB[SFLT_MAX_BLOCK];
+    float32_t af32BiquadState[2 * SFLT_MAX_BIQUADS];
+    float32_t af32FirState[SFLT_MAX_FIR_TAPS + SFLT_MAX_BLOCK - 1];
+    q15_t ai16In[SFLT_MAX_BLOCK];
+    q15_t ai16Decim[SFLT_MAX_BLOCK];
+    q15_t ai16DecimState[SFLT_MAX_DECIM_TAPS + SFLT_MAX_BLOCK - 1];
+    float32_t *pf32Out;                 /*!< Output of the last enabled stage */
+} SFLT_CH_T;
+
+/**
+  * @brief  Engine instance.
+  */
+typedef struct
+{
+    SFLT_CFG_T sCfg;
+    SFLT_CH_T asCh[SFLT_MAX_CHANNELS];
+    uint32_t u32OutLen;                 /*!< Output samples per channel per block */
+    uint32_t u32Blocks;                 /*!< Blocks processed since SFLT_ResetStats() */
+    uint64_t au64Ticks[eSFLT_STAGE_CNT];    /*!< Accumulated ticks per stage */
+    uint32_t au32MaxTicks[eSFLT_STAGE_CNT]; /*!< Worst block per stage */
+} SFLT_T;
+
+int32_t SFLT_Init(SFLT_T *psFlt, const SFLT_CFG_T *psCfg);
+void SFLT_ProcessBlock(SFLT_T *psFlt, const q15_t *pi16Block);
+const float32_t *SFLT_GetOutput(SFLT_T *psFlt, uint32_t u32Ch, uint32_t *pu32Len);
+float SFLT_GetStageLoad(SFLT_T *psFlt, E_SFLT_STAGE eStage);
+void SFLT_ResetStats(SFLT_T *psFlt);
+
+void SFLT_DesignLowpassQ15(q15_t *pi16Coef, uint32_t u32Taps, float32_t f32Cutoff);
+void SFLT_DesignLowpassF32(float32_t *pf32Coef, uint32_t u32Taps, float32_t f32Cutoff);
+void SFLT_DesignBandpass(float32_t *pf32Coef, float32_t f32Center, float32_t f32Q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STREAM_FILTER_H__ */
@@ -0,0 +1,395 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Compile large CAN acceptance lists with CANFD_FltrCompile() and
+ *           verify every ID end to end on the simulated CAN FD bus.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../CANFD_SimBus -I../../../Library/StdDriver/inc
+ *               -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../CANFD_SimBus/canfd_sim.c ../common/hostsim.c
+ *               ../../../Library/StdDriver/src/canfd.c -o canfd_fltrcompiler
+ *           ./canfd_fltrcompiler
+ *
+ *           CANFD0 sends every standard ID and a sample of extended IDs to
+ *           CANFD1, whose filter list comes from the compiler. A frame must reach
+ *           the application exactly when its ID is in the acceptance list.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "canfd_sim.h"
+
+#define SID_LIST_MAX        1024
+#define XID_LIST_MAX        2048
+#define XID_TEST_FRAMES     8000
+
+#define J1939_PGN_CNT       40
+#define J1939_NODE_CNT      300
+
+static CANFD_ID_RANGE_T s_asSidList[SID_LIST_MAX], s_asSidRef[SID_LIST_MAX];
+static CANFD_ID_RANGE_T s_asXidList[XID_LIST_MAX], s_asXidRef[XID_LIST_MAX];
+static uint32_t s_u32SidCnt, s_u32XidCnt;
+
+/* Compiler and software filter storage */
+static uint32_t s_au32Hash[4096];
+static CANFD_ID_RANGE_T s_asSwRange[1024];
+static uint32_t s_au32Work[XID_LIST_MAX * 10];
+static CANFD_FLTR_T s_sFltr;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Reference membership test on the original acceptance list                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t IsListed(const CANFD_ID_RANGE_T *psList, uint32_t u32Cnt, uint32_t u32Id)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Cnt; i++)
+    {
+        if ((u32Id >= psList[i].u32IdLow) && (u32Id <= psList[i].u32IdHigh))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void AddId(CANFD_ID_RANGE_T *psList, uint32_t *pu32Cnt, uint32_t u32Low, uint32_t u32High)
+{
+    psList[*pu32Cnt].u32IdLow = u32Low;
+    psList[*pu32Cnt].u32IdHigh = u32High;
+    (*pu32Cnt)++;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Acceptance lists                                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+static void BuildLists(void)
+{
+    uint32_t i, u32Id, u32Pgn, u32Prio;
+
+    srand(1);
+
+    /* standard IDs: scattered single IDs, a strided diagnostic block and a few ranges */
+    for (i = 0; i < 300; i++)
+    {
+        u32Id = (uint32_t)rand() & 0x3FF;
+        AddId(s_asSidList, &s_u32SidCnt, u32Id, u32Id);
+    }
+
+    for (i = 0; i < 32; i++)
+        AddId(s_asSidList, &s_u32SidCnt, 0x600 + i * 4, 0x600 + i * 4);
+
+    AddId(s_asSidList, &s_u32SidCnt, 0x700, 0x71F);
+    AddId(s_asSidList, &s_u32SidCnt, 0x7E0, 0x7EF);
+
+    /* J1939: a set of PGNs from any source address at any priority (ID = P[28:26] EDP DP PF PS SA) */
+    for (i = 0; i < J1939_PGN_CNT; i++)
+    {
+        u32Pgn = 0xFE00 + ((uint32_t)rand() & 0x1FF);
+
+        for (u32Prio = 0; u32Prio < 8; u32Prio++)
+            AddId(s_asXidList, &s_u32XidCnt, (u32Prio << 26) | (u32Pgn << 8), (u32Prio << 26) | (u32Pgn << 8) | 0xFF);
+    }
+
+    /* plus peer-to-peer messages from individual nodes */
+    for (i = 0; i < J1939_NODE_CNT; i++)
+    {
+        u32Id = (((uint32_t)rand() & 0x7) << 26) | (((uint32_t)rand() & 0xFFFF) << 8) | ((uint32_t)rand() & 0xFF);
+        AddId(s_asXidList, &s_u32XidCnt, u32Id, u32Id);
+    }
+
+    /* the compiler sorts and merges the list in place, keep the original for the reference check */
+    memcpy(s_asSidRef, s_asSidList, sizeof(s_asSidList));
+    memcpy(s_asXidRef, s_asXidList, sizeof(s_asXidList));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  CANFD1 with the largest filter lists: 128 standard and 64 extended elements                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static void OpenNodes(uint32_t u32SidElems, uint32_t u32XidElems)
+{
+    CANFD_FD_T sConfig;
+    CANFD_RAM_PART_T *psAddr = &sConfig.sMRamStartAddr;
+    CANFD_ELEM_SIZE_T *psSize = &sConfig.sElemSize;
+
+    CANFD_SimAttach(CANFD0);
+    CANFD_GetDefaultConfig(&sConfig, CANFD_OP_CAN_FD_MODE);
+    sConfig.sBtConfig.sNormBitRate.u32BitRate = 1000000;
+    sConfig.sBtConfig.sDataBitRate.u32BitRate = 4000000;
+    CANFD_Open(CANFD0, &sConfig);
+
+    /* same partition order as the driver default, with resized filter lists */
+    psSize->u32SIDFC = u32SidElems;
+    psSize->u32XIDFC = u32XidElems;
+    psAddr->u32SIDFC_FLSSA = 0;
+    psAddr->u32XIDFC_FLESA = psAddr->u32SIDFC_FLSSA + psSize->u32SIDFC * sizeof(CANFD_STD_FILTER_T);
+    psAddr->u32TXBC_TBSA = psAddr->u32XIDFC_FLESA + psSize->u32XIDFC * sizeof(CANFD_EXT_FILTER_T);
+    psAddr->u32RXBC_RBSA = psAddr->u32TXBC_TBSA + psSize->u32TxBuf * sizeof(CANFD_BUF_T);
+    psAddr->u32RXF0C_F0SA = psAddr->u32RXBC_RBSA + psSize->u32RxBuf * sizeof(CANFD_BUF_T);
+    psAddr->u32RXF1C_F1SA = psAddr->u32RXF0C_F0SA + psSize->u32RxFifo0 * sizeof(CANFD_BUF_T);
+    psAddr->u32TXEFC_EFSA = psAddr->u32RXF1C_F1SA + psSize->u32RxFifo1 * sizeof(CANFD_BUF_T);
+
+    CANFD_SimAttach(CANFD1);
+    CANFD_Open(CANFD1, &sConfig);
+}
+
+static void PrintReport(const char *pcName, const CANFD_FLTR_REPORT_T *psReport, uint32_t u32ListCnt, uint64_t u64Ns)
+{
+    printf("  %s: %u list entries compiled in %.1f us\n", pcName, u32ListCnt, (double)u64Ns / 1000.0);
+    printf("    elements: %u range + %u mask + %u dual = %u\n", psReport->u32RangeElems, psReport->u32MaskElems,
+           psReport->u32DualElems, psReport->u32RangeElems + psReport->u32MaskElems + psReport->u32DualElems);
+    printf("    IDs: %u by filter elements, %u by software hash/range filter\n", psReport->u32HwIds, psReport->u32SwIds);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Send one ID and check where it ends up                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t s_u32HwRejected, s_u32Delivered, s_u32CheckCnt;
+static uint64_t s_u64CheckNs;
+
+static void SendAndCheck(E_CANFD_ID_TYPE eIdType, uint32_t u32Id, uint32_t u32Expected)
+{
+    CANFD_FD_MSG_T sTx, sRx;
+    uint32_t u32Fifo, u32Accepted = 0, u32Seen = 0;
+    uint64_t u64T0;
+
+    memset(&sTx, 0, sizeof(sTx));
+    sTx.eIdType = eIdType;
+    sTx.u32Id = u32Id;
+    sTx.u32DLC = 8;
+    sTx.au32Data[0] = u32Id;
+
+    CANFD_TransmitDMsg(CANFD0, 0, &sTx);
+    CANFD_SimStep();
+
+    for (u32Fifo = 0; u32Fifo < 2; u32Fifo++)
+    {
+        if (CANFD_ReadRxFifoMsg(CANFD1, (uint8_t)u32Fifo, &sRx) == 0)
+            continue;
+
+        u32Seen++;
+        u64T0 = HOSTSIM_GetNanoSec();
+        u32Accepted = CANFD_FltrCheck(&s_sFltr, u32Fifo, &sRx);
+        s_u64CheckNs += HOSTSIM_GetNanoSec() - u64T0;
+        s_u32CheckCnt++;
+    }
+
+    if (u32Seen == 0)
+        s_u32HwRejected++;
+
+    if (u32Accepted)
+        s_u32Delivered++;
+
+    if (u32Accepted != u32Expected)
+    {
+        if (s_u32Errors < 10)
+            printf("  FAIL: %s ID 0x%08x %s\n", (eIdType == eCANFD_XID) ? "ext" : "std", u32Id,
+                   u32Expected ? "not delivered" : "delivered");
+
+        s_u32Errors++;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Ranges that each seed a classic element: four ranges and three cubes need 7 elements of scratch       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CUBE_RANGES         4
+#define CUBE_WORK           (CUBE_RANGES * 2 * 4)   /* 2 elements of 4 words per range */
+#define GUARD_WORD          0xA5A5A5A5ul
+
+static void TestCubeRanges(void)
+{
+    static const uint32_t au32Low[CUBE_RANGES] = { 0x000, 0x010, 0x020, 0x040 };
+    CANFD_ID_RANGE_T asList[CUBE_RANGES], asRef[CUBE_RANGES];
+    uint32_t au32Work[CUBE_WORK];
+    uint32_t i, u32Size, u32Cnt = 0, u32Errors = s_u32Errors;
+    uint64_t u64Ns = 0;
+    int32_t i32Ret = CANFD_ERR_FLTR_WORK;
+
+    printf("\n[Cubes] 4 ranges of 4 IDs at 0x000, 0x010, 0x020 and 0x040\n");
+
+    for (i = 0; i < CUBE_RANGES; i++)
+        AddId(asRef, &u32Cnt, au32Low[i], au32Low[i] + 3);
+
+    OpenNodes(CANFD_MAX_11_BIT_FTR_ELEMS, CANFD_MAX_29_BIT_FTR_ELEMS);
+
+    /* every scratch size up to the worst case: refused, or used without writing past its end */
+    for (u32Size = 0; u32Size <= CUBE_WORK; u32Size++)
+    {
+        for (i = 0; i < CUBE_WORK; i++)
+            au32Work[i] = GUARD_WORD;
+
+        memcpy(asList, asRef, sizeof(asList));
+        CHECK(CANFD_FltrInit(&s_sFltr, s_au32Hash, sizeof(s_au32Hash) / 4, s_asSwRange, sizeof(s_asSwRange) / sizeof(s_asSwRange[0]),
+                             au32Work, u32Size) == CANFD_OK, "CANFD_FltrInit() failed");
+        u64Ns = HOSTSIM_GetNanoSec();
+        i32Ret = CANFD_FltrCompile(CANFD1, &s_sFltr, eCANFD_SID, asList, u32Cnt);
+        u64Ns = HOSTSIM_GetNanoSec() - u64Ns;
+
+        for (i = u32Size; i < CUBE_WORK; i++)
+        {
+            if (au32Work[i] != GUARD_WORD)
+            {
+                printf("  FAIL: %u-word scratch buffer overrun at word %u\n", u32Size, i);
+                s_u32Errors++;
+                break;
+            }
+        }
+
+        if ((i32Ret != CANFD_OK) && (i32Ret != CANFD_ERR_FLTR_WORK))
+            break;
+    }
+
+    PrintReport("cube ranges", &s_sFltr.asReport[eCANFD_SID], u32Cnt, u64Ns);
+
+    if (i32Ret != CANFD_OK)
+    {
+        printf("  FAIL: CANFD_FltrCompile() returned %d with %u words of scratch\n", i32Ret, CUBE_WORK);
+        s_u32Errors++;
+    }
+
+    CANFD_RunToNormal(CANFD0, TRUE);
+    CANFD_RunToNormal(CANFD1, TRUE);
+
+    for (i = 0; i <= 0x7F; i++)
+        SendAndCheck(eCANFD_SID, i, IsListed(asRef, u32Cnt, i));
+
+    printf("  IDs 0x000-0x07F through the bus: %s\n", (s_u32Errors == u32Errors) ? "ok" : "failed");
+}
+
+/* Hash set sizes that are not a power of two are refused; 0 means no hash set at all */
+static void TestHashSize(void)
+{
+    static const uint32_t au32Id[8] = {0x101, 0x123, 0x245, 0x367, 0x489, 0x5AB, 0x6CD, 0x7EF};
+    CANFD_ID_RANGE_T asList[8];
+    uint32_t i, u32Cnt = 0;
+    int32_t i32Ret;
+
+    printf("\n[Hash size] invalid sizes and a filter without hash set\n");
+
+    CHECK(CANFD_FltrInit(&s_sFltr, s_au32Hash, 0, s_asSwRange, 4, s_au32Work, sizeof(s_au32Work) / 4) == CANFD_OK,
+          "hash set size 0 refused");
+    CHECK(CANFD_FltrInit(&s_sFltr, s_au32Hash, 3, s_asSwRange, 4, s_au32Work, sizeof(s_au32Work) / 4) == CANFD_ERR_FLTR_PARAM,
+          "hash set size 3 accepted");
+    CHECK(CANFD_FltrInit(&s_sFltr, s_au32Hash, 1000, s_asSwRange, 4, s_au32Work, sizeof(s_au32Work) / 4) == CANFD_ERR_FLTR_PARAM,
+          "hash set size 1000 accepted");
+    CHECK(CANFD_FltrInit(&s_sFltr, NULL, 64, s_asSwRange, 4, s_au32Work, sizeof(s_au32Work) / 4) == CANFD_ERR_FLTR_PARAM,
+          "hash set without storage accepted");
+
+    /* more scattered single IDs than two dual ID elements hold: the rest needs the hash set */
+    for (i = 0; i < 8; i++)
+        AddId(asList, &u32Cnt, au32Id[i], au32Id[i]);
+
+    OpenNodes(2, 2);
+    CANFD_FltrInit(&s_sFltr, NULL, 0, s_asSwRange, 4, s_au32Work, sizeof(s_au32Work) / 4);
+    i32Ret = CANFD_FltrCompile(CANFD1, &s_sFltr, eCANFD_SID, asList, u32Cnt);
+    printf("  no hash set, %u single IDs on 2 elements: %d\n", u32Cnt, i32Ret);
+    CHECK(i32Ret == CANFD_ERR_FLTR_FULL, "CANFD_FltrCompile() without hash set returned %d", i32Ret);
+    CHECK(s_sFltr.u32HashCnt == 0, "IDs hashed without hash set");
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (CANFD_SimInit() != CANFD_SIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    uint64_t u64T0;
+    uint32_t i, u32Id, u32Expected = 0;
+    int32_t i32Ret;
+
+    if (HOSTSIM_TestBegin("CAN acceptance filter compiler", SimInit) != 0)
+        return 1;
+
+    BuildLists();
+    OpenNodes(CANFD_MAX_11_BIT_FTR_ELEMS, CANFD_MAX_29_BIT_FTR_ELEMS);
+
+    if (CANFD_FltrInit(&s_sFltr, s_au32Hash, sizeof(s_au32Hash) / 4, s_asSwRange, sizeof(s_asSwRange) / sizeof(s_asSwRange[0]),
+                       s_au32Work, sizeof(s_au32Work) / 4) != CANFD_OK)
+    {
+        printf("CANFD_FltrInit() failed\n");
+        return 1;
+    }
+
+    printf("\n[Compile] CANFD1: %u standard / %u extended filter elements\n", CANFD_MAX_11_BIT_FTR_ELEMS, CANFD_MAX_29_BIT_FTR_ELEMS);
+
+    u64T0 = HOSTSIM_GetNanoSec();
+    i32Ret = CANFD_FltrCompile(CANFD1, &s_sFltr, eCANFD_SID, s_asSidList, s_u32SidCnt);
+    PrintReport("standard IDs", &s_sFltr.asReport[eCANFD_SID], s_u32SidCnt, HOSTSIM_GetNanoSec() - u64T0);
+
+    if (i32Ret != CANFD_OK)
+    {
+        printf("  FAIL: CANFD_FltrCompile(SID) returned %d\n", i32Ret);
+        s_u32Errors++;
+    }
+
+    u64T0 = HOSTSIM_GetNanoSec();
+    i32Ret = CANFD_FltrCompile(CANFD1, &s_sFltr, eCANFD_XID, s_asXidList, s_u32XidCnt);
+    PrintReport("J1939 extended IDs", &s_sFltr.asReport[eCANFD_XID], s_u32XidCnt, HOSTSIM_GetNanoSec() - u64T0);
+
+    if (i32Ret != CANFD_OK)
+    {
+        printf("  FAIL: CANFD_FltrCompile(XID) returned %d\n", i32Ret);
+        s_u32Errors++;
+    }
+
+    printf("    software filter: %u hashed IDs, %u ranges\n", s_sFltr.u32HashCnt, s_sFltr.u32RangeCnt);
+    printf("    message RAM layout errors: %u\n", CANFD_SimCheckRamLayout(CANFD1));
+
+    CANFD_RunToNormal(CANFD0, TRUE);
+    CANFD_RunToNormal(CANFD1, TRUE);
+
+    /* every standard ID */
+    printf("\n[Verify] all 2048 standard IDs and %u extended IDs through the simulated bus\n", XID_TEST_FRAMES);
+
+    for (u32Id = 0; u32Id <= 0x7FF; u32Id++)
+    {
+        u32Expected += IsListed(s_asSidRef, s_u32SidCnt, u32Id);
+        SendAndCheck(eCANFD_SID, u32Id, IsListed(s_asSidRef, s_u32SidCnt, u32Id));
+    }
+
+    /* extended IDs: half picked from the list, half random */
+    for (i = 0; i < XID_TEST_FRAMES; i++)
+    {
+        if (i & 1)
+        {
+            u32Id = ((uint32_t)rand() << 8 ^ (uint32_t)rand()) & 0x1FFFFFFF;
+        }
+        else
+        {
+            const CANFD_ID_RANGE_T *psRef = &s_asXidRef[(uint32_t)rand() % s_u32XidCnt];
+            u32Id = psRef->u32IdLow + (uint32_t)rand() % (psRef->u32IdHigh - psRef->u32IdLow + 1);
+        }
+
+        u32Expected += IsListed(s_asXidRef, s_u32XidCnt, u32Id);
+        SendAndCheck(eCANFD_XID, u32Id, IsListed(s_asXidRef, s_u32XidCnt, u32Id));
+    }
+
+    printf("  frames sent            : %u (%u in the acceptance list)\n", 0x800 + XID_TEST_FRAMES, u32Expected);
+    printf("  rejected by elements   : %u\n", s_u32HwRejected);
+    printf("  accepted by elements   : %u\n", s_sFltr.u32HwAccepted);
+    printf("  accepted by software   : %u\n", s_sFltr.u32SwAccepted);
+    printf("  rejected by software   : %u\n", s_sFltr.u32SwRejected);
+    printf("  CANFD_FltrCheck()      : %.1f ns per frame on this host\n", (double)s_u64CheckNs / (s_u32CheckCnt ? s_u32CheckCnt : 1));
+
+    if (s_u32Delivered != u32Expected)
+        s_u32Errors++;
+
+    TestCubeRanges();
+    TestHashSize();
+
+    return HOSTSIM_TestEnd();
+}
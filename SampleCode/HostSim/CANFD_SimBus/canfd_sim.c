@@ -0,0 +1,1072 @@
+/**************************************************************************//**
+ * @file     canfd_sim.c
+ * @version  V1.00
+ * @brief    Host-side M_CAN register and message RAM model with a virtual bus.
+ *
+ * @details  Each attached CANFD0~3 instance gets its register block and message
+ *           RAM mapped at the real address, so canfd.c runs unmodified. Stores
+ *           into the register page are trapped to emulate the side effects the
+ *           driver relies on (TXBAR, TXBCR, RXFnA, TXEFA and the write-1-to-clear
+ *           IR/NDATn). CANFD_SimStep() runs one bus cycle: arbitration between
+ *           all pending Tx buffers, acceptance filtering (SIDFC/XIDFC/GFC/XIDAM)
+ *           and storage into Rx FIFO 0/1 or dedicated Rx buffers of every node.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "hostsim.h"
+#include "canfd_sim.h"
+
+#define CANFD_SIM_WINDOW_SIZE   0x4000ul
+#define CANFD_SIM_REG_SIZE      0x200ul
+#define CANFD_SIM_OFS(reg)      ((uint32_t)offsetof(CANFD_T, reg))
+
+/* Element word fields shared by Tx buffers, Rx buffers and Rx FIFOs */
+#define SIM_E0_ESI      (1ul << 31)
+#define SIM_E0_XTD      (1ul << 30)
+#define SIM_E0_RTR      (1ul << 29)
+#define SIM_E1_FDF      (1ul << 21)
+#define SIM_E1_BRS      (1ul << 20)
+#define SIM_E1_DLC_Pos  16
+#define SIM_T1_EFC      (1ul << 23)
+#define SIM_R1_ANMF     (1ul << 31)
+#define SIM_R1_FIDX_Pos 24
+
+/* Destination chosen by acceptance filtering */
+#define SIM_DST_REJECT  0
+#define SIM_DST_FIFO0   1
+#define SIM_DST_FIFO1   2
+#define SIM_DST_DBUF    3
+#define SIM_DST_NONE    4   /* matched, priority only */
+
+typedef struct
+{
+    uint32_t u32R0;
+    uint32_t u32R1;
+    uint32_t u32Len;
+    uint8_t  au8Data[CANFD_MAX_MESSAGE_BYTES];
+} CANFD_SIM_FRAME_T;
+
+typedef struct
+{
+    CANFD_T *psCanfd;
+    uint32_t u32Idx;
+    uint32_t u32Attached;
+    uint32_t u32Trapped;
+    uint32_t au32FifoFill[2];
+    uint32_t au32FifoGet[2];
+    uint32_t au32FifoPut[2];
+    uint32_t u32TefFill;
+    uint32_t u32TefGet;
+    uint32_t u32TefPut;
+    CANFD_SIM_IRQ_CB pfnIrq;
+    CANFD_SIM_STATS_T sStats;
+} CANFD_SIM_NODE_T;
+
+static CANFD_SIM_NODE_T s_asNode[CANFD_SIM_MAX_NODES];
+static uint64_t s_u64BusTimeNs;
+static uint32_t s_u32TimeStamp;
+
+static const uint8_t s_au8DlcToLen[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+static CANFD_SIM_NODE_T *CANFD_SimGetNode(CANFD_T *psCanfd)
+{
+    if (psCanfd == CANFD0) return &s_asNode[0];
+    else if (psCanfd == CANFD1) return &s_asNode[1];
+    else if (psCanfd == CANFD2) return &s_asNode[2];
+    else if (psCanfd == CANFD3) return &s_asNode[3];
+
+    return NULL;
+}
+
+static uint8_t *CANFD_SimRam(CANFD_SIM_NODE_T *psNode)
+{
+    return (uint8_t *)(uintptr_t)((uint32_t)(uintptr_t)psNode->psCanfd + CANFD_SIM_REG_SIZE);
+}
+
+/* Element size in words for a RXESC/TXESC data field size code */
+static uint32_t CANFD_SimElemWords(uint32_t u32Ds)
+{
+    return (u32Ds < 5) ? (u32Ds + 4) : (u32Ds * 4 - 10);
+}
+
+static uint32_t CANFD_SimTxBufMask(CANFD_T *psCanfd)
+{
+    uint32_t u32Num = ((psCanfd->TXBC & CANFD_TXBC_NDTB_Msk) >> CANFD_TXBC_NDTB_Pos) +
+                      ((psCanfd->TXBC & CANFD_TXBC_TFQS_Msk) >> CANFD_TXBC_TFQS_Pos);
+
+    return (u32Num >= 32) ? 0xFFFFFFFFul : ((1ul << u32Num) - 1);
+}
+
+static void CANFD_SimUpdateFifoStatus(CANFD_SIM_NODE_T *psNode, uint32_t u32Fifo)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Size = ((u32Fifo ? psCanfd->RXF1C : psCanfd->RXF0C) >> CANFD_RXF0C_F0S_Pos) & 0x7F;
+    volatile uint32_t *pu32Sts = u32Fifo ? &psCanfd->RXF1S : &psCanfd->RXF0S;
+
+    *pu32Sts = (*pu32Sts & CANFD_RXF0S_RF0L_Msk) |
+               (psNode->au32FifoFill[u32Fifo] << CANFD_RXF0S_F0FL_Pos) |
+               (psNode->au32FifoGet[u32Fifo] << CANFD_RXF0S_F0GI_Pos) |
+               (psNode->au32FifoPut[u32Fifo] << CANFD_RXF0S_F0PI_Pos) |
+               ((u32Size && (psNode->au32FifoFill[u32Fifo] == u32Size)) ? CANFD_RXF0S_F0F_Msk : 0);
+}
+
+static void CANFD_SimUpdateTefStatus(CANFD_SIM_NODE_T *psNode)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Size = (psCanfd->TXEFC & CANFD_TXEFC_EFS_Msk) >> CANFD_TXEFC_EFS_Pos;
+
+    psCanfd->TXEFS = (psCanfd->TXEFS & CANFD_TXEFS_TEFL_Msk) |
+                     (psNode->u32TefFill << CANFD_TXEFS_EFFL_Pos) |
+                     (psNode->u32TefGet << CANFD_TXEFS_EFGI_Pos) |
+                     (psNode->u32TefPut << CANFD_TXEFS_EFPI_Pos) |
+                     ((u32Size && (psNode->u32TefFill == u32Size)) ? CANFD_TXEFS_EFF_Msk : 0);
+}
+
+/* Acknowledge releases every element up to and including u32AckIdx */
+static void CANFD_SimFifoAck(CANFD_SIM_NODE_T *psNode, uint32_t u32Fifo, uint32_t u32AckIdx)
+{
+    uint32_t u32Size = ((u32Fifo ? psNode->psCanfd->RXF1C : psNode->psCanfd->RXF0C) >> CANFD_RXF0C_F0S_Pos) & 0x7F;
+    uint32_t u32Released;
+
+    if ((u32Size == 0) || (u32AckIdx >= u32Size) || (psNode->au32FifoFill[u32Fifo] == 0))
+        return;
+
+    u32Released = ((u32AckIdx + u32Size - psNode->au32FifoGet[u32Fifo]) % u32Size) + 1;
+
+    if (u32Released > psNode->au32FifoFill[u32Fifo])
+        return;
+
+    psNode->au32FifoFill[u32Fifo] -= u32Released;
+    psNode->au32FifoGet[u32Fifo] = (u32AckIdx + 1) % u32Size;
+    CANFD_SimUpdateFifoStatus(psNode, u32Fifo);
+}
+
+static void CANFD_SimTefAck(CANFD_SIM_NODE_T *psNode, uint32_t u32AckIdx)
+{
+    uint32_t u32Size = (psNode->psCanfd->TXEFC & CANFD_TXEFC_EFS_Msk) >> CANFD_TXEFC_EFS_Pos;
+    uint32_t u32Released;
+
+    if ((u32Size == 0) || (u32AckIdx >= u32Size) || (psNode->u32TefFill == 0))
+        return;
+
+    u32Released = ((u32AckIdx + u32Size - psNode->u32TefGet) % u32Size) + 1;
+
+    if (u32Released > psNode->u32TefFill)
+        return;
+
+    psNode->u32TefFill -= u32Released;
+    psNode->u32TefGet = (u32AckIdx + 1) % u32Size;
+    CANFD_SimUpdateTefStatus(psNode);
+}
+
+/* Register store side effects, called from the HostSim write trap */
+static uint32_t CANFD_SimWrite(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    CANFD_SIM_NODE_T *psNode = (CANFD_SIM_NODE_T *)pvPriv;
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Pend;
+
+    /* Message RAM sharing the first page has no side effects */
+    if (u32Offset >= CANFD_SIM_REG_SIZE)
+        return u32New;
+
+    if (u32Offset == CANFD_SIM_OFS(IR))
+    {
+        /* write 1 to clear, message lost status follows the interrupt flag */
+        if (u32New & CANFD_IR_RF0L_Msk) psCanfd->RXF0S &= ~CANFD_RXF0S_RF0L_Msk;
+
+        if (u32New & CANFD_IR_RF1L_Msk) psCanfd->RXF1S &= ~CANFD_RXF1S_RF1L_Msk;
+
+        if (u32New & CANFD_IR_TEFL_Msk) psCanfd->TXEFS &= ~CANFD_TXEFS_TEFL_Msk;
+
+        return u32Old & ~u32New;
+    }
+    else if ((u32Offset == CANFD_SIM_OFS(NDAT1)) || (u32Offset == CANFD_SIM_OFS(NDAT2)))
+    {
+        /* write 1 to clear */
+        return u32Old & ~u32New;
+    }
+    else if (u32Offset == CANFD_SIM_OFS(TXBAR))
+    {
+        if (!(psCanfd->CCCR & CANFD_CCCR_INIT_Msk))
+            psCanfd->TXBRP |= u32New & CANFD_SimTxBufMask(psCanfd);
+
+        return 0;
+    }
+    else if (u32Offset == CANFD_SIM_OFS(TXBCR))
+    {
+        /* the bus is idle between CANFD_SimStep() calls, so cancellation finishes at once */
+        u32Pend = u32New & psCanfd->TXBRP;
+        psCanfd->TXBRP &= ~u32Pend;
+        psCanfd->TXBCF |= u32Pend;
+
+        if (u32Pend & psCanfd->TXBCIE)
+            psCanfd->IR |= CANFD_IR_TCF_Msk;
+
+        return 0;
+    }
+    else if (u32Offset == CANFD_SIM_OFS(RXF0A))
+    {
+        CANFD_SimFifoAck(psNode, 0, u32New & 0x3F);
+    }
+    else if (u32Offset == CANFD_SIM_OFS(RXF1A))
+    {
+        CANFD_SimFifoAck(psNode, 1, u32New & 0x3F);
+    }
+    else if (u32Offset == CANFD_SIM_OFS(TXEFA))
+    {
+        CANFD_SimTefAck(psNode, u32New & 0x1F);
+    }
+    else if (u32Offset == CANFD_SIM_OFS(CCCR))
+    {
+        /* CCE can only be set while INIT is set */
+        if (!(u32New & CANFD_CCCR_INIT_Msk))
+            u32New &= ~CANFD_CCCR_CCE_Msk;
+    }
+
+    return u32New;
+}
+
+static void CANFD_SimLockAll(uint32_t u32Lock)
+{
+    uint32_t i;
+
+    for (i = 0; i < CANFD_SIM_MAX_NODES; i++)
+    {
+        if (!s_asNode[i].u32Attached) continue;
+
+        if (u32Lock)
+            HOSTSIM_Lock((uint32_t)(uintptr_t)s_asNode[i].psCanfd);
+        else
+            HOSTSIM_Unlock((uint32_t)(uintptr_t)s_asNode[i].psCanfd);
+    }
+}
+
+/**
+ * @brief       Map the CANFD0~3 address windows.
+ *
+ * @retval      CANFD_SIM_OK       All windows mapped.
+ * @retval      CANFD_SIM_ERR_MAP  HostSim could not map a window.
+ *
+ * @details     HOSTSIM_Init() must have been called before.
+ */
+int32_t CANFD_SimInit(void)
+{
+    if ((HOSTSIM_MapPeriph(CANFD0_BASE, CANFD_SIM_WINDOW_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(CANFD1_BASE, CANFD_SIM_WINDOW_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(CANFD2_BASE, CANFD_SIM_WINDOW_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(CANFD3_BASE, CANFD_SIM_WINDOW_SIZE) != HOSTSIM_OK))
+        return CANFD_SIM_ERR_MAP;
+
+    memset(s_asNode, 0, sizeof(s_asNode));
+    s_u64BusTimeNs = 0;
+
+    return CANFD_SIM_OK;
+}
+
+/**
+ * @brief       Reset a CAN FD instance and connect it to the virtual bus.
+ *
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ *
+ * @retval      CANFD_SIM_OK        Instance attached in INIT state.
+ * @retval      CANFD_SIM_ERR_NODE  Unknown instance.
+ */
+int32_t CANFD_SimAttach(CANFD_T *psCanfd)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+    uint32_t u32Trapped;
+
+    if (psNode == NULL)
+        return CANFD_SIM_ERR_NODE;
+
+    u32Trapped = psNode->u32Trapped;
+
+    if (u32Trapped)
+        HOSTSIM_Unlock((uint32_t)(uintptr_t)psCanfd);
+
+    memset(psNode, 0, sizeof(CANFD_SIM_NODE_T));
+    psNode->psCanfd = psCanfd;
+    psNode->u32Idx = (uint32_t)(psNode - s_asNode);
+
+    /* register reset values */
+    memset((void *)psCanfd, 0, CANFD_SIM_REG_SIZE + CANFD_SRAM_SIZE);
+    psCanfd->CCCR = CANFD_CCCR_INIT_Msk;
+    psCanfd->NBTP = 0x06000A03ul;
+    psCanfd->DBTP = 0x00000A33ul;
+    psCanfd->XIDAM = 0x1FFFFFFFul;
+
+    if (u32Trapped)
+        HOSTSIM_Lock((uint32_t)(uintptr_t)psCanfd);
+    else if (HOSTSIM_TrapWrites((uint32_t)(uintptr_t)psCanfd, HOSTSIM_PAGE_SIZE, CANFD_SimWrite, psNode) != HOSTSIM_OK)
+        return CANFD_SIM_ERR_MAP;
+
+    psNode->u32Trapped = 1;
+    psNode->u32Attached = 1;
+
+    return CANFD_SIM_OK;
+}
+
+/**
+ * @brief       Install the interrupt routine called after each bus cycle.
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ * @param[in]   pfnIrq      Callback, NULL to poll only.
+ */
+void CANFD_SimSetIrqHandler(CANFD_T *psCanfd, CANFD_SIM_IRQ_CB pfnIrq)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+
+    if (psNode) psNode->pfnIrq = pfnIrq;
+}
+
+/**
+ * @brief       Decode the programmed bit timing.
+ *
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ * @param[out]  psTiming    Decoded nominal/data bit rates and sample points.
+ *
+ * @details     The CAN FD clock is SystemCoreClock divided by the CLKDIV5 CANFDnDIV field.
+ */
+void CANFD_SimGetTiming(CANFD_T *psCanfd, CANFD_SIM_TIMING_T *psTiming)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+    uint32_t u32Clk, u32Brp, u32Tq, u32Seg1;
+
+    memset(psTiming, 0, sizeof(CANFD_SIM_TIMING_T));
+
+    if (psNode == NULL) return;
+
+    u32Clk = SystemCoreClock / (((CLK->CLKDIV5 >> (psNode->u32Idx * 4)) & 0xF) + 1);
+
+    u32Brp = ((psCanfd->NBTP >> 16) & 0x1FF) + 1;
+    u32Seg1 = ((psCanfd->NBTP >> 8) & 0xFF) + 1;
+    u32Tq = 1 + u32Seg1 + (psCanfd->NBTP & 0x7F) + 1;
+    psTiming->u32NominalBitRate = u32Clk / (u32Brp * u32Tq);
+    psTiming->u32NominalSP = (1 + u32Seg1) * 1000 / u32Tq;
+
+    if ((psCanfd->CCCR & CANFD_CCCR_FDOE_Msk) && (psCanfd->CCCR & CANFD_CCCR_BRSE_Msk))
+    {
+        u32Brp = ((psCanfd->DBTP >> 16) & 0x1F) + 1;
+        u32Seg1 = ((psCanfd->DBTP >> 8) & 0x1F) + 1;
+        u32Tq = 1 + u32Seg1 + ((psCanfd->DBTP >> 4) & 0xF) + 1;
+        psTiming->u32DataBitRate = u32Clk / (u32Brp * u32Tq);
+        psTiming->u32DataSP = (1 + u32Seg1) * 1000 / u32Tq;
+    }
+}
+
+static uint32_t CANFD_SimRateDiffers(uint32_t u32A, uint32_t u32B)
+{
+    uint32_t u32Diff = (u32A > u32B) ? (u32A - u32B) : (u32B - u32A);
+
+    /* more than 1% apart cannot sample reliably */
+    return (u32Diff * 100 > u32B);
+}
+
+/* Nominal bus time of a frame; bit stuffing is not modelled */
+static uint64_t CANFD_SimFrameTimeNs(const CANFD_SIM_TIMING_T *psTiming, const CANFD_SIM_FRAME_T *psFrame)
+{
+    uint32_t u32Xtd = (psFrame->u32R0 & SIM_E0_XTD) ? 1 : 0;
+    uint32_t u32Len = (psFrame->u32R0 & SIM_E0_RTR) ? 0 : psFrame->u32Len;
+    uint32_t u32Arb, u32Data;
+    const uint32_t u32Tail = 13; /* CRC delimiter, ACK, ACK delimiter, EOF, IFS */
+
+    if (psTiming->u32NominalBitRate == 0)
+        return 0;
+
+    if (!(psFrame->u32R1 & SIM_E1_FDF))
+        return (uint64_t)((u32Xtd ? 67 : 47) + 8 * u32Len) * 1000000000ull / psTiming->u32NominalBitRate;
+
+    u32Arb = 17 + (u32Xtd ? 19 : 0);
+    u32Data = 1 + 4 + 8 * u32Len + ((u32Len <= 16) ? 17 : 21) + 4;
+
+    if ((psFrame->u32R1 & SIM_E1_BRS) && psTiming->u32DataBitRate)
+        return (uint64_t)(u32Arb + u32Tail) * 1000000000ull / psTiming->u32NominalBitRate +
+               (uint64_t)u32Data * 1000000000ull / psTiming->u32DataBitRate;
+
+    return (uint64_t)(u32Arb + u32Data + u32Tail) * 1000000000ull / psTiming->u32NominalBitRate;
+}
+
+/* Arbitration key: lower wins. Base ID first, then IDE, then extension, then RTR. */
+static uint32_t CANFD_SimArbKey(uint32_t u32R0)
+{
+    uint32_t u32Rtr = (u32R0 & SIM_E0_RTR) ? 1 : 0;
+
+    if (u32R0 & SIM_E0_XTD)
+        return (((u32R0 >> 18) & 0x7FF) << 20) | (1ul << 19) | ((u32R0 & 0x3FFFF) << 1) | u32Rtr;
+
+    return (((u32R0 >> 18) & 0x7FF) << 20) | u32Rtr;
+}
+
+static volatile uint32_t *CANFD_SimTxElem(CANFD_SIM_NODE_T *psNode, uint32_t u32BufIdx)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Words = CANFD_SimElemWords((psCanfd->TXESC & CANFD_TXESC_TBDS_Msk) >> CANFD_TXESC_TBDS_Pos);
+
+    return (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->TXBC & CANFD_TXBC_TBSA_Msk) + u32BufIdx * u32Words * 4);
+}
+
+/* Highest priority pending Tx buffer of a node, -1 if none */
+static int32_t CANFD_SimPickTxBuf(CANFD_SIM_NODE_T *psNode, uint32_t *pu32Key)
+{
+    uint32_t u32Pend = psNode->psCanfd->TXBRP;
+    uint32_t i, u32Key;
+    int32_t i32Best = -1;
+
+    for (i = 0; u32Pend; i++, u32Pend >>= 1)
+    {
+        if (!(u32Pend & 1)) continue;
+
+        u32Key = CANFD_SimArbKey(CANFD_SimTxElem(psNode, i)[0]);
+
+        if ((i32Best < 0) || (u32Key < *pu32Key))
+        {
+            i32Best = (int32_t)i;
+            *pu32Key = u32Key;
+        }
+    }
+
+    return i32Best;
+}
+
+static uint32_t CANFD_SimFilterStd(CANFD_SIM_NODE_T *psNode, const CANFD_SIM_FRAME_T *psFrame, uint32_t *pu32Fidx, uint32_t *pu32DBuf)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    volatile uint32_t *pu32Flt = (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->SIDFC & CANFD_SIDFC_FLSSA_Msk));
+    uint32_t u32Num = (psCanfd->SIDFC & CANFD_SIDFC_LSS_Msk) >> CANFD_SIDFC_LSS_Pos;
+    uint32_t u32Id = (psFrame->u32R0 >> 18) & 0x7FF;
+    uint32_t i, u32Elem, u32Sft, u32Sfec, u32Id1, u32Id2, u32Match;
+
+    if ((psFrame->u32R0 & SIM_E0_RTR) && (psCanfd->GFC & CANFD_GFC_RRFS_Msk))
+        return SIM_DST_REJECT;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        u32Elem = pu32Flt[i];
+        u32Sft = u32Elem >> 30;
+        u32Sfec = (u32Elem >> 27) & 0x7;
+        u32Id1 = (u32Elem >> 16) & 0x7FF;
+        u32Id2 = u32Elem & 0x7FF;
+
+        if (u32Sfec == 0) continue;
+
+        if (u32Sfec == 7)
+            u32Match = (u32Id == u32Id1);
+        else if (u32Sft == 0)
+            u32Match = (u32Id >= u32Id1) && (u32Id <= u32Id2);
+        else if (u32Sft == 1)
+            u32Match = (u32Id == u32Id1) || (u32Id == u32Id2);
+        else if (u32Sft == 2)
+            u32Match = ((u32Id & u32Id2) == (u32Id1 & u32Id2));
+        else
+            u32Match = 0;
+
+        if (!u32Match) continue;
+
+        *pu32Fidx = i;
+
+        switch (u32Sfec)
+        {
+            case 1:
+            case 5:
+                return SIM_DST_FIFO0;
+
+            case 2:
+            case 6:
+                return SIM_DST_FIFO1;
+
+            case 3:
+                return SIM_DST_REJECT;
+
+            case 7:
+                /* SFID2[10:9] = 00b stores into Rx buffer SFID2[5:0], debug messages are not modelled */
+                *pu32DBuf = u32Id2 & 0x3F;
+                return ((u32Id2 >> 9) & 0x3) ? SIM_DST_REJECT : SIM_DST_DBUF;
+
+            default:
+                return SIM_DST_NONE;
+        }
+    }
+
+    *pu32Fidx = 0xFF;
+
+    switch ((psCanfd->GFC & CANFD_GFC_ANFS_Msk) >> CANFD_GFC_ANFS_Pos)
+    {
+        case 0:
+            return SIM_DST_FIFO0;
+
+        case 1:
+            return SIM_DST_FIFO1;
+
+        default:
+            return SIM_DST_REJECT;
+    }
+}
+
+static uint32_t CANFD_SimFilterExt(CANFD_SIM_NODE_T *psNode, const CANFD_SIM_FRAME_T *psFrame, uint32_t *pu32Fidx, uint32_t *pu32DBuf)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    volatile uint32_t *pu32Flt = (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->XIDFC & CANFD_XIDFC_FLESA_Msk));
+    uint32_t u32Num = (psCanfd->XIDFC & CANFD_XIDFC_LSE_Msk) >> CANFD_XIDFC_LSE_Pos;
+    uint32_t u32RawId = psFrame->u32R0 & 0x1FFFFFFF;
+    uint32_t u32Id = u32RawId & psCanfd->XIDAM;
+    uint32_t i, u32Eft, u32Efec, u32Id1, u32Id2, u32Match;
+
+    if ((psFrame->u32R0 & SIM_E0_RTR) && (psCanfd->GFC & CANFD_GFC_RRFE_Msk))
+        return SIM_DST_REJECT;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        u32Efec = pu32Flt[i * 2] >> 29;
+        u32Id1 = pu32Flt[i * 2] & 0x1FFFFFFF;
+        u32Eft = pu32Flt[i * 2 + 1] >> 30;
+        u32Id2 = pu32Flt[i * 2 + 1] & 0x1FFFFFFF;
+
+        if (u32Efec == 0) continue;
+
+        if (u32Efec == 7)
+            u32Match = (u32Id == u32Id1);
+        else if (u32Eft == 0)
+            u32Match = (u32Id >= u32Id1) && (u32Id <= u32Id2);
+        else if (u32Eft == 1)
+            u32Match = (u32Id == u32Id1) || (u32Id == u32Id2);
+        else if (u32Eft == 2)
+            u32Match = ((u32Id & u32Id2) == (u32Id1 & u32Id2));
+        else
+            u32Match = (u32RawId >= u32Id1) && (u32RawId <= u32Id2);
+
+        if (!u32Match) continue;
+
+        *pu32Fidx = i;
+
+        switch (u32Efec)
+        {
+            case 1:
+            case 5:
+                return SIM_DST_FIFO0;
+
+            case 2:
+            case 6:
+                return SIM_DST_FIFO1;
+
+            case 3:
+                return SIM_DST_REJECT;
+
+            case 7:
+                *pu32DBuf = u32Id2 & 0x3F;
+                return ((u32Id2 >> 9) & 0x3) ? SIM_DST_REJECT : SIM_DST_DBUF;
+
+            default:
+                return SIM_DST_NONE;
+        }
+    }
+
+    *pu32Fidx = 0x7F;
+
+    switch ((psCanfd->GFC & CANFD_GFC_ANFE_Msk) >> CANFD_GFC_ANFE_Pos)
+    {
+        case 0:
+            return SIM_DST_FIFO0;
+
+        case 1:
+            return SIM_DST_FIFO1;
+
+        default:
+            return SIM_DST_REJECT;
+    }
+}
+
+static void CANFD_SimWriteElem(volatile uint32_t *pu32Elem, uint32_t u32Words, const CANFD_SIM_FRAME_T *psFrame, uint32_t u32R1)
+{
+    uint32_t u32Bytes = psFrame->u32Len;
+    uint32_t au32Data[CANFD_MAX_MESSAGE_WORDS];
+    uint32_t i;
+
+    /* data that does not fit the configured element size is truncated */
+    if (u32Bytes > (u32Words - 2) * 4)
+        u32Bytes = (u32Words - 2) * 4;
+
+    memset(au32Data, 0, sizeof(au32Data));
+    memcpy(au32Data, psFrame->au8Data, u32Bytes);
+
+    pu32Elem[0] = psFrame->u32R0;
+    pu32Elem[1] = u32R1;
+
+    for (i = 0; i < (u32Bytes + 3) / 4; i++)
+        pu32Elem[2 + i] = au32Data[i];
+}
+
+static void CANFD_SimStoreFifo(CANFD_SIM_NODE_T *psNode, uint32_t u32Fifo, const CANFD_SIM_FRAME_T *psFrame, uint32_t u32R1)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Cfg = u32Fifo ? psCanfd->RXF1C : psCanfd->RXF0C;
+    uint32_t u32Size = (u32Cfg >> CANFD_RXF0C_F0S_Pos) & 0x7F;
+    uint32_t u32Wm = (u32Cfg >> CANFD_RXF0C_F0WM_Pos) & 0x7F;
+    uint32_t u32Ds = u32Fifo ? ((psCanfd->RXESC & CANFD_RXESC_F1DS_Msk) >> CANFD_RXESC_F1DS_Pos)
+                     : ((psCanfd->RXESC & CANFD_RXESC_F0DS_Msk) >> CANFD_RXESC_F0DS_Pos);
+    uint32_t u32Words = CANFD_SimElemWords(u32Ds);
+    uint32_t u32Shift = u32Fifo ? 4 : 0;    /* IR RF1x flags sit 4 bits above RF0x */
+
+    if (u32Size == 0)
+    {
+        psNode->sStats.u32Rejected++;
+        return;
+    }
+
+    if (psNode->au32FifoFill[u32Fifo] == u32Size)
+    {
+        if (!(u32Cfg & CANFD_RXF0C_F0OM_Msk))
+        {
+            /* blocking mode: new message is lost */
+            psNode->sStats.u32FifoLost++;
+            psCanfd->IR |= (CANFD_IR_RF0L_Msk << u32Shift);
+            *(u32Fifo ? &psCanfd->RXF1S : &psCanfd->RXF0S) |= CANFD_RXF0S_RF0L_Msk;
+            return;
+        }
+
+        /* overwrite mode: drop the oldest element */
+        psNode->au32FifoGet[u32Fifo] = (psNode->au32FifoGet[u32Fifo] + 1) % u32Size;
+        psNode->au32FifoFill[u32Fifo]--;
+    }
+
+    CANFD_SimWriteElem((volatile uint32_t *)(CANFD_SimRam(psNode) + (u32Cfg & CANFD_RXF0C_F0SA_Msk) +
+                                             psNode->au32FifoPut[u32Fifo] * u32Words * 4), u32Words, psFrame, u32R1);
+
+    psNode->au32FifoPut[u32Fifo] = (psNode->au32FifoPut[u32Fifo] + 1) % u32Size;
+    psNode->au32FifoFill[u32Fifo]++;
+
+    psCanfd->IR |= (CANFD_IR_RF0N_Msk << u32Shift);
+
+    if (u32Wm && (psNode->au32FifoFill[u32Fifo] >= u32Wm))
+        psCanfd->IR |= (CANFD_IR_RF0W_Msk << u32Shift);
+
+    if (psNode->au32FifoFill[u32Fifo] == u32Size)
+        psCanfd->IR |= (CANFD_IR_RF0F_Msk << u32Shift);
+
+    if (u32Fifo)
+        psNode->sStats.u32RxFifo1++;
+    else
+        psNode->sStats.u32RxFifo0++;
+
+    CANFD_SimUpdateFifoStatus(psNode, u32Fifo);
+}
+
+static void CANFD_SimStoreDBuf(CANFD_SIM_NODE_T *psNode, uint32_t u32BufIdx, const CANFD_SIM_FRAME_T *psFrame, uint32_t u32R1)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    volatile uint32_t *pu32Ndat = (u32BufIdx < 32) ? &psCanfd->NDAT1 : &psCanfd->NDAT2;
+    uint32_t u32Bit = 1ul << (u32BufIdx & 0x1F);
+    uint32_t u32Words = CANFD_SimElemWords((psCanfd->RXESC & CANFD_RXESC_RBDS_Msk) >> CANFD_RXESC_RBDS_Pos);
+
+    /* a buffer is locked against updates while its NDAT flag is set */
+    if (*pu32Ndat & u32Bit)
+    {
+        psNode->sStats.u32DBufLocked++;
+        return;
+    }
+
+    CANFD_SimWriteElem((volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->RXBC & CANFD_RXBC_RBSA_Msk) +
+                                             u32BufIdx * u32Words * 4), u32Words, psFrame, u32R1);
+    *pu32Ndat |= u32Bit;
+    psCanfd->IR |= CANFD_IR_DRX_Msk;
+    psNode->sStats.u32RxDBuf++;
+}
+
+static void CANFD_SimReceive(CANFD_SIM_NODE_T *psNode, const CANFD_SIM_FRAME_T *psFrame)
+{
+    uint32_t u32Fidx = 0, u32DBuf = 0, u32Dst, u32R1;
+
+    if (psFrame->u32R0 & SIM_E0_XTD)
+        u32Dst = CANFD_SimFilterExt(psNode, psFrame, &u32Fidx, &u32DBuf);
+    else
+        u32Dst = CANFD_SimFilterStd(psNode, psFrame, &u32Fidx, &u32DBuf);
+
+    u32R1 = (s_u32TimeStamp & 0xFFFF) | (psFrame->u32R1 & (SIM_E1_FDF | SIM_E1_BRS | (0xFul << SIM_E1_DLC_Pos)));
+
+    if ((u32Fidx == 0xFF) || (u32Fidx == 0x7F))
+        u32R1 |= SIM_R1_ANMF;
+    else
+        u32R1 |= (u32Fidx & 0x7F) << SIM_R1_FIDX_Pos;
+
+    switch (u32Dst)
+    {
+        case SIM_DST_FIFO0:
+            CANFD_SimStoreFifo(psNode, 0, psFrame, u32R1);
+            break;
+
+        case SIM_DST_FIFO1:
+            CANFD_SimStoreFifo(psNode, 1, psFrame, u32R1);
+            break;
+
+        case SIM_DST_DBUF:
+            CANFD_SimStoreDBuf(psNode, u32DBuf, psFrame, u32R1);
+            break;
+
+        case SIM_DST_NONE:
+            break;
+
+        default:
+            psNode->sStats.u32Rejected++;
+            break;
+    }
+}
+
+static void CANFD_SimTxDone(CANFD_SIM_NODE_T *psNode, uint32_t u32BufIdx, const CANFD_SIM_FRAME_T *psFrame)
+{
+    CANFD_T *psCanfd = psNode->psCanfd;
+    uint32_t u32Bit = 1ul << u32BufIdx;
+    uint32_t u32Size = (psCanfd->TXEFC & CANFD_TXEFC_EFS_Msk) >> CANFD_TXEFC_EFS_Pos;
+    volatile uint32_t *pu32Evt;
+
+    psCanfd->TXBRP &= ~u32Bit;
+    psCanfd->TXBTO |= u32Bit;
+
+    if (psCanfd->TXBTIE & u32Bit)
+        psCanfd->IR |= CANFD_IR_TC_Msk;
+
+    psNode->sStats.u32TxFrames++;
+
+    if (!(psFrame->u32R1 & SIM_T1_EFC) || (u32Size == 0))
+        return;
+
+    if (psNode->u32TefFill == u32Size)
+    {
+        psCanfd->IR |= CANFD_IR_TEFL_Msk;
+        psCanfd->TXEFS |= CANFD_TXEFS_TEFL_Msk;
+        return;
+    }
+
+    pu32Evt = (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->TXEFC & CANFD_TXEFC_EFSA_Msk) + psNode->u32TefPut * 8);
+    pu32Evt[0] = psFrame->u32R0;
+    /* E1: MM, ET = 01b (Tx event), FDF, BRS, DLC, TXTS */
+    pu32Evt[1] = (psFrame->u32R1 & 0xFF000000ul) | (1ul << 22) | (psFrame->u32R1 & (SIM_E1_FDF | SIM_E1_BRS | (0xFul << SIM_E1_DLC_Pos))) |
+                 (s_u32TimeStamp & 0xFFFF);
+
+    psNode->u32TefPut = (psNode->u32TefPut + 1) % u32Size;
+    psNode->u32TefFill++;
+    psCanfd->IR |= CANFD_IR_TEFN_Msk;
+
+    if (psNode->u32TefFill == u32Size)
+        psCanfd->IR |= CANFD_IR_TEFF_Msk;
+
+    CANFD_SimUpdateTefStatus(psNode);
+}
+
+static void CANFD_SimDispatchIrq(void)
+{
+    CANFD_SIM_NODE_T *psNode;
+    uint32_t i, u32Pend;
+
+    for (i = 0; i < CANFD_SIM_MAX_NODES; i++)
+    {
+        psNode = &s_asNode[i];
+
+        if (!psNode->u32Attached || (psNode->pfnIrq == NULL)) continue;
+
+        u32Pend = psNode->psCanfd->IR & psNode->psCanfd->IE;
+
+        if ((u32Pend & ~psNode->psCanfd->ILS) && (psNode->psCanfd->ILE & 0x1))
+            psNode->pfnIrq(psNode->psCanfd, 0);
+
+        u32Pend = psNode->psCanfd->IR & psNode->psCanfd->IE;
+
+        if ((u32Pend & psNode->psCanfd->ILS) && (psNode->psCanfd->ILE & 0x2))
+            psNode->pfnIrq(psNode->psCanfd, 1);
+    }
+}
+
+/**
+ * @brief       Run one bus cycle.
+ *
+ * @return      1 if a frame was transmitted, 0 if the bus stayed idle.
+ *
+ * @details     The pending Tx buffer with the lowest arbitration field over all
+ *              nodes in normal operation wins. It is acknowledged if at least one
+ *              other node runs at the same bit rates (or the sender is in loopback
+ *              mode); otherwise it stays pending and TEC is incremented. Interrupt
+ *              callbacks run after the cycle with register trapping re-armed.
+ */
+uint32_t CANFD_SimStep(void)
+{
+    CANFD_SIM_NODE_T *psTx = NULL, *psNode;
+    CANFD_SIM_TIMING_T sTxTiming, sRxTiming;
+    CANFD_SIM_FRAME_T sFrame;
+    volatile uint32_t *pu32Elem;
+    uint32_t i, u32Key, u32BestKey = 0xFFFFFFFFul, u32Acked = 0, u32Loopback;
+    int32_t i32Buf, i32TxBuf = -1;
+
+    for (i = 0; i < CANFD_SIM_MAX_NODES; i++)
+    {
+        psNode = &s_asNode[i];
+
+        if (!psNode->u32Attached || (psNode->psCanfd->CCCR & CANFD_CCCR_INIT_Msk)) continue;
+
+        i32Buf = CANFD_SimPickTxBuf(psNode, &u32Key);
+
+        if (i32Buf < 0) continue;
+
+        if (psTx) psTx->sStats.u32ArbLost++;
+
+        if ((psTx == NULL) || (u32Key < u32BestKey))
+        {
+            psTx = psNode;
+            i32TxBuf = i32Buf;
+            u32BestKey = u32Key;
+        }
+        else
+        {
+            psNode->sStats.u32ArbLost++;
+        }
+    }
+
+    if (psTx == NULL)
+        return 0;
+
+    CANFD_SimLockAll(0);
+
+    pu32Elem = CANFD_SimTxElem(psTx, (uint32_t)i32TxBuf);
+    sFrame.u32R0 = pu32Elem[0];
+    sFrame.u32R1 = pu32Elem[1];
+    sFrame.u32Len = s_au8DlcToLen[(sFrame.u32R1 >> SIM_E1_DLC_Pos) & 0xF];
+
+    if (!(sFrame.u32R1 & SIM_E1_FDF))
+    {
+        /* classic frames carry at most 8 bytes and never switch bit rate */
+        sFrame.u32R1 &= ~SIM_E1_BRS;
+
+        if (sFrame.u32Len > 8) sFrame.u32Len = 8;
+    }
+
+    for (i = 0; i < (sFrame.u32Len + 3) / 4; i++)
+        ((uint32_t *)sFrame.au8Data)[i] = pu32Elem[2 + i];
+
+    CANFD_SimGetTiming(psTx->psCanfd, &sTxTiming);
+    u32Loopback = (psTx->psCanfd->CCCR & CANFD_CCCR_TEST_Msk) && (psTx->psCanfd->TEST & CANFD_TEST_LBCK_Msk);
+
+    for (i = 0; i < CANFD_SIM_MAX_NODES; i++)
+    {
+        psNode = &s_asNode[i];
+
+        if (!psNode->u32Attached || (psNode->psCanfd->CCCR & CANFD_CCCR_INIT_Msk)) continue;
+
+        if ((psNode == psTx) && !u32Loopback) continue;
+
+        if (psNode != psTx)
+        {
+            CANFD_SimGetTiming(psNode->psCanfd, &sRxTiming);
+
+            if (CANFD_SimRateDiffers(sRxTiming.u32NominalBitRate, sTxTiming.u32NominalBitRate) ||
+                    ((sFrame.u32R1 & SIM_E1_BRS) && CANFD_SimRateDiffers(sRxTiming.u32DataBitRate, sTxTiming.u32DataBitRate)))
+            {
+                psNode->sStats.u32BitRateErr++;
+                continue;
+            }
+
+            if ((sFrame.u32R1 & SIM_E1_FDF) && !(psNode->psCanfd->CCCR & CANFD_CCCR_FDOE_Msk))
+            {
+                psNode->sStats.u32FormatErr++;
+                psNode->psCanfd->IR |= CANFD_IR_PEA_Msk;
+                continue;
+            }
+        }
+
+        /* every compatible node acknowledges, whether or not it accepts the frame */
+        u32Acked = 1;
+        CANFD_SimReceive(psNode, &sFrame);
+    }
+
+    if (u32Acked)
+    {
+        CANFD_SimTxDone(psTx, (uint32_t)i32TxBuf, &sFrame);
+    }
+    else
+    {
+        /* ACK error: the frame stays pending for automatic retransmission */
+        psTx->psCanfd->IR |= CANFD_IR_PEA_Msk;
+
+        if (((psTx->psCanfd->ECR & CANFD_ECR_TEC_Msk) >> CANFD_ECR_TEC_Pos) < 248)
+            *(volatile uint32_t *)&psTx->psCanfd->ECR += (8ul << CANFD_ECR_TEC_Pos);
+    }
+
+    s_u64BusTimeNs += CANFD_SimFrameTimeNs(&sTxTiming, &sFrame);
+    s_u32TimeStamp++;
+
+    CANFD_SimLockAll(1);
+    CANFD_SimDispatchIrq();
+
+    return 1;
+}
+
+/**
+ * @brief       Run bus cycles until the bus is idle.
+ * @param[in]   u32MaxFrames    Upper bound of bus cycles.
+ * @return      Number of bus cycles executed.
+ */
+uint32_t CANFD_SimRun(uint32_t u32MaxFrames)
+{
+    uint32_t u32Cnt = 0;
+
+    while ((u32Cnt < u32MaxFrames) && CANFD_SimStep())
+        u32Cnt++;
+
+    return u32Cnt;
+}
+
+static uint32_t CANFD_SimOverlap(uint32_t u32A, uint32_t u32ASize, uint32_t u32B, uint32_t u32BSize)
+{
+    if ((u32ASize == 0) || (u32BSize == 0))
+        return 0;
+
+    return (u32A < u32B + u32BSize) && (u32B < u32A + u32ASize);
+}
+
+/**
+ * @brief       Check the message RAM partition programmed into a node.
+ *
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ *
+ * @return      Number of sections that overlap another section or exceed CANFD_SRAM_SIZE.
+ *
+ * @details     The dedicated Rx buffer section is sized from the highest buffer
+ *              index referenced by a "store into Rx buffer" filter element.
+ */
+uint32_t CANFD_SimCheckRamLayout(CANFD_T *psCanfd)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+    uint32_t au32Start[7], au32Size[7];
+    uint32_t i, j, u32Err = 0, u32MaxBuf = 0, u32Num;
+    volatile uint32_t *pu32Flt;
+
+    if (psNode == NULL) return 1;
+
+    /* dedicated Rx buffers referenced by the filters */
+    pu32Flt = (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->SIDFC & CANFD_SIDFC_FLSSA_Msk));
+    u32Num = (psCanfd->SIDFC & CANFD_SIDFC_LSS_Msk) >> CANFD_SIDFC_LSS_Pos;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if ((((pu32Flt[i] >> 27) & 0x7) == 7) && ((pu32Flt[i] & 0x3F) + 1 > u32MaxBuf))
+            u32MaxBuf = (pu32Flt[i] & 0x3F) + 1;
+    }
+
+    pu32Flt = (volatile uint32_t *)(CANFD_SimRam(psNode) + (psCanfd->XIDFC & CANFD_XIDFC_FLESA_Msk));
+    u32Num = (psCanfd->XIDFC & CANFD_XIDFC_LSE_Msk) >> CANFD_XIDFC_LSE_Pos;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (((pu32Flt[i * 2] >> 29) == 7) && ((pu32Flt[i * 2 + 1] & 0x3F) + 1 > u32MaxBuf))
+            u32MaxBuf = (pu32Flt[i * 2 + 1] & 0x3F) + 1;
+    }
+
+    au32Start[0] = psCanfd->SIDFC & CANFD_SIDFC_FLSSA_Msk;
+    au32Size[0] = ((psCanfd->SIDFC & CANFD_SIDFC_LSS_Msk) >> CANFD_SIDFC_LSS_Pos) * 4;
+    au32Start[1] = psCanfd->XIDFC & CANFD_XIDFC_FLESA_Msk;
+    au32Size[1] = ((psCanfd->XIDFC & CANFD_XIDFC_LSE_Msk) >> CANFD_XIDFC_LSE_Pos) * 8;
+    au32Start[2] = psCanfd->RXF0C & CANFD_RXF0C_F0SA_Msk;
+    au32Size[2] = ((psCanfd->RXF0C & CANFD_RXF0C_F0S_Msk) >> CANFD_RXF0C_F0S_Pos) *
+                  CANFD_SimElemWords((psCanfd->RXESC & CANFD_RXESC_F0DS_Msk) >> CANFD_RXESC_F0DS_Pos) * 4;
+    au32Start[3] = psCanfd->RXF1C & CANFD_RXF1C_F1SA_Msk;
+    au32Size[3] = ((psCanfd->RXF1C & CANFD_RXF1C_F1S_Msk) >> CANFD_RXF1C_F1S_Pos) *
+                  CANFD_SimElemWords((psCanfd->RXESC & CANFD_RXESC_F1DS_Msk) >> CANFD_RXESC_F1DS_Pos) * 4;
+    au32Start[4] = psCanfd->RXBC & CANFD_RXBC_RBSA_Msk;
+    au32Size[4] = u32MaxBuf * CANFD_SimElemWords((psCanfd->RXESC & CANFD_RXESC_RBDS_Msk) >> CANFD_RXESC_RBDS_Pos) * 4;
+    au32Start[5] = psCanfd->TXEFC & CANFD_TXEFC_EFSA_Msk;
+    au32Size[5] = ((psCanfd->TXEFC & CANFD_TXEFC_EFS_Msk) >> CANFD_TXEFC_EFS_Pos) * 8;
+    au32Start[6] = psCanfd->TXBC & CANFD_TXBC_TBSA_Msk;
+    au32Size[6] = (((psCanfd->TXBC & CANFD_TXBC_NDTB_Msk) >> CANFD_TXBC_NDTB_Pos) + ((psCanfd->TXBC & CANFD_TXBC_TFQS_Msk) >> CANFD_TXBC_TFQS_Pos)) *
+                  CANFD_SimElemWords((psCanfd->TXESC & CANFD_TXESC_TBDS_Msk) >> CANFD_TXESC_TBDS_Pos) * 4;
+
+    for (i = 0; i < 7; i++)
+    {
+        if (au32Start[i] + au32Size[i] > CANFD_SRAM_SIZE)
+        {
+            u32Err++;
+            continue;
+        }
+
+        for (j = i + 1; j < 7; j++)
+        {
+            if (CANFD_SimOverlap(au32Start[i], au32Size[i], au32Start[j], au32Size[j]))
+            {
+                u32Err++;
+                break;
+            }
+        }
+    }
+
+    return u32Err;
+}
+
+/**
+ * @brief       Read the model counters of a node.
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ * @param[out]  psStats     Counters.
+ */
+void CANFD_SimGetStats(CANFD_T *psCanfd, CANFD_SIM_STATS_T *psStats)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+
+    if (psNode)
+        *psStats = psNode->sStats;
+    else
+        memset(psStats, 0, sizeof(CANFD_SIM_STATS_T));
+}
+
+/**
+ * @brief       Clear the model counters of a node.
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ */
+void CANFD_SimClearStats(CANFD_T *psCanfd)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+
+    if (psNode)
+        memset(&psNode->sStats, 0, sizeof(CANFD_SIM_STATS_T));
+}
+
+/**
+ * @brief       Copy the register block and message RAM of a node into a spare instance.
+ *
+ * @param[in]   psCanfd     Attached source instance.
+ * @param[in]   psShadow    CANFD0 ~ CANFD3 instance that was never attached.
+ *
+ * @retval      CANFD_SIM_OK        Shadow holds the same state as the source.
+ * @retval      CANFD_SIM_ERR_NODE  Unknown instance, or the shadow is attached.
+ *
+ * @details     Stores into the shadow are not trapped and have no side effects,
+ *              so a driver call against it costs only the driver's own code.
+ *              Used to time a driver call in the same state as the real node.
+ */
+int32_t CANFD_SimShadow(CANFD_T *psCanfd, CANFD_T *psShadow)
+{
+    CANFD_SIM_NODE_T *psNode = CANFD_SimGetNode(psCanfd);
+    CANFD_SIM_NODE_T *psShadowNode = CANFD_SimGetNode(psShadow);
+
+    if ((psNode == NULL) || (psShadowNode == NULL) || !psNode->u32Attached || psShadowNode->u32Trapped)
+        return CANFD_SIM_ERR_NODE;
+
+    memcpy((void *)psShadow, (const void *)psCanfd, CANFD_SIM_REG_SIZE + CANFD_SRAM_SIZE);
+
+    return CANFD_SIM_OK;
+}
+
+/**
+ * @brief       Simulated bus time consumed by all frames so far.
+ * @return      Nanoseconds of bus time.
+ */
+uint64_t CANFD_SimGetBusTimeNs(void)
+{
+    return s_u64BusTimeNs;
+}
+
+/**
+ * @brief       Message RAM address of a node.
+ * @param[in]   psCanfd     CANFD0 ~ CANFD3.
+ * @return      Address of message RAM offset 0.
+ */
+uint32_t CANFD_SimGetMsgRamAddr(CANFD_T *psCanfd)
+{
+    return (uint32_t)(uintptr_t)psCanfd + CANFD_SIM_REG_SIZE;
+}
@@ -0,0 +1,69 @@
+/**************************************************************************//**
+ * @file     canfd_sim.h
+ * @version  V1.00
+ * @brief    Host-side M_CAN register and message RAM model with a virtual bus.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __CANFD_SIM_H__
+#define __CANFD_SIM_H__
+
+#include "NuMicro.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CANFD_SIM_MAX_NODES       4ul
+
+#define CANFD_SIM_OK              ( 0L)   /*!< Model operation OK */
+#define CANFD_SIM_ERR_MAP         (-1L)   /*!< CAN FD address window could not be mapped */
+#define CANFD_SIM_ERR_NODE        (-2L)   /*!< Not a CANFD0~3 instance */
+
+/* Per-node counters kept by the model */
+typedef struct
+{
+    uint32_t u32TxFrames;        /*!< Frames won arbitration and sent */
+    uint32_t u32RxFifo0;         /*!< Frames stored in Rx FIFO 0 */
+    uint32_t u32RxFifo1;         /*!< Frames stored in Rx FIFO 1 */
+    uint32_t u32RxDBuf;          /*!< Frames stored in dedicated Rx buffers */
+    uint32_t u32Rejected;        /*!< Frames rejected by the acceptance filters */
+    uint32_t u32FifoLost;        /*!< Frames lost because a blocking FIFO was full */
+    uint32_t u32DBufLocked;      /*!< Frames dropped because NDAT of the target buffer was still set */
+    uint32_t u32FormatErr;       /*!< FD frames seen while FD operation was disabled */
+    uint32_t u32BitRateErr;      /*!< Frames seen with a nominal/data bit rate different from our own */
+    uint32_t u32ArbLost;         /*!< Bus cycles in which a pending frame lost arbitration */
+} CANFD_SIM_STATS_T;
+
+/* Bit timing as decoded from NBTP/DBTP and the CAN FD clock divider */
+typedef struct
+{
+    uint32_t u32NominalBitRate;  /*!< bps */
+    uint32_t u32NominalSP;       /*!< Sample point in 1/1000 */
+    uint32_t u32DataBitRate;     /*!< bps, 0 if FD operation is disabled */
+    uint32_t u32DataSP;          /*!< Sample point in 1/1000 */
+} CANFD_SIM_TIMING_T;
+
+/* Interrupt line callback, called with u32Line = 0 or 1 when IR & IE is pending on an enabled line */
+typedef void (*CANFD_SIM_IRQ_CB)(CANFD_T *psCanfd, uint32_t u32Line);
+
+int32_t  CANFD_SimInit(void);
+int32_t  CANFD_SimAttach(CANFD_T *psCanfd);
+void     CANFD_SimSetIrqHandler(CANFD_T *psCanfd, CANFD_SIM_IRQ_CB pfnIrq);
+uint32_t CANFD_SimStep(void);
+uint32_t CANFD_SimRun(uint32_t u32MaxFrames);
+void     CANFD_SimGetTiming(CANFD_T *psCanfd, CANFD_SIM_TIMING_T *psTiming);
+uint32_t CANFD_SimCheckRamLayout(CANFD_T *psCanfd);
+void     CANFD_SimGetStats(CANFD_T *psCanfd, CANFD_SIM_STATS_T *psStats);
+void     CANFD_SimClearStats(CANFD_T *psCanfd);
+uint64_t CANFD_SimGetBusTimeNs(void);
+uint32_t CANFD_SimGetMsgRamAddr(CANFD_T *psCanfd);
+int32_t  CANFD_SimShadow(CANFD_T *psCanfd, CANFD_T *psShadow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANFD_SIM_H__ */
@@ -0,0 +1,348 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Validate the CAN FD driver against a simulated bus and measure its
+ *           CPU cost per frame on the host.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c canfd_sim.c ../common/hostsim.c
+ *               ../../../Library/StdDriver/src/canfd.c -o canfd_simbus
+ *           ./canfd_simbus
+ *
+ *           Register stores are trapped to model the M_CAN side effects, which
+ *           costs microseconds per store on the host. The benchmark therefore
+ *           times every driver call on an untrapped shadow copy of the node and
+ *           reports the trapped store count of the real call next to it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "canfd_sim.h"
+
+#define BENCH_FRAMES        10000
+#define CALIB_LOOPS         100000
+
+typedef struct
+{
+    uint64_t u64Ns;
+    uint32_t u32Traps;
+} BENCH_T;
+
+static uint64_t s_u64TimerNs;   /* host clock read overhead */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Open an instance with the driver defaults and the requested bit rates                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void CANFD_OpenNode(CANFD_T *psCanfd, CANFD_FD_T *psConfig, uint32_t u32NomRate, uint32_t u32DataRate)
+{
+    CANFD_SimAttach(psCanfd);
+
+    CANFD_GetDefaultConfig(psConfig, (u32DataRate == 0) ? CANFD_OP_CAN_MODE : CANFD_OP_CAN_FD_MODE);
+    psConfig->sBtConfig.sNormBitRate.u32BitRate = u32NomRate;
+    psConfig->sBtConfig.sDataBitRate.u32BitRate = u32DataRate;
+    CANFD_Open(psCanfd, psConfig);
+}
+
+static void CANFD_PrepareMsg(CANFD_FD_MSG_T *psMsg, E_CANFD_ID_TYPE eIdType, uint32_t u32Id, uint32_t u32Len, uint32_t u32Seed)
+{
+    uint32_t i;
+
+    memset(psMsg, 0, sizeof(CANFD_FD_MSG_T));
+    psMsg->eIdType = eIdType;
+    psMsg->eFrmType = eCANFD_DATA_FRM;
+    psMsg->u32Id = u32Id;
+    psMsg->u32DLC = u32Len;
+    psMsg->bFDFormat = (u32Len > 8) ? 1 : 0;
+    psMsg->bBitRateSwitch = psMsg->bFDFormat;
+
+    for (i = 0; i < u32Len; i++)
+        psMsg->au8Data[i] = (uint8_t)(u32Seed + i);
+}
+
+static uint32_t CANFD_SameMsg(const CANFD_FD_MSG_T *psTx, const CANFD_FD_MSG_T *psRx)
+{
+    return (psTx->eIdType == psRx->eIdType) && (psTx->u32Id == psRx->u32Id) &&
+           (psTx->u32DLC == psRx->u32DLC) && (memcmp(psTx->au8Data, psRx->au8Data, psTx->u32DLC) == 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Bit timing: requested versus programmed bit rates on CANFD0 and CANFD1                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Test_Timing(void)
+{
+    static const uint32_t au32Rate[][2] =
+    {
+        {125000, 0}, {250000, 0}, {500000, 0}, {1000000, 0},
+        {500000, 1000000}, {500000, 2000000}, {500000, 4000000},
+        {1000000, 2000000}, {1000000, 4000000}, {1000000, 5000000},
+    };
+    CANFD_FD_T sConfig;
+    CANFD_SIM_TIMING_T sTiming;
+    CANFD_T *apsNode[2] = {CANFD0, CANFD1};
+    uint32_t i, j;
+
+    printf("\n[Bit timing] SystemCoreClock = %u Hz\n", SystemCoreClock);
+    printf("  node   nominal req/got (SP)        data req/got (SP)\n");
+
+    for (i = 0; i < sizeof(au32Rate) / sizeof(au32Rate[0]); i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            CANFD_OpenNode(apsNode[j], &sConfig, au32Rate[i][0], au32Rate[i][1]);
+            CANFD_SimGetTiming(apsNode[j], &sTiming);
+
+            printf("  CANFD%u %7u/%7u (%3u.%u%%)  %7u/%7u (%3u.%u%%)\n", j,
+                   au32Rate[i][0], sTiming.u32NominalBitRate, sTiming.u32NominalSP / 10, sTiming.u32NominalSP % 10,
+                   au32Rate[i][1], sTiming.u32DataBitRate, sTiming.u32DataSP / 10, sTiming.u32DataSP % 10);
+
+            CHECK(sTiming.u32NominalBitRate == au32Rate[i][0], "nominal bit rate");
+            CHECK(sTiming.u32DataBitRate == au32Rate[i][1], "data bit rate");
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Message RAM partition from CANFD_GetDefaultConfig() and a maximal partition                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Test_RamLayout(void)
+{
+    CANFD_FD_T sConfig;
+    uint32_t u32Err;
+
+    printf("\n[Message RAM layout]\n");
+
+    CANFD_OpenNode(CANFD0, &sConfig, 500000, 2000000);
+    CANFD_SetSIDFltr(CANFD0, 0, CANFD_RX_BUFFER_STD(0x100, 2));
+    u32Err = CANFD_SimCheckRamLayout(CANFD0);
+    printf("  default partition : SID@0x%04x XID@0x%04x F0@0x%04x F1@0x%04x RB@0x%04x EF@0x%04x TB@0x%04x -> %u error(s)\n",
+           sConfig.sMRamStartAddr.u32SIDFC_FLSSA, sConfig.sMRamStartAddr.u32XIDFC_FLESA,
+           sConfig.sMRamStartAddr.u32RXF0C_F0SA, sConfig.sMRamStartAddr.u32RXF1C_F1SA,
+           sConfig.sMRamStartAddr.u32RXBC_RBSA, sConfig.sMRamStartAddr.u32TXEFC_EFSA,
+           sConfig.sMRamStartAddr.u32TXBC_TBSA, u32Err);
+    CHECK(u32Err == 0, "default message RAM partition");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Acceptance filtering: FIFO 0, FIFO 1, dedicated buffers, rejection and loopback                        */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Test_Routing(void)
+{
+    CANFD_FD_T sConfig;
+    CANFD_FD_MSG_T asTx[6], sRx;
+    CANFD_SIM_STATS_T sStats;
+    uint32_t i, u32Errors = s_u32Errors;
+
+    printf("\n[Filter routing] CANFD0 -> CANFD1\n");
+
+    CANFD_OpenNode(CANFD0, &sConfig, 1000000, 4000000);
+    CANFD_OpenNode(CANFD1, &sConfig, 1000000, 4000000);
+
+    CANFD_SetSIDFltr(CANFD1, 0, CANFD_RX_FIFO0_STD_MASK(0x110, 0x7F0));
+    CANFD_SetSIDFltr(CANFD1, 1, CANFD_RX_FIFO1_STD_MASK(0x220, 0x7FF));
+    CANFD_SetSIDFltr(CANFD1, 2, CANFD_RX_BUFFER_STD(0x333, 1));
+    CANFD_SetXIDFltr(CANFD1, 0, CANFD_RX_FIFO1_EXT_MASK_LOW(0x1ABC0000), CANFD_RX_FIFO1_EXT_MASK_HIGH(0x1FFF0000));
+    CANFD_SetXIDFltr(CANFD1, 1, CANFD_RX_BUFFER_EXT_LOW(0x0CAFE, 2), CANFD_RX_BUFFER_EXT_HIGH(0x0CAFE, 2));
+
+    CANFD_RunToNormal(CANFD0, TRUE);
+    CANFD_RunToNormal(CANFD1, TRUE);
+
+    CANFD_PrepareMsg(&asTx[0], eCANFD_SID, 0x115, 8, 0x10);
+    CANFD_PrepareMsg(&asTx[1], eCANFD_SID, 0x220, 64, 0x20);
+    CANFD_PrepareMsg(&asTx[2], eCANFD_SID, 0x333, 12, 0x30);
+    CANFD_PrepareMsg(&asTx[3], eCANFD_XID, 0x1ABC1234, 32, 0x40);
+    CANFD_PrepareMsg(&asTx[4], eCANFD_XID, 0x0CAFE, 5, 0x50);
+    CANFD_PrepareMsg(&asTx[5], eCANFD_SID, 0x555, 8, 0x60);  /* no filter: rejected */
+
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(CANFD_TransmitDMsg(CANFD0, i % 3, &asTx[i]) == 1, "queue Tx buffer");
+        CANFD_SimRun(1);
+    }
+
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 0, &sRx) && CANFD_SameMsg(&asTx[0], &sRx), "0x115 in Rx FIFO 0");
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 1, &sRx) && CANFD_SameMsg(&asTx[1], &sRx), "0x220 in Rx FIFO 1");
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 1, &sRx) && CANFD_SameMsg(&asTx[3], &sRx), "0x1ABC1234 in Rx FIFO 1");
+    CHECK(CANFD_ReadRxBufMsg(CANFD1, 1, &sRx) && CANFD_SameMsg(&asTx[2], &sRx), "0x333 in Rx buffer 1");
+    CHECK(CANFD_ReadRxBufMsg(CANFD1, 2, &sRx) && CANFD_SameMsg(&asTx[4], &sRx), "0x0CAFE in Rx buffer 2");
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 0, &sRx) == 0, "Rx FIFO 0 drained");
+    CHECK(CANFD_ReadRxBufMsg(CANFD1, 1, &sRx) == 0, "Rx buffer 1 new data cleared");
+
+    CANFD_SimGetStats(CANFD1, &sStats);
+    printf("  FIFO0 %u, FIFO1 %u, Rx buffer %u, rejected %u\n",
+           sStats.u32RxFifo0, sStats.u32RxFifo1, sStats.u32RxDBuf, sStats.u32Rejected);
+    CHECK(sStats.u32Rejected == 1, "unmatched frame rejected");
+
+    /* a second frame into buffer 1 must not clear the NDAT flag of buffer 2 */
+    CHECK(CANFD_TransmitDMsg(CANFD0, 0, &asTx[2]) == 1, "queue Tx buffer");
+    CHECK(CANFD_TransmitDMsg(CANFD0, 1, &asTx[4]) == 1, "queue Tx buffer");
+    CANFD_SimRun(2);
+    CHECK(CANFD_ReadRxBufMsg(CANFD1, 1, &sRx) == 1, "Rx buffer 1 refilled");
+    CHECK(CANFD_ReadRxBufMsg(CANFD1, 2, &sRx) == 1, "Rx buffer 2 kept its new data flag");
+
+    /* status flags are write-1-to-clear: clearing one must keep the others */
+    CHECK(CANFD_GetStatusFlag(CANFD1, CANFD_IR_RF0N_Msk) && CANFD_GetStatusFlag(CANFD1, CANFD_IR_RF1N_Msk), "IR flags pending");
+    CANFD_ClearStatusFlag(CANFD1, CANFD_IR_RF0N_Msk);
+    CHECK(!CANFD_GetStatusFlag(CANFD1, CANFD_IR_RF0N_Msk) && CANFD_GetStatusFlag(CANFD1, CANFD_IR_RF1N_Msk), "clear only RF0N");
+
+    /* arbitration: lowest ID queued last still goes first */
+    CANFD_PrepareMsg(&asTx[0], eCANFD_SID, 0x11F, 8, 0x70);
+    CANFD_PrepareMsg(&asTx[1], eCANFD_SID, 0x110, 8, 0x80);
+    CANFD_TransmitDMsg(CANFD0, 0, &asTx[0]);
+    CANFD_TransmitDMsg(CANFD0, 1, &asTx[1]);
+    CANFD_SimRun(2);
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 0, &sRx) && (sRx.u32Id == 0x110), "arbitration order");
+    CHECK(CANFD_ReadRxFifoMsg(CANFD1, 0, &sRx) && (sRx.u32Id == 0x11F), "arbitration order");
+
+    printf("  %s\n", (s_u32Errors != u32Errors) ? "routing errors found" : "all frames routed as filtered");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Benchmark helpers                                                                                      */
+/*  Each driver call is timed against an untrapped shadow copy of the node (CANFD2/CANFD3) holding the     */
+/*  same state, then repeated on the real node to advance the model and count the register stores.         */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef uint32_t (*BENCH_CALL)(CANFD_T *psCanfd, void *pvArg);
+
+static uint32_t Bench_Call(BENCH_T *psBench, BENCH_CALL pfnCall, CANFD_T *psCanfd, CANFD_T *psShadow, void *pvArg)
+{
+    uint64_t u64T0;
+    uint32_t u32Trap0;
+
+    CANFD_SimShadow(psCanfd, psShadow);
+    u64T0 = HOSTSIM_GetNanoSec();
+    pfnCall(psShadow, pvArg);
+    psBench->u64Ns += HOSTSIM_GetNanoSec() - u64T0;
+
+    u32Trap0 = HOSTSIM_GetTrapCount();
+    u32Trap0 = pfnCall(psCanfd, pvArg) | ((HOSTSIM_GetTrapCount() - u32Trap0) << 8);
+    psBench->u32Traps += u32Trap0 >> 8;
+
+    return u32Trap0 & 0xFF;
+}
+
+static uint32_t Bench_Tx(CANFD_T *psCanfd, void *pvArg)
+{
+    return CANFD_TransmitDMsg(psCanfd, 0, (CANFD_FD_MSG_T *)pvArg);
+}
+
+static uint32_t Bench_RxFifo(CANFD_T *psCanfd, void *pvArg)
+{
+    return CANFD_ReadRxFifoMsg(psCanfd, 0, (CANFD_FD_MSG_T *)pvArg);
+}
+
+static uint32_t Bench_RxBuf(CANFD_T *psCanfd, void *pvArg)
+{
+    return CANFD_ReadRxBufMsg(psCanfd, 0, (CANFD_FD_MSG_T *)pvArg);
+}
+
+static void Bench_Report(const char *pcName, const BENCH_T *psBench, uint32_t u32Frames)
+{
+    uint64_t u64Net = psBench->u64Ns - (uint64_t)u32Frames * s_u64TimerNs;
+
+    if (psBench->u64Ns < (uint64_t)u32Frames * s_u64TimerNs) u64Net = 0;
+
+    printf("  %-22s %7.1f ns/frame  %5.2f reg/RAM stores per frame\n", pcName,
+           (double)u64Net / u32Frames, (double)psBench->u32Traps / u32Frames);
+}
+
+/* Cost of reading the host clock around an empty call, subtracted from every sample */
+static void Bench_Calibrate(void)
+{
+    uint64_t u64T0, u64Sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < CALIB_LOOPS; i++)
+    {
+        u64T0 = HOSTSIM_GetNanoSec();
+        u64Sum += HOSTSIM_GetNanoSec() - u64T0;
+    }
+
+    s_u64TimerNs = u64Sum / CALIB_LOOPS;
+    printf("\n[Benchmark] driver CPU time per frame on this host (timer overhead %u ns subtracted)\n", (uint32_t)s_u64TimerNs);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Driver CPU cost per frame: Tx queueing, Rx FIFO and dedicated Rx buffer paths                          */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Bench_Driver(uint32_t u32Len)
+{
+    CANFD_FD_T sConfig;
+    CANFD_FD_MSG_T sTx, sRx;
+    BENCH_T sTxQ, sRxFifo, sRxBuf;
+    CANFD_SIM_STATS_T sStats;
+    uint64_t u64Bus0;
+    uint32_t i, u32Bad = 0;
+
+    memset(&sTxQ, 0, sizeof(BENCH_T));
+    memset(&sRxFifo, 0, sizeof(BENCH_T));
+    memset(&sRxBuf, 0, sizeof(BENCH_T));
+
+    CANFD_OpenNode(CANFD0, &sConfig, 1000000, 5000000);
+    CANFD_OpenNode(CANFD1, &sConfig, 1000000, 5000000);
+    CANFD_SetSIDFltr(CANFD1, 0, CANFD_RX_FIFO0_STD_MASK(0x100, 0x700));
+    CANFD_SetSIDFltr(CANFD1, 1, CANFD_RX_BUFFER_STD(0x7F0, 0));
+    CANFD_RunToNormal(CANFD0, TRUE);
+    CANFD_RunToNormal(CANFD1, TRUE);
+    CANFD_PrepareMsg(&sTx, eCANFD_SID, 0x123, u32Len, 0);
+    u64Bus0 = CANFD_SimGetBusTimeNs();
+
+    for (i = 0; i < BENCH_FRAMES; i++)
+    {
+        /* alternate between the Rx FIFO 0 filter and the Rx buffer 0 filter */
+        sTx.u32Id = (i & 1) ? 0x7F0 : 0x123;
+        sTx.au8Data[0] = (uint8_t)i;
+
+        u32Bad += (Bench_Call(&sTxQ, Bench_Tx, CANFD0, CANFD2, &sTx) != 1);
+
+        CANFD_SimStep();
+
+        if (i & 1)
+            u32Bad += (Bench_Call(&sRxBuf, Bench_RxBuf, CANFD1, CANFD3, &sRx) != 1);
+        else
+            u32Bad += (Bench_Call(&sRxFifo, Bench_RxFifo, CANFD1, CANFD3, &sRx) != 1);
+
+        u32Bad += (sRx.au8Data[0] != (uint8_t)i);
+    }
+
+    CANFD_SimGetStats(CANFD0, &sStats);
+    printf("  -- %u byte payload: %u frames, %u errors, %.1f us bus time per frame at 1M/5M\n", u32Len, sStats.u32TxFrames, u32Bad,
+           (double)(CANFD_SimGetBusTimeNs() - u64Bus0) / BENCH_FRAMES / 1000.0);
+    CHECK(u32Bad == 0, "benchmark frames lost or corrupted");
+
+    Bench_Report("CANFD_TransmitDMsg", &sTxQ, BENCH_FRAMES);
+    Bench_Report("CANFD_ReadRxFifoMsg", &sRxFifo, BENCH_FRAMES / 2);
+    Bench_Report("CANFD_ReadRxBufMsg", &sRxBuf, BENCH_FRAMES / 2);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (CANFD_SimInit() != CANFD_SIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("CAN FD driver on a simulated bus", SimInit) != 0)
+        return 1;
+
+    Test_Timing();
+    Test_RamLayout();
+    Test_Routing();
+
+    Bench_Calibrate();
+    Bench_Driver(8);
+    Bench_Driver(64);
+
+    return HOSTSIM_TestEnd();
+}
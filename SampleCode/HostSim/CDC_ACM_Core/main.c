@@ -0,0 +1,430 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the CDC-ACM class core (Library/UsbDeviceLib/src_cdc/cdc_acm.c).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               -I../../../Library/UsbDeviceLib/inc
+ *               main.c ../../../Library/UsbDeviceLib/src_cdc/cdc_acm.c
+ *               -o cdc_acm_core
+ *           ./cdc_acm_core
+ *
+ *           The class core touches no register, so a small port model stands in
+ *           for USBD/HSUSBD: a bulk IN transfer is read out of the ring when the
+ *           simulated bus completes it (as the HSUSBD DMA does), is cut into
+ *           packets and handed to a host model that ends a transfer on a short
+ *           or zero length packet. Checked are full packet batching, the ZLP
+ *           after a transfer ending on a full packet, the partial packet hold
+ *           and its release by flush and by tick, ring wrap through the bounce
+ *           buffer, RX hold and resume, overflow accounting and a randomized
+ *           run comparing every byte.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "cdc_acm.h"
+#include "hostsim_test.h"
+
+#define MAX_PKT         64
+#define MAX_XFER        256
+#define TX_RING_SIZE    1024
+#define RX_RING_SIZE    256
+#define FLUSH_TICKS     5
+#define HOST_BUF_SIZE   0x100000
+
+static CDC_ACM_T s_sCdc;
+static uint8_t s_au8TxRing[TX_RING_SIZE];
+static uint8_t s_au8RxRing[RX_RING_SIZE];
+static uint32_t s_au32Bounce[2 * MAX_PKT / 4];
+
+/* Port model */
+static uint8_t *s_pu8TxData;            /* Bulk IN transfer on the bus */
+static uint32_t s_u32TxLen;
+static uint8_t s_au8OutPkt[MAX_PKT];    /* Bulk OUT packet waiting in the endpoint */
+static uint32_t s_u32OutLen;
+
+/* Host model */
+static uint8_t s_au8HostIn[HOST_BUF_SIZE];
+static uint32_t s_u32HostInLen;
+static uint32_t s_u32HostPkts, s_u32HostShort, s_u32HostZlps, s_u32HostXferEnds;
+static int32_t s_i32HostXferOpen;       /* Last packet was full, transfer not ended yet */
+
+static void PortRxPacket(CDC_ACM_T *psCdc)
+{
+    uint8_t *pu8Dst = CDC_ACM_RxPrepare(psCdc, s_u32OutLen);
+
+    if (pu8Dst == NULL)
+    {
+        if (psCdc->u8RxState != CDC_ACM_ST_HOLD)
+            psCdc->sStats.u32RxHold++;
+        psCdc->u8RxState = CDC_ACM_ST_HOLD;
+        return;
+    }
+
+    memcpy(pu8Dst, s_au8OutPkt, s_u32OutLen);
+    CDC_ACM_RxDone(psCdc, pu8Dst, s_u32OutLen);
+    psCdc->u8RxState = CDC_ACM_ST_IDLE;
+    s_u32OutLen = 0;
+}
+
+static void PortKick(CDC_ACM_T *psCdc)
+{
+    uint32_t u32Len;
+
+    if (psCdc->u8TxState == CDC_ACM_ST_IDLE)
+    {
+        u32Len = CDC_ACM_TxPrepare(psCdc, &s_pu8TxData);
+        if (u32Len != CDC_ACM_TX_NONE)
+        {
+            CHECK(u32Len <= psCdc->u32MaxXfer, "transfer of %u bytes over u32MaxXfer", u32Len);
+            CHECK((u32Len < MAX_PKT) || ((u32Len % MAX_PKT) == 0), "transfer of %u bytes mixes full and short packets", u32Len);
+            s_u32TxLen = u32Len;
+            psCdc->u8TxState = CDC_ACM_ST_BUSY;
+        }
+    }
+
+    if (psCdc->u8RxState == CDC_ACM_ST_HOLD)
+        PortRxPacket(psCdc);
+}
+
+/* The host takes the bulk IN transfer in flight, returns 0 when there was none */
+static int32_t BusIn(void)
+{
+    uint32_t u32Pkt, u32Off = 0;
+
+    if (s_sCdc.u8TxState != CDC_ACM_ST_BUSY)
+        return 0;
+
+    if (s_u32TxLen == 0)
+    {
+        s_u32HostZlps++;
+        s_u32HostPkts++;
+        CHECK(s_i32HostXferOpen, "zero length packet without an open transfer");
+    }
+
+    while (u32Off < s_u32TxLen)
+    {
+        u32Pkt = s_u32TxLen - u32Off;
+        if (u32Pkt > MAX_PKT)
+            u32Pkt = MAX_PKT;
+        if (s_u32HostInLen + u32Pkt <= HOST_BUF_SIZE)
+            memcpy(&s_au8HostIn[s_u32HostInLen], s_pu8TxData + u32Off, u32Pkt);
+        s_u32HostInLen += u32Pkt;
+        u32Off += u32Pkt;
+        s_u32HostPkts++;
+        if (u32Pkt < MAX_PKT)
+            s_u32HostShort++;
+    }
+
+    if ((s_u32TxLen == 0) || (s_u32TxLen % MAX_PKT))
+    {
+        s_i32HostXferOpen = 0;
+        s_u32HostXferEnds++;
+    }
+    else
+        s_i32HostXferOpen = 1;
+
+    CDC_ACM_TxDone(&s_sCdc, s_u32TxLen);
+    s_sCdc.u8TxState = CDC_ACM_ST_IDLE;
+    PortKick(&s_sCdc);
+    return 1;
+}
+
+static void BusDrain(void)
+{
+    while (BusIn());
+}
+
+/* The host sends one bulk OUT packet, returns 0 when the endpoint is still full */
+static int32_t BusOut(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    if (s_u32OutLen || (s_sCdc.u8RxState == CDC_ACM_ST_HOLD))
+        return 0;       /* NAK */
+
+    memcpy(s_au8OutPkt, pu8Data, u32Len);
+    s_u32OutLen = u32Len;
+    PortRxPacket(&s_sCdc);
+    return 1;
+}
+
+static void HostReset(void)
+{
+    s_u32HostInLen = 0;
+    s_u32HostPkts = s_u32HostShort = s_u32HostZlps = s_u32HostXferEnds = 0;
+    s_i32HostXferOpen = 0;
+}
+
+static void Open(void)
+{
+    CDC_ACM_Init(&s_sCdc, s_au8TxRing, TX_RING_SIZE, s_au8RxRing, RX_RING_SIZE, (uint8_t *)s_au32Bounce);
+    s_sCdc.u16FlushTicks = FLUSH_TICKS;
+    s_sCdc.pfnKick = PortKick;
+    CDC_ACM_Reset(&s_sCdc, MAX_PKT, MAX_XFER + 10);
+    s_u32OutLen = 0;
+    HostReset();
+}
+
+static void Fill(uint8_t *pu8Buf, uint32_t u32Len, uint32_t u32Seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Len; i++)
+        pu8Buf[i] = (uint8_t)(u32Seed + i * 7 + (i >> 8));
+}
+
+static void TestBatching(void)
+{
+    static uint8_t au8Data[1000];
+    uint32_t i;
+
+    printf("\n[1] 1000 bytes written at once, max packet %u, max transfer %u\n", MAX_PKT, MAX_XFER);
+    Open();
+    CHECK(s_sCdc.u32MaxXfer == MAX_XFER, "u32MaxXfer not rounded down to full packets");
+    Fill(au8Data, sizeof(au8Data), 1);
+    CHECK(CDC_ACM_Write(&s_sCdc, au8Data, sizeof(au8Data)) == sizeof(au8Data), "write truncated");
+    BusDrain();
+    printf("  before hold expiry: %u bytes in %u packets, %u left in ring\n", s_u32HostInLen, s_u32HostPkts,
+           1000 - s_u32HostInLen);
+    CHECK(s_u32HostInLen == 960 && s_u32HostShort == 0, "only the 15 full packets should leave at once");
+
+    for (i = 1; i < FLUSH_TICKS; i++)
+    {
+        CDC_ACM_Tick(&s_sCdc);
+        BusDrain();
+    }
+    CHECK(s_u32HostInLen == 960, "partial packet sent before %u ticks", FLUSH_TICKS);
+    CDC_ACM_Tick(&s_sCdc);
+    BusDrain();
+    printf("  after %u ticks: %u bytes, %u short packet(s), %u transfer(s) ended\n", FLUSH_TICKS,
+           s_u32HostInLen, s_u32HostShort, s_u32HostXferEnds);
+    CHECK(s_u32HostInLen == 1000 && s_u32HostShort == 1 && s_u32HostZlps == 0, "tail of 40 bytes");
+    CHECK(memcmp(s_au8HostIn, au8Data, 1000) == 0, "data mismatch");
+    CHECK(s_sCdc.sStats.u32TxXfers == 5, "expected 4 batched transfers and 1 short one, got %u", s_sCdc.sStats.u32TxXfers);
+}
+
+static void TestZlp(void)
+{
+    static uint8_t au8Data[128];
+    uint32_t i;
+
+    printf("\n[2] Transfer ending on a full packet\n");
+    Open();
+    Fill(au8Data, sizeof(au8Data), 2);
+    CDC_ACM_Write(&s_sCdc, au8Data, sizeof(au8Data));
+    BusDrain();
+    CHECK(s_u32HostInLen == 128 && s_i32HostXferOpen, "two full packets should leave at once");
+
+    /* The ZLP waits like a partial packet, more data may still extend the transfer */
+    for (i = 1; i < FLUSH_TICKS; i++)
+    {
+        CDC_ACM_Tick(&s_sCdc);
+        BusDrain();
+    }
+    CHECK(s_u32HostZlps == 0, "ZLP sent early");
+    CDC_ACM_Tick(&s_sCdc);
+    BusDrain();
+    printf("  %u bytes, %u ZLP(s), transfer %s\n", s_u32HostInLen, s_u32HostZlps, s_i32HostXferOpen ? "open" : "ended");
+    CHECK(s_u32HostZlps == 1 && !s_i32HostXferOpen && s_sCdc.sStats.u32TxZlps == 1, "ZLP after hold time");
+
+    /* Flush ends the transfer at once, with a ZLP when needed */
+    CDC_ACM_Write(&s_sCdc, au8Data, 64);
+    BusDrain();
+    CHECK(s_i32HostXferOpen && s_u32HostZlps == 1, "full packet");
+    CDC_ACM_Flush(&s_sCdc);
+    BusDrain();
+    CHECK(!s_i32HostXferOpen && s_u32HostZlps == 2, "flush did not send the ZLP");
+
+    /* Flushing an empty, ended transfer sends nothing */
+    CDC_ACM_Flush(&s_sCdc);
+    BusDrain();
+    CHECK(s_u32HostZlps == 2 && s_u32HostPkts == 5, "spurious packet after flush");
+    for (i = 0; i < 2 * FLUSH_TICKS; i++)
+    {
+        CDC_ACM_Tick(&s_sCdc);
+        BusDrain();
+    }
+    CHECK(s_u32HostPkts == 5, "spurious packet on tick");
+
+    /* A partial packet flushed goes out without waiting */
+    CDC_ACM_Write(&s_sCdc, au8Data, 10);
+    BusDrain();
+    CHECK(s_u32HostInLen == 192, "partial packet sent without flush");
+    CDC_ACM_Flush(&s_sCdc);
+    BusDrain();
+    CHECK(s_u32HostInLen == 202 && !s_i32HostXferOpen, "flush of partial packet");
+}
+
+static void TestWrap(void)
+{
+    static uint8_t au8Data[TX_RING_SIZE];
+    uint32_t u32Sent;
+
+    printf("\n[3] Ring wrap\n");
+    Open();
+    s_sCdc.u16FlushTicks = 0;           /* no hold, everything leaves at once */
+
+    /* Move the ring indexes to 1000 */
+    Fill(au8Data, sizeof(au8Data), 3);
+    CDC_ACM_Write(&s_sCdc, au8Data, 1000);
+    BusDrain();
+    HostReset();
+
+    /* 100 bytes across the end: one packet through the bounce buffer, then the 36 byte tail */
+    Fill(au8Data, 100, 4);
+    CDC_ACM_Write(&s_sCdc, au8Data, 100);
+    BusDrain();
+    printf("  %u bytes in %u packets, %u bounce copies\n", s_u32HostInLen, s_u32HostPkts, s_sCdc.sStats.u32TxBounce);
+    CHECK(s_u32HostInLen == 100 && s_u32HostPkts == 2, "packets across the wrap");
+    CHECK(s_sCdc.sStats.u32TxBounce == 1, "bounce count");
+    CHECK(memcmp(s_au8HostIn, au8Data, 100) == 0, "data mismatch across the wrap");
+
+    /* Overflow: the bus is stalled, the ring takes exactly its size */
+    HostReset();
+    s_sCdc.u16FlushTicks = FLUSH_TICKS;
+    Fill(au8Data, sizeof(au8Data), 5);
+    u32Sent = CDC_ACM_Write(&s_sCdc, au8Data, 700);
+    u32Sent += CDC_ACM_Write(&s_sCdc, au8Data + 700, 500);
+    printf("  stalled bus: accepted %u of 1200, overflow %u\n", u32Sent, s_sCdc.sStats.u32TxOverflow);
+    CHECK(u32Sent == TX_RING_SIZE - 0 || u32Sent + CDC_ACM_TxSpace(&s_sCdc) <= TX_RING_SIZE, "accepted count");
+    CHECK(s_sCdc.sStats.u32TxOverflow == 1200 - u32Sent, "overflow count");
+}
+
+static void TestRxHold(void)
+{
+    uint8_t au8Pkt[MAX_PKT], au8Got[RX_RING_SIZE * 2];
+    uint32_t i, u32Got;
+
+    printf("\n[4] RX ring full\n");
+    Open();
+    for (i = 0; i < RX_RING_SIZE / MAX_PKT; i++)
+    {
+        Fill(au8Pkt, MAX_PKT, 10 + i);
+        CHECK(BusOut(au8Pkt, MAX_PKT), "packet %u refused", i);
+    }
+    Fill(au8Pkt, MAX_PKT, 10 + i);
+    CHECK(BusOut(au8Pkt, MAX_PKT) == 1, "packet taken into the endpoint");
+    CHECK(s_sCdc.u8RxState == CDC_ACM_ST_HOLD && s_sCdc.sStats.u32RxHold == 1, "not held");
+    Fill(au8Pkt, MAX_PKT, 11 + i);
+    CHECK(BusOut(au8Pkt, MAX_PKT) == 0, "second packet not NAKed while held");
+
+    /* Reading less than a packet keeps the hold, a full packet of space resumes */
+    u32Got = CDC_ACM_Read(&s_sCdc, au8Got, 30);
+    CHECK(s_sCdc.u8RxState == CDC_ACM_ST_HOLD, "resumed without room");
+    u32Got += CDC_ACM_Read(&s_sCdc, au8Got + u32Got, 34);
+    CHECK(s_sCdc.u8RxState == CDC_ACM_ST_IDLE, "not resumed");
+    u32Got += CDC_ACM_Read(&s_sCdc, au8Got + u32Got, sizeof(au8Got) - u32Got);
+    printf("  read %u bytes, %u hold(s), %u bounce(s)\n", u32Got, s_sCdc.sStats.u32RxHold, s_sCdc.sStats.u32RxBounce);
+    CHECK(u32Got == RX_RING_SIZE + MAX_PKT, "byte count");
+    for (i = 0; i <= RX_RING_SIZE / MAX_PKT; i++)
+    {
+        Fill(au8Pkt, MAX_PKT, 10 + i);
+        CHECK(memcmp(&au8Got[i * MAX_PKT], au8Pkt, MAX_PKT) == 0, "packet %u corrupt", i);
+    }
+
+    /* Odd sized packets make the ring wrap in the middle of one */
+    for (i = 0; i < 20; i++)
+    {
+        Fill(au8Pkt, 50, 100 + i);
+        CHECK(BusOut(au8Pkt, 50), "packet refused");
+        CHECK(CDC_ACM_Read(&s_sCdc, au8Got, 50) == 50 && memcmp(au8Got, au8Pkt, 50) == 0, "odd packet %u", i);
+    }
+    CHECK(s_sCdc.sStats.u32RxBounce > 0, "no packet crossed the wrap");
+}
+
+static void TestRandom(void)
+{
+    static uint8_t au8Src[HOST_BUF_SIZE / 2], au8Chunk[700];
+    uint32_t u32Wr = 0, u32Rx = 0, u32RxWr = 0, u32Len, i, u32Steps = 0;
+    uint8_t au8Pkt[MAX_PKT];
+
+    printf("\n[5] Randomized traffic\n");
+    Open();
+    srand(1234);
+    Fill(au8Src, sizeof(au8Src), 6);
+
+    while ((u32Wr < sizeof(au8Src)) || (u32Rx < u32RxWr) || (u32RxWr < sizeof(au8Src)))
+    {
+        u32Steps++;
+        switch (rand() % 8)
+        {
+            case 0:
+            case 1:
+                u32Len = rand() % 300;
+                if (u32Len > sizeof(au8Src) - u32Wr)
+                    u32Len = sizeof(au8Src) - u32Wr;
+                if (u32Len > CDC_ACM_TxSpace(&s_sCdc))
+                    u32Len = CDC_ACM_TxSpace(&s_sCdc);
+                u32Wr += CDC_ACM_Write(&s_sCdc, &au8Src[u32Wr], u32Len);
+                break;
+            case 2:
+            case 3:
+                BusIn();
+                break;
+            case 4:
+                CDC_ACM_Tick(&s_sCdc);
+                break;
+            case 5:
+                if ((rand() % 16) == 0)
+                    CDC_ACM_Flush(&s_sCdc);
+                break;
+            case 6:
+                u32Len = 1 + rand() % MAX_PKT;
+                if (u32Len > sizeof(au8Src) - u32RxWr)
+                    u32Len = sizeof(au8Src) - u32RxWr;
+                if (u32Len && BusOut(&au8Src[u32RxWr], u32Len))
+                    u32RxWr += u32Len;
+                break;
+            default:
+                u32Len = CDC_ACM_Read(&s_sCdc, au8Chunk, rand() % sizeof(au8Chunk));
+                if (memcmp(au8Chunk, &au8Src[u32Rx], u32Len))
+                {
+                    CHECK(0, "RX data mismatch at %u", u32Rx);
+                    return;
+                }
+                u32Rx += u32Len;
+                break;
+        }
+    }
+
+    /* Let the tail out */
+    for (i = 0; i <= FLUSH_TICKS; i++)
+    {
+        CDC_ACM_Tick(&s_sCdc);
+        BusDrain();
+    }
+
+    printf("  %u steps, IN %u bytes in %u packets (%u short, %u ZLP), OUT %u bytes, %u RX holds\n", u32Steps,
+           s_u32HostInLen, s_u32HostPkts, s_u32HostShort, s_u32HostZlps, u32Rx, s_sCdc.sStats.u32RxHold);
+    CHECK(s_u32HostInLen == sizeof(au8Src), "IN byte count %u", s_u32HostInLen);
+    CHECK(memcmp(s_au8HostIn, au8Src, sizeof(au8Src)) == 0, "IN data mismatch");
+    CHECK(!s_i32HostXferOpen, "last IN transfer never ended");
+    CHECK(s_sCdc.sStats.u32TxBytes == sizeof(au8Src) && s_sCdc.sStats.u32RxBytes == sizeof(au8Src), "byte statistics");
+    CHECK(s_sCdc.sStats.u32TxOverflow == 0, "overflow with TxSpace() respected");
+
+    /* Batching: most IN packets are full */
+    CHECK(s_u32HostPkts < (sizeof(au8Src) / MAX_PKT) + (sizeof(au8Src) / MAX_PKT) / 4, "too many packets");
+    (void)au8Pkt;
+}
+
+int32_t main(void)
+{
+    /* The class core touches no register: nothing to map */
+    if (HOSTSIM_TestBegin("CDC-ACM class core", NULL) != 0)
+        return 1;
+
+    TestBatching();
+    TestZlp();
+    TestWrap();
+    TestRxHold();
+    TestRandom();
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,507 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the frequency governor (CLK_GovInit() ... CLK_GovUpdate())
+ *           and comparison with a fixed core clock.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c
+ *               ../../../Library/StdDriver/src/clk.c ../../../Library/StdDriver/src/uart.c
+ *               ../../../Library/StdDriver/src/spi.c ../../../Library/StdDriver/src/i2s.c
+ *               ../../../Library/StdDriver/src/qspi.c ../../../Library/StdDriver/src/pdma.c
+ *               ../../../Library/StdDriver/src/timer.c
+ *               -o clk_governor
+ *           ./clk_governor
+ *
+ *           The clock registers are plain memory with every clock stable, so
+ *           CLK_SetCoreClock() runs unchanged, and SystemCoreClockUpdate() reads
+ *           them as the Cortex-M side does. Four drivers are registered: UART0
+ *           from PLL/2 at 115200 bps, SPI0 from PCLK1 at 2 MHz, I2S0 MCLK from
+ *           PCLK0 at 4.096 MHz and TIMER0 from PCLK0 at 1 kHz. Checked: the
+ *           level table, the order of the notifications and the clocks they
+ *           see, the rates the drivers derive at every level, the decisions of
+ *           CLK_GovUpdate() and its account of time and charge. Then a minute
+ *           of a bursty workload, one job every 10 ms due within 20 ms, runs
+ *           at a fixed 200 MHz, a fixed 50 MHz and under the governor: the jobs
+ *           done and how late they finish, and the average current. A change
+ *           costs 200 us of CPU time for the PLL to lock. The currents are
+ *           assumed figures, to compare the policies.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+
+#define PERIOD_US           10000u          /* Governor period, one job each */
+#define DEADLINE_US         20000u          /* A job is due two periods after it arrives */
+#define SWITCH_US           200u            /* CPU time of a level change */
+#define RUN_PERIODS         6000u           /* One minute */
+#define MAX_JOBS            64u
+
+#define UART_BPS            115200u
+#define SPI_HZ              2000000u
+#define MCLK_HZ             4096000u
+#define TICK_HZ             1000u
+
+/* Assumed supply currents, microamperes: HCLK, running, idle. Above 180 MHz the core needs power level 0. */
+static const CLK_GOV_LEVEL_T s_asLevel[] =
+{
+    {  50000000, 9500, 5000 },
+    { 100000000, 18500, 9500 },
+    { 144000000, 26500, 13500 },
+    { 180000000, 33000, 16500 },
+    { 200000000, 40000, 20000 },
+};
+#define LEVELS              (sizeof(s_asLevel) / sizeof(s_asLevel[0]))
+#define TOP                 (LEVELS - 1)
+
+/* Workload phases: share of the 200 MHz CPU */
+static const uint32_t s_au32PhaseLoad[] = { 3, 12, 35, 70 };
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t u32Index;
+    uint32_t u32Pre;
+    uint32_t u32Post;
+    uint32_t u32Rate;               /* Rate the driver reported at the last change */
+} CLIENT_T;
+
+typedef struct
+{
+    uint64_t u64Arrival;            /* Microseconds */
+    uint32_t u32Cycles;             /* Cycles left */
+} JOB_T;
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t u32First;              /* Levels used */
+    uint32_t u32Last;
+    uint32_t u32UpLoad;             /* 0: default policy */
+    uint32_t u32Target;
+    uint32_t u32DownDelay;
+} POLICY_T;
+
+static CLK_GOV_T s_sGov;
+static CLIENT_T s_asClient[] =
+{
+    { "UART0", 0 }, { "SPI0", 1 }, { "I2S0", 2 }, { "TIMER0", 3 },
+};
+#define CLIENTS             (sizeof(s_asClient) / sizeof(s_asClient[0]))
+
+static uint32_t s_u32Seq;           /* Notifications since the last change began */
+static uint32_t s_u32Bad;           /* Notifications out of order or with the wrong clocks */
+
+static JOB_T s_asJob[MAX_JOBS];
+static uint32_t s_u32Head, s_u32Count;
+
+static uint32_t s_u32Seed = 0x2545F491;
+
+static uint32_t Rand(void)
+{
+    s_u32Seed ^= s_u32Seed << 13;
+    s_u32Seed ^= s_u32Seed >> 17;
+    s_u32Seed ^= s_u32Seed << 5;
+    return s_u32Seed;
+}
+
+/* As system_m460.c computes it, from the registers CLK_SetCoreClock() wrote */
+void SystemCoreClockUpdate(void)
+{
+    static const uint32_t au32Src[8] = { __HXT, __LXT, 0, __LIRC, 0, 0, 0, __HIRC };
+    uint32_t u32Sel = CLK->CLKSEL0 & CLK_CLKSEL0_HCLKSEL_Msk;
+    uint32_t u32Freq;
+
+    u32Freq = (u32Sel == CLK_CLKSEL0_HCLKSEL_PLL) ? CLK_GetPLLClockFreq() : au32Src[u32Sel];
+    SystemCoreClock = u32Freq / ((CLK->CLKDIV0 & CLK_CLKDIV0_HCLKDIV_Msk) + 1);
+}
+
+/*
+    Each notification checks that the drivers are called in order, first all of them before
+    the change with the old PLL still running, then all of them after it with the new one.
+*/
+static void Notified(CLIENT_T *psClient, uint32_t u32Event, uint32_t u32Hclk)
+{
+    uint32_t u32Pll = CLK_GetPLLClockFreq();
+
+    if (u32Event == CLK_GOV_PRE_CHANGE)
+    {
+        psClient->u32Pre++;
+        if ((s_u32Seq != psClient->u32Index) || (u32Pll != s_sGov.u32Hclk))
+            s_u32Bad++;
+    }
+    else
+    {
+        psClient->u32Post++;
+        if ((s_u32Seq != CLIENTS + psClient->u32Index) || (u32Pll != u32Hclk) || (s_sGov.u32Hclk != u32Hclk))
+            s_u32Bad++;
+    }
+    if (++s_u32Seq == 2 * CLIENTS)
+        s_u32Seq = 0;
+}
+
+static void UartNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    CLIENT_T *psClient = (CLIENT_T *)pvPriv;
+
+    Notified(psClient, u32Event, u32Hclk);
+    if (u32Event == CLK_GOV_PRE_CHANGE)
+        UART_WAIT_TX_EMPTY(UART0);
+    else
+        UART_SetLineConfig(UART0, UART_BPS, UART_WORD_LEN_8, UART_PARITY_NONE, UART_STOP_BIT_1);
+}
+
+static void SpiNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    CLIENT_T *psClient = (CLIENT_T *)pvPriv;
+
+    Notified(psClient, u32Event, u32Hclk);
+    if (u32Event == CLK_GOV_POST_CHANGE)
+        psClient->u32Rate = SPI_SetBusClock(SPI0, SPI_HZ);
+}
+
+static void I2sNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    CLIENT_T *psClient = (CLIENT_T *)pvPriv;
+
+    Notified(psClient, u32Event, u32Hclk);
+    if (u32Event == CLK_GOV_POST_CHANGE)
+        psClient->u32Rate = I2S_EnableMCLK(I2S0, MCLK_HZ);
+}
+
+static void TimerNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    CLIENT_T *psClient = (CLIENT_T *)pvPriv;
+
+    Notified(psClient, u32Event, u32Hclk);
+    if (u32Event == CLK_GOV_PRE_CHANGE)
+    {
+        TIMER_Stop(TIMER0);
+    }
+    else
+    {
+        psClient->u32Rate = TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, TICK_HZ);
+        TIMER_Start(TIMER0);
+    }
+}
+
+static const CLK_GOV_NOTIFY_T s_apfnNotify[CLIENTS] = { UartNotify, SpiNotify, I2sNotify, TimerNotify };
+
+/* Percent the rate is off its target, from the registers and the clock of the level */
+static double UartError(uint32_t u32Hclk)
+{
+    uint32_t u32Bps = (u32Hclk / 2) / ((UART0->BAUD & UART_BAUD_BRD_Msk) + 2);
+
+    return (u32Bps - (double)UART_BPS) * 100.0 / UART_BPS;
+}
+
+static double SpiError(uint32_t u32Hclk)
+{
+    uint32_t u32Div = (SPI0->CLKDIV & SPI_CLKDIV_DIVIDER_Msk) >> SPI_CLKDIV_DIVIDER_Pos;
+
+    return ((u32Hclk / 2) / (u32Div + 1) - (double)SPI_HZ) * 100.0 / SPI_HZ;
+}
+
+static double I2sError(uint32_t u32Hclk)
+{
+    uint32_t u32Div = (I2S0->CLKDIV & I2S_CLKDIV_MCLKDIV_Msk) >> I2S_CLKDIV_MCLKDIV_Pos;
+    uint32_t u32Mclk = u32Div ? (u32Hclk / 2) / (2 * u32Div) : u32Hclk / 2;
+
+    return (u32Mclk - (double)MCLK_HZ) * 100.0 / MCLK_HZ;
+}
+
+static double TimerError(uint32_t u32Hclk)
+{
+    uint32_t u32Psc = (TIMER0->CTL & TIMER_CTL_PSC_Msk) >> TIMER_CTL_PSC_Pos;
+    double dHz = (u32Hclk / 2) / ((double)TIMER0->CMP * (u32Psc + 1));
+
+    return (dHz - TICK_HZ) * 100.0 / TICK_HZ;
+}
+
+/* The dividers the drivers hold match the level */
+static uint32_t RatesOk(uint32_t u32Hclk)
+{
+    return (UartError(u32Hclk) > -1.0) && (UartError(u32Hclk) < 1.0) &&
+           (SpiError(u32Hclk) > -10.0) && (SpiError(u32Hclk) < 10.0) &&
+           (I2sError(u32Hclk) > -10.0) && (I2sError(u32Hclk) < 10.0) &&
+           (TimerError(u32Hclk) > -0.1) && (TimerError(u32Hclk) < 0.1) &&
+           (TIMER0->CTL & TIMER_CTL_CNTEN_Msk);
+}
+
+static void RegisterClients(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < CLIENTS; i++)
+    {
+        s_asClient[i].u32Pre = s_asClient[i].u32Post = 0;
+        CLK_GovRegister(&s_sGov, s_apfnNotify[i], &s_asClient[i]);
+    }
+    s_u32Seq = 0;
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(FMC_BASE & ~(HOSTSIM_PAGE_SIZE - 1), HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(I2S0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(TIMER0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SPI0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(UART0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK))
+        return -1;
+
+    *(volatile uint32_t *)&CLK->STATUS = CLK_STATUS_HXTSTB_Msk | CLK_STATUS_LXTSTB_Msk | CLK_STATUS_PLLSTB_Msk | CLK_STATUS_HIRCSTB_Msk;
+    CLK->PCLKDIV = CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2;
+    CLK->CLKSEL1 = CLK_CLKSEL1_UART0SEL_PLL_DIV2 | CLK_CLKSEL1_TMR0SEL_PCLK0;
+    CLK->CLKSEL2 = CLK_CLKSEL2_SPI0SEL_PCLK1;
+    CLK->CLKSEL3 = CLK_CLKSEL3_I2S0SEL_PCLK0;
+    *(volatile uint32_t *)&UART0->FIFOSTS = UART_FIFOSTS_TXEMPTYF_Msk;
+
+    return 0;
+}
+
+static void TestLevels(void)
+{
+    static const CLK_GOV_LEVEL_T s_asLow[] = { { 40000000, 8000, 4000 } };
+    static const CLK_GOV_LEVEL_T s_asUnsorted[] = { { 100000000, 1, 1 }, { 50000000, 1, 1 } };
+    uint32_t i, u32Hclk, u32Switches;
+
+    printf("\n[Levels and notifications]\n");
+
+    CHECK(CLK_GovInit(&s_sGov, s_asLevel, 0) == CLK_GOV_ERR_PARAM, "empty table");
+    CHECK(CLK_GovInit(&s_sGov, s_asLow, 1) == CLK_GOV_ERR_PARAM, "40 MHz is below the PLL range");
+    CHECK(CLK_GovInit(&s_sGov, s_asUnsorted, 2) == CLK_GOV_ERR_PARAM, "levels out of order");
+    CHECK(CLK_GovInit(&s_sGov, s_asLevel, LEVELS) == CLK_GOV_OK, "init");
+    CHECK((s_sGov.u32Level == LEVELS - 1) && (SystemCoreClock == 200000000), "starts at the top level, HCLK %u", SystemCoreClock);
+    CHECK((SYS->PLCTL & SYS_PLCTL_PLSEL_Msk) == SYS_PLCTL_PLSEL_PL0, "power level 0 at 200 MHz");
+
+    RegisterClients();
+    for (i = CLIENTS; i < CLK_GOV_MAX_CLIENTS; i++)
+        CHECK(CLK_GovRegister(&s_sGov, TimerNotify, &s_asClient[3]) == CLK_GOV_OK, "client %u", i);
+    CHECK(CLK_GovRegister(&s_sGov, TimerNotify, &s_asClient[3]) == CLK_GOV_ERR_FULL, "client past the table");
+    CHECK(CLK_GovRegister(&s_sGov, NULL, NULL) == CLK_GOV_ERR_PARAM, "NULL client");
+    s_sGov.u32Clients = CLIENTS;
+
+    /* Every level from every other one */
+    for (i = 0; i < LEVELS * LEVELS; i++)
+    {
+        u32Hclk = CLK_GovSetLevel(&s_sGov, i % LEVELS);
+        CHECK(u32Hclk == s_asLevel[i % LEVELS].u32Hclk, "level %u set %u Hz", i % LEVELS, u32Hclk);
+        CHECK(SystemCoreClock == u32Hclk, "HCLK %u Hz after the change", SystemCoreClock);
+        CHECK(RatesOk(u32Hclk), "at %u MHz: UART %+.2f%%, SPI %+.2f%%, MCLK %+.2f%%, tick %+.3f%%", u32Hclk / 1000000,
+              UartError(u32Hclk), SpiError(u32Hclk), I2sError(u32Hclk), TimerError(u32Hclk));
+        CHECK(((SYS->PLCTL & SYS_PLCTL_PLSEL_Msk) == SYS_PLCTL_PLSEL_PL1) == (u32Hclk <= 180000000), "power level at %u MHz", u32Hclk / 1000000);
+    }
+    CHECK(s_u32Bad == 0, "%u notifications out of order or with the wrong clocks", s_u32Bad);
+
+    u32Switches = s_sGov.sStat.u32Switches;
+    CLK_GovSetLevel(&s_sGov, s_sGov.u32Level);
+    CHECK((s_sGov.sStat.u32Switches == u32Switches) && (s_asClient[0].u32Pre == u32Switches), "no change, no notification");
+    CHECK(CLK_GovSetLevel(&s_sGov, 99) == 200000000, "a level past the table is the top one");
+    for (i = 0; i < CLIENTS; i++)
+        CHECK((s_asClient[i].u32Pre == s_sGov.sStat.u32Switches) && (s_asClient[i].u32Post == s_sGov.sStat.u32Switches),
+              "%s notified %u/%u times for %u changes", s_asClient[i].pcName, s_asClient[i].u32Pre, s_asClient[i].u32Post, s_sGov.sStat.u32Switches);
+
+    for (i = 0; i < LEVELS; i++)
+        printf("  %3u MHz: UART %+.2f%%, SPI %+.2f%%, MCLK %+.2f%%, tick %+.3f%%\n", s_asLevel[i].u32Hclk / 1000000,
+               (CLK_GovSetLevel(&s_sGov, i), UartError(s_sGov.u32Hclk)), SpiError(s_sGov.u32Hclk),
+               I2sError(s_sGov.u32Hclk), TimerError(s_sGov.u32Hclk));
+}
+
+static void TestDecisions(void)
+{
+    const CLK_GOV_STAT_T *psStat = &s_sGov.sStat;
+    uint32_t i;
+
+    printf("\n[Decisions]\n");
+
+    CLK_GovInit(&s_sGov, s_asLevel, LEVELS);
+    RegisterClients();
+
+    /* 10% of 200 MHz is 20 MHz of work: 50 MHz keeps it at 40%, after the down delay */
+    for (i = 0; i < 2; i++)
+        CHECK(CLK_GovUpdate(&s_sGov, 1000, 10000) == TOP, "holds the top level for period %u", i);
+    CHECK(CLK_GovUpdate(&s_sGov, 1000, 10000) == 0, "down to 50 MHz after 3 periods");
+    CHECK(psStat->au64Time[TOP] == 30000 && psStat->au64Busy[TOP] == 3000, "time at 200 MHz");
+    CHECK(psStat->au64Charge[TOP] == 3000ull * 40000 + 27000ull * 20000, "charge at 200 MHz");
+
+    /* 75% at 50 MHz is 37.5 MHz of work: 100 MHz keeps it under 70% */
+    CHECK(CLK_GovUpdate(&s_sGov, 6000, 10000) == 0, "60%% load stays at 50 MHz");
+    CHECK(CLK_GovUpdate(&s_sGov, 7500, 10000) == 1, "75%% load at 50 MHz goes to 100 MHz, not %u", s_sGov.u32Level);
+    CHECK(CLK_GovUpdate(&s_sGov, 8000, 10000) == TOP, "80%% load takes the top level");
+    CHECK(psStat->u32Saturated == 0, "not saturated yet");
+    CLK_GovUpdate(&s_sGov, 12000, 10000);
+    CHECK(psStat->u32Saturated == 1 && psStat->au64Busy[TOP] == 3000 + 10000, "a full period at the top level");
+
+    /* A lull shorter than the delay keeps the level */
+    CLK_GovUpdate(&s_sGov, 500, 10000);
+    CLK_GovUpdate(&s_sGov, 500, 10000);
+    CHECK(CLK_GovUpdate(&s_sGov, 8500, 10000) == TOP, "two quiet periods do not step down");
+    CHECK(CLK_GovUpdate(&s_sGov, 5000, 10000) == TOP, "the count starts again after the busy period");
+
+    /* No delay */
+    CLK_GovSetPolicy(&s_sGov, 90, 95, 1);
+    CHECK(s_sGov.u32Target == 90, "target capped to the up threshold");
+    CHECK(CLK_GovUpdate(&s_sGov, 2000, 10000) == 0, "40 MHz of work fits 50 MHz at 90%%");
+    CHECK(s_u32Bad == 0, "%u notifications out of order", s_u32Bad);
+}
+
+static uint32_t JobCycles(uint32_t u32Load)
+{
+    /* Percent of 200 MHz over a period, as cycles */
+    return (uint32_t)((uint64_t)u32Load * 200000000u / 100u * PERIOD_US / 1000000u);
+}
+
+static uint32_t RunPolicy(const POLICY_T *psPolicy, uint32_t *pu32Done, uint32_t *pu32MaxLate)
+{
+    const CLK_GOV_STAT_T *psStat = &s_sGov.sStat;
+    uint32_t u32Period, u32Phase = 0, u32PhaseLeft = 0, u32Load, u32Hclk, u32Overhead = 0, u32Used, u32Need, u32Level;
+    uint32_t u32Done = 0, u32Late = 0, u32Lost = 0, u32MaxLate = 0, u32Rates = 0, i;
+    uint64_t u64Now, u64Charge = 0, u64Time = 0;
+    JOB_T *psJob;
+
+    s_u32Seed = 0x2545F491;
+    s_u32Head = s_u32Count = 0;
+    CLK_GovInit(&s_sGov, &s_asLevel[psPolicy->u32First], psPolicy->u32Last - psPolicy->u32First + 1);
+    if (psPolicy->u32UpLoad)
+        CLK_GovSetPolicy(&s_sGov, psPolicy->u32UpLoad, psPolicy->u32Target, psPolicy->u32DownDelay);
+    RegisterClients();
+
+    for (u32Period = 0; (u32Period < RUN_PERIODS) || s_u32Count; u32Period++)
+    {
+        u64Now = (uint64_t)u32Period * PERIOD_US;
+
+        /* Phases of 0.5 s to 3 s; now and then a spike */
+        if (u32PhaseLeft-- == 0)
+        {
+            u32Phase = Rand() % 4;
+            u32PhaseLeft = 50 + Rand() % 250;
+        }
+        if (u32Period < RUN_PERIODS)
+        {
+            u32Load = s_au32PhaseLoad[u32Phase] * (70 + Rand() % 61) / 100;
+            if (Rand() % 50 == 0)
+                u32Load += 25;
+            if (u32Load > 95)
+                u32Load = 95;
+            if (s_u32Count < MAX_JOBS)
+            {
+                psJob = &s_asJob[(s_u32Head + s_u32Count++) % MAX_JOBS];
+                psJob->u64Arrival = u64Now;
+                psJob->u32Cycles = JobCycles(u32Load);
+            }
+            else
+            {
+                u32Lost++;
+            }
+        }
+
+        /* Run the jobs in order at the current HCLK, after the change made at the end of the last period */
+        u32Hclk = s_sGov.u32Hclk;
+        u32Used = u32Overhead;
+        while (s_u32Count && (u32Used < PERIOD_US))
+        {
+            psJob = &s_asJob[s_u32Head];
+            u32Need = (uint32_t)(((uint64_t)psJob->u32Cycles * 1000000u + u32Hclk - 1) / u32Hclk);
+            if (u32Used + u32Need <= PERIOD_US)
+            {
+                u32Used += u32Need;
+                u32Late = (uint32_t)(u64Now + u32Used - psJob->u64Arrival);
+                if (u32Late > u32MaxLate)
+                    u32MaxLate = u32Late;
+                u32Done += (u32Late <= DEADLINE_US);
+                s_u32Head = (s_u32Head + 1) % MAX_JOBS;
+                s_u32Count--;
+            }
+            else
+            {
+                psJob->u32Cycles -= (uint32_t)((uint64_t)(PERIOD_US - u32Used) * u32Hclk / 1000000u);
+                u32Used = PERIOD_US;
+            }
+        }
+
+        u32Level = s_sGov.u32Level;
+        CLK_GovUpdate(&s_sGov, u32Used, PERIOD_US);
+        u32Overhead = (s_sGov.u32Level != u32Level) ? SWITCH_US : 0;
+        if (u32Overhead && !RatesOk(s_sGov.u32Hclk))
+            u32Rates++;
+    }
+
+    for (i = 0; i < s_sGov.u32Levels; i++)
+    {
+        u64Charge += psStat->au64Charge[i];
+        u64Time += psStat->au64Time[i];
+    }
+
+    printf("\n  %s\n", psPolicy->pcName);
+    printf("    average %7.1f uA, %u jobs on time, %u lost, latest %.1f ms, %u changes, saturated %u periods\n",
+           (double)u64Charge / u64Time, u32Done, u32Lost, u32MaxLate / 1000.0, psStat->u32Switches, psStat->u32Saturated);
+    printf("    time at");
+    for (i = 0; i < s_sGov.u32Levels; i++)
+        printf(" %u MHz %.1f%%", s_sGov.asLevel[i].u32Hclk / 1000000, psStat->au64Time[i] * 100.0 / u64Time);
+    printf("\n");
+
+    CHECK(u32Rates == 0, "%u changes left a driver on the old clock", u32Rates);
+    CHECK(s_u32Bad == 0, "%u notifications out of order", s_u32Bad);
+
+    *pu32Done = u32Done;
+    *pu32MaxLate = u32MaxLate;
+
+    return (uint32_t)(u64Charge / u64Time);
+}
+
+static void TestWorkload(void)
+{
+    static const POLICY_T s_asPolicy[] =
+    {
+        { "fixed 200 MHz", TOP, TOP },
+        { "fixed 50 MHz", 0, 0 },
+        { "governor, default policy", 0, TOP },
+        { "governor, no down delay", 0, TOP, 80, 70, 1 },
+        { "governor, up at 90%, target 80%", 0, TOP, 90, 80, 3 },
+    };
+    uint32_t au32Avg[5], au32Done[5], au32Late[5], i;
+
+    printf("\n[Workload, %u s, one job every %u ms due within %u ms]\n", RUN_PERIODS * PERIOD_US / 1000000, PERIOD_US / 1000, DEADLINE_US / 1000);
+    printf("  assumed currents (run/idle):");
+    for (i = 0; i < LEVELS; i++)
+        printf(" %u MHz %u/%u uA", s_asLevel[i].u32Hclk / 1000000, s_asLevel[i].u32RunCurrent, s_asLevel[i].u32IdleCurrent);
+    printf("\n");
+
+    for (i = 0; i < 5; i++)
+        au32Avg[i] = RunPolicy(&s_asPolicy[i], &au32Done[i], &au32Late[i]);
+
+    printf("\n  governor: %.1f%% of the current at a fixed 200 MHz, same %u jobs on time\n",
+           au32Avg[2] * 100.0 / au32Avg[0], au32Done[2]);
+
+    CHECK(au32Done[0] == RUN_PERIODS, "fixed 200 MHz did %u jobs on time", au32Done[0]);
+    CHECK(au32Done[1] < RUN_PERIODS, "the workload needs more than 50 MHz");
+    for (i = 2; i < 5; i++)
+    {
+        CHECK(au32Done[i] == au32Done[0], "%s loses throughput", s_asPolicy[i].pcName);
+        CHECK(au32Late[i] <= DEADLINE_US, "%s: latest job %u us", s_asPolicy[i].pcName, au32Late[i]);
+        CHECK(au32Avg[i] * 4 < au32Avg[0] * 3, "%s not 25%% below 200 MHz", s_asPolicy[i].pcName);
+    }
+    CHECK(au32Avg[2] < au32Avg[1] || au32Done[1] < au32Done[2], "fixed 50 MHz both cheaper and on time");
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("CLK frequency governor", SimInit) != 0)
+        return 1;
+
+    TestLevels();
+    TestDecisions();
+    TestWorkload();
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,482 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the tickless idle manager (CLK_IdleInit() ... CLK_IdleEnter())
+ *           and comparison with idle loops that spin or sleep a tick at a time.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pwr.c
+ *               ../../../Library/StdDriver/src/clk.c
+ *               -o clk_tickless
+ *           ./clk_tickless
+ *
+ *           The chip is the power model of ../common/sim_pwr.c, with TIMER0 from
+ *           LXT and mode latencies that differ from the defaults of the manager
+ *           (Low Leakage Power-down takes longer to leave). The kernel is a
+ *           small stand-in for RTX5 with a 1 ms tick: osKernelSuspend() and
+ *           osKernelResume() as RTX has them, a SysTick that pauses while
+ *           suspended, and the idle thread of ../../StdDriver/CLK_TicklessIdle.
+ *           The workload is a battery sensor node: a control loop every 50 ms,
+ *           a sensor read every 100 ms, a radio report every second and button
+ *           presses at random. Checked: mode selection against the window, the
+ *           limit of CLK_IdleSetMaxMode(), wake-up on time and on other
+ *           interrupts, the exit latency learned from late wake-ups, and over a
+ *           minute of the workload the average current of each idle policy,
+ *           how late the threads run and that the kernel keeps time. The
+ *           currents are assumed figures, to compare the policies.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pwr.h"
+
+#define TIMER_CLK           32768u          /* TIMER0 from LXT */
+#define TICK_US             1000u           /* RTX OS_TICK_FREQ 1000 */
+#define MAX_IDLE_TICKS      10000u          /* Longest sleep asked for; RTX may return osWaitForever */
+#define RUN_SECONDS         60u
+#define BUTTON_MIN_MS       300u
+#define BUTTON_MAX_MS       3000u
+
+/* Assumed supply currents, microamperes; clocks and regulator start at a fraction of the run current */
+static const uint32_t s_au32Current[SIM_PWR_STATE_CNT] = { 40000, 20000, 500, 100, 20, 5000 };
+static const char *s_apcState[SIM_PWR_STATE_CNT] = { "run", "idle", "FWPD", "PD", "LLPD", "in/out" };
+
+/* Latencies of the model, microseconds: entry, exit */
+static const uint32_t s_au32Latency[SIM_PWR_STATE_CNT][2] = { { 0, 0 }, { 0, 1 }, { 3, 10 }, { 8, 40 }, { 15, 380 }, { 0, 0 } };
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t u32Period;             /* Ticks, 0: started by the button */
+    uint32_t u32Work;               /* Microseconds */
+    uint32_t u32Next;               /* Tick of the next release */
+    uint32_t u32Runs;
+    uint32_t u32MaxLate;            /* Microseconds after the release */
+} THREAD_T;
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t u32Spin;               /* The RTX default idle loop */
+    uint32_t u32MaxTicks;           /* Sleep at most this long */
+    uint32_t u32MaxMode;
+} POLICY_T;
+
+static THREAD_T s_asThread[] =
+{
+    { "control", 50, 60 },
+    { "sensor", 100, 400 },
+    { "radio", 1000, 2500 },
+    { "button", 0, 800 },
+};
+#define THREADS             (sizeof(s_asThread) / sizeof(s_asThread[0]))
+
+static CLK_IDLE_T s_sIdle;
+
+/* Kernel */
+static uint32_t s_u32Tick;
+static uint32_t s_u32TickRem;       /* SysTick: microseconds to the next tick */
+static uint64_t s_u64T0;            /* Model time at tick 0 */
+static uint64_t s_u64Base;          /* Idle manager time at tick 0 */
+
+/* Button */
+static uint64_t s_u64ButtonAt;      /* Next press */
+static uint64_t s_u64Pressed;       /* Press waiting for the thread */
+static volatile uint32_t s_u32ButtonPending;
+
+static uint32_t s_u32Seed = 0x7F4A7C15;
+
+static uint32_t Rand(void)
+{
+    s_u32Seed ^= s_u32Seed << 13;
+    s_u32Seed ^= s_u32Seed >> 17;
+    s_u32Seed ^= s_u32Seed << 5;
+    return s_u32Seed;
+}
+
+/* TMR0_IRQHandler */
+static void TimerIrq(void *pvPriv)
+{
+    (void)pvPriv;
+    CLK_IdleIRQHandler(&s_sIdle);
+}
+
+/* GPIO wake-up interrupt: signal the button thread, the next press comes later */
+static void ButtonIrq(void *pvPriv)
+{
+    (void)pvPriv;
+
+    if (!s_u32ButtonPending)
+    {
+        s_u32ButtonPending = 1;
+        s_u64Pressed = s_u64ButtonAt;
+    }
+    s_u64ButtonAt += (BUTTON_MIN_MS + Rand() % (BUTTON_MAX_MS - BUTTON_MIN_MS)) * 1000ull;
+    SIM_PWR_AddEvent(s_u64ButtonAt, ButtonIrq, NULL);
+}
+
+/* A single wake-up pin interrupt */
+static void PinIrq(void *pvPriv)
+{
+    (void)pvPriv;
+    s_u32ButtonPending = 1;
+}
+
+/* The CPU runs with the kernel resumed: SysTick counts */
+static void Busy(uint32_t u32Us)
+{
+    SIM_PWR_Run(u32Us);
+
+    while (u32Us >= s_u32TickRem)
+    {
+        u32Us -= s_u32TickRem;
+        s_u32Tick++;
+        s_u32TickRem = TICK_US;
+    }
+    s_u32TickRem -= u32Us;
+}
+
+/* Ticks until the next thread is released, 0 if one is ready */
+static uint32_t osKernelSuspend(void)
+{
+    uint32_t i, u32Ticks = 0xFFFFFFFFu;
+
+    if (s_u32ButtonPending)
+        return 0;
+
+    for (i = 0; i < THREADS; i++)
+    {
+        if (s_asThread[i].u32Period == 0)
+            continue;
+        if (s_asThread[i].u32Next <= s_u32Tick)
+            return 0;
+        if (s_asThread[i].u32Next - s_u32Tick < u32Ticks)
+            u32Ticks = s_asThread[i].u32Next - s_u32Tick;
+    }
+
+    return u32Ticks;
+}
+
+/* Kernel time, microseconds: ticks and SysTick */
+static uint64_t KernelTime(void)
+{
+    return (uint64_t)s_u32Tick * TICK_US + TICK_US - s_u32TickRem;
+}
+
+static void osKernelResume(uint32_t u32SleepTicks)
+{
+    s_u32Tick += u32SleepTicks;
+}
+
+static void RunReady(void)
+{
+    THREAD_T *psThread;
+    uint64_t u64Release;
+    uint32_t i, u32Late, u32Ran;
+
+    do
+    {
+        u32Ran = 0;
+        for (i = 0; i < THREADS; i++)
+        {
+            psThread = &s_asThread[i];
+            if (psThread->u32Period)
+            {
+                if (psThread->u32Next > s_u32Tick)
+                    continue;
+                u64Release = s_u64T0 + (uint64_t)psThread->u32Next * TICK_US;
+                psThread->u32Next += psThread->u32Period;
+            }
+            else
+            {
+                if (!s_u32ButtonPending)
+                    continue;
+                u64Release = s_u64Pressed;
+                s_u32ButtonPending = 0;
+            }
+
+            /* The kernel may be a timer clock ahead: a thread run that early counts as on time */
+            u32Late = (SIM_PWR_GetTime() > u64Release) ? (uint32_t)(SIM_PWR_GetTime() - u64Release) : 0;
+            if (u32Late > psThread->u32MaxLate)
+                psThread->u32MaxLate = u32Late;
+            psThread->u32Runs++;
+            Busy(psThread->u32Work);
+            u32Ran = 1;
+        }
+    } while (u32Ran);
+}
+
+/* One pass of the idle thread */
+static void Idle(const POLICY_T *psPolicy)
+{
+    uint32_t u32Ticks, u32Window, u32Us, u32Credit = 0;
+    int64_t i64Behind;
+
+    u32Ticks = osKernelSuspend();
+    if (u32Ticks == 0)
+    {
+        osKernelResume(0);
+        return;
+    }
+
+    if (psPolicy->u32Spin)
+    {
+        /* for(;;) {}: the next tick or interrupt ends the pass */
+        osKernelResume(0);
+        u32Us = s_u32TickRem;
+        if (s_u64ButtonAt - SIM_PWR_GetTime() < u32Us)
+            u32Us = (uint32_t)(s_u64ButtonAt - SIM_PWR_GetTime());
+        Busy(u32Us ? u32Us : 1);
+        return;
+    }
+
+    if (u32Ticks > psPolicy->u32MaxTicks)
+        u32Ticks = psPolicy->u32MaxTicks;
+    u32Window = (u32Ticks - 1) * TICK_US + s_u32TickRem;
+
+    if (CLK_IdleEnter(&s_sIdle, u32Window) == 0)
+    {
+        /* Too short to sleep: spin to the release */
+        osKernelResume(0);
+        Busy(u32Window);
+        return;
+    }
+
+    /* The kernel follows the timer: whole ticks go to the kernel, SysTick goes on with the rest */
+    i64Behind = (int64_t)(CLK_IdleGetTime(&s_sIdle) - s_u64Base - KernelTime());
+    if (i64Behind < 0)
+    {
+        u32Us = (uint32_t)-i64Behind;
+        s_u32TickRem = (s_u32TickRem + u32Us < TICK_US) ? s_u32TickRem + u32Us : TICK_US;
+    }
+    else if (i64Behind < s_u32TickRem)
+    {
+        s_u32TickRem -= (uint32_t)i64Behind;
+    }
+    else
+    {
+        u32Us = (uint32_t)i64Behind - s_u32TickRem;
+        u32Credit = 1 + u32Us / TICK_US;
+        s_u32TickRem = TICK_US - u32Us % TICK_US;
+    }
+    osKernelResume(u32Credit);
+}
+
+static void TestSelect(void)
+{
+    const CLK_IDLE_MODE_T *psMode = s_sIdle.asMode;
+    uint32_t i, u32Cost;
+
+    printf("\n[Mode selection]\n");
+    CLK_IdleInit(&s_sIdle, TIMER0, TIMER_CLK);
+
+    CHECK(CLK_IdleSelect(&s_sIdle, 0) == CLK_IDLE_NONE, "no mode for an empty window");
+    for (i = 0; i < CLK_IDLE_MODE_CNT; i++)
+    {
+        u32Cost = psMode[i].u32Entry + psMode[i].u32Exit + psMode[i].u32MinStay;
+        printf("  mode %u from %5u us\n", i, u32Cost);
+        CHECK(CLK_IdleSelect(&s_sIdle, u32Cost) == i, "mode %u at its cost", i);
+        if (u32Cost)
+            CHECK(CLK_IdleSelect(&s_sIdle, u32Cost - 1) == i - 1, "mode %u below its cost", i);
+    }
+    CHECK(CLK_IdleSelect(&s_sIdle, 0xFFFFFFFFu) == CLK_IDLE_LLPD, "the deepest mode for a long window");
+
+    /* Measured costs move the thresholds */
+    CLK_IdleSetMode(&s_sIdle, CLK_IDLE_LLPD, 20, 250, 2000);
+    CHECK(CLK_IdleSelect(&s_sIdle, 3000) == CLK_IDLE_LLPD, "LLPD once it pays off sooner");
+    CLK_IdleInit(&s_sIdle, TIMER0, TIMER_CLK);
+}
+
+static void TestWakeup(void)
+{
+    const SIM_PWR_STAT_T *psSim = SIM_PWR_GetStat();
+    uint32_t i, u32Us, u32Exit, u32Clk = 1000000u / TIMER_CLK + 1;
+    uint64_t u64Start, u64Time;
+
+    printf("\n[Wake-up]\n");
+    CLK_IdleInit(&s_sIdle, TIMER0, TIMER_CLK);
+    SIM_PWR_ResetStat();
+
+    /* On time, in the mode the window allows */
+    u64Start = SIM_PWR_GetTime();
+    u64Time = CLK_IdleGetTime(&s_sIdle);
+    u32Us = CLK_IdleEnter(&s_sIdle, 700);
+    CHECK(psSim->au32Entries[SIM_PWR_PD] == 1, "PD for 700 us");
+    CHECK((u32Us <= 700 + u32Clk) && (u32Us + 60 + u32Clk >= 700), "700 us window slept %u us", u32Us);
+    CHECK(SIM_PWR_GetTime() - u64Start <= 700, "running again %u us after a 700 us window", (uint32_t)(SIM_PWR_GetTime() - u64Start));
+    CHECK(CLK_IdleGetTime(&s_sIdle) - u64Time + u32Clk >= SIM_PWR_GetTime() - u64Start, "time of the manager");
+    CHECK(s_sIdle.u32Woken && (s_sIdle.sStat.u32Late == 0), "PD wake-up by the timer, on time");
+    CHECK(!(TIMER0->CTL & TIMER_CTL_INTEN_Msk) && !(TIMER0->INTSTS & (TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk)), "timer interrupt left disabled and clear");
+
+    CHECK(CLK_IdleEnter(&s_sIdle, 100) > 0, "100 us window");
+    CHECK(psSim->au32Entries[SIM_PWR_FWPD] == 1, "FWPD for 100 us");
+    CHECK(CLK_IdleEnter(&s_sIdle, 40) == 0, "40 us window");
+    CHECK(s_sIdle.sStat.u32Short == 1, "a window shorter than two timer clocks is not slept");
+
+    /* LLPD takes longer to leave than its default: late once, then on time */
+    u32Exit = s_sIdle.asMode[CLK_IDLE_LLPD].u32Exit;
+    for (i = 0; i < 4; i++)
+    {
+        u64Start = SIM_PWR_GetTime();
+        u32Us = CLK_IdleEnter(&s_sIdle, 30000);
+        printf("  LLPD for 30 ms: slept %5u us, running again after %5u us, exit latency now %3u us\n",
+               u32Us, (uint32_t)(SIM_PWR_GetTime() - u64Start), s_sIdle.asMode[CLK_IDLE_LLPD].u32Exit);
+    }
+    CHECK(s_sIdle.sStat.u32Late == 1, "late %u times, not once", s_sIdle.sStat.u32Late);
+    CHECK((s_sIdle.asMode[CLK_IDLE_LLPD].u32Exit >= s_au32Latency[SIM_PWR_LLPD][1]) &&
+          (s_sIdle.asMode[CLK_IDLE_LLPD].u32Exit <= s_au32Latency[SIM_PWR_LLPD][1] + u32Clk),
+          "exit latency learned: %u us, default %u us", s_sIdle.asMode[CLK_IDLE_LLPD].u32Exit, u32Exit);
+    CHECK(SIM_PWR_GetTime() - u64Start <= 30000, "on time after learning");
+    CHECK(psSim->au32Entries[SIM_PWR_LLPD] == 4, "LLPD for 30 ms");
+
+    /* Another interrupt ends the sleep early */
+    SIM_PWR_AddEvent(SIM_PWR_GetTime() + 3000, PinIrq, NULL);
+    u32Us = CLK_IdleEnter(&s_sIdle, 50000);
+    CHECK(s_u32ButtonPending && !s_sIdle.u32Woken && (s_sIdle.sStat.u32Early == 1), "woken by the pin");
+    CHECK((u32Us >= 3000) && (u32Us <= 3000 + 400 + 2 * u32Clk), "slept %u us up to the pin", u32Us);
+    s_u32ButtonPending = 0;
+
+    /* A driver holds the chip out of power-down */
+    CLK_IdleSetMaxMode(&s_sIdle, CLK_IDLE_SLEEP);
+    CLK_IdleEnter(&s_sIdle, 30000);
+    CHECK(psSim->au32Entries[SIM_PWR_SLEEP] == 1, "idle mode when limited");
+    CHECK(s_sIdle.sStat.u32Vetoed == 1, "deeper mode vetoed");
+    CLK_IdleSetMaxMode(&s_sIdle, CLK_IDLE_LLPD);
+
+    CHECK(psSim->u32Stuck == 0, "WFI without a wake-up source");
+}
+
+/* A minute of the workload under one idle policy; returns the average current, uA */
+static uint32_t RunPolicy(const POLICY_T *psPolicy)
+{
+    const SIM_PWR_STAT_T *psSim = SIM_PWR_GetStat();
+    uint64_t u64Total = 0, u64Charge = 0, u64End;
+    uint32_t i, u32Avg, u32Entries = 0;
+    int32_t i32Drift;
+
+    CLK_IdleInit(&s_sIdle, TIMER0, TIMER_CLK);
+    CLK_IdleSetMaxMode(&s_sIdle, psPolicy->u32MaxMode);
+    SIM_PWR_ResetStat();
+
+    s_u32Tick = 0;
+    s_u32TickRem = TICK_US;
+    s_u64T0 = SIM_PWR_GetTime();
+    s_u64Base = CLK_IdleGetTime(&s_sIdle);
+    u64End = s_u64T0 + RUN_SECONDS * 1000000ull;
+    for (i = 0; i < THREADS; i++)
+    {
+        s_asThread[i].u32Next = s_asThread[i].u32Period;
+        s_asThread[i].u32Runs = 0;
+        s_asThread[i].u32MaxLate = 0;
+    }
+
+    while (SIM_PWR_GetTime() < u64End)
+    {
+        RunReady();
+        Idle(psPolicy);
+    }
+
+    for (i = 0; i < SIM_PWR_STATE_CNT; i++)
+    {
+        u64Total += psSim->au64Time[i];
+        u64Charge += psSim->au64Time[i] * s_au32Current[i];
+        if (i != SIM_PWR_RUN)
+            u32Entries += psSim->au32Entries[i];
+    }
+    u32Avg = (uint32_t)(u64Charge / u64Total);
+
+    printf("\n  %s\n", psPolicy->pcName);
+    printf("    average %7.1f uA,", u32Avg / 1.0);
+    for (i = 0; i < SIM_PWR_STATE_CNT; i++)
+    {
+        if (psSim->au64Time[i])
+            printf(" %s %.2f%%", s_apcState[i], psSim->au64Time[i] * 100.0 / u64Total);
+    }
+    printf("\n    %u sleeps (%u by the timer, %u by the button),", u32Entries, psSim->u32TimerWakeups, psSim->u32EventWakeups);
+    printf(" worst lateness:");
+    for (i = 0; i < THREADS; i++)
+        printf(" %s %u us", s_asThread[i].pcName, s_asThread[i].u32MaxLate);
+    printf("\n");
+
+    /* The kernel time against the model time */
+    i32Drift = (int32_t)((int64_t)(SIM_PWR_GetTime() - s_u64T0) - ((int64_t)s_u32Tick * TICK_US + TICK_US - s_u32TickRem));
+    printf("    kernel time off by %d us after %u s\n", i32Drift, RUN_SECONDS);
+
+    CHECK(s_asThread[0].u32Runs >= RUN_SECONDS * 20 - 1, "control loop ran %u times", s_asThread[0].u32Runs);
+    CHECK(s_asThread[3].u32Runs > RUN_SECONDS * 1000 / BUTTON_MAX_MS, "button handled %u times", s_asThread[3].u32Runs);
+    CHECK((i32Drift > -(int32_t)TICK_US) && (i32Drift < (int32_t)TICK_US), "kernel time drifts");
+    CHECK(psSim->u32Stuck == 0, "WFI without a wake-up source");
+
+    return u32Avg;
+}
+
+static void TestPolicies(void)
+{
+    static const POLICY_T s_asPolicy[] =
+    {
+        { "spin (RTX default idle thread)", 1, 0, 0 },
+        { "WFI at every tick", 0, 1, CLK_IDLE_SLEEP },
+        { "tickless, idle mode only", 0, MAX_IDLE_TICKS, CLK_IDLE_SLEEP },
+        { "tickless, down to Power-down", 0, MAX_IDLE_TICKS, CLK_IDLE_PD },
+        { "tickless, all modes", 0, MAX_IDLE_TICKS, CLK_IDLE_LLPD },
+    };
+    uint32_t au32Avg[5], au32Late[5], i;
+
+    printf("\n[Idle policies, %u s of the workload]\n", RUN_SECONDS);
+    printf("  assumed currents:");
+    for (i = 0; i < SIM_PWR_STATE_CNT; i++)
+        printf(" %s %u uA", s_apcState[i], s_au32Current[i]);
+    printf("\n");
+
+    for (i = 0; i < 5; i++)
+    {
+        au32Avg[i] = RunPolicy(&s_asPolicy[i]);
+        au32Late[i] = s_asThread[0].u32MaxLate;
+    }
+
+    printf("\n  tickless, all modes: %.1fx less current than spinning, %.1fx less than WFI at every tick\n",
+           au32Avg[0] / (double)au32Avg[4], au32Avg[1] / (double)au32Avg[4]);
+
+    CHECK(au32Avg[4] * 20 < au32Avg[0], "tickless not 20x below spinning");
+    CHECK(au32Avg[4] < au32Avg[3] && au32Avg[3] < au32Avg[2] && au32Avg[2] < au32Avg[1], "deeper modes do not save more");
+    /* Only the wake-up before the LLPD exit latency was learned may be late, by what it lacked */
+    CHECK(au32Late[4] < TICK_US / 4, "control loop %u us late", au32Late[4]);
+}
+
+static int32_t SimInit(void)
+{
+    uint32_t i;
+
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (SIM_PWR_Init(TIMER_CLK) != HOSTSIM_OK))
+        return -1;
+
+    for (i = 0; i < SIM_PWR_STATE_CNT; i++)
+        SIM_PWR_SetLatency(i, s_au32Latency[i][0], s_au32Latency[i][1]);
+    SIM_PWR_SetTimerIrq(TimerIrq, NULL);
+
+    return 0;
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("CLK tickless idle manager", SimInit) != 0)
+        return 1;
+
+    TestSelect();
+    TestWakeup();
+
+    s_u64ButtonAt = SIM_PWR_GetTime() + BUTTON_MIN_MS * 1000ull;
+    SIM_PWR_AddEvent(s_u64ButtonAt, ButtonIrq, NULL);
+    TestPolicies();
+
+    return HOSTSIM_TestEnd();
+}
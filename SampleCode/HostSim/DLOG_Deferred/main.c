@@ -0,0 +1,624 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the deferred binary log
+ *           (DLOG_Init() ... DLOG_Drain()) over the ring-buffered UART.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -no-pie -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c ../common/sim_uart.c
+ *               ../../../Library/StdDriver/src/pdma.c ../../../Library/StdDriver/src/uart.c
+ *               -o dlog_deferred
+ *           ./dlog_deferred [capture.bin]
+ *
+ *           dlog.c is built into this file so that its timestamp is the
+ *           simulated clock, which can also play an interrupt: a message
+ *           logged while the clock is read lands between the LDREX and STREX
+ *           of the one being reserved, as an interrupt does on the target.
+ *           The log drains through UART_BufWrite() into the UART0 and PDMA0
+ *           models of ../common/sim_uart.c and ../common/sim_pdma.c, and the
+ *           checks parse the bytes seen on the wire.
+ *           Checked are the parameter checks and INFO record, messages of 0 to
+ *           8 arguments, text split into records, printf() lines of thread
+ *           mode and of nested interrupt handlers, the ring full with the
+ *           DROP record in place, a reserved record holding back the drain,
+ *           and messages nested up to three deep at random points.
+ *           Given a file name, the last check writes a capture there; built
+ *           with -no-pie, this executable is the image it was logged from, as
+ *           input for SampleCode/StdDriver/DLOG_Deferred/HostTool/dlog_decode.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+static uint32_t SimCycles(void);
+#define DLOG_TIMESTAMP()    SimCycles()
+
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+#include "sim_uart.h"
+
+/* Exception number seen by DLOG_PutChar(), 0 for thread mode */
+static uint32_t s_u32Ipsr;
+#define __get_IPSR()        (s_u32Ipsr)
+
+#include "../../../Library/StdDriver/src/dlog.c"
+
+#define SMALL_RING          32
+#define RING_SIZE           1024
+#define BIG_RING_SIZE       4096
+#define RX_SIZE             64
+#define TX_SIZE             256
+#define SRAM_SIM_SIZE       0x10000ul
+#define WIRE_SIZE           0x10000ul
+#define REC_MAX             512
+#define NEST_MSGS           5000
+
+#define DESC_NUM            2
+
+#define ADDR(p)             ((uint32_t)(uintptr_t)(p))
+#define HDR_TYPE(h)         ((uint32_t)(((h) & DLOG_HDR_TYPE_Msk) >> DLOG_HDR_TYPE_Pos))
+#define HDR_LEN(h)          ((uint32_t)(((h) & DLOG_HDR_LEN_Msk) >> DLOG_HDR_LEN_Pos))
+#define HDR_SEQ(h)          ((uint32_t)(((h) & DLOG_HDR_SEQ_Msk) >> DLOG_HDR_SEQ_Pos))
+#define HDR_WORDS(h)        ((uint32_t)(((h) & DLOG_HDR_WORDS_Msk) >> DLOG_HDR_WORDS_Pos))
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[DESC_NUM];
+    DSCT_T asRxDesc[2];
+    uint8_t au8Rx[RX_SIZE];
+    uint8_t au8Tx[TX_SIZE];
+} SIM_MEM_T;
+
+/* A record as parsed from the wire */
+typedef struct
+{
+    uint32_t au32Word[DLOG_REC_MAX_WORDS];
+} REC_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+static UART_BUF_T s_sUart;
+static uint32_t s_u32UartOpen;
+
+static uint32_t s_au32Small[SMALL_RING];
+static uint32_t s_au32Ring[RING_SIZE];
+static uint32_t s_au32BigRing[BIG_RING_SIZE];
+
+/* Wire bytes not parsed yet, records parsed since Reset() */
+static uint8_t s_au8Wire[WIRE_SIZE];
+static uint32_t s_u32WireLen;
+static REC_T s_asRec[REC_MAX];
+static uint32_t s_u32RecCnt, s_u32NextSeq, s_u32Skipped;
+
+/* Whole capture of the last check */
+static uint8_t *s_pu8Capture;
+static uint32_t s_u32CaptureLen;
+
+/* Simulated clock; reads may log on behalf of an interrupt */
+static uint32_t s_u32Now, s_u32Step = 1;
+static uint32_t s_u32Preempt;           /* Reads left before the next preemption, 0 for none */
+static uint32_t s_u32Depth, s_u32MaxDepth, s_u32Nested;
+static uint32_t s_u32Seed = 1;
+static uint8_t s_au8Seen[NEST_MSGS * 2];   /* Nested messages received, by number */
+
+static const char *const s_apcFmt[] =
+{
+    "no arguments\n",
+    "a=%d\n",
+    "a=%d b=%u\n",
+    "%d %d %d\n",
+    "%d %d %d %d\n",
+    "%x %x %x %x %x\n",
+    "%X %X %X %X %X %X\n",
+    "%u %u %u %u %u %u %u\n",
+    "%d %d %d %d %d %d %d %d\n",
+};
+
+static const char s_acNested[] = "nested %u at depth %u\n";
+
+/* Referenced by the baud rate code of uart.c, which the check never calls */
+uint32_t CLK_GetPLLClockFreq(void)
+{
+    return 0;
+}
+
+void UART0_IRQHandler(void)
+{
+    if (s_u32UartOpen)
+        UART_BufIRQHandler(&s_sUart);
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+    if (s_u32UartOpen)
+        UART_BufPdmaIRQHandler(&s_sUart);
+}
+
+static uint32_t Rand(void)
+{
+    s_u32Seed = s_u32Seed * 1103515245u + 12345u;
+    return s_u32Seed >> 16;
+}
+
+static uint32_t SimCycles(void)
+{
+    uint32_t u32Now;
+
+    /* An interrupt while the words are reserved, which may itself be interrupted */
+    if ((s_u32Preempt != 0) && (--s_u32Preempt == 0) && (s_u32Depth < 3))
+    {
+        s_u32Depth++;
+        if (s_u32Depth > s_u32MaxDepth)
+            s_u32MaxDepth = s_u32Depth;
+        s_u32Preempt = (Rand() & 1) ? 1 : 0;
+        DLOG(s_acNested, s_u32Nested++, s_u32Depth);
+        s_u32Depth--;
+    }
+
+    u32Now = s_u32Now;
+    s_u32Now += s_u32Step;
+
+    return u32Now;
+}
+
+static int32_t SimInit(void)
+{
+    UART_BUF_CFG_T sCfg;
+
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, DESC_NUM, PDMA_SCATBA_SET, 0, NULL) != 0) ||
+            (SIM_UART_Init(UART0_IRQHandler, NULL) != HOSTSIM_OK))
+        return -1;
+
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.uart = UART0;
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32RxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.u32TxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.pu8RxBuf = s_psMem->au8Rx;
+    sCfg.u32RxSize = RX_SIZE;
+    sCfg.pu8TxBuf = s_psMem->au8Tx;
+    sCfg.u32TxSize = TX_SIZE;
+    sCfg.psRxDesc = s_psMem->asRxDesc;
+    s_u32UartOpen = (UART_BufOpen(&s_sUart, &sCfg) == 0);
+
+    return s_u32UartOpen ? 0 : -1;
+}
+
+static void Reset(void)
+{
+    s_u32RecCnt = 0;
+    s_u32NextSeq = 0;
+    s_u32Skipped = 0;
+}
+
+/* Move the wire bytes seen so far into s_au8Wire and the capture */
+static void Collect(void)
+{
+    uint32_t u32Len = SIM_UART_Drain(SIM_UART_UART0, s_au8Wire + s_u32WireLen, WIRE_SIZE - s_u32WireLen);
+
+    if (s_pu8Capture != NULL)
+    {
+        memcpy(s_pu8Capture + s_u32CaptureLen, s_au8Wire + s_u32WireLen, u32Len);
+        s_u32CaptureLen += u32Len;
+    }
+    s_u32WireLen += u32Len;
+}
+
+/* Drain from the idle loop until the log and the UART are empty; returns the records drained */
+static uint32_t Pump(void)
+{
+    uint32_t u32Cnt = 0, u32Drained;
+
+    do
+    {
+        u32Drained = DLOG_Drain(&s_sUart);
+        u32Cnt += u32Drained;
+        SIM_UART_Run(32);
+        Collect();
+    }
+    while ((u32Drained != 0) || (UART_BufTxPending(&s_sUart) != 0));
+
+    SIM_UART_Run(32);
+    Collect();
+
+    return u32Cnt;
+}
+
+/* Frames on the wire into s_asRec, checking the frame numbers; returns the records parsed */
+static uint32_t Parse(void)
+{
+    uint32_t u32Pos = 0, u32Cnt = 0, u32Hdr, u32Words, i;
+
+    while (u32Pos + 5 <= s_u32WireLen)
+    {
+        if (s_au8Wire[u32Pos] != DLOG_SYNC)
+        {
+            u32Pos++;
+            s_u32Skipped++;
+            continue;
+        }
+
+        memcpy(&u32Hdr, &s_au8Wire[u32Pos + 1], 4);
+        u32Words = HDR_WORDS(u32Hdr);
+        if ((u32Words < 2) || (u32Words > DLOG_REC_MAX_WORDS))
+        {
+            u32Pos++;
+            s_u32Skipped++;
+            continue;
+        }
+        if (u32Pos + 1 + u32Words * 4 > s_u32WireLen)
+            break;
+
+        CHECK(HDR_SEQ(u32Hdr) == (s_u32NextSeq & 0xFF), "frame %u numbered %u", s_u32NextSeq & 0xFF, HDR_SEQ(u32Hdr));
+        s_u32NextSeq = HDR_SEQ(u32Hdr) + 1;
+
+        if (s_u32RecCnt < REC_MAX)
+        {
+            for (i = 0; i < u32Words; i++)
+                memcpy(&s_asRec[s_u32RecCnt].au32Word[i], &s_au8Wire[u32Pos + 1 + i * 4], 4);
+            s_u32RecCnt++;
+        }
+        u32Pos += 1 + u32Words * 4;
+        u32Cnt++;
+    }
+
+    memmove(s_au8Wire, s_au8Wire + u32Pos, s_u32WireLen - u32Pos);
+    s_u32WireLen -= u32Pos;
+
+    return u32Cnt;
+}
+
+static int32_t IsFmt(const REC_T *psRec, const char *pcFmt, uint32_t u32Argc)
+{
+    return (HDR_TYPE(psRec->au32Word[0]) == DLOG_TYPE_FMT) && (HDR_LEN(psRec->au32Word[0]) == u32Argc) &&
+           (HDR_WORDS(psRec->au32Word[0]) == 3 + u32Argc) && (psRec->au32Word[2] == ADDR(pcFmt));
+}
+
+static int32_t IsText(const REC_T *psRec, const char *pcText, uint32_t u32Len)
+{
+    return (HDR_TYPE(psRec->au32Word[0]) == DLOG_TYPE_TEXT) && (HDR_LEN(psRec->au32Word[0]) == u32Len) &&
+           (HDR_WORDS(psRec->au32Word[0]) == 2 + (u32Len + 3) / 4) &&
+           (memcmp(&psRec->au32Word[2], pcText, u32Len) == 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void TestInit(void)
+{
+    DLOG_STAT_T sStat;
+
+    printf("\n[1] Parameters and the INFO record\n");
+    DLOG(s_apcFmt[1], 1);
+    DLOG_Text("lost", 4);
+    CHECK(Pump() == 0, "drained before DLOG_Init()");
+
+    CHECK(DLOG_Init(NULL, RING_SIZE) == DLOG_ERR_PARAM, "no ring");
+    CHECK(DLOG_Init(s_au32Ring, 16) == DLOG_ERR_PARAM, "ring below DLOG_MIN_WORDS");
+    CHECK(DLOG_Init(s_au32Ring, 48) == DLOG_ERR_PARAM, "ring not a power of two");
+
+    memset(s_au32Ring, 0xEE, sizeof(s_au32Ring));
+    CHECK(DLOG_Init(s_au32Ring, RING_SIZE) == DLOG_OK, "init");
+    CHECK(s_au32Ring[4] == 0, "ring cleared");
+    DLOG_GetStats(&sStat);
+    CHECK((sStat.u32Dropped == 0) && (sStat.u32MaxUsed == 4) && (sStat.u32Drained == 0), "stats after init");
+
+    Reset();
+    CHECK(Pump() == 1, "one record after init");
+    CHECK(Parse() == 1, "one frame on the wire");
+    printf("  INFO 0x%08X: %u Hz, version %u\n", s_asRec[0].au32Word[0], s_asRec[0].au32Word[2], s_asRec[0].au32Word[3]);
+    CHECK((HDR_TYPE(s_asRec[0].au32Word[0]) == DLOG_TYPE_INFO) && (HDR_WORDS(s_asRec[0].au32Word[0]) == 4), "INFO header");
+    CHECK((s_asRec[0].au32Word[2] == SystemCoreClock) && (s_asRec[0].au32Word[3] == DLOG_VERSION), "INFO words");
+    CHECK(s_au32Ring[0] == 0, "sent words cleared");
+    DLOG_GetStats(&sStat);
+    CHECK(sStat.u32Drained == 1, "drained count");
+}
+
+static void TestFmt(void)
+{
+    uint32_t au32Args[10] = { 0xFFFFFFFF, 7, 0x80000000, 3, 4, 5, 6, 7, 8, 9 };
+    uint32_t u32Time = 0, i, j;
+
+    printf("\n[2] Messages of 0 to 8 arguments\n");
+    Reset();
+    s_u32NextSeq = 1;
+    DLOG(s_apcFmt[0]);
+    DLOG(s_apcFmt[1], -1);
+    DLOG(s_apcFmt[2], -1, 7);
+    DLOG(s_apcFmt[3], -1, 7, 0x80000000);
+    DLOG(s_apcFmt[4], -1, 7, 0x80000000, 3);
+    DLOG(s_apcFmt[5], -1, 7, 0x80000000, 3, 4);
+    DLOG(s_apcFmt[6], -1, 7, 0x80000000, 3, 4, 5);
+    DLOG(s_apcFmt[7], -1, 7, 0x80000000, 3, 4, 5, 6);
+    DLOG(s_apcFmt[8], -1, 7, 0x80000000, 3, 4, 5, 6, 7);
+    DLOG_Write(s_apcFmt[8], 10, au32Args);
+
+    CHECK(Pump() == 10, "records drained");
+    CHECK(Parse() == 10, "frames on the wire");
+    for (i = 0; i < 10; i++)
+    {
+        uint32_t u32Argc = (i < 9) ? i : 8;
+
+        CHECK(IsFmt(&s_asRec[i], s_apcFmt[u32Argc], u32Argc), "message %u header 0x%08X", i, s_asRec[i].au32Word[0]);
+        for (j = 0; j < u32Argc; j++)
+            CHECK(s_asRec[i].au32Word[3 + j] == au32Args[j], "message %u argument %u", i, j);
+        if (i > 0)
+            CHECK(s_asRec[i].au32Word[1] > u32Time, "message %u timestamp", i);
+        u32Time = s_asRec[i].au32Word[1];
+    }
+    CHECK(s_u32Skipped == 0, "%u bytes between frames", s_u32Skipped);
+}
+
+static void PutStr(uint32_t u32Ipsr, const char *pcText)
+{
+    s_u32Ipsr = u32Ipsr;
+    while (*pcText != '\0')
+        DLOG_PutChar(*pcText++);
+}
+
+static void TestText(void)
+{
+    char acText[150], acRest[7];
+    const char *pcLine = "line one\n";
+    uint32_t u32Head, i;
+
+    printf("\n[3] Text records and printf() lines\n");
+    for (i = 0; i < sizeof(acText); i++)
+        acText[i] = (char)('A' + i % 26);
+
+    Reset();
+    s_u32NextSeq = 11;
+    DLOG_Text(acText, sizeof(acText));
+    CHECK(Pump() == 3, "150 bytes in three records");
+    CHECK(Parse() == 3, "frames on the wire");
+    CHECK(IsText(&s_asRec[0], acText, 64) && IsText(&s_asRec[1], acText + 64, 64) && IsText(&s_asRec[2], acText + 128, 22),
+          "text split at DLOG_TEXT_MAX");
+
+    Reset();
+    s_u32NextSeq = 14;
+    u32Head = s_u32Head;
+    for (i = 0; pcLine[i + 1] != '\0'; i++)
+        DLOG_PutChar(pcLine[i]);
+    CHECK(s_u32Head == u32Head, "line recorded before its end");
+    DLOG_PutChar('\n');
+    for (i = 0; i < 70; i++)
+        DLOG_PutChar(acText[i]);
+    DLOG_PutChar('\n');
+    CHECK(Pump() == 3, "a line, then a long one in two records");
+    CHECK(Parse() == 3, "frames on the wire");
+    CHECK(IsText(&s_asRec[0], pcLine, 9), "line");
+    CHECK(IsText(&s_asRec[1], acText, 64), "long line, first record");
+    memcpy(acRest, acText + 64, 6);
+    acRest[6] = '\n';
+    CHECK(IsText(&s_asRec[2], acRest, 7), "long line, rest");
+
+    /* Handlers gather their own lines: a thread line stays whole, a preempted handler line is cut */
+    Reset();
+    s_u32NextSeq = 17;
+    PutStr(0, "thread ");
+    PutStr(16 + TMR0_IRQn, "tick");
+    PutStr(16 + UART0_IRQn, "uart\n");
+    PutStr(16 + TMR0_IRQn, " done\n");
+    PutStr(0, "line\n");
+    PutStr(3, "fault");
+    CHECK(Pump() == 5, "a record per line, not per character");
+    CHECK(Parse() == 5, "frames on the wire");
+    CHECK(IsText(&s_asRec[0], "tick", 4), "handler line cut by a nested handler");
+    CHECK(IsText(&s_asRec[1], "uart\n", 5), "nested handler line");
+    CHECK(IsText(&s_asRec[2], " done\n", 6), "rest of the handler line");
+    CHECK(IsText(&s_asRec[3], "thread line\n", 12), "thread line across the handlers");
+    CHECK(IsText(&s_asRec[4], "fault", 5), "open line sent by the drain");
+    s_u32Ipsr = 0;
+}
+
+static void TestFull(void)
+{
+    uint8_t au8Fill[TX_SIZE - 36];
+    DLOG_STAT_T sStat;
+    uint32_t u32Drop, i;
+
+    printf("\n[4] Ring full: messages refused, DROP record where they were lost\n");
+    CHECK(DLOG_Init(s_au32Small, SMALL_RING) == DLOG_OK, "init");
+    for (i = 0; i < 12; i++)
+        DLOG(s_apcFmt[1], i);
+    DLOG_GetStats(&sStat);
+    printf("  dropped %u, highest fill %u of %u words\n", sStat.u32Dropped, sStat.u32MaxUsed, SMALL_RING);
+    CHECK((sStat.u32Dropped == 5) && (sStat.u32MaxUsed == SMALL_RING), "7 of 12 messages fit");
+
+    /* A nearly full TX ring lets two records out; two more messages fit in their place */
+    memset(au8Fill, 0, sizeof(au8Fill));
+    CHECK(UART_BufWrite(&s_sUart, au8Fill, sizeof(au8Fill)) == sizeof(au8Fill), "filler");
+    CHECK(DLOG_Drain(&s_sUart) == 2, "records with the TX ring nearly full");
+    DLOG(s_apcFmt[1], 100);
+    DLOG(s_apcFmt[1], 101);
+
+    Reset();
+    CHECK(Pump() == 9, "rest of the records");
+    CHECK(Parse() == 11, "frames on the wire");
+    CHECK(s_u32Skipped == sizeof(au8Fill), "filler skipped");
+    CHECK(HDR_TYPE(s_asRec[0].au32Word[0]) == DLOG_TYPE_INFO, "INFO first");
+    for (i = 0; i < 7; i++)
+        CHECK(IsFmt(&s_asRec[1 + i], s_apcFmt[1], 1) && (s_asRec[1 + i].au32Word[3] == i), "message %u", i);
+    CHECK((HDR_TYPE(s_asRec[8].au32Word[0]) == DLOG_TYPE_DROP) && (s_asRec[8].au32Word[2] == 5),
+          "DROP of 5 after the messages kept, type %u count %u", HDR_TYPE(s_asRec[8].au32Word[0]), s_asRec[8].au32Word[2]);
+    CHECK(IsFmt(&s_asRec[9], s_apcFmt[1], 1) && (s_asRec[9].au32Word[3] == 100) &&
+          IsFmt(&s_asRec[10], s_apcFmt[1], 1) && (s_asRec[10].au32Word[3] == 101), "messages after the DROP");
+
+    /* The count goes out once */
+    u32Drop = s_asRec[8].au32Word[2];
+    DLOG(s_apcFmt[1], 103);
+    Reset();
+    s_u32NextSeq = 11;
+    CHECK((Pump() == 1) && (Parse() == 1) && IsFmt(&s_asRec[0], s_apcFmt[1], 1), "no second DROP");
+    DLOG_GetStats(&sStat);
+    CHECK((sStat.u32Dropped == u32Drop) && (sStat.u32Drained == 12), "stats %u dropped, %u drained", sStat.u32Dropped, sStat.u32Drained);
+}
+
+static void TestReserved(void)
+{
+    uint32_t u32Head, u32Time;
+
+    printf("\n[5] A record reserved but not written holds back the drain\n");
+    CHECK(DLOG_Init(s_au32Ring, RING_SIZE) == DLOG_OK, "init");
+    Reset();
+    CHECK((Pump() == 1) && (Parse() == 1), "INFO");
+
+    /* The interrupted writer: words reserved, header not stored yet */
+    u32Head = DLOG_Reserve(4, &u32Time);
+    DLOG(s_apcFmt[0]);
+    CHECK(Pump() == 0, "drained past the reserved record");
+
+    DLOG_Put(u32Head, 1, u32Time);
+    DLOG_Put(u32Head, 2, ADDR(s_apcFmt[1]));
+    DLOG_Put(u32Head, 3, 42);
+    DLOG_Commit(u32Head, DLOG_HDR(DLOG_TYPE_FMT, 1, 4));
+    Reset();
+    s_u32NextSeq = 1;
+    CHECK(Pump() == 2, "both records once complete");
+    CHECK(Parse() == 2, "frames on the wire");
+    CHECK(IsFmt(&s_asRec[0], s_apcFmt[1], 1) && (s_asRec[0].au32Word[3] == 42) && IsFmt(&s_asRec[1], s_apcFmt[0], 0),
+          "records in reservation order");
+}
+
+static void TestNested(void)
+{
+    uint32_t u32Outer = 0, u32Nested = 0, u32Time = 0, u32Unordered = 0, i, j;
+    DLOG_STAT_T sStat;
+
+    printf("\n[6] Messages nested up to three deep at random points\n");
+    CHECK(DLOG_Init(s_au32BigRing, BIG_RING_SIZE) == DLOG_OK, "init");
+    s_u32Nested = 0;
+    s_u32MaxDepth = 0;
+    memset(s_au8Seen, 0, sizeof(s_au8Seen));
+    Reset();
+
+    for (i = 0; i < NEST_MSGS; i += 8)
+    {
+        for (j = i; j < i + 8; j++)
+        {
+            s_u32Preempt = Rand() % 3;
+            DLOG(s_apcFmt[2], j, j * 3);
+        }
+        s_u32Preempt = 0;
+        Pump();
+        Parse();
+
+        for (j = 0; j < s_u32RecCnt; j++)
+        {
+            const REC_T *psRec = &s_asRec[j];
+
+            if (HDR_TYPE(psRec->au32Word[0]) == DLOG_TYPE_INFO)
+                continue;
+            if (psRec->au32Word[1] < u32Time)
+                u32Unordered++;
+            u32Time = psRec->au32Word[1];
+
+            if (IsFmt(psRec, s_apcFmt[2], 2))
+            {
+                CHECK((psRec->au32Word[3] == u32Outer) && (psRec->au32Word[4] == u32Outer * 3), "message %u", u32Outer);
+                u32Outer++;
+            }
+            else if (IsFmt(psRec, s_acNested, 2))
+            {
+                /* A deeper message is reserved ahead of the one it interrupted */
+                CHECK((psRec->au32Word[3] < sizeof(s_au8Seen)) && (s_au8Seen[psRec->au32Word[3]]++ == 0),
+                      "nested message %u", psRec->au32Word[3]);
+                u32Nested++;
+            }
+            else
+            {
+                CHECK(0, "unexpected record 0x%08X", psRec->au32Word[0]);
+            }
+        }
+        s_u32RecCnt = 0;
+    }
+
+    DLOG_GetStats(&sStat);
+    printf("  %u messages, %u nested, deepest %u, highest fill %u words\n", u32Outer, u32Nested, s_u32MaxDepth, sStat.u32MaxUsed);
+    CHECK((u32Outer == NEST_MSGS) && (u32Nested == s_u32Nested), "messages lost");
+    CHECK(s_u32MaxDepth == 3, "nesting depth");
+    CHECK(u32Unordered == 0, "%u records out of time order", u32Unordered);
+    CHECK(sStat.u32Dropped == 0, "dropped");
+}
+
+static void TestCapture(const char *pcFile)
+{
+    static const char s_acBoot[] = "boot: reset cause 0x%08X, %d retries, %s\n";
+    static uint32_t s_au32Capture[64];
+    uint32_t i;
+    FILE *fp;
+
+    printf("\n[7] Capture for the host decoder\n");
+    s_pu8Capture = malloc(WIRE_SIZE);
+    s_u32CaptureLen = 0;
+    Reset();
+
+    /* 1 us a cycle count read, at SystemCoreClock */
+    s_u32Now = 0;
+    s_u32Step = SystemCoreClock / 1000000;
+    CHECK(DLOG_Init(s_au32Capture, 64) == DLOG_OK, "init");
+    DLOG(s_acBoot, 0x00000001, 3, "watchdog");
+    DLOG("adc: ch%u = %d mV (%c)\n", 4, -125, 'n');
+    DLOG("pdma: desc %p, %5u bytes, %-4x|%04x|%%\n", 0x20001000, 512, 0xAB, 0xCD);
+    DLOG_Text("text from printf()\n", 19);
+    DLOG("no newline, ");
+    DLOG("continued %lu\n", 12345678);
+    Pump();
+
+    for (i = 0; i < 40; i++)
+        DLOG("burst %u of 40\n", i + 1);
+    s_u32Step = SystemCoreClock / 100;
+    Pump();
+    DLOG("after the burst: %u%% done\n", 100);
+    Pump();
+    Parse();
+
+    printf("  %u bytes, %u frames\n", s_u32CaptureLen, s_u32NextSeq);
+    CHECK((s_u32RecCnt == s_u32NextSeq) && (s_u32Skipped == 0), "capture parsed");
+    CHECK(HDR_TYPE(s_asRec[s_u32RecCnt - 2].au32Word[0]) == DLOG_TYPE_DROP, "DROP in the capture");
+
+    if ((pcFile != NULL) && ((fp = fopen(pcFile, "wb")) != NULL))
+    {
+        fwrite(s_pu8Capture, 1, s_u32CaptureLen, fp);
+        fclose(fp);
+        printf("  written to %s\n", pcFile);
+    }
+
+    free(s_pu8Capture);
+    s_pu8Capture = NULL;
+    s_u32Step = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (HOSTSIM_TestBegin("Deferred binary log", SimInit) != 0)
+        return 1;
+
+    TestInit();
+    TestFmt();
+    TestText();
+    TestFull();
+    TestReserved();
+    TestNested();
+    TestCapture((argc > 1) ? argv[1] : NULL);
+
+    return HOSTSIM_TestEnd();
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,95 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host build of the CMSIS-DSP FFT benchmark in
+ *           SampleCode/CortexM4/DSP_FFTBench.
+ *
+ * @details  Build and run on a Linux host:
+ *
+ *           DSP=../../../Library/CMSIS/DSP_Lib/Source
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -DARM_MATH_CM3
+ *               -I../../CortexM4/DSP_FFTBench -I../../../Library/CMSIS/Include
+ *               main.c ../../CortexM4/DSP_FFTBench/fft_bench.c
+ *               $DSP/TransformFunctions/arm_cfft*.c $DSP/TransformFunctions/arm_rfft*.c
+ *               $DSP/TransformFunctions/arm_bitreversal.c $DSP/CommonTables/*.c
+ *               -lm -o dsp_fftbench
+ *           ./dsp_fftbench
+ *
+ *           ARM_MATH_CM3 selects the plain C paths of the library (no DSP
+ *           extension intrinsics), so the host figures rank the algorithms,
+ *           not the M4 SIMD code. Accuracy matches the M4 build apart from the
+ *           q15/q31 SIMD rounding. Times are nanoseconds on this host.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <time.h>
+#include "arm_math.h"
+#include "fft_bench.h"
+
+#define BENCH_REPEAT        50
+
+uint32_t FFTB_GetTicks(void)
+{
+    struct timespec sTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTs);
+
+    return (uint32_t)((uint64_t)sTs.tv_sec * 1000000000ull + (uint64_t)sTs.tv_nsec);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  C versions of the bit reversal routines the library only ships as Cortex-M assembly                   */
+/*  (arm_bitreversal2.S). The table holds byte offsets of 8-byte complex elements.                        */
+/*---------------------------------------------------------------------------------------------------------*/
+void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable)
+{
+    uint32_t i, a, b, u32Tmp;
+
+    for (i = 0; i < bitRevLen; i += 2)
+    {
+        a = pBitRevTable[i] >> 2;
+        b = pBitRevTable[i + 1] >> 2;
+
+        u32Tmp = pSrc[a];
+        pSrc[a] = pSrc[b];
+        pSrc[b] = u32Tmp;
+
+        u32Tmp = pSrc[a + 1];
+        pSrc[a + 1] = pSrc[b + 1];
+        pSrc[b + 1] = u32Tmp;
+    }
+}
+
+void arm_bitreversal_16(uint16_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable)
+{
+    uint32_t i, a, b;
+    uint16_t u16Tmp;
+
+    /* same table, 4-byte complex elements */
+    for (i = 0; i < bitRevLen; i += 2)
+    {
+        a = pBitRevTable[i] >> 2;
+        b = pBitRevTable[i + 1] >> 2;
+
+        u16Tmp = pSrc[a];
+        pSrc[a] = pSrc[b];
+        pSrc[b] = u16Tmp;
+
+        u16Tmp = pSrc[a + 1];
+        pSrc[a + 1] = pSrc[b + 1];
+        pSrc[b + 1] = u16Tmp;
+    }
+}
+
+int main(void)
+{
+    printf("+------------------------------------------------+\n");
+    printf("|   CMSIS-DSP FFT benchmark (host, C reference)  |\n");
+    printf("+------------------------------------------------+\n");
+
+    FFTB_Run(BENCH_REPEAT, "ns");
+
+    return 0;
+}
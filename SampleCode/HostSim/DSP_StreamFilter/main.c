@@ -0,0 +1,215 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the streaming filter engine in
+ *           SampleCode/CortexM4/DSP_StreamFilter.
+ *
+ * @details  Build and run on a Linux host:
+ *
+ *           DSP=../../../Library/CMSIS/DSP_Lib/Source
+ *           gcc -O2 -w -std=gnu99 -fno-strict-aliasing -include ../common/hostsim_cmsis.h
+ *               -DARM_MATH_CM3 -I../../CortexM4/DSP_StreamFilter -I../../../Library/CMSIS/Include
+ *               main.c ../../CortexM4/DSP_StreamFilter/stream_filter.c
+ *               $DSP/FilteringFunctions/arm_fir_decimate_*q15.c $DSP/FilteringFunctions/arm_fir_*f32.c
+ *               $DSP/FilteringFunctions/arm_biquad_cascade_df2T_*f32.c
+ *               $DSP/SupportFunctions/arm_q15_to_float.c -lm -o dsp_streamfilter
+ *           ./dsp_streamfilter
+ *
+ *           Interleaved ping-pong blocks are fed to the engine for 1 to 8
+ *           channels. Every channel output must match, bit for bit, a
+ *           per-channel chain of the same kernels with separate buffers (the
+ *           usual hand-written glue). The per-stage load is then measured with
+ *           host nanoseconds.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stream_filter.h"
+
+#define SAMPLE_RATE         16000
+#define BLOCK_SIZE          256
+#define DECIM_FACTOR        4
+#define DECIM_TAPS          32
+#define FIR_TAPS            31
+#define TEST_BLOCKS         40
+#define BENCH_BLOCKS        2000
+
+static SFLT_T s_sFlt;
+static q15_t s_ai16Decim[DECIM_TAPS];
+static float32_t s_af32Biquad[2 * 5];
+static float32_t s_af32Fir[FIR_TAPS];
+
+/* PDMA ping-pong buffer, word aligned as on the target */
+static q15_t s_ai16PingPong[2][SFLT_MAX_CHANNELS * BLOCK_SIZE] __attribute__((aligned(4)));
+
+/* Reference chain: one set of instances and buffers per channel */
+static struct
+{
+    arm_fir_decimate_instance_q15 sDecim;
+    arm_biquad_cascade_df2T_instance_f32 sBiquad;
+    arm_fir_instance_f32 sFir;
+    q15_t ai16DecimState[DECIM_TAPS + BLOCK_SIZE - 1];
+    float32_t af32BiquadState[4];
+    float32_t af32FirState[FIR_TAPS + BLOCK_SIZE / DECIM_FACTOR - 1];
+    q15_t ai16In[BLOCK_SIZE], ai16Decim[BLOCK_SIZE / DECIM_FACTOR];
+    float32_t af32Conv[BLOCK_SIZE / DECIM_FACTOR], af32Bq[BLOCK_SIZE / DECIM_FACTOR], af32Out[BLOCK_SIZE / DECIM_FACTOR];
+} s_asRef[SFLT_MAX_CHANNELS];
+
+static uint32_t GetTicks(void)
+{
+    struct timespec sTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTs);
+
+    return (uint32_t)((uint64_t)sTs.tv_sec * 1000000000ull + (uint64_t)sTs.tv_nsec);
+}
+
+/* What PDMA would have written: frames of u32Chs samples, a different tone per channel */
+static void FillBlock(q15_t *pi16Block, uint32_t u32Chs, uint32_t u32Block)
+{
+    static uint32_t s_u32Seed = 1;
+    uint32_t n, c, u32Sample;
+
+    for (n = 0; n < BLOCK_SIZE; n++)
+    {
+        u32Sample = u32Block * BLOCK_SIZE + n;
+
+        for (c = 0; c < u32Chs; c++)
+        {
+            s_u32Seed = s_u32Seed * 1664525u + 1013904223u;
+            pi16Block[n * u32Chs + c] = (q15_t)(12000.0 * sin(2.0 * PI * (150.0 + 200.0 * c) * u32Sample / SAMPLE_RATE)
+                                                + (double)((int32_t)(s_u32Seed >> 20) - 2048));
+        }
+    }
+}
+
+static void RefInit(uint32_t u32Chs)
+{
+    uint32_t c;
+
+    for (c = 0; c < u32Chs; c++)
+    {
+        arm_fir_decimate_init_q15(&s_asRef[c].sDecim, DECIM_TAPS, DECIM_FACTOR, s_ai16Decim, s_asRef[c].ai16DecimState, BLOCK_SIZE);
+        arm_biquad_cascade_df2T_init_f32(&s_asRef[c].sBiquad, 2, s_af32Biquad, s_asRef[c].af32BiquadState);
+        arm_fir_init_f32(&s_asRef[c].sFir, FIR_TAPS, s_af32Fir, s_asRef[c].af32FirState, BLOCK_SIZE / DECIM_FACTOR);
+    }
+}
+
+static void RefProcess(const q15_t *pi16Block, uint32_t u32Chs)
+{
+    uint32_t c, n;
+
+    for (c = 0; c < u32Chs; c++)
+    {
+        for (n = 0; n < BLOCK_SIZE; n++)
+            s_asRef[c].ai16In[n] = pi16Block[n * u32Chs + c];
+
+        arm_fir_decimate_q15(&s_asRef[c].sDecim, s_asRef[c].ai16In, s_asRef[c].ai16Decim, BLOCK_SIZE);
+        arm_q15_to_float(s_asRef[c].ai16Decim, s_asRef[c].af32Conv, BLOCK_SIZE / DECIM_FACTOR);
+        arm_biquad_cascade_df2T_f32(&s_asRef[c].sBiquad, s_asRef[c].af32Conv, s_asRef[c].af32Bq, BLOCK_SIZE / DECIM_FACTOR);
+        arm_fir_f32(&s_asRef[c].sFir, s_asRef[c].af32Bq, s_asRef[c].af32Out, BLOCK_SIZE / DECIM_FACTOR);
+    }
+}
+
+static void MakeConfig(SFLT_CFG_T *psCfg, uint32_t u32Chs)
+{
+    memset(psCfg, 0, sizeof(SFLT_CFG_T));
+    psCfg->u32Channels = u32Chs;
+    psCfg->u32BlockSize = BLOCK_SIZE;
+    psCfg->u32SampleRate = SAMPLE_RATE;
+    psCfg->u32DecimFactor = DECIM_FACTOR;
+    psCfg->u32DecimTaps = DECIM_TAPS;
+    psCfg->pi16DecimCoef = s_ai16Decim;
+    psCfg->u32BiquadStages = 2;
+    psCfg->pf32BiquadCoef = s_af32Biquad;
+    psCfg->u32FirTaps = FIR_TAPS;
+    psCfg->pf32FirCoef = s_af32Fir;
+    psCfg->pfnGetTicks = GetTicks;
+    psCfg->u32TickHz = 1000000000;
+}
+
+int main(void)
+{
+    static const uint32_t au32Chs[] = {1, 2, 3, 4, 8};
+    static const char *apcStage[eSFLT_STAGE_CNT] = {"deinterleave", "decimate", "q15->f32", "biquad", "fir"};
+    SFLT_CFG_T sCfg;
+    const float32_t *pf32Out;
+    uint32_t i, b, c, s, u32Len, u32Chs, u32Errors = 0;
+
+    printf("+------------------------------------------------+\n");
+    printf("|   Streaming filter engine (host check)         |\n");
+    printf("+------------------------------------------------+\n");
+
+    /* 16 kHz -> 4 kHz, 300..1500 Hz band of interest, 1.2 kHz output lowpass */
+    SFLT_DesignLowpassQ15(s_ai16Decim, DECIM_TAPS, 0.9f / (2.0f * DECIM_FACTOR));
+    SFLT_DesignBandpass(&s_af32Biquad[0], 400.0f / 4000.0f, 0.7f);
+    SFLT_DesignBandpass(&s_af32Biquad[5], 900.0f / 4000.0f, 0.7f);
+    SFLT_DesignLowpassF32(s_af32Fir, FIR_TAPS, 1200.0f / 4000.0f);
+
+    printf("\n[Verify] engine output against per-channel kernel chains, %u blocks\n", TEST_BLOCKS);
+
+    for (i = 0; i < sizeof(au32Chs) / sizeof(au32Chs[0]); i++)
+    {
+        uint32_t u32Mismatch = 0;
+
+        u32Chs = au32Chs[i];
+        MakeConfig(&sCfg, u32Chs);
+
+        if (SFLT_Init(&s_sFlt, &sCfg) != SFLT_OK)
+        {
+            printf("  FAIL: SFLT_Init(%u channels)\n", u32Chs);
+            u32Errors++;
+            continue;
+        }
+
+        RefInit(u32Chs);
+
+        for (b = 0; b < TEST_BLOCKS; b++)
+        {
+            q15_t *pi16Block = s_ai16PingPong[b & 1];
+
+            FillBlock(pi16Block, u32Chs, b);
+            SFLT_ProcessBlock(&s_sFlt, pi16Block);
+            RefProcess(pi16Block, u32Chs);
+
+            for (c = 0; c < u32Chs; c++)
+            {
+                pf32Out = SFLT_GetOutput(&s_sFlt, c, &u32Len);
+
+                if ((u32Len != BLOCK_SIZE / DECIM_FACTOR) || memcmp(pf32Out, s_asRef[c].af32Out, u32Len * sizeof(float32_t)))
+                    u32Mismatch++;
+            }
+        }
+
+        printf("  %u channel(s)%s: %s\n", u32Chs, ((u32Chs & 1) == 0) ? " (SIMD deinterleave)" : "",
+               u32Mismatch ? "MISMATCH" : "bit-exact");
+        u32Errors += u32Mismatch;
+    }
+
+    /* rejected configurations */
+    MakeConfig(&sCfg, SFLT_MAX_CHANNELS + 1);
+    u32Errors += (SFLT_Init(&s_sFlt, &sCfg) != SFLT_ERR_PARAM);
+    MakeConfig(&sCfg, 2);
+    sCfg.u32BlockSize = 250;
+    u32Errors += (SFLT_Init(&s_sFlt, &sCfg) != SFLT_ERR_PARAM);
+
+    printf("\n[Load] 8 channels, %u-sample blocks at %u Hz, %u blocks (host CPU)\n", BLOCK_SIZE, SAMPLE_RATE, BENCH_BLOCKS);
+    MakeConfig(&sCfg, 8);
+    SFLT_Init(&s_sFlt, &sCfg);
+    FillBlock(s_ai16PingPong[0], 8, 0);
+    FillBlock(s_ai16PingPong[1], 8, 1);
+
+    for (b = 0; b < BENCH_BLOCKS; b++)
+        SFLT_ProcessBlock(&s_sFlt, s_ai16PingPong[b & 1]);
+
+    for (s = 0; s < eSFLT_STAGE_CNT; s++)
+        printf("  %-14s %8.4f %%   avg %6u ns   max %6u ns\n", apcStage[s], (double)SFLT_GetStageLoad(&s_sFlt, (E_SFLT_STAGE)s),
+               (uint32_t)(s_sFlt.au64Ticks[s] / s_sFlt.u32Blocks), s_sFlt.au32MaxTicks[s]);
+
+    printf("\n%s (%u error(s))\n", u32Errors ? "FAILED" : "PASSED", u32Errors);
+
+    return u32Errors ? 1 : 0;
+}
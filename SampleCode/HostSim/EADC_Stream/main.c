@@ -0,0 +1,442 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the EADC continuous acquisition API
+ *           (EADC_StreamOpen() ... EADC_StreamReleaseBlock()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../../../Library/StdDriver/src/eadc.c
+ *               ../../../Library/StdDriver/src/pdma.c ../../../Library/StdDriver/src/sys.c
+ *               -o eadc_stream
+ *           ./eadc_stream
+ *
+ *           A small model of EADC0 and of PDMA0 scatter-gather mode stands in
+ *           for the hardware: every trigger converts all stream modules in
+ *           order, each conversion is one single PDMA request from CURDAT, and
+ *           PDMA walks the descriptor chain exactly as the driver built it in
+ *           the simulated SRAM. Checked are sample order and content across
+ *           block boundaries, sequence numbers and timestamps, the overrun,
+ *           late-consumer and trigger-overrun statistics, and blocks that
+ *           complete while the PDMA interrupt is held back.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+
+#define MODULE_CNT          4
+#define BLOCK_FRAMES        64
+#define BLOCK_CNT           4
+#define FRAME_PERIOD_US     125         /* 8 kHz trigger */
+
+#define SRAM_SIM_SIZE       0x20000ul
+#define STREAM_MEM_BASE     (SRAM_BASE + 0x10000ul)    /* Above the SCATBA reset window */
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asDesc[BLOCK_CNT];
+    uint16_t au16Buf[BLOCK_CNT * BLOCK_FRAMES * MODULE_CNT];
+    EADC_STREAM_BLK_T asBlk[BLOCK_CNT];
+} STREAM_MEM_T;
+
+static STREAM_MEM_T *s_psMem = (STREAM_MEM_T *)STREAM_MEM_BASE;
+static EADC_STREAM_T s_sStream;
+static const uint32_t s_au32Channel[MODULE_CNT] = {0, 1, 2, 3};
+
+/* Model state */
+static uint32_t s_u32Frame;             /* Triggers since EADC_StreamStart() */
+static uint32_t s_u32NowUs;             /* Simulated time */
+static uint32_t s_u32OverrunNext;       /* Next trigger finds the converter busy */
+static uint32_t s_u32DescLoaded, s_u32Remain;
+static uint32_t s_u32IrqHeld;           /* The test holds the PDMA interrupt back */
+
+static uint32_t GetTimeUs(void)
+{
+    return s_u32NowUs;
+}
+
+/* Value converted by module u32Module on trigger u32Frame */
+static uint16_t SampleValue(uint32_t u32Frame, uint32_t u32Module)
+{
+    return (uint16_t)((u32Frame * 7u + u32Module * 1000u) & 0xFFFu);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  EADC0 / PDMA0 model                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t SimWrite(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    uint32_t u32Base = (uint32_t)(uintptr_t)pvPriv;
+
+    if ((u32Base == EADC0_BASE) && (u32Offset == offsetof(EADC_T, OVSTS)))
+        return u32Old & ~u32New;
+
+    if ((u32Base == PDMA0_BASE) && ((u32Offset == offsetof(PDMA_T, TDSTS)) || (u32Offset == offsetof(PDMA_T, INTSTS))))
+        return u32Old & ~u32New;
+
+    return u32New;
+}
+
+void PDMA0_IRQHandler(void)
+{
+    if (PDMA0->TDSTS & (1UL << s_sStream.sCfg.u32PdmaCh))
+        EADC_StreamIRQHandler(&s_sStream);
+}
+
+/* Scatter-gather: fetch the table at SCATBA + NEXT into the channel registers (PDMA0 unlocked) */
+static void SimPdmaFetch(uint32_t u32Ch)
+{
+    DSCT_T *psDesc = (DSCT_T *)(uintptr_t)((PDMA0->SCATBA & PDMA_SCATBA_SCATBA_Msk) + PDMA0->DSCT[u32Ch].NEXT);
+
+    PDMA0->DSCT[u32Ch].CTL = psDesc->CTL;
+    PDMA0->DSCT[u32Ch].SA = psDesc->SA;
+    PDMA0->DSCT[u32Ch].DA = psDesc->DA;
+    PDMA0->DSCT[u32Ch].NEXT = psDesc->NEXT;
+    *(uint32_t *)&PDMA0->CURSCAT[u32Ch] = (uint32_t)(uintptr_t)psDesc;
+    s_u32Remain = ((psDesc->CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos) + 1;
+    s_u32DescLoaded = 1;
+}
+
+/* Run the PDMA interrupt unless the test holds it back, as a higher priority ISR would */
+static void SimPdmaIrq(void)
+{
+    if (!s_u32IrqHeld && (PDMA0->INTEN & PDMA0->TDSTS))
+        PDMA0_IRQHandler();
+}
+
+/* One PDMA single request on the channel whose request source is EADC0 */
+static void SimPdmaRequest(uint32_t u32Ch)
+{
+    uint32_t u32Ctl;
+
+    HOSTSIM_Unlock(PDMA0_BASE);
+
+    if (!s_u32DescLoaded)
+        SimPdmaFetch(u32Ch);
+
+    *(uint16_t *)(uintptr_t)PDMA0->DSCT[u32Ch].DA = *(uint16_t *)(uintptr_t)PDMA0->DSCT[u32Ch].SA;
+    PDMA0->DSCT[u32Ch].DA += 2;
+
+    if (--s_u32Remain == 0)
+    {
+        u32Ctl = PDMA0->DSCT[u32Ch].CTL;
+        s_u32DescLoaded = 0;
+
+        /* The next table is loaded right away, so CURSCAT moves on before the interrupt */
+        if ((u32Ctl & PDMA_DSCT_CTL_OPMODE_Msk) != PDMA_OP_SCATTER)
+            PDMA0->CHCTL &= ~(1UL << u32Ch);
+        else
+            SimPdmaFetch(u32Ch);
+
+        PDMA0->TDSTS |= (1UL << u32Ch);
+        PDMA0->INTSTS |= PDMA_INTSTS_TDIF_Msk;
+        HOSTSIM_Lock(PDMA0_BASE);
+
+        if (!(u32Ctl & PDMA_DSCT_CTL_TBINTDIS_Msk))
+            SimPdmaIrq();
+
+        return;
+    }
+
+    HOSTSIM_Lock(PDMA0_BASE);
+}
+
+/* Channel whose REQSEL field selects EADC0 */
+static int32_t SimPdmaFindCh(void)
+{
+    volatile uint32_t *pu32ReqSel = &PDMA0->REQSEL0_3;
+    uint32_t u32Ch;
+
+    for (u32Ch = 0; u32Ch < 16; u32Ch++)
+    {
+        if ((PDMA0->CHCTL & (1UL << u32Ch)) && (((pu32ReqSel[u32Ch >> 2] >> ((u32Ch & 3) * 8)) & 0x7F) == PDMA_EADC0_RX))
+            return (int32_t)u32Ch;
+    }
+
+    return -1;
+}
+
+/* One trigger: every PDMA enabled module converts, in module order */
+static void SimTrigger(void)
+{
+    int32_t i32Ch = SimPdmaFindCh();
+    uint32_t u32Module;
+
+    s_u32NowUs += FRAME_PERIOD_US;
+
+    HOSTSIM_Unlock(EADC0_BASE);
+
+    if (s_u32OverrunNext)
+    {
+        EADC0->OVSTS |= EADC0->PDMACTL;
+        s_u32OverrunNext = 0;
+    }
+
+    HOSTSIM_Lock(EADC0_BASE);
+
+    for (u32Module = 0; u32Module < EADC_STREAM_MAX_MODULES; u32Module++)
+    {
+        if (!(EADC0->PDMACTL & (1UL << u32Module)))
+            continue;
+
+        HOSTSIM_Unlock(EADC0_BASE);
+        *(uint32_t *)&EADC0->CURDAT = SampleValue(s_u32Frame, u32Module);
+        HOSTSIM_Lock(EADC0_BASE);
+
+        if (i32Ch >= 0)
+            SimPdmaRequest((uint32_t)i32Ch);
+    }
+
+    s_u32Frame++;
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(EADC0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(PDMA0_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_TrapWrites(EADC0_BASE, HOSTSIM_PAGE_SIZE, SimWrite, (void *)(uintptr_t)EADC0_BASE) != HOSTSIM_OK) ||
+            (HOSTSIM_TrapWrites(PDMA0_BASE, HOSTSIM_PAGE_SIZE, SimWrite, (void *)(uintptr_t)PDMA0_BASE) != HOSTSIM_OK))
+        return -1;
+
+    /* SCATBA resets to the SRAM base, not 0 */
+    PDMA0->SCATBA = SRAM_BASE;
+
+    return 0;
+}
+
+static void Produce(uint32_t u32Blocks)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Blocks * BLOCK_FRAMES; i++)
+        SimTrigger();
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t BlockIntact(const EADC_STREAM_BLK_T *psBlk)
+{
+    uint32_t f, m;
+
+    for (f = 0; f < BLOCK_FRAMES; f++)
+    {
+        for (m = 0; m < MODULE_CNT; m++)
+        {
+            if (psBlk->pu16Data[f * MODULE_CNT + m] != SampleValue(psBlk->u32Seq * BLOCK_FRAMES + f, m))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void Restart(void)
+{
+    EADC_StreamStop(&s_sStream);
+    EADC_StreamClearStats(&s_sStream);
+    s_u32Frame = 0;
+    s_u32DescLoaded = 0;
+    EADC_StreamStart(&s_sStream);
+}
+
+static void TestPromptConsumer(void)
+{
+    EADC_STREAM_BLK_T *psBlk;
+    uint32_t i, u32Got = 0, u32Bad = 0, u32Seq = 0, u32LastTs = 0;
+
+    printf("\n[1] Prompt consumer, 200 blocks\n");
+    Restart();
+
+    for (i = 0; i < 200 * BLOCK_FRAMES; i++)
+    {
+        SimTrigger();
+
+        while ((psBlk = EADC_StreamGetBlock(&s_sStream)) != NULL)
+        {
+            if (!BlockIntact(psBlk) || (psBlk->u32Seq != u32Seq) ||
+                    ((u32Got > 0) && (psBlk->u32Timestamp - u32LastTs != BLOCK_FRAMES * FRAME_PERIOD_US)))
+                u32Bad++;
+
+            u32LastTs = psBlk->u32Timestamp;
+            u32Seq++;
+            u32Got++;
+            u32Bad += (EADC_StreamReleaseBlock(&s_sStream) != 0);
+        }
+    }
+
+    printf("  blocks %u, bad %u, overruns %u, late %u, max fill %u\n", u32Got, u32Bad,
+           s_sStream.u32Overruns, s_sStream.u32LateBlocks, s_sStream.u32MaxFill);
+    CHECK(u32Got == 200, "expected 200 blocks");
+    CHECK(u32Bad == 0, "corrupt, missing or mistimed blocks");
+    CHECK((s_sStream.u32Overruns == 0) && (s_sStream.u32LateBlocks == 0) && (s_sStream.u32MaxFill == 1), "statistics");
+}
+
+static void TestStalledConsumer(void)
+{
+    EADC_STREAM_BLK_T *psBlk;
+    uint32_t u32Got = 0, u32Bad = 0, u32First = 0;
+
+    printf("\n[2] Consumer stalled for 50 blocks, then drains\n");
+    Restart();
+    Produce(50);
+
+    while ((psBlk = EADC_StreamGetBlock(&s_sStream)) != NULL)
+    {
+        if (u32Got == 0)
+            u32First = psBlk->u32Seq;
+
+        u32Bad += !BlockIntact(psBlk) || (psBlk->u32Seq != u32First + u32Got);
+        u32Bad += (EADC_StreamReleaseBlock(&s_sStream) != 0);
+        u32Got++;
+    }
+
+    printf("  drained %u blocks from seq %u, bad %u, overruns %u, max latency %u us\n", u32Got, u32First, u32Bad,
+           s_sStream.u32Overruns, s_sStream.u32MaxLatency);
+    CHECK((u32Got == BLOCK_CNT - 1) && (u32First == 50 - (BLOCK_CNT - 1)), "newest %u blocks expected", BLOCK_CNT - 1);
+    CHECK(u32Bad == 0, "corrupt blocks after overrun");
+    CHECK(s_sStream.u32Overruns == 50 - (BLOCK_CNT - 1), "overrun count");
+    CHECK(s_sStream.u32MaxLatency == (BLOCK_CNT - 2) * BLOCK_FRAMES * FRAME_PERIOD_US, "latency");
+}
+
+static void TestLateConsumer(void)
+{
+    EADC_STREAM_BLK_T *psBlk;
+    int32_t i32Ret1, i32Ret2;
+
+    printf("\n[3] Consumer holds a block while PDMA laps the ring\n");
+    Restart();
+    Produce(1);
+    psBlk = EADC_StreamGetBlock(&s_sStream);
+    Produce(BLOCK_CNT - 2);
+    i32Ret1 = EADC_StreamReleaseBlock(&s_sStream);
+
+    psBlk = EADC_StreamGetBlock(&s_sStream);
+    Produce(BLOCK_CNT);
+    i32Ret2 = EADC_StreamReleaseBlock(&s_sStream);
+
+    printf("  release in time %d, release after lap %d, late %u\n", i32Ret1, i32Ret2, s_sStream.u32LateBlocks);
+    CHECK((psBlk != NULL) && (i32Ret1 == 0) && (i32Ret2 == EADC_STREAM_LATE_ERR), "release status");
+    CHECK(s_sStream.u32LateBlocks == 1, "late count");
+}
+
+static void TestTriggerOverrun(void)
+{
+    uint32_t i;
+
+    printf("\n[4] Converter busy on 3 triggers\n");
+    Restart();
+
+    for (i = 0; i < 3; i++)
+    {
+        s_u32OverrunNext = 1;
+        Produce(1);
+    }
+
+    printf("  trigger overruns %u, OVSTS 0x%08X\n", s_sStream.u32TriggerOverruns, EADC0->OVSTS);
+    CHECK(s_sStream.u32TriggerOverruns == 3 * MODULE_CNT, "trigger overrun count");
+    CHECK(EADC0->OVSTS == 0, "OVSTS not cleared");
+}
+
+static void TestDelayedIrq(void)
+{
+    EADC_STREAM_BLK_T *psBlk;
+    uint32_t i, u32Got = 0, u32Bad = 0;
+
+    printf("\n[5] PDMA interrupt delayed until two blocks are done, 20 times\n");
+    Restart();
+
+    for (i = 0; i < 20; i++)
+    {
+        s_u32IrqHeld = 1;
+        Produce(2);
+        s_u32IrqHeld = 0;
+        SimPdmaIrq();
+
+        while ((psBlk = EADC_StreamGetBlock(&s_sStream)) != NULL)
+        {
+            u32Bad += !BlockIntact(psBlk) || (psBlk->u32Seq != u32Got);
+            u32Bad += (EADC_StreamReleaseBlock(&s_sStream) != 0);
+            u32Got++;
+        }
+    }
+
+    printf("  blocks %u, bad %u, merged %u, overruns %u\n", u32Got, u32Bad, s_sStream.u32MergedBlocks,
+           s_sStream.u32Overruns);
+    CHECK(u32Got == 40, "expected 40 blocks");
+    CHECK(u32Bad == 0, "corrupt or missing blocks after merged completions");
+    CHECK((s_sStream.u32MergedBlocks == 20) && (s_sStream.u32Overruns == 0), "statistics");
+}
+
+static void TestRejected(void)
+{
+    EADC_STREAM_CFG_T sCfg = s_sStream.sCfg;
+
+    sCfg.u32BlockCnt = 1;
+    CHECK(EADC_StreamOpen(EADC0, &s_sStream, &sCfg) == EADC_STREAM_PARAM_ERR, "ring of one block accepted");
+    sCfg = s_sStream.sCfg;
+    sCfg.u32BlockFrames = 0x10000 / MODULE_CNT + 1;
+    CHECK(EADC_StreamOpen(EADC0, &s_sStream, &sCfg) == EADC_STREAM_PARAM_ERR, "oversized block accepted");
+    sCfg = s_sStream.sCfg;
+    sCfg.u32ScatMode = PDMA_SCATBA_SHARED;
+    PDMA0->SCATBA = SRAM_BASE;
+    CHECK(EADC_StreamOpen(EADC0, &s_sStream, &sCfg) == EADC_STREAM_PARAM_ERR, "descriptors outside a shared SCATBA window accepted");
+    CHECK(PDMA0->SCATBA == SRAM_BASE, "shared SCATBA changed");
+    PDMA0->SCATBA = STREAM_MEM_BASE;
+    CHECK(EADC_StreamOpen(EADC0, &s_sStream, &sCfg) == 0, "descriptors inside a shared SCATBA window rejected");
+}
+
+int main(void)
+{
+    EADC_STREAM_CFG_T sCfg;
+
+    if (HOSTSIM_TestBegin("EADC continuous acquisition", SimInit) != 0)
+        return 1;
+
+    printf("%u modules, %u frames per block, %u blocks in the ring\n", MODULE_CNT, BLOCK_FRAMES, BLOCK_CNT);
+
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.pdma = PDMA0;
+    sCfg.u32PdmaCh = 5;
+    sCfg.u32ModuleCnt = MODULE_CNT;
+    sCfg.pu32Channel = s_au32Channel;
+    sCfg.u32TriggerSrc = EADC_TIMER0_TRIGGER;
+    sCfg.u32BlockFrames = BLOCK_FRAMES;
+    sCfg.u32BlockCnt = BLOCK_CNT;
+    sCfg.pu16Buf = s_psMem->au16Buf;
+    sCfg.psDesc = s_psMem->asDesc;
+    sCfg.u32ScatMode = PDMA_SCATBA_SET;
+    sCfg.psBlk = s_psMem->asBlk;
+    sCfg.pfnGetTime = GetTimeUs;
+
+    /* EADC_Open() is skipped: it waits for a calibration the model does not run */
+    if (EADC_StreamOpen(EADC0, &s_sStream, &sCfg) != 0)
+    {
+        printf("EADC_StreamOpen failed\n");
+        return 1;
+    }
+
+    CHECK((EADC0->SCTL[3] & EADC_SCTL_TRGSEL_Msk) == EADC_TIMER0_TRIGGER, "sample module trigger");
+    CHECK(PDMA0->SCATBA == STREAM_MEM_BASE, "SCATBA not claimed from its reset value");
+
+    TestPromptConsumer();
+    TestStalledConsumer();
+    TestLateConsumer();
+    TestTriggerOverrun();
+    TestDelayedIrq();
+    TestRejected();
+
+    return HOSTSIM_TestEnd();
+}
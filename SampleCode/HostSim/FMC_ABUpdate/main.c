@@ -0,0 +1,476 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check and benchmark of the dual bank firmware update
+ *           (FMC_UpdInit() ... FMC_UpdConfirm()) with full and delta packages.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               -I../../StdDriver/FMC_ABUpdate/HostTool -DABPATCH_NO_MAIN
+ *               main.c ../common/hostsim.c ../common/sim_fmc.c ../common/sim_crypto.c
+ *               ../../../Library/StdDriver/src/fmc.c
+ *               ../../StdDriver/FMC_ABUpdate/HostTool/abpatch.c
+ *               -o fmc_abupdate
+ *           ./fmc_abupdate
+ *
+ *           The FMC model of ../common/sim_fmc.c carries both APROM banks with
+ *           typical program and erase times, one tick per microsecond, and the
+ *           CRC and SHA models of ../common/sim_crypto.c check records and
+ *           pages. Packages are built by the HostTool of the sample and arrive
+ *           over a 115200 baud UART with flow control: at each receive
+ *           interrupt, 16 bytes at a time, the main loop hands them to
+ *           FMC_UpdWrite() and calls FMC_UpdPoll(), and the model runs until
+ *           the next interrupt or the end of the flash command.
+ *           Checked and measured: a full and a delta update with update time
+ *           and downtime against a single bank bootloader, trial boot, confirm
+ *           and rollback, a package sent again, back pressure from a fast
+ *           link, rejected packages leaving both images intact, and power
+ *           failures torn into every phase of an update.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_fmc.h"
+#include "sim_crypto.h"
+#include "abpatch.h"
+
+#define SLOT_SIZE           0x40000ul       /* 256 KB of each bank: up to 252 KB of image and the trailer page */
+#define IMAGE_SIZE          180000ul
+#define PKG_MAX             (IMAGE_SIZE + 0x10000ul)
+
+#define BAUD                115200u
+#define RX_RING             256ul           /* Receive buffer; the sender holds while it is full */
+#define FAST_CHUNK          4096ul          /* Link faster than the flash: a whole buffer at once */
+#define RX_BURST            16ul            /* Receive interrupt at this RX FIFO level */
+#define POWER_CUTS          40
+#define CUT_SIZE            12000ul         /* Image of the rejected package and power cut checks */
+
+static FMC_UPD_T s_sUpd;
+static uint8_t s_au8V0[IMAGE_SIZE], s_au8V1[IMAGE_SIZE], s_au8V2[IMAGE_SIZE + 512], s_au8V3[IMAGE_SIZE];
+static uint8_t s_au8Pkg[PKG_MAX], s_au8Bad[PKG_MAX], s_au8Slot[SLOT_SIZE];
+static uint32_t s_u32V2Len;
+static uint32_t s_u32Seed = 0x2545F491;
+
+/* One receive and flash run */
+typedef struct
+{
+    int32_t  i32Result;
+    uint32_t u32Ticks;              /* First byte sent to commit */
+    uint32_t u32Polls;              /* FMC_UpdPoll() calls */
+    uint32_t u32Holds;              /* Times the sender was held by flow control */
+} RUN_T;
+
+static uint32_t Rand(void)
+{
+    s_u32Seed ^= s_u32Seed << 13;
+    s_u32Seed ^= s_u32Seed >> 17;
+    s_u32Seed ^= s_u32Seed << 5;
+    return s_u32Seed;
+}
+
+/* Something like code: short runs of repeated instruction patterns, a literal pool, erased tail */
+static void MakeImage(uint8_t *pu8Img, uint32_t u32Len)
+{
+    uint32_t i, j, u32Run;
+
+    for (i = 0; i < u32Len;)
+    {
+        u32Run = 16 + Rand() % 96;
+        for (j = 0; (j < u32Run) && (i < u32Len); j++, i++)
+            pu8Img[i] = (uint8_t)((j & 1) ? (0x40 | (Rand() & 0x0F)) : Rand());
+    }
+}
+
+/* Next firmware version: a function grows in the middle, a few constants change, the build id moves */
+static uint32_t MakeNext(uint8_t *pu8New, const uint8_t *pu8Old, uint32_t u32Len)
+{
+    uint32_t i;
+
+    memcpy(pu8New, pu8Old, 40000);
+    for (i = 0; i < 320; i++)
+        pu8New[40000 + i] = (uint8_t)Rand();
+    memcpy(pu8New + 40320, pu8Old + 40000, u32Len - 40000);
+    u32Len += 320;
+
+    for (i = 0; i < 12; i++)
+        pu8New[90000 + i * 7000] ^= (uint8_t)(1 + i);
+    memcpy(pu8New + 256, "build 2023-06-02", 16);
+
+    return u32Len;
+}
+
+/* The image a bank holds, as the trailer tells */
+static uint32_t BankHolds(uint32_t u32Bank, const uint8_t *pu8Img, uint32_t u32Len)
+{
+    FMC_UPD_TRAILER_T sTrl;
+
+    return (FMC_UpdReadTrailer(&s_sUpd, u32Bank, &sTrl) == FMC_UPD_OK) && (sTrl.u32Size == u32Len) &&
+           (memcmp(SIM_FMC_GetBank(u32Bank), pu8Img, u32Len) == 0) ? 1 : 0;
+}
+
+static uint32_t RunningBank(void)
+{
+    return (FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos;
+}
+
+/* Reset: FMC back to its defaults, then what the loader does first */
+static int32_t Boot(uint32_t *pu32Downtime)
+{
+    uint32_t u32Start;
+    int32_t i32Bank;
+
+    SIM_FMC_PowerOn();
+    FMC->ISPCTL |= FMC_ISPCTL_ISPEN_Msk | FMC_ISPCTL_APUEN_Msk;
+    FMC_UpdInit(&s_sUpd, SLOT_SIZE, SIM_FMC_GetTicks);
+    s_sUpd.u32MapBase = SIM_FMC_MAP_BASE;
+
+    u32Start = SIM_FMC_GetTicks();
+    i32Bank = FMC_UpdBoot(&s_sUpd);
+    if ((i32Bank >= 0) && ((uint32_t)i32Bank != RunningBank()) && (FMC_RemapBank((uint32_t)i32Bank) != 0))
+        i32Bank = FMC_UPD_ERR_FAIL;
+
+    if (pu32Downtime)
+        *pu32Downtime = SIM_FMC_GetTicks() - u32Start;
+
+    return i32Bank;
+}
+
+/* Send a package over the UART while the main loop feeds and polls the update; u32Baud 0 for a fast link */
+static void Send(const uint8_t *pu8Pkg, uint32_t u32Len, uint32_t u32Baud, RUN_T *psRun)
+{
+    uint32_t u32ByteTicks = u32Baud ? (10 * 1000000 + u32Baud / 2) / u32Baud : 0;
+    uint32_t u32Ring = u32Baud ? RX_RING : FAST_CHUNK;
+    uint32_t u32Start = SIM_FMC_GetTicks();
+    uint32_t u32NextRx = u32Start + u32ByteTicks;
+    uint32_t u32Sent = 0, u32Taken = 0, u32Now, u32Wait, u32Burst;
+    int32_t i32Ret;
+
+    memset(psRun, 0, sizeof(RUN_T));
+    if ((psRun->i32Result = FMC_UpdBegin(&s_sUpd)) != FMC_UPD_OK)
+        return;
+
+    for (;;)
+    {
+        u32Now = SIM_FMC_GetTicks();
+
+        /* Bytes that arrived meanwhile go to the receive buffer */
+        while ((u32Sent < u32Len) && ((int32_t)(u32Now - u32NextRx) >= 0))
+        {
+            if (u32Sent - u32Taken >= u32Ring)
+            {
+                u32NextRx = u32Now + u32ByteTicks;
+                psRun->u32Holds++;
+                break;
+            }
+            u32Sent++;
+            u32NextRx += u32ByteTicks;
+        }
+
+        if (u32Sent > u32Taken)
+        {
+            if ((i32Ret = FMC_UpdWrite(&s_sUpd, pu8Pkg + u32Taken, u32Sent - u32Taken)) < 0)
+                break;
+            u32Taken += (uint32_t)i32Ret;
+        }
+
+        i32Ret = FMC_UpdPoll(&s_sUpd);
+        psRun->u32Polls++;
+        if ((i32Ret < 0) || (i32Ret == FMC_UPD_DONE) || SIM_FMC_IsPowerOff())
+            break;
+
+        if ((i32Ret == FMC_UPD_BUSY) && !SIM_FMC_IsBusy())
+            continue;
+
+        /* Idle until the flash command ends or the next receive interrupt */
+        u32Burst = (u32Len - u32Sent < RX_BURST) ? u32Len - u32Sent : RX_BURST;
+        u32Wait = u32Burst ? u32NextRx + (u32Burst - 1) * u32ByteTicks - u32Now : 0;
+        if (SIM_FMC_IsBusy())
+            SIM_FMC_RunBusy(u32Wait ? u32Wait : SIM_FMC_T_ERASE);
+        else if (u32Wait)
+            SIM_FMC_Run(u32Wait);
+        else if (u32Taken == u32Len)
+            break;
+    }
+
+    psRun->i32Result = s_sUpd.i32Result;
+    psRun->u32Ticks = SIM_FMC_GetTicks() - u32Start;
+}
+
+static void PrintRun(const char *pcName, uint32_t u32PkgLen, const RUN_T *psRun, const FMC_UPD_STAT_T *psStat,
+                     uint32_t u32Downtime)
+{
+    printf("  %-6s %7u %7u.%01u %6u %6u %6u %6u %7u %4u.%03u\n", pcName, u32PkgLen,
+           psRun->u32Ticks / 1000000, psRun->u32Ticks / 100000 % 10,
+           psStat->u32CopyBytes / 1024, psStat->u32Erases, psStat->u32Programs, psStat->u32Kept,
+           psStat->u32UpdateTime / 1000, u32Downtime / 1000, u32Downtime % 1000);
+}
+
+static void TestFirstImage(void)
+{
+    RUN_T sRun;
+    uint32_t u32Len, u32Downtime;
+
+    printf("\n[Factory image, first update]\n");
+
+    /* As programmed by the writer: bank 0 holds the image, no trailer anywhere */
+    memcpy(SIM_FMC_GetBank(0), s_au8V0, IMAGE_SIZE);
+    CHECK(Boot(NULL) == 0, "factory image not kept");
+    CHECK(s_sUpd.u32BootState == FMC_UPD_BOOT_NONE, "boot state %u, expected none", s_sUpd.u32BootState);
+
+    /* A delta needs a running image it knows */
+    u32Len = ABPATCH_Build(s_au8V0, IMAGE_SIZE, s_au8V1, IMAGE_SIZE, 1, s_au8Pkg, PKG_MAX, NULL);
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_ERR_BASE, "delta onto the factory image: %d", sRun.i32Result);
+
+    u32Len = ABPATCH_Build(NULL, 0, s_au8V1, IMAGE_SIZE, 1, s_au8Pkg, PKG_MAX, NULL);
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "full update: %d", sRun.i32Result);
+    CHECK(BankHolds(1, s_au8V1, IMAGE_SIZE), "bank 1 does not hold version 1");
+    CHECK(memcmp(SIM_FMC_GetBank(0), s_au8V0, IMAGE_SIZE) == 0, "running image changed");
+
+    CHECK(Boot(&u32Downtime) == 1, "version 1 not selected");
+    CHECK(s_sUpd.u32BootState == FMC_UPD_BOOT_TRIAL, "boot state %u, expected trial", s_sUpd.u32BootState);
+    CHECK(FMC_UpdConfirm(&s_sUpd) == FMC_UPD_OK, "confirm failed");
+    CHECK((Boot(NULL) == 1) && (s_sUpd.u32BootState == FMC_UPD_BOOT_CONFIRMED), "version 1 not confirmed");
+    printf("  factory image kept, full update to bank 1, trial boot in %u us, confirmed\n", u32Downtime);
+}
+
+static void TestUpdateTime(void)
+{
+    const SIM_FMC_STAT_T *psSim = SIM_FMC_GetStat();
+    ABPATCH_STAT_T sPatch;
+    FMC_UPD_STAT_T sStat;
+    RUN_T sRun;
+    uint32_t u32Len, u32Downtime, u32Flash, u32Erases, u32Programs;
+
+    printf("\n[Update time and downtime, %u baud, version 1 running from bank 1]\n", BAUD);
+    printf("  package  bytes  link s  copyKB erases progs   kept  upd ms  down ms\n");
+
+    /* Full package of version 2 */
+    u32Len = ABPATCH_Build(NULL, 0, s_au8V2, s_u32V2Len, 2, s_au8Pkg, PKG_MAX, NULL);
+    u32Erases = psSim->u32Erases;
+    u32Programs = psSim->u32Programs;
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "full update: %d", sRun.i32Result);
+    CHECK(BankHolds(0, s_au8V2, s_u32V2Len), "bank 0 does not hold version 2");
+    CHECK(s_sUpd.sStat.u32UpdateTime < sRun.u32Ticks + 1, "update time %u over the run", s_sUpd.sStat.u32UpdateTime);
+    CHECK(sRun.u32Holds == 0, "sender held %u times at %u baud", sRun.u32Holds, BAUD);
+    u32Flash = (psSim->u32Erases - u32Erases) * SIM_FMC_T_ERASE + (psSim->u32Programs - u32Programs) * SIM_FMC_T_PROG64;
+    sStat = s_sUpd.sStat;
+    CHECK((Boot(&u32Downtime) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_TRIAL), "full: version 2 not booted");
+    PrintRun("full", u32Len, &sRun, &sStat, u32Downtime);
+    printf("  single bank loader, same package: application down %u.%01u s (link and %u ms of flash)\n",
+           (sRun.u32Ticks + u32Flash) / 1000000, (sRun.u32Ticks + u32Flash) / 100000 % 10, u32Flash / 1000);
+
+    /* Roll back to version 1 and install version 2 again, as a delta */
+    CHECK((Boot(NULL) == 1) && (s_sUpd.u32BootState == FMC_UPD_BOOT_ROLLBACK), "no rollback to version 1");
+    memset(SIM_FMC_GetBank(0), 0xFF, SLOT_SIZE);
+    u32Len = ABPATCH_Build(s_au8V1, IMAGE_SIZE, s_au8V2, s_u32V2Len, 2, s_au8Pkg, PKG_MAX, &sPatch);
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "delta update: %d", sRun.i32Result);
+    CHECK(BankHolds(0, s_au8V2, s_u32V2Len), "bank 0 does not hold version 2");
+    CHECK(s_sUpd.sStat.u32CopyBytes == sPatch.u32CopyBytes, "copied %u bytes, package copies %u",
+          s_sUpd.sStat.u32CopyBytes, sPatch.u32CopyBytes);
+    sStat = s_sUpd.sStat;
+    CHECK((Boot(&u32Downtime) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_TRIAL), "delta: version 2 not booted");
+    PrintRun("delta", u32Len, &sRun, &sStat, u32Downtime);
+    printf("  delta: %u copy and %u insert records; copies outpace the flash, sender held %u times\n",
+           sPatch.u32Copies, sPatch.u32Inserts, sRun.u32Holds);
+    CHECK(u32Len * 20 < s_u32V2Len, "delta package %u bytes for a %u byte image", u32Len, s_u32V2Len);
+
+    /* Rollback: version 2 never confirmed, so the next boot returns to version 1, and stays there */
+    CHECK((Boot(NULL) == 1) && (s_sUpd.u32BootState == FMC_UPD_BOOT_ROLLBACK), "no rollback to version 1");
+    CHECK((Boot(NULL) == 1) && (s_sUpd.u32BootState == FMC_UPD_BOOT_ROLLBACK), "rollback not kept");
+    CHECK(BankHolds(1, s_au8V1, IMAGE_SIZE), "version 1 damaged by the rollback");
+
+    /* The same delta again: the bank already holds it, only the trailer page is written */
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "delta sent again: %d", sRun.i32Result);
+    CHECK(s_sUpd.sStat.u32Erases == 1, "%u erases for an image already in place", s_sUpd.sStat.u32Erases);
+    printf("  delta sent again: %u double words kept, %u programmed, %u erase\n",
+           s_sUpd.sStat.u32Kept, s_sUpd.sStat.u32Programs, s_sUpd.sStat.u32Erases);
+    CHECK((Boot(NULL) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_TRIAL), "version 2 not tried again");
+    CHECK(FMC_UpdConfirm(&s_sUpd) == FMC_UPD_OK, "confirm failed");
+    CHECK((Boot(NULL) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_CONFIRMED), "version 2 not confirmed");
+}
+
+static void TestBackPressure(void)
+{
+    RUN_T sRun;
+    uint32_t u32Len;
+
+    printf("\n[Fast link, version 3 into bank 1]\n");
+
+    u32Len = ABPATCH_Build(NULL, 0, s_au8V3, IMAGE_SIZE, 3, s_au8Pkg, PKG_MAX, NULL);
+    Send(s_au8Pkg, u32Len, 0, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "fast update: %d", sRun.i32Result);
+    CHECK(BankHolds(1, s_au8V3, IMAGE_SIZE), "bank 1 does not hold version 3");
+    CHECK(s_sUpd.sStat.u32Stalls > 0, "no back pressure");
+    CHECK(s_sUpd.sStat.u32RxBytes == u32Len, "took %u of %u bytes", s_sUpd.sStat.u32RxBytes, u32Len);
+    printf("  %u bytes in %u ms of flash time, %u writes left bytes behind\n",
+           u32Len, sRun.u32Ticks / 1000, s_sUpd.sStat.u32Stalls);
+
+    /* Version 3 is dropped: its first boot is never confirmed */
+    CHECK((Boot(NULL) == 1) && (s_sUpd.u32BootState == FMC_UPD_BOOT_TRIAL), "version 3 not tried");
+    CHECK((Boot(NULL) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_ROLLBACK), "no rollback to version 2");
+}
+
+/* Rejected packages leave the running image and the image to fall back to */
+static void TestRejected(void)
+{
+    static const char *s_apcName[] = { "header CRC", "record CRC", "trailing bytes", "image digest", "truncated" };
+    FMC_UPD_PKG_T *psHdr = (FMC_UPD_PKG_T *)s_au8Bad;
+    int32_t ai32Expect[] = { FMC_UPD_ERR_FORMAT, FMC_UPD_ERR_CRC, FMC_UPD_ERR_FORMAT, FMC_UPD_ERR_DIGEST, FMC_UPD_OK };
+    RUN_T sRun;
+    uint32_t u32Len, u32BadLen, i;
+
+    printf("\n[Rejected packages, version 2 running from bank 0]\n");
+
+    /* A delta made for version 1 */
+    u32Len = ABPATCH_Build(s_au8V1, IMAGE_SIZE, s_au8V3, IMAGE_SIZE, 3, s_au8Pkg, PKG_MAX, NULL);
+    Send(s_au8Pkg, u32Len, BAUD, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_ERR_BASE, "delta for another image: %d", sRun.i32Result);
+    CHECK(BankHolds(1, s_au8V3, IMAGE_SIZE), "wrong delta touched bank 1");
+    printf("  %-16s %d, bank 1 untouched\n", "wrong base", sRun.i32Result);
+
+    u32Len = ABPATCH_Build(s_au8V2, s_u32V2Len, s_au8V1, CUT_SIZE, 4, s_au8Pkg, PKG_MAX, NULL);
+    for (i = 0; i < sizeof(ai32Expect) / sizeof(ai32Expect[0]); i++)
+    {
+        memcpy(s_au8Bad, s_au8Pkg, u32Len);
+        u32BadLen = u32Len;
+
+        switch (i)
+        {
+        case 0:
+            psHdr->u32Version ^= 1;
+            break;
+        case 1:
+            s_au8Bad[u32Len - 10] ^= 0x20;
+            break;
+        case 2:
+            u32BadLen += 4;
+            break;
+        case 3:
+            psHdr->au8Digest[5] ^= 1;
+            psHdr->u32HdrCrc = ABPATCH_Crc32(s_au8Bad, offsetof(FMC_UPD_PKG_T, u32HdrCrc));
+            break;
+        default:
+            u32BadLen -= 100;
+            break;
+        }
+
+        Send(s_au8Bad, u32BadLen, BAUD, &sRun);
+        CHECK(sRun.i32Result == ai32Expect[i], "%s: %d, expected %d", s_apcName[i], sRun.i32Result, ai32Expect[i]);
+        CHECK(Boot(NULL) == 0, "%s: version 2 not kept", s_apcName[i]);
+        CHECK(BankHolds(0, s_au8V2, s_u32V2Len), "%s: version 2 damaged", s_apcName[i]);
+        printf("  %-16s %d, version 2 kept\n", s_apcName[i], sRun.i32Result);
+    }
+
+    /* Unsupported slot */
+    FMC_UpdInit(&s_sUpd, SLOT_SIZE + 1, NULL);
+    CHECK(FMC_UpdBegin(&s_sUpd) == FMC_UPD_ERR_PARAM, "odd slot size accepted");
+    CHECK(FMC_UpdWrite(&s_sUpd, s_au8Pkg, 16) == FMC_UPD_ERR_PARAM, "write without a begin accepted");
+    CHECK((Boot(NULL) == 0) && (s_sUpd.u32BootState == FMC_UPD_BOOT_CONFIRMED), "version 2 not confirmed");
+}
+
+/* Power fails anywhere in an update: the running image always boots, the update is redone */
+static void TestPowerCut(void)
+{
+    const SIM_FMC_STAT_T *psSim = SIM_FMC_GetStat();
+    RUN_T sRun;
+    uint32_t u32Len, u32Ops, u32Cut, u32Trailer = 0, i;
+    int32_t i32Bank;
+
+    printf("\n[Power cuts, version 2 running from bank 0]\n");
+
+    /* Bank 1 as each update finds it: an older image, tried and rolled back */
+    u32Len = ABPATCH_Build(NULL, 0, s_au8V1, CUT_SIZE, 5, s_au8Pkg, PKG_MAX, NULL);
+    Send(s_au8Pkg, u32Len, 0, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "old image: %d", sRun.i32Result);
+    CHECK((Boot(NULL) == 1) && (Boot(NULL) == 0), "old image: trial and rollback");
+    memcpy(s_au8Slot, SIM_FMC_GetBank(1), SLOT_SIZE);
+
+    /* Flash operations of a clean run */
+    u32Len = ABPATCH_Build(NULL, 0, s_au8V3, CUT_SIZE, 6, s_au8Pkg, PKG_MAX, NULL);
+    u32Ops = psSim->u32Programs + psSim->u32Erases;
+    Send(s_au8Pkg, u32Len, 0, &sRun);
+    CHECK(sRun.i32Result == FMC_UPD_DONE, "clean run: %d", sRun.i32Result);
+    u32Ops = psSim->u32Programs + psSim->u32Erases - u32Ops;
+
+    for (i = 0; i < POWER_CUTS; i++)
+    {
+        /* Spread over the update, the last ones into the trailer */
+        u32Cut = (i < POWER_CUTS - 8) ? 1 + Rand() % u32Ops : u32Ops - (POWER_CUTS - 1 - i);
+        if (u32Cut > u32Ops - 7)
+            u32Trailer++;
+        memcpy(SIM_FMC_GetBank(1), s_au8Slot, SLOT_SIZE);
+
+        SIM_FMC_PowerCut(u32Cut);
+        Send(s_au8Pkg, u32Len, 0, &sRun);
+        CHECK(SIM_FMC_IsPowerOff(), "cut %u: no power failure", u32Cut);
+
+        i32Bank = Boot(NULL);
+        CHECK(i32Bank == 0, "cut %u of %u: bank %d state %u", u32Cut, u32Ops, i32Bank, s_sUpd.u32BootState);
+        CHECK(BankHolds(0, s_au8V2, s_u32V2Len), "cut %u: running image damaged", u32Cut);
+
+        /* Redo over what the cut left */
+        Send(s_au8Pkg, u32Len, 0, &sRun);
+        CHECK(sRun.i32Result == FMC_UPD_DONE, "cut %u: update after the cut: %d", u32Cut, sRun.i32Result);
+        CHECK(BankHolds(1, s_au8V3, CUT_SIZE), "cut %u: bank 1 does not hold the update", u32Cut);
+        CHECK((Boot(NULL) == 1) && (Boot(NULL) == 0), "cut %u: trial and rollback", u32Cut);
+    }
+
+    printf("  %u cuts over %u flash operations, %u in the trailer: running image booted every time\n",
+           POWER_CUTS, u32Ops, u32Trailer);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (SIM_FMC_Init() != HOSTSIM_OK) || (SIM_CRYPTO_Init() != HOSTSIM_OK) ||
+            (SIM_CRYPTO_AddMemory(SIM_FMC_MAP_BASE, SIM_FMC_APROM_SIZE) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    const SIM_FMC_STAT_T *psSim;
+    const SIM_CRYPTO_STAT_T *psCrypto;
+
+    if (HOSTSIM_TestBegin("FMC dual bank firmware update", SimInit) != 0)
+        return 1;
+
+    /* Bounds the ISP time-outs of the driver */
+    SystemCoreClock = 100000;
+
+    MakeImage(s_au8V0, IMAGE_SIZE);
+    MakeImage(s_au8V1, IMAGE_SIZE);
+    s_u32V2Len = MakeNext(s_au8V2, s_au8V1, IMAGE_SIZE);
+    MakeImage(s_au8V3, IMAGE_SIZE);
+
+    TestFirstImage();
+    TestUpdateTime();
+    TestBackPressure();
+    TestRejected();
+    TestPowerCut();
+
+    psSim = SIM_FMC_GetStat();
+    psCrypto = SIM_CRYPTO_GetStat();
+    printf("\nFlash: %u programs, %u erases, %u remaps; SHA: %u runs, %u KB\n", psSim->u32Programs, psSim->u32Erases,
+           psSim->u32Remaps, psCrypto->u32ShaRuns, psCrypto->u32ShaBytes / 1024);
+    CHECK(psSim->u32Fails == 0, "%u ISP commands failed", psSim->u32Fails);
+    CHECK(psSim->u32Overprograms == 0, "%u programs onto data not erased", psSim->u32Overprograms);
+    CHECK(psCrypto->u32ShaErrors == 0, "%u SHA DMA errors", psCrypto->u32ShaErrors);
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,479 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check and benchmark of the data flash key-value store
+ *           (FMC_KvInit() ... FMC_KvDelete()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_fmc.c
+ *               ../../../Library/StdDriver/src/fmc.c
+ *               -o fmc_kvstore
+ *           ./fmc_kvstore
+ *
+ *           The store runs on the FMC model of ../common/sim_fmc.c, with typical
+ *           program and erase times, one tick per microsecond, in the last
+ *           pages of APROM bank 1. The workload is a device configuration:
+ *           settings of 8 to 64 bytes changed now and then, often written back
+ *           unchanged, and counters updated all the time.
+ *           Checked and measured: lookups and writes per second of flash time,
+ *           erases per page against rewriting a data flash page per change as
+ *           the application does today, mount time, index and region limits,
+ *           and power failures torn into record writes, compactions, mounts
+ *           and page erases, after which every key holds its previous or its
+ *           new value.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_fmc.h"
+
+#define KV_BASE             0x000F8000ul    /* Last 32 KB of APROM bank 1 */
+#define KV_PAGES            8u
+#define INDEX_SIZE          128u
+#define SETTINGS            48u            /* Keys 0x100... */
+#define COUNTERS            8u             /* Keys 0x200... */
+#define KEYS                (SETTINGS + COUNTERS)
+#define VAL_MAX             64u
+#define CHANGES             5000u
+#define LOOKUPS             10000u
+#define BASELINE_CHANGES    4u
+#define CUT_PAGES           3u             /* A small ring: the cuts often land in compactions */
+#define POWER_CUTS          40u
+
+/* What the store should hold */
+typedef struct
+{
+    uint32_t u32Key;
+    uint32_t u32Len;
+    uint32_t u32Present;
+    uint8_t  au8Val[VAL_MAX];
+} SHADOW_T;
+
+static FMC_KV_T s_sKv;
+static FMC_KV_ENTRY_T s_asIndex[INDEX_SIZE];
+static SHADOW_T s_asShadow[KEYS], s_asPrev[KEYS];
+static uint32_t s_au32Erases[KV_PAGES], s_au32Hdr[KV_PAGES];
+static uint32_t s_u32Seed = 0x2545F491;
+
+static uint32_t Rand(void)
+{
+    s_u32Seed ^= s_u32Seed << 13;
+    s_u32Seed ^= s_u32Seed >> 17;
+    s_u32Seed ^= s_u32Seed << 5;
+    return s_u32Seed;
+}
+
+/* The region as the array holds it */
+static const uint8_t *Region(void)
+{
+    return SIM_FMC_GetBank(1) + (KV_BASE - FMC_BANK_SIZE);
+}
+
+/* Reset: FMC back to its defaults, then mount as the application does at start */
+static int32_t Mount(uint32_t u32Pages)
+{
+    SIM_FMC_PowerOn();
+    FMC->ISPCTL |= FMC_ISPCTL_ISPEN_Msk | FMC_ISPCTL_APUEN_Msk;
+
+    if (FMC_KvInit(&s_sKv, KV_BASE, u32Pages, s_asIndex, INDEX_SIZE) != FMC_KV_OK)
+        return FMC_KV_ERR_PARAM;
+    return FMC_KvMount(&s_sKv);
+}
+
+static void EraseRegion(void)
+{
+    static const uint8_t s_au8Blank[FMC_FLASH_PAGE_SIZE] = { [0 ... FMC_FLASH_PAGE_SIZE - 1] = 0xFF };
+    uint32_t i;
+
+    SIM_FMC_PowerOn();
+    FMC->ISPCTL |= FMC_ISPCTL_ISPEN_Msk | FMC_ISPCTL_APUEN_Msk;
+    for (i = 0; i < KV_PAGES; i++)
+    {
+        if (memcmp(Region() + i * FMC_FLASH_PAGE_SIZE, s_au8Blank, FMC_FLASH_PAGE_SIZE) != 0)
+            FMC_Erase(KV_BASE + i * FMC_FLASH_PAGE_SIZE);
+    }
+}
+
+static void InitShadow(void)
+{
+    uint32_t i;
+
+    memset(s_asShadow, 0, sizeof(s_asShadow));
+    for (i = 0; i < KEYS; i++)
+    {
+        s_asShadow[i].u32Key = (i < SETTINGS) ? (0x100 + i) : (0x200 + i - SETTINGS);
+        s_asShadow[i].u32Len = (i < SETTINGS) ? (8 + Rand() % (VAL_MAX - 7)) : 4;
+    }
+}
+
+/* Every key holds what the shadow says, but the one skipped */
+static uint32_t Verify(uint32_t u32Skip)
+{
+    uint8_t au8Val[VAL_MAX];
+    uint32_t i, u32Bad = 0;
+    int32_t i32Len;
+
+    for (i = 0; i < KEYS; i++)
+    {
+        if (i == u32Skip)
+            continue;
+
+        i32Len = FMC_KvGet(&s_sKv, s_asShadow[i].u32Key, au8Val, sizeof(au8Val));
+        if (!s_asShadow[i].u32Present)
+            u32Bad += (i32Len != FMC_KV_ERR_NOT_FOUND);
+        else
+            u32Bad += (i32Len != (int32_t)s_asShadow[i].u32Len) || memcmp(au8Val, s_asShadow[i].au8Val, s_asShadow[i].u32Len);
+    }
+    return u32Bad;
+}
+
+static int32_t SetKey(uint32_t u32Idx)
+{
+    return FMC_KvSet(&s_sKv, s_asShadow[u32Idx].u32Key, s_asShadow[u32Idx].au8Val, s_asShadow[u32Idx].u32Len);
+}
+
+/* One change of the workload to the shadow; returns the key changed */
+static uint32_t Change(void)
+{
+    uint32_t u32Idx, u32Cnt, r = Rand() % 100;
+
+    if (r < 80)
+    {
+        /* A counter goes up */
+        u32Idx = SETTINGS + Rand() % COUNTERS;
+        memcpy(&u32Cnt, s_asShadow[u32Idx].au8Val, 4);
+        u32Cnt++;
+        memcpy(s_asShadow[u32Idx].au8Val, &u32Cnt, 4);
+    }
+    else
+    {
+        /* A setting is saved, changed or not */
+        u32Idx = Rand() % SETTINGS;
+        if (r < 92)
+            s_asShadow[u32Idx].au8Val[Rand() % s_asShadow[u32Idx].u32Len] = (uint8_t)Rand();
+    }
+    s_asShadow[u32Idx].u32Present = 1;
+    return u32Idx;
+}
+
+/* Count the page erases the store did, from the page headers */
+static void WearScan(void)
+{
+    uint32_t i, u32Hdr;
+
+    for (i = 0; i < KV_PAGES; i++)
+    {
+        memcpy(&u32Hdr, Region() + i * FMC_FLASH_PAGE_SIZE + 4, 4);
+        if ((s_au32Hdr[i] != 0xFFFFFFFFul) && (u32Hdr != s_au32Hdr[i]))
+            s_au32Erases[i]++;
+        s_au32Hdr[i] = u32Hdr;
+    }
+}
+
+static void TestBasic(void)
+{
+    static const uint8_t s_au8Name[] = "m460-gateway-01";
+    uint8_t au8Val[32];
+    uint32_t u32Cnt = 7;
+
+    printf("\n[Basic use]\n");
+    EraseRegion();
+
+    CHECK(FMC_KvGet(&s_sKv, 1, au8Val, sizeof(au8Val)) == FMC_KV_ERR_PARAM, "get before mount");
+    CHECK(Mount(KV_PAGES) == FMC_KV_OK, "format");
+    CHECK(FMC_KvGet(&s_sKv, 1, au8Val, sizeof(au8Val)) == FMC_KV_ERR_NOT_FOUND, "get on an empty store");
+
+    CHECK(FMC_KvSet(&s_sKv, 1, s_au8Name, sizeof(s_au8Name)) == FMC_KV_OK, "set name");
+    CHECK(FMC_KvSet(&s_sKv, 2, &u32Cnt, 4) == FMC_KV_OK, "set counter");
+    CHECK(FMC_KvSet(&s_sKv, 3, NULL, 0) == FMC_KV_OK, "set empty value");
+    CHECK(FMC_KvSet(&s_sKv, FMC_KV_KEY_NONE, &u32Cnt, 4) == FMC_KV_ERR_PARAM, "reserved key");
+    CHECK(FMC_KvSet(&s_sKv, 4, s_au8Name, FMC_KV_MAX_LEN + 1) == FMC_KV_ERR_PARAM, "value too long");
+
+    CHECK((FMC_KvGet(&s_sKv, 1, au8Val, sizeof(au8Val)) == sizeof(s_au8Name)) &&
+          (memcmp(au8Val, s_au8Name, sizeof(s_au8Name)) == 0), "get name");
+    memset(au8Val, 0, sizeof(au8Val));
+    CHECK((FMC_KvGet(&s_sKv, 1, au8Val, 4) == sizeof(s_au8Name)) && (memcmp(au8Val, s_au8Name, 4) == 0) &&
+          (au8Val[4] == 0), "get into a short buffer");
+    CHECK(FMC_KvGet(&s_sKv, 3, au8Val, sizeof(au8Val)) == 0, "get empty value");
+
+    CHECK(FMC_KvSet(&s_sKv, 1, s_au8Name, sizeof(s_au8Name)) == FMC_KV_OK, "set name again");
+    CHECK(s_sKv.sStat.u32Unchanged == 1, "unchanged value written: %u", s_sKv.sStat.u32Unchanged);
+
+    CHECK(FMC_KvDelete(&s_sKv, 2) == FMC_KV_OK, "delete");
+    CHECK(FMC_KvGet(&s_sKv, 2, au8Val, sizeof(au8Val)) == FMC_KV_ERR_NOT_FOUND, "get deleted key");
+    CHECK(FMC_KvDelete(&s_sKv, 2) == FMC_KV_ERR_NOT_FOUND, "delete twice");
+
+    CHECK(Mount(KV_PAGES) == FMC_KV_OK, "remount");
+    CHECK(FMC_KvGet(&s_sKv, 1, au8Val, sizeof(au8Val)) == sizeof(s_au8Name), "name after remount");
+    CHECK(FMC_KvGet(&s_sKv, 2, au8Val, sizeof(au8Val)) == FMC_KV_ERR_NOT_FOUND, "deleted key after remount");
+    CHECK(FMC_KvGet(&s_sKv, 3, au8Val, sizeof(au8Val)) == 0, "empty value after remount");
+    CHECK(s_sKv.u32Keys == 3, "%u keys indexed after remount", s_sKv.u32Keys);
+    printf("  set, get, unchanged write skipped, delete and remount\n");
+}
+
+static void TestBench(void)
+{
+    uint8_t au8Val[VAL_MAX];
+    uint32_t i, j, u32Start, u32SetTicks, u32GetTicks, u32MountTicks, u32BaseTicks, u32Erases = 0;
+    uint32_t u32MaxErases = 0, u32MinErases = 0xFFFFFFFFul;
+    const SIM_FMC_STAT_T *psSim = SIM_FMC_GetStat();
+    uint32_t u32Programs, u32Sets;
+    FMC_KV_STAT_T sStat;
+
+    printf("\n[Throughput and wear, %u keys, %u changes, %u KB region]\n", KEYS, CHANGES, KV_PAGES * 4);
+    EraseRegion();
+    CHECK(Mount(KV_PAGES) == FMC_KV_OK, "format");
+    InitShadow();
+    memset(s_au32Hdr, 0xFF, sizeof(s_au32Hdr));
+    WearScan();
+
+    for (i = 0; i < KEYS; i++)
+    {
+        s_asShadow[i].u32Present = 1;
+        CHECK(SetKey(i) == FMC_KV_OK, "first value of key %u", i);
+    }
+
+    u32Programs = psSim->u32Programs;
+    u32Sets = s_sKv.sStat.u32Sets;
+    u32Start = SIM_FMC_GetTicks();
+    for (i = 0; i < CHANGES; i++)
+    {
+        CHECK(SetKey(Change()) == FMC_KV_OK, "change %u", i);
+        WearScan();
+    }
+    u32SetTicks = SIM_FMC_GetTicks() - u32Start;
+    u32Programs = psSim->u32Programs - u32Programs;
+    u32Sets = s_sKv.sStat.u32Sets - u32Sets;
+    CHECK(Verify(KEYS) == 0, "values after the changes");
+
+    u32Start = SIM_FMC_GetTicks();
+    for (i = 0; i < LOOKUPS; i++)
+        FMC_KvGet(&s_sKv, s_asShadow[Rand() % KEYS].u32Key, au8Val, sizeof(au8Val));
+    u32GetTicks = SIM_FMC_GetTicks() - u32Start;
+    sStat = s_sKv.sStat;
+
+    u32Start = SIM_FMC_GetTicks();
+    CHECK(Mount(KV_PAGES) == FMC_KV_OK, "remount");
+    u32MountTicks = SIM_FMC_GetTicks() - u32Start;
+    CHECK(Verify(KEYS) == 0, "values after remount");
+
+    for (i = 0; i < KV_PAGES; i++)
+    {
+        u32Erases += s_au32Erases[i];
+        if (s_au32Erases[i] > u32MaxErases)
+            u32MaxErases = s_au32Erases[i];
+        if (s_au32Erases[i] < u32MinErases)
+            u32MinErases = s_au32Erases[i];
+    }
+    CHECK(u32Erases == sStat.u32Erases, "%u erases seen, %u done", u32Erases, sStat.u32Erases);
+
+    /* Today: the settings page is erased and programmed again at each change */
+    u32Start = SIM_FMC_GetTicks();
+    for (i = 0; i < BASELINE_CHANGES; i++)
+    {
+        FMC_Erase(KV_BASE);
+        for (j = 0; j < FMC_FLASH_PAGE_SIZE; j += 8)
+            FMC_Write8Bytes(KV_BASE + j, 0x5A5A5A5Aul, 0x5A5A5A5Aul);
+    }
+    u32BaseTicks = (SIM_FMC_GetTicks() - u32Start) / BASELINE_CHANGES;
+    EraseRegion();
+
+    printf("  %-22s %12s %12s %14s %16s\n", "", "writes/s", "programs/wr", "erases/1000 wr", "max erases/page");
+    printf("  %-22s %12u %12u %14u %16u\n", "page rewrite (today)", 1000000u / u32BaseTicks,
+           (uint32_t)(FMC_FLASH_PAGE_SIZE / 8), 1000, CHANGES);
+    printf("  %-22s %12u %9u.%02u %11u.%02u %16u\n", "key-value store", (uint32_t)(CHANGES * 1000000ull / u32SetTicks),
+           u32Programs / CHANGES, u32Programs * 100 / CHANGES % 100,
+           sStat.u32Erases * 1000 / CHANGES, sStat.u32Erases * 100000 / CHANGES % 100, u32MaxErases);
+    printf("  %u of %u changes written (%u unchanged), %u compactions moved %u records\n", u32Sets, CHANGES,
+           sStat.u32Unchanged, sStat.u32Rotations, sStat.u32Copies);
+    printf("  erases per page:");
+    for (i = 0; i < KV_PAGES; i++)
+        printf(" %u", s_au32Erases[i]);
+    printf("\n  lookups: %u/s of flash time; mount of %u pages: %u.%03u ms\n",
+           (uint32_t)(LOOKUPS * 1000000ull / u32GetTicks), KV_PAGES, u32MountTicks / 1000, u32MountTicks % 1000);
+
+    CHECK(u32MaxErases * 20 < CHANGES, "wear: %u erases of one page for %u changes", u32MaxErases, CHANGES);
+    CHECK(u32MaxErases - u32MinErases <= 1, "wear not level: %u to %u erases per page", u32MinErases, u32MaxErases);
+}
+
+static void TestLimits(void)
+{
+    static uint8_t s_au8Big[FMC_KV_MAX_LEN];
+    FMC_KV_ENTRY_T asSmall[8];
+    uint8_t au8Val[8];
+    uint32_t i, u32Stored;
+    int32_t i32Ret;
+
+    printf("\n[Limits]\n");
+    EraseRegion();
+    SIM_FMC_PowerOn();
+    FMC->ISPCTL |= FMC_ISPCTL_ISPEN_Msk | FMC_ISPCTL_APUEN_Msk;
+
+    CHECK(FMC_KvInit(&s_sKv, KV_BASE + 8, 2, s_asIndex, INDEX_SIZE) == FMC_KV_ERR_PARAM, "unaligned region");
+    CHECK(FMC_KvInit(&s_sKv, KV_BASE, 1, s_asIndex, INDEX_SIZE) == FMC_KV_ERR_PARAM, "one page");
+    CHECK(FMC_KvInit(&s_sKv, KV_BASE, 2, s_asIndex, 100) == FMC_KV_ERR_PARAM, "index size");
+
+    /* Three quarters of the index hold keys */
+    CHECK((FMC_KvInit(&s_sKv, KV_BASE, 2, asSmall, 8) == FMC_KV_OK) && (FMC_KvMount(&s_sKv) == FMC_KV_OK), "small index");
+    for (i = 0; i < 6; i++)
+        CHECK(FMC_KvSet(&s_sKv, i, &i, 4) == FMC_KV_OK, "key %u of 6", i);
+    CHECK(FMC_KvSet(&s_sKv, 6, &i, 4) == FMC_KV_ERR_FULL, "7th key");
+    CHECK(FMC_KvSet(&s_sKv, 5, &i, 4) == FMC_KV_OK, "existing key when the index is full");
+    CHECK((FMC_KvInit(&s_sKv, KV_BASE, 2, asSmall, 4) == FMC_KV_OK) && (FMC_KvMount(&s_sKv) == FMC_KV_ERR_FULL),
+          "mount with too small an index");
+
+    /* Two pages: one page of records */
+    EraseRegion();
+    CHECK(Mount(2) == FMC_KV_OK, "two pages");
+    for (u32Stored = 0; ; u32Stored++)
+    {
+        memset(s_au8Big, (int)u32Stored, sizeof(s_au8Big));
+        i32Ret = FMC_KvSet(&s_sKv, u32Stored, s_au8Big, sizeof(s_au8Big));
+        if (i32Ret != FMC_KV_OK)
+            break;
+    }
+    CHECK((i32Ret == FMC_KV_ERR_FULL) && (u32Stored == 2), "region full after %u values: %d", u32Stored, i32Ret);
+    CHECK(FMC_KvSet(&s_sKv, 100, au8Val, 8) == FMC_KV_OK, "small value when full");
+
+    /* Values rewritten over and over: compaction keeps them */
+    for (i = 0; i < 40; i++)
+    {
+        memset(s_au8Big, (int)(0x80 + i), sizeof(s_au8Big));
+        CHECK(FMC_KvSet(&s_sKv, i & 1, s_au8Big, sizeof(s_au8Big)) == FMC_KV_OK, "rewrite %u", i);
+    }
+    CHECK(Mount(2) == FMC_KV_OK, "remount");
+    CHECK((FMC_KvGet(&s_sKv, 1, s_au8Big, sizeof(s_au8Big)) == FMC_KV_MAX_LEN) && (s_au8Big[0] == 0x80 + 39) &&
+          (s_au8Big[FMC_KV_MAX_LEN - 1] == 0x80 + 39), "value after the rewrites");
+
+    CHECK(FMC_KvDelete(&s_sKv, 1) == FMC_KV_OK, "delete to make room");
+    memset(s_au8Big, 0x33, sizeof(s_au8Big));
+    CHECK(FMC_KvSet(&s_sKv, 2, s_au8Big, sizeof(s_au8Big)) == FMC_KV_OK, "set after the delete");
+    CHECK(Mount(2) == FMC_KV_OK, "remount");
+    CHECK((FMC_KvGet(&s_sKv, 2, s_au8Big, sizeof(s_au8Big)) == FMC_KV_MAX_LEN) && (s_au8Big[100] == 0x33) &&
+          (FMC_KvGet(&s_sKv, 1, s_au8Big, sizeof(s_au8Big)) == FMC_KV_ERR_NOT_FOUND), "values after remount");
+    printf("  index and region full, previous values kept, room made by a delete\n");
+}
+
+static void TestPowerCut(void)
+{
+    SHADOW_T sOld;
+    uint8_t au8Val[VAL_MAX];
+    uint32_t u32Cut, u32Idx = 0, u32Ops, u32Rot = 0, u32InRotation = 0, u32InMount = 0;
+    uint32_t u32Deleted;
+    int32_t i32Len;
+
+    printf("\n[Power failures, %u cuts, %u page ring]\n", POWER_CUTS, CUT_PAGES);
+    EraseRegion();
+    CHECK(Mount(CUT_PAGES) == FMC_KV_OK, "format");
+    InitShadow();
+
+    for (u32Cut = 0; u32Cut < POWER_CUTS; u32Cut++)
+    {
+        SIM_FMC_PowerCut(1 + Rand() % 60);
+
+        /* Changes, a few deletes among them, until the power fails in one */
+        for (u32Ops = 0; !SIM_FMC_IsPowerOff() && (u32Ops < 1000); u32Ops++)
+        {
+            memcpy(s_asPrev, s_asShadow, sizeof(s_asShadow));
+            u32Idx = Change();
+            sOld = s_asPrev[u32Idx];
+            u32Rot = s_sKv.sStat.u32Rotations;
+
+            /* Bigger settings: the small ring rotates often */
+            if (u32Idx < SETTINGS)
+                s_asShadow[u32Idx].u32Len = 8 + Rand() % (VAL_MAX - 7);
+
+            u32Deleted = ((Rand() % 16) == 0) && sOld.u32Present;
+            if (u32Deleted)
+            {
+                s_asShadow[u32Idx].u32Present = 0;
+                CHECK(FMC_KvDelete(&s_sKv, s_asShadow[u32Idx].u32Key) == FMC_KV_OK, "cut %u: delete", u32Cut);
+            }
+            else
+            {
+                CHECK(SetKey(u32Idx) == FMC_KV_OK, "cut %u: set", u32Cut);
+            }
+        }
+        CHECK(SIM_FMC_IsPowerOff(), "cut %u: no power failure", u32Cut);
+        u32InRotation += (s_sKv.sStat.u32Rotations != u32Rot);
+
+        /* Every other time the power fails again in the first erase or program of the mount */
+        if (u32Cut & 1)
+        {
+            SIM_FMC_PowerOn();
+            FMC->ISPCTL |= FMC_ISPCTL_ISPEN_Msk | FMC_ISPCTL_APUEN_Msk;
+            FMC_KvInit(&s_sKv, KV_BASE, CUT_PAGES, s_asIndex, INDEX_SIZE);
+            SIM_FMC_PowerCut(1);
+            FMC_KvMount(&s_sKv);
+            u32InMount += SIM_FMC_IsPowerOff();
+        }
+
+        CHECK(Mount(CUT_PAGES) == FMC_KV_OK, "cut %u: mount", u32Cut);
+        CHECK(Verify(u32Idx) == 0, "cut %u: keys not written meanwhile changed", u32Cut);
+
+        /* The key written when the power failed holds either value */
+        i32Len = FMC_KvGet(&s_sKv, s_asShadow[u32Idx].u32Key, au8Val, sizeof(au8Val));
+        if ((i32Len == (int32_t)sOld.u32Len) && sOld.u32Present && (memcmp(au8Val, sOld.au8Val, sOld.u32Len) == 0))
+            s_asShadow[u32Idx] = sOld;
+        else if (i32Len == FMC_KV_ERR_NOT_FOUND)
+            CHECK(!sOld.u32Present || !s_asShadow[u32Idx].u32Present, "cut %u: key lost", u32Cut);
+        else
+            CHECK(s_asShadow[u32Idx].u32Present && (i32Len == (int32_t)s_asShadow[u32Idx].u32Len) &&
+                  (memcmp(au8Val, s_asShadow[u32Idx].au8Val, s_asShadow[u32Idx].u32Len) == 0),
+                  "cut %u: key %x holds neither value", u32Cut, s_asShadow[u32Idx].u32Key);
+        s_asShadow[u32Idx].u32Present = (i32Len >= 0);
+    }
+
+    CHECK(Verify(KEYS) == 0, "values at the end");
+
+    /* The spare page torn while erased: its second half still programmed */
+    u32Idx = (s_sKv.u32Page + 1) % CUT_PAGES;
+    memset((uint8_t *)Region() + u32Idx * FMC_FLASH_PAGE_SIZE + FMC_FLASH_PAGE_SIZE / 2, 0x5A, 64);
+    CHECK((Mount(CUT_PAGES) == FMC_KV_OK) && (s_sKv.sStat.u32Erases == 1), "mount over a torn erase");
+    for (u32Ops = 0; u32Ops < 200; u32Ops++)
+        CHECK(SetKey(Change()) == FMC_KV_OK, "set after a torn erase");
+    CHECK(Verify(KEYS) == 0, "values after a torn erase");
+    printf("  %u cuts, %u in a record, %u in a rotation, %u more in a mount: no value lost\n",
+           POWER_CUTS, POWER_CUTS - u32InRotation, u32InRotation, u32InMount);
+    CHECK(u32InRotation > 5, "too few cuts in a rotation: %u", u32InRotation);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (SIM_FMC_Init() != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    const SIM_FMC_STAT_T *psSim;
+
+    if (HOSTSIM_TestBegin("FMC key-value store", SimInit) != 0)
+        return 1;
+
+    /* Bounds the ISP time-outs of the driver */
+    SystemCoreClock = 100000;
+
+    TestBasic();
+    TestBench();
+    TestLimits();
+    TestPowerCut();
+
+    psSim = SIM_FMC_GetStat();
+    printf("\nFlash: %u reads, %u programs, %u erases\n", psSim->u32Reads, psSim->u32Programs, psSim->u32Erases);
+    CHECK(psSim->u32Fails == 0, "%u ISP commands failed", psSim->u32Fails);
+    CHECK(psSim->u32Overprograms == 0, "%u programs onto data not erased", psSim->u32Overprograms);
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,582 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the HyperRAM heap (HBI_HeapInit() ... HBI_HeapClearStats()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c
+ *               ../../../Library/StdDriver/src/hbi.c ../../../Library/StdDriver/src/pdma.c
+ *               -o hbi_heap
+ *           ./hbi_heap
+ *
+ *           The HyperRAM is plain host memory mapped at HYPER_RAM_MEM_MAP, as
+ *           the memory-mapped window of HBI looks to the CPU and to PDMA. The
+ *           PDMA0 model of ../common/sim_pdma.c moves one item per tick when
+ *           SIM_PDMA_RunMem() is called, so the copy latencies are in items.
+ *           Checked are the set-up checks, class and general area allocation
+ *           with spills, coalescing and bad frees, a randomized churn of audio
+ *           rings, JPEG pools, camera frames and odd buffers compared with and
+ *           without size classes, and strip copies between SRAM and a frame
+ *           in HyperRAM with their statistics.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+
+#define SRAM_SIM_SIZE       0x40000ul
+#define HRAM_SIZE           0x800000ul      /* 64 Mbit HyperRAM of the NuMaker board */
+#define POOL_SIZE           16
+#define BAD_ADDR            0x60000000ul    /* Not in a simulated memory: target abort */
+
+/* Buffers of the applications that would move off SRAM */
+#define PCM_RING_SIZE       (2 * 2304 * 4)  /* aPCMBuffer of I2S_MP3PLAYER */
+#define JPEG_POOL_SIZE      16000           /* Large pool chunk of libjpeg */
+#define QVGA_FRAME_SIZE     (320 * 240 * 2) /* CCAP frame, RGB565 */
+#define VGA_FRAME_SIZE      (640 * 480 * 2) /* CCAP frame, YUV422 */
+
+#define FRAME_W             320
+#define FRAME_H             240
+#define STRIP_LINES         16
+#define STRIP_SIZE          (FRAME_W * 2 * STRIP_LINES)
+
+#define CHURN_STEPS         20000
+#define ODD_LIVE            32              /* Odd buffers alive at a time, about */
+#define MAX_LIVE            64
+
+/* Everything PDMA touches on the SRAM side lives in the simulated SRAM window */
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    PDMA_COPY_T sCopy;
+    uint8_t au8Strip[4][STRIP_SIZE];
+    uint8_t au8Check[STRIP_SIZE];
+} SIM_MEM_T;
+
+typedef struct
+{
+    uint8_t *pu8Addr;
+    uint32_t u32Size;
+    uint32_t u32Tag;
+    uint32_t u32Kind;
+} LIVE_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+static HBI_HEAP_T s_sHeap;
+static LIVE_T s_asLive[MAX_LIVE];
+static uint32_t s_u32Live;
+static uint32_t s_u32Seed = 1;
+
+static const HBI_HEAP_CLASS_T s_asClass[] =
+{
+    { 4096,             32 },           /* Descriptors, small codec tables */
+    { JPEG_POOL_SIZE,   12 },
+    { PCM_RING_SIZE,    4 },
+    { QVGA_FRAME_SIZE,  4 },
+};
+
+static uint32_t GetTime(void)
+{
+    return SIM_PDMA_GetTicks();
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(HYPER_RAM_MEM_MAP, HRAM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(HYPER_RAM_MEM_MAP, HRAM_SIZE) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+static uint32_t Rand(void)
+{
+    s_u32Seed = s_u32Seed * 1103515245ul + 12345ul;
+    return s_u32Seed >> 8;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void TestInit(void)
+{
+    static const HBI_HEAP_CLASS_T asDesc[] = { { 8192, 2 }, { 4096, 2 } };
+    static const HBI_HEAP_CLASS_T asHuge[] = { { 0x100000, 9 } };
+    static const HBI_HEAP_CLASS_T asFull[] = { { 0x20000, 8 } };
+    static const HBI_HEAP_CLASS_T asMany[] = { { 64, HBI_HEAP_CLASS_BLOCKS + 1 } };
+    HBI_HEAP_T *psHeap = &s_sHeap;
+
+    printf("\n[1] Set-up checks\n");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP + 4, HRAM_SIZE, NULL, 0) == HBI_ERR_FAIL, "misaligned base");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, 16, NULL, 0) == HBI_ERR_FAIL, "region below the alignment");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, asDesc, 2) == HBI_ERR_FAIL, "descending classes");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, asHuge, 1) == HBI_ERR_FAIL, "classes beyond the region");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, asMany, 1) == HBI_ERR_FAIL, "too many blocks");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, s_asClass, HBI_HEAP_MAX_CLASSES + 1) == HBI_ERR_FAIL, "too many classes");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, 0x100000, asHuge, 0) == HBI_OK, "no classes");
+    CHECK((psHeap->u32Spans == 1) && (psHeap->asSpan[0].u32Size == 0x100000), "general area");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, 0x100000, asFull, 1) == HBI_OK, "class filling the region");
+    CHECK(psHeap->u32Spans == 0, "empty general area");
+}
+
+static void TestClasses(void)
+{
+    HBI_HEAP_T *psHeap = &s_sHeap;
+    HBI_HEAP_STAT_T sStat;
+    void *apvFrame[5], *pvPcm, *pvOdd, *pvSmall;
+    uint32_t i, u32Peak, u32Classes = sizeof(s_asClass) / sizeof(s_asClass[0]);
+
+    printf("\n[2] Size classes and spills\n");
+    CHECK(HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, s_asClass, u32Classes) == HBI_OK, "init");
+
+    pvSmall = HBI_HeapAlloc(psHeap, 100);
+    pvPcm = HBI_HeapAlloc(psHeap, PCM_RING_SIZE);
+    pvOdd = HBI_HeapAlloc(psHeap, 17000);
+    printf("  100 B at +0x%06X, PCM ring at +0x%06X, 17000 B at +0x%06X\n",
+           (uint32_t)pvSmall - HYPER_RAM_MEM_MAP, (uint32_t)pvPcm - HYPER_RAM_MEM_MAP, (uint32_t)pvOdd - HYPER_RAM_MEM_MAP);
+    CHECK(pvSmall == (void *)psHeap->asPool[0].u32Base, "100 B not from the 4 KB class");
+    CHECK(pvPcm == (void *)psHeap->asPool[2].u32Base, "PCM ring not from its class");
+    CHECK(pvOdd == (void *)psHeap->asPool[2].u32Base + psHeap->asPool[2].u32Size, "17000 B not from the smallest class it fits");
+
+    for (i = 0; i < 5; i++)
+        apvFrame[i] = HBI_HeapAlloc(psHeap, QVGA_FRAME_SIZE);
+
+    CHECK((uint32_t)apvFrame[3] - psHeap->asPool[3].u32Base == 3 * psHeap->asPool[3].u32Size, "frame class order");
+    CHECK((uint32_t)apvFrame[4] == psHeap->asSpan[0].u32Addr, "fifth frame not from the general area");
+    CHECK(psHeap->asPool[3].u32Spills == 1, "spill count %u", psHeap->asPool[3].u32Spills);
+    CHECK(HBI_HeapAlloc(psHeap, HRAM_SIZE) == NULL, "region-sized block");
+    CHECK(HBI_HeapAlloc(psHeap, 0) == NULL, "empty block");
+
+    HBI_HeapGetStat(psHeap, &sStat);
+    printf("  in use %u B, general area %u B, largest free %u B, fails %u\n",
+           sStat.u32InUse, sStat.u32AreaInUse, sStat.u32LargestFree, sStat.u32Fails);
+    CHECK(sStat.u32AreaInUse == ((QVGA_FRAME_SIZE + HBI_HEAP_ALIGN - 1) & ~(HBI_HEAP_ALIGN - 1)), "area bytes");
+    CHECK(sStat.u32InUse == 4096 + 2 * psHeap->asPool[2].u32Size + 4 * psHeap->asPool[3].u32Size + sStat.u32AreaInUse, "bytes in use");
+    CHECK((sStat.u32Allocs == 8) && (sStat.u32Fails == 2), "counts");
+    u32Peak = sStat.u32InUse;
+
+    printf("  bad frees\n");
+    CHECK(HBI_HeapFree(psHeap, (uint8_t *)pvPcm + 32) == HBI_ERR_FAIL, "interior of a class block");
+    CHECK(HBI_HeapFree(psHeap, (uint8_t *)apvFrame[4] + 32) == HBI_ERR_FAIL, "interior of a span");
+    CHECK(HBI_HeapFree(psHeap, s_psMem) == HBI_ERR_FAIL, "SRAM pointer");
+    CHECK(HBI_HeapFree(psHeap, NULL) == HBI_OK, "NULL");
+    CHECK(HBI_HeapFree(psHeap, pvPcm) == HBI_OK, "free");
+    CHECK(HBI_HeapFree(psHeap, pvPcm) == HBI_ERR_FAIL, "double free of a class block");
+    CHECK(HBI_HeapFree(psHeap, apvFrame[4]) == HBI_OK, "free");
+    CHECK(HBI_HeapFree(psHeap, apvFrame[4]) == HBI_ERR_FAIL, "double free of a span");
+
+    HBI_HeapFree(psHeap, pvSmall);
+    HBI_HeapFree(psHeap, pvOdd);
+    for (i = 0; i < 4; i++)
+        HBI_HeapFree(psHeap, apvFrame[i]);
+
+    HBI_HeapGetStat(psHeap, &sStat);
+    CHECK((sStat.u32InUse == 0) && (sStat.u32Frees == 8), "all freed");
+    CHECK(sStat.u32Peak == u32Peak, "peak %u, expected %u", sStat.u32Peak, u32Peak);
+}
+
+static void TestCoalesce(void)
+{
+    HBI_HEAP_T *psHeap = &s_sHeap;
+    HBI_HEAP_STAT_T sStat;
+    void *apv[6];
+    uint32_t i, u32Area;
+
+    printf("\n[3] General area: best fit and coalescing\n");
+    HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, 0x100000, NULL, 0);
+
+    for (i = 0; i < 6; i++)
+        apv[i] = HBI_HeapAlloc(psHeap, (i + 1) * 0x1000);
+
+    /* Holes of 8 KB and 16 KB: a 7 KB block goes to the 8 KB hole */
+    HBI_HeapFree(psHeap, apv[1]);
+    HBI_HeapFree(psHeap, apv[3]);
+    CHECK(HBI_HeapAlloc(psHeap, 7000) == apv[1], "best fit");
+    CHECK(psHeap->u32Spans == 8, "spans %u, expected 8", psHeap->u32Spans);
+    HBI_HeapFree(psHeap, apv[1]);
+    CHECK(psHeap->u32Spans == 7, "spans %u, expected 7", psHeap->u32Spans);
+
+    /* The 12 KB block between the holes merges with both */
+    HBI_HeapFree(psHeap, apv[2]);
+    CHECK(psHeap->u32Spans == 5, "spans %u after a merge on both sides", psHeap->u32Spans);
+    CHECK(psHeap->asSpan[1].u32Size == 0x2000 + 0x3000 + 0x4000, "merged size 0x%X", psHeap->asSpan[1].u32Size);
+
+    HBI_HeapFree(psHeap, apv[0]);
+    HBI_HeapFree(psHeap, apv[5]);
+    HBI_HeapFree(psHeap, apv[4]);
+    HBI_HeapGetStat(psHeap, &sStat);
+    CHECK((psHeap->u32Spans == 1) && (sStat.u32LargestFree == 0x100000), "one span left");
+
+    /* A full span table hands out whole spans */
+    for (i = 0; i < HBI_HEAP_MAX_SPANS - 1; i++)
+        HBI_HeapAlloc(psHeap, 64);
+    u32Area = psHeap->asSpan[HBI_HEAP_MAX_SPANS - 1].u32Size;
+    CHECK(HBI_HeapAlloc(psHeap, 64) == (void *)psHeap->asSpan[HBI_HEAP_MAX_SPANS - 1].u32Addr, "last span");
+    HBI_HeapGetStat(psHeap, &sStat);
+    printf("  full table: last block %u B for 64 B asked\n", u32Area);
+    CHECK((sStat.u32AreaInUse == 0x100000) && (HBI_HeapAlloc(psHeap, 64) == NULL), "whole span");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Churn: what an application with audio, JPEG and a camera allocates over time                          */
+/*---------------------------------------------------------------------------------------------------------*/
+enum { KIND_PCM, KIND_JPEG, KIND_FRAME, KIND_VGA, KIND_ODD };
+
+static uint32_t Overlaps(const uint8_t *pu8Addr, uint32_t u32Size)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32Live; i++)
+    {
+        if ((pu8Addr < s_asLive[i].pu8Addr + s_asLive[i].u32Size) && (s_asLive[i].pu8Addr < pu8Addr + u32Size))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void Tag(uint8_t *pu8Addr, uint32_t u32Size, uint32_t u32Tag)
+{
+    memcpy(pu8Addr, &u32Tag, 4);
+    memcpy(pu8Addr + u32Size - 4, &u32Tag, 4);
+}
+
+static uint32_t Tagged(const uint8_t *pu8Addr, uint32_t u32Size, uint32_t u32Tag)
+{
+    return (memcmp(pu8Addr, &u32Tag, 4) == 0) && (memcmp(pu8Addr + u32Size - 4, &u32Tag, 4) == 0);
+}
+
+static uint32_t Count(uint32_t u32Kind)
+{
+    uint32_t i, n = 0;
+
+    for (i = 0; i < s_u32Live; i++)
+        n += (s_asLive[i].u32Kind == u32Kind);
+
+    return n;
+}
+
+static void Release(uint32_t u32Idx)
+{
+    LIVE_T *psLive = &s_asLive[u32Idx];
+
+    CHECK(Tagged(psLive->pu8Addr, psLive->u32Size, psLive->u32Tag), "block of %u B overwritten", psLive->u32Size);
+    CHECK(HBI_HeapFree(&s_sHeap, psLive->pu8Addr) == HBI_OK, "free");
+    *psLive = s_asLive[--s_u32Live];
+}
+
+static void ReleaseKind(uint32_t u32Kind)
+{
+    uint32_t i = 0;
+
+    while (i < s_u32Live)
+    {
+        if (s_asLive[i].u32Kind == u32Kind)
+            Release(i);
+        else
+            i++;
+    }
+}
+
+static uint32_t Take(uint32_t u32Kind, uint32_t u32Size)
+{
+    uint8_t *pu8Addr;
+    static uint32_t u32Tag;
+
+    if (s_u32Live == MAX_LIVE)
+        return 0;
+
+    pu8Addr = HBI_HeapAlloc(&s_sHeap, u32Size);
+    if (pu8Addr == NULL)
+        return 0;
+
+    CHECK(((uint32_t)pu8Addr % HBI_HEAP_ALIGN) == 0, "alignment");
+    CHECK(((uint32_t)pu8Addr >= HYPER_RAM_MEM_MAP) && ((uint32_t)pu8Addr + u32Size <= HYPER_RAM_MEM_MAP + s_sHeap.u32Size), "outside the heap");
+    CHECK(!Overlaps(pu8Addr, u32Size), "overlapping blocks");
+
+    s_asLive[s_u32Live].pu8Addr = pu8Addr;
+    s_asLive[s_u32Live].u32Size = u32Size;
+    s_asLive[s_u32Live].u32Tag = ++u32Tag;
+    s_asLive[s_u32Live].u32Kind = u32Kind;
+    Tag(pu8Addr, u32Size, u32Tag);
+    s_u32Live++;
+
+    return 1;
+}
+
+/* One step of the application: sessions start and end, frames rotate, odd buffers come and go */
+static uint32_t Step(void)
+{
+    uint32_t u32Op = Rand() % 100, u32Wants = 0, u32Got = 0, i;
+
+    if (u32Op < 3)
+    {
+        /* Audio track change: both rings are reallocated */
+        ReleaseKind(KIND_PCM);
+        u32Wants = 2;
+        u32Got = Take(KIND_PCM, PCM_RING_SIZE) + Take(KIND_PCM, PCM_RING_SIZE);
+    }
+    else if (u32Op < 15)
+    {
+        /* JPEG encode: pools of the session, then all freed together */
+        if (Count(KIND_JPEG) != 0)
+        {
+            ReleaseKind(KIND_JPEG);
+        }
+        else
+        {
+            u32Wants = 6;
+            for (i = 0; i < 4; i++)
+                u32Got += Take(KIND_JPEG, JPEG_POOL_SIZE);
+            u32Got += Take(KIND_JPEG, 1600 + Rand() % 4000);
+            u32Got += Take(KIND_JPEG, 5000 + Rand() % 3000);
+        }
+    }
+    else if (u32Op < 17)
+    {
+        /* Resolution change: QVGA triple buffer <-> one VGA frame */
+        if (Count(KIND_VGA) != 0)
+        {
+            ReleaseKind(KIND_VGA);
+            u32Wants = 3;
+            for (i = 0; i < 3; i++)
+                u32Got += Take(KIND_FRAME, QVGA_FRAME_SIZE);
+        }
+        else
+        {
+            ReleaseKind(KIND_FRAME);
+            u32Wants = 1;
+            u32Got = Take(KIND_VGA, VGA_FRAME_SIZE);
+        }
+    }
+    else if ((Count(KIND_ODD) < ODD_LIVE) && (Rand() & 1))
+    {
+        u32Wants = 1;
+        u32Got = Take(KIND_ODD, 64 + Rand() % ((Rand() & 7) ? 12000 : 120000));
+    }
+    else if (Count(KIND_ODD) != 0)
+    {
+        /* A random odd buffer goes */
+        for (i = Rand() % s_u32Live; s_asLive[i].u32Kind != KIND_ODD; i = (i + 1) % s_u32Live)
+            ;
+        Release(i);
+    }
+
+    return u32Wants - u32Got;
+}
+
+static void Churn(const char *pcName, const HBI_HEAP_CLASS_T *psClass, uint32_t u32Classes, uint32_t *pu32Fails)
+{
+    HBI_HEAP_STAT_T sStat;
+    uint32_t i, u32Fails = 0, u32MinLargest = HRAM_SIZE;
+
+    /* 1.5 MB: enough for the peak, tight enough to fragment */
+    CHECK(HBI_HeapInit(&s_sHeap, HYPER_RAM_MEM_MAP, 0x180000, psClass, u32Classes) == HBI_OK, "init");
+    s_u32Seed = 12345;
+    s_u32Live = 0;
+    Take(KIND_PCM, PCM_RING_SIZE);
+    Take(KIND_PCM, PCM_RING_SIZE);
+    for (i = 0; i < 3; i++)
+        Take(KIND_FRAME, QVGA_FRAME_SIZE);
+
+    for (i = 0; i < CHURN_STEPS; i++)
+    {
+        u32Fails += Step();
+
+        HBI_HeapGetStat(&s_sHeap, &sStat);
+        if ((s_sHeap.u32Spans != 0) && (sStat.u32LargestFree < u32MinLargest))
+            u32MinLargest = sStat.u32LargestFree;
+    }
+
+    HBI_HeapGetStat(&s_sHeap, &sStat);
+    printf("  %-13s allocs %6u, failed %4u, peak %7u B, spans %2u, smallest largest-free %7u B\n",
+           pcName, sStat.u32Allocs, u32Fails, sStat.u32Peak, s_sHeap.u32Spans, u32MinLargest);
+
+    while (s_u32Live != 0)
+        Release(0);
+
+    HBI_HeapGetStat(&s_sHeap, &sStat);
+    CHECK(sStat.u32InUse == 0, "%u B still in use", sStat.u32InUse);
+    CHECK(s_sHeap.u32Spans <= 1, "general area not coalesced: %u spans", s_sHeap.u32Spans);
+
+    *pu32Fails = u32Fails;
+}
+
+static void TestChurn(void)
+{
+    static const HBI_HEAP_CLASS_T asClass[] =
+    {
+        { 8192,             16 },
+        { JPEG_POOL_SIZE,   8 },
+        { PCM_RING_SIZE,    2 },
+        { QVGA_FRAME_SIZE,  3 },
+    };
+    uint32_t u32Classes, u32Plain, i;
+
+    printf("\n[4] %u steps of audio rings, JPEG sessions, frames and odd buffers in 1.5 MB\n", CHURN_STEPS);
+    Churn("no classes", NULL, 0, &u32Plain);
+    Churn("size classes", asClass, sizeof(asClass) / sizeof(asClass[0]), &u32Classes);
+    for (i = 0; i < 4; i++)
+        printf("    class %6u B: peak %u of %u, spills %u\n", s_sHeap.asPool[i].u32Size,
+               s_sHeap.asPool[i].u32Peak, s_sHeap.asPool[i].u32Count, s_sHeap.asPool[i].u32Spills);
+    CHECK(u32Classes <= u32Plain, "size classes failed more often");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Copies                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void FillStrip(uint8_t *pu8Strip, uint32_t u32Strip)
+{
+    uint32_t i;
+
+    for (i = 0; i < STRIP_SIZE; i++)
+        pu8Strip[i] = (uint8_t)(i * 7 + u32Strip * 31 + (i >> 9));
+}
+
+static void TestCopy(void)
+{
+    HBI_HEAP_T *psHeap = &s_sHeap;
+    HBI_HEAP_COPY_STAT_T *psStore = &psHeap->sStat.asCopy[HBI_HEAP_STORE];
+    HBI_HEAP_COPY_STAT_T *psLoad = &psHeap->sStat.asCopy[HBI_HEAP_LOAD];
+    uint8_t *pu8Frame, *pu8Frame2;
+    uint32_t u32Fence = 0, u32Strips = FRAME_H / STRIP_LINES, u32Ok = 1, u32Ticks, i;
+
+    printf("\n[5] Camera frame stored to HyperRAM in %u-line strips, four in flight\n", STRIP_LINES);
+    HBI_HeapInit(psHeap, HYPER_RAM_MEM_MAP, HRAM_SIZE, s_asClass, sizeof(s_asClass) / sizeof(s_asClass[0]));
+    psHeap->psCopy = &s_psMem->sCopy;
+    psHeap->pfnGetTime = GetTime;
+    pu8Frame = HBI_HeapAlloc(psHeap, QVGA_FRAME_SIZE);
+    pu8Frame2 = HBI_HeapAlloc(psHeap, QVGA_FRAME_SIZE);
+    memset(pu8Frame, 0, QVGA_FRAME_SIZE);
+
+    u32Ticks = SIM_PDMA_GetTicks();
+    for (i = 0; i < u32Strips; i++)
+    {
+        /* The capture side refills a strip buffer once its copy is done */
+        if (i >= 4)
+            CHECK(HBI_HeapCopyWait(psHeap, u32Fence - 3) == HBI_OK, "wait for strip buffer");
+        FillStrip(s_psMem->au8Strip[i % 4], i);
+        u32Fence = HBI_HeapCopy(psHeap, pu8Frame + i * STRIP_SIZE, s_psMem->au8Strip[i % 4], STRIP_SIZE);
+        if ((i % 4) == 3)
+            SIM_PDMA_RunMem();
+    }
+    SIM_PDMA_RunMem();
+    CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK, "wait");
+    u32Ticks = SIM_PDMA_GetTicks() - u32Ticks;
+
+    for (i = 0; i < u32Strips; i++)
+    {
+        FillStrip(s_psMem->au8Check, i);
+        if (memcmp(pu8Frame + i * STRIP_SIZE, s_psMem->au8Check, STRIP_SIZE) != 0)
+            u32Ok = 0;
+    }
+    CHECK(u32Ok, "frame data");
+
+    printf("  store: %u copies, %u B, %u B by PDMA, %u items; latency avg %u max %u ticks\n",
+           psStore->u32Copies, psStore->u32Bytes, psStore->u32DmaBytes, u32Ticks,
+           psStore->u32TotalTime / psStore->u32Timed, psStore->u32MaxTime);
+    CHECK((psStore->u32Copies == u32Strips) && (psStore->u32Bytes == QVGA_FRAME_SIZE), "store count");
+    CHECK(psStore->u32DmaBytes == QVGA_FRAME_SIZE, "store by PDMA");
+    CHECK(psStore->u32Timed == u32Strips, "timed %u", psStore->u32Timed);
+    CHECK(psStore->u32MaxTime == 4 * STRIP_SIZE / 4, "latency of the fourth strip %u", psStore->u32MaxTime);
+    CHECK(psHeap->u32PendCnt == 0, "pending");
+
+    printf("\n[6] Strips loaded back and the frame moved within HyperRAM\n");
+    u32Ok = 1;
+    for (i = 0; i < u32Strips; i++)
+    {
+        u32Fence = HBI_HeapCopy(psHeap, s_psMem->au8Strip[0], pu8Frame + i * STRIP_SIZE, STRIP_SIZE);
+        SIM_PDMA_RunMem();
+        CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK, "wait");
+        FillStrip(s_psMem->au8Check, i);
+        if (memcmp(s_psMem->au8Strip[0], s_psMem->au8Check, STRIP_SIZE) != 0)
+            u32Ok = 0;
+    }
+    CHECK(u32Ok, "loaded data");
+    CHECK((psLoad->u32Timed == u32Strips) && (psLoad->u32MaxTime == STRIP_SIZE / 4), "load latency %u", psLoad->u32MaxTime);
+
+    u32Fence = HBI_HeapCopy(psHeap, pu8Frame2, pu8Frame, QVGA_FRAME_SIZE);
+    SIM_PDMA_RunMem();
+    CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK, "wait");
+    CHECK(memcmp(pu8Frame2, pu8Frame, QVGA_FRAME_SIZE) == 0, "moved frame");
+    CHECK(psHeap->sStat.asCopy[HBI_HEAP_MOVE].u32DmaBytes == QVGA_FRAME_SIZE, "move by PDMA");
+
+    printf("\n[7] Small copies on the CPU, every PDMA slot in flight\n");
+    HBI_HeapClearStats(psHeap);
+    HBI_HeapCopy(psHeap, pu8Frame, s_psMem->au8Strip[0], 64);
+    CHECK((psStore->u32DmaBytes == 0) && (psStore->u32Timed == 1), "small copy");
+
+    for (i = 0; i < PDMA_COPY_SLOTS + 2; i++)
+    {
+        u32Fence = HBI_HeapCopy(psHeap, pu8Frame + i * 1024, s_psMem->au8Strip[1] + i * 1024, 1024);
+        SIM_PDMA_DropSwReq();           /* Nothing progresses */
+    }
+    printf("  pending %u, timed %u of %u\n", psHeap->u32PendCnt, psStore->u32Timed, psStore->u32Copies);
+    CHECK((psHeap->u32PendCnt == PDMA_COPY_SLOTS) && (psStore->u32Timed == 3), "tracking with the slots full");
+
+    PDMA0->SWREQ = 1UL << s_psMem->sCopy.u32Ch;
+    SIM_PDMA_RunMem();
+    CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK, "wait");
+    CHECK((psStore->u32Timed == psStore->u32Copies) && (psHeap->u32PendCnt == 0), "all timed");
+    CHECK(memcmp(pu8Frame, s_psMem->au8Strip[1], (PDMA_COPY_SLOTS + 2) * 1024) == 0, "data");
+
+    printf("\n[8] PDMA error reported by HBI_HeapCopyWait()\n");
+    HBI_HeapCopy(psHeap, (void *)BAD_ADDR, s_psMem->au8Strip[0], 4096);
+    u32Fence = HBI_HeapCopy(psHeap, pu8Frame, s_psMem->au8Strip[0], 4096);
+    SIM_PDMA_RunMem();
+    CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_ERR_FAIL, "abort not reported");
+    CHECK(HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK, "reported twice");
+
+    printf("\n[9] Without a copy service\n");
+    psHeap->psCopy = NULL;
+    HBI_HeapClearStats(psHeap);
+    FillStrip(s_psMem->au8Strip[2], 99);
+    u32Fence = HBI_HeapCopy(psHeap, pu8Frame, s_psMem->au8Strip[2], STRIP_SIZE);
+    CHECK((u32Fence == 0) && (HBI_HeapCopyWait(psHeap, u32Fence) == HBI_OK), "fence");
+    CHECK(memcmp(pu8Frame, s_psMem->au8Strip[2], STRIP_SIZE) == 0, "CPU copy");
+    CHECK((psStore->u32Timed == 1) && (psStore->u32DmaBytes == 0), "statistics");
+    CHECK((psHeap->sStat.u32InUse == 2 * psHeap->asPool[3].u32Size) && (psHeap->sStat.u32Peak == psHeap->sStat.u32InUse), "cleared with blocks in use");
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("HyperRAM heap", SimInit) != 0)
+        return 1;
+
+    if ((PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, GetTime) != 0) ||
+            (PDMA_CopyInit(&s_psMem->sCopy, &s_sSvc, 0) != 0))
+    {
+        printf("Init failed\n");
+        return 1;
+    }
+
+    SystemCoreClock = 100000;           /* Bounds the spin of PDMA_CopyWait() */
+
+    TestInit();
+    TestClasses();
+    TestCoalesce();
+    TestChurn();
+    TestCopy();
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,388 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the PDMA memory copy service
+ *           (PDMA_CopyInit() ... PDMA_CopyWait()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c
+ *               ../../../Library/StdDriver/src/pdma.c
+ *               -o pdma_memcopy
+ *           ./pdma_memcopy
+ *
+ *           The PDMA0 model of ../common/sim_pdma.c does the DMA part of each
+ *           copy when SIM_PDMA_RunMem() is called, so what the CPU did before
+ *           returning and what was left to PDMA can be told apart.
+ *           Checked are the CPU/PDMA dispatch by size and alignment, the
+ *           16-bit path, fills, fences, splitting at the transfer count
+ *           limit, falling back to the CPU with every slot in flight, error
+ *           reporting, a copy from address 0, the counters and fences across
+ *           the 32-bit wrap.
+ *           Timing is measured on the board by
+ *           SampleCode/StdDriver/PDMA_MemCopyBench.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+
+#define POOL_SIZE           16
+#define SRC_SIZE            (16 * 1024)
+#define BIG_SIZE            (300 * 1024)
+#define SRAM_SIM_SIZE       0x80000ul
+#define BAD_ADDR            0x60000000ul    /* Not in the simulated SRAM: target abort */
+#define ROM_SIZE            4096            /* APROM seen by PDMA at 0 */
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    PDMA_COPY_T sCopy;
+    uint8_t au8Src[SRC_SIZE];
+    uint8_t au8Dst[BIG_SIZE];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+static uint8_t s_au8Rom[ROM_SIZE];      /* The host cannot map address 0 */
+
+static uint32_t GetTime(void)
+{
+    return SIM_PDMA_GetTicks();
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddAlias(0, ROM_SIZE, s_au8Rom) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void FillSrc(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < SRC_SIZE; i++)
+        s_psMem->au8Src[i] = (uint8_t)(i * 13 + 7);
+
+    memset(s_psMem->au8Dst, 0, BIG_SIZE);
+}
+
+static uint32_t DmaBytes(void)
+{
+    return s_psMem->sCopy.u32DmaBytes;
+}
+
+static void TestSmall(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence;
+
+    printf("\n[1] Below the threshold: CPU, done on return\n");
+    FillSrc();
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst, s_psMem->au8Src, 100);
+    printf("  fence %u, DMA bytes %u, pending request %u\n", u32Fence, DmaBytes(), SIM_PDMA_SwReqPending());
+    CHECK(memcmp(s_psMem->au8Dst, s_psMem->au8Src, 100) == 0, "data");
+    CHECK(s_psMem->au8Dst[100] == 0, "overrun");
+    CHECK((u32Fence == 0) && PDMA_CopyIsDone(psCopy, u32Fence), "fence 0 not done");
+    CHECK((DmaBytes() == 0) && (SIM_PDMA_SwReqPending() == 0), "went to PDMA");
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+}
+
+static void TestAligned(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence;
+
+    printf("\n[2] 4 KB aligned: PDMA, 32-bit items\n");
+    FillSrc();
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst, s_psMem->au8Src, 4096);
+    printf("  fence %u, done before run %u\n", u32Fence, PDMA_CopyIsDone(psCopy, u32Fence));
+    CHECK((u32Fence == 1) && !PDMA_CopyIsDone(psCopy, u32Fence), "completed without PDMA");
+    CHECK(s_psMem->au8Dst[0] == 0, "CPU copied the body");
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == PDMA_COPY_TIMEOUT_ERR, "wait without progress");
+
+    SIM_PDMA_RunMem();
+    printf("  after run: done %u, model ticks %u\n", PDMA_CopyIsDone(psCopy, u32Fence), SIM_PDMA_GetTicks());
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst, s_psMem->au8Src, 4096) == 0, "data");
+    CHECK(SIM_PDMA_GetTicks() == 1024, "item count %u, expected 1024 words", SIM_PDMA_GetTicks());
+}
+
+static void TestUnaligned(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence, u32Ticks, u32Dma;
+
+    printf("\n[3] Same word offset: CPU head/tail, 32-bit body\n");
+    FillSrc();
+    u32Ticks = SIM_PDMA_GetTicks();
+    u32Dma = DmaBytes();
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst + 3, s_psMem->au8Src + 3, 1000);
+    CHECK((s_psMem->au8Dst[3] == s_psMem->au8Src[3]) && (s_psMem->au8Dst[4] == 0), "head");
+    CHECK(s_psMem->au8Dst[1002] == s_psMem->au8Src[1002], "tail");
+    SIM_PDMA_RunMem();
+    printf("  DMA bytes %u in %u items\n", DmaBytes() - u32Dma, SIM_PDMA_GetTicks() - u32Ticks);
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst + 3, s_psMem->au8Src + 3, 1000) == 0, "data");
+    CHECK((s_psMem->au8Dst[2] == 0) && (s_psMem->au8Dst[1003] == 0), "outside the range");
+    CHECK((DmaBytes() - u32Dma == 996) && (SIM_PDMA_GetTicks() - u32Ticks == 249), "body");
+
+    printf("\n[4] Halfword offset only: 16-bit body\n");
+    FillSrc();
+    u32Ticks = SIM_PDMA_GetTicks();
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst + 2, s_psMem->au8Src, 1000);
+    SIM_PDMA_RunMem();
+    printf("  items %u\n", SIM_PDMA_GetTicks() - u32Ticks);
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst + 2, s_psMem->au8Src, 1000) == 0, "data");
+    CHECK(SIM_PDMA_GetTicks() - u32Ticks == 500, "halfword items");
+
+    printf("\n[5] Odd offset: CPU\n");
+    FillSrc();
+    u32Dma = DmaBytes();
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst + 1, s_psMem->au8Src, 1000);
+    CHECK(memcmp(s_psMem->au8Dst + 1, s_psMem->au8Src, 1000) == 0, "data");
+    CHECK((DmaBytes() == u32Dma) && PDMA_CopyIsDone(psCopy, u32Fence), "went to PDMA");
+}
+
+static void TestMemSet(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence1, u32Fence2, i, u32Ok = 1;
+
+    printf("\n[6] Two fills in flight with different values\n");
+    memset(s_psMem->au8Dst, 0, 4096);
+    u32Fence1 = PDMA_MemSet(psCopy, s_psMem->au8Dst + 1, 0xA5, 2000);
+    u32Fence2 = PDMA_MemSet(psCopy, s_psMem->au8Dst + 2048, 0x3C, 2000);
+    printf("  fences %u, %u\n", u32Fence1, u32Fence2);
+    CHECK(u32Fence2 == u32Fence1 + 1, "fence order");
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, u32Fence2) == 0, "wait");
+
+    for (i = 0; i < 2000; i++)
+    {
+        if ((s_psMem->au8Dst[1 + i] != 0xA5) || (s_psMem->au8Dst[2048 + i] != 0x3C))
+            u32Ok = 0;
+    }
+
+    CHECK(u32Ok, "pattern");
+    CHECK((s_psMem->au8Dst[0] == 0) && (s_psMem->au8Dst[2001] == 0) && (s_psMem->au8Dst[4048] == 0), "outside the range");
+}
+
+static void TestFallback(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence = 0, u32Fallbacks, u32Issued, i;
+
+    printf("\n[7] Every slot in flight: CPU instead of waiting\n");
+    FillSrc();
+    u32Fallbacks = psCopy->u32Fallbacks;
+    u32Issued = psCopy->u32Issued;
+
+    for (i = 0; i < PDMA_COPY_SLOTS + 2; i++)
+    {
+        u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst + i * 1024, s_psMem->au8Src + i * 1024, 1024);
+        SIM_PDMA_DropSwReq();           /* Nothing progresses */
+    }
+
+    printf("  issued %u, fallbacks %u\n", psCopy->u32Issued - u32Issued, psCopy->u32Fallbacks - u32Fallbacks);
+    CHECK(psCopy->u32Issued - u32Issued == PDMA_COPY_SLOTS, "issued");
+    CHECK(psCopy->u32Fallbacks - u32Fallbacks == 2, "fallbacks");
+    CHECK(memcmp(s_psMem->au8Dst + PDMA_COPY_SLOTS * 1024, s_psMem->au8Src + PDMA_COPY_SLOTS * 1024, 2048) == 0, "CPU part");
+
+    /* The dropped request of the head transfer is given again, the rest follow from the interrupt */
+    PDMA0->SWREQ = 1UL << psCopy->u32Ch;
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst, s_psMem->au8Src, (PDMA_COPY_SLOTS + 2) * 1024) == 0, "data");
+}
+
+static void TestThreshold(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Dma, u32Fence;
+
+    printf("\n[8] Threshold\n");
+    FillSrc();
+    PDMA_CopySetThreshold(psCopy, 2048);
+    u32Dma = DmaBytes();
+    PDMA_MemCopy(psCopy, s_psMem->au8Dst, s_psMem->au8Src, 1024);
+    CHECK(DmaBytes() == u32Dma, "1 KB went to PDMA at 2 KB threshold");
+
+    /* 2050 bytes from offset 1 leave a 2044-byte body: below the threshold as well */
+    PDMA_MemCopy(psCopy, s_psMem->au8Dst + 1, s_psMem->au8Src + 1, 2050);
+    CHECK(DmaBytes() == u32Dma, "body below the threshold went to PDMA");
+
+    PDMA_CopySetThreshold(psCopy, 0);
+    CHECK(psCopy->u32Threshold == PDMA_COPY_THRESHOLD, "default");
+    PDMA_CopySetThreshold(psCopy, 16);
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst, s_psMem->au8Src, 64);
+    SIM_PDMA_RunMem();
+    CHECK((DmaBytes() == u32Dma + 64) && (PDMA_CopyWait(psCopy, u32Fence) == 0), "64 bytes at 16-byte threshold");
+    PDMA_CopySetThreshold(psCopy, 0);
+}
+
+static void TestBig(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Ops, u32Fence, i, u32Ok = 1;
+
+    printf("\n[9] %u KB fill: split at 65536 items\n", BIG_SIZE / 1024);
+    memset(s_psMem->au8Dst, 0, BIG_SIZE);
+    u32Ops = psCopy->u32DmaOps;
+    u32Fence = PDMA_MemSet(psCopy, s_psMem->au8Dst, 0x5A, BIG_SIZE);
+    printf("  operations %u\n", psCopy->u32DmaOps - u32Ops);
+    CHECK(psCopy->u32DmaOps - u32Ops == 2, "two operations");
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+
+    for (i = 0; i < BIG_SIZE; i++)
+    {
+        if (s_psMem->au8Dst[i] != 0x5A)
+            u32Ok = 0;
+    }
+
+    CHECK(u32Ok, "pattern");
+}
+
+static void TestAbort(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence;
+
+    printf("\n[10] Target abort reported once by PDMA_CopyWait()\n");
+    FillSrc();
+    PDMA_MemCopy(psCopy, (void *)BAD_ADDR, s_psMem->au8Src, 1024);
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst, s_psMem->au8Src, 1024);
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == PDMA_SVC_ABORT_ERR, "abort not reported");
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "reported twice");
+    CHECK(memcmp(s_psMem->au8Dst, s_psMem->au8Src, 1024) == 0, "copy after the abort");
+}
+
+static void TestFromZero(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t u32Fence, i;
+
+    printf("\n[11] Copy from address 0: a copy, not a fill\n");
+    for (i = 0; i < ROM_SIZE; i++)
+        s_au8Rom[i] = (uint8_t)(i * 13 + 1);
+    memset(s_psMem->au8Dst, 0xAA, ROM_SIZE);
+
+    /* Aligned destination and length: the CPU copies nothing, the body starts at 0 */
+    u32Fence = PDMA_MemCopy(psCopy, s_psMem->au8Dst, (const void *)0, ROM_SIZE);
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, u32Fence) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst, s_au8Rom, ROM_SIZE) == 0, "vector table not copied (first word 0x%08X)",
+          *(uint32_t *)s_psMem->au8Dst);
+}
+
+static void TestWrap(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+    uint32_t au32Fence[PDMA_COPY_SLOTS + 4], i, u32Zero = 0, u32Ok = 1;
+
+    printf("\n[12] Fences across the 32-bit wrap\n");
+    FillSrc();
+
+    /* Idle service: moving both counters together is what 2^32 earlier operations would leave */
+    psCopy->u32Issued = psCopy->u32Completed = 0xFFFFFFFDUL;
+
+    for (i = 0; i < PDMA_COPY_SLOTS + 4; i++)
+    {
+        au32Fence[i] = PDMA_MemCopy(psCopy, s_psMem->au8Dst + i * 1024, s_psMem->au8Src + i * 1024, 1024);
+        if (au32Fence[i] == 0)
+            u32Zero = 1;
+
+        /* Every fence in flight is not reached yet, the older ones are */
+        if ((i >= 1) && !PDMA_CopyIsDone(psCopy, au32Fence[i - 1]))
+            u32Ok = 0;
+        if (PDMA_CopyIsDone(psCopy, au32Fence[i]))
+            u32Ok = 0;
+
+        SIM_PDMA_RunMem();
+        CHECK(PDMA_CopyWait(psCopy, au32Fence[i]) == 0, "wait for fence 0x%08X", au32Fence[i]);
+    }
+
+    printf("  fences 0x%08X .. 0x%08X\n", au32Fence[0], au32Fence[PDMA_COPY_SLOTS + 3]);
+    CHECK(u32Zero, "no fence was 0");
+    CHECK(u32Ok, "fence state");
+    CHECK(psCopy->u32Completed == psCopy->u32Issued, "completed 0x%08X, issued 0x%08X", psCopy->u32Completed, psCopy->u32Issued);
+
+    /* A full queue across the wrap still falls back to the CPU rather than reusing a slot */
+    psCopy->u32Issued = psCopy->u32Completed = 0xFFFFFFFCUL;
+    memset(s_psMem->au8Dst, 0, BIG_SIZE);
+
+    for (i = 0; i < PDMA_COPY_SLOTS + 2; i++)
+    {
+        au32Fence[i] = PDMA_MemCopy(psCopy, s_psMem->au8Dst + i * 1024, s_psMem->au8Src + i * 1024, 1024);
+        SIM_PDMA_DropSwReq();
+    }
+
+    CHECK(psCopy->u32Issued == (uint32_t)(0xFFFFFFFCUL + PDMA_COPY_SLOTS), "issued 0x%08X", psCopy->u32Issued);
+    CHECK(!PDMA_CopyIsDone(psCopy, au32Fence[PDMA_COPY_SLOTS + 1]), "done before running");
+    PDMA0->SWREQ = 1UL << psCopy->u32Ch;
+    SIM_PDMA_RunMem();
+    CHECK(PDMA_CopyWait(psCopy, au32Fence[PDMA_COPY_SLOTS + 1]) == 0, "wait");
+    CHECK(memcmp(s_psMem->au8Dst, s_psMem->au8Src, (PDMA_COPY_SLOTS + 2) * 1024) == 0, "data");
+}
+
+int main(void)
+{
+    PDMA_COPY_T *psCopy = &s_psMem->sCopy;
+
+    if (HOSTSIM_TestBegin("PDMA memory copy service", SimInit) != 0)
+        return 1;
+
+    if ((PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, GetTime) != 0) ||
+            (PDMA_CopyInit(psCopy, &s_sSvc, 0) != 0))
+    {
+        printf("Init failed\n");
+        return 1;
+    }
+
+    SystemCoreClock = 100000;           /* Bounds the spin of PDMA_CopyWait() */
+    printf("Channel %u, threshold %u bytes\n", psCopy->u32Ch, psCopy->u32Threshold);
+
+    TestSmall();
+    TestAligned();
+    TestUnaligned();
+    TestMemSet();
+    TestFallback();
+    TestThreshold();
+    TestBig();
+    TestAbort();
+    TestFromZero();
+    TestWrap();
+
+    printf("\nCPU: %u ops, %u bytes; PDMA: %u ops, %u bytes; fallbacks %u\n",
+           psCopy->u32CpuOps, psCopy->u32CpuBytes, psCopy->u32DmaOps, psCopy->u32DmaBytes, psCopy->u32Fallbacks);
+    PDMA_CopyDeInit(psCopy);
+
+    return HOSTSIM_TestEnd();
+}
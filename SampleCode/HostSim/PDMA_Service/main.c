@@ -0,0 +1,499 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the PDMA channel service
+ *           (PDMA_SvcInit() ... PDMA_SvcGetLoad()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c
+ *               ../../../Library/StdDriver/src/pdma.c
+ *               -o pdma_service
+ *           ./pdma_service
+ *
+ *           The PDMA0 model of ../common/sim_pdma.c stands in for the hardware,
+ *           with the simulated SRAM as its only memory; its item count is the
+ *           clock of the statistics.
+ *           Checked are channel allocation, chained segments, queue order,
+ *           resubmission from the callback, descriptor pool exhaustion, one
+ *           channel shared by two request sources, aborts, stride/repeat
+ *           programming, cancellation and channel load.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+
+#define POOL_SIZE           16
+#define QUEUE_XFERS         6
+#define SRAM_SIM_SIZE       0x20000ul
+#define HIGH_POOL           (SRAM_BASE + 0x10000ul)     /* Pool outside the reset SCATBA window */
+#define BAD_ADDR            0x60000000ul    /* Not in the simulated SRAM: target abort */
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    uint8_t au8Src[4096];
+    uint8_t au8Dst[4096];
+    uint32_t u32UartTx;                 /* Stand-in for UART0 DAT */
+    uint32_t u32SpiTx;                  /* Stand-in for SPI0 TX */
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+
+static uint32_t s_u32Irqs;
+
+/* Callback log */
+static uint32_t s_u32Done;
+static int32_t s_ai32Status[16];
+static void *s_apvArg[16];
+static uint32_t s_u32HeadOk;
+
+static uint32_t GetTime(void)
+{
+    return SIM_PDMA_GetTicks();
+}
+
+void PDMA0_IRQHandler(void)
+{
+    s_u32Irqs++;
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Done(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    if (s_u32Done < 16)
+    {
+        s_ai32Status[s_u32Done] = i32Status;
+        s_apvArg[s_u32Done] = psXfer->pvArg;
+    }
+
+    s_u32Done++;
+}
+
+static void ResetLog(void)
+{
+    s_u32Done = 0;
+    s_u32Irqs = 0;
+    s_u32HeadOk = 0;
+    memset(s_ai32Status, 0, sizeof(s_ai32Status));
+    memset(s_apvArg, 0, sizeof(s_apvArg));
+}
+
+static void FillSrc(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(s_psMem->au8Src); i++)
+        s_psMem->au8Src[i] = (uint8_t)(i * 13 + 7);
+
+    memset(s_psMem->au8Dst, 0, sizeof(s_psMem->au8Dst));
+}
+
+#define ADDR(p)     ((uint32_t)(uintptr_t)(p))
+#define MEM_CTL     (PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128)
+
+static void TestAlloc(void)
+{
+    int32_t ai32Ch[PDMA_CH_MAX];
+    int32_t i32Any, i32Stride, i32Repeat, i32Ch;
+    uint32_t n = 0, i;
+
+    printf("\n[1] Channel allocation, channel 15 reserved\n");
+    i32Any = PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+    i32Stride = PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_STRIDE);
+    i32Repeat = PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_REPEAT);
+    printf("  any -> %d, stride -> %d, repeat -> %d\n", i32Any, i32Stride, i32Repeat);
+    CHECK((i32Any == 14) && (i32Stride == 5) && (i32Repeat == 1), "allocation order");
+    CHECK((PDMA0->CHCTL & PDMA0->INTEN) == ((1UL << 14) | (1UL << 5) | (1UL << 1)), "CHCTL/INTEN 0x%04X", PDMA0->CHCTL);
+
+    while ((i32Ch = PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY)) >= 0)
+        ai32Ch[n++] = i32Ch;
+
+    printf("  %u more channels, last %d, then %d\n", n, ai32Ch[n - 1], i32Ch);
+    CHECK((n == 12) && (ai32Ch[n - 1] == 0) && (i32Ch == PDMA_SVC_NOCH_ERR), "exhaustion");
+    CHECK(PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_REPEAT) == PDMA_SVC_NOCH_ERR, "repeat channel after exhaustion");
+    CHECK(!(s_sSvc.u32ChUsed & (1UL << 15)), "reserved channel handed out");
+
+    for (i = 0; i < n; i++)
+        PDMA_SvcFreeCh(&s_sSvc, (uint32_t)ai32Ch[i]);
+
+    PDMA_SvcFreeCh(&s_sSvc, (uint32_t)i32Any);
+    PDMA_SvcFreeCh(&s_sSvc, (uint32_t)i32Stride);
+    PDMA_SvcFreeCh(&s_sSvc, (uint32_t)i32Repeat);
+    CHECK((s_sSvc.u32ChUsed == 0) && (PDMA0->CHCTL == 0), "channels not released");
+    CHECK(PDMA_SvcFreeCh(&s_sSvc, 3) == PDMA_SVC_PARAM_ERR, "double free accepted");
+}
+
+static void TestChain(void)
+{
+    static const uint32_t au32Src[3] = {0, 1000, 2500};
+    static const uint32_t au32Dst[3] = {100, 3000, 600};
+    static const uint32_t au32Cnt[3] = {100, 37, 256};
+    PDMA_SEG_T asSeg[3];
+    PDMA_XFER_T sXfer;
+    uint32_t u32Ch, i, u32Bad = 0, u32FreeQueued;
+
+    printf("\n[2] One transfer of three chained segments\n");
+    FillSrc();
+    ResetLog();
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    for (i = 0; i < 3; i++)
+    {
+        asSeg[i].u32SrcAddr = ADDR(&s_psMem->au8Src[au32Src[i]]);
+        asSeg[i].u32DstAddr = ADDR(&s_psMem->au8Dst[au32Dst[i]]);
+        asSeg[i].u32TransCount = au32Cnt[i];
+    }
+
+    PDMA_SvcInitXfer(&sXfer, asSeg, 3, PDMA_MEM, MEM_CTL, Done, NULL);
+    CHECK(PDMA_SvcSubmit(&s_sSvc, u32Ch, &sXfer) == 0, "submit");
+    u32FreeQueued = s_sSvc.u32DescFree;
+    SIM_PDMA_RunMem();
+
+    for (i = 0; i < 3; i++)
+        u32Bad += (memcmp(&s_psMem->au8Dst[au32Dst[i]], &s_psMem->au8Src[au32Src[i]], au32Cnt[i]) != 0);
+
+    printf("  bad segments %u, callbacks %u, interrupts %u, free descriptors %u while queued, %u after\n",
+           u32Bad, s_u32Done, s_u32Irqs, u32FreeQueued, s_sSvc.u32DescFree);
+    CHECK(u32Bad == 0, "segment data");
+    CHECK((s_u32Done == 1) && (s_ai32Status[0] == 0) && (sXfer.i32Status == 0), "completion");
+    CHECK(s_u32Irqs == 1, "intermediate tables raised an interrupt");
+    CHECK((u32FreeQueued == POOL_SIZE - 3) && (s_sSvc.u32DescFree == POOL_SIZE), "descriptor accounting");
+    CHECK((s_sSvc.asCh[u32Ch].sStat.u32Xfers == 1) && (s_sSvc.asCh[u32Ch].sStat.u32Bytes == 393), "statistics");
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+static uint32_t s_u32QueueCh;
+static PDMA_XFER_T s_asQueue[QUEUE_XFERS];
+
+static void QueueDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    uint32_t u32Idx = (uint32_t)(uintptr_t)psXfer->pvArg;
+
+    /* The next transfer is already running when the callback sees the previous one */
+    if ((u32Idx + 1 == QUEUE_XFERS) ? (s_sSvc.asCh[s_u32QueueCh].psHead == NULL) :
+            (s_sSvc.asCh[s_u32QueueCh].psHead == &s_asQueue[u32Idx + 1]))
+        s_u32HeadOk++;
+
+    Done(psXfer, i32Status);
+}
+
+static void TestQueue(void)
+{
+    PDMA_SEG_T asSeg[QUEUE_XFERS];
+    PDMA_SVC_STAT_T *psStat;
+    uint32_t i, u32Order = 1, u32Bad = 0;
+
+    printf("\n[3] %u transfers queued on one channel\n", QUEUE_XFERS);
+    FillSrc();
+    ResetLog();
+    s_u32QueueCh = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    for (i = 0; i < QUEUE_XFERS; i++)
+    {
+        asSeg[i].u32SrcAddr = ADDR(&s_psMem->au8Src[i * 64]);
+        asSeg[i].u32DstAddr = ADDR(&s_psMem->au8Dst[(QUEUE_XFERS - 1 - i) * 64]);
+        asSeg[i].u32TransCount = 64;
+        PDMA_SvcInitXfer(&s_asQueue[i], &asSeg[i], 1, PDMA_MEM, MEM_CTL, QueueDone, (void *)(uintptr_t)i);
+        CHECK(PDMA_SvcSubmit(&s_sSvc, s_u32QueueCh, &s_asQueue[i]) == 0, "submit %u", i);
+    }
+
+    SIM_PDMA_RunMem();
+
+    for (i = 0; i < QUEUE_XFERS; i++)
+    {
+        u32Order &= (s_apvArg[i] == (void *)(uintptr_t)i) && (s_ai32Status[i] == 0);
+        u32Bad += (memcmp(&s_psMem->au8Dst[(QUEUE_XFERS - 1 - i) * 64], &s_psMem->au8Src[i * 64], 64) != 0);
+    }
+
+    psStat = &s_sSvc.asCh[s_u32QueueCh].sStat;
+    printf("  callbacks %u in order %u, next already started %u, max depth %u, max latency %u, bytes %u\n",
+           s_u32Done, u32Order, s_u32HeadOk, psStat->u32MaxDepth, psStat->u32MaxLatency, psStat->u32Bytes);
+    CHECK((s_u32Done == QUEUE_XFERS) && u32Order && (u32Bad == 0), "queue order or data");
+    CHECK(s_u32HeadOk == QUEUE_XFERS, "next transfer not started before the callback");
+    CHECK((psStat->u32MaxDepth == QUEUE_XFERS) && (psStat->u32Xfers == QUEUE_XFERS) &&
+          (psStat->u32Bytes == QUEUE_XFERS * 64) && (psStat->u32MaxLatency == QUEUE_XFERS * 64) &&
+          (psStat->u32BusyTime == QUEUE_XFERS * 64), "statistics");
+    PDMA_SvcFreeCh(&s_sSvc, s_u32QueueCh);
+}
+
+static uint32_t s_u32PingCh, s_u32PingLeft;
+
+static void PingDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    Done(psXfer, i32Status);
+
+    if (s_u32PingLeft && (i32Status == 0))
+    {
+        s_u32PingLeft--;
+        PDMA_SvcSubmit(&s_sSvc, s_u32PingCh, psXfer);
+    }
+}
+
+static void TestResubmit(void)
+{
+    PDMA_SEG_T sSeg;
+    PDMA_XFER_T sXfer;
+
+    printf("\n[4] Transfer resubmitted from its own callback\n");
+    ResetLog();
+    s_u32PingCh = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+    s_u32PingLeft = 9;
+    sSeg.u32SrcAddr = ADDR(s_psMem->au8Src);
+    sSeg.u32DstAddr = ADDR(s_psMem->au8Dst);
+    sSeg.u32TransCount = 32;
+    PDMA_SvcInitXfer(&sXfer, &sSeg, 1, PDMA_MEM, MEM_CTL, PingDone, NULL);
+    PDMA_SvcSubmit(&s_sSvc, s_u32PingCh, &sXfer);
+    SIM_PDMA_RunMem();
+
+    printf("  runs %u, free descriptors %u\n", s_u32Done, s_sSvc.u32DescFree);
+    CHECK((s_u32Done == 10) && (s_sSvc.u32DescFree == POOL_SIZE), "resubmission");
+    PDMA_SvcFreeCh(&s_sSvc, s_u32PingCh);
+}
+
+static void TestPool(void)
+{
+    PDMA_SEG_T asSeg[4];
+    PDMA_XFER_T asXfer[5];
+    int32_t ai32Ret[5];
+    uint32_t u32Ch, i;
+
+    printf("\n[5] Descriptor pool of %u, transfers of 4 segments\n", POOL_SIZE);
+    ResetLog();
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    for (i = 0; i < 4; i++)
+    {
+        asSeg[i].u32SrcAddr = ADDR(&s_psMem->au8Src[i * 16]);
+        asSeg[i].u32DstAddr = ADDR(&s_psMem->au8Dst[i * 16]);
+        asSeg[i].u32TransCount = 16;
+    }
+
+    for (i = 0; i < 5; i++)
+    {
+        PDMA_SvcInitXfer(&asXfer[i], asSeg, 4, PDMA_MEM, MEM_CTL, Done, NULL);
+        ai32Ret[i] = PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[i]);
+    }
+
+    printf("  submit results %d %d %d %d %d, min free %u, fails %u\n", ai32Ret[0], ai32Ret[1], ai32Ret[2],
+           ai32Ret[3], ai32Ret[4], s_sSvc.u32DescMinFree, s_sSvc.u32DescFails);
+    CHECK((ai32Ret[3] == 0) && (ai32Ret[4] == PDMA_SVC_NODESC_ERR), "pool exhaustion");
+    CHECK((s_sSvc.u32DescMinFree == 0) && (s_sSvc.u32DescFails == 1), "pool statistics");
+
+    SIM_PDMA_RunMem();
+    CHECK((s_u32Done == 4) && (s_sSvc.u32DescFree == POOL_SIZE), "pool not refilled");
+    CHECK(PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[4]) == 0, "submit after refill");
+    SIM_PDMA_RunMem();
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+static void TestShared(void)
+{
+    static const char s_acUart[] = "HELLO UART";
+    static const char s_acSpi[] = "SPI DATA";
+    char acUartLog[16] = {0}, acSpiLog[16] = {0};
+    PDMA_SEG_T sUartSeg, sSpiSeg;
+    PDMA_XFER_T sUart, sSpi;
+    uint32_t u32Ch, n, u32SpiEarly;
+    volatile uint32_t *pu32ReqSel = &PDMA0->REQSEL0_3;
+
+    printf("\n[6] One channel shared by UART0 TX and SPI0 TX\n");
+    ResetLog();
+    memcpy(s_psMem->au8Src, s_acUart, sizeof(s_acUart) - 1);
+    memcpy(&s_psMem->au8Src[64], s_acSpi, sizeof(s_acSpi) - 1);
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    sUartSeg.u32SrcAddr = ADDR(s_psMem->au8Src);
+    sUartSeg.u32DstAddr = ADDR(&s_psMem->u32UartTx);
+    sUartSeg.u32TransCount = sizeof(s_acUart) - 1;
+    PDMA_SvcInitXfer(&sUart, &sUartSeg, 1, PDMA_UART0_TX,
+                     PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_FIX | PDMA_REQ_SINGLE | PDMA_BURST_1, Done, (void *)"uart");
+
+    sSpiSeg.u32SrcAddr = ADDR(&s_psMem->au8Src[64]);
+    sSpiSeg.u32DstAddr = ADDR(&s_psMem->u32SpiTx);
+    sSpiSeg.u32TransCount = sizeof(s_acSpi) - 1;
+    PDMA_SvcInitXfer(&sSpi, &sSpiSeg, 1, PDMA_SPI0_TX,
+                     PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_FIX | PDMA_REQ_SINGLE | PDMA_BURST_1, Done, (void *)"spi");
+
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &sUart);
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &sSpi);
+
+    /* SPI asks first, but the channel belongs to the UART transfer */
+    u32SpiEarly = SIM_PDMA_PeriphReq(PDMA_SPI0_TX);
+
+    for (n = 0; SIM_PDMA_PeriphReq(PDMA_UART0_TX); n++)
+        acUartLog[n] = (char)s_psMem->u32UartTx;
+
+    for (n = 0; SIM_PDMA_PeriphReq(PDMA_SPI0_TX); n++)
+        acSpiLog[n] = (char)s_psMem->u32SpiTx;
+
+    printf("  early SPI request served %u, UART sent \"%s\", SPI sent \"%s\", callbacks %u\n",
+           u32SpiEarly, acUartLog, acSpiLog, s_u32Done);
+    CHECK(u32SpiEarly == 0, "SPI request served on the UART transfer");
+    CHECK((strcmp(acUartLog, s_acUart) == 0) && (strcmp(acSpiLog, s_acSpi) == 0), "peripheral data");
+    CHECK((s_u32Done == 2) && (strcmp((char *)s_apvArg[0], "uart") == 0) && (strcmp((char *)s_apvArg[1], "spi") == 0),
+          "completion order");
+    CHECK(((pu32ReqSel[u32Ch >> 2] >> ((u32Ch & 3) * 8)) & 0x7F) == PDMA_SPI0_TX, "request source not switched");
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+static void TestAbort(void)
+{
+    PDMA_SEG_T asSeg[2];
+    PDMA_XFER_T asXfer[2];
+    uint32_t u32Ch;
+
+    printf("\n[7] Target abort on the first of two queued transfers\n");
+    FillSrc();
+    ResetLog();
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    asSeg[0].u32SrcAddr = BAD_ADDR;
+    asSeg[0].u32DstAddr = ADDR(s_psMem->au8Dst);
+    asSeg[0].u32TransCount = 16;
+    asSeg[1].u32SrcAddr = ADDR(s_psMem->au8Src);
+    asSeg[1].u32DstAddr = ADDR(&s_psMem->au8Dst[256]);
+    asSeg[1].u32TransCount = 16;
+    PDMA_SvcInitXfer(&asXfer[0], &asSeg[0], 1, PDMA_MEM, MEM_CTL, Done, NULL);
+    PDMA_SvcInitXfer(&asXfer[1], &asSeg[1], 1, PDMA_MEM, MEM_CTL, Done, NULL);
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[0]);
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[1]);
+    SIM_PDMA_RunMem();
+
+    printf("  status %d then %d, errors %u, transfers %u\n", s_ai32Status[0], s_ai32Status[1],
+           s_sSvc.asCh[u32Ch].sStat.u32Errors, s_sSvc.asCh[u32Ch].sStat.u32Xfers);
+    CHECK((s_u32Done == 2) && (s_ai32Status[0] == PDMA_SVC_ABORT_ERR) && (s_ai32Status[1] == 0), "abort status");
+    CHECK(memcmp(&s_psMem->au8Dst[256], s_psMem->au8Src, 16) == 0, "transfer after the abort");
+    CHECK((s_sSvc.asCh[u32Ch].sStat.u32Errors == 1) && (s_sSvc.asCh[u32Ch].sStat.u32Xfers == 1), "statistics");
+    CHECK((PDMA0->ABTSTS == 0) && (s_sSvc.u32DescFree == POOL_SIZE), "abort clean-up");
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+static void TestStrideCancel(void)
+{
+    PDMA_SEG_T sSeg;
+    PDMA_XFER_T asXfer[2];
+    uint32_t u32Ch, u32Plain;
+    DSCT_T *psDesc;
+
+    printf("\n[8] Stride/repeat programming and cancellation\n");
+    ResetLog();
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_REPEAT);
+    u32Plain = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+
+    sSeg.u32SrcAddr = ADDR(s_psMem->au8Src);
+    sSeg.u32DstAddr = ADDR(s_psMem->au8Dst);
+    sSeg.u32TransCount = 16;
+    PDMA_SvcInitXfer(&asXfer[0], &sSeg, 1, PDMA_MEM, PDMA_WIDTH_32 | PDMA_SAR_INC | PDMA_DAR_INC, Done, NULL);
+    PDMA_SvcSetStride(&asXfer[0], 1, 2, 1);
+    PDMA_SvcSetRepeat(&asXfer[0], 8, 1, 1);
+    asXfer[1] = asXfer[0];
+
+    CHECK(PDMA_SvcSubmit(&s_sSvc, u32Plain, &asXfer[0]) == PDMA_SVC_PARAM_ERR, "stride accepted on channel %u", u32Plain);
+    CHECK(PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[0]) == 0, "stride submit");
+    CHECK(PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[1]) == 0, "second submit");
+    psDesc = asXfer[0].psDesc;
+
+    printf("  channel %u: ASOCR 0x%08X STCR %u AICTL 0x%08X RCNT %u\n", u32Ch, PDMA0->STRIDE[u32Ch].ASOCR,
+           PDMA0->STRIDE[u32Ch].STCR, PDMA0->REPEAT[u32Ch].AICTL, PDMA0->REPEAT[u32Ch].RCNT);
+    CHECK((PDMA0->STRIDE[u32Ch].ASOCR == ((1UL << 16) | 2)) && (PDMA0->STRIDE[u32Ch].STCR == 1), "stride registers");
+    CHECK((PDMA0->REPEAT[u32Ch].AICTL == ((8UL << 16) | 1)) && (PDMA0->REPEAT[u32Ch].RCNT == 1), "repeat registers");
+    CHECK(psDesc->CTL & PDMA_DSCT_CTL_STRIDEEN_Msk, "descriptor without STRIDEEN");
+
+    /* Both transfers are still queued: freeing the channel cancels them */
+    SIM_PDMA_DropSwReq();
+    CHECK(PDMA_SvcFreeCh(&s_sSvc, u32Ch) == 0, "free");
+    printf("  cancelled %u, status %d %d, free descriptors %u\n", s_u32Done, s_ai32Status[0], s_ai32Status[1],
+           s_sSvc.u32DescFree);
+    CHECK((s_u32Done == 2) && (s_ai32Status[0] == PDMA_SVC_CANCEL_ERR) && (s_ai32Status[1] == PDMA_SVC_CANCEL_ERR),
+          "cancel status");
+    CHECK((s_sSvc.u32DescFree == POOL_SIZE) && !(PDMA0->CHCTL & (1UL << u32Ch)), "cancel clean-up");
+    PDMA_SvcFreeCh(&s_sSvc, u32Plain);
+}
+
+static void TestLoad(void)
+{
+    PDMA_SEG_T sSeg;
+    PDMA_XFER_T sXfer;
+    uint32_t u32Ch, u32Load;
+
+    printf("\n[9] Channel load: 100 ticks busy out of 400\n");
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+    SIM_PDMA_AddTicks(50);
+    PDMA_SvcClearStats(&s_sSvc, u32Ch);
+
+    sSeg.u32SrcAddr = ADDR(s_psMem->au8Src);
+    sSeg.u32DstAddr = ADDR(s_psMem->au8Dst);
+    sSeg.u32TransCount = 100;
+    PDMA_SvcInitXfer(&sXfer, &sSeg, 1, PDMA_MEM, MEM_CTL, NULL, NULL);
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &sXfer);
+    SIM_PDMA_RunMem();
+    SIM_PDMA_AddTicks(300);
+
+    u32Load = PDMA_SvcGetLoad(&s_sSvc, u32Ch);
+    printf("  load %u/1000, busy %u\n", u32Load, s_sSvc.asCh[u32Ch].sStat.u32BusyTime);
+    CHECK(u32Load == 250, "load");
+    CHECK(sXfer.i32Status == 0, "transfer without callback");
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("PDMA channel service", SimInit) != 0)
+        return 1;
+
+    CHECK(PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, 0, PDMA_SCATBA_SET, 0, GetTime) == PDMA_SVC_PARAM_ERR, "empty pool accepted");
+    CHECK(PDMA0->SCATBA == SRAM_BASE, "SCATBA reset value 0x%08X", PDMA0->SCATBA);
+    CHECK(PDMA_SvcInit(&s_sSvc, PDMA0, (DSCT_T *)HIGH_POOL, POOL_SIZE, PDMA_SCATBA_SHARED, 0, GetTime) == PDMA_SVC_PARAM_ERR,
+          "pool outside a shared SCATBA window accepted");
+    CHECK(PDMA_SvcInit(&s_sSvc, PDMA0, (DSCT_T *)(HIGH_POOL - 8), 2, PDMA_SCATBA_SET, 0, GetTime) == PDMA_SVC_PARAM_ERR,
+          "pool across a 64 KB boundary accepted");
+    CHECK((PDMA_SvcInit(&s_sSvc, PDMA0, (DSCT_T *)HIGH_POOL, POOL_SIZE, PDMA_SCATBA_SET, 0, GetTime) == 0) &&
+          (PDMA0->SCATBA == HIGH_POOL), "pool above the first 64 KB not claimed, SCATBA 0x%08X", PDMA0->SCATBA);
+
+    if (PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, (1UL << 15), GetTime) != 0)
+    {
+        printf("PDMA_SvcInit failed\n");
+        return 1;
+    }
+
+    CHECK(PDMA0->SCATBA == SRAM_BASE, "SCATBA");
+
+    TestAlloc();
+    TestChain();
+    TestQueue();
+    TestResubmit();
+    TestPool();
+    TestShared();
+    TestAbort();
+    TestStrideCancel();
+    TestLoad();
+
+    return HOSTSIM_TestEnd();
+}
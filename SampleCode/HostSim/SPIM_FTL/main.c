@@ -0,0 +1,601 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check and benchmark of the SPIM flash translation layer
+ *           (SPIM_FtlInit() ... SPIM_FtlGetWear()) with FatFs on top.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include -I../../../ThirdParty/FatFs/source
+ *               main.c ../../StdDriver/SPIM_FTL_FATFS/diskio.c ../common/hostsim.c ../common/sim_spim.c
+ *               ../../../Library/StdDriver/src/spim.c ../../../Library/StdDriver/src/pdma.c
+ *               ../../../ThirdParty/FatFs/source/ff.c
+ *               -o spim_ftl
+ *           ./spim_ftl
+ *
+ *           The SPIM model of ../common/sim_spim.c carries a W25Q16-like NOR
+ *           flash with typical page program and erase times, one tick per
+ *           microsecond. While the FTL waits, its idle hook lets the model run
+ *           to the end of the flash operation, so the times reported are those
+ *           of the flash and SPIM.
+ *           Checked and measured: mounting erased flash, sequential fill and
+ *           remount, random overwrites with write amplification and IOPS,
+ *           reads suspending the background erase, static wear leveling on
+ *           and off under a hot/cold load, recovery from power failures torn
+ *           into programs and erases, and a FAT volume through the diskio.c
+ *           of the SPIM_FTL_FATFS sample surviving a remount.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_spim.h"
+#include "ff.h"
+#include "diskio.h"
+
+#define SRAM_SIM_SIZE       0x20000ul
+#define IO_SECTORS          8
+#define MAX_SECTORS         (SPIM_FTL_MAX_BLOCKS * SPIM_FTL_SLOTS)
+#define FILE_BUF_SIZE       4096
+
+/* Areas of the flash the checks use */
+#define BENCH_BASE          0x000000ul
+#define BENCH_BLOCKS        512
+#define BENCH_SPARE         64
+#define WEAR_BASE           0x100000ul
+#define WEAR_BLOCKS         32
+#define WEAR_SPARE          4
+#define CUT_BASE            0x180000ul
+#define CUT_BLOCKS          32
+#define CUT_SPARE           4
+#define FAT_BLOCKS          256
+#define FAT_SPARE           16
+
+#define RANDOM_WRITES       1000
+#define RANDOM_READS        1000
+#define HOT_SECTORS         16
+#define HOT_WRITES          1000
+#define WL_THRESHOLD        8
+#define POWER_CUTS          100
+#define LOG_RECORDS         1000
+
+/* Everything SPIM DMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    SPIM_PRG_T sPrg;
+    SPIM_FTL_T sFtl;
+    FATFS sFs;
+    FIL sFile;
+    uint8_t au8Wr[IO_SECTORS * SPIM_FTL_SECTOR_SIZE];
+    uint8_t au8Rd[IO_SECTORS * SPIM_FTL_SECTOR_SIZE];
+    uint8_t au8File[FILE_BUF_SIZE];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+SPIM_FTL_T *g_psFtl;                /* The FTL of drive 0, for diskio.c */
+
+/* Version last written to each sector, 0 for never */
+static uint32_t s_au32Ver[MAX_SECTORS];
+static uint32_t s_u32Seed = 0x2545F491;
+
+static uint32_t GetTime(void)
+{
+    return SIM_SPIM_GetTicks();
+}
+
+/* FTL idle hook: let the model run to its next change instead of polling tick by tick */
+static void Idle(void)
+{
+    if (SIM_SPIM_RunBusy(SIM_SPIM_T_BE64) == 0)
+        SIM_SPIM_Run(1);
+}
+
+static uint32_t Rand(void)
+{
+    s_u32Seed ^= s_u32Seed << 13;
+    s_u32Seed ^= s_u32Seed >> 17;
+    s_u32Seed ^= s_u32Seed << 5;
+    return s_u32Seed;
+}
+
+static void Fill(uint8_t *pu8Buf, uint32_t u32Lsn, uint32_t u32Ver)
+{
+    uint32_t i;
+
+    for (i = 0; i < SPIM_FTL_SECTOR_SIZE; i++)
+        pu8Buf[i] = (uint8_t)(u32Lsn * 131 + u32Ver * 17 + i * 7 + (i >> 8));
+
+    memcpy(&pu8Buf[0], &u32Lsn, 4);
+    memcpy(&pu8Buf[4], &u32Ver, 4);
+}
+
+static uint32_t Matches(const uint8_t *pu8Buf, uint32_t u32Lsn, uint32_t u32Ver)
+{
+    uint8_t au8Exp[SPIM_FTL_SECTOR_SIZE];
+
+    if (u32Ver == 0)
+        memset(au8Exp, 0xFF, sizeof(au8Exp));
+    else
+        Fill(au8Exp, u32Lsn, u32Ver);
+
+    return (memcmp(pu8Buf, au8Exp, SPIM_FTL_SECTOR_SIZE) == 0) ? 1 : 0;
+}
+
+/* A new chip: erased and without any FTL on it */
+static void Wipe(void)
+{
+    memset(SIM_SPIM_GetArray(), 0xFF, SIM_SPIM_FLASH_SIZE);
+    memset(s_au32Ver, 0, sizeof(s_au32Ver));
+}
+
+/* Power up: engine and FTL from scratch, then mount */
+static int32_t Mount(uint32_t u32Base, uint32_t u32Blocks, uint32_t u32Spare, uint32_t u32WlThreshold)
+{
+    if ((SPIM_PrgInit(&s_psMem->sPrg, 0, CMD_NORMAL_PAGE_PROGRAM, CMD_DMA_FAST_READ, NULL) != SPIM_OK) ||
+            (SPIM_FtlInit(&s_psMem->sFtl, &s_psMem->sPrg, u32Base, u32Blocks, u32Spare) != SPIM_OK))
+        return SPIM_ERR_FAIL;
+
+    s_psMem->sPrg.pfnGetTime = GetTime;
+    s_psMem->sFtl.pfnIdle = Idle;
+    s_psMem->sFtl.u32WlThreshold = u32WlThreshold;
+
+    return SPIM_FtlMount(&s_psMem->sFtl);
+}
+
+static int32_t WriteVer(uint32_t u32Lsn, uint32_t u32Cnt)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Cnt; i++)
+        Fill(&s_psMem->au8Wr[i * SPIM_FTL_SECTOR_SIZE], u32Lsn + i, s_au32Ver[u32Lsn + i] + 1);
+
+    if (SPIM_FtlWrite(&s_psMem->sFtl, u32Lsn, s_psMem->au8Wr, u32Cnt) != SPIM_OK)
+        return SPIM_ERR_FAIL;
+
+    for (i = 0; i < u32Cnt; i++)
+        s_au32Ver[u32Lsn + i]++;
+
+    return SPIM_OK;
+}
+
+/* Read every sector back; returns the number that differ */
+static uint32_t VerifyAll(void)
+{
+    uint32_t u32Sectors = SPIM_FtlGetSectorCount(&s_psMem->sFtl);
+    uint32_t i, j, u32Cnt, u32Bad = 0;
+
+    for (i = 0; i < u32Sectors; i += u32Cnt)
+    {
+        u32Cnt = ((u32Sectors - i) < IO_SECTORS) ? (u32Sectors - i) : IO_SECTORS;
+
+        if (SPIM_FtlRead(&s_psMem->sFtl, i, s_psMem->au8Rd, u32Cnt) != SPIM_OK)
+            return u32Sectors;
+
+        for (j = 0; j < u32Cnt; j++)
+        {
+            if (!Matches(&s_psMem->au8Rd[j * SPIM_FTL_SECTOR_SIZE], i + j, s_au32Ver[i + j]))
+                u32Bad++;
+        }
+    }
+
+    return u32Bad;
+}
+
+static uint32_t Rate(uint32_t u32Cnt, uint32_t u32Ticks)
+{
+    return u32Ticks ? (uint32_t)(((uint64_t)u32Cnt * 1000000) / u32Ticks) : 0;
+}
+
+/* Write amplification x100: flash sector programs per host sector written */
+static uint32_t Waf(const SPIM_FTL_STAT_T *psStat)
+{
+    return psStat->u32HostWrites ? ((psStat->u32HostWrites + psStat->u32GcCopies) * 100) / psStat->u32HostWrites : 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void TestBlank(void)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    uint32_t u32Erases = SIM_SPIM_GetStat()->u32Erases;
+    uint32_t u32Start = SIM_SPIM_GetTicks();
+
+    printf("\n[1] Mount erased flash, %u blocks\n", BENCH_BLOCKS);
+    Wipe();
+
+    CHECK(SPIM_FtlInit(psFtl, &s_psMem->sPrg, 0x800, BENCH_BLOCKS, BENCH_SPARE) == SPIM_ERR_FAIL, "unaligned area accepted");
+    CHECK(SPIM_FtlInit(psFtl, &s_psMem->sPrg, 0, SPIM_FTL_MAX_BLOCKS + 1, BENCH_SPARE) == SPIM_ERR_FAIL, "too many blocks accepted");
+    CHECK(SPIM_FtlInit(psFtl, &s_psMem->sPrg, 0, BENCH_BLOCKS, SPIM_FTL_MIN_SPARE - 1) == SPIM_ERR_FAIL, "too few spare blocks accepted");
+    CHECK(SPIM_FtlRead(psFtl, 0, s_psMem->au8Rd, 1) == SPIM_ERR_FAIL, "read before mount");
+
+    CHECK(Mount(BENCH_BASE, BENCH_BLOCKS, BENCH_SPARE, SPIM_FTL_WL_THRESHOLD) == SPIM_OK, "mount");
+    CHECK(SPIM_FtlSync(psFtl) == SPIM_OK, "sync");
+    printf("    %u sectors, mounted in %u us\n", SPIM_FtlGetSectorCount(psFtl), SIM_SPIM_GetTicks() - u32Start);
+
+    CHECK(SPIM_FtlGetSectorCount(psFtl) == (BENCH_BLOCKS - BENCH_SPARE) * SPIM_FTL_SLOTS, "sector count");
+    CHECK(psFtl->u32FreeCnt == BENCH_BLOCKS, "%u free blocks", psFtl->u32FreeCnt);
+    CHECK(SIM_SPIM_GetStat()->u32Erases == u32Erases, "blank blocks erased");
+    CHECK(SPIM_FtlRead(psFtl, SPIM_FtlGetSectorCount(psFtl) - 1, s_psMem->au8Rd, 2) == SPIM_ERR_FAIL, "read past the end");
+    CHECK(SPIM_FtlWrite(psFtl, SPIM_FtlGetSectorCount(psFtl), s_psMem->au8Wr, 1) == SPIM_ERR_FAIL, "write past the end");
+    CHECK(VerifyAll() == 0, "unwritten sectors do not read as erased");
+}
+
+static void TestFill(void)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    uint32_t u32Sectors = SPIM_FtlGetSectorCount(psFtl);
+    uint32_t i, u32Cnt, u32Start, u32Ticks;
+
+    printf("\n[2] Sequential fill, remount\n");
+
+    u32Start = SIM_SPIM_GetTicks();
+    for (i = 0; i < u32Sectors; i += u32Cnt)
+    {
+        u32Cnt = ((u32Sectors - i) < IO_SECTORS) ? (u32Sectors - i) : IO_SECTORS;
+        if (WriteVer(i, u32Cnt) != SPIM_OK)
+        {
+            CHECK(0, "write %u", i);
+            return;
+        }
+    }
+    u32Ticks = SIM_SPIM_GetTicks() - u32Start;
+    printf("    %u sectors in %u ms: %u KB/s\n", u32Sectors, u32Ticks / 1000,
+           (uint32_t)(((uint64_t)u32Sectors * SPIM_FTL_SECTOR_SIZE * 1000) / u32Ticks));
+    CHECK(psFtl->sStat.u32GcCopies == 0, "garbage collection while filling");
+    CHECK(VerifyAll() == 0, "read back");
+
+    u32Start = SIM_SPIM_GetTicks();
+    CHECK(Mount(BENCH_BASE, BENCH_BLOCKS, BENCH_SPARE, SPIM_FTL_WL_THRESHOLD) == SPIM_OK, "remount");
+    printf("    Remounted in %u us\n", SIM_SPIM_GetTicks() - u32Start);
+    CHECK(VerifyAll() == 0, "read back after remount");
+}
+
+static void TestRandom(void)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    uint32_t u32Sectors = SPIM_FtlGetSectorCount(psFtl);
+    uint32_t i, u32Start, u32Ticks, u32Min, u32Max;
+
+    printf("\n[3] Random 512-byte overwrites of a full device, %u%% spare\n", (BENCH_SPARE * 100) / BENCH_BLOCKS);
+
+    SPIM_FtlClearStats(psFtl);
+    SPIM_PrgClearStats(&s_psMem->sPrg);
+
+    u32Start = SIM_SPIM_GetTicks();
+    for (i = 0; i < RANDOM_WRITES; i++)
+    {
+        if (WriteVer(Rand() % u32Sectors, 1) != SPIM_OK)
+        {
+            CHECK(0, "write %u", i);
+            return;
+        }
+    }
+    u32Ticks = SIM_SPIM_GetTicks() - u32Start;
+
+    SPIM_FtlGetWear(psFtl, &u32Min, &u32Max);
+    printf("    Writes: %u IOPS, write amplification %u.%02u, %u erases, %u GC runs, erase counts %u..%u\n",
+           Rate(RANDOM_WRITES, u32Ticks), Waf(&psFtl->sStat) / 100, Waf(&psFtl->sStat) % 100,
+           psFtl->sStat.u32Erases, psFtl->sStat.u32GcRuns, u32Min, u32Max);
+    CHECK(psFtl->sStat.u32GcRuns != 0, "no garbage collection");
+    CHECK(Waf(&psFtl->sStat) < 600, "write amplification");
+    CHECK(psFtl->sStat.u32Errors == 0, "%u flash errors", psFtl->sStat.u32Errors);
+
+    /* Reads right behind a write that queued an erase suspend it */
+    u32Start = SIM_SPIM_GetTicks();
+    for (i = 0; i < RANDOM_READS; i++)
+    {
+        if ((i % 8) == 0)
+            WriteVer(Rand() % u32Sectors, 1);
+
+        if (SPIM_FtlRead(psFtl, Rand() % u32Sectors, s_psMem->au8Rd, 1) != SPIM_OK)
+        {
+            CHECK(0, "read %u", i);
+            return;
+        }
+    }
+    u32Ticks = SIM_SPIM_GetTicks() - u32Start;
+    printf("    Reads, 1 write per 8: %u IOPS, %u erase suspends, read latency up to %u us\n",
+           Rate(RANDOM_READS + RANDOM_READS / 8, u32Ticks), s_psMem->sPrg.sStat.u32Suspends,
+           s_psMem->sPrg.sStat.u32MaxReadLatency);
+    CHECK(s_psMem->sPrg.sStat.u32Suspends != 0, "no read suspended an erase");
+    CHECK(s_psMem->sPrg.sStat.u32MaxReadLatency < 1000, "read latency");
+
+    u32Start = SIM_SPIM_GetTicks();
+    CHECK(SPIM_FtlSync(psFtl) == SPIM_OK, "sync");
+    for (i = 0; i < RANDOM_READS; i++)
+        SPIM_FtlRead(psFtl, Rand() % u32Sectors, s_psMem->au8Rd, 1);
+    u32Ticks = SIM_SPIM_GetTicks() - u32Start;
+    printf("    Reads only: %u IOPS\n", Rate(RANDOM_READS, u32Ticks));
+
+    CHECK(VerifyAll() == 0, "read back");
+    CHECK(Mount(BENCH_BASE, BENCH_BLOCKS, BENCH_SPARE, SPIM_FTL_WL_THRESHOLD) == SPIM_OK, "remount");
+    CHECK(VerifyAll() == 0, "read back after remount");
+}
+
+/* Fill the area with cold data, then keep rewriting a few hot sectors */
+static uint32_t RunWear(uint32_t u32WlThreshold, uint32_t *pu32Moves)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    uint32_t i, u32Cnt, u32Sectors, u32Min, u32Max;
+
+    Wipe();
+    if (Mount(WEAR_BASE, WEAR_BLOCKS, WEAR_SPARE, u32WlThreshold) != SPIM_OK)
+        return 0;
+
+    u32Sectors = SPIM_FtlGetSectorCount(psFtl);
+    for (i = 0; i < u32Sectors; i += u32Cnt)
+    {
+        u32Cnt = ((u32Sectors - i) < IO_SECTORS) ? (u32Sectors - i) : IO_SECTORS;
+        WriteVer(i, u32Cnt);
+    }
+
+    for (i = 0; i < HOT_WRITES; i++)
+        WriteVer(Rand() % HOT_SECTORS, 1);
+
+    CHECK(VerifyAll() == 0, "read back, threshold %u", u32WlThreshold);
+    CHECK(SIM_SPIM_GetStat()->u32Erases != 0, "no erase");
+
+    SPIM_FtlGetWear(psFtl, &u32Min, &u32Max);
+    printf("    Threshold %2u: erase counts %u..%u, %u blocks moved, write amplification %u.%02u\n",
+           u32WlThreshold, u32Min, u32Max, psFtl->sStat.u32WlMoves, Waf(&psFtl->sStat) / 100, Waf(&psFtl->sStat) % 100);
+    *pu32Moves = psFtl->sStat.u32WlMoves;
+
+    return u32Max - u32Min;
+}
+
+static void TestWear(void)
+{
+    uint32_t u32SpreadOff, u32SpreadOn, u32Moves;
+
+    printf("\n[4] Static wear leveling, %u hot sectors in %u blocks\n", HOT_SECTORS, WEAR_BLOCKS);
+
+    u32SpreadOff = RunWear(0, &u32Moves);
+    CHECK(u32Moves == 0, "blocks moved with wear leveling off");
+    u32SpreadOn = RunWear(WL_THRESHOLD, &u32Moves);
+    CHECK(u32Moves != 0, "no block moved");
+    CHECK(u32SpreadOn <= WL_THRESHOLD + 1, "erase count spread %u over threshold", u32SpreadOn);
+    CHECK(u32SpreadOff > u32SpreadOn * 4, "wear leveling off spreads only %u", u32SpreadOff);
+}
+
+static void TestPowerCut(void)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    uint32_t au32New[4];
+    uint32_t i, j, u32Lsn, u32Cnt, u32Sectors, u32Bad = 0, u32Lost = 0, u32Torn = 0;
+    uint32_t u32Erases = SIM_SPIM_GetStat()->u32Erases;
+
+    printf("\n[5] %u power failures during writes, garbage collection and erases\n", POWER_CUTS);
+
+    Wipe();
+    CHECK(Mount(CUT_BASE, CUT_BLOCKS, CUT_SPARE, WL_THRESHOLD) == SPIM_OK, "mount");
+    u32Sectors = SPIM_FtlGetSectorCount(psFtl);
+
+    for (i = 0; i < u32Sectors; i++)
+        WriteVer(i, 1);
+
+    for (i = 0; i < POWER_CUTS; i++)
+    {
+        SIM_SPIM_PowerCut(1 + Rand() % 24);
+
+        /* Writes that return while the power is on are committed */
+        do
+        {
+            u32Cnt = 1 + Rand() % 3;
+            u32Lsn = Rand() % (u32Sectors - u32Cnt + 1);
+            for (j = 0; j < u32Cnt; j++)
+                Fill(&s_psMem->au8Wr[j * SPIM_FTL_SECTOR_SIZE], u32Lsn + j, au32New[j] = s_au32Ver[u32Lsn + j] + 1);
+
+            if ((SPIM_FtlWrite(psFtl, u32Lsn, s_psMem->au8Wr, u32Cnt) == SPIM_OK) && !SIM_SPIM_IsPowerOff())
+            {
+                for (j = 0; j < u32Cnt; j++)
+                    s_au32Ver[u32Lsn + j] = au32New[j];
+            }
+        }
+        while (!SIM_SPIM_IsPowerOff());
+
+        SIM_SPIM_PowerOn();
+        if (Mount(CUT_BASE, CUT_BLOCKS, CUT_SPARE, WL_THRESHOLD) != SPIM_OK)
+        {
+            CHECK(0, "mount after power failure %u", i);
+            return;
+        }
+
+        /* The write cut short reads back old or new, sector by sector */
+        for (j = 0; j < u32Cnt; j++)
+        {
+            SPIM_FtlRead(psFtl, u32Lsn + j, s_psMem->au8Rd, 1);
+            if (Matches(s_psMem->au8Rd, u32Lsn + j, au32New[j]))
+            {
+                s_au32Ver[u32Lsn + j] = au32New[j];
+                u32Torn++;
+            }
+            else if (!Matches(s_psMem->au8Rd, u32Lsn + j, s_au32Ver[u32Lsn + j]))
+            {
+                u32Lost++;
+            }
+        }
+
+        u32Bad += VerifyAll();
+    }
+
+    printf("    %u sectors of interrupted writes kept, %u erases\n", u32Torn, SIM_SPIM_GetStat()->u32Erases - u32Erases);
+    CHECK(u32Lost == 0, "%u sectors of interrupted writes neither old nor new", u32Lost);
+    CHECK(u32Bad == 0, "%u committed sectors lost", u32Bad);
+}
+
+/* FatFs has no mkfs in this configuration: lay out a FAT12 volume by hand */
+static int32_t Format(uint32_t u32Sectors)
+{
+    uint8_t *pu8Sec = s_psMem->au8Wr;
+    uint32_t u32FatSz = ((u32Sectors + 2) * 3 / 2 + SPIM_FTL_SECTOR_SIZE - 1) / SPIM_FTL_SECTOR_SIZE;
+    uint32_t i;
+
+    memset(pu8Sec, 0, SPIM_FTL_SECTOR_SIZE);
+    memcpy(&pu8Sec[0], "\xEB\x3C\x90" "MSDOS5.0", 11);
+    pu8Sec[11] = 0x00;  pu8Sec[12] = 0x02;                  /* 512 bytes per sector */
+    pu8Sec[13] = 1;                                         /* 1 sector per cluster */
+    pu8Sec[14] = 1;                                         /* 1 reserved sector */
+    pu8Sec[16] = 2;                                         /* 2 FATs */
+    pu8Sec[17] = 64;                                        /* 64 root directory entries */
+    pu8Sec[19] = (uint8_t)u32Sectors;  pu8Sec[20] = (uint8_t)(u32Sectors >> 8);
+    pu8Sec[21] = 0xF8;
+    pu8Sec[22] = (uint8_t)u32FatSz;
+    pu8Sec[24] = 63;  pu8Sec[26] = 255;
+    pu8Sec[36] = 0x80;  pu8Sec[38] = 0x29;
+    memcpy(&pu8Sec[43], "NO NAME    FAT12   ", 19);
+    pu8Sec[510] = 0x55;  pu8Sec[511] = 0xAA;
+    if (SPIM_FtlWrite(&s_psMem->sFtl, 0, pu8Sec, 1) != SPIM_OK)
+        return SPIM_ERR_FAIL;
+
+    /* Both FATs and the root directory; the data area may stay as the FTL reads it */
+    for (i = 1; i < 1 + 2 * u32FatSz + 4; i++)
+    {
+        memset(pu8Sec, 0, SPIM_FTL_SECTOR_SIZE);
+        if ((i == 1) || (i == 1 + u32FatSz))
+            memcpy(pu8Sec, "\xF8\xFF\xFF", 3);
+        if (SPIM_FtlWrite(&s_psMem->sFtl, i, pu8Sec, 1) != SPIM_OK)
+            return SPIM_ERR_FAIL;
+    }
+
+    return SPIM_OK;
+}
+
+static void Record(char *pcBuf, uint32_t u32Idx)
+{
+    sprintf(pcBuf, "%06u,%08X,sensor sample\n", u32Idx, u32Idx * 2654435761u);
+}
+
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2023 - 1980) << 25) | (1UL << 21) | (1UL << 16);
+}
+
+static void TestFatFs(void)
+{
+    SPIM_FTL_T *psFtl = &s_psMem->sFtl;
+    FIL *psFile = &s_psMem->sFile;
+    char acRec[40];
+    uint32_t i, u32Min, u32Max, u32Bad = 0;
+    UINT uLen;
+
+    printf("\n[6] FAT volume through diskio.c: log with f_sync(), file rewrite, remount\n");
+
+    Wipe();
+    g_psFtl = psFtl;
+    if ((Mount(0, FAT_BLOCKS, FAT_SPARE, SPIM_FTL_WL_THRESHOLD) != SPIM_OK) || (Format(SPIM_FtlGetSectorCount(psFtl)) != SPIM_OK))
+    {
+        CHECK(0, "format");
+        return;
+    }
+    SPIM_FtlClearStats(psFtl);
+
+    CHECK(f_mount(&s_psMem->sFs, "0:", 1) == FR_OK, "f_mount");
+
+    /* A data logger: short records, each one synced */
+    CHECK(f_open(psFile, "0:/LOG.CSV", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "f_open log");
+    for (i = 0; i < LOG_RECORDS; i++)
+    {
+        Record(acRec, i);
+        if ((f_write(psFile, acRec, strlen(acRec), &uLen) != FR_OK) || (uLen != strlen(acRec)) || (f_sync(psFile) != FR_OK))
+        {
+            CHECK(0, "log record %u", i);
+            break;
+        }
+    }
+    CHECK(f_close(psFile) == FR_OK, "f_close log");
+
+    /* A 64 KB image rewritten in the middle */
+    CHECK(f_open(psFile, "0:/IMAGE.BIN", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "f_open image");
+    for (i = 0; i < 16; i++)
+    {
+        memset(s_psMem->au8File, (int)i, FILE_BUF_SIZE);
+        CHECK((f_write(psFile, s_psMem->au8File, FILE_BUF_SIZE, &uLen) == FR_OK) && (uLen == FILE_BUF_SIZE), "write image");
+    }
+    memset(s_psMem->au8File, 0xA5, FILE_BUF_SIZE);
+    CHECK(f_lseek(psFile, 5 * FILE_BUF_SIZE + 100) == FR_OK, "f_lseek");
+    CHECK((f_write(psFile, s_psMem->au8File, 1000, &uLen) == FR_OK) && (uLen == 1000), "rewrite image");
+    CHECK(f_close(psFile) == FR_OK, "f_close image");
+    f_mount(NULL, "0:", 0);
+
+    SPIM_FtlGetWear(psFtl, &u32Min, &u32Max);
+    printf("    %u sectors written by FatFs, write amplification %u.%02u, %u erases, erase counts %u..%u\n",
+           psFtl->sStat.u32HostWrites, Waf(&psFtl->sStat) / 100, Waf(&psFtl->sStat) % 100, psFtl->sStat.u32Erases,
+           u32Min, u32Max);
+    /* Without remapping every f_sync() would erase the FAT and directory blocks in place */
+    CHECK(u32Max < LOG_RECORDS / 16, "FAT blocks worn");
+
+    /* Power cycle */
+    CHECK(Mount(0, FAT_BLOCKS, FAT_SPARE, SPIM_FTL_WL_THRESHOLD) == SPIM_OK, "remount");
+    CHECK(f_mount(&s_psMem->sFs, "0:", 1) == FR_OK, "f_mount after remount");
+
+    CHECK(f_open(psFile, "0:/LOG.CSV", FA_READ) == FR_OK, "reopen log");
+    for (i = 0; i < LOG_RECORDS; i++)
+    {
+        Record(acRec, i);
+        if ((f_read(psFile, s_psMem->au8File, strlen(acRec), &uLen) != FR_OK) || (uLen != strlen(acRec)) ||
+                (memcmp(s_psMem->au8File, acRec, uLen) != 0))
+            u32Bad++;
+    }
+    CHECK(f_size(psFile) == f_tell(psFile), "log size");
+    f_close(psFile);
+
+    CHECK(f_open(psFile, "0:/IMAGE.BIN", FA_READ) == FR_OK, "reopen image");
+    for (i = 0; i < 16 * FILE_BUF_SIZE; i++)
+    {
+        if ((i % FILE_BUF_SIZE) == 0)
+            f_read(psFile, s_psMem->au8File, FILE_BUF_SIZE, &uLen);
+
+        if (s_psMem->au8File[i % FILE_BUF_SIZE] != (((i >= 5 * FILE_BUF_SIZE + 100) && (i < 5 * FILE_BUF_SIZE + 1100)) ? 0xA5 : i / FILE_BUF_SIZE))
+            u32Bad++;
+    }
+    f_close(psFile);
+    f_mount(NULL, "0:", 0);
+
+    CHECK(u32Bad == 0, "%u records/bytes differ after remount", u32Bad);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_SPIM_Init() != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    const SIM_SPIM_STAT_T *psSim;
+
+    if (HOSTSIM_TestBegin("SPIM flash translation layer", SimInit) != 0)
+        return 1;
+
+    if (SPIM_InitFlash(1) != 0)
+    {
+        printf("Init failed\n");
+        return 1;
+    }
+
+    TestBlank();
+    TestFill();
+    TestRandom();
+    TestWear();
+    TestPowerCut();
+    TestFatFs();
+
+    psSim = SIM_SPIM_GetStat();
+    printf("\nFlash: %u page writes, %u erases, %u suspends, %u reads\n",
+           psSim->u32PageWrites, psSim->u32Erases, psSim->u32Suspends, psSim->u32Reads);
+    CHECK(psSim->u32BusyReads == 0, "%u reads of busy or suspended areas", psSim->u32BusyReads);
+    CHECK(psSim->u32Rejected == 0, "%u commands ignored by the flash", psSim->u32Rejected);
+
+    return HOSTSIM_TestEnd();
+}
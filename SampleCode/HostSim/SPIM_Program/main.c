@@ -0,0 +1,442 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the SPIM programming engine
+ *           (SPIM_PrgInit() ... SPIM_PrgGetThroughput()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c ../common/sim_spim.c
+ *               ../../../Library/StdDriver/src/spim.c ../../../Library/StdDriver/src/pdma.c
+ *               -o spim_program
+ *           ./spim_program
+ *
+ *           The SPIM model of ../common/sim_spim.c carries a W25Q16-like NOR
+ *           flash with typical page program and erase times, one tick per
+ *           microsecond. The engine is polled every few ticks, as a timer
+ *           would. Checked are multi-page programs against the blocking
+ *           SPIM_DMA_Write(), staging of the next page during the page write
+ *           and erase, reads suspending a long erase, the resume hold time,
+ *           reads between page writes, CPU staging, queue order with an
+ *           operation queued from a callback, timeout and parameter errors.
+ *           The flash model counts every command it had to ignore; none may
+ *           occur.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+#include "sim_spim.h"
+
+#define POOL_SIZE           16
+#define OP_CNT              16
+#define SRC_SIZE            (16 * 1024)
+#define RD_SIZE             1024
+#define RD_CNT              8
+#define SRAM_SIM_SIZE       0x20000ul
+#define POLL_STEP           25              /* Ticks between two SPIM_PrgPoll() calls */
+
+/* Everything PDMA and SPIM DMA touch lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    PDMA_COPY_T sCopy;
+    SPIM_PRG_T sPrg;
+    SPIM_PRG_OP_T asOp[OP_CNT];
+    uint8_t au8Src[SRC_SIZE];
+    uint8_t au8Rd[RD_CNT][RD_SIZE];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+
+/* Callback log */
+static uint32_t s_u32Done;
+static uint32_t s_au32Order[32];
+static int32_t s_ai32Status[32];
+
+static uint32_t GetTime(void)
+{
+    return SIM_SPIM_GetTicks();
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_SPIM_Init() != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+static void Done(SPIM_PRG_OP_T *psOp, int32_t i32Status)
+{
+    if (s_u32Done < 32)
+    {
+        s_au32Order[s_u32Done] = (uint32_t)(uintptr_t)psOp->pvArg;
+        s_ai32Status[s_u32Done] = i32Status;
+    }
+    s_u32Done++;
+}
+
+static void ClearLog(void)
+{
+    s_u32Done = 0;
+    memset(s_au32Order, 0, sizeof(s_au32Order));
+    memset(s_ai32Status, 0, sizeof(s_ai32Status));
+}
+
+/* Poll as a timer would until the engine is idle; returns the ticks it took */
+static uint32_t RunIdle(uint32_t u32Max)
+{
+    uint32_t u32Start = SIM_SPIM_GetTicks();
+
+    while (SPIM_PrgPoll(&s_psMem->sPrg) && ((SIM_SPIM_GetTicks() - u32Start) < u32Max))
+    {
+        SIM_PDMA_RunMem();
+        SIM_SPIM_Run(POLL_STEP);
+    }
+
+    return SIM_SPIM_GetTicks() - u32Start;
+}
+
+static void RunTicks(uint32_t u32Ticks)
+{
+    uint32_t u32Start = SIM_SPIM_GetTicks();
+
+    while ((SIM_SPIM_GetTicks() - u32Start) < u32Ticks)
+    {
+        SPIM_PrgPoll(&s_psMem->sPrg);
+        SIM_PDMA_RunMem();
+        SIM_SPIM_Run(POLL_STEP);
+    }
+}
+
+static uint32_t IsErased(uint32_t u32Addr, uint32_t u32Len)
+{
+    const uint8_t *pu8Array = SIM_SPIM_GetArray();
+
+    while (u32Len--)
+    {
+        if (pu8Array[u32Addr++] != 0xFF)
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint32_t KBps(uint32_t u32Bytes, uint32_t u32Ticks)
+{
+    return u32Ticks ? (uint32_t)(((uint64_t)u32Bytes * 1000) / u32Ticks) : 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t s_u32SyncRate;
+
+static void TestSync(void)
+{
+    uint32_t u32Start, u32Ticks;
+
+    printf("\n[1] Blocking SPIM_EraseBlock() + SPIM_DMA_Write(), 4 KB\n");
+    SPIM_EraseBlock(0, 0, OPCODE_SE_4K, 1, 1);
+    CHECK(IsErased(0, 0x1000), "sector not erased");
+
+    u32Start = SIM_SPIM_GetTicks();
+    SPIM_DMA_Write(0, 0, 4096, s_psMem->au8Src, CMD_NORMAL_PAGE_PROGRAM);
+    u32Ticks = SIM_SPIM_GetTicks() - u32Start;
+    s_u32SyncRate = KBps(4096, u32Ticks);
+
+    printf("  %u ticks, %u KB/s, CPU blocked throughout\n", u32Ticks, s_u32SyncRate);
+    CHECK(memcmp(SIM_SPIM_GetArray(), s_psMem->au8Src, 4096) == 0, "data");
+}
+
+static void TestProgram(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    uint32_t u32Ticks, u32Rate;
+
+    printf("\n[2] Queued 64 KB erase + 5000 bytes at an odd address, PDMA staging\n");
+    ClearLog();
+    SPIM_PrgClearStats(psPrg);
+
+    CHECK(SPIM_PrgErase(psPrg, &s_psMem->asOp[0], 0x10000, OPCODE_BE_64K, Done, (void *)1) == SPIM_OK, "erase");
+    CHECK(SPIM_PrgProgram(psPrg, &s_psMem->asOp[1], 0x10025, s_psMem->au8Src, 5000, Done, (void *)2) == SPIM_OK, "program");
+    CHECK(s_psMem->asOp[1].i32Status == SPIM_PRG_PENDING, "status not pending");
+
+    u32Ticks = RunIdle(1000000);
+    u32Rate = SPIM_PrgGetThroughput(psPrg);
+
+    printf("  %u ticks: erase %u, %u pages in %u ticks = %u KB/s, stalls %u\n", u32Ticks, psPrg->sStat.u32EraseTime,
+           psPrg->sStat.u32Pages, psPrg->sStat.u32ProgTime, u32Rate, psPrg->sStat.u32StageStalls);
+
+    CHECK((s_u32Done == 2) && (s_au32Order[0] == 1) && (s_au32Order[1] == 2), "callbacks %u", s_u32Done);
+    CHECK((s_ai32Status[0] == SPIM_OK) && (s_ai32Status[1] == SPIM_OK), "status %d %d", s_ai32Status[0], s_ai32Status[1]);
+    CHECK(memcmp(SIM_SPIM_GetArray() + 0x10025, s_psMem->au8Src, 5000) == 0, "data");
+    CHECK(IsErased(0x10000, 0x25) && IsErased(0x10025 + 5000, 0x10000 - 0x25 - 5000), "outside the program");
+    CHECK(psPrg->sStat.u32Pages == 20, "%u pages, expected 20", psPrg->sStat.u32Pages);
+    CHECK(psPrg->sStat.u32StageStalls == 0, "first page not staged during the erase");
+    CHECK(psPrg->sStat.u32EraseTime >= SIM_SPIM_T_BE64, "erase time %u", psPrg->sStat.u32EraseTime);
+    /* Up to a poll step is lost per page */
+    CHECK(u32Rate * 100 >= s_u32SyncRate * 90, "throughput %u below blocking %u", u32Rate, s_u32SyncRate);
+    CHECK(psPrg->sStat.u32ProgBytes == 5000, "bytes %u", psPrg->sStat.u32ProgBytes);
+}
+
+static void TestSuspend(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    const SIM_SPIM_STAT_T *psSim = SIM_SPIM_GetStat();
+    uint32_t u32Susp = psSim->u32Suspends, u32Start, u32Latency;
+
+    printf("\n[3] Read during a 64 KB erase\n");
+    ClearLog();
+    SPIM_PrgClearStats(psPrg);
+    memset(s_psMem->au8Rd[0], 0, RD_SIZE);
+
+    SPIM_PrgErase(psPrg, &s_psMem->asOp[0], 0x20000, OPCODE_BE_64K, Done, (void *)1);
+    RunTicks(10000);
+    CHECK((s_u32Done == 0) && SIM_SPIM_IsBusy(), "erase not running");
+
+    u32Start = SIM_SPIM_GetTicks();
+    SPIM_PrgRead(psPrg, &s_psMem->asOp[1], 0x10025, s_psMem->au8Rd[0], RD_SIZE, Done, (void *)2);
+    while ((s_psMem->asOp[1].i32Status == SPIM_PRG_PENDING) && ((SIM_SPIM_GetTicks() - u32Start) < 200000))
+        RunTicks(POLL_STEP);
+    u32Latency = SIM_SPIM_GetTicks() - u32Start;
+
+    printf("  read done after %u ticks with the erase %s\n", u32Latency, SIM_SPIM_IsBusy() ? "suspended" : "finished");
+    CHECK((s_u32Done == 1) && (s_au32Order[0] == 2) && (s_ai32Status[0] == SPIM_OK), "read not first");
+    CHECK(u32Latency < 500, "read latency %u", u32Latency);
+    CHECK(memcmp(s_psMem->au8Rd[0], s_psMem->au8Src, RD_SIZE) == 0, "read data");
+    CHECK((psPrg->sStat.u32Suspends == 1) && (psSim->u32Suspends == u32Susp + 1), "suspends %u", psPrg->sStat.u32Suspends);
+
+    RunIdle(1000000);
+    printf("  erase done: %u ticks erasing, %u suspend(s), latency %u\n", psPrg->sStat.u32EraseTime,
+           psPrg->sStat.u32Suspends, psPrg->sStat.u32MaxReadLatency);
+    CHECK((s_u32Done == 2) && (s_ai32Status[1] == SPIM_OK), "erase callback");
+    CHECK(IsErased(0x20000, 0x10000), "block not erased");
+    CHECK((psPrg->sStat.u32EraseTime >= SIM_SPIM_T_BE64) && (psPrg->sStat.u32EraseTime < SIM_SPIM_T_BE64 + 200),
+          "erase time %u", psPrg->sStat.u32EraseTime);
+}
+
+static void TestHold(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    uint32_t u32Reads = 0, u32Start = SIM_SPIM_GetTicks();
+
+    printf("\n[4] A read every 500 ticks during a 4 KB erase, 5000 ticks resume hold\n");
+    ClearLog();
+    SPIM_PrgClearStats(psPrg);
+    psPrg->u32ResumeHold = 5000;
+
+    SPIM_PrgErase(psPrg, &s_psMem->asOp[0], 0x30000, OPCODE_SE_4K, Done, (void *)1);
+
+    while ((s_psMem->asOp[0].i32Status == SPIM_PRG_PENDING) && ((SIM_SPIM_GetTicks() - u32Start) < 1000000))
+    {
+        if (s_psMem->asOp[1 + (u32Reads % 4)].i32Status != SPIM_PRG_PENDING)
+        {
+            SPIM_PrgRead(psPrg, &s_psMem->asOp[1 + (u32Reads % 4)], 0x10025 + 64 * (u32Reads % 4),
+                         s_psMem->au8Rd[u32Reads % 4], 64, NULL, NULL);
+            u32Reads++;
+        }
+        RunTicks(500);
+    }
+    RunIdle(100000);
+
+    printf("  %u reads, %u suspends, max latency %u, erase %u ticks\n", psPrg->sStat.u32Reads,
+           psPrg->sStat.u32Suspends, psPrg->sStat.u32MaxReadLatency, SIM_SPIM_GetTicks() - u32Start);
+    CHECK(s_psMem->asOp[0].i32Status == SPIM_OK, "erase status %d", s_psMem->asOp[0].i32Status);
+    CHECK(IsErased(0x30000, 0x1000), "sector not erased");
+    CHECK(psPrg->sStat.u32Reads == u32Reads, "reads %u of %u", psPrg->sStat.u32Reads, u32Reads);
+    CHECK((psPrg->sStat.u32Suspends >= 5) && (psPrg->sStat.u32Suspends <= SIM_SPIM_T_SE / 5000 + 1),
+          "suspends %u", psPrg->sStat.u32Suspends);
+    CHECK(psPrg->sStat.u32MaxReadLatency <= 5000 + 100, "latency %u", psPrg->sStat.u32MaxReadLatency);
+    CHECK(memcmp(s_psMem->au8Rd[3], s_psMem->au8Src + 192, 64) == 0, "read data");
+
+    psPrg->u32ResumeHold = 0;
+}
+
+static void TestReadBetweenPages(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    uint32_t u32Start;
+
+    printf("\n[5] Read while a 16 KB program runs\n");
+    ClearLog();
+    SPIM_PrgClearStats(psPrg);
+    memset(s_psMem->au8Rd[0], 0, RD_SIZE);
+
+    SPIM_PrgProgram(psPrg, &s_psMem->asOp[0], 0x40000, s_psMem->au8Src, SRC_SIZE, Done, (void *)1);
+    RunTicks(20000);
+    u32Start = SIM_SPIM_GetTicks();
+    SPIM_PrgRead(psPrg, &s_psMem->asOp[1], 0x10025, s_psMem->au8Rd[0], RD_SIZE, Done, (void *)2);
+    RunIdle(1000000);
+
+    printf("  read latency %u, %u pages at %u KB/s, stalls %u\n", psPrg->sStat.u32MaxReadLatency, psPrg->sStat.u32Pages,
+           SPIM_PrgGetThroughput(psPrg), psPrg->sStat.u32StageStalls);
+    CHECK((s_u32Done == 2) && (s_au32Order[0] == 2) && (s_au32Order[1] == 1), "order %u %u", s_au32Order[0], s_au32Order[1]);
+    CHECK(psPrg->sStat.u32MaxReadLatency <= SIM_SPIM_T_PP + 200, "read latency %u", psPrg->sStat.u32MaxReadLatency);
+    CHECK(memcmp(s_psMem->au8Rd[0], s_psMem->au8Src, RD_SIZE) == 0, "read data");
+    CHECK(memcmp(SIM_SPIM_GetArray() + 0x40000, s_psMem->au8Src, SRC_SIZE) == 0, "program data");
+    CHECK(psPrg->sStat.u32Pages == SRC_SIZE / 256, "pages %u", psPrg->sStat.u32Pages);
+    CHECK(psPrg->sStat.u32StageStalls <= 1, "stalls %u", psPrg->sStat.u32StageStalls);
+    CHECK(u32Start != 0, "time");
+}
+
+static void TestCpuStaging(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+
+    printf("\n[6] Staging by CPU\n");
+    ClearLog();
+    CHECK(SPIM_PrgInit(psPrg, 0, CMD_NORMAL_PAGE_PROGRAM, CMD_DMA_FAST_READ, NULL) == SPIM_OK, "init");
+    psPrg->pfnGetTime = GetTime;
+
+    SPIM_PrgProgram(psPrg, &s_psMem->asOp[0], 0x50010, s_psMem->au8Src + 7, 2000, Done, (void *)1);
+    RunIdle(100000);
+
+    printf("  %u pages at %u KB/s, stalls %u, copies on PDMA %u\n", psPrg->sStat.u32Pages, SPIM_PrgGetThroughput(psPrg),
+           psPrg->sStat.u32StageStalls, s_psMem->sCopy.u32DmaOps);
+    CHECK((s_u32Done == 1) && (s_ai32Status[0] == SPIM_OK), "callback");
+    CHECK(memcmp(SIM_SPIM_GetArray() + 0x50010, s_psMem->au8Src + 7, 2000) == 0, "data");
+    CHECK(psPrg->sStat.u32Pages == 8, "pages %u", psPrg->sStat.u32Pages);
+    CHECK(psPrg->sStat.u32StageStalls == 1, "stalls %u", psPrg->sStat.u32StageStalls);
+
+    SPIM_PrgInit(psPrg, 0, CMD_NORMAL_PAGE_PROGRAM, CMD_DMA_FAST_READ, &s_psMem->sCopy);
+    psPrg->pfnGetTime = GetTime;
+}
+
+/* Queues a read of what the first program wrote, from its callback */
+static void ProgDone(SPIM_PRG_OP_T *psOp, int32_t i32Status)
+{
+    Done(psOp, i32Status);
+    SPIM_PrgRead(&s_psMem->sPrg, &s_psMem->asOp[4], 0x60000, s_psMem->au8Rd[1], 300, Done, (void *)5);
+    CHECK(SPIM_PrgPoll(&s_psMem->sPrg) == 1, "nested poll");
+}
+
+static void TestOrder(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    static const uint32_t au32Expect[5] = { 1, 2, 5, 3, 4 };
+    uint32_t i;
+
+    printf("\n[7] Queue order, read queued from a callback\n");
+    ClearLog();
+
+    SPIM_PrgErase(psPrg, &s_psMem->asOp[0], 0x60000, OPCODE_SE_4K, Done, (void *)1);
+    SPIM_PrgProgram(psPrg, &s_psMem->asOp[1], 0x60000, s_psMem->au8Src + 1000, 300, ProgDone, (void *)2);
+    SPIM_PrgErase(psPrg, &s_psMem->asOp[2], 0x61000, OPCODE_SE_4K, Done, (void *)3);
+    SPIM_PrgProgram(psPrg, &s_psMem->asOp[3], 0x61000, s_psMem->au8Src + 2000, 300, Done, (void *)4);
+    RunIdle(1000000);
+
+    printf("  completion order:");
+    for (i = 0; i < s_u32Done; i++)
+        printf(" %u", s_au32Order[i]);
+    printf("\n");
+
+    CHECK(s_u32Done == 5, "%u callbacks", s_u32Done);
+    for (i = 0; i < 5; i++)
+        CHECK((s_au32Order[i] == au32Expect[i]) && (s_ai32Status[i] == SPIM_OK), "callback %u: %u", i, s_au32Order[i]);
+
+    CHECK(memcmp(s_psMem->au8Rd[1], s_psMem->au8Src + 1000, 300) == 0, "read data");
+    CHECK(memcmp(SIM_SPIM_GetArray() + 0x61000, s_psMem->au8Src + 2000, 300) == 0, "second program data");
+}
+
+static void TestTimeout(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    uint32_t u32Ticks;
+
+    printf("\n[8] Erase timeout\n");
+    ClearLog();
+    SPIM_PrgClearStats(psPrg);
+    psPrg->u32Timeout = 1000;
+
+    SPIM_PrgErase(psPrg, &s_psMem->asOp[0], 0x70000, OPCODE_SE_4K, Done, (void *)1);
+    u32Ticks = RunIdle(100000);
+
+    printf("  status %d after %u ticks, errors %u\n", s_ai32Status[0], u32Ticks, psPrg->sStat.u32Errors);
+    CHECK(u32Ticks < SIM_SPIM_T_SE, "waited for the erase");
+    CHECK((s_u32Done == 1) && (s_ai32Status[0] == SPIM_ERR_TIMEOUT), "status %d", s_ai32Status[0]);
+    CHECK((psPrg->sStat.u32Errors == 1) && (psPrg->sStat.u32Erases == 0), "errors %u", psPrg->sStat.u32Errors);
+
+    /* The flash finishes on its own */
+    while (SIM_SPIM_IsBusy())
+        SIM_SPIM_Run(100);
+    psPrg->u32Timeout = 0;
+}
+
+static void TestParam(void)
+{
+    SPIM_PRG_T *psPrg = &s_psMem->sPrg;
+    SPIM_PRG_OP_T *psOp = &s_psMem->asOp[0];
+
+    printf("\n[9] Parameter errors\n");
+    CHECK(SPIM_PrgErase(psPrg, psOp, 0, OPCODE_CHIP_ERASE, NULL, NULL) == SPIM_ERR_FAIL, "chip erase accepted");
+    CHECK(SPIM_PrgProgram(psPrg, psOp, 0, s_psMem->au8Src, 0, NULL, NULL) == SPIM_ERR_FAIL, "empty program");
+    CHECK(SPIM_PrgProgram(psPrg, psOp, 0, NULL, 16, NULL, NULL) == SPIM_ERR_FAIL, "program without data");
+    CHECK(SPIM_PrgRead(psPrg, psOp, 0, NULL, 16, NULL, NULL) == SPIM_ERR_FAIL, "read without buffer");
+    CHECK(SPIM_PrgRead(psPrg, psOp, 0, s_psMem->au8Rd[0], 0x1000000, NULL, NULL) == SPIM_ERR_FAIL, "read over DMACNT");
+    CHECK(SPIM_PrgPoll(psPrg) == 0, "engine not idle");
+}
+
+int main(void)
+{
+    const SIM_SPIM_STAT_T *psSim;
+    uint32_t i;
+
+    if (HOSTSIM_TestBegin("SPIM programming engine", SimInit) != 0)
+        return 1;
+
+    for (i = 0; i < SRC_SIZE; i++)
+        s_psMem->au8Src[i] = (uint8_t)(i * 29 + (i >> 8) + 3);
+
+    if ((SPIM_InitFlash(1) != 0) ||
+            (PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, GetTime) != 0) ||
+            (PDMA_CopyInit(&s_psMem->sCopy, &s_sSvc, PDMA_COPY_THRESHOLD) != 0))
+    {
+        printf("Init failed\n");
+        return 1;
+    }
+
+    CHECK(SPIM_PrgInit(&s_psMem->sPrg, 0, CMD_QUAD_PAGE_PROGRAM_EON, CMD_DMA_FAST_READ, NULL) == SPIM_ERR_FAIL, "EON quad accepted");
+    CHECK(SPIM_PrgInit(&s_psMem->sPrg, 0, CMD_NORMAL_PAGE_PROGRAM, CMD_DMA_FAST_READ, &s_psMem->sCopy) == SPIM_OK, "init");
+    s_psMem->sPrg.pfnGetTime = GetTime;
+
+    TestSync();
+    TestProgram();
+    TestSuspend();
+    TestHold();
+    TestReadBetweenPages();
+    TestCpuStaging();
+    TestOrder();
+    TestTimeout();
+    TestParam();
+
+    psSim = SIM_SPIM_GetStat();
+    printf("\nFlash: %u page writes, %u erases, %u suspends, %u resumes, %u reads, %u status reads\n",
+           psSim->u32PageWrites, psSim->u32Erases, psSim->u32Suspends, psSim->u32Resumes, psSim->u32Reads,
+           psSim->u32StatusReads);
+    CHECK(psSim->u32Suspends == psSim->u32Resumes, "suspended erase left behind");
+    CHECK(psSim->u32BusyReads == 0, "%u reads of busy or suspended areas", psSim->u32BusyReads);
+    CHECK(psSim->u32Rejected == 0, "%u commands ignored by the flash", psSim->u32Rejected);
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,594 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the queued SPI/QSPI transaction engine
+ *           (SPI_BusOpen() ... SPI_BusGetLoad()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c ../common/sim_spi.c
+ *               ../../../Library/StdDriver/src/spi.c ../../../Library/StdDriver/src/qspi.c
+ *               ../../../Library/StdDriver/src/pdma.c
+ *               -o spi_queue
+ *           ./spi_queue
+ *
+ *           The QSPI0/SPI0 model of ../common/sim_spi.c shifts one byte per
+ *           byte time through the devices below, and the PDMA0 model of
+ *           ../common/sim_pdma.c serves their requests through the channel
+ *           service. SPI0 carries a display (SS pin, mode 0, 24 MHz) and a
+ *           sensor (PB3, mode 3, 1 MHz); QSPI0 carries a quad NOR flash.
+ *           Every shifted byte is checked for exactly one active chip select
+ *           and the mode, clock and line mode of the selected device. Checked
+ *           are interleaved queues, KEEP_CS, quad read and program, parameter
+ *           errors, a target abort in the middle of a queue, resubmission
+ *           from the callback and the bus statistics.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+#include "sim_spi.h"
+
+#define POOL_SIZE           32
+#define FRAME_LEN           256
+#define SENS_LEN            6
+#define BIG_LEN             70000           /* Two PDMA segments */
+#define PROG_LEN            256
+#define FLASH_SIZE          0x20000ul
+#define SRAM_SIM_SIZE       0x20000ul
+#define GPIO_PAGE           0x40004000ul
+#define BAD_ADDR            0x60000000ul    /* Not in the simulated SRAM: target abort */
+#define MODE_MSK            (SPI_CTL_CLKPOL_Msk | SPI_CTL_TXNEG_Msk | SPI_CTL_RXNEG_Msk)
+#define LINE_MSK            (QSPI_CTL_DUALIOEN_Msk | QSPI_CTL_QUADIOEN_Msk | QSPI_CTL_DATDIR_Msk)
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    SPI_BUS_T sSpiBus;
+    SPI_BUS_T sQspiBus;
+    SPI_TXN_T asTxn[8];
+    uint8_t au8Frame[FRAME_LEN];
+    uint8_t au8Sens[8][SENS_LEN];
+    uint8_t au8Prog[PROG_LEN];
+    uint8_t au8Big[BIG_LEN];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+static SPI_DEV_T s_sDisp, s_sSens, s_sFlash;
+
+/* Device side, written from the model */
+static uint8_t s_au8DispLog[4096];
+static uint32_t s_u32DispCnt;
+static uint32_t s_u32SensPtr;
+static uint8_t s_au8Flash[FLASH_SIZE];
+static uint32_t s_u32FlashSel, s_u32FlashPos, s_u32FlashCmd, s_u32FlashAddr;
+static uint32_t s_u32CsClash, s_u32NoCs, s_u32BadMode, s_u32BadLines;
+
+/* Callback log */
+static uint32_t s_u32Done;
+static int32_t s_ai32Status[16];
+static void *s_apvArg[16];
+static uint32_t s_u32Resubmit;
+
+/* Referenced by the bus clock code of spi.c and qspi.c: PCLK0/PCLK1 at 96 MHz */
+uint32_t CLK_GetHCLKFreq(void)
+{
+    return 192000000;
+}
+
+uint32_t CLK_GetPCLK0Freq(void)
+{
+    return 96000000;
+}
+
+uint32_t CLK_GetPCLK1Freq(void)
+{
+    return 96000000;
+}
+
+uint32_t CLK_GetPLLClockFreq(void)
+{
+    return 192000000;
+}
+
+uint32_t CLK_GetPLLFNClockFreq(void)
+{
+    return 0;
+}
+
+static uint32_t GetTime(void)
+{
+    return SIM_PDMA_GetTicks();
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static uint8_t SensReg(uint32_t u32Reg)
+{
+    return (uint8_t)(u32Reg * 7 + 3);
+}
+
+static uint8_t SpiShift(uint32_t u32Ctl, uint32_t u32ClkDiv, uint32_t u32SSCtl, uint8_t u8Out)
+{
+    uint32_t u32Disp = (u32SSCtl & SPI_SSCTL_SS_Msk) != 0;
+    uint32_t u32Sens = (PB3 == 0);
+
+    if (u32Disp && u32Sens)
+        s_u32CsClash++;
+    else if (!u32Disp && !u32Sens)
+        s_u32NoCs++;
+
+    if (u32Disp)
+    {
+        if (((u32Ctl & MODE_MSK) != s_sDisp.u32Mode) || (u32ClkDiv != s_sDisp.u32ClkDiv))
+            s_u32BadMode++;
+
+        if (s_u32DispCnt < sizeof(s_au8DispLog))
+            s_au8DispLog[s_u32DispCnt++] = u8Out;
+
+        return 0x00;
+    }
+
+    if (u32Sens)
+    {
+        if (((u32Ctl & MODE_MSK) != s_sSens.u32Mode) || (u32ClkDiv != s_sSens.u32ClkDiv))
+            s_u32BadMode++;
+
+        /* 0x80 | register starts a read, 0xFF clocks out the next register */
+        if (u8Out == 0xFF)
+            return SensReg(s_u32SensPtr++);
+
+        s_u32SensPtr = u8Out & 0x7F;
+    }
+
+    return 0x00;
+}
+
+static uint8_t QspiShift(uint32_t u32Ctl, uint32_t u32ClkDiv, uint32_t u32SSCtl, uint8_t u8Out)
+{
+    uint32_t u32Pos, u32Quad = u32Ctl & LINE_MSK;
+    uint8_t u8In = 0xFF;
+
+    if (!(u32SSCtl & SPI_SSCTL_SS_Msk))
+    {
+        s_u32NoCs++;
+        return u8In;
+    }
+
+    if (((u32Ctl & MODE_MSK) != s_sFlash.u32Mode) || (u32ClkDiv != s_sFlash.u32ClkDiv))
+        s_u32BadMode++;
+
+    /* A new select starts a new command */
+    if (s_u32FlashSel != SIM_SPI_GetSelects(SIM_SPI_QSPI0))
+    {
+        s_u32FlashSel = SIM_SPI_GetSelects(SIM_SPI_QSPI0);
+        s_u32FlashPos = 0;
+    }
+
+    u32Pos = s_u32FlashPos++;
+
+    if (u32Pos == 0)
+    {
+        s_u32FlashCmd = u8Out;
+        s_u32FlashAddr = 0;
+    }
+
+    switch (s_u32FlashCmd)
+    {
+    case 0x9F:
+        if (u32Quad)
+            s_u32BadLines++;
+        if ((u32Pos >= 1) && (u32Pos <= 3))
+            u8In = (uint8_t[]) {0xEF, 0x40, 0x18}[u32Pos - 1];
+        break;
+
+    case 0x6B:      /* Fast read quad output: command, address and dummy on one line */
+    case 0x32:      /* Quad page program: command and address on one line */
+        if (u32Pos <= ((s_u32FlashCmd == 0x6B) ? 4u : 3u))
+        {
+            if (u32Quad)
+                s_u32BadLines++;
+            if ((u32Pos >= 1) && (u32Pos <= 3))
+                s_u32FlashAddr = (s_u32FlashAddr << 8) | u8Out;
+        }
+        else if (s_u32FlashCmd == 0x6B)
+        {
+            if (u32Quad != QSPI_CTL_QUADIOEN_Msk)
+                s_u32BadLines++;
+            u8In = s_au8Flash[s_u32FlashAddr++ % FLASH_SIZE];
+        }
+        else
+        {
+            if (u32Quad != (QSPI_CTL_QUADIOEN_Msk | QSPI_CTL_DATDIR_Msk))
+                s_u32BadLines++;
+            s_au8Flash[s_u32FlashAddr++ % FLASH_SIZE] = u8Out;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return u8In;
+}
+
+static uint8_t Shift(uint32_t u32Port, uint32_t u32Ctl, uint32_t u32ClkDiv, uint32_t u32SSCtl, uint8_t u8Out)
+{
+    if (u32Port == SIM_SPI_SPI0)
+        return SpiShift(u32Ctl, u32ClkDiv, u32SSCtl, u8Out);
+
+    return QspiShift(u32Ctl, u32ClkDiv, u32SSCtl, u8Out);
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(GPIO_PAGE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK) ||
+            (SIM_SPI_Init(Shift) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Done(SPI_TXN_T *psTxn, int32_t i32Status)
+{
+    if (s_u32Done < 16)
+    {
+        s_ai32Status[s_u32Done] = i32Status;
+        s_apvArg[s_u32Done] = psTxn->pvArg;
+    }
+
+    s_u32Done++;
+}
+
+static void ResetLog(void)
+{
+    s_u32Done = 0;
+    s_u32DispCnt = 0;
+    memset(s_ai32Status, 0, sizeof(s_ai32Status));
+    memset(s_apvArg, 0, sizeof(s_apvArg));
+}
+
+static uint32_t RunIdle(SPI_BUS_T *psBus)
+{
+    uint32_t n;
+
+    for (n = 0; (psBus->psHead != NULL) && (n < 4 * BIG_LEN); n++)
+        SIM_SPI_Run(1);
+
+    return psBus->psHead == NULL;
+}
+
+static void BuildDisp(SPI_TXN_T *psTxn, uint32_t u32Tag)
+{
+    static const uint8_t au8Cmd[] = {0x2C};
+
+    SPI_BusInitTxn(psTxn, &s_sDisp, au8Cmd, sizeof(au8Cmd), s_psMem->au8Frame, NULL, FRAME_LEN, 0, Done,
+                   (void *)(uintptr_t)u32Tag);
+}
+
+static void BuildSens(SPI_TXN_T *psTxn, uint32_t u32Tag, uint32_t u32Reg)
+{
+    uint8_t u8Cmd = (uint8_t)(0x80 | u32Reg);
+
+    SPI_BusInitTxn(psTxn, &s_sSens, &u8Cmd, 1, NULL, s_psMem->au8Sens[u32Tag], SENS_LEN, 0, Done,
+                   (void *)(uintptr_t)u32Tag);
+}
+
+static uint32_t SensOk(uint32_t u32Tag, uint32_t u32Reg)
+{
+    uint32_t i;
+
+    for (i = 0; i < SENS_LEN; i++)
+    {
+        if (s_psMem->au8Sens[u32Tag][i] != SensReg(u32Reg + i))
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint32_t DispOk(uint32_t u32Frames)
+{
+    uint32_t i, j;
+
+    if (s_u32DispCnt != u32Frames * (FRAME_LEN + 1))
+        return 0;
+
+    for (i = 0; i < u32Frames; i++)
+    {
+        if (s_au8DispLog[i * (FRAME_LEN + 1)] != 0x2C)
+            return 0;
+
+        for (j = 0; j < FRAME_LEN; j++)
+        {
+            if (s_au8DispLog[i * (FRAME_LEN + 1) + 1 + j] != s_psMem->au8Frame[j])
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void TestShared(void)
+{
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+    uint32_t i, u32Selects;
+
+    printf("\n[1] Display and sensor interleaved on SPI0\n");
+    ResetLog();
+    memset(s_psMem->au8Sens, 0, sizeof(s_psMem->au8Sens));
+    SPI_BusClearStats(&s_psMem->sSpiBus);
+    u32Selects = SIM_SPI_GetSelects(SIM_SPI_SPI0);
+
+    /* D S D S S D: the sensor pair shares its settings, the other changes reload them */
+    BuildDisp(&psTxn[0], 0);
+    BuildSens(&psTxn[1], 1, 0x10);
+    BuildDisp(&psTxn[2], 2);
+    BuildSens(&psTxn[3], 3, 0x20);
+    BuildSens(&psTxn[4], 4, 0x30);
+    BuildDisp(&psTxn[5], 5);
+
+    for (i = 0; i < 6; i++)
+        CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[i]) == 0, "submit %u", i);
+
+    CHECK(psTxn[5].i32Status == SPI_BUS_PENDING, "queued status");
+    CHECK(RunIdle(&s_psMem->sSpiBus), "bus never idle");
+    CHECK(s_u32Done == 6, "%u callbacks", s_u32Done);
+
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(s_ai32Status[i] == 0, "status %d of callback %u", s_ai32Status[i], i);
+        CHECK(s_apvArg[i] == (void *)(uintptr_t)i, "callback %u out of order", i);
+    }
+
+    CHECK(SensOk(1, 0x10) && SensOk(3, 0x20) && SensOk(4, 0x30), "sensor data");
+    CHECK(DispOk(3), "display stream (%u bytes)", s_u32DispCnt);
+    CHECK(SIM_SPI_GetSelects(SIM_SPI_SPI0) - u32Selects == 3, "%u display selects", SIM_SPI_GetSelects(SIM_SPI_SPI0) - u32Selects);
+    CHECK(!(SPI0->SSCTL & SPI_SSCTL_SS_Msk) && (PB3 == 1), "chip select left active");
+    CHECK(s_psMem->sSpiBus.sStat.u32Txns == 6, "stat txns %u", s_psMem->sSpiBus.sStat.u32Txns);
+    CHECK(s_psMem->sSpiBus.sStat.u32Bytes == 3 * (FRAME_LEN + 1) + 3 * (SENS_LEN + 1), "stat bytes %u", s_psMem->sSpiBus.sStat.u32Bytes);
+    CHECK(s_psMem->sSpiBus.sStat.u32ModeSwitches == 5, "stat mode switches %u", s_psMem->sSpiBus.sStat.u32ModeSwitches);
+    CHECK(s_psMem->sSpiBus.sStat.u32MaxDepth == 6, "stat max depth %u", s_psMem->sSpiBus.sStat.u32MaxDepth);
+    CHECK(s_psMem->sSpiBus.sStat.u32MaxLatency >= s_psMem->sSpiBus.sStat.u32BusyTime / 2, "stat latency %u busy %u",
+          s_psMem->sSpiBus.sStat.u32MaxLatency, s_psMem->sSpiBus.sStat.u32BusyTime);
+    CHECK((SPI_BusGetLoad(&s_psMem->sSpiBus) > 900) && (SPI_BusGetLoad(&s_psMem->sSpiBus) <= 1000), "load %u",
+          SPI_BusGetLoad(&s_psMem->sSpiBus));
+    printf("  %u bytes, %u mode switches, load %u/1000, max latency %u ticks\n", s_psMem->sSpiBus.sStat.u32Bytes,
+           s_psMem->sSpiBus.sStat.u32ModeSwitches, SPI_BusGetLoad(&s_psMem->sSpiBus), s_psMem->sSpiBus.sStat.u32MaxLatency);
+}
+
+static void TestKeepCs(void)
+{
+    static const uint8_t au8Caset[] = {0x2A, 0x00, 0x00, 0x00, 0xEF};
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+    uint32_t u32Selects;
+
+    printf("\n[2] KEEP_CS: command and data of one display write under one select\n");
+    ResetLog();
+    u32Selects = SIM_SPI_GetSelects(SIM_SPI_SPI0);
+
+    SPI_BusInitTxn(&psTxn[0], &s_sDisp, au8Caset, sizeof(au8Caset), NULL, NULL, 0, SPI_TXN_KEEP_CS, Done, NULL);
+    SPI_BusInitTxn(&psTxn[1], &s_sDisp, NULL, 0, s_psMem->au8Frame, NULL, 64, 0, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == 0, "submit");
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[1]) == 0, "submit");
+    CHECK(RunIdle(&s_psMem->sSpiBus) && (s_u32Done == 2), "not completed");
+    CHECK(SIM_SPI_GetSelects(SIM_SPI_SPI0) - u32Selects == 1, "%u selects", SIM_SPI_GetSelects(SIM_SPI_SPI0) - u32Selects);
+    CHECK((s_u32DispCnt == sizeof(au8Caset) + 64) && !memcmp(s_au8DispLog + sizeof(au8Caset), s_psMem->au8Frame, 64),
+          "display stream");
+
+    /* A kept select is dropped before another device is selected */
+    ResetLog();
+    SPI_BusInitTxn(&psTxn[0], &s_sDisp, au8Caset, sizeof(au8Caset), NULL, NULL, 0, SPI_TXN_KEEP_CS, Done, NULL);
+    BuildSens(&psTxn[1], 1, 0x40);
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == 0, "submit");
+    CHECK(RunIdle(&s_psMem->sSpiBus), "not completed");
+    CHECK(SPI0->SSCTL & SPI_SSCTL_SS_Msk, "KEEP_CS select dropped while idle");
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[1]) == 0, "submit");
+    CHECK(RunIdle(&s_psMem->sSpiBus) && (s_u32Done == 2), "not completed");
+    CHECK(SensOk(1, 0x40), "sensor data");
+    CHECK(!(SPI0->SSCTL & SPI_SSCTL_SS_Msk) && (PB3 == 1), "chip select left active");
+}
+
+static void TestQuad(void)
+{
+    static const uint8_t au8Read[] = {0x6B, 0x00, 0x10, 0x00, 0x00};
+    static const uint8_t au8Prog[] = {0x32, 0x01, 0x80, 0x00};
+    static const uint8_t au8Id[] = {0x9F};
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+    uint8_t au8Id3[3];
+    uint32_t i;
+
+    printf("\n[3] QSPI0 flash: 1-bit command, quad data, two PDMA segments\n");
+    ResetLog();
+
+    for (i = 0; i < FLASH_SIZE; i++)
+        s_au8Flash[i] = (uint8_t)(i * 31 + (i >> 8));
+
+    for (i = 0; i < PROG_LEN; i++)
+        s_psMem->au8Prog[i] = (uint8_t)(0x5A ^ i);
+
+    memset(s_psMem->au8Big, 0, BIG_LEN);
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, au8Id, sizeof(au8Id), NULL, s_psMem->au8Sens[0], 3, 0, Done, NULL);
+    SPI_BusInitTxn(&psTxn[1], &s_sFlash, au8Read, sizeof(au8Read), NULL, s_psMem->au8Big, BIG_LEN, SPI_TXN_DATA_QUAD, Done, NULL);
+    SPI_BusInitTxn(&psTxn[2], &s_sFlash, au8Prog, sizeof(au8Prog), s_psMem->au8Prog, NULL, PROG_LEN, SPI_TXN_DATA_QUAD, Done, NULL);
+
+    for (i = 0; i < 3; i++)
+        CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[i]) == 0, "submit %u", i);
+
+    CHECK(RunIdle(&s_psMem->sQspiBus) && (s_u32Done == 3), "not completed");
+    CHECK((s_ai32Status[0] == 0) && (s_ai32Status[1] == 0) && (s_ai32Status[2] == 0), "status");
+    memcpy(au8Id3, s_psMem->au8Sens[0], 3);
+    CHECK((au8Id3[0] == 0xEF) && (au8Id3[1] == 0x40) && (au8Id3[2] == 0x18), "JEDEC ID %02X %02X %02X", au8Id3[0], au8Id3[1], au8Id3[2]);
+
+    for (i = 0; (i < BIG_LEN) && (s_psMem->au8Big[i] == (uint8_t)((0x1000 + i) * 31 + ((0x1000 + i) >> 8))); i++) {}
+
+    CHECK(i == BIG_LEN, "quad read differs at %u", i);
+    CHECK(!memcmp(&s_au8Flash[0x18000], s_psMem->au8Prog, PROG_LEN), "quad program");
+    CHECK(!(QSPI0->CTL & LINE_MSK), "line mode left in CTL");
+    CHECK(SIM_SPI_GetRxOverruns(SIM_SPI_QSPI0) == 0, "RX FIFO overrun");
+    CHECK(s_psMem->sQspiBus.sStat.u32ModeSwitches == 1, "%u mode switches", s_psMem->sQspiBus.sStat.u32ModeSwitches);
+}
+
+static void TestParam(void)
+{
+    static const uint8_t au8Cmd[SPI_TXN_CMD_MAX + 1] = {0x03};
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+    SPI_DEV_T sDev;
+
+    printf("\n[4] Parameter and state errors\n");
+    ResetLog();
+
+    SPI_BusInitTxn(&psTxn[0], &s_sSens, NULL, 0, NULL, s_psMem->au8Sens[0], 4, SPI_TXN_DATA_QUAD, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "quad on SPI0 accepted");
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, NULL, 0, NULL, s_psMem->au8Sens[0], 4, SPI_TXN_DATA_QUAD | SPI_TXN_DATA_DUAL, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "dual and quad accepted");
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, NULL, 0, s_psMem->au8Prog, s_psMem->au8Sens[0], 4, SPI_TXN_DATA_QUAD, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "quad in both directions accepted");
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, au8Cmd, sizeof(au8Cmd), NULL, NULL, 0, 0, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "long command accepted");
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, NULL, 0, NULL, NULL, 0, 0, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "empty transaction accepted");
+    SPI_BusInitTxn(&psTxn[0], &s_sFlash, NULL, 0, NULL, NULL, SPI_TXN_SEG_MAX * 65536 + 1, 0, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "oversized transaction accepted");
+    SPI_BusInitTxn(&psTxn[0], NULL, au8Cmd, 1, NULL, NULL, 0, 0, Done, NULL);
+    CHECK(SPI_BusSubmit(&s_psMem->sQspiBus, &psTxn[0]) == SPI_BUS_PARAM_ERR, "transaction without device accepted");
+    CHECK(s_u32Done == 0, "callback of a rejected transaction");
+
+    BuildSens(&psTxn[0], 0, 0x01);
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == 0, "submit");
+    CHECK(SPI_BusInitDev(&s_psMem->sSpiBus, &sDev, SPI_MODE_0, 1000000, SPI_SS_ACTIVE_LOW, NULL) == SPI_BUS_BUSY_ERR, "device set up on a busy bus");
+    CHECK(SPI_BusClose(&s_psMem->sSpiBus) == SPI_BUS_BUSY_ERR, "busy bus closed");
+    CHECK(RunIdle(&s_psMem->sSpiBus) && (s_u32Done == 1) && SensOk(0, 0x01), "not completed");
+}
+
+static void TestAbort(void)
+{
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+    uint32_t u32Errors = s_psMem->sSpiBus.sStat.u32Errors;
+
+    printf("\n[5] Target abort in the middle of a queue\n");
+    ResetLog();
+
+    BuildSens(&psTxn[0], 0, 0x05);
+    psTxn[0].pu8Rx = (uint8_t *)BAD_ADDR;
+    BuildDisp(&psTxn[1], 1);
+    BuildSens(&psTxn[2], 2, 0x06);
+
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == 0, "submit");
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[1]) == 0, "submit");
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[2]) == 0, "submit");
+    CHECK(RunIdle(&s_psMem->sSpiBus) && (s_u32Done == 3), "not completed (%u)", s_u32Done);
+    CHECK(s_ai32Status[0] == SPI_BUS_PDMA_ERR, "abort status %d", s_ai32Status[0]);
+    CHECK((s_ai32Status[1] == 0) && (s_ai32Status[2] == 0), "queue after the abort %d %d", s_ai32Status[1], s_ai32Status[2]);
+    CHECK(DispOk(1) && SensOk(2, 0x06), "data after the abort");
+    CHECK(s_psMem->sSpiBus.sStat.u32Errors == u32Errors + 1, "stat errors");
+    CHECK(!(SPI0->SSCTL & SPI_SSCTL_SS_Msk) && (PB3 == 1), "chip select left active");
+}
+
+static void Resubmit(SPI_TXN_T *psTxn, int32_t i32Status)
+{
+    Done(psTxn, i32Status);
+
+    if ((i32Status == 0) && (++s_u32Resubmit < 5))
+        SPI_BusSubmit(&s_psMem->sSpiBus, psTxn);
+}
+
+static void TestResubmit(void)
+{
+    SPI_TXN_T *psTxn = s_psMem->asTxn;
+
+    printf("\n[6] Resubmission from the callback\n");
+    ResetLog();
+    s_u32Resubmit = 0;
+
+    BuildSens(&psTxn[0], 0, 0x11);
+    psTxn[0].pfnDone = Resubmit;
+    BuildDisp(&psTxn[1], 1);
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[0]) == 0, "submit");
+    CHECK(SPI_BusSubmit(&s_psMem->sSpiBus, &psTxn[1]) == 0, "submit");
+    CHECK(RunIdle(&s_psMem->sSpiBus), "not completed");
+    CHECK(s_u32Done == 6, "%u callbacks", s_u32Done);
+    CHECK(DispOk(1) && SensOk(0, 0x11), "data");
+}
+
+static void TestStats(void)
+{
+    printf("\n[7] Statistics and close\n");
+    SPI_BusClearStats(&s_psMem->sSpiBus);
+    CHECK((s_psMem->sSpiBus.sStat.u32Txns == 0) && (s_psMem->sSpiBus.sStat.u32MaxDepth == 0) && (SPI_BusGetLoad(&s_psMem->sSpiBus) == 0),
+          "statistics not cleared");
+    CHECK(s_u32CsClash == 0, "%u bytes with two selects", s_u32CsClash);
+    CHECK(s_u32NoCs == 0, "%u bytes without select", s_u32NoCs);
+    CHECK(s_u32BadMode == 0, "%u bytes with another device's mode or clock", s_u32BadMode);
+    CHECK(s_u32BadLines == 0, "%u bytes in the wrong line mode", s_u32BadLines);
+    CHECK((SPI_BusClose(&s_psMem->sSpiBus) == 0) && (SPI_BusClose(&s_psMem->sQspiBus) == 0), "close");
+    CHECK(s_sSvc.u32ChUsed == 0, "PDMA channels left allocated 0x%X", s_sSvc.u32ChUsed);
+}
+
+int main(void)
+{
+    uint32_t i;
+
+    if (HOSTSIM_TestBegin("SPI/QSPI transaction queue", SimInit) != 0)
+        return 1;
+
+    CLK->CLKSEL2 = CLK_CLKSEL2_QSPI0SEL_PCLK0 | CLK_CLKSEL2_SPI0SEL_PCLK1;
+    PB3 = 1;
+
+    for (i = 0; i < FRAME_LEN; i++)
+        s_psMem->au8Frame[i] = (uint8_t)(i ^ 0xA5);
+
+    if ((PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, GetTime) != 0) ||
+            (SPI_Open(SPI0, SPI_MASTER, SPI_MODE_0, 8, 1000000) == 0) ||
+            (QSPI_Open(QSPI0, QSPI_MASTER, QSPI_MODE_0, 8, 1000000) == 0))
+    {
+        printf("Open failed\n");
+        return 1;
+    }
+
+    CHECK(SPI_BusOpen(&s_psMem->sSpiBus, (SPI_T *)UART0, &s_sSvc) == SPI_BUS_PARAM_ERR, "UART0 accepted as a bus");
+
+    if ((SPI_BusOpen(&s_psMem->sSpiBus, SPI0, &s_sSvc) != 0) || (SPI_BusOpen(&s_psMem->sQspiBus, (SPI_T *)QSPI0, &s_sSvc) != 0) ||
+            (SPI_BusInitDev(&s_psMem->sSpiBus, &s_sDisp, SPI_MODE_0, 24000000, SPI_SS_ACTIVE_LOW, NULL) != 0) ||
+            (SPI_BusInitDev(&s_psMem->sSpiBus, &s_sSens, SPI_MODE_3, 1000000, SPI_SS_ACTIVE_LOW, &PB3) != 0) ||
+            (SPI_BusInitDev(&s_psMem->sQspiBus, &s_sFlash, SPI_MODE_0, 48000000, SPI_SS_ACTIVE_LOW, NULL) != 0))
+    {
+        printf("SPI_BusOpen failed\n");
+        return 1;
+    }
+
+    CHECK((s_sDisp.u32BusClock == 24000000) && (s_sSens.u32BusClock == 1000000) && (s_sFlash.u32BusClock == 48000000),
+          "bus clocks %u %u %u", s_sDisp.u32BusClock, s_sSens.u32BusClock, s_sFlash.u32BusClock);
+    CHECK(s_sDisp.u32ClkDiv != s_sSens.u32ClkDiv, "display and sensor share a divider");
+
+    TestShared();
+    TestKeepCs();
+    TestQuad();
+    TestParam();
+    TestAbort();
+    TestResubmit();
+    TestStats();
+
+    return HOSTSIM_TestEnd();
+}
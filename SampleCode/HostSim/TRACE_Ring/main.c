@@ -0,0 +1,573 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the event trace ring
+ *           (TRACE_Init() ... TRACE_Dump()) and the PDMA trace points.
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               "-DTRACE_MODULES=(TRACE_MSK_APP|TRACE_MSK_PDMA|TRACE_MSK_I2S|TRACE_MSK_CANFD)"
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c
+ *               ../../../Library/StdDriver/src/pdma.c
+ *               -o trace_ring
+ *           ./trace_ring [dump.bin]
+ *
+ *           trace.c is built into this file so that its timestamp is the
+ *           simulated clock, which can also play an interrupt: a record made
+ *           while the clock is read lands between the LDREX and STREX of the
+ *           record being written, as an interrupt does on the target.
+ *           Checked are the parameter checks, compile-time module selection,
+ *           wrap and one-shot modes, the dump layout, records nested up to
+ *           three deep at random points, and the trace points of
+ *           PDMA_SvcIRQHandler() against the PDMA0 model of
+ *           ../common/sim_pdma.c.
+ *           Check [6] simulates a preemptive workload: a decode loop, the
+ *           I2S interrupt above the CAN FD interrupt above PDMA, with known
+ *           durations. Given a file name, its dump is written there as input
+ *           for SampleCode/StdDriver/TRACE_HotPath/HostTool/trace_decode.
+ *           The last check dumps a ring whose 32-bit record head went
+ *           through 0.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+static uint32_t SimCycles(void);
+#define TRACE_TIMESTAMP()   SimCycles()
+
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+#include "../../../Library/StdDriver/src/trace.c"
+
+#define RING_SIZE           16
+#define BIG_RING_SIZE       4096
+#define POOL_SIZE           8
+#define SRAM_SIM_SIZE       0x10000ul
+#define NEST_RECORDS        20000
+
+#define ADDR(p)             ((uint32_t)(uintptr_t)(p))
+#define MEM_CTL             (PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128)
+
+#define EVT_TYPE(e)         (((e) & TRACE_EVT_TYPE_Msk) >> TRACE_EVT_TYPE_Pos)
+#define EVT_MOD(e)          (((e) & TRACE_EVT_MOD_Msk) >> TRACE_EVT_MOD_Pos)
+#define EVT_POINT(e)        (((e) & TRACE_EVT_POINT_Msk) >> TRACE_EVT_POINT_Pos)
+#define EVT_ARG(e)          (((e) & TRACE_EVT_ARG_Msk) >> TRACE_EVT_ARG_Pos)
+
+typedef struct
+{
+    DSCT_T asPool[POOL_SIZE];
+    uint8_t au8Src[1024];
+    uint8_t au8Dst[1024];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+
+static TRACE_REC_T s_asRing[RING_SIZE];
+static TRACE_REC_T s_asBigRing[BIG_RING_SIZE];
+
+/* Dump read back */
+static uint8_t s_au8Dump[sizeof(TRACE_HDR_T) + BIG_RING_SIZE * sizeof(TRACE_REC_T)];
+static uint32_t s_u32DumpLen, s_u32DumpPuts;
+static TRACE_HDR_T s_sHdr;
+static TRACE_REC_T *s_psRec = (TRACE_REC_T *)&s_au8Dump[sizeof(TRACE_HDR_T)];
+
+/* Simulated clock; reads may record on behalf of an interrupt */
+static uint32_t s_u32Now, s_u32Reads;
+static uint32_t s_u32Preempt;           /* Reads left before the next preemption, 0 for none */
+static uint32_t s_u32Depth, s_u32MaxDepth, s_u32Nested;
+static uint32_t s_u32Seed = 1;
+
+static uint32_t Rand(void)
+{
+    s_u32Seed = s_u32Seed * 1103515245u + 12345u;
+    return s_u32Seed >> 16;
+}
+
+static uint32_t SimCycles(void)
+{
+    s_u32Reads++;
+
+    /* An interrupt while the slot is reserved, which may itself be interrupted */
+    if ((s_u32Preempt != 0) && (--s_u32Preempt == 0) && (s_u32Depth < 3))
+    {
+        s_u32Depth++;
+        if (s_u32Depth > s_u32MaxDepth)
+            s_u32MaxDepth = s_u32Depth;
+        s_u32Preempt = (Rand() & 1) ? 1 : 0;
+        TRACE_MARK(APP, 1, s_u32Nested++);
+        s_u32Depth--;
+    }
+
+    return s_u32Now++;
+}
+
+static void Put(void *pvPriv, const void *pvData, uint32_t u32Len)
+{
+    (void)pvPriv;
+
+    if (s_u32DumpLen + u32Len <= sizeof(s_au8Dump))
+        memcpy(&s_au8Dump[s_u32DumpLen], pvData, u32Len);
+    s_u32DumpLen += u32Len;
+    s_u32DumpPuts++;
+}
+
+static uint32_t Dump(void)
+{
+    uint32_t u32Count;
+
+    s_u32DumpLen = 0;
+    s_u32DumpPuts = 0;
+    u32Count = TRACE_Dump(Put, NULL);
+    memcpy(&s_sHdr, s_au8Dump, sizeof(s_sHdr));
+
+    return u32Count;
+}
+
+/* Records in slot order carry nondecreasing timestamps */
+static uint32_t Unordered(uint32_t u32Count)
+{
+    uint32_t i, u32Bad = 0;
+
+    for (i = 1; i < u32Count; i++)
+        u32Bad += ((int32_t)(s_psRec[i].u32Cycles - s_psRec[i - 1].u32Cycles) < 0);
+
+    return u32Bad;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void TestInit(void)
+{
+    uint32_t u32Side = 0;
+
+    printf("\n[1] Parameters and compile-time selection\n");
+    CHECK(TRACE_Init(NULL, RING_SIZE, TRACE_MODE_WRAP) == TRACE_ERR_PARAM, "NULL ring accepted");
+    CHECK(TRACE_Init(s_asRing, 1, TRACE_MODE_WRAP) == TRACE_ERR_PARAM, "size 1 accepted");
+    CHECK(TRACE_Init(s_asRing, 12, TRACE_MODE_WRAP) == TRACE_ERR_PARAM, "size 12 accepted");
+    CHECK(TRACE_Init(s_asRing, RING_SIZE, 2) == TRACE_ERR_PARAM, "mode 2 accepted");
+    CHECK(TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_WRAP) == TRACE_OK, "init");
+
+    TRACE_MARK(APP, 0, 1);
+    CHECK(Dump() == 0, "recorded before TRACE_Start()");
+
+    /* SDH and EHCI are not in TRACE_MODULES: no record, the argument is not even evaluated */
+    TRACE_Start();
+    TRACE_MARK(SDH, TRACE_SDH_IRQ, u32Side++);
+    TRACE_ENTER(EHCI, TRACE_EHCI_IRQ, u32Side++);
+    TRACE_MARK(APP, 7, 0x12345);
+    TRACE_ENTER(CANFD, TRACE_CANFD_IRQ, 3);
+    TRACE_Stop();
+    TRACE_MARK(APP, 0, 2);
+
+    printf("  %u records, disabled modules evaluated %u arguments\n", Dump(), u32Side);
+    CHECK((s_sHdr.u32Count == 2) && (u32Side == 0), "compile-time selection");
+    CHECK(s_psRec[0].u32Event == TRACE_EVENT(TRACE_TYPE_MARK, TRACE_MOD_APP, 7, 0x2345), "event word 0x%08X",
+          s_psRec[0].u32Event);
+    CHECK((EVT_TYPE(s_psRec[1].u32Event) == TRACE_TYPE_ENTER) && (EVT_MOD(s_psRec[1].u32Event) == TRACE_MOD_CANFD) &&
+          (EVT_POINT(s_psRec[1].u32Event) == TRACE_CANFD_IRQ) && (EVT_ARG(s_psRec[1].u32Event) == 3), "event fields");
+}
+
+static void TestModes(void)
+{
+    uint32_t i, u32Bad = 0;
+
+    printf("\n[2] Wrap mode, 40 records into %u slots\n", RING_SIZE);
+    TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_WRAP);
+    TRACE_Start();
+    for (i = 0; i < 40; i++)
+        TRACE_MARK(APP, 0, i);
+    TRACE_Stop();
+
+    Dump();
+    for (i = 0; i < s_sHdr.u32Count; i++)
+        u32Bad += (EVT_ARG(s_psRec[i].u32Event) != 24 + i);
+
+    printf("  header: magic %08X, version %u, %u Hz, %u records, %u lost; %u bytes in %u writes\n", s_sHdr.u32Magic,
+           s_sHdr.u32Version, s_sHdr.u32Freq, s_sHdr.u32Count, s_sHdr.u32Lost, s_u32DumpLen, s_u32DumpPuts);
+    CHECK((s_sHdr.u32Magic == TRACE_MAGIC) && (s_sHdr.u32Version == TRACE_VERSION) &&
+          (s_sHdr.u32Freq == SystemCoreClock), "header");
+    CHECK((s_sHdr.u32Count == RING_SIZE) && (s_sHdr.u32Lost == 24), "count/lost");
+    CHECK((u32Bad == 0) && (Unordered(s_sHdr.u32Count) == 0), "newest records, oldest first");
+    CHECK((s_u32DumpLen == sizeof(TRACE_HDR_T) + RING_SIZE * sizeof(TRACE_REC_T)) && (s_u32DumpPuts == 3),
+          "two runs of records after the header");
+
+    printf("\n[3] One-shot mode, 40 records into %u slots\n", RING_SIZE);
+    TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_ONESHOT);
+    TRACE_Start();
+    for (i = 0; i < 40; i++)
+        TRACE_MARK(APP, 0, i);
+    TRACE_Stop();
+
+    Dump();
+    u32Bad = 0;
+    for (i = 0; i < s_sHdr.u32Count; i++)
+        u32Bad += (EVT_ARG(s_psRec[i].u32Event) != i);
+
+    printf("  %u records, %u lost\n", s_sHdr.u32Count, s_sHdr.u32Lost);
+    CHECK((s_sHdr.u32Count == RING_SIZE) && (s_sHdr.u32Lost == 24) && (u32Bad == 0), "first records kept");
+
+    /* Recording again keeps what is there */
+    TRACE_Start();
+    TRACE_MARK(APP, 0, 99);
+    TRACE_Stop();
+    Dump();
+    CHECK((s_sHdr.u32Count == RING_SIZE) && (s_sHdr.u32Lost == 25), "one-shot after restart");
+}
+
+static void TestNesting(void)
+{
+    static uint8_t au8Seen[NEST_RECORDS];
+    uint32_t i, u32Outer = 0, u32Inner, u32Dup = 0, u32Reads, u32Missing = 0;
+
+    printf("\n[4] Records interrupted between LDREX and STREX\n");
+    TRACE_Init(s_asBigRing, BIG_RING_SIZE, TRACE_MODE_ONESHOT);
+    TRACE_Start();
+
+    /* One interrupt: it takes slot 0, the interrupted record retries into slot 1 */
+    s_u32Nested = 0;
+    s_u32Reads = 0;
+    s_u32Seed = 2;                      /* First draw even: no second level */
+    s_u32Preempt = 1;
+    TRACE_MARK(APP, 0, 0);
+    Dump();
+    printf("  %u records, clock read %u times\n", s_sHdr.u32Count, s_u32Reads);
+    CHECK((s_sHdr.u32Count == 2) && (EVT_POINT(s_psRec[0].u32Event) == 1) && (EVT_POINT(s_psRec[1].u32Event) == 0),
+          "interrupt record first");
+    CHECK((s_u32Reads == 3) && (Unordered(2) == 0), "retry with a new timestamp");
+
+    /* Random interrupts, up to three deep */
+    TRACE_Init(s_asBigRing, BIG_RING_SIZE, TRACE_MODE_WRAP);
+    TRACE_Start();
+    s_u32Nested = 0;
+    s_u32MaxDepth = 0;
+    s_u32Reads = 0;
+    for (i = 0; (u32Outer + s_u32Nested) < NEST_RECORDS; i++)
+    {
+        s_u32Preempt = ((Rand() & 3) == 0) ? 1 : 0;
+        TRACE_MARK(APP, 0, u32Outer++);
+    }
+    s_u32Preempt = 0;
+    TRACE_Stop();
+    u32Reads = s_u32Reads;
+
+    /* The ring holds the newest records; every one of them appears once */
+    Dump();
+    memset(au8Seen, 0, sizeof(au8Seen));
+    u32Inner = 0;
+    for (i = 0; i < s_sHdr.u32Count; i++)
+    {
+        uint32_t u32Point = EVT_POINT(s_psRec[i].u32Event), u32Arg = EVT_ARG(s_psRec[i].u32Event);
+
+        u32Inner += u32Point;
+        if (au8Seen[u32Arg] & (1 << u32Point))
+            u32Dup++;
+        au8Seen[u32Arg] |= (1 << u32Point);
+    }
+    for (i = u32Outer - (BIG_RING_SIZE / 2); i < u32Outer; i++)
+        u32Missing += !(au8Seen[i] & 1);
+
+    printf("  %u records (%u interrupting, max depth %u), %u clock reads, %u kept, %u lost\n",
+           u32Outer + s_u32Nested, s_u32Nested, s_u32MaxDepth, u32Reads, s_sHdr.u32Count, s_sHdr.u32Lost);
+    CHECK(s_u32MaxDepth == 3, "nesting depth");
+    CHECK((s_sHdr.u32Count + s_sHdr.u32Lost) == (u32Outer + s_u32Nested), "records taken");
+    CHECK(u32Reads == (u32Outer + 2 * s_u32Nested), "one retry per interrupting record");
+    CHECK((u32Dup == 0) && (u32Missing == 0) && (Unordered(s_sHdr.u32Count) == 0), "duplicates %u, missing %u",
+          u32Dup, u32Missing);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  PDMA trace points                                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+static void XferDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    (void)psXfer;
+    TRACE_MARK(APP, 2, (uint32_t)i32Status);
+}
+
+static void TestPdma(void)
+{
+    static const uint32_t au32Expect[] =
+    {
+        TRACE_EVENT(TRACE_TYPE_ENTER, TRACE_MOD_PDMA, TRACE_PDMA_SVC_IRQ, 0),
+        TRACE_EVENT(TRACE_TYPE_ENTER, TRACE_MOD_PDMA, TRACE_PDMA_XFER_DONE, 0),
+        TRACE_EVENT(TRACE_TYPE_MARK, TRACE_MOD_APP, 2, 0),
+        TRACE_EVENT(TRACE_TYPE_EXIT, TRACE_MOD_PDMA, TRACE_PDMA_XFER_DONE, 0),
+        TRACE_EVENT(TRACE_TYPE_EXIT, TRACE_MOD_PDMA, TRACE_PDMA_SVC_IRQ, 0),
+    };
+    PDMA_SEG_T asSeg[2];
+    PDMA_XFER_T asXfer[2];
+    uint32_t i, j, u32Ch, u32Arg, u32Bad = 0;
+
+    printf("\n[5] PDMA_SvcIRQHandler() trace points\n");
+    if ((SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) || (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, NULL) != 0))
+    {
+        CHECK(0, "PDMA model");
+        return;
+    }
+
+    u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+    for (i = 0; i < 2; i++)
+    {
+        asSeg[i].u32SrcAddr = ADDR(&s_psMem->au8Src[i * 512]);
+        asSeg[i].u32DstAddr = ADDR(&s_psMem->au8Dst[i * 512]);
+        asSeg[i].u32TransCount = 512;
+        PDMA_SvcInitXfer(&asXfer[i], &asSeg[i], 1, PDMA_MEM, MEM_CTL, XferDone, NULL);
+    }
+
+    TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_WRAP);
+    TRACE_Start();
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[0]);
+    PDMA_SvcSubmit(&s_sSvc, u32Ch, &asXfer[1]);
+    SIM_PDMA_RunMem();
+    TRACE_Stop();
+
+    Dump();
+    for (i = 0; i < s_sHdr.u32Count; i++)
+    {
+        j = i % 5;
+        u32Arg = ((j == 1) || (j == 3)) ? u32Ch : ((j == 4) ? (1u << u32Ch) & TRACE_EVT_ARG_Msk : 0);
+        u32Bad += (s_psRec[i].u32Event != (au32Expect[j] | u32Arg));
+    }
+
+    printf("  channel %u, %u records for 2 transfers:", u32Ch, s_sHdr.u32Count);
+    for (i = 0; i < s_sHdr.u32Count; i++)
+        printf(" %c%u.%u:%X", "MEX?"[EVT_TYPE(s_psRec[i].u32Event)], EVT_MOD(s_psRec[i].u32Event),
+               EVT_POINT(s_psRec[i].u32Event), EVT_ARG(s_psRec[i].u32Event));
+    printf("\n");
+    CHECK((s_sHdr.u32Count == 10) && (u32Bad == 0), "interrupt, callback span and channel mask");
+    PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Preemptive workload for the host decoder                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SRC_I2S             0
+#define SRC_CANFD           1
+#define SRC_PDMA            2
+#define SRC_NUM             3
+
+/* An interrupt source: runs u32Pre cycles, a nested span of u32Child cycles, then u32Post cycles */
+typedef struct
+{
+    uint32_t u32Mod, u32Point;
+    uint32_t u32ChildMod, u32ChildPoint;
+    uint32_t u32Period, u32Pre, u32Child, u32Post;
+    uint32_t u32Next, u32Pending;
+} SRC_T;
+
+typedef struct
+{
+    SRC_T *psSrc;
+    uint32_t u32Phase, u32Left;
+} CTX_T;
+
+static void TestWorkload(const char *pcFile)
+{
+    /* Highest priority first */
+    static SRC_T asSrc[SRC_NUM] =
+    {
+        { TRACE_MOD_I2S, TRACE_I2S_IRQ, 0, 0, 48000, 1500, 0, 0 },
+        { TRACE_MOD_CANFD, TRACE_CANFD_IRQ, TRACE_MOD_CANFD, TRACE_CANFD_RX_FIFO, 25000, 200, 500, 100 },
+        { TRACE_MOD_PDMA, TRACE_PDMA_SVC_IRQ, TRACE_MOD_PDMA, TRACE_PDMA_XFER_DONE, 100000, 300, 600, 300 },
+    };
+    CTX_T asCtx[SRC_NUM];
+    uint32_t u32Depth = 0, i, u32End, u32Frame = 0, u32FrameLeft = 0, u32IdleLeft = 0, u32Frames = 0;
+    uint32_t u32Open = 0, u32Bad = 0, au32Runs[SRC_NUM] = { 0 };
+    FILE *fp;
+
+    printf("\n[6] Preemptive workload, 20 ms at 200 MHz\n");
+    TRACE_Init(s_asBigRing, BIG_RING_SIZE, TRACE_MODE_WRAP);
+
+    /* Start near the top of the counter so the decoder sees it wrap */
+    s_u32Now = 0xFFF00000u;
+    u32End = s_u32Now + 4000000u;
+    for (i = 0; i < SRC_NUM; i++)
+        asSrc[i].u32Next = s_u32Now + asSrc[i].u32Period / (i + 2);
+
+    TRACE_Start();
+    while (s_u32Now != u32End)
+    {
+        /* Raise the sources due; one that is higher than the running context enters */
+        for (i = 0; i < SRC_NUM; i++)
+        {
+            if (s_u32Now == asSrc[i].u32Next)
+            {
+                asSrc[i].u32Pending = 1;
+                asSrc[i].u32Next += asSrc[i].u32Period + (Rand() % 64);
+            }
+        }
+        for (i = 0; i < SRC_NUM; i++)
+        {
+            if (!asSrc[i].u32Pending)
+                continue;
+            if ((u32Depth != 0) && (asCtx[u32Depth - 1].psSrc <= &asSrc[i]))
+                break;
+            asSrc[i].u32Pending = 0;
+            asCtx[u32Depth].psSrc = &asSrc[i];
+            asCtx[u32Depth].u32Phase = 0;
+            asCtx[u32Depth].u32Left = asSrc[i].u32Pre;
+            u32Depth++;
+            TRACE_Record(TRACE_EVENT(TRACE_TYPE_ENTER, asSrc[i].u32Mod, asSrc[i].u32Point, 0));
+            s_u32Now--;                 /* TRACE_Record() read the clock */
+            break;
+        }
+
+        if (u32Depth != 0)
+        {
+            CTX_T *psCtx = &asCtx[u32Depth - 1];
+            SRC_T *psSrc = psCtx->psSrc;
+
+            /* Phase 0: before the child, 1: child, 2: after it */
+            while (psCtx->u32Left == 0)
+            {
+                if (psCtx->u32Phase == 0)
+                {
+                    psCtx->u32Phase = 1;
+                    psCtx->u32Left = psSrc->u32Child;
+                    if (psSrc->u32Child)
+                        TRACE_Record(TRACE_EVENT(TRACE_TYPE_ENTER, psSrc->u32ChildMod, psSrc->u32ChildPoint, 0)), s_u32Now--;
+                }
+                else if (psCtx->u32Phase == 1)
+                {
+                    psCtx->u32Phase = 2;
+                    psCtx->u32Left = psSrc->u32Post;
+                    if (psSrc->u32Child)
+                        TRACE_Record(TRACE_EVENT(TRACE_TYPE_EXIT, psSrc->u32ChildMod, psSrc->u32ChildPoint, 0)), s_u32Now--;
+                }
+                else
+                {
+                    TRACE_Record(TRACE_EVENT(TRACE_TYPE_EXIT, psSrc->u32Mod, psSrc->u32Point, 0));
+                    s_u32Now--;
+                    au32Runs[psSrc - asSrc]++;
+                    u32Depth--;
+                    break;
+                }
+            }
+            if ((u32Depth != 0) && (&asCtx[u32Depth - 1] == psCtx))
+                psCtx->u32Left--;
+        }
+        else if (u32FrameLeft != 0)
+        {
+            /* Thread: 40000 cycles of decoding per frame, then waiting for the buffer */
+            if (--u32FrameLeft == 0)
+            {
+                TRACE_Record(TRACE_EVENT(TRACE_TYPE_EXIT, TRACE_MOD_APP, 0, u32Frame)), s_u32Now--;
+                u32IdleLeft = 10000;
+                u32Frames++;
+            }
+        }
+        else if ((u32IdleLeft == 0) || (--u32IdleLeft == 0))
+        {
+            u32Frame++;
+            u32FrameLeft = 40000;
+            TRACE_Record(TRACE_EVENT(TRACE_TYPE_ENTER, TRACE_MOD_APP, 0, u32Frame)), s_u32Now--;
+        }
+
+        s_u32Now++;
+    }
+    TRACE_Stop();
+
+    /* Spans left open at the end are the decoder's to report */
+    u32Open = u32Depth + (u32FrameLeft != 0);
+
+    Dump();
+    for (i = 1; i < s_sHdr.u32Count; i++)
+        u32Bad += ((s_psRec[i].u32Cycles - s_psRec[i - 1].u32Cycles) > 4000000u);
+
+    printf("  %u frames; I2S %u, CAN FD %u, PDMA %u interrupts; %u records, %u lost, %u spans open at the end\n",
+           u32Frames, au32Runs[SRC_I2S], au32Runs[SRC_CANFD], au32Runs[SRC_PDMA], s_sHdr.u32Count, s_sHdr.u32Lost, u32Open);
+    printf("  expected: I2S_IRQ 1500 cycles every ~48000; CANFD_IRQ 800 with ReadRxFifoMsg 500 every ~25000;\n"
+           "            PDMA_SvcIRQHandler 1200 with callback 600 every ~100000; decode frames 40000 of work\n");
+    CHECK((s_sHdr.u32Lost == 0) && (u32Bad == 0), "workload records");
+    CHECK((u32Frames > 70) && (au32Runs[SRC_I2S] > 80) && (au32Runs[SRC_CANFD] > 150) && (au32Runs[SRC_PDMA] > 35),
+          "workload ran");
+
+    if ((pcFile != NULL) && ((fp = fopen(pcFile, "wb")) != NULL))
+    {
+        fwrite(s_au8Dump, 1, s_u32DumpLen, fp);
+        fclose(fp);
+        printf("  dump written to %s\n", pcFile);
+    }
+}
+
+static void TestHeadWrap(void)
+{
+    uint32_t i, u32Bad = 0;
+
+    printf("\n[7] Wrap mode with the 32-bit head going through 0\n");
+    TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_WRAP);
+    memset(s_asRing, 0, sizeof(s_asRing));
+
+    /* As if 2^32 - 6 records were taken already: 10 more move the head to 4 */
+    s_u32Head = 0xFFFFFFFAul;
+    TRACE_Start();
+    for (i = 0; i < 10; i++)
+        TRACE_MARK(APP, 0, i + 1);
+    TRACE_Stop();
+
+    Dump();
+    for (i = 0; i < 10; i++)
+        u32Bad += (EVT_ARG(s_psRec[RING_SIZE - 10 + i].u32Event) != i + 1);
+
+    printf("  head %u, lap %u: %u records, %u lost\n", s_u32Head, s_u32Laps, s_sHdr.u32Count, s_sHdr.u32Lost);
+    CHECK((s_u32Head == 4) && (s_sHdr.u32Count == RING_SIZE), "ring not full after the wrap");
+    CHECK(s_sHdr.u32Lost == 0xFFFFFFF4ul, "lost %u", s_sHdr.u32Lost);
+    CHECK((u32Bad == 0) && (s_u32DumpLen == sizeof(TRACE_HDR_T) + RING_SIZE * sizeof(TRACE_REC_T)), "oldest slot");
+
+    /* Past the ring size again the lost count no longer fits: it saturates */
+    TRACE_Start();
+    for (i = 10; i < 30; i++)
+        TRACE_MARK(APP, 0, i + 1);
+    TRACE_Stop();
+
+    Dump();
+    u32Bad = 0;
+    for (i = 0; i < RING_SIZE; i++)
+        u32Bad += (EVT_ARG(s_psRec[i].u32Event) != 30 - RING_SIZE + i + 1);
+
+    printf("  head %u: %u records, %u lost\n", s_u32Head, s_sHdr.u32Count, s_sHdr.u32Lost);
+    CHECK((s_sHdr.u32Count == RING_SIZE) && (s_sHdr.u32Lost == 0xFFFFFFFFul), "count/lost");
+    CHECK((u32Bad == 0) && (Unordered(s_sHdr.u32Count) == 0), "newest records, oldest first");
+}
+
+static int32_t SimInit(void)
+{
+    return HOSTSIM_Init();
+}
+
+int main(int argc, char *argv[])
+{
+    if (HOSTSIM_TestBegin("Event trace ring", SimInit) != 0)
+        return 1;
+
+    SystemCoreClock = 200000000;
+
+    TestInit();
+    TestModes();
+    TestNesting();
+    TestPdma();
+    TestWorkload((argc > 1) ? argv[1] : NULL);
+    TestHeadWrap();
+
+    return HOSTSIM_TestEnd();
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,480 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the ring-buffered UART API
+ *           (UART_BufOpen() ... UART_BufPdmaIRQHandler()).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               main.c ../common/hostsim.c ../common/sim_pdma.c ../common/sim_uart.c
+ *               ../../../Library/StdDriver/src/pdma.c ../../../Library/StdDriver/src/uart.c
+ *               -o uart_buffered
+ *           ./uart_buffered
+ *
+ *           The UART0/USCI0 model of ../common/sim_uart.c moves one character
+ *           per character time between the host wire and the FIFOs, and the
+ *           PDMA0 model of ../common/sim_pdma.c serves their requests into the
+ *           rings in the simulated SRAM. The port channels come from a PDMA
+ *           channel service whose handler runs in the same PDMA0 interrupt.
+ *           Checked are channel allocation, PDMA and interrupt driven RX and
+ *           TX, reads without any flush, peek, the idle and half ring events,
+ *           ring and FIFO overruns, line error counters, the USCI port and a
+ *           back-to-back burst read by a slow polling consumer.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "sim_pdma.h"
+#include "sim_uart.h"
+
+#define RX_SIZE             256
+#define TX_SIZE             256
+#define BURST_RX_SIZE       1024
+#define BURST_LEN           16384
+#define SRAM_SIM_SIZE       0x10000ul
+
+#define DESC_NUM            4
+
+/* Everything PDMA touches lives in the simulated SRAM window, as on the target */
+typedef struct
+{
+    DSCT_T asPool[DESC_NUM];
+    DSCT_T asUartDesc[2];
+    DSCT_T asUsciDesc[2];
+    uint8_t au8UartRx[BURST_RX_SIZE];
+    uint8_t au8UartTx[TX_SIZE];
+    uint8_t au8UsciRx[RX_SIZE];
+    uint8_t au8UsciTx[TX_SIZE];
+} SIM_MEM_T;
+
+static SIM_MEM_T *s_psMem = (SIM_MEM_T *)SRAM_BASE;
+static PDMA_SVC_T s_sSvc;
+static UART_BUF_T s_sUart, s_sUsci;
+static uint32_t s_u32UartOpen, s_u32UsciOpen;
+static uint32_t s_au32Events[3];        /* RX_IDLE, RX_HALF, TX_EMPTY */
+
+static uint8_t s_au8Pattern[BURST_LEN];
+static uint8_t s_au8Got[BURST_LEN];
+
+/* Referenced by the baud rate code of uart.c, which the check never calls */
+uint32_t CLK_GetPLLClockFreq(void)
+{
+    return 0;
+}
+
+void UART0_IRQHandler(void)
+{
+    if (s_u32UartOpen)
+        UART_BufIRQHandler(&s_sUart);
+}
+
+void USCI0_IRQHandler(void)
+{
+    if (s_u32UsciOpen)
+        UART_BufIRQHandler(&s_sUsci);
+}
+
+/* The service goes first: it must leave the flags of the port channels alone */
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+    if (s_u32UartOpen)
+        UART_BufPdmaIRQHandler(&s_sUart);
+    if (s_u32UsciOpen)
+        UART_BufPdmaIRQHandler(&s_sUsci);
+}
+
+static void OnEvent(UART_BUF_T *psBuf, uint32_t u32Events)
+{
+    (void)psBuf;
+
+    if (u32Events & UART_BUF_EV_RX_IDLE)
+        s_au32Events[0]++;
+    if (u32Events & UART_BUF_EV_RX_HALF)
+        s_au32Events[1]++;
+    if (u32Events & UART_BUF_EV_TX_EMPTY)
+        s_au32Events[2]++;
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) ||
+            (SIM_PDMA_Init(PDMA0_IRQHandler) != HOSTSIM_OK) ||
+            (HOSTSIM_MapPeriph(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (SIM_PDMA_AddMemory(SRAM_BASE, SRAM_SIM_SIZE) != HOSTSIM_OK) ||
+            (PDMA_SvcInit(&s_sSvc, PDMA0, s_psMem->asPool, DESC_NUM, PDMA_SCATBA_SET, 0, NULL) != 0) ||
+            (SIM_UART_Init(UART0_IRQHandler, USCI0_IRQHandler) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+static int32_t OpenUart(uint32_t u32RxChFlags, uint32_t u32TxChFlags, uint32_t u32RxSize)
+{
+    UART_BUF_CFG_T sCfg;
+
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.uart = UART0;
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32RxChFlags = u32RxChFlags;
+    sCfg.u32TxChFlags = u32TxChFlags;
+    sCfg.pu8RxBuf = s_psMem->au8UartRx;
+    sCfg.u32RxSize = u32RxSize;
+    sCfg.pu8TxBuf = s_psMem->au8UartTx;
+    sCfg.u32TxSize = TX_SIZE;
+    sCfg.psRxDesc = s_psMem->asUartDesc;
+    sCfg.pfnEvent = OnEvent;
+
+    memset(s_au32Events, 0, sizeof(s_au32Events));
+    s_u32UartOpen = (UART_BufOpen(&s_sUart, &sCfg) == 0);
+
+    return s_u32UartOpen ? 0 : -1;
+}
+
+static void CloseUart(void)
+{
+    UART_BufClose(&s_sUart);
+    s_u32UartOpen = 0;
+}
+
+static void MakePattern(uint32_t u32Seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < BURST_LEN; i++)
+        s_au8Pattern[i] = (uint8_t)(i * 7 + u32Seed + (i >> 8));
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Checks                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+static void TestConfig(void)
+{
+    UART_BUF_CFG_T sCfg;
+    UART_BUF_T sBuf;
+    uint32_t u32Ch;
+
+    printf("\n[1] Rejected configurations\n");
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.uart = UART0;
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32RxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.u32TxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.pu8RxBuf = s_psMem->au8UartRx;
+    sCfg.u32RxSize = RX_SIZE;
+    sCfg.pu8TxBuf = s_psMem->au8UartTx;
+    sCfg.u32TxSize = TX_SIZE;
+    sCfg.psRxDesc = s_psMem->asUartDesc;
+
+    sCfg.u32RxSize = 100;
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_PARAM_ERR, "ring not a power of two");
+    sCfg.u32RxSize = RX_SIZE;
+    sCfg.uuart = UUART0;
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_PARAM_ERR, "two ports");
+    sCfg.uuart = NULL;
+    sCfg.psRxDesc = NULL;
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_PARAM_ERR, "PDMA RX without descriptors");
+    sCfg.psRxDesc = s_psMem->asUartDesc;
+    sCfg.psSvc = NULL;
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_PARAM_ERR, "PDMA without a channel service");
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32TxChFlags = PDMA_SVC_CH_DIRECT;
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_PARAM_ERR, "unknown channel flag");
+    sCfg.u32TxChFlags = PDMA_SVC_CH_ANY;
+
+    /* One channel left: RX gets it, TX finds none and RX must give it back */
+    for (u32Ch = 1; u32Ch < PDMA_CH_MAX; u32Ch++)
+        PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY);
+    CHECK(UART_BufOpen(&sBuf, &sCfg) == UART_BUF_NOCH_ERR, "open with one free channel");
+    CHECK(s_sSvc.u32ChUsed == 0xFFFEUL, "channels used 0x%X after the failed open", s_sSvc.u32ChUsed);
+    for (u32Ch = 1; u32Ch < PDMA_CH_MAX; u32Ch++)
+        PDMA_SvcFreeCh(&s_sSvc, u32Ch);
+
+    CHECK((PDMA0->CHCTL == 0) && (s_sSvc.u32ChUsed == 0), "channel enabled by a rejected open");
+}
+
+static void TestPdmaRx(void)
+{
+    uint8_t au8Buf[64], au8Peek[64];
+    uint32_t u32Len;
+    PDMA_SEG_T sSeg = { (uint32_t)au8Buf, (uint32_t)au8Peek, 1 };
+    PDMA_XFER_T sXfer;
+
+    printf("\n[2] PDMA RX: bytes readable at once, idle event after the time-out\n");
+    MakePattern(1);
+    CHECK(OpenUart(PDMA_SVC_CH_ANY, PDMA_SVC_CH_ANY, RX_SIZE) == 0, "open");
+    printf("  RX channel %u, TX channel %u, REQSEL12_15 0x%08X, SCATBA 0x%08X\n", s_sUart.u32RxCh, s_sUart.u32TxCh,
+           PDMA0->REQSEL12_15, PDMA0->SCATBA);
+    CHECK((s_sUart.u32RxCh == 15) && (s_sUart.u32TxCh == 14), "channels not the highest free ones");
+    CHECK(s_sSvc.u32ChDirect == 0xC000UL, "port channels not direct");
+    CHECK(SIM_PDMA_GetReqSrc(s_sUart.u32RxCh) == PDMA_UART0_RX, "RX request source");
+    CHECK(SIM_PDMA_GetReqSrc(s_sUart.u32TxCh) == PDMA_UART0_TX, "TX request source");
+    PDMA_SvcInitXfer(&sXfer, &sSeg, 1, PDMA_MEM, PDMA_WIDTH_8 | PDMA_SAR_INC | PDMA_DAR_INC, NULL, NULL);
+    CHECK(PDMA_SvcSubmit(&s_sSvc, s_sUart.u32RxCh, &sXfer) == PDMA_SVC_PARAM_ERR, "transfer queued on a port channel");
+
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 10);
+    SIM_UART_Run(10);
+    CHECK(UART_BufRxCount(&s_sUart) == 10, "count %u, expected 10", UART_BufRxCount(&s_sUart));
+    CHECK(s_au32Events[0] == 0, "idle during the frame");
+
+    u32Len = UART_BufPeek(&s_sUart, au8Peek, 4);
+    CHECK((u32Len == 4) && (memcmp(au8Peek, s_au8Pattern, 4) == 0), "peek");
+    u32Len = UART_BufRead(&s_sUart, au8Buf, 3);
+    CHECK((u32Len == 3) && (memcmp(au8Buf, s_au8Pattern, 3) == 0), "partial read");
+    u32Len = UART_BufRead(&s_sUart, au8Buf, sizeof(au8Buf));
+    CHECK((u32Len == 7) && (memcmp(au8Buf, s_au8Pattern + 3, 7) == 0), "rest of the frame, got %u", u32Len);
+    CHECK(UART_BufRead(&s_sUart, au8Buf, sizeof(au8Buf)) == 0, "empty ring");
+
+    SIM_UART_Run(5);
+    printf("  idle events %u, RX idle count %u\n", s_au32Events[0], s_sUart.sStats.u32RxIdle);
+    CHECK((s_au32Events[0] == 1) && (s_sUart.sStats.u32RxIdle == 1), "one idle event after 4 character times");
+    SIM_UART_Run(20);
+    CHECK(s_au32Events[0] == 1, "idle raised again without data");
+}
+
+static void TestPdmaWrap(void)
+{
+    uint32_t u32Got = 0, u32Len, i;
+
+    printf("\n[3] PDMA RX across ring halves and laps\n");
+    MakePattern(2);
+
+    for (i = 0; i < 10; i++)
+    {
+        SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern + i * 100, 100);
+        SIM_UART_Run(100);
+        u32Len = UART_BufRead(&s_sUart, s_au8Got + u32Got, 100);
+        CHECK(u32Len == 100, "chunk %u read %u", i, u32Len);
+        u32Got += u32Len;
+    }
+
+    printf("  read %u bytes, half ring events %u, halves %u\n", u32Got, s_au32Events[1], s_sUart.u32RxHalves);
+    CHECK(memcmp(s_au8Got, s_au8Pattern, 1000) == 0, "data across the wrap");
+    CHECK(s_sUart.u32RxHalves == (10 + 1000) / (RX_SIZE / 2), "halves");
+    CHECK(s_sUart.sStats.u32RxOverruns == 0, "overrun");
+}
+
+static void TestPdmaOverrun(void)
+{
+    uint8_t au8Buf[RX_SIZE];
+    uint32_t u32Len;
+
+    printf("\n[4] PDMA RX ring overrun: stale data discarded and counted\n");
+    MakePattern(3);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 300);
+    SIM_UART_Run(310);
+    u32Len = UART_BufRead(&s_sUart, au8Buf, sizeof(au8Buf));
+    printf("  read %u, overruns %u, dropped %u\n", u32Len, s_sUart.sStats.u32RxOverruns, s_sUart.sStats.u32RxDropped);
+    CHECK((u32Len == 0) && (s_sUart.sStats.u32RxOverruns == 1) && (s_sUart.sStats.u32RxDropped == 300), "overrun accounting");
+
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern + 300, 20);
+    SIM_UART_Run(20);
+    u32Len = UART_BufRead(&s_sUart, au8Buf, sizeof(au8Buf));
+    CHECK((u32Len == 20) && (memcmp(au8Buf, s_au8Pattern + 300, 20) == 0), "resync after the overrun");
+    SIM_UART_Run(10);
+}
+
+static void TestPdmaTx(void)
+{
+    uint8_t au8Wire[512];
+    uint32_t u32Len;
+
+    printf("\n[5] PDMA TX from the ring\n");
+    MakePattern(4);
+    s_au32Events[2] = 0;
+    u32Len = UART_BufWrite(&s_sUart, s_au8Pattern, 200);
+    CHECK((u32Len == 200) && (UART_BufTxSpace(&s_sUart) == TX_SIZE - 200), "queue 200");
+    SIM_UART_Run(100);
+    CHECK(UART_BufTxSpace(&s_sUart) == TX_SIZE - 200, "space freed before the run completed");
+    SIM_UART_Run(100);
+    CHECK(s_au32Events[2] == 1, "TX empty after the first run");
+
+    /* The next write wraps the ring: two runs */
+    s_au32Events[2] = 0;
+    u32Len = UART_BufWrite(&s_sUart, s_au8Pattern + 200, 300);
+    printf("  second write took %u, refused %u\n", u32Len, s_sUart.sStats.u32TxRefused);
+    CHECK(s_sUart.sStats.u32TxRefused == 300 - u32Len, "refused count");
+    CHECK(s_au32Events[2] == 0, "TX empty while sending");
+
+    SIM_UART_Run(500);
+    u32Len = SIM_UART_Drain(SIM_UART_UART0, au8Wire, sizeof(au8Wire));
+    printf("  wire %u bytes, PDMA runs %u, TX empty events %u\n", u32Len, s_sUart.sStats.u32TxDmaRuns, s_au32Events[2]);
+    CHECK((u32Len == 200 + 300 - s_sUart.sStats.u32TxRefused) && (memcmp(au8Wire, s_au8Pattern, u32Len) == 0), "wire data");
+    CHECK(s_au32Events[2] == 1, "one TX empty event");
+    CHECK((UART_BufTxPending(&s_sUart) == 0) && (s_sUart.sStats.u32TxDmaRuns == 3), "ring drained in contiguous runs");
+}
+
+static void TestErrors(void)
+{
+    UART_BUF_STATS_T *psStats = &s_sUart.sStats;
+    uint8_t au8Buf[64];
+
+    printf("\n[6] Line errors and FIFO overrun with PDMA RX\n");
+    UART_BufClearStats(&s_sUart);
+    MakePattern(5);
+
+    SIM_UART_InjectError(SIM_UART_UART0, SIM_UART_ERR_PARITY);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 1);
+    SIM_UART_Run(2);
+    SIM_UART_InjectError(SIM_UART_UART0, SIM_UART_ERR_FRAME);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 1);
+    SIM_UART_Run(2);
+    SIM_UART_InjectError(SIM_UART_UART0, SIM_UART_ERR_BREAK | SIM_UART_ERR_FRAME);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 1);
+    SIM_UART_Run(2);
+
+    /* Nobody serves the FIFO for 20 characters */
+    SIM_UART_Stall(SIM_UART_UART0, 1);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 20);
+    SIM_UART_Run(20);
+    SIM_UART_Stall(SIM_UART_UART0, 0);
+    SIM_UART_Run(10);
+
+    printf("  parity %u, frame %u, break %u, FIFO overrun %u\n",
+           psStats->u32ParityErrs, psStats->u32FrameErrs, psStats->u32Breaks, psStats->u32FifoOverruns);
+    CHECK((psStats->u32ParityErrs == 1) && (psStats->u32FrameErrs == 2) && (psStats->u32Breaks == 1), "line errors");
+    CHECK(psStats->u32FifoOverruns == 1, "FIFO overrun");
+    CHECK(UART_BufRead(&s_sUart, au8Buf, sizeof(au8Buf)) == 3 + 16, "bytes kept by the FIFO");
+    CHECK((UART0->FIFOSTS & (UART_FIFOSTS_PEF_Msk | UART_FIFOSTS_FEF_Msk | UART_FIFOSTS_BIF_Msk | UART_FIFOSTS_RXOVIF_Msk)) == 0,
+          "flags left set");
+}
+
+static void TestFifoMode(void)
+{
+    uint8_t au8Wire[512];
+    uint32_t u32Len;
+
+    printf("\n[7] No PDMA: RX and TX by FIFO interrupts\n");
+    CloseUart();
+    CHECK((PDMA0->CHCTL == 0) && (s_sSvc.u32ChUsed == 0) && (s_sSvc.u32ChDirect == 0), "channels left allocated");
+    CHECK(OpenUart(UART_BUF_NO_PDMA, UART_BUF_NO_PDMA, RX_SIZE) == 0, "open");
+    MakePattern(6);
+
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 37);
+    SIM_UART_Run(37);
+    printf("  after the frame: %u in the ring\n", UART_BufRxCount(&s_sUart));
+    CHECK(UART_BufRxCount(&s_sUart) == 32, "ring holds the trigger level multiples");
+    SIM_UART_Run(5);
+    u32Len = UART_BufRead(&s_sUart, s_au8Got, sizeof(s_au8Got));
+    printf("  after the time-out: read %u, idle events %u\n", u32Len, s_au32Events[0]);
+    CHECK((u32Len == 37) && (memcmp(s_au8Got, s_au8Pattern, 37) == 0), "frame tail collected by the time-out");
+    CHECK(s_au32Events[0] == 1, "idle event");
+
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, 300);
+    SIM_UART_Run(310);
+    u32Len = UART_BufRead(&s_sUart, s_au8Got, sizeof(s_au8Got));
+    printf("  300 bytes unread: read %u, overruns %u, dropped %u, half events %u\n",
+           u32Len, s_sUart.sStats.u32RxOverruns, s_sUart.sStats.u32RxDropped, s_au32Events[1]);
+    CHECK((u32Len == RX_SIZE) && (memcmp(s_au8Got, s_au8Pattern, RX_SIZE) == 0), "oldest bytes kept");
+    CHECK(s_sUart.sStats.u32RxDropped == 300 - RX_SIZE, "dropped count");
+    CHECK(s_au32Events[1] >= 2, "half ring events");
+
+    u32Len = UART_BufWrite(&s_sUart, s_au8Pattern, 100);
+    SIM_UART_Run(120);
+    u32Len = SIM_UART_Drain(SIM_UART_UART0, au8Wire, sizeof(au8Wire));
+    printf("  TX wire %u bytes, TX empty events %u, THREIEN %u\n", u32Len, s_au32Events[2],
+           (UART0->INTEN & UART_INTEN_THREIEN_Msk) ? 1 : 0);
+    CHECK((u32Len == 100) && (memcmp(au8Wire, s_au8Pattern, 100) == 0), "wire data");
+    CHECK(s_au32Events[2] == 1, "one TX empty event");
+    CHECK(!(UART0->INTEN & UART_INTEN_THREIEN_Msk), "THRE interrupt left on");
+    CloseUart();
+}
+
+static void TestUsci(void)
+{
+    UART_BUF_CFG_T sCfg;
+    uint8_t au8Wire[256];
+    uint32_t u32Len;
+
+    printf("\n[8] USCI0: PDMA RX, interrupt TX\n");
+    memset(&sCfg, 0, sizeof(sCfg));
+    sCfg.uuart = UUART0;
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32RxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.u32TxChFlags = UART_BUF_NO_PDMA;
+    sCfg.pu8RxBuf = s_psMem->au8UsciRx;
+    sCfg.u32RxSize = RX_SIZE;
+    sCfg.pu8TxBuf = s_psMem->au8UsciTx;
+    sCfg.u32TxSize = TX_SIZE;
+    sCfg.psRxDesc = s_psMem->asUsciDesc;
+    sCfg.pfnEvent = OnEvent;
+    memset(s_au32Events, 0, sizeof(s_au32Events));
+    s_u32UsciOpen = (UART_BufOpen(&s_sUsci, &sCfg) == 0);
+    CHECK(s_u32UsciOpen, "open");
+    CHECK(SIM_PDMA_GetReqSrc(s_sUsci.u32RxCh) == PDMA_USCI0_RX, "RX request source");
+    MakePattern(7);
+
+    SIM_UART_Feed(SIM_UART_USCI0, s_au8Pattern, 150);
+    SIM_UART_InjectError(SIM_UART_USCI0, SIM_UART_ERR_PARITY);
+    SIM_UART_Run(160);
+    u32Len = UART_BufRead(&s_sUsci, s_au8Got, sizeof(s_au8Got));
+    printf("  read %u, parity errors %u, idle events %u\n", u32Len, s_sUsci.sStats.u32ParityErrs, s_au32Events[0]);
+    CHECK((u32Len == 150) && (memcmp(s_au8Got, s_au8Pattern, 150) == 0), "RX data");
+    CHECK(s_sUsci.sStats.u32ParityErrs == 1, "parity error");
+    CHECK(s_au32Events[0] == 0, "USCI has no time-out");
+
+    u32Len = UART_BufWrite(&s_sUsci, s_au8Pattern, 90);
+    SIM_UART_Run(100);
+    u32Len = SIM_UART_Drain(SIM_UART_USCI0, au8Wire, sizeof(au8Wire));
+    printf("  TX wire %u bytes, TX empty events %u\n", u32Len, s_au32Events[2]);
+    CHECK((u32Len == 90) && (memcmp(au8Wire, s_au8Pattern, 90) == 0), "TX data");
+    CHECK(s_au32Events[2] == 1, "one TX empty event");
+
+    UART_BufClose(&s_sUsci);
+    s_u32UsciOpen = 0;
+}
+
+static void TestBurst(void)
+{
+    uint32_t u32Got = 0, u32Len, u32Polls = 0;
+
+    printf("\n[9] %u bytes back to back, consumer polls every 400 characters\n", BURST_LEN);
+    CHECK(OpenUart(PDMA_SVC_CH_ANY, PDMA_SVC_CH_ANY, BURST_RX_SIZE) == 0, "open");
+    MakePattern(8);
+    SIM_UART_Feed(SIM_UART_UART0, s_au8Pattern, BURST_LEN);
+
+    while (u32Got < BURST_LEN)
+    {
+        SIM_UART_Run(400);
+        u32Len = UART_BufRead(&s_sUart, s_au8Got + u32Got, BURST_LEN - u32Got);
+        u32Got += u32Len;
+
+        if ((u32Len == 0) || (++u32Polls > 1000))
+            break;
+    }
+
+    /* 400 characters is 1.3 ms at 3 Mbps */
+    printf("  read %u in %u polls, overruns %u, FIFO overruns %u, idle events %u\n", u32Got, u32Polls,
+           s_sUart.sStats.u32RxOverruns, s_sUart.sStats.u32FifoOverruns, s_au32Events[0]);
+    CHECK((u32Got == BURST_LEN) && (memcmp(s_au8Got, s_au8Pattern, BURST_LEN) == 0), "burst data");
+    CHECK((s_sUart.sStats.u32RxOverruns == 0) && (s_sUart.sStats.u32FifoOverruns == 0), "loss");
+    CloseUart();
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("Ring-buffered UART", SimInit) != 0)
+        return 1;
+
+    TestConfig();
+    TestPdmaRx();
+    TestPdmaWrap();
+    TestPdmaOverrun();
+    TestPdmaTx();
+    TestErrors();
+    TestFifoMode();
+    TestUsci();
+    TestBurst();
+
+    printf("\nRegister traps: %u\n", HOSTSIM_GetTrapCount());
+    return HOSTSIM_TestEnd();
+}
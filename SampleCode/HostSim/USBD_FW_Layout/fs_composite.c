@@ -0,0 +1,24 @@
+/**************************************************************************//**
+ * @file     fs_composite.c
+ * @version  V1.00
+ * @brief    USBD VCOM + HID + MSC composite. 464 of the 512 SRAM bytes are
+ *           needed at depth 1, no AUTO endpoint gets a second packet.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include "NuMicro.h"
+#include "layout_tables.h"
+
+#define FS_COMPOSITE_EP(X) \
+    X(VCOM_IN,  EP2, 0x81, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+    X(VCOM_OUT, EP3, 0x02, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+    X(VCOM_INT, EP4, 0x83, USBD_FW_EP_INT,   8, 1,                  0) \
+    X(HID_IN,   EP5, 0x84, USBD_FW_EP_INT,  64, 1,                  1) \
+    X(HID_OUT,  EP6, 0x05, USBD_FW_EP_INT,  64, 1,                  1) \
+    X(MSC_IN,   EP7, 0x86, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 2) \
+    X(MSC_OUT,  EP8, 0x07, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 2)
+
+USBD_FW_LAYOUT(FS_COMPOSITE_EP, 64);
+
+LAYOUT_EXPORT(g_sFsComposite, FS_COMPOSITE_EP, 64, 0);
@@ -0,0 +1,23 @@
+/**************************************************************************//**
+ * @file     fs_vcom_hid.c
+ * @version  V1.00
+ * @brief    USBD VCOM + HID. The VCOM bulk pair is double buffered, HID IN
+ *           does not fit a second packet any more and is passed over for the
+ *           8 byte VCOM interrupt endpoint listed after it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include "NuMicro.h"
+#include "layout_tables.h"
+
+#define FS_VCOM_HID_EP(X) \
+    X(VCOM_IN,  EP2, 0x81, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+    X(VCOM_OUT, EP3, 0x02, USBD_FW_EP_BULK, 64, USBD_FW_DEPTH_AUTO, 0) \
+    X(HID_IN,   EP5, 0x84, USBD_FW_EP_INT,  64, USBD_FW_DEPTH_AUTO, 1) \
+    X(HID_OUT,  EP6, 0x05, USBD_FW_EP_INT,  64, 1,                  1) \
+    X(VCOM_INT, EP4, 0x83, USBD_FW_EP_INT,   8, USBD_FW_DEPTH_AUTO, 0)
+
+USBD_FW_LAYOUT(FS_VCOM_HID_EP, 64);
+
+LAYOUT_EXPORT(g_sFsVcomHid, FS_VCOM_HID_EP, 64, 0);
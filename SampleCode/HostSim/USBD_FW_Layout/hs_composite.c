@@ -0,0 +1,25 @@
+/**************************************************************************//**
+ * @file     hs_composite.c
+ * @version  V1.00
+ * @brief    HSUSBD MSC + VCOM + HID. Three of the four 512 byte bulk
+ *           endpoints get a second packet, the last one does not fit.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#define USBD_FW_HSUSBD
+#include "NuMicro.h"
+#include "layout_tables.h"
+
+#define HS_COMPOSITE_EP(X) \
+    X(MSC_IN,   EPA, 0x81, USBD_FW_EP_BULK, 512, USBD_FW_DEPTH_AUTO, 0) \
+    X(MSC_OUT,  EPB, 0x02, USBD_FW_EP_BULK, 512, USBD_FW_DEPTH_AUTO, 0) \
+    X(VCOM_IN,  EPC, 0x83, USBD_FW_EP_BULK, 512, USBD_FW_DEPTH_AUTO, 1) \
+    X(VCOM_OUT, EPD, 0x04, USBD_FW_EP_BULK, 512, USBD_FW_DEPTH_AUTO, 1) \
+    X(VCOM_INT, EPE, 0x85, USBD_FW_EP_INT,   16, 1,                  1) \
+    X(HID_IN,   EPF, 0x86, USBD_FW_EP_INT,   64, 1,                  2) \
+    X(HID_OUT,  EPG, 0x07, USBD_FW_EP_INT,   64, 1,                  2)
+
+USBD_FW_LAYOUT(HS_COMPOSITE_EP, 64);
+
+LAYOUT_EXPORT(g_sHsComposite, HS_COMPOSITE_EP, 64, 1);
@@ -0,0 +1,57 @@
+/**************************************************************************//**
+ * @file     layout_tables.h
+ * @version  V1.00
+ * @brief    Endpoint tables laid out by USBD_FW_LAYOUT(), one per file.
+ *
+ * @details  USBD_FW_LAYOUT() defines enumerators, so each table lives in its
+ *           own translation unit and is exported together with the request
+ *           it was made from for main.c to check.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __LAYOUT_TABLES_H__
+#define __LAYOUT_TABLES_H__
+
+#include "usbd_fw.h"
+
+/* What a table entry asked for */
+typedef struct
+{
+    const char *pcName;
+    uint8_t  u8HwEp;
+    uint8_t  u8Addr;
+    uint8_t  u8Type;
+    uint8_t  u8Depth;
+    uint8_t  u8Func;
+    uint16_t u16MaxPkt;
+} LAYOUT_SPEC_T;
+
+typedef struct
+{
+    const char *pcName;
+    const USBD_FW_EP_T *psEp;       /* computed at compile time */
+    const LAYOUT_SPEC_T *psSpec;
+    uint32_t u32EpNum;
+    uint32_t u32CtrlMaxPkt;
+    uint32_t u32Used;
+    uint32_t u32SramSize;
+    uint32_t u32Align;
+    uint32_t u32MaxDepth;
+    uint32_t u32Hs;
+} LAYOUT_T;
+
+#define LAYOUT_X_SPEC(name, hw, addr, type, mps, depth, func) \
+    { #name, (uint8_t)(hw), (uint8_t)(addr), (uint8_t)(type), (uint8_t)(depth), (uint8_t)(func), (uint16_t)(mps) },
+
+#define LAYOUT_EXPORT(VAR, TABLE, CTRLMPS, HS) \
+    USBD_FW_EP_DEFINE(VAR##_Ep, TABLE); \
+    static const LAYOUT_SPEC_T VAR##_Spec[] = { TABLE(LAYOUT_X_SPEC) }; \
+    const LAYOUT_T VAR = { #VAR, VAR##_Ep, VAR##_Spec, USBD_FW_EP_NUM, (CTRLMPS), USBD_FW_SRAM_USED, \
+                           USBD_FW_SRAM_SIZE, USBD_FW_BUF_ALIGN, USBD_FW_MAX_DEPTH, (HS) }
+
+extern const LAYOUT_T g_sFsComposite;
+extern const LAYOUT_T g_sFsVcomHid;
+extern const LAYOUT_T g_sHsComposite;
+
+#endif  /* __LAYOUT_TABLES_H__ */
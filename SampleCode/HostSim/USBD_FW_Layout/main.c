@@ -0,0 +1,420 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Host check of the descriptor-table USB device framework
+ *           (Library/UsbDeviceLib/src_fw).
+ *
+ * @details  Build and run on an x86-64 Linux host (no board required):
+ *
+ *           gcc -O2 -w -std=gnu99 -include ../common/hostsim_cmsis.h -I../common
+ *               -I../../../Library/StdDriver/inc -I../../../Library/CMSIS/Include
+ *               -I../../../Library/Device/Nuvoton/m460/Include
+ *               -I../../../Library/UsbDeviceLib/inc
+ *               main.c fs_composite.c fs_vcom_hid.c hs_composite.c ../common/hostsim.c
+ *               ../../../Library/StdDriver/src/usbd.c
+ *               ../../../Library/UsbDeviceLib/src_fw/usbd_fw.c
+ *               ../../../Library/UsbDeviceLib/src_fw/usbd_fw_port.c
+ *               -o usbd_fw_layout
+ *           ./usbd_fw_layout
+ *
+ *           1. Layout: the three tables were laid out by the compiler; each
+ *              is recomputed here the slow way (first fit of the AUTO
+ *              endpoints in table order) and checked for alignment, overlap
+ *              and SRAM size.
+ *           2. Dispatch: class requests of a VCOM + HID + MSC composite are
+ *              routed through the function tables by interface, endpoint
+ *              and device recipient, with stalls for what nobody handles.
+ *           3. USBD port: with the USBD register window mapped into the
+ *              process, the endpoint registers programmed by USBD_FW_Init()
+ *              are compared with the table and the double buffer is run
+ *              through USBD_FW_EpBuf()/USBD_FW_EpSubmit() and the interrupt
+ *              handler.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "hostsim_test.h"
+#include "layout_tables.h"
+
+#define ROUND(n, a)     ((((n) + (a) - 1) / (a)) * (a))
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* 1. Layout                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static void CheckLayout(const LAYOUT_T *psL)
+{
+    uint32_t u32Ctrl, u32Min, u32Extra = 0, u32Base, u32Pairs = 0, u32Depth, u32Pkt, i, j;
+    const LAYOUT_SPEC_T *psS;
+    const USBD_FW_EP_T *psE;
+
+    printf("%s: %s, %u of %u bytes\n", psL->pcName, psL->u32Hs ? "HSUSBD" : "USBD", psL->u32Used, psL->u32SramSize);
+
+    u32Ctrl = ROUND(psL->u32CtrlMaxPkt, psL->u32Align) + (psL->u32Hs ? 0 : 8);
+    u32Min = u32Ctrl;
+    for (i = 0; i < psL->u32EpNum; i++)
+        u32Min += ROUND(psL->psSpec[i].u16MaxPkt, psL->u32Align) * (psL->psSpec[i].u8Depth ? psL->psSpec[i].u8Depth : 1);
+
+    u32Base = u32Ctrl;
+    printf("  %-10s %4s %4s %4s %5s %6s %5s\n", "endpoint", "hw", "hw2", "addr", "depth", "base", "len");
+    printf("  %-10s %4s %4s %4s %5s %6u %5u\n", "control", "-", "-", "-", "-", 0u, u32Ctrl);
+    for (i = 0; i < psL->u32EpNum; i++)
+    {
+        psS = &psL->psSpec[i];
+        psE = &psL->psEp[i];
+        u32Pkt = ROUND(psS->u16MaxPkt, psL->u32Align);
+
+        u32Depth = psS->u8Depth;
+        if (u32Depth == USBD_FW_DEPTH_AUTO)
+        {
+            u32Depth = 1;
+            if (u32Min + u32Extra + u32Pkt <= psL->u32SramSize)
+            {
+                u32Depth = 2;
+                u32Extra += u32Pkt;
+            }
+        }
+
+        printf("  %-10s %4u %4d %#4x %5u %#6x %5u\n", psS->pcName, psE->u8HwEp,
+               (psE->u8HwEp2 == USBD_FW_NO_EP) ? -1 : psE->u8HwEp2, psE->u8Addr, psE->u8Depth, psE->u16Base, psE->u16Len);
+
+        CHECK(psE->u8HwEp == psS->u8HwEp && psE->u8Addr == psS->u8Addr && psE->u8Type == psS->u8Type &&
+              psE->u8Func == psS->u8Func && psE->u16MaxPkt == psS->u16MaxPkt, "table fields");
+        CHECK(psE->u8Depth == u32Depth, "depth differs from first fit");
+        CHECK(psE->u16Base == u32Base, "base differs from packed order");
+        CHECK(psE->u16Len == u32Pkt * u32Depth, "length");
+        CHECK((psE->u16Base % psL->u32Align) == 0, "alignment");
+        CHECK(psE->u16Base + psE->u16Len <= psL->u32SramSize, "outside the SRAM");
+
+        if (!psL->u32Hs && (u32Depth == 2))
+            CHECK(psE->u8HwEp2 == USBD_MAX_EP - 1 - u32Pairs++, "second hardware endpoint");
+        else
+            CHECK(psE->u8HwEp2 == USBD_FW_NO_EP, "unexpected second hardware endpoint");
+
+        for (j = 0; j < i; j++)
+            CHECK((psE->u16Base >= psL->psEp[j].u16Base + psL->psEp[j].u16Len) ||
+                  (psE->u16Base + psE->u16Len <= psL->psEp[j].u16Base), "buffers overlap");
+
+        u32Base += u32Pkt * u32Depth;
+    }
+    CHECK(psL->u32Used == u32Base, "SRAM used");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* 2. Dispatch                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+static struct
+{
+    uint32_t u32In, u32InLen, u32Out, u32OutLen, u32Ack, u32Stall;
+} s_sPort;
+
+static void FakeCtrlIn(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    (void)pu8Buf;
+    s_sPort.u32In++;
+    s_sPort.u32InLen = u32Len;
+}
+static void FakeCtrlOut(uint8_t *pu8Buf, uint32_t u32Len)
+{
+    (void)pu8Buf;
+    s_sPort.u32Out++;
+    s_sPort.u32OutLen = u32Len;
+}
+static void FakeCtrlAck(void)
+{
+    s_sPort.u32Ack++;
+}
+static void FakeCtrlStall(void)
+{
+    s_sPort.u32Stall++;
+}
+
+static const USBD_FW_PORT_T s_sFakePort = { FakeCtrlIn, FakeCtrlOut, FakeCtrlAck, FakeCtrlStall };
+
+/* What the classes saw */
+typedef struct
+{
+    uint32_t u32Req;
+    uint8_t  u8LastReq;
+    uint32_t u32EpEvents;
+    uint32_t u32LastEp;
+    uint32_t u32CtrlOutDone;
+    uint32_t u32Reset;
+    uint32_t u32AltIf;
+    uint8_t  au8Data[64];
+} CLASS_LOG_T;
+
+static CLASS_LOG_T s_asLog[3];
+
+#define LOG(psFunc)     ((CLASS_LOG_T *)(psFunc)->pvCtx)
+
+static int32_t ReqIn(USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    LOG(psFunc)->u32Req++;
+    LOG(psFunc)->u8LastReq = psSetup->bRequest;
+    USBD_FW_CtrlIn(psFunc, LOG(psFunc)->au8Data, sizeof(LOG(psFunc)->au8Data));
+    return 0;
+}
+
+static int32_t ReqOut(USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    LOG(psFunc)->u32Req++;
+    LOG(psFunc)->u8LastReq = psSetup->bRequest;
+    USBD_FW_CtrlOut(psFunc, LOG(psFunc)->au8Data, 7);
+    return 0;
+}
+
+static int32_t ReqAck(USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    LOG(psFunc)->u32Req++;
+    LOG(psFunc)->u8LastReq = psSetup->bRequest;
+    USBD_FW_CtrlAck(psFunc);
+    return 0;
+}
+
+static int32_t ReqRefuse(USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    (void)psSetup;
+    LOG(psFunc)->u32Req++;
+    return -1;
+}
+
+static void OnEpEvent(USBD_FW_FUNC_T *psFunc, uint32_t u32Ep, uint32_t u32IntSts)
+{
+    (void)u32IntSts;
+    LOG(psFunc)->u32EpEvents++;
+    LOG(psFunc)->u32LastEp = u32Ep;
+}
+
+static void OnCtrlOutDone(USBD_FW_FUNC_T *psFunc, const USBD_FW_SETUP_T *psSetup)
+{
+    (void)psSetup;
+    LOG(psFunc)->u32CtrlOutDone++;
+}
+
+static void OnReset(USBD_FW_FUNC_T *psFunc)
+{
+    LOG(psFunc)->u32Reset++;
+}
+
+static void OnSetInterface(USBD_FW_FUNC_T *psFunc, uint32_t u32IfNum, uint32_t u32AltIf)
+{
+    LOG(psFunc)->u32AltIf = (u32IfNum << 8) | u32AltIf;
+}
+
+static const USBD_FW_REQ_T s_asVcomReq[] =
+{
+    { USBD_FW_REQ_IN  | USBD_FW_REQ_CLASS, 0x21, ReqIn  },     /* GET_LINE_CODE */
+    { USBD_FW_REQ_OUT | USBD_FW_REQ_CLASS, 0x20, ReqOut },     /* SET_LINE_CODE */
+    { USBD_FW_REQ_OUT | USBD_FW_REQ_CLASS, 0x22, ReqAck },     /* SET_CONTROL_LINE_STATE */
+};
+
+static const USBD_FW_REQ_T s_asHidReq[] =
+{
+    { USBD_FW_REQ_IN  | USBD_FW_REQ_CLASS, 0x01, ReqIn     },  /* GET_REPORT */
+    { USBD_FW_REQ_OUT | USBD_FW_REQ_CLASS, 0x0A, ReqAck    },  /* SET_IDLE */
+    { USBD_FW_REQ_OUT | USBD_FW_REQ_CLASS, 0x0B, ReqRefuse },  /* SET_PROTOCOL, refused */
+};
+
+static const USBD_FW_REQ_T s_asMscReq[] =
+{
+    { USBD_FW_REQ_IN  | USBD_FW_REQ_CLASS,  0xFE, ReqIn  },    /* GET_MAX_LUN */
+    { USBD_FW_REQ_OUT | USBD_FW_REQ_CLASS,  0xFF, ReqAck },    /* Bulk-only reset */
+    { USBD_FW_REQ_IN  | USBD_FW_REQ_VENDOR, 0x55, ReqIn  },    /* vendor, device recipient */
+};
+
+static const USBD_FW_CLASS_T s_sVcomClass = { s_asVcomReq, 3, OnReset, OnEpEvent, OnCtrlOutDone, OnSetInterface, NULL };
+static const USBD_FW_CLASS_T s_sHidClass  = { s_asHidReq,  3, OnReset, OnEpEvent, NULL,          NULL,           NULL };
+static const USBD_FW_CLASS_T s_sMscClass  = { s_asMscReq,  3, OnReset, OnEpEvent, NULL,          OnSetInterface, NULL };
+
+static USBD_FW_FUNC_T s_sVcom = { &s_sVcomClass, 0, 2, { 0 }, &s_asLog[0], NULL };
+static USBD_FW_FUNC_T s_sHid  = { &s_sHidClass,  2, 1, { 0 }, &s_asLog[1], NULL };
+static USBD_FW_FUNC_T s_sMsc  = { &s_sMscClass,  3, 1, { 0 }, &s_asLog[2], NULL };
+
+static USBD_FW_FUNC_T *const s_apsFunc[] = { &s_sVcom, &s_sHid, &s_sMsc };
+
+static void Setup(USBD_FW_DEV_T *psDev, uint8_t u8Type, uint8_t u8Req, uint16_t u16Index, uint16_t u16Length)
+{
+    uint8_t au8Setup[8] = { u8Type, u8Req, 0, 0, (uint8_t)u16Index, (uint8_t)(u16Index >> 8),
+                            (uint8_t)u16Length, (uint8_t)(u16Length >> 8)
+                          };
+
+    memset(&s_sPort, 0, sizeof(s_sPort));
+    USBD_FW_Setup(psDev, au8Setup);
+}
+
+static void CheckDispatch(void)
+{
+    static USBD_FW_DEV_T s_sDev;
+    USBD_FW_EP_T asBad[2];
+
+    printf("dispatch: VCOM(if 0-1) + HID(if 2) + MSC(if 3) on g_sFsComposite\n");
+    memset(s_asLog, 0, sizeof(s_asLog));
+    CHECK(USBD_FW_Bind(&s_sDev, &s_sFakePort, g_sFsComposite.psEp, g_sFsComposite.u32EpNum, s_apsFunc, 3) == 0, "bind");
+    CHECK(s_sVcom.psDev == &s_sDev, "function not attached");
+
+    /* Interface recipient */
+    Setup(&s_sDev, 0xA1, 0x21, 1, 7);
+    CHECK(s_asLog[0].u32Req == 1 && s_asLog[0].u8LastReq == 0x21, "GET_LINE_CODE to VCOM (if 1)");
+    CHECK(s_sPort.u32In == 1 && s_sPort.u32InLen == 7, "data stage cut to wLength");
+
+    Setup(&s_sDev, 0xA1, 0xFE, 3, 1);
+    CHECK(s_asLog[2].u32Req == 1 && s_sPort.u32InLen == 1 && s_sPort.u32Stall == 0, "GET_MAX_LUN to MSC");
+
+    Setup(&s_sDev, 0xA1, 0xFE, 0, 1);
+    CHECK(s_sPort.u32Stall == 1 && s_asLog[0].u32Req == 1, "GET_MAX_LUN on VCOM not stalled");
+
+    Setup(&s_sDev, 0x21, 0x0A, 2, 0);
+    CHECK(s_asLog[1].u32Req == 1 && s_sPort.u32Ack == 1, "SET_IDLE to HID");
+
+    Setup(&s_sDev, 0x21, 0x0B, 2, 0);
+    CHECK(s_asLog[1].u32Req == 2 && s_sPort.u32Stall == 1, "refused request not stalled");
+
+    Setup(&s_sDev, 0x21, 0x22, 9, 0);
+    CHECK(s_sPort.u32Stall == 1, "request to a missing interface not stalled");
+
+    /* Host to device with data stage */
+    Setup(&s_sDev, 0x21, 0x20, 0, 7);
+    CHECK(s_sPort.u32Out == 1 && s_sPort.u32OutLen == 7 && s_asLog[0].u32CtrlOutDone == 0, "SET_LINE_CODE data stage");
+    USBD_FW_CtrlOutDone(&s_sDev);
+    CHECK(s_asLog[0].u32CtrlOutDone == 1, "control OUT done not delivered");
+    USBD_FW_CtrlOutDone(&s_sDev);
+    CHECK(s_asLog[0].u32CtrlOutDone == 1, "control OUT done delivered twice");
+
+    /* Endpoint recipient: wIndex is the address of MSC_IN */
+    Setup(&s_sDev, 0x22, 0xFF, 0x86, 0);
+    CHECK(s_asLog[2].u32Req == 2 && s_sPort.u32Ack == 1, "endpoint recipient not routed to MSC");
+
+    /* Device recipient: first function having the request */
+    Setup(&s_sDev, 0xC0, 0x55, 0, 4);
+    CHECK(s_asLog[2].u32Req == 3 && s_sPort.u32InLen == 4, "device vendor request not routed to MSC");
+    Setup(&s_sDev, 0xC0, 0x56, 0, 4);
+    CHECK(s_sPort.u32Stall == 1, "unknown device request not stalled");
+
+    /* Endpoint events by hardware endpoint */
+    USBD_FW_EpEvent(&s_sDev, EP7, 0);
+    CHECK(s_asLog[2].u32EpEvents == 1 && s_asLog[2].u32LastEp == 5, "EP7 event to MSC_IN");
+    USBD_FW_EpEvent(&s_sDev, EP4, 0);
+    CHECK(s_asLog[0].u32EpEvents == 1 && s_asLog[0].u32LastEp == 2, "EP4 event to VCOM_INT");
+    USBD_FW_EpEvent(&s_sDev, EP9, 0);
+    CHECK(s_asLog[0].u32EpEvents + s_asLog[1].u32EpEvents + s_asLog[2].u32EpEvents == 2, "EP9 event not dropped");
+
+    USBD_FW_SetInterface(&s_sDev, 3, 1);
+    CHECK(s_asLog[2].u32AltIf == 0x301, "SET_INTERFACE to MSC");
+    USBD_FW_Reset(&s_sDev);
+    CHECK(s_asLog[0].u32Reset == 1 && s_asLog[1].u32Reset == 1 && s_asLog[2].u32Reset == 1, "reset");
+
+    /* Tables that do not go together */
+    memcpy(asBad, g_sFsComposite.psEp, sizeof(asBad));
+    asBad[1].u8HwEp = asBad[0].u8HwEp;
+    CHECK(USBD_FW_Bind(&s_sDev, &s_sFakePort, asBad, 2, s_apsFunc, 3) == -1, "shared hardware endpoint accepted");
+    memcpy(asBad, g_sFsComposite.psEp, sizeof(asBad));
+    asBad[1].u8Func = 3;
+    CHECK(USBD_FW_Bind(&s_sDev, &s_sFakePort, asBad, 2, s_apsFunc, 3) == -1, "missing function accepted");
+    memcpy(asBad, g_sFsVcomHid.psEp, sizeof(asBad));
+    asBad[1].u8HwEp = asBad[0].u8HwEp2;
+    CHECK(USBD_FW_Bind(&s_sDev, &s_sFakePort, asBad, 2, s_apsFunc, 3) == -1, "second buffer on a table endpoint accepted");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* 3. USBD port                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static void UsbdEvent(uint32_t u32HwEp)
+{
+    USBD->INTSTS = USBD_INTSTS_USB;
+    USBD->EPINTSTS = 1ul << u32HwEp;
+    USBD->ATTR = 0;
+    USBD_FW_IRQHandler();
+}
+
+static void CheckUsbdPort(void)
+{
+    const USBD_FW_EP_T *psEp;
+    uint32_t i, u32VcomIn = 0, u32VcomOut = 1;
+    uint8_t *pu8First, *pu8Second;
+
+    printf("USBD port: g_sFsVcomHid on the mapped USBD registers\n");
+    memset(s_asLog, 0, sizeof(s_asLog));
+    memset((void *)USBD, 0, 0x800);
+
+    CHECK(USBD_FW_Init(g_sFsVcomHid.psEp, g_sFsVcomHid.u32EpNum, s_apsFunc, 2) == 0, "init");
+    CHECK(USBD_GET_EP_BUF_ADDR(EP0) == 8 && USBD_GET_EP_BUF_ADDR(EP1) == 8 && USBD->STBUFSEG == 0, "control buffers");
+
+    for (i = 0; i < g_sFsVcomHid.u32EpNum; i++)
+    {
+        psEp = &g_sFsVcomHid.psEp[i];
+        CHECK(USBD_GET_EP_BUF_ADDR(psEp->u8HwEp) == psEp->u16Base, "BUFSEG");
+        CHECK((USBD->EP[psEp->u8HwEp].CFG & 0xF) == (psEp->u8Addr & 0xFul), "EPNUM");
+        if (psEp->u8HwEp2 != USBD_FW_NO_EP)
+        {
+            CHECK(USBD_GET_EP_BUF_ADDR(psEp->u8HwEp2) == psEp->u16Base + psEp->u16Len / 2, "BUFSEG of the second buffer");
+            CHECK(USBD_IS_DB_MODE(psEp->u8HwEp) && USBD_IS_DB_MODE(psEp->u8HwEp2), "double buffer not enabled");
+            CHECK((USBD->EP[psEp->u8HwEp2].CFG & 0xF) == (psEp->u8Addr & 0xFul), "EPNUM of the second buffer");
+        }
+        if ((psEp->u8Addr & 0x80) == 0)
+            CHECK(USBD_GET_PAYLOAD_LEN(psEp->u8HwEp) == psEp->u16MaxPkt, "OUT endpoint not armed");
+    }
+
+    /* Double buffered IN: two packets in flight, buffers alternate */
+    psEp = &g_sFsVcomHid.psEp[u32VcomIn];
+    CHECK(USBD_FW_EpInFree(u32VcomIn) == 2, "two IN buffers free");
+    pu8First = USBD_FW_EpBuf(u32VcomIn);
+    USBD_FW_EpSubmit(u32VcomIn, 10);
+    pu8Second = USBD_FW_EpBuf(u32VcomIn);
+    USBD_FW_EpSubmit(u32VcomIn, 20);
+    CHECK(pu8First == (uint8_t *)(USBD_BUF_BASE + psEp->u16Base) && pu8Second == pu8First + 64, "IN buffers do not alternate");
+    CHECK(USBD_GET_PAYLOAD_LEN(psEp->u8HwEp) == 10 && USBD_GET_PAYLOAD_LEN(psEp->u8HwEp2) == 20, "IN payloads");
+    CHECK(USBD_FW_EpInFree(u32VcomIn) == 0, "IN buffers not busy");
+
+    UsbdEvent(psEp->u8HwEp);
+    CHECK(USBD_FW_EpInFree(u32VcomIn) == 1 && s_asLog[0].u32EpEvents == 1 && s_asLog[0].u32LastEp == u32VcomIn, "IN done event");
+    CHECK(USBD_FW_EpBuf(u32VcomIn) == pu8First, "next IN buffer");
+    UsbdEvent(psEp->u8HwEp2);
+    CHECK(USBD_FW_EpInFree(u32VcomIn) == 2 && s_asLog[0].u32EpEvents == 2, "IN done event of the second buffer");
+
+    /* Double buffered OUT: the buffer follows the hardware endpoint of the event */
+    psEp = &g_sFsVcomHid.psEp[u32VcomOut];
+    USBD_SET_PAYLOAD_LEN(psEp->u8HwEp2, 33);
+    UsbdEvent(psEp->u8HwEp2);
+    CHECK(USBD_FW_EpBuf(u32VcomOut) == (uint8_t *)(USBD_BUF_BASE + psEp->u16Base + 64) && USBD_FW_EpRxLen(u32VcomOut) == 33,
+          "OUT packet in the second buffer");
+    USBD_FW_EpSubmit(u32VcomOut, 64);
+    CHECK(USBD_GET_PAYLOAD_LEN(psEp->u8HwEp2) == 64, "second OUT buffer not armed again");
+    UsbdEvent(psEp->u8HwEp);
+    CHECK(USBD_FW_EpBuf(u32VcomOut) == (uint8_t *)(USBD_BUF_BASE + psEp->u16Base), "OUT packet in the first buffer");
+
+    /* HID_IN (EP5) goes to the HID function */
+    UsbdEvent(EP5);
+    CHECK(s_asLog[1].u32EpEvents == 1 && s_asLog[1].u32LastEp == 2, "EP5 event to HID_IN");
+
+    /* Bus reset configures again and tells every function */
+    USBD->INTSTS = USBD_INTSTS_BUS;
+    USBD->ATTR = USBD_STATE_USBRST;
+    USBD_FW_IRQHandler();
+    CHECK(s_asLog[0].u32Reset == 1 && s_asLog[1].u32Reset == 1 && USBD_FW_EpInFree(u32VcomIn) == 2, "bus reset");
+}
+
+static int32_t SimInit(void)
+{
+    if ((HOSTSIM_Init() != HOSTSIM_OK) || (HOSTSIM_MapPeriph(USBD_BASE, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK))
+        return -1;
+
+    return 0;
+}
+
+int main(void)
+{
+    if (HOSTSIM_TestBegin("USB device framework", SimInit) != 0)
+        return 1;
+
+    CheckLayout(&g_sFsComposite);
+    CheckLayout(&g_sFsVcomHid);
+    CheckLayout(&g_sHsComposite);
+    CheckDispatch();
+    CheckUsbdPort();
+
+    return HOSTSIM_TestEnd();
+}
@@ -0,0 +1,315 @@
+/**************************************************************************//**
+ * @file     hostsim.c
+ * @version  V1.00
+ * @brief    Host-side peripheral simulation helpers.
+ *
+ * @note     Write trapping single-steps the faulting store with the x86 trap
+ *           flag and read trapping tells loads from stores by the page fault
+ *           error code, so this file only builds for x86/x86-64 Linux hosts.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "hostsim.h"
+
+#if !defined(__linux__) || !(defined(__x86_64__) || defined(__i386__))
+#error "HostSim register write trapping requires an x86/x86-64 Linux host"
+#endif
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define EFLAGS_TF   0x100ul
+#define PF_WRITE    0x2ul                   /* Page fault error code: the access was a store */
+
+/* Core clock seen by the drivers. The Cortex-M side defines it in system_m460.c. */
+uint32_t SystemCoreClock = 200000000ul;
+
+/* clk.c calls it after a clock change; the checks keep the value they set, or replace it */
+__attribute__((weak)) void SystemCoreClockUpdate(void)
+{
+}
+
+typedef struct
+{
+    uint32_t u32Base;
+    uint32_t u32Size;
+    int32_t  i32Prot;                   /* Protection while trapping */
+    HOSTSIM_WRITE_CB pfnWrite;
+    HOSTSIM_READ_CB pfnRead;
+    void    *pvPriv;
+} HOSTSIM_REGION_T;
+
+static HOSTSIM_REGION_T s_asRegion[HOSTSIM_MAX_REGIONS];
+static uint32_t s_u32RegionCnt;
+
+/* State carried from the write fault to the single-step trap */
+static HOSTSIM_REGION_T *s_psPending;
+static uint32_t s_u32PendingAddr;
+static uint32_t s_u32PendingOld;
+static uint32_t s_u32PendingWrite;
+static volatile uint32_t s_u32TrapCnt;
+
+static HOSTSIM_REGION_T *HOSTSIM_FindRegion(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32RegionCnt; i++)
+    {
+        if ((u32Addr >= s_asRegion[i].u32Base) && (u32Addr < s_asRegion[i].u32Base + s_asRegion[i].u32Size))
+            return &s_asRegion[i];
+    }
+
+    return NULL;
+}
+
+static void HOSTSIM_SegvHandler(int i32Sig, siginfo_t *psInfo, void *pvCtx)
+{
+    ucontext_t *psUc = (ucontext_t *)pvCtx;
+    uint32_t u32Addr = (uint32_t)(uintptr_t)psInfo->si_addr;
+    HOSTSIM_REGION_T *psRegion = HOSTSIM_FindRegion(u32Addr);
+
+    if ((psRegion == NULL) || ((uintptr_t)psInfo->si_addr >> 32))
+    {
+        /* Not a simulated register: let the default action dump core */
+        signal(i32Sig, SIG_DFL);
+        return;
+    }
+
+    s_psPending = psRegion;
+    s_u32PendingAddr = u32Addr & ~3ul;
+    s_u32PendingWrite = (psRegion->pfnRead == NULL) || (psUc->uc_mcontext.gregs[REG_ERR] & PF_WRITE);
+
+    /* Let the access execute once, then come back through SIGTRAP */
+    mprotect((void *)(uintptr_t)psRegion->u32Base, psRegion->u32Size, PROT_READ | PROT_WRITE);
+    s_u32PendingOld = *(volatile uint32_t *)(uintptr_t)s_u32PendingAddr;
+
+    if (!s_u32PendingWrite)
+        *(volatile uint32_t *)(uintptr_t)s_u32PendingAddr = psRegion->pfnRead(psRegion->pvPriv, s_u32PendingAddr - psRegion->u32Base, s_u32PendingOld);
+
+    psUc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+static void HOSTSIM_TrapHandler(int i32Sig, siginfo_t *psInfo, void *pvCtx)
+{
+    ucontext_t *psUc = (ucontext_t *)pvCtx;
+    HOSTSIM_REGION_T *psRegion = s_psPending;
+    volatile uint32_t *pu32Reg;
+
+    (void)i32Sig;
+    (void)psInfo;
+
+    psUc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+
+    if (psRegion == NULL)
+        return;
+
+    s_psPending = NULL;
+    s_u32TrapCnt++;
+
+    pu32Reg = (volatile uint32_t *)(uintptr_t)s_u32PendingAddr;
+
+    if (s_u32PendingWrite && psRegion->pfnWrite)
+        *pu32Reg = psRegion->pfnWrite(psRegion->pvPriv, s_u32PendingAddr - psRegion->u32Base, s_u32PendingOld, *pu32Reg);
+
+    mprotect((void *)(uintptr_t)psRegion->u32Base, psRegion->u32Size, psRegion->i32Prot);
+}
+
+/**
+ * @brief       Map a peripheral address window at its fixed address.
+ *
+ * @param[in]   u32Base     Physical base address on the M460, page aligned.
+ * @param[in]   u32Size     Window size in bytes.
+ *
+ * @retval      HOSTSIM_OK       Window mapped (or already mapped) and zero filled.
+ * @retval      HOSTSIM_ERR_MAP  The host address range is in use.
+ */
+int32_t HOSTSIM_MapPeriph(uint32_t u32Base, uint32_t u32Size)
+{
+    void *pvMap;
+
+    u32Size = (u32Size + HOSTSIM_PAGE_SIZE - 1) & ~(HOSTSIM_PAGE_SIZE - 1);
+    pvMap = mmap((void *)(uintptr_t)u32Base, u32Size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (pvMap == MAP_FAILED)
+        return HOSTSIM_ERR_MAP;
+
+    if ((uintptr_t)pvMap != (uintptr_t)u32Base)
+    {
+        /* Old kernels ignore MAP_FIXED_NOREPLACE and return a hint address */
+        munmap(pvMap, u32Size);
+        return HOSTSIM_ERR_MAP;
+    }
+
+    return HOSTSIM_OK;
+}
+
+/**
+ * @brief       Map the system windows every driver touches.
+ *
+ * @retval      HOSTSIM_OK       SYS/CLK and the Cortex-M System Control Space are mapped.
+ * @retval      HOSTSIM_ERR_MAP  Mapping failed.
+ *
+ * @details     Maps SYS/CLK (CLK->AHBCLKx, CLK->CLKDIVx) and the SCS page (NVIC,
+ *              SysTick, DWT is not modelled) and installs the trap handlers.
+ */
+int32_t HOSTSIM_Init(void)
+{
+    struct sigaction sAct;
+
+    if (HOSTSIM_MapPeriph(0x40000000ul, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK)
+        return HOSTSIM_ERR_MAP;
+
+    if (HOSTSIM_MapPeriph(0xE000E000ul, HOSTSIM_PAGE_SIZE) != HOSTSIM_OK)
+        return HOSTSIM_ERR_MAP;
+
+    memset(&sAct, 0, sizeof(sAct));
+    sAct.sa_flags = SA_SIGINFO;
+    sAct.sa_sigaction = HOSTSIM_SegvHandler;
+    sigaction(SIGSEGV, &sAct, NULL);
+    sAct.sa_sigaction = HOSTSIM_TrapHandler;
+    sigaction(SIGTRAP, &sAct, NULL);
+
+    return HOSTSIM_OK;
+}
+
+/**
+ * @brief       Write-protect a register window and route stores to a model.
+ *
+ * @param[in]   u32Base     Page aligned base of the already mapped window.
+ * @param[in]   u32Size     Window size in bytes, multiple of the page size.
+ * @param[in]   pfnWrite    Callback deciding the post-store register value.
+ * @param[in]   pvPriv      Model private pointer passed to pfnWrite.
+ *
+ * @retval      HOSTSIM_OK        Stores into the window are now trapped.
+ * @retval      HOSTSIM_ERR_FULL  All HOSTSIM_MAX_REGIONS slots are used.
+ *
+ * @details     Every store into the window costs two signals, so only the
+ *              register page should be trapped, not bulk memory.
+ */
+int32_t HOSTSIM_TrapWrites(uint32_t u32Base, uint32_t u32Size, HOSTSIM_WRITE_CB pfnWrite, void *pvPriv)
+{
+    HOSTSIM_REGION_T *psRegion;
+
+    if (s_u32RegionCnt >= HOSTSIM_MAX_REGIONS)
+        return HOSTSIM_ERR_FULL;
+
+    psRegion = &s_asRegion[s_u32RegionCnt++];
+    psRegion->u32Base = u32Base;
+    psRegion->u32Size = u32Size;
+    psRegion->i32Prot = PROT_READ;
+    psRegion->pfnWrite = pfnWrite;
+    psRegion->pfnRead = NULL;
+    psRegion->pvPriv = pvPriv;
+
+    mprotect((void *)(uintptr_t)u32Base, u32Size, PROT_READ);
+
+    return HOSTSIM_OK;
+}
+
+/**
+ * @brief       Route loads from a register window to a model as well.
+ *
+ * @param[in]   u32Base     Page aligned base of the already mapped window.
+ * @param[in]   u32Size     Window size in bytes, multiple of the page size.
+ * @param[in]   pfnRead     Callback supplying the value of each load.
+ * @param[in]   pvPriv      Model private pointer passed to pfnRead (and pfnWrite).
+ *
+ * @retval      HOSTSIM_OK        Loads and stores into the window are now trapped.
+ * @retval      HOSTSIM_ERR_FULL  All HOSTSIM_MAX_REGIONS slots are used.
+ *
+ * @details     A window already given to HOSTSIM_TrapWrites() keeps its write
+ *              callback. The model reads its own registers between
+ *              HOSTSIM_Unlock() and HOSTSIM_Lock() like it writes them.
+ */
+int32_t HOSTSIM_TrapReads(uint32_t u32Base, uint32_t u32Size, HOSTSIM_READ_CB pfnRead, void *pvPriv)
+{
+    HOSTSIM_REGION_T *psRegion = HOSTSIM_FindRegion(u32Base);
+
+    if (psRegion == NULL)
+    {
+        if (s_u32RegionCnt >= HOSTSIM_MAX_REGIONS)
+            return HOSTSIM_ERR_FULL;
+
+        psRegion = &s_asRegion[s_u32RegionCnt++];
+        psRegion->u32Base = u32Base;
+        psRegion->u32Size = u32Size;
+        psRegion->pfnWrite = NULL;
+    }
+
+    psRegion->i32Prot = PROT_NONE;
+    psRegion->pfnRead = pfnRead;
+    psRegion->pvPriv = pvPriv;
+
+    mprotect((void *)(uintptr_t)u32Base, u32Size, PROT_NONE);
+
+    return HOSTSIM_OK;
+}
+
+/**
+ * @brief       Allow the model itself to update a trapped window.
+ * @param[in]   u32Base     Base address given to HOSTSIM_TrapWrites().
+ */
+void HOSTSIM_Unlock(uint32_t u32Base)
+{
+    HOSTSIM_REGION_T *psRegion = HOSTSIM_FindRegion(u32Base);
+
+    if (psRegion)
+        mprotect((void *)(uintptr_t)psRegion->u32Base, psRegion->u32Size, PROT_READ | PROT_WRITE);
+}
+
+/**
+ * @brief       Re-arm write trapping after HOSTSIM_Unlock().
+ * @param[in]   u32Base     Base address given to HOSTSIM_TrapWrites().
+ */
+void HOSTSIM_Lock(uint32_t u32Base)
+{
+    HOSTSIM_REGION_T *psRegion = HOSTSIM_FindRegion(u32Base);
+
+    if (psRegion)
+        mprotect((void *)(uintptr_t)psRegion->u32Base, psRegion->u32Size, psRegion->i32Prot);
+}
+
+/**
+ * @brief       Monotonic host time stamp.
+ * @return      Nanoseconds.
+ */
+uint64_t HOSTSIM_GetNanoSec(void)
+{
+    struct timespec sTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTs);
+
+    return (uint64_t)sTs.tv_sec * 1000000000ull + (uint64_t)sTs.tv_nsec;
+}
+
+/**
+ * @brief       Number of trapped register stores so far.
+ * @return      Trap count.
+ */
+uint32_t HOSTSIM_GetTrapCount(void)
+{
+    return s_u32TrapCnt;
+}
+
+/**
+ * @brief       Core sleep of __WFI().
+ *
+ * @details     Returns at once, as if an interrupt were pending. A model of the
+ *              power modes (sim_pwr.c) replaces it to let time pass until the
+ *              next wake-up event.
+ */
+__attribute__((weak)) void HOSTSIM_WaitForInterrupt(void)
+{
+}
@@ -0,0 +1,67 @@
+/**************************************************************************//**
+ * @file     hostsim.h
+ * @version  V1.00
+ * @brief    Host-side peripheral simulation helpers.
+ *
+ * @details  Maps the M460 peripheral address windows into a Linux host process
+ *           at their real addresses so that the unmodified StdDriver sources can
+ *           be compiled natively and run against a software model. Register
+ *           pages that need write side effects (write-1-to-clear, add requests,
+ *           acknowledge registers ...) can be write-protected; every store into
+ *           them is trapped, executed and handed to the model as (old, new).
+ *           Registers with read side effects (FIFO data ports) can in addition
+ *           be read-protected, so that the model supplies the value of each load.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __HOSTSIM_H__
+#define __HOSTSIM_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define HOSTSIM_MAX_REGIONS     8       /*!< Maximum number of write-trapped register windows */
+#define HOSTSIM_PAGE_SIZE       0x1000ul
+
+#define HOSTSIM_OK              ( 0L)   /*!< Operation OK */
+#define HOSTSIM_ERR_MAP         (-1L)   /*!< Address window could not be mapped at its fixed address */
+#define HOSTSIM_ERR_FULL        (-2L)   /*!< No free write-trap region */
+
+/**
+  * @brief   Register write callback.
+  * @param[in] pvPriv     Model private data given at registration.
+  * @param[in] u32Offset  Byte offset of the written word inside the region.
+  * @param[in] u32Old     Register value before the store.
+  * @param[in] u32New     Value stored by the driver.
+  * @return  Value the register holds after the store (e.g. u32Old & ~u32New for write-1-to-clear).
+  */
+typedef uint32_t (*HOSTSIM_WRITE_CB)(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New);
+
+/**
+  * @brief   Register read callback.
+  * @param[in] pvPriv     Model private data given at registration.
+  * @param[in] u32Offset  Byte offset of the read word inside the region.
+  * @param[in] u32Cur     Value the register holds.
+  * @return  Value the load returns and the register keeps (e.g. the popped FIFO entry).
+  */
+typedef uint32_t (*HOSTSIM_READ_CB)(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur);
+
+int32_t  HOSTSIM_Init(void);
+int32_t  HOSTSIM_MapPeriph(uint32_t u32Base, uint32_t u32Size);
+int32_t  HOSTSIM_TrapWrites(uint32_t u32Base, uint32_t u32Size, HOSTSIM_WRITE_CB pfnWrite, void *pvPriv);
+int32_t  HOSTSIM_TrapReads(uint32_t u32Base, uint32_t u32Size, HOSTSIM_READ_CB pfnRead, void *pvPriv);
+void     HOSTSIM_Unlock(uint32_t u32Base);
+void     HOSTSIM_Lock(uint32_t u32Base);
+uint64_t HOSTSIM_GetNanoSec(void);
+uint32_t HOSTSIM_GetTrapCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOSTSIM_H__ */
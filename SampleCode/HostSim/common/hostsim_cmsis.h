@@ -0,0 +1,148 @@
+/**************************************************************************//**
+ * @file     hostsim_cmsis.h
+ * @version  V1.00
+ * @brief    CMSIS compiler layer for host builds of the StdDriver sources.
+ *
+ * @details  Force-included (gcc -include) ahead of NuMicro.h. It claims the
+ *           cmsis_gcc.h include guard so that no Cortex-M instruction reaches
+ *           the host assembler, and supplies the compiler abstraction macros
+ *           and core intrinsics used by core_cm4.h and the drivers.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __HOSTSIM_CMSIS_H__
+#define __HOSTSIM_CMSIS_H__
+
+/* Included before any system header: select the GNU feature set hostsim.c needs */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+
+#define __CMSIS_GCC_H
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    __attribute__((always_inline)) static inline
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT         struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION          union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+#define __COMPILER_BARRIER()    __ASM volatile("":::"memory")
+
+#define __UNALIGNED_UINT16_READ(addr)           (*(const uint16_t *)(addr))
+#define __UNALIGNED_UINT16_WRITE(addr, val)     ((void)(*(uint16_t *)(addr) = (val)))
+#define __UNALIGNED_UINT32_READ(addr)           (*(const uint32_t *)(addr))
+#define __UNALIGNED_UINT32_WRITE(addr, val)     ((void)(*(uint32_t *)(addr) = (val)))
+#define __UNALIGNED_UINT32(addr)                (*(uint32_t *)(addr))
+
+/* Wait for interrupt: hostsim.c returns at once, a power model lets time pass to the wake-up */
+void HOSTSIM_WaitForInterrupt(void);
+
+/* Barriers and hints only need to stop compiler reordering on the host */
+#define __NOP()                 __COMPILER_BARRIER()
+#define __WFI()                 HOSTSIM_WaitForInterrupt()
+#define __WFE()                 __COMPILER_BARRIER()
+#define __SEV()                 __COMPILER_BARRIER()
+#define __ISB()                 __COMPILER_BARRIER()
+#define __DSB()                 __COMPILER_BARRIER()
+#define __DMB()                 __COMPILER_BARRIER()
+#define __BKPT(value)           __builtin_trap()
+#define __CLZ                   __builtin_clz
+
+#define __enable_irq()          __COMPILER_BARRIER()
+#define __disable_irq()         __COMPILER_BARRIER()
+
+__STATIC_INLINE uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+__STATIC_INLINE void __set_PRIMASK(uint32_t u32PriMask)
+{
+    (void)u32PriMask;
+}
+
+__STATIC_INLINE uint32_t __get_IPSR(void)
+{
+    return 0;
+}
+
+__STATIC_INLINE uint32_t __RBIT(uint32_t u32Value)
+{
+    uint32_t u32Result = 0;
+    uint32_t i;
+
+    for (i = 0; i < 32; i++)
+    {
+        u32Result = (u32Result << 1) | (u32Value & 1);
+        u32Value >>= 1;
+    }
+
+    return u32Result;
+}
+
+#define __REV(x)                __builtin_bswap32(x)
+
+/* Saturation in C, as cmsis_gcc.h does for cores without SSAT/USAT */
+__STATIC_INLINE int32_t __SSAT(int32_t i32Val, uint32_t u32Sat)
+{
+    const int32_t i32Max = (int32_t)((1U << (u32Sat - 1U)) - 1U);
+    const int32_t i32Min = -1 - i32Max;
+
+    if ((u32Sat < 1U) || (u32Sat > 32U))
+        return i32Val;
+
+    return (i32Val > i32Max) ? i32Max : ((i32Val < i32Min) ? i32Min : i32Val);
+}
+
+__STATIC_INLINE uint32_t __USAT(int32_t i32Val, uint32_t u32Sat)
+{
+    const uint32_t u32Max = (1U << u32Sat) - 1U;
+
+    if (u32Sat > 31U)
+        return (uint32_t)i32Val;
+
+    return (i32Val > (int32_t)u32Max) ? u32Max : ((i32Val < 0) ? 0U : (uint32_t)i32Val);
+}
+
+/*
+ *  Exclusive access as the local monitor of one core sees it: a store-exclusive succeeds only
+ *  after a load-exclusive of the same address with no other store-exclusive or CLREX between.
+ *  A nested call standing in for an interrupt therefore makes the interrupted STREX fail, as
+ *  the exception return does on the target.
+ */
+static volatile uint32_t *s_pu32HostsimExcl __attribute__((unused));
+
+__STATIC_INLINE uint32_t __LDREXW(volatile uint32_t *pu32Addr)
+{
+    s_pu32HostsimExcl = pu32Addr;
+    return *pu32Addr;
+}
+
+__STATIC_INLINE uint32_t __STREXW(uint32_t u32Value, volatile uint32_t *pu32Addr)
+{
+    if (s_pu32HostsimExcl != pu32Addr)
+    {
+        s_pu32HostsimExcl = 0;
+        return 1U;
+    }
+
+    *pu32Addr = u32Value;
+    s_pu32HostsimExcl = 0;
+    return 0U;
+}
+
+__STATIC_INLINE void __CLREX(void)
+{
+    s_pu32HostsimExcl = 0;
+}
+
+#endif /* __HOSTSIM_CMSIS_H__ */
@@ -0,0 +1,82 @@
+/**************************************************************************//**
+ * @file     hostsim_test.h
+ * @version  V1.00
+ * @brief    Check macro, error count and main() frame shared by the host checks.
+ *
+ * @details  Each check is one executable built from its main.c, which includes
+ *           this header once: the error count is that file's own.
+ *
+ *           int main(void)
+ *           {
+ *               if (HOSTSIM_TestBegin("What is checked", SimInit) != 0)
+ *                   return 1;
+ *
+ *               TestOne();
+ *               TestTwo();
+ *
+ *               return HOSTSIM_TestEnd();
+ *           }
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __HOSTSIM_TEST_H__
+#define __HOSTSIM_TEST_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HOSTSIM_TEST_WIDTH      45      /*!< Inner width of the banner */
+
+/* Failed checks of this executable */
+static uint32_t s_u32Errors;
+
+/**
+  * @brief   Count a failed check and print why.
+  * @param[in] cond  Condition that holds when the check passes.
+  * @param[in] ...   printf() format of the message, then its arguments.
+  */
+#define CHECK(cond, ...)    do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); s_u32Errors++; } } while (0)
+
+/**
+  * @brief   Set up the models and print the banner.
+  * @param[in] pcTitle     What the executable checks, without "(host check)".
+  * @param[in] pfnSimInit  Maps the peripheral windows (HOSTSIM_Init() first) and starts the models,
+  *                        returns 0 on success; NULL when the code under check touches no register.
+  * @return  0, or -1 after a message when the host cannot run the check.
+  */
+static inline int32_t HOSTSIM_TestBegin(const char *pcTitle, int32_t (*pfnSimInit)(void))
+{
+    int32_t i32Pad = HOSTSIM_TEST_WIDTH - (int32_t)strlen(pcTitle) - (int32_t)sizeof(" (host check)") + 1;
+
+    if ((pfnSimInit != NULL) && (pfnSimInit() != 0))
+    {
+        printf("Cannot map the M460 peripheral windows on this host.\n");
+        return -1;
+    }
+
+    if (i32Pad < 0)
+        i32Pad = 0;
+
+    printf("+---------------------------------------------+\n");
+    printf("|%*s%s (host check)%*s|\n", i32Pad / 2, "", pcTitle, i32Pad - i32Pad / 2, "");
+    printf("+---------------------------------------------+\n");
+
+    return 0;
+}
+
+/**
+  * @brief   Print the verdict.
+  * @return  Exit status of the executable: 0 when every check passed, 1 otherwise.
+  */
+static inline int HOSTSIM_TestEnd(void)
+{
+    printf("\n%s (%u error(s))\n", s_u32Errors ? "FAILED" : "PASSED", s_u32Errors);
+
+    return s_u32Errors ? 1 : 0;
+}
+
+#endif /* __HOSTSIM_TEST_H__ */
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
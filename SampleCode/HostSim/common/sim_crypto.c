@@ -0,0 +1,404 @@
+/**************************************************************************//**
+ * @file     sim_crypto.c
+ * @version  V1.00
+ * @brief    Host model of the CRC controller and the SHA engine of CRPT,
+ *           shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_crypto.h"
+
+#define SIM_SHA_DMA_MODE_Msk    (CRPT_HMAC_CTL_DMALAST_Msk | CRPT_HMAC_CTL_DMACSCAD_Msk | CRPT_HMAC_CTL_DMAEN_Msk)
+
+typedef struct
+{
+    uint32_t au32H[8];
+    uint8_t  au8Block[64];
+    uint32_t u32BlockLen;
+    uint64_t u64Total;
+} SIM_SHA256_T;
+
+typedef struct
+{
+    uint32_t u32Crc;                    /* CRC shift register, not reversed */
+    SIM_SHA256_T sSha;
+    uint32_t au32MemBase[SIM_CRYPTO_MAX_MEMORY];
+    uint32_t au32MemSize[SIM_CRYPTO_MAX_MEMORY];
+    uint32_t u32MemCnt;
+    SIM_CRYPTO_STAT_T sStat;
+} SIM_CRYPTO_T;
+
+static SIM_CRYPTO_T s_sSim;
+
+static const uint32_t s_au32K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SIM_ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void SIM_SHA256_Block(SIM_SHA256_T *psSha, const uint8_t *pu8Block)
+{
+    uint32_t au32W[64], a, b, c, d, e, f, g, h, t1, t2;
+    uint32_t i;
+
+    for (i = 0; i < 16; i++)
+        au32W[i] = ((uint32_t)pu8Block[4 * i] << 24) | ((uint32_t)pu8Block[4 * i + 1] << 16) |
+                   ((uint32_t)pu8Block[4 * i + 2] << 8) | pu8Block[4 * i + 3];
+
+    for (i = 16; i < 64; i++)
+        au32W[i] = (SIM_ROR(au32W[i - 2], 17) ^ SIM_ROR(au32W[i - 2], 19) ^ (au32W[i - 2] >> 10)) + au32W[i - 7] +
+                   (SIM_ROR(au32W[i - 15], 7) ^ SIM_ROR(au32W[i - 15], 18) ^ (au32W[i - 15] >> 3)) + au32W[i - 16];
+
+    a = psSha->au32H[0];
+    b = psSha->au32H[1];
+    c = psSha->au32H[2];
+    d = psSha->au32H[3];
+    e = psSha->au32H[4];
+    f = psSha->au32H[5];
+    g = psSha->au32H[6];
+    h = psSha->au32H[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        t1 = h + (SIM_ROR(e, 6) ^ SIM_ROR(e, 11) ^ SIM_ROR(e, 25)) + ((e & f) ^ (~e & g)) + s_au32K[i] + au32W[i];
+        t2 = (SIM_ROR(a, 2) ^ SIM_ROR(a, 13) ^ SIM_ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    psSha->au32H[0] += a;
+    psSha->au32H[1] += b;
+    psSha->au32H[2] += c;
+    psSha->au32H[3] += d;
+    psSha->au32H[4] += e;
+    psSha->au32H[5] += f;
+    psSha->au32H[6] += g;
+    psSha->au32H[7] += h;
+}
+
+static void SIM_SHA256_Start(SIM_SHA256_T *psSha)
+{
+    static const uint32_t s_au32H0[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(psSha->au32H, s_au32H0, sizeof(s_au32H0));
+    psSha->u32BlockLen = 0;
+    psSha->u64Total = 0;
+}
+
+static void SIM_SHA256_Update(SIM_SHA256_T *psSha, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    psSha->u64Total += u32Len;
+
+    while (u32Len--)
+    {
+        psSha->au8Block[psSha->u32BlockLen++] = *pu8Data++;
+        if (psSha->u32BlockLen == 64)
+        {
+            SIM_SHA256_Block(psSha, psSha->au8Block);
+            psSha->u32BlockLen = 0;
+        }
+    }
+}
+
+/* Big-endian digest bytes */
+static void SIM_SHA256_Finish(SIM_SHA256_T *psSha, uint8_t au8Digest[32])
+{
+    uint64_t u64Bits = psSha->u64Total * 8;
+    uint8_t au8Pad[72];
+    uint32_t u32PadLen, i;
+
+    memset(au8Pad, 0, sizeof(au8Pad));
+    au8Pad[0] = 0x80;
+    u32PadLen = ((psSha->u32BlockLen < 56) ? 56 : 120) - psSha->u32BlockLen;
+    for (i = 0; i < 8; i++)
+        au8Pad[u32PadLen + i] = (uint8_t)(u64Bits >> (56 - 8 * i));
+
+    SIM_SHA256_Update(psSha, au8Pad, u32PadLen + 8);
+
+    for (i = 0; i < 32; i++)
+        au8Digest[i] = (uint8_t)(psSha->au32H[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+static uint32_t SIM_CRYPTO_InMemory(uint32_t u32Addr, uint32_t u32Len)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_sSim.u32MemCnt; i++)
+    {
+        if ((u32Addr >= s_sSim.au32MemBase[i]) && (u32Len <= s_sSim.au32MemSize[i]) &&
+                (u32Addr - s_sSim.au32MemBase[i] <= s_sSim.au32MemSize[i] - u32Len))
+            return 1;
+    }
+
+    return 0;
+}
+
+static uint32_t SIM_CRC_Reverse(uint32_t u32Val, uint32_t u32Bits)
+{
+    uint32_t u32Ret = 0, i;
+
+    for (i = 0; i < u32Bits; i++)
+        u32Ret |= ((u32Val >> i) & 1u) << (u32Bits - 1 - i);
+
+    return u32Ret;
+}
+
+static uint32_t SIM_CRC_Width(uint32_t u32Ctl)
+{
+    static const uint32_t s_au32Width[4] = { 16, 8, 16, 32 };
+
+    return s_au32Width[(u32Ctl & CRC_CTL_CRCMODE_Msk) >> CRC_CTL_CRCMODE_Pos];
+}
+
+static uint32_t SIM_CRC_Mask(uint32_t u32Width)
+{
+    return (u32Width == 32) ? 0xFFFFFFFFul : ((1ul << u32Width) - 1);
+}
+
+static void SIM_CRC_Update(uint32_t u32Data)
+{
+    uint32_t u32Ctl = CRC->CTL;
+    uint32_t u32Width = SIM_CRC_Width(u32Ctl);
+    uint32_t u32Mask = SIM_CRC_Mask(u32Width);
+    uint32_t u32Bytes = 1u << ((u32Ctl & CRC_CTL_DATLEN_Msk) >> CRC_CTL_DATLEN_Pos);
+    uint32_t u32Sum, u32Byte, u32Bit, i, j;
+
+    if (u32Bytes > 4)
+        u32Bytes = 4;
+
+    for (i = 0; i < u32Bytes; i++)
+    {
+        u32Byte = (u32Data >> (8 * i)) & 0xFF;
+        if (u32Ctl & CRC_CTL_DATFMT_Msk)
+            u32Byte ^= 0xFF;
+        if (u32Ctl & CRC_CTL_DATREV_Msk)
+            u32Byte = SIM_CRC_Reverse(u32Byte, 8);
+
+        for (j = 0; j < 8; j++)
+        {
+            u32Bit = ((s_sSim.u32Crc >> (u32Width - 1)) ^ (u32Byte >> (7 - j))) & 1u;
+            s_sSim.u32Crc = (s_sSim.u32Crc << 1) & u32Mask;
+            if (u32Bit)
+                s_sSim.u32Crc ^= CRC->POLYNOMIAL & u32Mask;
+        }
+    }
+
+    s_sSim.sStat.u32CrcBytes += u32Bytes;
+    s_sSim.sStat.u32CrcWrites++;
+
+    u32Sum = (u32Ctl & CRC_CTL_CHKSREV_Msk) ? SIM_CRC_Reverse(s_sSim.u32Crc, u32Width) : s_sSim.u32Crc;
+    if (u32Ctl & CRC_CTL_CHKSFMT_Msk)
+        u32Sum ^= u32Mask;
+    *(uint32_t *)&CRC->CHECKSUM = u32Sum;
+}
+
+static uint32_t SIM_CRC_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    (void)pvPriv;
+
+    switch (u32Offset)
+    {
+    case offsetof(CRC_T, CTL):
+        if (u32New & CRC_CTL_CHKSINIT_Msk)
+        {
+            s_sSim.u32Crc = CRC->SEED & SIM_CRC_Mask(SIM_CRC_Width(u32New));
+            CRC->CTL = u32New & ~CRC_CTL_CHKSINIT_Msk;
+            *(uint32_t *)&CRC->CHECKSUM = 0;
+        }
+        return u32New & ~CRC_CTL_CHKSINIT_Msk;
+
+    case offsetof(CRC_T, DAT):
+        if (CRC->CTL & CRC_CTL_CRCEN_Msk)
+            SIM_CRC_Update(u32New);
+        return u32New;
+
+    case offsetof(CRC_T, CHECKSUM):
+        return u32Old;
+
+    default:
+        return u32New;
+    }
+}
+
+/* START of a SHA DMA transfer */
+static void SIM_SHA_Run(uint32_t u32Ctl)
+{
+    uint32_t u32Src = CRPT->HMAC_SADDR;
+    uint32_t u32Len = CRPT->HMAC_DMACNT;
+    const uint8_t *pu8Src = (const uint8_t *)(uintptr_t)u32Src;
+    uint8_t au8Digest[32], au8Word[4];
+    uint32_t i;
+
+    s_sSim.sStat.u32ShaRuns++;
+
+    if ((((u32Ctl & CRPT_HMAC_CTL_OPMODE_Msk) >> CRPT_HMAC_CTL_OPMODE_Pos) != SHA_MODE_SHA256) ||
+            (u32Ctl & CRPT_HMAC_CTL_HMACEN_Msk) || !(u32Ctl & CRPT_HMAC_CTL_DMAEN_Msk) ||
+            ((u32Ctl & CRPT_HMAC_CTL_DMALAST_Msk) == 0 && (u32Len & 63)) ||
+            ((u32Len != 0) && !SIM_CRYPTO_InMemory(u32Src, u32Len)))
+    {
+        s_sSim.sStat.u32ShaErrors++;
+        *(uint32_t *)&CRPT->HMAC_STS |= CRPT_HMAC_STS_DMAERR_Msk;
+        CRPT->INTSTS |= CRPT_INTSTS_HMACEIF_Msk;
+        return;
+    }
+
+    *(uint32_t *)&CRPT->HMAC_STS &= ~CRPT_HMAC_STS_DMAERR_Msk;
+
+    if (!(u32Ctl & CRPT_HMAC_CTL_DMACSCAD_Msk))
+        SIM_SHA256_Start(&s_sSim.sSha);
+
+    /* Without INSWAP each word is taken most significant byte first, i.e. byte swapped in memory */
+    if (u32Ctl & CRPT_HMAC_CTL_INSWAP_Msk)
+    {
+        SIM_SHA256_Update(&s_sSim.sSha, pu8Src, u32Len);
+    }
+    else
+    {
+        for (i = 0; i < u32Len; i += 4)
+        {
+            au8Word[0] = pu8Src[i + 3];
+            au8Word[1] = pu8Src[i + 2];
+            au8Word[2] = pu8Src[i + 1];
+            au8Word[3] = pu8Src[i];
+            SIM_SHA256_Update(&s_sSim.sSha, au8Word, (u32Len - i < 4) ? u32Len - i : 4);
+        }
+    }
+    s_sSim.sStat.u32ShaBytes += u32Len;
+
+    if (u32Ctl & CRPT_HMAC_CTL_DMALAST_Msk)
+    {
+        SIM_SHA256_Finish(&s_sSim.sSha, au8Digest);
+
+        /* OUTSWAP leaves the digest bytes in order in memory */
+        for (i = 0; i < 8; i++)
+        {
+            if (u32Ctl & CRPT_HMAC_CTL_OUTSWAP_Msk)
+                *(uint32_t *)&CRPT->HMAC_DGST[i] = (uint32_t)au8Digest[4 * i] | ((uint32_t)au8Digest[4 * i + 1] << 8) |
+                                                   ((uint32_t)au8Digest[4 * i + 2] << 16) | ((uint32_t)au8Digest[4 * i + 3] << 24);
+            else
+                *(uint32_t *)&CRPT->HMAC_DGST[i] = s_sSim.sSha.au32H[i];
+        }
+    }
+
+    CRPT->INTSTS |= CRPT_INTSTS_HMACIF_Msk;
+}
+
+static uint32_t SIM_CRPT_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    (void)pvPriv;
+
+    switch (u32Offset)
+    {
+    case offsetof(CRPT_T, INTSTS):
+        return u32Old & ~u32New;
+
+    case offsetof(CRPT_T, HMAC_CTL):
+        if (u32New & CRPT_HMAC_CTL_START_Msk)
+            SIM_SHA_Run(u32New);
+        return u32New & ~(CRPT_HMAC_CTL_START_Msk | CRPT_HMAC_CTL_STOP_Msk);
+
+    case offsetof(CRPT_T, HMAC_STS):
+        return u32Old;
+
+    default:
+        if ((u32Offset >= offsetof(CRPT_T, HMAC_DGST)) && (u32Offset < offsetof(CRPT_T, HMAC_KEYCNT)))
+            return u32Old;
+        return u32New;
+    }
+}
+
+/**
+  * @brief      Map CRC and CRPT and trap their registers.
+  * @return     HOSTSIM_OK or the HOSTSIM error.
+  */
+int32_t SIM_CRYPTO_Init(void)
+{
+    int32_t i32Ret;
+
+    memset(&s_sSim, 0, sizeof(s_sSim));
+
+    if (((i32Ret = HOSTSIM_MapPeriph(CRC_BASE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_MapPeriph(CRPT_BASE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK))
+        return i32Ret;
+
+    if (((i32Ret = HOSTSIM_TrapWrites(CRC_BASE, HOSTSIM_PAGE_SIZE, SIM_CRC_Write, NULL)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_TrapWrites(CRPT_BASE, HOSTSIM_PAGE_SIZE, SIM_CRPT_Write, NULL)) != HOSTSIM_OK))
+        return i32Ret;
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      Let the SHA DMA read a memory window.
+  * @return     HOSTSIM_OK, or HOSTSIM_ERR_FULL with SIM_CRYPTO_MAX_MEMORY windows given.
+  */
+int32_t SIM_CRYPTO_AddMemory(uint32_t u32Base, uint32_t u32Size)
+{
+    if (s_sSim.u32MemCnt >= SIM_CRYPTO_MAX_MEMORY)
+        return HOSTSIM_ERR_FULL;
+
+    s_sSim.au32MemBase[s_sSim.u32MemCnt] = u32Base;
+    s_sSim.au32MemSize[s_sSim.u32MemCnt] = u32Size;
+    s_sSim.u32MemCnt++;
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      SHA-256 of a buffer, computed in software as a reference.
+  */
+void SIM_CRYPTO_Sha256(const uint8_t *pu8Data, uint32_t u32Len, uint8_t au8Digest[32])
+{
+    SIM_SHA256_T sSha;
+
+    SIM_SHA256_Start(&sSha);
+    SIM_SHA256_Update(&sSha, pu8Data, u32Len);
+    SIM_SHA256_Finish(&sSha, au8Digest);
+}
+
+/**
+  * @brief      CRC-32 of a buffer as zlib computes it, in software as a reference.
+  */
+uint32_t SIM_CRYPTO_Crc32(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Crc = 0xFFFFFFFFul, i;
+
+    while (u32Len--)
+    {
+        u32Crc ^= *pu8Data++;
+        for (i = 0; i < 8; i++)
+            u32Crc = (u32Crc >> 1) ^ ((u32Crc & 1u) ? 0xEDB88320ul : 0);
+    }
+
+    return ~u32Crc;
+}
+
+/**
+  * @brief      Counters of the engines.
+  */
+const SIM_CRYPTO_STAT_T *SIM_CRYPTO_GetStat(void)
+{
+    return &s_sSim.sStat;
+}
@@ -0,0 +1,54 @@
+/**************************************************************************//**
+ * @file     sim_crypto.h
+ * @version  V1.00
+ * @brief    Host model of the CRC controller and the SHA engine of CRPT,
+ *           shared by the HostSim checks.
+ *
+ * @details  CRC computes CRC-8, CRC-16 and CRC-32 over CPU writes of 8, 16 or
+ *           32 bits, least significant byte first, with the data and checksum
+ *           reverse and complement options of CTL; CHKSINIT reloads the seed.
+ *           SHA runs SHA-256 in DMA mode only: START reads HMAC_DMACNT bytes
+ *           from HMAC_SADDR, continues the previous digest when DMACSCAD is
+ *           set and pads and writes HMAC_DGST when DMALAST is set, then raises
+ *           HMACIF. Sources outside the memory windows given to
+ *           SIM_CRYPTO_AddMemory() and other SHA modes end with HMACEIF and
+ *           HMAC_STS.DMAERR. Both engines complete at once.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_CRYPTO_H__
+#define __SIM_CRYPTO_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_CRYPTO_MAX_MEMORY   4       /*!< Maximum number of memory windows */
+
+/**
+  * @brief   What the engines saw, since SIM_CRYPTO_Init().
+  */
+typedef struct
+{
+    uint32_t u32CrcBytes;           /*!< Bytes CRC took */
+    uint32_t u32CrcWrites;          /*!< Writes to CRC_DAT */
+    uint32_t u32ShaRuns;            /*!< SHA DMA transfers */
+    uint32_t u32ShaBytes;           /*!< Bytes SHA read */
+    uint32_t u32ShaErrors;          /*!< SHA DMA transfers ended with HMACEIF */
+} SIM_CRYPTO_STAT_T;
+
+int32_t  SIM_CRYPTO_Init(void);
+int32_t  SIM_CRYPTO_AddMemory(uint32_t u32Base, uint32_t u32Size);
+void     SIM_CRYPTO_Sha256(const uint8_t *pu8Data, uint32_t u32Len, uint8_t au8Digest[32]);
+uint32_t SIM_CRYPTO_Crc32(const uint8_t *pu8Data, uint32_t u32Len);
+const SIM_CRYPTO_STAT_T *SIM_CRYPTO_GetStat(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_CRYPTO_H__ */
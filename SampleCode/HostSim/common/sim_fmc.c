@@ -0,0 +1,429 @@
+/**************************************************************************//**
+ * @file     sim_fmc.c
+ * @version  V1.00
+ * @brief    Host model of FMC and the dual bank APROM, shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_fmc.h"
+
+#define SIM_FMC_BANK_SIZE       (SIM_FMC_APROM_SIZE / 2)
+#define SIM_FMC_PAGE_SIZE       0x1000ul
+#define SIM_FMC_REMAP_KEY       0x5AA55AA5ul
+
+#define SIM_FMC_OP_NONE         0
+#define SIM_FMC_OP_PROGRAM      1
+#define SIM_FMC_OP_ERASE        2
+#define SIM_FMC_OP_OTHER        3
+
+typedef struct
+{
+    uint32_t u32Bank;                   /* Physical bank mapped first, ISPSTS.FBS */
+
+    /* Command in progress */
+    uint32_t u32Op;
+    uint32_t u32Remain;                 /* Ticks left */
+    uint32_t u32OpAddr;                 /* Physical address */
+    uint32_t u32OpLen;
+    uint32_t au32Latch[2];
+
+    /* Power failure */
+    uint32_t u32CutCnt;                 /* Programs and erases until the torn one, 0 for none */
+    uint32_t u32PowerOff;
+
+    uint32_t u32Ticks;
+    SIM_FMC_STAT_T sStat;
+} SIM_FMC_T;
+
+static SIM_FMC_T s_sSim;
+
+/* Physical APROM address to its place in the bus view */
+static uint8_t *SIM_FMC_Addr(uint32_t u32Addr)
+{
+    uint32_t u32View = (((u32Addr / SIM_FMC_BANK_SIZE) ^ s_sSim.u32Bank) * SIM_FMC_BANK_SIZE) + (u32Addr % SIM_FMC_BANK_SIZE);
+
+    return (uint8_t *)(uintptr_t)(SIM_FMC_MAP_BASE + u32View);
+}
+
+static void SIM_FMC_SetFlag(uint32_t u32Msk)
+{
+    FMC->ISPCTL |= u32Msk & FMC_ISPCTL_ISPFF_Msk;
+    FMC->ISPSTS |= u32Msk;
+}
+
+/* Power fails half way through the program or erase just started */
+static void SIM_FMC_Tear(void)
+{
+    uint32_t *pu32Word = (uint32_t *)SIM_FMC_Addr(s_sSim.u32OpAddr);
+    uint32_t i;
+
+    if (s_sSim.u32Op == SIM_FMC_OP_PROGRAM)
+    {
+        /* Only the low four bits of each byte get programmed */
+        for (i = 0; i < s_sSim.u32OpLen / 4; i++)
+            pu32Word[i] &= s_sSim.au32Latch[i] | 0xF0F0F0F0ul;
+    }
+    else
+    {
+        memset(pu32Word, 0xFF, s_sSim.u32OpLen / 2);
+    }
+
+    s_sSim.u32Op = SIM_FMC_OP_NONE;
+    s_sSim.u32Remain = 0;
+    s_sSim.u32PowerOff = 1;
+    FMC->ISPTRG = 0;
+    FMC->ISPSTS &= ~FMC_ISPSTS_ISPBUSY_Msk;
+}
+
+static void SIM_FMC_FinishOp(void)
+{
+    uint32_t *pu32Word = (uint32_t *)SIM_FMC_Addr(s_sSim.u32OpAddr);
+    uint32_t i;
+
+    if (s_sSim.u32Op == SIM_FMC_OP_PROGRAM)
+    {
+        for (i = 0; i < s_sSim.u32OpLen / 4; i++)
+            pu32Word[i] &= s_sSim.au32Latch[i];
+    }
+    else if (s_sSim.u32Op == SIM_FMC_OP_ERASE)
+    {
+        memset(pu32Word, 0xFF, s_sSim.u32OpLen);
+    }
+
+    s_sSim.u32Op = SIM_FMC_OP_NONE;
+    FMC->ISPTRG = 0;
+    FMC->ISPSTS &= ~FMC_ISPSTS_ISPBUSY_Msk;
+}
+
+static void SIM_FMC_StartOp(uint32_t u32Op, uint32_t u32Addr, uint32_t u32Len, uint32_t u32Ticks)
+{
+    s_sSim.u32Op = u32Op;
+    s_sSim.u32OpAddr = u32Addr;
+    s_sSim.u32OpLen = u32Len;
+    s_sSim.u32Remain = u32Ticks;
+    FMC->ISPSTS |= FMC_ISPSTS_ISPBUSY_Msk;
+
+    if ((u32Op == SIM_FMC_OP_PROGRAM) || (u32Op == SIM_FMC_OP_ERASE))
+    {
+        if (s_sSim.u32PowerOff)
+            s_sSim.u32Op = SIM_FMC_OP_OTHER;
+        else if (s_sSim.u32CutCnt && (--s_sSim.u32CutCnt == 0))
+            SIM_FMC_Tear();
+    }
+}
+
+static void SIM_FMC_Program(uint32_t u32Addr, uint32_t u32Len)
+{
+    const uint32_t *pu32Word = (const uint32_t *)SIM_FMC_Addr(u32Addr);
+    uint32_t i;
+
+    s_sSim.au32Latch[0] = (u32Len == 4) ? FMC->ISPDAT : FMC->MPDAT0;
+    s_sSim.au32Latch[1] = FMC->MPDAT1;
+
+    for (i = 0; i < u32Len / 4; i++)
+    {
+        if (pu32Word[i] != 0xFFFFFFFFul)
+        {
+            s_sSim.sStat.u32Overprograms++;
+            break;
+        }
+    }
+
+    s_sSim.sStat.u32Programs++;
+    SIM_FMC_StartOp(SIM_FMC_OP_PROGRAM, u32Addr, u32Len, SIM_FMC_T_PROG64);
+}
+
+static void SIM_FMC_Remap(uint32_t u32Bank)
+{
+    static uint8_t s_au8Tmp[SIM_FMC_BANK_SIZE];
+    uint8_t *pu8View = (uint8_t *)(uintptr_t)SIM_FMC_MAP_BASE;
+
+    if (u32Bank == s_sSim.u32Bank)
+        return;
+
+    memcpy(s_au8Tmp, pu8View, SIM_FMC_BANK_SIZE);
+    memcpy(pu8View, pu8View + SIM_FMC_BANK_SIZE, SIM_FMC_BANK_SIZE);
+    memcpy(pu8View + SIM_FMC_BANK_SIZE, s_au8Tmp, SIM_FMC_BANK_SIZE);
+
+    s_sSim.u32Bank = u32Bank;
+    FMC->ISPSTS = (FMC->ISPSTS & ~FMC_ISPSTS_FBS_Msk) | (u32Bank << FMC_ISPSTS_FBS_Pos);
+    s_sSim.sStat.u32Remaps++;
+}
+
+/* ISPGO set: run the command of ISPCMD */
+static void SIM_FMC_Execute(void)
+{
+    uint32_t u32Cmd = FMC->ISPCMD;
+    uint32_t u32Addr = FMC->ISPADDR;
+    uint32_t u32Write = (u32Cmd == FMC_ISPCMD_PROGRAM) || (u32Cmd == FMC_ISPCMD_PROGRAM_64) || (u32Cmd == FMC_ISPCMD_PAGE_ERASE);
+
+    if (!(FMC->ISPCTL & FMC_ISPCTL_ISPEN_Msk) ||
+            (u32Write && !(FMC->ISPCTL & FMC_ISPCTL_APUEN_Msk)) ||
+            ((u32Cmd != FMC_ISPCMD_BANK_REMAP) && (u32Addr >= SIM_FMC_APROM_SIZE)))
+    {
+        SIM_FMC_SetFlag(FMC_ISPSTS_ISPFF_Msk);
+        s_sSim.sStat.u32Fails++;
+        FMC->ISPTRG = 0;
+        return;
+    }
+
+    switch (u32Cmd)
+    {
+    case FMC_ISPCMD_READ:
+        FMC->ISPDAT = *(const uint32_t *)SIM_FMC_Addr(u32Addr & ~3ul);
+        s_sSim.sStat.u32Reads++;
+        SIM_FMC_StartOp(SIM_FMC_OP_OTHER, u32Addr, 4, SIM_FMC_T_READ);
+        break;
+
+    case FMC_ISPCMD_READ_64:
+        FMC->MPDAT0 = *(const uint32_t *)SIM_FMC_Addr(u32Addr & ~7ul);
+        FMC->MPDAT1 = *(const uint32_t *)SIM_FMC_Addr((u32Addr & ~7ul) + 4);
+        s_sSim.sStat.u32Reads++;
+        SIM_FMC_StartOp(SIM_FMC_OP_OTHER, u32Addr, 8, SIM_FMC_T_READ);
+        break;
+
+    case FMC_ISPCMD_PROGRAM:
+        SIM_FMC_Program(u32Addr & ~3ul, 4);
+        break;
+
+    case FMC_ISPCMD_PROGRAM_64:
+        if (u32Addr & 7ul)
+        {
+            SIM_FMC_SetFlag(FMC_ISPSTS_ISPFF_Msk);
+            s_sSim.sStat.u32Fails++;
+            FMC->ISPTRG = 0;
+            return;
+        }
+        SIM_FMC_Program(u32Addr, 8);
+        break;
+
+    case FMC_ISPCMD_PAGE_ERASE:
+        s_sSim.sStat.u32Erases++;
+        SIM_FMC_StartOp(SIM_FMC_OP_ERASE, u32Addr & ~(SIM_FMC_PAGE_SIZE - 1), SIM_FMC_PAGE_SIZE, SIM_FMC_T_ERASE);
+        break;
+
+    case FMC_ISPCMD_BANK_REMAP:
+        if ((FMC->ISPDAT != SIM_FMC_REMAP_KEY) || (u32Addr > 1))
+        {
+            SIM_FMC_SetFlag(FMC_ISPSTS_ISPFF_Msk);
+            s_sSim.sStat.u32Fails++;
+            FMC->ISPTRG = 0;
+            return;
+        }
+        SIM_FMC_Remap(u32Addr);
+        SIM_FMC_StartOp(SIM_FMC_OP_OTHER, u32Addr, 0, SIM_FMC_T_REMAP);
+        break;
+
+    default:
+        SIM_FMC_SetFlag(FMC_ISPSTS_ISPFF_Msk);
+        s_sSim.sStat.u32Fails++;
+        FMC->ISPTRG = 0;
+        break;
+    }
+}
+
+/* Registers are unlocked; let u32Ticks pass at once */
+static void SIM_FMC_Advance(uint32_t u32Ticks)
+{
+    s_sSim.u32Ticks += u32Ticks;
+
+    if (s_sSim.u32Remain == 0)
+        return;
+
+    if (u32Ticks >= s_sSim.u32Remain)
+    {
+        s_sSim.sStat.u32BusyTicks += s_sSim.u32Remain;
+        s_sSim.u32Remain = 0;
+        SIM_FMC_FinishOp();
+    }
+    else
+    {
+        s_sSim.sStat.u32BusyTicks += u32Ticks;
+        s_sSim.u32Remain -= u32Ticks;
+    }
+}
+
+static uint32_t SIM_FMC_Read(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur)
+{
+    (void)pvPriv;
+
+    /* Busy-wait: a tick passes while ISPGO or ISPBUSY is polled */
+    if ((u32Offset == offsetof(FMC_T, ISPTRG)) && (u32Cur & FMC_ISPTRG_ISPGO_Msk))
+    {
+        SIM_FMC_Advance(1);
+        u32Cur = FMC->ISPTRG;
+    }
+    else if ((u32Offset == offsetof(FMC_T, ISPSTS)) && (u32Cur & FMC_ISPSTS_ISPBUSY_Msk))
+    {
+        SIM_FMC_Advance(1);
+        u32Cur = FMC->ISPSTS;
+    }
+
+    return u32Cur;
+}
+
+static uint32_t SIM_FMC_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    (void)pvPriv;
+
+    switch (u32Offset)
+    {
+    case offsetof(FMC_T, ISPCTL):
+        /* ISPFF is write-1-to-clear, in ISPSTS as well */
+        if (u32New & FMC_ISPCTL_ISPFF_Msk)
+        {
+            FMC->ISPSTS &= ~FMC_ISPSTS_ISPFF_Msk;
+            return u32New & ~FMC_ISPCTL_ISPFF_Msk;
+        }
+        return (u32New & ~FMC_ISPCTL_ISPFF_Msk) | (u32Old & FMC_ISPCTL_ISPFF_Msk);
+
+    case offsetof(FMC_T, ISPSTS):
+        if (u32New & FMC_ISPSTS_ISPFF_Msk)
+        {
+            FMC->ISPCTL &= ~FMC_ISPCTL_ISPFF_Msk;
+            return u32Old & ~FMC_ISPSTS_ISPFF_Msk;
+        }
+        return u32Old;
+
+    case offsetof(FMC_T, ISPTRG):
+        /* A command is only taken while none is in progress */
+        if ((u32New & FMC_ISPTRG_ISPGO_Msk) && !(u32Old & FMC_ISPTRG_ISPGO_Msk))
+        {
+            FMC->ISPTRG = FMC_ISPTRG_ISPGO_Msk;
+            SIM_FMC_Execute();
+            return FMC->ISPTRG;
+        }
+        return u32Old;
+
+    case offsetof(FMC_T, DFBA):
+    case offsetof(FMC_T, MPSTS):
+    case offsetof(FMC_T, MPADDR):
+        return u32Old;
+
+    default:
+        return u32New;
+    }
+}
+
+/**
+  * @brief      Map FMC and the APROM view, trap the registers and erase both banks.
+  * @return     HOSTSIM_OK or the HOSTSIM error.
+  */
+int32_t SIM_FMC_Init(void)
+{
+    int32_t i32Ret;
+
+    memset(&s_sSim, 0, sizeof(s_sSim));
+
+    if (((i32Ret = HOSTSIM_MapPeriph(FMC_BASE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_MapPeriph(SIM_FMC_MAP_BASE, SIM_FMC_APROM_SIZE)) != HOSTSIM_OK))
+        return i32Ret;
+
+    memset((void *)(uintptr_t)SIM_FMC_MAP_BASE, 0xFF, SIM_FMC_APROM_SIZE);
+
+    if (((i32Ret = HOSTSIM_TrapWrites(FMC_BASE, HOSTSIM_PAGE_SIZE, SIM_FMC_Write, NULL)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_TrapReads(FMC_BASE, HOSTSIM_PAGE_SIZE, SIM_FMC_Read, NULL)) != HOSTSIM_OK))
+        return i32Ret;
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      Let a number of ticks (microseconds) pass.
+  */
+void SIM_FMC_Run(uint32_t u32Ticks)
+{
+    HOSTSIM_Unlock(FMC_BASE);
+    SIM_FMC_Advance(u32Ticks);
+    HOSTSIM_Lock(FMC_BASE);
+}
+
+/**
+  * @brief      Let time pass until the command in progress ends, or u32Max ticks.
+  * @return     Ticks that passed.
+  */
+uint32_t SIM_FMC_RunBusy(uint32_t u32Max)
+{
+    uint32_t u32Ticks = (s_sSim.u32Remain < u32Max) ? s_sSim.u32Remain : u32Max;
+
+    SIM_FMC_Run(u32Ticks);
+
+    return u32Ticks;
+}
+
+/**
+  * @brief      Cut the power during a later program or erase.
+  * @param      u32Ops      The program or erase to tear, 1 for the next one.
+  * @details    A torn program leaves only the low four bits of each byte programmed, a torn
+  *             erase only the first half of the page erased. Program and erase commands then
+  *             complete without effect until SIM_FMC_PowerOn(); reads still see the array.
+  */
+void SIM_FMC_PowerCut(uint32_t u32Ops)
+{
+    s_sSim.u32CutCnt = u32Ops;
+}
+
+/**
+  * @brief      The power cut set by SIM_FMC_PowerCut() has happened.
+  */
+uint32_t SIM_FMC_IsPowerOff(void)
+{
+    return s_sSim.u32PowerOff;
+}
+
+/**
+  * @brief      Power up again: the array is kept, FMC is reset and bank 0 is mapped first again.
+  */
+void SIM_FMC_PowerOn(void)
+{
+    HOSTSIM_Unlock(FMC_BASE);
+
+    SIM_FMC_Remap(0);
+    s_sSim.u32CutCnt = 0;
+    s_sSim.u32PowerOff = 0;
+    s_sSim.u32Op = SIM_FMC_OP_NONE;
+    s_sSim.u32Remain = 0;
+    FMC->ISPCTL = 0;
+    FMC->ISPTRG = 0;
+    FMC->ISPSTS = 0;
+
+    HOSTSIM_Lock(FMC_BASE);
+}
+
+/**
+  * @brief      Model time, usable as pfnGetTime of the drivers.
+  */
+uint32_t SIM_FMC_GetTicks(void)
+{
+    return s_sSim.u32Ticks;
+}
+
+/**
+  * @brief      An ISP command is in progress.
+  */
+uint32_t SIM_FMC_IsBusy(void)
+{
+    return s_sSim.u32Remain ? 1 : 0;
+}
+
+/**
+  * @brief      Array of a physical bank, where it currently shows in the bus view.
+  * @details    Valid until the next bank remap.
+  */
+uint8_t *SIM_FMC_GetBank(uint32_t u32Bank)
+{
+    return SIM_FMC_Addr(u32Bank * SIM_FMC_BANK_SIZE);
+}
+
+/**
+  * @brief      Counters of the flash.
+  */
+const SIM_FMC_STAT_T *SIM_FMC_GetStat(void)
+{
+    return &s_sSim.sStat;
+}
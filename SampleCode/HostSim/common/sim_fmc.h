@@ -0,0 +1,71 @@
+/**************************************************************************//**
+ * @file     sim_fmc.h
+ * @version  V1.00
+ * @brief    Host model of FMC and the dual bank APROM, shared by the HostSim checks.
+ *
+ * @details  APROM is 1 MB in two 512 KB banks. ISP commands take physical
+ *           addresses; the bus view at SIM_FMC_MAP_BASE shows the bank selected
+ *           by the bank remap first and the other one behind it, as APROM does
+ *           at FMC_APROM_BASE on the target, and ISPSTS.FBS tells which. The
+ *           model executes read, read-64, program, program-64, page erase and
+ *           bank remap. Commands fail with ISPFF when ISP is off, when APROM
+ *           update is not enabled for program and erase, and on bad addresses.
+ *           Program and erase take typical times, with one model tick standing
+ *           for one microsecond; ISPGO and ISPBUSY stay set meanwhile and the
+ *           array changes when the command ends. Time advances with
+ *           SIM_FMC_Run(), and polling ISPTRG or ISPSTS while busy lets one
+ *           tick pass. Programming a double word that is not erased is
+ *           counted, as the part does not allow it. SIM_FMC_PowerCut() tears a
+ *           later program or erase to check recovery from power failure.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_FMC_H__
+#define __SIM_FMC_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_FMC_MAP_BASE        0x08000000ul    /*!< Bus view of APROM in the host process */
+#define SIM_FMC_APROM_SIZE      0x100000ul      /*!< Both banks */
+
+#define SIM_FMC_T_READ          1ul             /*!< Read commands, ticks */
+#define SIM_FMC_T_PROG64        20ul            /*!< Program of a word or double word, ticks */
+#define SIM_FMC_T_ERASE         5000ul          /*!< 4 KB page erase, ticks */
+#define SIM_FMC_T_REMAP         2ul             /*!< Bank remap, ticks */
+
+/**
+  * @brief   What the flash saw, since SIM_FMC_Init().
+  */
+typedef struct
+{
+    uint32_t u32Reads;              /*!< ISP read commands */
+    uint32_t u32Programs;           /*!< Word and double word programs */
+    uint32_t u32Erases;             /*!< Page erases */
+    uint32_t u32Remaps;             /*!< Bank remaps that changed the mapping */
+    uint32_t u32Fails;              /*!< Commands that set ISPFF */
+    uint32_t u32Overprograms;       /*!< Programs onto a word or double word that was not erased */
+    uint32_t u32BusyTicks;          /*!< Ticks the flash was busy */
+} SIM_FMC_STAT_T;
+
+int32_t  SIM_FMC_Init(void);
+void     SIM_FMC_Run(uint32_t u32Ticks);
+uint32_t SIM_FMC_RunBusy(uint32_t u32Max);
+void     SIM_FMC_PowerCut(uint32_t u32Ops);
+uint32_t SIM_FMC_IsPowerOff(void);
+void     SIM_FMC_PowerOn(void);
+uint32_t SIM_FMC_GetTicks(void);
+uint32_t SIM_FMC_IsBusy(void);
+uint8_t *SIM_FMC_GetBank(uint32_t u32Bank);
+const SIM_FMC_STAT_T *SIM_FMC_GetStat(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_FMC_H__ */
@@ -0,0 +1,293 @@
+/**************************************************************************//**
+ * @file     sim_pdma.c
+ * @version  V1.00
+ * @brief    Host model of PDMA0 shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_pdma.h"
+
+#define SIM_PDMA_SCATBA_RESET   0x20000000UL    /* SCATBA reads the SRAM base after reset, not 0 */
+
+static SIM_PDMA_IRQ_T s_pfnIrq;
+static uint32_t s_au32MemBase[SIM_PDMA_MAX_MEMORY];
+static uint32_t s_au32MemSize[SIM_PDMA_MAX_MEMORY];
+static uintptr_t s_auMemHost[SIM_PDMA_MAX_MEMORY];    /* Host address of each window base */
+static uint32_t s_u32MemCnt;
+
+static uint32_t s_u32Ticks;             /* Items moved so far, plus SIM_PDMA_AddTicks() */
+static uint32_t s_u32SwReq;             /* Software requests not yet served */
+static uint32_t s_au32Remain[PDMA_CH_MAX];
+
+static uint32_t SIM_PDMA_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    uint32_t u32Ch;
+
+    (void)pvPriv;
+
+    if ((u32Offset == offsetof(PDMA_T, TDSTS)) || (u32Offset == offsetof(PDMA_T, ABTSTS)) ||
+            (u32Offset == offsetof(PDMA_T, INTSTS)))
+        return u32Old & ~u32New;
+
+    if (u32Offset == offsetof(PDMA_T, SWREQ))
+    {
+        s_u32SwReq |= u32New;
+        return 0;
+    }
+
+    if (u32Offset == offsetof(PDMA_T, CHRST))
+    {
+        for (u32Ch = 0; u32Ch < PDMA_CH_MAX; u32Ch++)
+        {
+            if (u32New & (1UL << u32Ch))
+                s_au32Remain[u32Ch] = 0;
+        }
+
+        return 0;
+    }
+
+    return u32New;
+}
+
+/**
+  * @brief      Map PDMA0 and trap its register writes.
+  * @param[in]  pfnIrq  Called for an enabled transfer done or any target abort, as PDMA0_IRQHandler().
+  * @return     HOSTSIM_OK or the HOSTSIM error.
+  */
+int32_t SIM_PDMA_Init(SIM_PDMA_IRQ_T pfnIrq)
+{
+    int32_t i32Ret;
+
+    s_pfnIrq = pfnIrq;
+
+    if ((i32Ret = HOSTSIM_MapPeriph(PDMA0_BASE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK)
+        return i32Ret;
+
+    PDMA0->SCATBA = SIM_PDMA_SCATBA_RESET;
+
+    return HOSTSIM_TrapWrites(PDMA0_BASE, HOSTSIM_PAGE_SIZE, SIM_PDMA_Write, NULL);
+}
+
+/**
+  * @brief      Declare a window PDMA may access; the caller maps it.
+  */
+int32_t SIM_PDMA_AddMemory(uint32_t u32Base, uint32_t u32Size)
+{
+    return SIM_PDMA_AddAlias(u32Base, u32Size, (void *)(uintptr_t)u32Base);
+}
+
+/**
+  * @brief      Declare a window PDMA sees at u32Base while its content lives at pvHost, for bus
+  *             addresses the host cannot map, such as the APROM at 0.
+  */
+int32_t SIM_PDMA_AddAlias(uint32_t u32Base, uint32_t u32Size, void *pvHost)
+{
+    if (s_u32MemCnt >= SIM_PDMA_MAX_MEMORY)
+        return HOSTSIM_ERR_FULL;
+
+    s_au32MemBase[s_u32MemCnt] = u32Base;
+    s_au32MemSize[s_u32MemCnt] = u32Size;
+    s_auMemHost[s_u32MemCnt] = (uintptr_t)pvHost;
+    s_u32MemCnt++;
+
+    return HOSTSIM_OK;
+}
+
+/* Host address of a bus access, NULL outside the windows */
+static void *SIM_PDMA_HostAddr(uint32_t u32Addr, uint32_t u32Width)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32MemCnt; i++)
+    {
+        if ((u32Addr >= s_au32MemBase[i]) && (u32Addr - s_au32MemBase[i] + u32Width <= s_au32MemSize[i]))
+            return (void *)(s_auMemHost[i] + (u32Addr - s_au32MemBase[i]));
+    }
+
+    return NULL;
+}
+
+/* Raise the channel flag and its interrupt */
+static void SIM_PDMA_Flag(uint32_t u32Ch, uint32_t u32Abort)
+{
+    HOSTSIM_Unlock(PDMA0_BASE);
+
+    if (u32Abort)
+    {
+        PDMA0->ABTSTS |= (1UL << u32Ch);
+        PDMA0->INTSTS |= PDMA_INTSTS_ABTIF_Msk;
+    }
+    else
+    {
+        PDMA0->TDSTS |= (1UL << u32Ch);
+        PDMA0->INTSTS |= PDMA_INTSTS_TDIF_Msk;
+    }
+
+    HOSTSIM_Lock(PDMA0_BASE);
+
+    if ((s_pfnIrq != NULL) && (u32Abort || (PDMA0->INTEN & (1UL << u32Ch))))
+        s_pfnIrq();
+}
+
+/* Load the table at SCATBA + NEXT into the channel registers */
+static void SIM_PDMA_Fetch(uint32_t u32Ch)
+{
+    volatile DSCT_T *psCh = &PDMA0->DSCT[u32Ch];
+    DSCT_T *psDesc = (DSCT_T *)(uintptr_t)((PDMA0->SCATBA & PDMA_SCATBA_SCATBA_Msk) + (psCh->NEXT & 0xFFFFUL));
+
+    psCh->CTL = psDesc->CTL;
+    psCh->SA = psDesc->SA;
+    psCh->DA = psDesc->DA;
+    psCh->NEXT = psDesc->NEXT;
+    *(uint32_t *)&PDMA0->CURSCAT[u32Ch] = (uint32_t)(uintptr_t)psDesc;
+    s_au32Remain[u32Ch] = ((psDesc->CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos) + 1;
+}
+
+/**
+  * @brief      Move one item on a channel.
+  * @return     1 while the channel has more to do. 0 once it went idle (the interrupt may already have
+  *             started the next transfer) or when it had nothing to do.
+  */
+uint32_t SIM_PDMA_Step(uint32_t u32Ch)
+{
+    volatile DSCT_T *psCh = &PDMA0->DSCT[u32Ch];
+    uint32_t u32Ctl, u32Width, u32Last;
+    void *pvSrc, *pvDst;
+
+    if (!(PDMA0->CHCTL & (1UL << u32Ch)) || ((psCh->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_STOP))
+        return 0;
+
+    HOSTSIM_Unlock(PDMA0_BASE);
+
+    if ((s_au32Remain[u32Ch] == 0) && ((psCh->CTL & PDMA_DSCT_CTL_OPMODE_Msk) == PDMA_OP_SCATTER))
+        SIM_PDMA_Fetch(u32Ch);
+    else if (s_au32Remain[u32Ch] == 0)
+        s_au32Remain[u32Ch] = ((psCh->CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos) + 1;
+
+    u32Ctl = psCh->CTL;
+    u32Width = 1UL << ((u32Ctl & PDMA_DSCT_CTL_TXWIDTH_Msk) >> PDMA_DSCT_CTL_TXWIDTH_Pos);
+
+    pvSrc = SIM_PDMA_HostAddr(psCh->SA, u32Width);
+    pvDst = SIM_PDMA_HostAddr(psCh->DA, u32Width);
+
+    if ((pvSrc == NULL) || (pvDst == NULL))
+    {
+        psCh->CTL &= ~PDMA_DSCT_CTL_OPMODE_Msk;
+        s_au32Remain[u32Ch] = 0;
+        HOSTSIM_Lock(PDMA0_BASE);
+        SIM_PDMA_Flag(u32Ch, 1);
+        return 0;
+    }
+
+    memcpy(pvDst, pvSrc, u32Width);
+
+    if ((u32Ctl & PDMA_DSCT_CTL_SAINC_Msk) != PDMA_SAR_FIX)
+        psCh->SA += u32Width;
+
+    if ((u32Ctl & PDMA_DSCT_CTL_DAINC_Msk) != PDMA_DAR_FIX)
+        psCh->DA += u32Width;
+
+    s_u32Ticks++;
+
+    /* TXCNT counts down with the items left, as software reads it */
+    if (--s_au32Remain[u32Ch] != 0)
+    {
+        psCh->CTL = (psCh->CTL & ~PDMA_DSCT_CTL_TXCNT_Msk) | ((s_au32Remain[u32Ch] - 1) << PDMA_DSCT_CTL_TXCNT_Pos);
+        HOSTSIM_Lock(PDMA0_BASE);
+        return 1;
+    }
+
+    /* Table complete: scatter mode loads the next table right away, basic mode ends the channel */
+    u32Last = ((u32Ctl & PDMA_DSCT_CTL_OPMODE_Msk) != PDMA_OP_SCATTER);
+
+    if (u32Last)
+        psCh->CTL &= ~PDMA_DSCT_CTL_OPMODE_Msk;
+    else
+        SIM_PDMA_Fetch(u32Ch);
+
+    HOSTSIM_Lock(PDMA0_BASE);
+
+    if (u32Last || !(u32Ctl & PDMA_DSCT_CTL_TBINTDIS_Msk))
+        SIM_PDMA_Flag(u32Ch, 0);
+
+    return !u32Last;
+}
+
+/**
+  * @brief      Serve software requests until every memory channel is idle.
+  */
+void SIM_PDMA_RunMem(void)
+{
+    uint32_t u32Ch;
+
+    while (s_u32SwReq)
+    {
+        u32Ch = (uint32_t)__builtin_ctz(s_u32SwReq);
+        s_u32SwReq &= ~(1UL << u32Ch);
+
+        while (SIM_PDMA_Step(u32Ch))
+            ;
+    }
+}
+
+/**
+  * @brief      Request source selected by the REQSEL field of a channel.
+  */
+uint32_t SIM_PDMA_GetReqSrc(uint32_t u32Ch)
+{
+    volatile uint32_t *pu32ReqSel = &PDMA0->REQSEL0_3;
+
+    return (pu32ReqSel[u32Ch >> 2] >> ((u32Ch & 3) * 8)) & 0x7F;
+}
+
+/**
+  * @brief      One single request from a peripheral.
+  * @return     1 if an enabled, active channel with that request source served it.
+  */
+uint32_t SIM_PDMA_PeriphReq(uint32_t u32ReqSrc)
+{
+    uint32_t u32Ch;
+
+    for (u32Ch = 0; u32Ch < PDMA_CH_MAX; u32Ch++)
+    {
+        if ((PDMA0->CHCTL & (1UL << u32Ch)) && ((PDMA0->DSCT[u32Ch].CTL & PDMA_DSCT_CTL_OPMODE_Msk) != PDMA_OP_STOP) &&
+                (SIM_PDMA_GetReqSrc(u32Ch) == u32ReqSrc))
+        {
+            SIM_PDMA_Step(u32Ch);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+  * @brief      Software requests written to SWREQ and not served yet.
+  */
+uint32_t SIM_PDMA_SwReqPending(void)
+{
+    return s_u32SwReq;
+}
+
+/**
+  * @brief      Forget pending software requests, e.g. to keep transfers queued.
+  */
+void SIM_PDMA_DropSwReq(void)
+{
+    s_u32SwReq = 0;
+}
+
+uint32_t SIM_PDMA_GetTicks(void)
+{
+    return s_u32Ticks;
+}
+
+void SIM_PDMA_AddTicks(uint32_t u32Ticks)
+{
+    s_u32Ticks += u32Ticks;
+}
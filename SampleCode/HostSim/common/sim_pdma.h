@@ -0,0 +1,48 @@
+/**************************************************************************//**
+ * @file     sim_pdma.h
+ * @version  V1.00
+ * @brief    Host model of PDMA0 shared by the HostSim checks.
+ *
+ * @details  The model fetches scatter-gather tables from SCATBA + NEXT, moves
+ *           one item per request (software request for memory channels,
+ *           peripheral request for the others), raises transfer done only for
+ *           tables with their interrupt enabled and target-aborts accesses
+ *           outside the memory windows given to SIM_PDMA_AddMemory(). TXCNT
+ *           of the channel counts down as items move and a completed scatter
+ *           table is followed by the next one at once. Each item moved is one
+ *           model tick. SCATBA starts at its reset value, the SRAM base.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_PDMA_H__
+#define __SIM_PDMA_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_PDMA_MAX_MEMORY     4       /*!< Maximum number of memory windows */
+
+typedef void (*SIM_PDMA_IRQ_T)(void);
+
+int32_t  SIM_PDMA_Init(SIM_PDMA_IRQ_T pfnIrq);
+int32_t  SIM_PDMA_AddMemory(uint32_t u32Base, uint32_t u32Size);
+int32_t  SIM_PDMA_AddAlias(uint32_t u32Base, uint32_t u32Size, void *pvHost);
+uint32_t SIM_PDMA_Step(uint32_t u32Ch);
+void     SIM_PDMA_RunMem(void);
+uint32_t SIM_PDMA_PeriphReq(uint32_t u32ReqSrc);
+uint32_t SIM_PDMA_GetReqSrc(uint32_t u32Ch);
+uint32_t SIM_PDMA_SwReqPending(void);
+void     SIM_PDMA_DropSwReq(void);
+uint32_t SIM_PDMA_GetTicks(void);
+void     SIM_PDMA_AddTicks(uint32_t u32Ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_PDMA_H__ */
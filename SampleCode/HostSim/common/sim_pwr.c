@@ -0,0 +1,360 @@
+/**************************************************************************//**
+ * @file     sim_pwr.c
+ * @version  V1.00
+ * @brief    Host model of the power modes and a wake-up timer, shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_pwr.h"
+
+#define SIM_PWR_TIMER_PAGE      (TIMER0_BASE & ~(HOSTSIM_PAGE_SIZE - 1))
+#define SIM_PWR_NEVER           UINT64_MAX
+
+typedef struct
+{
+    uint64_t u64At;
+    SIM_PWR_IRQ_CB pfnIrq;
+    void *pvPriv;
+} SIM_PWR_EVENT_T;
+
+typedef struct
+{
+    uint64_t u64Now;                    /* Model time, microseconds */
+
+    /* TIMER0 */
+    uint32_t u32TimerClk;
+    uint64_t u64CntBase;                /* Timer clock at which CNT was 0 */
+    uint32_t u32CntHeld;                /* CNT while stopped */
+    uint64_t u64Checked;                /* Compare matches up to this time are done */
+    SIM_PWR_IRQ_CB pfnTimerIrq;
+    void *pvTimerIrq;
+
+    SIM_PWR_EVENT_T asEvent[SIM_PWR_MAX_EVENTS];
+    uint32_t au32Entry[SIM_PWR_STATE_CNT];
+    uint32_t au32Exit[SIM_PWR_STATE_CNT];
+
+    SIM_PWR_STAT_T sStat;
+} SIM_PWR_T;
+
+static SIM_PWR_T s_sSim;
+
+/* Timer clocks since time 0 */
+static uint64_t SIM_PWR_Clocks(uint64_t u64Us)
+{
+    return (u64Us * s_sSim.u32TimerClk) / 1000000ull;
+}
+
+static uint32_t SIM_PWR_Cnt(uint32_t u32Ctl)
+{
+    if (!(u32Ctl & TIMER_CTL_CNTEN_Msk))
+        return s_sSim.u32CntHeld;
+
+    return (uint32_t)(SIM_PWR_Clocks(s_sSim.u64Now) - s_sSim.u64CntBase) & TIMER_CNT_CNT_Msk;
+}
+
+/* Time of the first compare match after u64Checked; TIMER0 must be unlocked */
+static uint64_t SIM_PWR_TimerDue(void)
+{
+    uint64_t u64Clk = SIM_PWR_Clocks(s_sSim.u64Checked);
+    uint32_t u32Delta;
+
+    if (!(TIMER0->CTL & TIMER_CTL_CNTEN_Msk))
+        return SIM_PWR_NEVER;
+
+    u32Delta = (TIMER0->CMP - (uint32_t)(u64Clk - s_sSim.u64CntBase)) & TIMER_CNT_CNT_Msk;
+    if (u32Delta == 0)
+        u32Delta = TIMER_CNT_CNT_Msk + 1;
+
+    /* First microsecond at which the counter shows the match */
+    return ((u64Clk + u32Delta) * 1000000ull + s_sSim.u32TimerClk - 1) / s_sSim.u32TimerClk;
+}
+
+static SIM_PWR_EVENT_T *SIM_PWR_NextEvent(void)
+{
+    SIM_PWR_EVENT_T *psNext = NULL;
+    uint32_t i;
+
+    for (i = 0; i < SIM_PWR_MAX_EVENTS; i++)
+    {
+        if (s_sSim.asEvent[i].pfnIrq && ((psNext == NULL) || (s_sSim.asEvent[i].u64At < psNext->u64At)))
+            psNext = &s_sSim.asEvent[i];
+    }
+
+    return psNext;
+}
+
+static void SIM_PWR_Pass(uint64_t u64To, uint32_t u32State)
+{
+    if (u64To > s_sSim.u64Now)
+    {
+        s_sSim.sStat.au64Time[u32State] += u64To - s_sSim.u64Now;
+        s_sSim.u64Now = u64To;
+    }
+}
+
+/*
+ * Handle the timer match or event due first, if it is due by u64To. u32Deep: the chip
+ * is in power-down, so the timer sets TWKF. Returns 0 when nothing was due.
+ */
+static uint32_t SIM_PWR_FireNext(uint64_t u64To, uint32_t u32Deep)
+{
+    SIM_PWR_EVENT_T *psEvent = SIM_PWR_NextEvent();
+    SIM_PWR_EVENT_T sEvent;
+    uint64_t u64Timer;
+    uint32_t u32Ctl;
+
+    HOSTSIM_Unlock(SIM_PWR_TIMER_PAGE);
+    u64Timer = SIM_PWR_TimerDue();
+    u32Ctl = TIMER0->CTL;
+
+    if ((u64Timer <= u64To) && ((psEvent == NULL) || (u64Timer <= psEvent->u64At)))
+    {
+        s_sSim.u64Checked = (u64Timer > s_sSim.u64Now) ? u64Timer : s_sSim.u64Now;
+        TIMER0->INTSTS |= TIMER_INTSTS_TIF_Msk;
+        if (u32Deep && (u32Ctl & TIMER_CTL_WKEN_Msk))
+            TIMER0->INTSTS |= TIMER_INTSTS_TWKF_Msk;
+        HOSTSIM_Lock(SIM_PWR_TIMER_PAGE);
+
+        if ((u32Ctl & TIMER_CTL_INTEN_Msk) && s_sSim.pfnTimerIrq)
+            s_sSim.pfnTimerIrq(s_sSim.pvTimerIrq);
+        return 1;
+    }
+    HOSTSIM_Lock(SIM_PWR_TIMER_PAGE);
+
+    if (psEvent && (psEvent->u64At <= u64To))
+    {
+        /* The handler may add the next event into the freed slot */
+        sEvent = *psEvent;
+        psEvent->pfnIrq = NULL;
+        sEvent.pfnIrq(sEvent.pvPriv);
+        return 1;
+    }
+
+    return 0;
+}
+
+static uint32_t SIM_PWR_Read(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur)
+{
+    (void)pvPriv;
+
+    if (u32Offset == offsetof(TIMER_T, CNT))
+        return SIM_PWR_Cnt(TIMER0->CTL);
+
+    return u32Cur;
+}
+
+static uint32_t SIM_PWR_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    (void)pvPriv;
+
+    switch (u32Offset)
+    {
+    case offsetof(TIMER_T, CTL):
+        /* The counter holds its value while stopped */
+        if ((u32New & TIMER_CTL_CNTEN_Msk) && !(u32Old & TIMER_CTL_CNTEN_Msk))
+            s_sSim.u64CntBase = SIM_PWR_Clocks(s_sSim.u64Now) - s_sSim.u32CntHeld;
+        else if (!(u32New & TIMER_CTL_CNTEN_Msk) && (u32Old & TIMER_CTL_CNTEN_Msk))
+            s_sSim.u32CntHeld = SIM_PWR_Cnt(u32Old);
+        s_sSim.u64Checked = s_sSim.u64Now;
+        return (u32New & ~TIMER_CTL_ACTSTS_Msk) | ((u32New & TIMER_CTL_CNTEN_Msk) ? TIMER_CTL_ACTSTS_Msk : 0);
+
+    case offsetof(TIMER_T, CMP):
+        s_sSim.u64Checked = s_sSim.u64Now;
+        return u32New & TIMER_CNT_CNT_Msk;
+
+    case offsetof(TIMER_T, INTSTS):
+        return u32Old & ~u32New;
+
+    case offsetof(TIMER_T, CNT):
+        return u32Old;
+
+    default:
+        return u32New;
+    }
+}
+
+/**
+  * @brief      Map and trap TIMER0, with time 0 and the CPU running.
+  * @param      u32TimerClk     Clock of TIMER0, Hz.
+  * @return     HOSTSIM_OK or the HOSTSIM error.
+  */
+int32_t SIM_PWR_Init(uint32_t u32TimerClk)
+{
+    int32_t i32Ret;
+
+    memset(&s_sSim, 0, sizeof(s_sSim));
+    s_sSim.u32TimerClk = u32TimerClk;
+
+    if ((i32Ret = HOSTSIM_MapPeriph(SIM_PWR_TIMER_PAGE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK)
+        return i32Ret;
+
+    if (((i32Ret = HOSTSIM_TrapWrites(SIM_PWR_TIMER_PAGE, HOSTSIM_PAGE_SIZE, SIM_PWR_Write, NULL)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_TrapReads(SIM_PWR_TIMER_PAGE, HOSTSIM_PAGE_SIZE, SIM_PWR_Read, NULL)) != HOSTSIM_OK))
+        return i32Ret;
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      Latency of a mode, microseconds.
+  * @details    Entry runs from WFI to the mode reached, exit from the wake-up event to the
+  *             return from WFI; both are accounted as SIM_PWR_TRANS.
+  */
+void SIM_PWR_SetLatency(uint32_t u32State, uint32_t u32Entry, uint32_t u32Exit)
+{
+    if (u32State < SIM_PWR_STATE_CNT)
+    {
+        s_sSim.au32Entry[u32State] = u32Entry;
+        s_sSim.au32Exit[u32State] = u32Exit;
+    }
+}
+
+/**
+  * @brief      Handler of the TIMER0 interrupt, called on a match while INTEN is set.
+  */
+void SIM_PWR_SetTimerIrq(SIM_PWR_IRQ_CB pfnIrq, void *pvPriv)
+{
+    s_sSim.pfnTimerIrq = pfnIrq;
+    s_sSim.pvTimerIrq = pvPriv;
+}
+
+/**
+  * @brief      Raise an interrupt at a model time; it also wakes the chip from power-down.
+  * @return     0, or -1 when SIM_PWR_MAX_EVENTS are pending.
+  */
+int32_t SIM_PWR_AddEvent(uint64_t u64At, SIM_PWR_IRQ_CB pfnIrq, void *pvPriv)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_PWR_MAX_EVENTS; i++)
+    {
+        if (s_sSim.asEvent[i].pfnIrq == NULL)
+        {
+            s_sSim.asEvent[i].u64At = u64At;
+            s_sSim.asEvent[i].pfnIrq = pfnIrq;
+            s_sSim.asEvent[i].pvPriv = pvPriv;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+  * @brief      The CPU runs for u32Us microseconds; interrupts due meanwhile are handled as they come.
+  */
+void SIM_PWR_Run(uint32_t u32Us)
+{
+    uint64_t u64To = s_sSim.u64Now + u32Us;
+    SIM_PWR_EVENT_T *psEvent;
+    uint64_t u64Next;
+
+    for (;;)
+    {
+        /* Run up to the next interrupt, then take it */
+        HOSTSIM_Unlock(SIM_PWR_TIMER_PAGE);
+        u64Next = SIM_PWR_TimerDue();
+        HOSTSIM_Lock(SIM_PWR_TIMER_PAGE);
+        psEvent = SIM_PWR_NextEvent();
+        if (psEvent && (psEvent->u64At < u64Next))
+            u64Next = psEvent->u64At;
+        if (u64Next > u64To)
+            break;
+
+        SIM_PWR_Pass(u64Next, SIM_PWR_RUN);
+        SIM_PWR_FireNext(s_sSim.u64Now, 0);
+    }
+
+    SIM_PWR_Pass(u64To, SIM_PWR_RUN);
+    s_sSim.u64Checked = s_sSim.u64Now;
+}
+
+/**
+  * @brief      __WFI(): sleep in the selected mode until an interrupt, then handle it.
+  */
+void HOSTSIM_WaitForInterrupt(void)
+{
+    SIM_PWR_EVENT_T *psEvent = SIM_PWR_NextEvent();
+    uint64_t u64Wake = SIM_PWR_NEVER;
+    uint32_t u32State = SIM_PWR_SLEEP, u32ByTimer = 0;
+
+    if ((SCB->SCR & SCB_SCR_SLEEPDEEP_Msk) && (CLK->PWRCTL & CLK_PWRCTL_PDEN_Msk))
+    {
+        /* Standby and Deep Power-down are not modelled; they count as Power-down */
+        switch (CLK->PMUCTL & CLK_PMUCTL_PDMSEL_Msk)
+        {
+        case CLK_PMUCTL_PDMSEL_FWPD:
+            u32State = SIM_PWR_FWPD;
+            break;
+        case CLK_PMUCTL_PDMSEL_LLPD:
+            u32State = SIM_PWR_LLPD;
+            break;
+        default:
+            u32State = SIM_PWR_PD;
+            break;
+        }
+    }
+
+    HOSTSIM_Unlock(SIM_PWR_TIMER_PAGE);
+    if (TIMER0->CTL & TIMER_CTL_INTEN_Msk)
+        u64Wake = SIM_PWR_TimerDue();
+    HOSTSIM_Lock(SIM_PWR_TIMER_PAGE);
+    if (u64Wake != SIM_PWR_NEVER)
+        u32ByTimer = 1;
+    if (psEvent && (psEvent->u64At < u64Wake))
+    {
+        u64Wake = psEvent->u64At;
+        u32ByTimer = 0;
+    }
+
+    if (u64Wake == SIM_PWR_NEVER)
+    {
+        s_sSim.sStat.u32Stuck++;
+        return;
+    }
+
+    s_sSim.sStat.au32Entries[u32State]++;
+    if (u32ByTimer)
+        s_sSim.sStat.u32TimerWakeups++;
+    else
+        s_sSim.sStat.u32EventWakeups++;
+
+    /* An interrupt during the entry ends the sleep as soon as the mode is reached */
+    SIM_PWR_Pass(s_sSim.u64Now + s_sSim.au32Entry[u32State], SIM_PWR_TRANS);
+    SIM_PWR_Pass(u64Wake, u32State);
+    SIM_PWR_Pass(s_sSim.u64Now + s_sSim.au32Exit[u32State], SIM_PWR_TRANS);
+
+    /* Everything that came up meanwhile, in order */
+    while (SIM_PWR_FireNext(s_sSim.u64Now, u32State != SIM_PWR_SLEEP))
+        ;
+    s_sSim.u64Checked = s_sSim.u64Now;
+}
+
+/**
+  * @brief      Model time, microseconds.
+  */
+uint64_t SIM_PWR_GetTime(void)
+{
+    return s_sSim.u64Now;
+}
+
+/**
+  * @brief      Start the accounting again.
+  */
+void SIM_PWR_ResetStat(void)
+{
+    memset(&s_sSim.sStat, 0, sizeof(s_sSim.sStat));
+}
+
+/**
+  * @brief      Where the time went.
+  */
+const SIM_PWR_STAT_T *SIM_PWR_GetStat(void)
+{
+    return &s_sSim.sStat;
+}
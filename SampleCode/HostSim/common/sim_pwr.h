@@ -0,0 +1,73 @@
+/**************************************************************************//**
+ * @file     sim_pwr.h
+ * @version  V1.00
+ * @brief    Host model of the power modes and a wake-up timer, shared by the HostSim checks.
+ *
+ * @details  Model time counts microseconds. The CPU runs for the time given to
+ *           SIM_PWR_Run(); __WFI() lets time pass in the mode selected by
+ *           SCB->SCR.SLEEPDEEP, CLK->PWRCTL.PDEN and CLK->PMUCTL.PDMSEL until
+ *           an interrupt, taking the entry and exit latency of the mode set by
+ *           SIM_PWR_SetLatency(), and the time spent in each mode is
+ *           accounted. TIMER0 counts in continuous mode from a clock that keeps
+ *           running in power-down (LXT or LIRC); when CNT reaches CMP it sets
+ *           TIF, and TWKF when it wakes the chip, and calls the handler set by
+ *           SIM_PWR_SetTimerIrq() if INTEN is set. Other interrupts, such as a
+ *           wake-up pin, are events added with SIM_PWR_AddEvent(). The
+ *           prescaler, the other timer modes and PRIMASK are not modelled:
+ *           handlers run when their event is due, at the end of __WFI() while
+ *           the CPU sleeps.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_PWR_H__
+#define __SIM_PWR_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_PWR_RUN             0ul     /*!< CPU running */
+#define SIM_PWR_SLEEP           1ul     /*!< Idle: WFI without SLEEPDEEP or PDEN */
+#define SIM_PWR_FWPD            2ul     /*!< Fast Wake-up Power-down */
+#define SIM_PWR_PD              3ul     /*!< Normal Power-down */
+#define SIM_PWR_LLPD            4ul     /*!< Low Leakage Power-down */
+#define SIM_PWR_TRANS           5ul     /*!< Entering or leaving a mode */
+#define SIM_PWR_STATE_CNT       6ul
+
+#define SIM_PWR_MAX_EVENTS      8ul     /*!< Events pending at once */
+
+/**
+  * @brief   Interrupt handler of the model.
+  */
+typedef void (*SIM_PWR_IRQ_CB)(void *pvPriv);
+
+/**
+  * @brief   Where the time went, since SIM_PWR_Init() or SIM_PWR_ResetStat().
+  */
+typedef struct
+{
+    uint64_t au64Time[SIM_PWR_STATE_CNT];       /*!< Microseconds in each state */
+    uint32_t au32Entries[SIM_PWR_STATE_CNT];    /*!< __WFI() calls that entered each mode */
+    uint32_t u32TimerWakeups;                   /*!< Wake-ups by TIMER0 */
+    uint32_t u32EventWakeups;                   /*!< Wake-ups by an event */
+    uint32_t u32Stuck;                          /*!< __WFI() with no wake-up source: returned at once */
+} SIM_PWR_STAT_T;
+
+int32_t  SIM_PWR_Init(uint32_t u32TimerClk);
+void     SIM_PWR_SetLatency(uint32_t u32State, uint32_t u32Entry, uint32_t u32Exit);
+void     SIM_PWR_SetTimerIrq(SIM_PWR_IRQ_CB pfnIrq, void *pvPriv);
+int32_t  SIM_PWR_AddEvent(uint64_t u64At, SIM_PWR_IRQ_CB pfnIrq, void *pvPriv);
+void     SIM_PWR_Run(uint32_t u32Us);
+uint64_t SIM_PWR_GetTime(void);
+void     SIM_PWR_ResetStat(void);
+const SIM_PWR_STAT_T *SIM_PWR_GetStat(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_PWR_H__ */
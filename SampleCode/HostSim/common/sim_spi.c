@@ -0,0 +1,250 @@
+/**************************************************************************//**
+ * @file     sim_spi.c
+ * @version  V1.00
+ * @brief    Host model of QSPI0 and SPI0 in master mode shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_pdma.h"
+#include "sim_spi.h"
+
+#define SIM_SPI_FIFO_DEPTH      8
+
+typedef struct
+{
+    uint32_t u32Base;
+    uint32_t u32ReqTx;                  /* PDMA request sources, RX is the next one */
+
+    uint8_t  au8Rx[SIM_SPI_FIFO_DEPTH];
+    uint32_t u32RxCnt;
+    uint8_t  au8Tx[SIM_SPI_FIFO_DEPTH];
+    uint32_t u32TxCnt;
+
+    uint32_t u32Selects;                /* SS activations */
+    uint32_t u32RxOverruns;
+} SIM_SPI_PORT_T;
+
+static SIM_SPI_PORT_T s_asPort[SIM_SPI_PORT_CNT];
+static SIM_SPI_SHIFT_T s_pfnShift;
+
+/* Recompute STATUS from the FIFOs; the register page is writable when called */
+static void SIM_SPI_Update(SIM_SPI_PORT_T *psPort)
+{
+    SPI_T *spi = (SPI_T *)(uintptr_t)psPort->u32Base;
+    uint32_t u32Sts;
+
+    u32Sts = (psPort->u32RxCnt << SPI_STATUS_RXCNT_Pos) | (psPort->u32TxCnt << SPI_STATUS_TXCNT_Pos);
+    u32Sts |= (psPort->u32RxCnt == 0) ? SPI_STATUS_RXEMPTY_Msk : 0;
+    u32Sts |= (psPort->u32RxCnt == SIM_SPI_FIFO_DEPTH) ? SPI_STATUS_RXFULL_Msk : 0;
+    u32Sts |= (psPort->u32TxCnt == 0) ? SPI_STATUS_TXEMPTY_Msk : (SPI_STATUS_BUSY_Msk);
+    u32Sts |= (psPort->u32TxCnt == SIM_SPI_FIFO_DEPTH) ? SPI_STATUS_TXFULL_Msk : 0;
+    u32Sts |= (spi->CTL & SPI_CTL_SPIEN_Msk) ? SPI_STATUS_SPIENSTS_Msk : 0;
+    spi->STATUS = u32Sts;
+}
+
+/* One byte time: the oldest TX FIFO entry goes out, the device answer comes in unless in output mode */
+static void SIM_SPI_Shift(SIM_SPI_PORT_T *psPort)
+{
+    SPI_T *spi = (SPI_T *)(uintptr_t)psPort->u32Base;
+    uint32_t u32Ctl = spi->CTL;
+    uint8_t u8In;
+
+    if (!psPort->u32TxCnt || !(u32Ctl & SPI_CTL_SPIEN_Msk))
+        return;
+
+    u8In = (s_pfnShift != NULL) ? s_pfnShift(psPort - s_asPort, u32Ctl, spi->CLKDIV, spi->SSCTL, psPort->au8Tx[0]) : 0xFF;
+    memmove(psPort->au8Tx, psPort->au8Tx + 1, --psPort->u32TxCnt);
+
+    if ((u32Ctl & (QSPI_CTL_DUALIOEN_Msk | QSPI_CTL_QUADIOEN_Msk)) && (u32Ctl & QSPI_CTL_DATDIR_Msk))
+        return;
+
+    if (psPort->u32RxCnt < SIM_SPI_FIFO_DEPTH)
+        psPort->au8Rx[psPort->u32RxCnt++] = u8In;
+    else
+        psPort->u32RxOverruns++;
+}
+
+static uint32_t SIM_SPI_Read(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur)
+{
+    SIM_SPI_PORT_T *psPort = (SIM_SPI_PORT_T *)pvPriv;
+
+    if (u32Offset == offsetof(SPI_T, RX))
+    {
+        u32Cur = 0;
+
+        if (psPort->u32RxCnt)
+        {
+            u32Cur = psPort->au8Rx[0];
+            memmove(psPort->au8Rx, psPort->au8Rx + 1, --psPort->u32RxCnt);
+        }
+
+        SIM_SPI_Update(psPort);
+    }
+    else if (u32Offset == offsetof(SPI_T, STATUS))
+    {
+        /* Busy-wait: the byte in the shifter finishes while the status is polled */
+        SIM_SPI_Shift(psPort);
+        SIM_SPI_Update(psPort);
+        u32Cur = ((SPI_T *)(uintptr_t)psPort->u32Base)->STATUS;
+    }
+
+    return u32Cur;
+}
+
+static uint32_t SIM_SPI_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    SIM_SPI_PORT_T *psPort = (SIM_SPI_PORT_T *)pvPriv;
+    SPI_T *spi = (SPI_T *)(uintptr_t)psPort->u32Base;
+
+    switch (u32Offset)
+    {
+    case offsetof(SPI_T, TX):
+        if (psPort->u32TxCnt < SIM_SPI_FIFO_DEPTH)
+            psPort->au8Tx[psPort->u32TxCnt++] = (uint8_t)u32New;
+        SIM_SPI_Update(psPort);
+        return u32Old;
+
+    case offsetof(SPI_T, FIFOCTL):
+        if (u32New & (SPI_FIFOCTL_RXRST_Msk | SPI_FIFOCTL_RXFBCLR_Msk))
+            psPort->u32RxCnt = 0;
+        if (u32New & (SPI_FIFOCTL_TXRST_Msk | SPI_FIFOCTL_TXFBCLR_Msk))
+            psPort->u32TxCnt = 0;
+        u32New &= ~(SPI_FIFOCTL_RXRST_Msk | SPI_FIFOCTL_TXRST_Msk | SPI_FIFOCTL_RXFBCLR_Msk | SPI_FIFOCTL_TXFBCLR_Msk);
+        spi->FIFOCTL = u32New;
+        SIM_SPI_Update(psPort);
+        return u32New;
+
+    case offsetof(SPI_T, PDMACTL):
+        /* PDMARST clears the request enables and reads back 0 */
+        return (u32New & SPI_PDMACTL_PDMARST_Msk) ? 0 : u32New;
+
+    case offsetof(SPI_T, SSCTL):
+        if ((u32New & SPI_SSCTL_SS_Msk) && !(u32Old & SPI_SSCTL_SS_Msk))
+            psPort->u32Selects++;
+        return u32New;
+
+    case offsetof(SPI_T, CTL):
+        spi->CTL = u32New;
+        SIM_SPI_Update(psPort);
+        return u32New;
+
+    default:
+        return u32New;
+    }
+}
+
+/**
+  * @brief      Map QSPI0 and SPI0, trap their registers and let PDMA reach the data ports.
+  * @param[in]  pfnShift  Device side of the shifted bytes, or NULL to read 0xFF.
+  * @return     HOSTSIM_OK or the HOSTSIM error. SIM_PDMA_Init() must have been called.
+  */
+int32_t SIM_SPI_Init(SIM_SPI_SHIFT_T pfnShift)
+{
+    SIM_SPI_PORT_T *psPort;
+    uint32_t u32Port;
+    int32_t i32Ret;
+
+    memset(s_asPort, 0, sizeof(s_asPort));
+    s_pfnShift = pfnShift;
+
+    s_asPort[SIM_SPI_QSPI0].u32Base = QSPI0_BASE;
+    s_asPort[SIM_SPI_QSPI0].u32ReqTx = PDMA_QSPI0_TX;
+    s_asPort[SIM_SPI_SPI0].u32Base = SPI0_BASE;
+    s_asPort[SIM_SPI_SPI0].u32ReqTx = PDMA_SPI0_TX;
+
+    /* Both register pages are adjacent, one PDMA memory window covers them */
+    if (((i32Ret = HOSTSIM_MapPeriph(QSPI0_BASE, 2 * HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK) ||
+            ((i32Ret = SIM_PDMA_AddMemory(QSPI0_BASE, 2 * HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK))
+        return i32Ret;
+
+    for (u32Port = 0; u32Port < SIM_SPI_PORT_CNT; u32Port++)
+    {
+        psPort = &s_asPort[u32Port];
+        SIM_SPI_Update(psPort);
+
+        if (((i32Ret = HOSTSIM_TrapWrites(psPort->u32Base, HOSTSIM_PAGE_SIZE, SIM_SPI_Write, psPort)) != HOSTSIM_OK) ||
+                ((i32Ret = HOSTSIM_TrapReads(psPort->u32Base, HOSTSIM_PAGE_SIZE, SIM_SPI_Read, psPort)) != HOSTSIM_OK))
+            return i32Ret;
+    }
+
+    return HOSTSIM_OK;
+}
+
+/* Single requests while the FIFOs ask for them; the page is locked so PDMA goes through the traps */
+static void SIM_SPI_ServePdma(SIM_SPI_PORT_T *psPort)
+{
+    SPI_T *spi = (SPI_T *)(uintptr_t)psPort->u32Base;
+    uint32_t u32Pdma, u32Cnt;
+
+    HOSTSIM_Unlock(psPort->u32Base);
+    u32Pdma = spi->PDMACTL;
+    HOSTSIM_Lock(psPort->u32Base);
+
+    while ((u32Pdma & SPI_PDMACTL_RXPDMAEN_Msk) && psPort->u32RxCnt)
+    {
+        u32Cnt = psPort->u32RxCnt;
+        if (!SIM_PDMA_PeriphReq(psPort->u32ReqTx + 1) || (psPort->u32RxCnt == u32Cnt))
+            break;
+    }
+
+    HOSTSIM_Unlock(psPort->u32Base);
+    u32Pdma = spi->PDMACTL;
+    HOSTSIM_Lock(psPort->u32Base);
+
+    while ((u32Pdma & SPI_PDMACTL_TXPDMAEN_Msk) && (psPort->u32TxCnt < SIM_SPI_FIFO_DEPTH))
+    {
+        u32Cnt = psPort->u32TxCnt;
+        if (!SIM_PDMA_PeriphReq(psPort->u32ReqTx) || (psPort->u32TxCnt == u32Cnt))
+            break;
+
+        /* The PDMA interrupt of the request may have turned the requests off */
+        HOSTSIM_Unlock(psPort->u32Base);
+        u32Pdma = spi->PDMACTL;
+        HOSTSIM_Lock(psPort->u32Base);
+    }
+}
+
+/**
+  * @brief      Advance both ports by a number of byte times.
+  */
+void SIM_SPI_Run(uint32_t u32Bytes)
+{
+    SIM_SPI_PORT_T *psPort;
+    uint32_t u32Port;
+
+    while (u32Bytes--)
+    {
+        for (u32Port = 0; u32Port < SIM_SPI_PORT_CNT; u32Port++)
+        {
+            psPort = &s_asPort[u32Port];
+
+            HOSTSIM_Unlock(psPort->u32Base);
+            SIM_SPI_Shift(psPort);
+            SIM_SPI_Update(psPort);
+            HOSTSIM_Lock(psPort->u32Base);
+
+            SIM_SPI_ServePdma(psPort);
+        }
+    }
+}
+
+/**
+  * @brief      Number of times SSCTL.SS of a port went active.
+  */
+uint32_t SIM_SPI_GetSelects(uint32_t u32Port)
+{
+    return s_asPort[u32Port].u32Selects;
+}
+
+/**
+  * @brief      Bytes lost because the RX FIFO of a port was full.
+  */
+uint32_t SIM_SPI_GetRxOverruns(uint32_t u32Port)
+{
+    return s_asPort[u32Port].u32RxOverruns;
+}
@@ -0,0 +1,54 @@
+/**************************************************************************//**
+ * @file     sim_spi.h
+ * @version  V1.00
+ * @brief    Host model of QSPI0 and SPI0 in master mode shared by the HostSim checks.
+ *
+ * @details  The model keeps the 8-level TX and RX FIFOs behind TX/RX and
+ *           derives STATUS from them. Time advances in byte times with
+ *           SIM_SPI_Run(): each byte time shifts one byte from the TX FIFO
+ *           through the host device callback, which also gets CTL, CLKDIV and
+ *           SSCTL as the controller drives them, and serves the PDMA requests
+ *           of ../common/sim_pdma.c. In dual/quad output mode nothing enters
+ *           the RX FIFO. Polling STATUS while the TX FIFO holds data lets a
+ *           byte time pass, as a busy-wait on the target does.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_SPI_H__
+#define __SIM_SPI_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_SPI_QSPI0           0       /*!< QSPI0 port */
+#define SIM_SPI_SPI0            1       /*!< SPI0 port */
+#define SIM_SPI_PORT_CNT        2
+
+/**
+  * @brief   Device side of one shifted byte.
+  * @param[in] u32Port   SIM_SPI_QSPI0 or SIM_SPI_SPI0.
+  * @param[in] u32Ctl    CTL while the byte is shifted (mode, line mode, direction).
+  * @param[in] u32ClkDiv CLKDIV while the byte is shifted.
+  * @param[in] u32SSCtl  SSCTL while the byte is shifted.
+  * @param[in] u8Out     Byte driven by the controller (ignored by a device in input mode).
+  * @return  Byte driven by the device, dropped in output mode.
+  * @details Called from the model, possibly while a register trap is served: it must not touch
+  *          the registers of the SPI ports or PDMA.
+  */
+typedef uint8_t (*SIM_SPI_SHIFT_T)(uint32_t u32Port, uint32_t u32Ctl, uint32_t u32ClkDiv, uint32_t u32SSCtl, uint8_t u8Out);
+
+int32_t  SIM_SPI_Init(SIM_SPI_SHIFT_T pfnShift);
+void     SIM_SPI_Run(uint32_t u32Bytes);
+uint32_t SIM_SPI_GetSelects(uint32_t u32Port);
+uint32_t SIM_SPI_GetRxOverruns(uint32_t u32Port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_SPI_H__ */
@@ -0,0 +1,581 @@
+/**************************************************************************//**
+ * @file     sim_spim.c
+ * @version  V1.00
+ * @brief    Host model of SPIM with a serial NOR flash attached, shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_spim.h"
+
+#define SIM_SPIM_FRAME_MAX      (8 + 256)
+
+#define SIM_SPIM_SR1_WIP        0x01u
+#define SIM_SPIM_SR1_WEL        0x02u
+#define SIM_SPIM_SR2_SUS        0x80u
+
+#define SIM_SPIM_OP_NONE        0
+#define SIM_SPIM_OP_PROGRAM     1
+#define SIM_SPIM_OP_ERASE       2
+#define SIM_SPIM_OP_STATUS      3
+
+typedef struct
+{
+    uint8_t  au8Array[SIM_SPIM_FLASH_SIZE];
+    uint8_t  u8Sr1, u8Sr2, u8Sr3;
+
+    /* Program, erase or status write in progress */
+    uint32_t u32Op;
+    uint32_t u32Remain;                 /* Ticks left */
+    uint32_t u32OpAddr;
+    uint32_t u32OpLen;
+    uint8_t  au8Latch[256];             /* Page buffer of a program */
+    uint32_t u32Suspended;
+    uint32_t u32SusRemain;              /* Ticks until a requested suspend takes effect, 0 for none */
+
+    /* I/O mode frame between chip select edges */
+    uint8_t  au8Frame[SIM_SPIM_FRAME_MAX];
+    uint32_t u32FrameLen;
+    uint32_t u32InCnt;
+
+    /* Page Write/Read mode transfer */
+    uint32_t u32DmaMode;                /* SPIM_CTL0_OPMODE_PAGEWRITE/PAGEREAD, 0 for none */
+    uint32_t u32DmaRemain;
+    uint32_t u32DmaAddr;
+    uint32_t u32DmaSram;
+    uint32_t u32DmaLen;
+    uint32_t u32DmaWait;                /* Page Write mode waits for the program to finish */
+
+    /* Power failure */
+    uint32_t u32CutCnt;                 /* Programs and erases until the torn one, 0 for none */
+    uint32_t u32PowerOff;               /* Power is gone: program and erase commands do nothing */
+
+    uint32_t u32Ticks;
+    SIM_SPIM_STAT_T sStat;
+} SIM_SPIM_T;
+
+static SIM_SPIM_T s_sSim;
+
+static const uint8_t s_au8JedecId[3] = { 0xEF, 0x40, 0x15 };
+
+static uint32_t SIM_SPIM_Busy(void)
+{
+    return (s_sSim.u8Sr1 & SIM_SPIM_SR1_WIP) ? 1 : 0;
+}
+
+/* Program, erase and status write need WEL and a flash that is neither busy nor suspended */
+static uint32_t SIM_SPIM_CanWrite(void)
+{
+    if (s_sSim.u32PowerOff)
+        return 0;
+
+    if ((s_sSim.u8Sr1 & SIM_SPIM_SR1_WEL) && (s_sSim.u32Op == SIM_SPIM_OP_NONE))
+        return 1;
+
+    s_sSim.sStat.u32Rejected++;
+    return 0;
+}
+
+/* Power fails half way through the program or erase just started */
+static void SIM_SPIM_Tear(void)
+{
+    uint32_t i;
+
+    if (s_sSim.u32Op == SIM_SPIM_OP_PROGRAM)
+    {
+        /* Every byte of the page only gets its low bits programmed */
+        for (i = 0; i < 256; i++)
+            s_sSim.au8Array[s_sSim.u32OpAddr + i] &= (uint8_t)(s_sSim.au8Latch[i] | 0xF0u);
+    }
+    else
+    {
+        memset(&s_sSim.au8Array[s_sSim.u32OpAddr], 0xFF, s_sSim.u32OpLen / 2);
+    }
+
+    s_sSim.u32Op = SIM_SPIM_OP_NONE;
+    s_sSim.u8Sr1 &= (uint8_t)~(SIM_SPIM_SR1_WIP | SIM_SPIM_SR1_WEL);
+    s_sSim.u32PowerOff = 1;
+}
+
+static void SIM_SPIM_StartOp(uint32_t u32Op, uint32_t u32Addr, uint32_t u32Len, uint32_t u32Ticks)
+{
+    s_sSim.u32Op = u32Op;
+    s_sSim.u32OpAddr = u32Addr % SIM_SPIM_FLASH_SIZE;
+    s_sSim.u32OpLen = u32Len;
+    s_sSim.u32Remain = u32Ticks;
+    s_sSim.u8Sr1 |= SIM_SPIM_SR1_WIP;
+
+    if (s_sSim.u32CutCnt && (u32Op != SIM_SPIM_OP_STATUS) && (--s_sSim.u32CutCnt == 0))
+        SIM_SPIM_Tear();
+}
+
+/* Latch a page program; the bytes wrap inside the page and only clear bits when the program ends */
+static void SIM_SPIM_Program(uint32_t u32Addr, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t i;
+
+    memset(s_sSim.au8Latch, 0xFF, sizeof(s_sSim.au8Latch));
+
+    for (i = 0; i < u32Len; i++)
+        s_sSim.au8Latch[(u32Addr + i) & 0xFF] &= pu8Data[i];
+
+    SIM_SPIM_StartOp(SIM_SPIM_OP_PROGRAM, u32Addr & ~0xFFul, 256, SIM_SPIM_T_PP);
+}
+
+static void SIM_SPIM_FinishOp(void)
+{
+    uint32_t i;
+
+    if (s_sSim.u32Op == SIM_SPIM_OP_PROGRAM)
+    {
+        for (i = 0; i < 256; i++)
+            s_sSim.au8Array[s_sSim.u32OpAddr + i] &= s_sSim.au8Latch[i];
+    }
+    else if (s_sSim.u32Op == SIM_SPIM_OP_ERASE)
+    {
+        memset(&s_sSim.au8Array[s_sSim.u32OpAddr], 0xFF, s_sSim.u32OpLen);
+        s_sSim.sStat.u32Erases++;
+    }
+
+    s_sSim.u32Op = SIM_SPIM_OP_NONE;
+    s_sSim.u32SusRemain = 0;
+    s_sSim.u8Sr1 &= (uint8_t)~(SIM_SPIM_SR1_WIP | SIM_SPIM_SR1_WEL);
+}
+
+/* An array read sees undefined data while the flash is busy or inside the suspended erase */
+static void SIM_SPIM_CheckRead(uint32_t u32Addr, uint32_t u32Len)
+{
+    s_sSim.sStat.u32Reads++;
+
+    if (SIM_SPIM_Busy() ||
+            (s_sSim.u32Suspended && (u32Addr < s_sSim.u32OpAddr + s_sSim.u32OpLen) && (s_sSim.u32OpAddr < u32Addr + u32Len)))
+        s_sSim.sStat.u32BusyReads++;
+}
+
+static uint32_t SIM_SPIM_FrameAddr(uint32_t u32AddrLen)
+{
+    uint32_t u32Addr = 0, i;
+
+    for (i = 1; i <= u32AddrLen; i++)
+        u32Addr = (u32Addr << 8) | s_sSim.au8Frame[i];
+
+    return u32Addr % SIM_SPIM_FLASH_SIZE;
+}
+
+/* Command complete: chip select went inactive */
+static void SIM_SPIM_Execute(void)
+{
+    uint32_t u32Len = s_sSim.u32FrameLen;
+    uint32_t u32AddrLen = (u32Len > 4) ? 4 : 3;
+    uint32_t u32Size;
+
+    if (u32Len == 0)
+        return;
+
+    switch (s_sSim.au8Frame[0])
+    {
+    case OPCODE_WREN:
+        if (!SIM_SPIM_Busy())
+            s_sSim.u8Sr1 |= SIM_SPIM_SR1_WEL;
+        break;
+
+    case OPCODE_WRDI:
+        if (!SIM_SPIM_Busy())
+            s_sSim.u8Sr1 &= (uint8_t)~SIM_SPIM_SR1_WEL;
+        break;
+
+    case OPCODE_WRSR:
+        if ((u32Len >= 2) && SIM_SPIM_CanWrite())
+        {
+            s_sSim.u8Sr1 = (uint8_t)((s_sSim.u8Sr1 & 0x03u) | (s_sSim.au8Frame[1] & 0xFCu));
+            if (u32Len >= 3)
+                s_sSim.u8Sr2 = (uint8_t)((s_sSim.u8Sr2 & SIM_SPIM_SR2_SUS) | (s_sSim.au8Frame[2] & (uint8_t)~SIM_SPIM_SR2_SUS));
+            SIM_SPIM_StartOp(SIM_SPIM_OP_STATUS, 0, 0, SIM_SPIM_T_W);
+        }
+        break;
+
+    case OPCODE_WRSR2:
+        if ((u32Len >= 2) && SIM_SPIM_CanWrite())
+        {
+            s_sSim.u8Sr2 = (uint8_t)((s_sSim.u8Sr2 & SIM_SPIM_SR2_SUS) | (s_sSim.au8Frame[1] & (uint8_t)~SIM_SPIM_SR2_SUS));
+            SIM_SPIM_StartOp(SIM_SPIM_OP_STATUS, 0, 0, SIM_SPIM_T_W);
+        }
+        break;
+
+    case OPCODE_PP:
+        if ((u32Len >= 4) && SIM_SPIM_CanWrite())
+        {
+            s_sSim.sStat.u32IoPrograms++;
+            SIM_SPIM_Program(SIM_SPIM_FrameAddr(3), &s_sSim.au8Frame[4], u32Len - 4);
+        }
+        break;
+
+    case OPCODE_SE_4K:
+    case OPCODE_BE_32K:
+    case OPCODE_BE_64K:
+        if ((u32Len >= 4) && SIM_SPIM_CanWrite())
+        {
+            u32Size = (s_sSim.au8Frame[0] == OPCODE_SE_4K) ? 0x1000 : (s_sSim.au8Frame[0] == OPCODE_BE_32K) ? 0x8000 : 0x10000;
+            SIM_SPIM_StartOp(SIM_SPIM_OP_ERASE, SIM_SPIM_FrameAddr(u32AddrLen) & ~(u32Size - 1), u32Size,
+                             (u32Size == 0x1000) ? SIM_SPIM_T_SE : (u32Size == 0x8000) ? SIM_SPIM_T_BE32 : SIM_SPIM_T_BE64);
+        }
+        break;
+
+    case 0x75:      /* Erase suspend, Winbond */
+    case 0xB0:      /* Erase suspend, MXIC */
+        if ((s_sSim.u32Op == SIM_SPIM_OP_ERASE) && !s_sSim.u32Suspended && !s_sSim.u32SusRemain)
+            s_sSim.u32SusRemain = SIM_SPIM_T_SUS;
+        break;
+
+    case 0x7A:      /* Erase resume, Winbond */
+    case 0x30:      /* Erase resume, MXIC */
+        if (s_sSim.u32Suspended)
+        {
+            s_sSim.u32Suspended = 0;
+            s_sSim.u32Remain += SIM_SPIM_T_SUS;
+            s_sSim.u8Sr1 |= SIM_SPIM_SR1_WIP;
+            s_sSim.u8Sr2 &= (uint8_t)~SIM_SPIM_SR2_SUS;
+            s_sSim.sStat.u32Resumes++;
+        }
+        break;
+
+    case OPCODE_RST:
+        if (!SIM_SPIM_Busy())
+            s_sSim.u8Sr1 &= (uint8_t)~SIM_SPIM_SR1_WEL;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Byte the flash drives in the current frame */
+static uint8_t SIM_SPIM_In(void)
+{
+    uint32_t u32Idx = s_sSim.u32InCnt++;
+    uint32_t u32Addr;
+
+    switch (s_sSim.au8Frame[0])
+    {
+    case OPCODE_RDSR:
+        if (u32Idx == 0)
+            s_sSim.sStat.u32StatusReads++;
+        return s_sSim.u8Sr1;
+
+    case OPCODE_RDSR2:
+        return s_sSim.u8Sr2;
+
+    case OPCODE_RDSR3:
+        return s_sSim.u8Sr3;
+
+    case OPCODE_RDID:
+        return (u32Idx < sizeof(s_au8JedecId)) ? s_au8JedecId[u32Idx] : 0;
+
+    case OPCODE_RDSCUR:
+        return 0;
+
+    case OPCODE_NORM_READ:
+    case OPCODE_FAST_READ:
+        u32Addr = SIM_SPIM_FrameAddr(3);
+        if (u32Idx == 0)
+            SIM_SPIM_CheckRead(u32Addr, 1);
+        return SIM_SPIM_Busy() ? 0xFF : s_sSim.au8Array[(u32Addr + u32Idx) % SIM_SPIM_FLASH_SIZE];
+
+    default:
+        return 0xFF;
+    }
+}
+
+/* I/O mode transfer: TX[n-1] goes first, each word low byte first; RX fills the same way */
+static void SIM_SPIM_IoTransfer(void)
+{
+    uint32_t u32Ctl0 = SPIM->CTL0;
+    uint32_t u32Bytes = (((u32Ctl0 & SPIM_CTL0_DWIDTH_Msk) >> SPIM_CTL0_DWIDTH_Pos) + 1) / 8;
+    uint32_t u32Words = ((u32Ctl0 & SPIM_CTL0_BURSTNUM_Msk) >> SPIM_CTL0_BURSTNUM_Pos) + 1;
+    uint32_t u32Word, w, b;
+
+    for (w = u32Words; w-- > 0;)
+    {
+        if (u32Ctl0 & SPIM_CTL0_QDIODIR_Msk)
+        {
+            u32Word = SPIM->TX[w];
+            for (b = 0; b < u32Bytes; b++)
+            {
+                if (s_sSim.u32FrameLen < SIM_SPIM_FRAME_MAX)
+                    s_sSim.au8Frame[s_sSim.u32FrameLen++] = (uint8_t)(u32Word >> (8 * b));
+            }
+        }
+        else
+        {
+            u32Word = 0;
+            for (b = 0; b < u32Bytes; b++)
+                u32Word |= (uint32_t)SIM_SPIM_In() << (8 * b);
+            ((volatile uint32_t *)SPIM->RX)[w] = u32Word;
+        }
+    }
+}
+
+/* Page Write/Read mode data phase done */
+static void SIM_SPIM_DmaDone(void)
+{
+    uint8_t *pu8Sram = (uint8_t *)(uintptr_t)s_sSim.u32DmaSram;
+    uint32_t u32Len = s_sSim.u32DmaLen;
+    uint32_t i;
+
+    if (s_sSim.u32DmaMode == SPIM_CTL0_OPMODE_PAGEWRITE)
+    {
+        /* The controller sends write enable before the program command */
+        if (!SIM_SPIM_Busy() && !s_sSim.u32Suspended)
+            s_sSim.u8Sr1 |= SIM_SPIM_SR1_WEL;
+
+        if (SIM_SPIM_CanWrite())
+        {
+            s_sSim.sStat.u32PageWrites++;
+            SIM_SPIM_Program(s_sSim.u32DmaAddr, pu8Sram, (u32Len > 256) ? 256 : u32Len);
+            s_sSim.u32DmaWait = 1;
+            s_sSim.u32DmaMode = 0;
+            return;
+        }
+    }
+    else
+    {
+        SIM_SPIM_CheckRead(s_sSim.u32DmaAddr, u32Len);
+
+        for (i = 0; i < u32Len; i++)
+            pu8Sram[i] = SIM_SPIM_Busy() ? 0xFF : s_sSim.au8Array[(s_sSim.u32DmaAddr + i) % SIM_SPIM_FLASH_SIZE];
+    }
+
+    s_sSim.u32DmaMode = 0;
+    SPIM->CTL1 &= ~SPIM_CTL1_SPIMEN_Msk;
+}
+
+/* One tick; the register page is writable when called */
+static void SIM_SPIM_Tick(void)
+{
+    s_sSim.u32Ticks++;
+
+    if ((s_sSim.u32Op != SIM_SPIM_OP_NONE) && !s_sSim.u32Suspended)
+    {
+        if (--s_sSim.u32Remain == 0)
+        {
+            SIM_SPIM_FinishOp();
+        }
+        else if (s_sSim.u32SusRemain && (--s_sSim.u32SusRemain == 0))
+        {
+            s_sSim.u32Suspended = 1;
+            s_sSim.u8Sr1 &= (uint8_t)~SIM_SPIM_SR1_WIP;
+            s_sSim.u8Sr2 |= SIM_SPIM_SR2_SUS;
+            s_sSim.sStat.u32Suspends++;
+        }
+    }
+
+    if (s_sSim.u32DmaMode)
+    {
+        if (--s_sSim.u32DmaRemain == 0)
+            SIM_SPIM_DmaDone();
+    }
+    else if (s_sSim.u32DmaWait && (s_sSim.u32Op == SIM_SPIM_OP_NONE))
+    {
+        s_sSim.u32DmaWait = 0;
+        SPIM->CTL1 &= ~SPIM_CTL1_SPIMEN_Msk;
+    }
+}
+
+static uint32_t SIM_SPIM_Read(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur)
+{
+    (void)pvPriv;
+
+    /* Busy-wait: a tick passes while SPIMEN is polled */
+    if ((u32Offset == offsetof(SPIM_T, CTL1)) && (u32Cur & SPIM_CTL1_SPIMEN_Msk))
+    {
+        SIM_SPIM_Tick();
+        u32Cur = SPIM->CTL1;
+    }
+
+    return u32Cur;
+}
+
+static uint32_t SIM_SPIM_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    uint32_t u32OpMode;
+
+    (void)pvPriv;
+
+    if (u32Offset != offsetof(SPIM_T, CTL1))
+        return u32New;
+
+    /* SS is 0 while the chip select is active */
+    if (!(u32New & SPIM_CTL1_SS_Msk) && (u32Old & SPIM_CTL1_SS_Msk))
+    {
+        s_sSim.u32FrameLen = 0;
+        s_sSim.u32InCnt = 0;
+    }
+    else if ((u32New & SPIM_CTL1_SS_Msk) && !(u32Old & SPIM_CTL1_SS_Msk))
+    {
+        SIM_SPIM_Execute();
+        s_sSim.u32FrameLen = 0;
+    }
+
+    if (!(u32New & SPIM_CTL1_SPIMEN_Msk) || (u32Old & SPIM_CTL1_SPIMEN_Msk))
+        return u32New;
+
+    SPIM->CTL1 = u32New;
+    u32OpMode = SPIM->CTL0 & SPIM_CTL0_OPMODE_Msk;
+
+    if (u32OpMode == SPIM_CTL0_OPMODE_IO)
+    {
+        if (!(u32New & SPIM_CTL1_SS_Msk))
+            SIM_SPIM_IoTransfer();
+        SIM_SPIM_Tick();
+        return u32New & ~SPIM_CTL1_SPIMEN_Msk;
+    }
+
+    if ((u32OpMode == SPIM_CTL0_OPMODE_PAGEWRITE) || (u32OpMode == SPIM_CTL0_OPMODE_PAGEREAD))
+    {
+        s_sSim.u32DmaMode = u32OpMode;
+        s_sSim.u32DmaSram = SPIM->SRAMADDR;
+        s_sSim.u32DmaLen = SPIM->DMACNT & SPIM_DMACNT_DMACNT_Msk;
+        s_sSim.u32DmaAddr = SPIM->FADDR % SIM_SPIM_FLASH_SIZE;
+        s_sSim.u32DmaRemain = 1 + s_sSim.u32DmaLen / SIM_SPIM_DMA_RATE;
+        return u32New;
+    }
+
+    return u32New & ~SPIM_CTL1_SPIMEN_Msk;
+}
+
+/**
+  * @brief      Map SPIM, trap its registers and erase the flash.
+  * @return     HOSTSIM_OK or the HOSTSIM error.
+  */
+int32_t SIM_SPIM_Init(void)
+{
+    int32_t i32Ret;
+
+    memset(&s_sSim, 0, sizeof(s_sSim));
+    memset(s_sSim.au8Array, 0xFF, sizeof(s_sSim.au8Array));
+
+    if ((i32Ret = HOSTSIM_MapPeriph(SPIM_BASE, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK)
+        return i32Ret;
+
+    SPIM->CTL1 = SPIM_CTL1_SS_Msk;
+
+    if (((i32Ret = HOSTSIM_TrapWrites(SPIM_BASE, HOSTSIM_PAGE_SIZE, SIM_SPIM_Write, NULL)) != HOSTSIM_OK) ||
+            ((i32Ret = HOSTSIM_TrapReads(SPIM_BASE, HOSTSIM_PAGE_SIZE, SIM_SPIM_Read, NULL)) != HOSTSIM_OK))
+        return i32Ret;
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      Let a number of ticks (microseconds) pass.
+  */
+void SIM_SPIM_Run(uint32_t u32Ticks)
+{
+    HOSTSIM_Unlock(SPIM_BASE);
+
+    while (u32Ticks--)
+        SIM_SPIM_Tick();
+
+    HOSTSIM_Lock(SPIM_BASE);
+}
+
+/**
+  * @brief      Let time pass until the flash and SPIM have nothing left to do, or u32Max ticks.
+  * @return     Ticks that passed.
+  * @details    Stops where software polling the status would see a change: a program, erase or
+  *             transfer done, or an erase suspended. Lets a blocking caller skip the polls between.
+  */
+uint32_t SIM_SPIM_RunBusy(uint32_t u32Max)
+{
+    uint32_t u32Ticks = 0;
+
+    HOSTSIM_Unlock(SPIM_BASE);
+
+    while ((u32Ticks < u32Max) &&
+            (((s_sSim.u32Op != SIM_SPIM_OP_NONE) && !s_sSim.u32Suspended) || s_sSim.u32DmaMode || s_sSim.u32DmaWait))
+    {
+        SIM_SPIM_Tick();
+        u32Ticks++;
+    }
+
+    HOSTSIM_Lock(SPIM_BASE);
+
+    return u32Ticks;
+}
+
+/**
+  * @brief      Cut the power during a later program or erase.
+  * @param      u32Ops      The program or erase to tear, 1 for the next one.
+  * @details    A torn page program leaves only the low four bits of each byte programmed, a
+  *             torn erase only the first half of the block erased. Program and erase commands then do nothing until SIM_SPIM_PowerOn();
+  *             reads still see the array, so the software keeps running to a clean stop.
+  */
+void SIM_SPIM_PowerCut(uint32_t u32Ops)
+{
+    s_sSim.u32CutCnt = u32Ops;
+}
+
+/**
+  * @brief      The power cut set by SIM_SPIM_PowerCut() has happened.
+  */
+uint32_t SIM_SPIM_IsPowerOff(void)
+{
+    return s_sSim.u32PowerOff;
+}
+
+/**
+  * @brief      Power up again: the array is kept, flash and SPIM states are reset.
+  */
+void SIM_SPIM_PowerOn(void)
+{
+    s_sSim.u32CutCnt = 0;
+    s_sSim.u32PowerOff = 0;
+    s_sSim.u32Op = SIM_SPIM_OP_NONE;
+    s_sSim.u32Suspended = 0;
+    s_sSim.u32SusRemain = 0;
+    s_sSim.u32FrameLen = 0;
+    s_sSim.u32DmaMode = 0;
+    s_sSim.u32DmaWait = 0;
+    s_sSim.u8Sr1 &= (uint8_t)~(SIM_SPIM_SR1_WIP | SIM_SPIM_SR1_WEL);
+    s_sSim.u8Sr2 &= (uint8_t)~SIM_SPIM_SR2_SUS;
+
+    HOSTSIM_Unlock(SPIM_BASE);
+    SPIM->CTL1 = SPIM_CTL1_SS_Msk;
+    HOSTSIM_Lock(SPIM_BASE);
+}
+
+/**
+  * @brief      Model time, usable as pfnGetTime of the drivers.
+  */
+uint32_t SIM_SPIM_GetTicks(void)
+{
+    return s_sSim.u32Ticks;
+}
+
+/**
+  * @brief      A program, erase (suspended included) or status write is in progress, or SPIM is busy.
+  */
+uint32_t SIM_SPIM_IsBusy(void)
+{
+    return ((s_sSim.u32Op != SIM_SPIM_OP_NONE) || s_sSim.u32DmaMode || s_sSim.u32DmaWait) ? 1 : 0;
+}
+
+/**
+  * @brief      Flash array, for checking and preparing contents directly.
+  */
+uint8_t *SIM_SPIM_GetArray(void)
+{
+    return s_sSim.au8Array;
+}
+
+/**
+  * @brief      Flash side counters.
+  */
+const SIM_SPIM_STAT_T *SIM_SPIM_GetStat(void)
+{
+    return &s_sSim.sStat;
+}
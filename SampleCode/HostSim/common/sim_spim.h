@@ -0,0 +1,75 @@
+/**************************************************************************//**
+ * @file     sim_spim.h
+ * @version  V1.00
+ * @brief    Host model of SPIM with a serial NOR flash attached, shared by the HostSim checks.
+ *
+ * @details  The flash behaves like a 2 MB Winbond W25Q16: status registers
+ *           with WIP/WEL/QE/SUS, write enable, page program, 4 KB/32 KB/64 KB
+ *           erase, erase suspend/resume and array reads. Program and erase
+ *           take datasheet typical times, with one model tick standing for
+ *           one microsecond; while the flash is busy only the status can be
+ *           read and other commands are ignored, as on the part.
+ *           I/O mode transfers complete at once and cost one tick. Page Write
+ *           and Page Read mode move SIM_SPIM_DMA_RATE bytes per tick; Page
+ *           Write mode sends write enable itself and keeps CTL1.SPIMEN set
+ *           until the flash has finished the page, as the controller does.
+ *           Time advances with SIM_SPIM_Run(), and polling CTL1 while SPIM is
+ *           busy lets one tick pass, as a busy-wait on the target does.
+ *           SIM_SPIM_PowerCut() tears a later program or erase to check
+ *           recovery from power failure.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_SPIM_H__
+#define __SIM_SPIM_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_SPIM_FLASH_SIZE     0x200000ul  /*!< Flash array size */
+#define SIM_SPIM_DMA_RATE       8ul         /*!< Bytes Page Write/Read mode moves per tick */
+
+#define SIM_SPIM_T_PP           700ul       /*!< Page program, ticks */
+#define SIM_SPIM_T_SE           45000ul     /*!< 4 KB sector erase, ticks */
+#define SIM_SPIM_T_BE32         120000ul    /*!< 32 KB block erase, ticks */
+#define SIM_SPIM_T_BE64         150000ul    /*!< 64 KB block erase, ticks */
+#define SIM_SPIM_T_W            10000ul     /*!< Status register write, ticks */
+#define SIM_SPIM_T_SUS          20ul        /*!< Suspend latency, also lost by the erase on every suspend */
+
+/**
+  * @brief   What the flash saw, since SIM_SPIM_Init().
+  */
+typedef struct
+{
+    uint32_t u32PageWrites;         /*!< Page Write mode programs executed */
+    uint32_t u32IoPrograms;         /*!< I/O mode page programs executed */
+    uint32_t u32Erases;             /*!< Erases completed */
+    uint32_t u32Suspends;           /*!< Erases suspended */
+    uint32_t u32Resumes;            /*!< Erases resumed */
+    uint32_t u32Reads;              /*!< Array reads, I/O or Page Read mode */
+    uint32_t u32BusyReads;          /*!< Array reads while busy or of the suspended block: undefined data */
+    uint32_t u32Rejected;           /*!< Program/erase/write commands ignored: busy, suspended or no WEL */
+    uint32_t u32StatusReads;        /*!< Status register #1 reads */
+} SIM_SPIM_STAT_T;
+
+int32_t  SIM_SPIM_Init(void);
+void     SIM_SPIM_Run(uint32_t u32Ticks);
+uint32_t SIM_SPIM_RunBusy(uint32_t u32Max);
+void     SIM_SPIM_PowerCut(uint32_t u32Ops);
+uint32_t SIM_SPIM_IsPowerOff(void);
+void     SIM_SPIM_PowerOn(void);
+uint32_t SIM_SPIM_GetTicks(void);
+uint32_t SIM_SPIM_IsBusy(void);
+uint8_t *SIM_SPIM_GetArray(void);
+const SIM_SPIM_STAT_T *SIM_SPIM_GetStat(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_SPIM_H__ */
@@ -0,0 +1,470 @@
+/**************************************************************************//**
+ * @file     sim_uart.c
+ * @version  V1.00
+ * @brief    Host model of UART0 and USCI0 in UART mode shared by the HostSim checks.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hostsim.h"
+#include "sim_pdma.h"
+#include "sim_uart.h"
+
+#define SIM_UART_FIFO_MAX       16
+
+typedef struct
+{
+    uint32_t u32Base;
+    uint32_t u32Depth;                  /* 16 for UART, 2 for USCI */
+    uint32_t u32ReqTx;                  /* PDMA request sources */
+    SIM_UART_IRQ_T pfnIrq;
+
+    uint8_t  au8Rx[SIM_UART_FIFO_MAX];
+    uint32_t u32RxCnt;
+    uint8_t  au8Tx[SIM_UART_FIFO_MAX];
+    uint32_t u32TxCnt;
+
+    uint32_t u32ErrSts;                 /* Sticky FIFOSTS (UART) or PROTSTS/BUFSTS (USCI) flags */
+    uint32_t u32IntSts;                 /* Sticky RXTOIF/HWTOIF (UART) */
+    uint32_t u32NextErr;                /* SIM_UART_ERR_x for the next byte */
+    uint32_t u32IdleBits;               /* Bit times since the last byte */
+    uint32_t u32ToArmed;                /* A byte arrived since the last time-out */
+    uint32_t u32Stall;
+
+    uint8_t  au8WireIn[SIM_UART_WIRE_SIZE];
+    uint32_t u32InHead, u32InTail;
+    uint8_t  au8WireOut[SIM_UART_WIRE_SIZE];
+    uint32_t u32OutHead, u32OutTail;
+} SIM_UART_PORT_T;
+
+static SIM_UART_PORT_T s_asPort[SIM_UART_PORT_CNT];
+
+static const uint32_t s_au32RfitlBytes[4] = {1, 4, 8, 14};
+
+static uint8_t SIM_UART_RxPop(SIM_UART_PORT_T *psPort)
+{
+    uint8_t u8Data = 0;
+
+    if (psPort->u32RxCnt)
+    {
+        u8Data = psPort->au8Rx[0];
+        memmove(psPort->au8Rx, psPort->au8Rx + 1, --psPort->u32RxCnt);
+    }
+
+    return u8Data;
+}
+
+static void SIM_UART_TxPush(SIM_UART_PORT_T *psPort, uint8_t u8Data)
+{
+    if (psPort->u32TxCnt < psPort->u32Depth)
+        psPort->au8Tx[psPort->u32TxCnt++] = u8Data;
+    else if (psPort->u32Base == UART0_BASE)
+        psPort->u32ErrSts |= UART_FIFOSTS_TXOVIF_Msk;
+}
+
+/* Recompute the status registers from the FIFOs; the register page is writable when called */
+static void SIM_UART_Update(SIM_UART_PORT_T *psPort)
+{
+    UART_T *uart = (UART_T *)(uintptr_t)psPort->u32Base;
+    UUART_T *uuart = (UUART_T *)(uintptr_t)psPort->u32Base;
+    uint32_t u32Sts, u32Inten, u32Pdma;
+
+    if (psPort->u32Base == UART0_BASE)
+    {
+        u32Sts = psPort->u32ErrSts | (psPort->u32RxCnt << UART_FIFOSTS_RXPTR_Pos) | (psPort->u32TxCnt << UART_FIFOSTS_TXPTR_Pos);
+        u32Sts |= (psPort->u32RxCnt == 0) ? UART_FIFOSTS_RXEMPTY_Msk : 0;
+        u32Sts |= (psPort->u32RxCnt == psPort->u32Depth) ? UART_FIFOSTS_RXFULL_Msk : 0;
+        u32Sts |= (psPort->u32TxCnt == 0) ? (UART_FIFOSTS_TXEMPTY_Msk | UART_FIFOSTS_TXEMPTYF_Msk) : 0;
+        u32Sts |= (psPort->u32TxCnt == psPort->u32Depth) ? UART_FIFOSTS_TXFULL_Msk : 0;
+        uart->FIFOSTS = u32Sts;
+
+        /* Line errors and overflow report through the HW flags while RX PDMA is on */
+        u32Inten = uart->INTEN;
+        u32Pdma = u32Inten & UART_INTEN_RXPDMAEN_Msk;
+        u32Sts = psPort->u32IntSts;
+
+        if (psPort->u32RxCnt >= s_au32RfitlBytes[(uart->FIFO & UART_FIFO_RFITL_Msk) >> UART_FIFO_RFITL_Pos])
+            u32Sts |= UART_INTSTS_RDAIF_Msk;
+        if (psPort->u32TxCnt == 0)
+            u32Sts |= UART_INTSTS_THREIF_Msk;
+        if (psPort->u32ErrSts & (UART_FIFOSTS_BIF_Msk | UART_FIFOSTS_FEF_Msk | UART_FIFOSTS_PEF_Msk))
+            u32Sts |= u32Pdma ? UART_INTSTS_HWRLSIF_Msk : UART_INTSTS_RLSIF_Msk;
+        if (psPort->u32ErrSts & (UART_FIFOSTS_RXOVIF_Msk | UART_FIFOSTS_TXOVIF_Msk))
+            u32Sts |= u32Pdma ? UART_INTSTS_HWBUFEIF_Msk : UART_INTSTS_BUFERRIF_Msk;
+
+        if ((u32Sts & UART_INTSTS_RDAIF_Msk) && (u32Inten & UART_INTEN_RDAIEN_Msk))
+            u32Sts |= UART_INTSTS_RDAINT_Msk;
+        if ((u32Sts & UART_INTSTS_THREIF_Msk) && (u32Inten & UART_INTEN_THREIEN_Msk))
+            u32Sts |= UART_INTSTS_THREINT_Msk;
+        if ((u32Sts & UART_INTSTS_RLSIF_Msk) && (u32Inten & UART_INTEN_RLSIEN_Msk))
+            u32Sts |= UART_INTSTS_RLSINT_Msk;
+        if ((u32Sts & UART_INTSTS_HWRLSIF_Msk) && (u32Inten & UART_INTEN_RLSIEN_Msk))
+            u32Sts |= UART_INTSTS_HWRLSINT_Msk;
+        if ((u32Sts & UART_INTSTS_RXTOIF_Msk) && (u32Inten & UART_INTEN_RXTOIEN_Msk))
+            u32Sts |= UART_INTSTS_RXTOINT_Msk;
+        if ((u32Sts & UART_INTSTS_HWTOIF_Msk) && (u32Inten & UART_INTEN_RXTOIEN_Msk))
+            u32Sts |= UART_INTSTS_HWTOINT_Msk;
+        if ((u32Sts & UART_INTSTS_BUFERRIF_Msk) && (u32Inten & UART_INTEN_BUFERRIEN_Msk))
+            u32Sts |= UART_INTSTS_BUFERRINT_Msk;
+        if ((u32Sts & UART_INTSTS_HWBUFEIF_Msk) && (u32Inten & UART_INTEN_BUFERRIEN_Msk))
+            u32Sts |= UART_INTSTS_HWBUFEINT_Msk;
+
+        uart->INTSTS = u32Sts;
+    }
+    else
+    {
+        u32Sts = (psPort->u32ErrSts & UUART_BUFSTS_RXOVIF_Msk);
+        u32Sts |= (psPort->u32RxCnt == 0) ? UUART_BUFSTS_RXEMPTY_Msk : 0;
+        u32Sts |= (psPort->u32RxCnt == psPort->u32Depth) ? UUART_BUFSTS_RXFULL_Msk : 0;
+        u32Sts |= (psPort->u32TxCnt == 0) ? UUART_BUFSTS_TXEMPTY_Msk : 0;
+        u32Sts |= (psPort->u32TxCnt == psPort->u32Depth) ? UUART_BUFSTS_TXFULL_Msk : 0;
+        uuart->BUFSTS = u32Sts;
+        uuart->PROTSTS = psPort->u32ErrSts & ~UUART_BUFSTS_RXOVIF_Msk;
+    }
+}
+
+/* An enabled interrupt is pending; the register page is writable when called */
+static uint32_t SIM_UART_IrqPending(SIM_UART_PORT_T *psPort)
+{
+    UART_T *uart = (UART_T *)(uintptr_t)psPort->u32Base;
+    UUART_T *uuart = (UUART_T *)(uintptr_t)psPort->u32Base;
+
+    if (psPort->u32Base == UART0_BASE)
+        return uart->INTSTS & (UART_INTSTS_RDAINT_Msk | UART_INTSTS_THREINT_Msk | UART_INTSTS_RLSINT_Msk |
+                               UART_INTSTS_RXTOINT_Msk | UART_INTSTS_BUFERRINT_Msk | UART_INTSTS_HWRLSINT_Msk |
+                               UART_INTSTS_HWTOINT_Msk | UART_INTSTS_HWBUFEINT_Msk);
+
+    return ((uuart->PROTSTS & UUART_PROTSTS_RXENDIF_Msk) && (uuart->INTEN & UUART_INTEN_RXENDIEN_Msk)) ||
+           ((uuart->PROTSTS & UUART_PROTSTS_TXENDIF_Msk) && (uuart->INTEN & UUART_INTEN_TXENDIEN_Msk)) ||
+           ((uuart->PROTSTS & (UUART_PROTSTS_PARITYERR_Msk | UUART_PROTSTS_FRMERR_Msk | UUART_PROTSTS_BREAK_Msk)) &&
+            (uuart->PROTIEN & UUART_PROTIEN_RLSIEN_Msk)) ||
+           ((uuart->BUFSTS & UUART_BUFSTS_RXOVIF_Msk) && (uuart->BUFCTL & UUART_BUFCTL_RXOVIEN_Msk));
+}
+
+static uint32_t SIM_UART_Read(void *pvPriv, uint32_t u32Offset, uint32_t u32Cur)
+{
+    SIM_UART_PORT_T *psPort = (SIM_UART_PORT_T *)pvPriv;
+
+    if ((psPort->u32Base == UART0_BASE) && (u32Offset == offsetof(UART_T, DAT)))
+    {
+        u32Cur = SIM_UART_RxPop(psPort);
+
+        /* The time-out flag goes with the data it was raised for */
+        if (psPort->u32RxCnt == 0)
+            psPort->u32IntSts &= ~UART_INTSTS_RXTOIF_Msk;
+
+        SIM_UART_Update(psPort);
+    }
+    else if ((psPort->u32Base == USCI0_BASE) && (u32Offset == offsetof(UUART_T, RXDAT)))
+    {
+        u32Cur = SIM_UART_RxPop(psPort);
+        SIM_UART_Update(psPort);
+    }
+
+    return u32Cur;
+}
+
+static uint32_t SIM_UART_Write(void *pvPriv, uint32_t u32Offset, uint32_t u32Old, uint32_t u32New)
+{
+    SIM_UART_PORT_T *psPort = (SIM_UART_PORT_T *)pvPriv;
+    UART_T *uart = (UART_T *)(uintptr_t)psPort->u32Base;
+    UUART_T *uuart = (UUART_T *)(uintptr_t)psPort->u32Base;
+
+    if (psPort->u32Base == UART0_BASE)
+    {
+        switch (u32Offset)
+        {
+        case offsetof(UART_T, DAT):
+            SIM_UART_TxPush(psPort, (uint8_t)u32New);
+            SIM_UART_Update(psPort);
+            return u32Old;
+
+        case offsetof(UART_T, FIFO):
+            if (u32New & UART_FIFO_RXRST_Msk)
+                psPort->u32RxCnt = 0;
+            if (u32New & UART_FIFO_TXRST_Msk)
+                psPort->u32TxCnt = 0;
+            u32New &= ~(UART_FIFO_RXRST_Msk | UART_FIFO_TXRST_Msk);
+            uart->FIFO = u32New;
+            SIM_UART_Update(psPort);
+            return u32New;
+
+        case offsetof(UART_T, FIFOSTS):
+            psPort->u32ErrSts &= ~(u32New & (UART_FIFOSTS_RXOVIF_Msk | UART_FIFOSTS_PEF_Msk | UART_FIFOSTS_FEF_Msk |
+                                             UART_FIFOSTS_BIF_Msk | UART_FIFOSTS_TXOVIF_Msk));
+            SIM_UART_Update(psPort);
+            return uart->FIFOSTS;
+
+        case offsetof(UART_T, INTSTS):
+            psPort->u32IntSts &= ~(u32New & (UART_INTSTS_RXTOIF_Msk | UART_INTSTS_HWTOIF_Msk));
+            SIM_UART_Update(psPort);
+            return uart->INTSTS;
+
+        default:
+            SIM_UART_Update(psPort);
+            return u32New;
+        }
+    }
+
+    switch (u32Offset)
+    {
+    case offsetof(UUART_T, TXDAT):
+        SIM_UART_TxPush(psPort, (uint8_t)u32New);
+        SIM_UART_Update(psPort);
+        return u32Old;
+
+    case offsetof(UUART_T, BUFCTL):
+        if (u32New & UUART_BUFCTL_RXCLR_Msk)
+            psPort->u32RxCnt = 0;
+        if (u32New & UUART_BUFCTL_TXCLR_Msk)
+            psPort->u32TxCnt = 0;
+        u32New &= ~(UUART_BUFCTL_RXCLR_Msk | UUART_BUFCTL_TXCLR_Msk);
+        uuart->BUFCTL = u32New;
+        SIM_UART_Update(psPort);
+        return u32New;
+
+    case offsetof(UUART_T, BUFSTS):
+        psPort->u32ErrSts &= ~(u32New & UUART_BUFSTS_RXOVIF_Msk);
+        SIM_UART_Update(psPort);
+        return uuart->BUFSTS;
+
+    case offsetof(UUART_T, PROTSTS):
+        psPort->u32ErrSts &= ~(u32New & ~UUART_BUFSTS_RXOVIF_Msk);
+        SIM_UART_Update(psPort);
+        return uuart->PROTSTS;
+
+    default:
+        return u32New;
+    }
+}
+
+/**
+  * @brief      Map UART0 and USCI0, trap their registers and let PDMA reach the data ports.
+  * @param[in]  pfnUart0Irq  Called as UART0_IRQHandler(), or NULL.
+  * @param[in]  pfnUsci0Irq  Called as USCI0_IRQHandler(), or NULL.
+  * @return     HOSTSIM_OK or the HOSTSIM error. SIM_PDMA_Init() must have been called.
+  */
+int32_t SIM_UART_Init(SIM_UART_IRQ_T pfnUart0Irq, SIM_UART_IRQ_T pfnUsci0Irq)
+{
+    SIM_UART_PORT_T *psPort;
+    uint32_t u32Port;
+    int32_t i32Ret;
+
+    memset(s_asPort, 0, sizeof(s_asPort));
+
+    s_asPort[SIM_UART_UART0].u32Base = UART0_BASE;
+    s_asPort[SIM_UART_UART0].u32Depth = 16;
+    s_asPort[SIM_UART_UART0].u32ReqTx = PDMA_UART0_TX;
+    s_asPort[SIM_UART_UART0].pfnIrq = pfnUart0Irq;
+    s_asPort[SIM_UART_USCI0].u32Base = USCI0_BASE;
+    s_asPort[SIM_UART_USCI0].u32Depth = 2;
+    s_asPort[SIM_UART_USCI0].u32ReqTx = PDMA_USCI0_TX;
+    s_asPort[SIM_UART_USCI0].pfnIrq = pfnUsci0Irq;
+
+    for (u32Port = 0; u32Port < SIM_UART_PORT_CNT; u32Port++)
+    {
+        psPort = &s_asPort[u32Port];
+
+        if (((i32Ret = HOSTSIM_MapPeriph(psPort->u32Base, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK) ||
+                ((i32Ret = SIM_PDMA_AddMemory(psPort->u32Base, HOSTSIM_PAGE_SIZE)) != HOSTSIM_OK))
+            return i32Ret;
+
+        SIM_UART_Update(psPort);
+
+        if (((i32Ret = HOSTSIM_TrapWrites(psPort->u32Base, HOSTSIM_PAGE_SIZE, SIM_UART_Write, psPort)) != HOSTSIM_OK) ||
+                ((i32Ret = HOSTSIM_TrapReads(psPort->u32Base, HOSTSIM_PAGE_SIZE, SIM_UART_Read, psPort)) != HOSTSIM_OK))
+            return i32Ret;
+    }
+
+    return HOSTSIM_OK;
+}
+
+/**
+  * @brief      Queue bytes on the RX wire of a port.
+  * @return     Bytes queued.
+  */
+uint32_t SIM_UART_Feed(uint32_t u32Port, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    SIM_UART_PORT_T *psPort = &s_asPort[u32Port];
+    uint32_t i;
+
+    for (i = 0; (i < u32Len) && (psPort->u32InHead - psPort->u32InTail < SIM_UART_WIRE_SIZE); i++)
+        psPort->au8WireIn[psPort->u32InHead++ % SIM_UART_WIRE_SIZE] = pu8Data[i];
+
+    return i;
+}
+
+/**
+  * @brief      Give the next byte received on a port line errors (SIM_UART_ERR_x).
+  */
+void SIM_UART_InjectError(uint32_t u32Port, uint32_t u32Err)
+{
+    s_asPort[u32Port].u32NextErr = u32Err;
+}
+
+/**
+  * @brief      Take the bytes a port sent on its TX wire.
+  * @return     Bytes copied.
+  */
+uint32_t SIM_UART_Drain(uint32_t u32Port, uint8_t *pu8Data, uint32_t u32Max)
+{
+    SIM_UART_PORT_T *psPort = &s_asPort[u32Port];
+    uint32_t i;
+
+    for (i = 0; (i < u32Max) && (psPort->u32OutTail != psPort->u32OutHead); i++)
+        pu8Data[i] = psPort->au8WireOut[psPort->u32OutTail++ % SIM_UART_WIRE_SIZE];
+
+    return i;
+}
+
+/**
+  * @brief      Hold off PDMA requests and interrupts of a port, as a long critical section would.
+  */
+void SIM_UART_Stall(uint32_t u32Port, uint32_t u32Stall)
+{
+    s_asPort[u32Port].u32Stall = u32Stall;
+}
+
+/* One byte arrives from the wire */
+static void SIM_UART_RxChar(SIM_UART_PORT_T *psPort)
+{
+    uint32_t u32Uart = (psPort->u32Base == UART0_BASE);
+    uint8_t u8Data = psPort->au8WireIn[psPort->u32InTail++ % SIM_UART_WIRE_SIZE];
+
+    if (psPort->u32NextErr & SIM_UART_ERR_PARITY)
+        psPort->u32ErrSts |= u32Uart ? UART_FIFOSTS_PEF_Msk : UUART_PROTSTS_PARITYERR_Msk;
+    if (psPort->u32NextErr & SIM_UART_ERR_FRAME)
+        psPort->u32ErrSts |= u32Uart ? UART_FIFOSTS_FEF_Msk : UUART_PROTSTS_FRMERR_Msk;
+    if (psPort->u32NextErr & SIM_UART_ERR_BREAK)
+        psPort->u32ErrSts |= u32Uart ? UART_FIFOSTS_BIF_Msk : UUART_PROTSTS_BREAK_Msk;
+    psPort->u32NextErr = 0;
+
+    if (psPort->u32RxCnt < psPort->u32Depth)
+        psPort->au8Rx[psPort->u32RxCnt++] = u8Data;
+    else
+        psPort->u32ErrSts |= u32Uart ? UART_FIFOSTS_RXOVIF_Msk : UUART_BUFSTS_RXOVIF_Msk;
+
+    if (!u32Uart)
+        psPort->u32ErrSts |= UUART_PROTSTS_RXENDIF_Msk;
+
+    psPort->u32IdleBits = 0;
+    psPort->u32ToArmed = 1;
+    psPort->u32IntSts &= ~UART_INTSTS_RXTOIF_Msk;
+}
+
+/* RX time-out counted in bit times from the end of the last byte */
+static void SIM_UART_RxIdle(SIM_UART_PORT_T *psPort)
+{
+    UART_T *uart = (UART_T *)(uintptr_t)psPort->u32Base;
+    uint32_t u32Toic;
+
+    psPort->u32IdleBits += 10;
+
+    if ((psPort->u32Base != UART0_BASE) || !psPort->u32ToArmed || !(uart->INTEN & UART_INTEN_TOCNTEN_Msk))
+        return;
+
+    u32Toic = (uart->TOUT & UART_TOUT_TOIC_Msk) >> UART_TOUT_TOIC_Pos;
+
+    if (psPort->u32IdleBits < u32Toic)
+        return;
+
+    if (uart->INTEN & UART_INTEN_RXPDMAEN_Msk)
+    {
+        psPort->u32IntSts |= UART_INTSTS_HWTOIF_Msk;
+        psPort->u32ToArmed = 0;
+    }
+    else if (psPort->u32RxCnt)
+    {
+        psPort->u32IntSts |= UART_INTSTS_RXTOIF_Msk;
+        psPort->u32ToArmed = 0;
+    }
+}
+
+static uint32_t SIM_UART_PdmaOn(SIM_UART_PORT_T *psPort, uint32_t u32Rx)
+{
+    UART_T *uart = (UART_T *)(uintptr_t)psPort->u32Base;
+    UUART_T *uuart = (UUART_T *)(uintptr_t)psPort->u32Base;
+
+    if (psPort->u32Base == UART0_BASE)
+        return uart->INTEN & (u32Rx ? UART_INTEN_RXPDMAEN_Msk : UART_INTEN_TXPDMAEN_Msk);
+
+    return (uuart->PDMACTL & UUART_PDMACTL_PDMAEN_Msk) &&
+           (uuart->PDMACTL & (u32Rx ? UUART_PDMACTL_RXPDMAEN_Msk : UUART_PDMACTL_TXPDMAEN_Msk));
+}
+
+/* Single requests while the FIFO asks for them; the model page is locked so PDMA goes through the traps */
+static void SIM_UART_ServePdma(SIM_UART_PORT_T *psPort)
+{
+    uint32_t u32Cnt;
+
+    while (SIM_UART_PdmaOn(psPort, 1) && psPort->u32RxCnt)
+    {
+        u32Cnt = psPort->u32RxCnt;
+        if (!SIM_PDMA_PeriphReq(psPort->u32ReqTx + 1) || (psPort->u32RxCnt == u32Cnt))
+            break;
+    }
+
+    while (SIM_UART_PdmaOn(psPort, 0) && (psPort->u32TxCnt < psPort->u32Depth))
+    {
+        u32Cnt = psPort->u32TxCnt;
+        if (!SIM_PDMA_PeriphReq(psPort->u32ReqTx) || (psPort->u32TxCnt == u32Cnt))
+            break;
+    }
+}
+
+/**
+  * @brief      Advance both ports by a number of character times (10 bit times each).
+  */
+void SIM_UART_Run(uint32_t u32Chars)
+{
+    SIM_UART_PORT_T *psPort;
+    uint32_t u32Port, u32Irq, u32Pass;
+
+    while (u32Chars--)
+    {
+        for (u32Port = 0; u32Port < SIM_UART_PORT_CNT; u32Port++)
+        {
+            psPort = &s_asPort[u32Port];
+
+            HOSTSIM_Unlock(psPort->u32Base);
+
+            if (psPort->u32TxCnt)
+            {
+                psPort->au8WireOut[psPort->u32OutHead++ % SIM_UART_WIRE_SIZE] = psPort->au8Tx[0];
+                memmove(psPort->au8Tx, psPort->au8Tx + 1, --psPort->u32TxCnt);
+
+                if (psPort->u32Base == USCI0_BASE)
+                    psPort->u32ErrSts |= UUART_PROTSTS_TXENDIF_Msk;
+            }
+
+            if (psPort->u32InTail != psPort->u32InHead)
+                SIM_UART_RxChar(psPort);
+            else
+                SIM_UART_RxIdle(psPort);
+
+            SIM_UART_Update(psPort);
+            HOSTSIM_Lock(psPort->u32Base);
+
+            if (psPort->u32Stall)
+                continue;
+
+            SIM_UART_ServePdma(psPort);
+
+            /* Level interrupt: re-enter while the handler leaves something pending */
+            for (u32Pass = 0; u32Pass < 4; u32Pass++)
+            {
+                HOSTSIM_Unlock(psPort->u32Base);
+                u32Irq = SIM_UART_IrqPending(psPort);
+                HOSTSIM_Lock(psPort->u32Base);
+
+                if (!u32Irq || (psPort->pfnIrq == NULL))
+                    break;
+
+                psPort->pfnIrq();
+            }
+        }
+    }
+}
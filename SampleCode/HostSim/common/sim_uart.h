@@ -0,0 +1,51 @@
+/**************************************************************************//**
+ * @file     sim_uart.h
+ * @version  V1.00
+ * @brief    Host model of UART0 and USCI0 in UART mode shared by the HostSim checks.
+ *
+ * @details  The model keeps the RX and TX FIFOs behind DAT (RXDAT/TXDAT) and
+ *           derives FIFOSTS/BUFSTS and the interrupt flags from them. Time
+ *           advances in character times with SIM_UART_Run(): each character
+ *           time moves one byte from the host wire into the RX FIFO and one
+ *           byte from the TX FIFO onto the wire, serves the PDMA requests of
+ *           ../common/sim_pdma.c and calls the port interrupt handler while an
+ *           enabled interrupt is pending. Line errors and RX FIFO overflow are
+ *           injected from the host side.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __SIM_UART_H__
+#define __SIM_UART_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SIM_UART_UART0          0       /*!< UART0 port */
+#define SIM_UART_USCI0          1       /*!< USCI0 in UART mode */
+#define SIM_UART_PORT_CNT       2
+
+#define SIM_UART_WIRE_SIZE      0x10000ul   /*!< Bytes each wire queue holds */
+
+#define SIM_UART_ERR_PARITY     0x1ul   /*!< Next byte arrives with a parity error */
+#define SIM_UART_ERR_FRAME      0x2ul   /*!< Next byte arrives with a framing error */
+#define SIM_UART_ERR_BREAK      0x4ul   /*!< Next byte arrives as a break */
+
+typedef void (*SIM_UART_IRQ_T)(void);
+
+int32_t  SIM_UART_Init(SIM_UART_IRQ_T pfnUart0Irq, SIM_UART_IRQ_T pfnUsci0Irq);
+uint32_t SIM_UART_Feed(uint32_t u32Port, const uint8_t *pu8Data, uint32_t u32Len);
+void     SIM_UART_InjectError(uint32_t u32Port, uint32_t u32Err);
+uint32_t SIM_UART_Drain(uint32_t u32Port, uint8_t *pu8Data, uint32_t u32Max);
+void     SIM_UART_Run(uint32_t u32Chars);
+void     SIM_UART_Stall(uint32_t u32Port, uint32_t u32Stall);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_UART_H__ */
@@ -0,0 +1,278 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Scale HCLK with the load: the frequency governor picks the lowest level that
+ *           keeps up with a bursty workload, and re-derives the UART, SPI and timer dividers.
+ *
+ * @details  TIMER0 from HIRC releases a job every 10 ms, whose size follows phases of light
+ *           and heavy load. The main loop runs the jobs and waits in Idle mode between them;
+ *           TIMER1 from HIRC counts the idle time in microseconds, so both keep time whatever
+ *           HCLK is. At each period CLK_GovUpdate() gets the busy time and sets HCLK for the
+ *           next one. UART0 runs from PLL/2, SPI0 and TIMER2 from PCLK1: they are
+ *           registered with the governor and set their dividers again at each change, so
+ *           printf keeps 115200 bps and TIMER2 keeps counting milliseconds.
+ *           The level currents are first estimates, to be replaced by board measurements.
+ *           The host check of the governor is SampleCode/HostSim/CLK_Governor.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+
+#define PERIOD_US           10000ul         /* Governor period, one job each */
+#define REPORT_PERIODS      500ul           /* Report every 5 s */
+#define LOOPS_PER_PERCENT   4000ul          /* Busy loops of 1% of a period at 200 MHz, about 5 cycles each */
+
+/* HCLK, running and idle current in uA; above 180 MHz the core needs power level 0 */
+static const CLK_GOV_LEVEL_T s_asLevel[] =
+{
+    {  50000000, 9500, 5000 },
+    { 100000000, 18500, 9500 },
+    { 144000000, 26500, 13500 },
+    { 180000000, 33000, 16500 },
+    { 200000000, 40000, 20000 },
+};
+#define LEVELS              (sizeof(s_asLevel) / sizeof(s_asLevel[0]))
+
+/* Load of each phase, percent of the 200 MHz CPU, and its length in periods */
+static const uint32_t s_au32Phase[][2] = { { 3, 300 }, { 70, 150 }, { 12, 200 }, { 35, 250 } };
+
+static CLK_GOV_T s_sGov;
+static volatile uint32_t s_u32Jobs;         /* Released, not run yet */
+static volatile uint32_t s_u32Ms;           /* TIMER2 ticks */
+static volatile uint32_t s_u32Work;
+
+void TMR0_IRQHandler(void);
+void TMR2_IRQHandler(void);
+void SYS_Init(void);
+void UART0_Init(void);
+
+/**
+ * @brief       IRQ Handler for Timer0 Interrupt
+ * @param       None
+ * @return      None
+ * @details     Releases a job every period.
+ */
+void TMR0_IRQHandler(void)
+{
+    TIMER_ClearIntFlag(TIMER0);
+    s_u32Jobs++;
+}
+
+/**
+ * @brief       IRQ Handler for Timer2 Interrupt
+ * @param       None
+ * @return      None
+ * @details     Millisecond tick from PCLK1, which follows HCLK.
+ */
+void TMR2_IRQHandler(void)
+{
+    TIMER_ClearIntFlag(TIMER2);
+    s_u32Ms++;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Drivers notified of the level changes                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+static void UartNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    (void)pvPriv;
+    (void)u32Hclk;
+
+    if(u32Event == CLK_GOV_PRE_CHANGE)
+        UART_WAIT_TX_EMPTY(UART0);
+    else
+        UART_SetLineConfig(UART0, 115200, UART_WORD_LEN_8, UART_PARITY_NONE, UART_STOP_BIT_1);
+}
+
+static void SpiNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    (void)pvPriv;
+    (void)u32Hclk;
+
+    if(u32Event == CLK_GOV_PRE_CHANGE)
+    {
+        while(SPI_IS_BUSY(SPI0)) {}
+    }
+    else
+    {
+        SPI_SetBusClock(SPI0, 2000000);
+    }
+}
+
+static void TimerNotify(void *pvPriv, uint32_t u32Event, uint32_t u32Hclk)
+{
+    (void)pvPriv;
+    (void)u32Hclk;
+
+    if(u32Event == CLK_GOV_PRE_CHANGE)
+    {
+        TIMER_Stop(TIMER2);
+    }
+    else
+    {
+        TIMER_Open(TIMER2, TIMER_PERIODIC_MODE, 1000);
+        TIMER_EnableInt(TIMER2);
+        TIMER_Start(TIMER2);
+    }
+}
+
+static void Report(uint32_t u32Periods)
+{
+    const CLK_GOV_STAT_T *psStat = &s_sGov.sStat;
+    uint64_t u64Charge = 0, u64Time = 0;
+    uint32_t i;
+
+    for(i = 0; i < LEVELS; i++)
+    {
+        u64Charge += psStat->au64Charge[i];
+        u64Time += psStat->au64Time[i];
+    }
+
+    printf("\n[%u s, TIMER2 %u ms] %u level changes, %u periods saturated, about %u uA\n",
+           u32Periods / 100, s_u32Ms, psStat->u32Switches, psStat->u32Saturated, (uint32_t)(u64Charge / u64Time));
+    for(i = 0; i < LEVELS; i++)
+        printf("  %3u MHz: %3u%% of the time, %3u%% busy\n", s_asLevel[i].u32Hclk / 1000000,
+               (uint32_t)(psStat->au64Time[i] * 100 / u64Time),
+               psStat->au64Time[i] ? (uint32_t)(psStat->au64Busy[i] * 100 / psStat->au64Time[i]) : 0);
+}
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Enable HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable UART0, SPI0 and TIMER0 ~ TIMER2 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(SPI0_MODULE);
+    CLK_EnableModuleClock(TMR0_MODULE);
+    CLK_EnableModuleClock(TMR1_MODULE);
+    CLK_EnableModuleClock(TMR2_MODULE);
+
+    /* UART0 from PLL/2, SPI0 and TIMER2 from PCLK1 follow the levels */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_PLL_DIV2, CLK_CLKDIV0_UART0(1));
+    CLK_SetModuleClock(SPI0_MODULE, CLK_CLKSEL2_SPI0SEL_PCLK1, MODULE_NoMsk);
+    CLK_SetModuleClock(TMR2_MODULE, CLK_CLKSEL1_TMR2SEL_PCLK1, 0);
+
+    /* TIMER0 and TIMER1 from HIRC keep the time */
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HIRC, 0);
+    CLK_SetModuleClock(TMR1_MODULE, CLK_CLKSEL1_TMR1SEL_HIRC, 0);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Setup SPI0 multi-function pins */
+    SET_SPI0_MOSI_PA0();
+    SET_SPI0_MISO_PA1();
+    SET_SPI0_CLK_PA2();
+    SET_SPI0_SS_PA3();
+}
+
+void UART0_Init(void)
+{
+    /* Reset UART0 */
+    SYS_ResetModule(UART0_RST);
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    uint32_t u32Periods = 0, u32Phase = 0, u32PhaseLeft = 0, u32Loops;
+    uint32_t u32Start, u32Idle = 0;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    printf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    printf("+------------------------------------------+\n");
+    printf("|    CLK Frequency Governor Sample Code    |\n");
+    printf("+------------------------------------------+\n\n");
+    printf("Registers stay unlocked: each level change writes the clock registers.\n");
+
+    SPI_Open(SPI0, SPI_MASTER, SPI_MODE_0, 8, 2000000);
+    TIMER_Open(TIMER2, TIMER_PERIODIC_MODE, 1000);
+    TIMER_EnableInt(TIMER2);
+    NVIC_EnableIRQ(TMR2_IRQn);
+    TIMER_Start(TIMER2);
+
+    if(CLK_GovInit(&s_sGov, s_asLevel, LEVELS) != CLK_GOV_OK)
+    {
+        printf("Invalid level table\n");
+        while(1) {}
+    }
+    CLK_GovRegister(&s_sGov, UartNotify, NULL);
+    CLK_GovRegister(&s_sGov, SpiNotify, NULL);
+    CLK_GovRegister(&s_sGov, TimerNotify, NULL);
+
+    /* TIMER1 counts microseconds freely: HIRC / 12 */
+    TIMER1->CTL = TIMER_CONTINUOUS_MODE | (12 - 1);
+    TIMER1->CMP = TIMER_CMP_CMPDAT_Msk;
+    TIMER_Start(TIMER1);
+
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 1000000 / PERIOD_US);
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+    TIMER_Start(TIMER0);
+
+    while(1)
+    {
+        /* Wait for the next job in Idle mode, counting the time */
+        while(s_u32Jobs == 0)
+        {
+            u32Start = TIMER_GetCounter(TIMER1);
+            CLK_Idle();
+            u32Idle += (TIMER_GetCounter(TIMER1) - u32Start) & TIMER_CNT_CNT_Msk;
+        }
+        s_u32Jobs--;
+
+        /* The period that just ended: set the level of the next one */
+        if(u32Periods > 0)
+        {
+            CLK_GovUpdate(&s_sGov, (u32Idle < PERIOD_US) ? PERIOD_US - u32Idle : 0, PERIOD_US);
+            if((u32Periods % REPORT_PERIODS) == 0)
+                Report(u32Periods);
+        }
+        u32Idle = 0;
+        u32Periods++;
+
+        /* The job of this period */
+        if(u32PhaseLeft-- == 0)
+        {
+            u32Phase = (u32Phase + 1) % (sizeof(s_au32Phase) / sizeof(s_au32Phase[0]));
+            u32PhaseLeft = s_au32Phase[u32Phase][1];
+        }
+        u32Loops = s_au32Phase[u32Phase][0] * LOOPS_PER_PERCENT;
+        while(u32Loops--)
+            s_u32Work++;
+    }
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
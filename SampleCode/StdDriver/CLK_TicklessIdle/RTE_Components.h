@@ -0,0 +1,17 @@
+/**************************************************************************//**
+ * @file     RTE_Components.h
+ * @version  V1.00
+ * @brief    Components of the CLK_TicklessIdle sample, for the RTX5 sources built with it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef RTE_COMPONENTS_H
+#define RTE_COMPONENTS_H
+
+#define CMSIS_device_header "NuMicro.h"
+
+#define RTE_CMSIS_RTOS2                 /* CMSIS-RTOS2 */
+#define RTE_CMSIS_RTOS2_RTX5            /* CMSIS-RTOS2 Keil RTX5 */
+
+#endif /* RTE_COMPONENTS_H */
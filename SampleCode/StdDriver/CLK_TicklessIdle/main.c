@@ -0,0 +1,280 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Tickless idle for RTX5: the idle thread sleeps in the deepest power mode that
+ *           fits the time to the next thread release, woken by TIMER0 on LXT.
+ *
+ * @details  The RTX idle thread is replaced. It suspends the kernel, which returns the
+ *           ticks to the next timeout, and hands the window to CLK_IdleEnter(), which
+ *           picks Idle, Fast Wake-up, Normal or Low Leakage Power-down from the cost of
+ *           each mode and sets TIMER0 to wake the chip before the release. SysTick
+ *           stops in power-down, so on return the kernel is credited the ticks that
+ *           CLK_IdleGetTime() says have passed, and SysTick counts the remaining part
+ *           of the tick before it goes back to its full period. Every ten seconds the
+ *           report thread prints where the idle time went.
+ *           The host check of the same idle thread is SampleCode/HostSim/CLK_TicklessIdle.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+#include "cmsis_os2.h"
+
+#define TICK_US             1000ul          /* OS_TICK_FREQ of RTX_Config.h */
+#define MAX_IDLE_TICKS      10000ul         /* Longest sleep asked for; osKernelSuspend() may return osWaitForever */
+
+static CLK_IDLE_T s_sIdle;
+static uint64_t s_u64Base;                  /* Idle manager time at tick 0 */
+static volatile uint32_t s_u32Work;
+
+static const char *s_apcMode[CLK_IDLE_MODE_CNT] = { "Idle", "FWPD", "PD", "LLPD" };
+
+/* printf needs more than the default stack of RTX_Config.h */
+static const osThreadAttr_t s_sReportAttr = { .name = "report", .stack_size = 1024 };
+
+void TMR0_IRQHandler(void);
+void SYS_Init(void);
+void UART0_Init(void);
+__NO_RETURN void osRtxIdleThread(void *argument);
+
+/**
+ * @brief       IRQ Handler for Timer0 Interrupt
+ * @param       None
+ * @return      None
+ * @details     TIMER0 is the wake-up timer of the idle manager.
+ */
+void TMR0_IRQHandler(void)
+{
+    CLK_IdleIRQHandler(&s_sIdle);
+}
+
+/* Microseconds the kernel has counted since tick 0, SysTick stopped */
+static uint64_t KernelTime(uint32_t u32Rem)
+{
+    return (uint64_t)osKernelGetTickCount() * TICK_US + TICK_US - u32Rem;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  RTX idle thread: sleep to the next release                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+__NO_RETURN void osRtxIdleThread(void *argument)
+{
+    uint32_t u32Ticks, u32Window, u32Rem, u32Us, u32Credit, u32CycPerUs, u32Load;
+    int64_t i64Behind;
+
+    (void)argument;
+
+    for(;;)
+    {
+        u32Ticks = osKernelSuspend();
+        if(u32Ticks == 0)
+        {
+            osKernelResume(0);
+            continue;
+        }
+        if(u32Ticks > MAX_IDLE_TICKS)
+            u32Ticks = MAX_IDLE_TICKS;
+
+        /* Part of the current tick left on SysTick */
+        u32CycPerUs = SystemCoreClock / 1000000ul;
+        u32Load = SysTick->LOAD + 1;
+        u32Rem = (SysTick->VAL + u32CycPerUs - 1) / u32CycPerUs;
+        if((u32Rem == 0) || (u32Rem > TICK_US))
+            u32Rem = TICK_US;
+
+        u32Window = (u32Ticks - 1) * TICK_US + u32Rem;
+        if(CLK_IdleEnter(&s_sIdle, u32Window) == 0)
+        {
+            /* Too short to sleep: SysTick ends the pass */
+            osKernelResume(0);
+            CLK_Idle();
+            continue;
+        }
+
+        /*
+            The kernel follows the timer: whole ticks go to the kernel and SysTick counts the
+            rest of the tick. Taking the time from the timer rather than summing the sleeps keeps
+            the kernel from drifting, and an error of a pass, such as a tick pending while the
+            kernel was suspended, is taken back by the next ones.
+        */
+        u32Credit = 0;
+        i64Behind = (int64_t)(CLK_IdleGetTime(&s_sIdle) - s_u64Base - KernelTime(u32Rem));
+        if(i64Behind < 0)
+        {
+            u32Us = (uint32_t)(-i64Behind);
+            u32Rem = (u32Rem + u32Us < TICK_US) ? (u32Rem + u32Us) : TICK_US;
+        }
+        else if(i64Behind < (int64_t)u32Rem)
+        {
+            u32Rem -= (uint32_t)i64Behind;
+        }
+        else
+        {
+            u32Us = (uint32_t)i64Behind - u32Rem;
+            u32Credit = 1 + u32Us / TICK_US;
+            u32Rem = TICK_US - u32Us % TICK_US;
+        }
+
+        /* SysTick reloads the full tick after the part counted from here */
+        SysTick->LOAD = u32Rem * u32CycPerUs - 1;
+        SysTick->VAL = 0;
+        osKernelResume(u32Credit);
+        SysTick->LOAD = u32Load - 1;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Workload: a control loop every 50 ms, a sensor read every 100 ms and a report every 10 s              */
+/*---------------------------------------------------------------------------------------------------------*/
+static void Busy(uint32_t u32Loops)
+{
+    while(u32Loops--)
+        s_u32Work++;
+}
+
+static void ControlThread(void *argument)
+{
+    uint32_t u32Tick = osKernelGetTickCount();
+
+    (void)argument;
+
+    for(;;)
+    {
+        u32Tick += 50;
+        osDelayUntil(u32Tick);
+        Busy(2000);
+    }
+}
+
+static void SensorThread(void *argument)
+{
+    uint32_t u32Tick = osKernelGetTickCount();
+
+    (void)argument;
+
+    for(;;)
+    {
+        u32Tick += 100;
+        osDelayUntil(u32Tick);
+        Busy(20000);
+    }
+}
+
+static void ReportThread(void *argument)
+{
+    const CLK_IDLE_STAT_T *psStat = &s_sIdle.sStat;
+    uint32_t i, u32Tick = osKernelGetTickCount();
+    int32_t i32Drift;
+
+    (void)argument;
+
+    for(;;)
+    {
+        u32Tick += 10000;
+        osDelayUntil(u32Tick);
+
+        i32Drift = (int32_t)((int64_t)(CLK_IdleGetTime(&s_sIdle) - s_u64Base) - (int64_t)osKernelGetTickCount() * TICK_US);
+        printf("\n[%u s] kernel - timer: %d us\n", osKernelGetTickCount() / 1000, -i32Drift);
+        for(i = 0; i < CLK_IDLE_MODE_CNT; i++)
+            printf("  %-4s %8u entries %10u ms  exit %u us\n", s_apcMode[i], psStat->au32Entries[i],
+                   (uint32_t)(psStat->au64Time[i] / 1000), s_sIdle.asMode[i].u32Exit);
+        printf("  short %u, vetoed %u, early %u, late %u (max %u clocks)\n",
+               psStat->u32Short, psStat->u32Vetoed, psStat->u32Early, psStat->u32Late, psStat->u32MaxLate);
+
+        /* The next power-down would stop the UART clock with characters in the FIFO */
+        UART_WAIT_TX_EMPTY(UART0);
+    }
+}
+
+void SYS_Init(void)
+{
+    /* Set PF multi-function pins for X32_OUT(PF.4) and X32_IN(PF.5) */
+    SET_X32_OUT_PF4();
+    SET_X32_IN_PF5();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable LXT clock, it keeps TIMER0 running in power-down */
+    CLK_EnableXtalRC(CLK_PWRCTL_LXTEN_Msk);
+
+    /* Wait for LXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_LXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable UART0 and TIMER0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(TMR0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Select TIMER0 module clock source as LXT */
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_LXT, 0);
+
+    /* Update System Core Clock */
+    SystemCoreClockUpdate();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+}
+
+void UART0_Init(void)
+{
+    /* Reset UART0 */
+    SYS_ResetModule(UART0_RST);
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    printf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    printf("+------------------------------------------+\n");
+    printf("|    RTX5 Tickless Idle Sample Code        |\n");
+    printf("+------------------------------------------+\n\n");
+    printf("Threads run every 50 ms and 100 ms; the idle thread sleeps between them.\n");
+    printf("Registers stay unlocked: entering power-down writes CLK->PWRCTL.\n");
+    UART_WAIT_TX_EMPTY(UART0);
+
+    /* TIMER0 from LXT wakes the chip and keeps the time across the sleeps */
+    CLK_IdleInit(&s_sIdle, TIMER0, __LXT);
+    NVIC_EnableIRQ(TMR0_IRQn);
+
+    osKernelInitialize();
+    osThreadNew(ControlThread, NULL, NULL);
+    osThreadNew(SensorThread, NULL, NULL);
+    osThreadNew(ReportThread, NULL, &s_sReportAttr);
+
+    s_u64Base = CLK_IdleGetTime(&s_sIdle);
+    osKernelStart();
+
+    for(;;) {}
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,503 @@
+/**************************************************************************//**
+ * @file     dlog_decode.c
+ * @version  V1.00
+ * @brief    Host side of the deferred binary log: formats the records sent
+ *           by DLOG_Drain() with the format strings of the firmware image.
+ *
+ * @details  Build: gcc -O2 -o dlog_decode dlog_decode.c
+ *
+ *           ./dlog_decode image.axf capture.bin
+ *           stty -F /dev/ttyACM0 115200 raw && ./dlog_decode image.axf - < /dev/ttyACM0
+ *
+ *           image is the ELF (AXF) file the running firmware was built from,
+ *           32 or 64-bit, little endian: the format strings and the strings
+ *           of %s arguments are read from its allocated PROGBITS sections at
+ *           the addresses logged. An image other than the one running prints
+ *           wrong text without noticing, so keep them together.
+ *
+ *           The input is the raw UART byte stream, a file or "-" for stdin,
+ *           decoded as it arrives. Frames are found by the sync byte and a
+ *           header that makes sense, so the decoder starts anywhere and
+ *           recovers from noise; a gap in the frame numbers reports frames
+ *           lost on the wire, a DROP record messages the target refused with
+ *           its ring full.
+ *
+ *           Each line starts with the time of its record in seconds, counted
+ *           from the INFO record at SystemCoreClock, on the assumption that
+ *           records are less than 2^32 cycles apart. Conversions are those
+ *           of integers, characters, strings and pointers; every argument is
+ *           one 32-bit word, so length modifiers are ignored. Lines end in
+ *           \r\n, as retarget.c sends them to the terminal without the log.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Record layout of Library/StdDriver/inc/dlog.h, which needs the device headers */
+#define DLOG_TYPE_FMT           1
+#define DLOG_TYPE_TEXT          2
+#define DLOG_TYPE_INFO          3
+#define DLOG_TYPE_DROP          4
+#define DLOG_MAX_ARGS           8
+#define DLOG_TEXT_MAX           64
+#define DLOG_SYNC               0xA5
+#define DLOG_VERSION            1
+#define REC_MAX_WORDS           (2 + DLOG_TEXT_MAX / 4)
+
+#define HDR_TYPE(h)             (((h) >> 28) & 0xF)
+#define HDR_LEN(h)              (((h) >> 16) & 0xFF)
+#define HDR_SEQ(h)              (((h) >> 8) & 0xFF)
+#define HDR_WORDS(h)            ((h) & 0xFF)
+
+#define SHT_PROGBITS            1
+#define SHF_ALLOC               2
+#define MAX_SECTIONS            256
+#define MSG_SIZE                1024
+#define SPEC_SIZE               32
+
+typedef struct
+{
+    uint64_t u64Addr;
+    uint64_t u64Size;
+    const uint8_t *pu8Data;
+} SECTION_T;
+
+static uint8_t *s_pu8Image;
+static SECTION_T s_asSect[MAX_SECTIONS];
+static uint32_t s_u32Sects;
+
+/* Input bytes not consumed yet: at most one frame */
+static uint8_t s_au8Buf[1 + REC_MAX_WORDS * 4];
+static uint32_t s_u32BufLen;
+
+/* Output state */
+static uint32_t s_u32Freq;
+static uint32_t s_u32LastTime, s_u32HaveTime;
+static uint64_t s_u64Time;
+static uint32_t s_u32MidLine;
+static char s_cLast;                    /* Last character out, for the line ends */
+static uint32_t s_u32NextSeq, s_u32HaveSeq;
+
+/* Totals */
+static uint32_t s_u32Frames, s_u32Skipped, s_u32Lost, s_u32Dropped;
+
+static FILE *OpenFile(const char *pcPath, const char *pcMode)
+{
+    FILE *fp = fopen(pcPath, pcMode);
+
+    if (fp == NULL)
+    {
+        perror(pcPath);
+        exit(1);
+    }
+
+    return fp;
+}
+
+static uint32_t Le(const uint8_t *pu8, uint32_t u32Bytes)
+{
+    uint32_t u32Value = 0;
+
+    while (u32Bytes-- > 0)
+        u32Value = (u32Value << 8) | pu8[u32Bytes];
+
+    return u32Value;
+}
+
+static uint64_t Le64(const uint8_t *pu8)
+{
+    return Le(pu8, 4) | ((uint64_t)Le(pu8 + 4, 4) << 32);
+}
+
+/*
+ *  The sections of the image loaded on the target, from its section headers
+ */
+static void LoadImage(const char *pcPath)
+{
+    FILE *fp = OpenFile(pcPath, "rb");
+    uint64_t u64ShOff;
+    uint32_t u32ShSize, u32ShNum, u32Is64, i;
+    long lLen;
+
+    fseek(fp, 0, SEEK_END);
+    lLen = ftell(fp);
+    rewind(fp);
+    s_pu8Image = malloc((size_t)lLen);
+    if ((lLen < 52) || (fread(s_pu8Image, 1, (size_t)lLen, fp) != (size_t)lLen) || (memcmp(s_pu8Image, "\x7f" "ELF", 4) != 0))
+    {
+        fprintf(stderr, "%s: not an ELF file\n", pcPath);
+        exit(1);
+    }
+    fclose(fp);
+
+    if (s_pu8Image[5] != 1)
+    {
+        fprintf(stderr, "%s: not little endian\n", pcPath);
+        exit(1);
+    }
+
+    u32Is64 = (s_pu8Image[4] == 2);
+    u64ShOff = u32Is64 ? Le64(&s_pu8Image[0x28]) : Le(&s_pu8Image[0x20], 4);
+    u32ShSize = Le(&s_pu8Image[u32Is64 ? 0x3A : 0x2E], 2);
+    u32ShNum = Le(&s_pu8Image[u32Is64 ? 0x3C : 0x30], 2);
+    if (u64ShOff + (uint64_t)u32ShSize * u32ShNum > (uint64_t)lLen)
+    {
+        fprintf(stderr, "%s: section headers out of the file\n", pcPath);
+        exit(1);
+    }
+
+    for (i = 0; (i < u32ShNum) && (s_u32Sects < MAX_SECTIONS); i++)
+    {
+        const uint8_t *pu8Sh = &s_pu8Image[u64ShOff + (uint64_t)i * u32ShSize];
+        uint64_t u64Flags = u32Is64 ? Le64(pu8Sh + 8) : Le(pu8Sh + 8, 4);
+        uint64_t u64Addr = u32Is64 ? Le64(pu8Sh + 16) : Le(pu8Sh + 12, 4);
+        uint64_t u64Off = u32Is64 ? Le64(pu8Sh + 24) : Le(pu8Sh + 16, 4);
+        uint64_t u64Size = u32Is64 ? Le64(pu8Sh + 32) : Le(pu8Sh + 20, 4);
+
+        if ((Le(pu8Sh + 4, 4) != SHT_PROGBITS) || !(u64Flags & SHF_ALLOC) || (u64Off + u64Size > (uint64_t)lLen))
+            continue;
+
+        s_asSect[s_u32Sects].u64Addr = u64Addr;
+        s_asSect[s_u32Sects].u64Size = u64Size;
+        s_asSect[s_u32Sects].pu8Data = &s_pu8Image[u64Off];
+        s_u32Sects++;
+    }
+
+    if (s_u32Sects == 0)
+    {
+        fprintf(stderr, "%s: no loaded sections\n", pcPath);
+        exit(1);
+    }
+}
+
+/* A string of the image at a logged address, NULL if there is none */
+static const char *Str(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32Sects; i++)
+    {
+        const SECTION_T *psSect = &s_asSect[i];
+
+        if ((u32Addr >= psSect->u64Addr) && (u32Addr < psSect->u64Addr + psSect->u64Size))
+        {
+            const char *pcStr = (const char *)&psSect->pu8Data[u32Addr - psSect->u64Addr];
+
+            /* Terminated inside the section */
+            if (memchr(pcStr, '\0', psSect->u64Addr + psSect->u64Size - u32Addr) == NULL)
+                return NULL;
+            return pcStr;
+        }
+    }
+
+    return NULL;
+}
+
+/* Text out, each line led by the time of the record it comes from and ended by \r\n as retarget.c does */
+static void Out(uint32_t u32Time, const char *pcText, uint32_t u32Len)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Len; i++)
+    {
+        if (!s_u32MidLine)
+        {
+            if (s_u32Freq != 0)
+                printf("[%12.6f] ", (double)s_u64Time / s_u32Freq);
+            else
+                printf("[%12u] ", u32Time);
+            s_u32MidLine = 1;
+        }
+
+        if ((pcText[i] == '\n') && (s_cLast != '\r'))
+            putchar('\r');
+        putchar(pcText[i]);
+        s_cLast = pcText[i];
+        if (pcText[i] == '\n')
+            s_u32MidLine = 0;
+    }
+}
+
+/* A note of the decoder on a line of its own */
+static void Note(uint32_t u32Time, const char *pcNote)
+{
+    if (s_u32MidLine)
+        Out(u32Time, "\n", 1);
+    Out(u32Time, pcNote, (uint32_t)strlen(pcNote));
+}
+
+/*
+ *  printf() of a logged format with 32-bit arguments. Each conversion goes through the host
+ *  snprintf() with its flags, width and precision, the length modifier left out.
+ */
+static uint32_t Format(char *pcMsg, uint32_t u32Size, const char *pcFmt, const uint32_t *pu32Arg, uint32_t u32Argc)
+{
+    char acSpec[SPEC_SIZE], acPtr[16];
+    const char *pcStr;
+    uint32_t u32Len = 0, u32Spec, u32Arg = 0, u32Value;
+    int n;
+
+#define ARG()   ((u32Arg < u32Argc) ? pu32Arg[u32Arg++] : (u32Arg++, 0))
+#define ADD(...) \
+    do { n = snprintf(&pcMsg[u32Len], u32Size - u32Len, __VA_ARGS__); \
+         u32Len += ((n > 0) && ((uint32_t)n < u32Size - u32Len)) ? (uint32_t)n : 0; } while (0)
+
+    pcMsg[0] = '\0';
+    while ((*pcFmt != '\0') && (u32Len + 1 < u32Size))
+    {
+        if (*pcFmt != '%')
+        {
+            pcMsg[u32Len++] = *pcFmt++;
+            pcMsg[u32Len] = '\0';
+            continue;
+        }
+
+        /* %, flags, width and precision, '*' taking an argument */
+        u32Spec = 0;
+        acSpec[u32Spec++] = *pcFmt++;
+        while ((*pcFmt != '\0') && (strchr("-+ #0", *pcFmt) != NULL) && (u32Spec < SPEC_SIZE - 16))
+            acSpec[u32Spec++] = *pcFmt++;
+        while ((((*pcFmt >= '0') && (*pcFmt <= '9')) || (*pcFmt == '.') || (*pcFmt == '*')) && (u32Spec < SPEC_SIZE - 16))
+        {
+            if (*pcFmt == '*')
+                u32Spec += (uint32_t)sprintf(&acSpec[u32Spec], "%d", (int32_t)ARG());
+            else
+                acSpec[u32Spec++] = *pcFmt;
+            pcFmt++;
+        }
+        while ((*pcFmt != '\0') && (strchr("hljztL", *pcFmt) != NULL))
+            pcFmt++;
+
+        acSpec[u32Spec++] = *pcFmt;
+        acSpec[u32Spec] = '\0';
+
+        switch (*pcFmt)
+        {
+        case 'd':
+        case 'i':
+            ADD(acSpec, (int32_t)ARG());
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            ADD(acSpec, ARG());
+            break;
+        case 'c':
+            ADD(acSpec, (int)(char)ARG());
+            break;
+        case 'p':
+            acSpec[u32Spec - 1] = 's';
+            snprintf(acPtr, sizeof(acPtr), "0x%08x", ARG());
+            ADD(acSpec, acPtr);
+            break;
+        case 's':
+            u32Value = ARG();
+            if ((pcStr = Str(u32Value)) != NULL)
+            {
+                ADD(acSpec, pcStr);
+            }
+            else
+            {
+                ADD("<str 0x%08X>", u32Value);
+            }
+            break;
+        case '%':
+            ADD("%%");
+            break;
+        case '\0':
+            return u32Len;
+        default:
+            /* Floating point and the like: not loggable as one word */
+            ADD("<%%%c 0x%08X>", *pcFmt, ARG());
+            break;
+        }
+        pcFmt++;
+    }
+
+    if (u32Arg < u32Argc)
+        ADD(" <%u extra argument(s)>", u32Argc - u32Arg);
+
+#undef ARG
+#undef ADD
+
+    return u32Len;
+}
+
+static void Record(const uint32_t *pu32Rec)
+{
+    uint32_t u32Hdr = pu32Rec[0], u32Time = pu32Rec[1], u32Len;
+    char acMsg[MSG_SIZE];
+    uint8_t au8Text[DLOG_TEXT_MAX];
+    const char *pcFmt;
+
+    /* Frames lost on the wire: the numbers run on across them */
+    if (s_u32HaveSeq && (HDR_SEQ(u32Hdr) != s_u32NextSeq) && (HDR_TYPE(u32Hdr) != DLOG_TYPE_INFO))
+    {
+        s_u32Lost += (HDR_SEQ(u32Hdr) - s_u32NextSeq) & 0xFF;
+        snprintf(acMsg, sizeof(acMsg), "<<< %u frame(s) lost >>>\n", (HDR_SEQ(u32Hdr) - s_u32NextSeq) & 0xFF);
+        Note(u32Time, acMsg);
+    }
+    s_u32NextSeq = (HDR_SEQ(u32Hdr) + 1) & 0xFF;
+    s_u32HaveSeq = 1;
+
+    /* Time since the INFO record; the drain stamps a DROP record later than those around it */
+    if (HDR_TYPE(u32Hdr) == DLOG_TYPE_INFO)
+    {
+        s_u64Time = 0;
+        s_u32LastTime = u32Time;
+        s_u32HaveTime = 1;
+    }
+    else if (s_u32HaveTime && (HDR_TYPE(u32Hdr) != DLOG_TYPE_DROP))
+    {
+        s_u64Time += (uint32_t)(u32Time - s_u32LastTime);
+        s_u32LastTime = u32Time;
+    }
+
+    switch (HDR_TYPE(u32Hdr))
+    {
+    case DLOG_TYPE_INFO:
+        s_u32Freq = pu32Rec[2];
+        snprintf(acMsg, sizeof(acMsg), "--- log start, %u Hz, format %u%s ---\n", pu32Rec[2], pu32Rec[3],
+                 (pu32Rec[3] != DLOG_VERSION) ? " (unknown)" : "");
+        Note(u32Time, acMsg);
+        break;
+
+    case DLOG_TYPE_DROP:
+        s_u32Dropped += pu32Rec[2];
+        snprintf(acMsg, sizeof(acMsg), "<<< %u message(s) dropped on the target >>>\n", pu32Rec[2]);
+        Note(u32Time, acMsg);
+        break;
+
+    case DLOG_TYPE_TEXT:
+        for (u32Len = 0; u32Len < HDR_LEN(u32Hdr); u32Len++)
+            au8Text[u32Len] = (uint8_t)(pu32Rec[2 + u32Len / 4] >> (8 * (u32Len % 4)));
+        Out(u32Time, (const char *)au8Text, HDR_LEN(u32Hdr));
+        break;
+
+    default:
+        if ((pcFmt = Str(pu32Rec[2])) == NULL)
+        {
+            snprintf(acMsg, sizeof(acMsg), "<format 0x%08X not in the image, %u argument(s)>\n", pu32Rec[2], HDR_LEN(u32Hdr));
+            Note(u32Time, acMsg);
+            break;
+        }
+        u32Len = Format(acMsg, sizeof(acMsg), pcFmt, &pu32Rec[3], HDR_LEN(u32Hdr));
+        Out(u32Time, acMsg, u32Len);
+        break;
+    }
+}
+
+/* A header as DLOG_Drain() makes them */
+static int Valid(uint32_t u32Hdr)
+{
+    uint32_t u32Len = HDR_LEN(u32Hdr), u32Words = HDR_WORDS(u32Hdr);
+
+    switch (HDR_TYPE(u32Hdr))
+    {
+    case DLOG_TYPE_FMT:
+        return (u32Len <= DLOG_MAX_ARGS) && (u32Words == 3 + u32Len);
+    case DLOG_TYPE_TEXT:
+        return (u32Len >= 1) && (u32Len <= DLOG_TEXT_MAX) && (u32Words == 2 + (u32Len + 3) / 4);
+    case DLOG_TYPE_INFO:
+        return (u32Len == 0) && (u32Words == 4);
+    case DLOG_TYPE_DROP:
+        return (u32Len == 0) && (u32Words == 3);
+    default:
+        return 0;
+    }
+}
+
+static int Fill(FILE *fp, uint32_t u32Need)
+{
+    int c;
+
+    while (s_u32BufLen < u32Need)
+    {
+        if ((c = fgetc(fp)) == EOF)
+            return 0;
+        s_au8Buf[s_u32BufLen++] = (uint8_t)c;
+    }
+
+    return 1;
+}
+
+static void Consume(uint32_t u32Len)
+{
+    memmove(s_au8Buf, &s_au8Buf[u32Len], s_u32BufLen - u32Len);
+    s_u32BufLen -= u32Len;
+}
+
+static void Decode(FILE *fp, int iLive)
+{
+    uint32_t au32Rec[REC_MAX_WORDS], u32Hdr, u32Words, i;
+
+    while (Fill(fp, 1))
+    {
+        if (s_au8Buf[0] != DLOG_SYNC)
+        {
+            Consume(1);
+            s_u32Skipped++;
+            continue;
+        }
+
+        if (!Fill(fp, 5))
+            break;
+
+        /* Not a frame after all: look again from the next byte */
+        u32Hdr = Le(&s_au8Buf[1], 4);
+        if (!Valid(u32Hdr))
+        {
+            Consume(1);
+            s_u32Skipped++;
+            continue;
+        }
+
+        u32Words = HDR_WORDS(u32Hdr);
+        if (!Fill(fp, 1 + u32Words * 4))
+            break;
+
+        for (i = 0; i < u32Words; i++)
+            au32Rec[i] = Le(&s_au8Buf[1 + i * 4], 4);
+        Consume(1 + u32Words * 4);
+        s_u32Frames++;
+
+        Record(au32Rec);
+        if (iLive)
+            fflush(stdout);
+    }
+
+    s_u32Skipped += s_u32BufLen;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    int iLive;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s image.axf capture.bin\n"
+                "       %s image.axf - < /dev/ttyACM0\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    LoadImage(argv[1]);
+
+    iLive = (strcmp(argv[2], "-") == 0);
+    fp = iLive ? stdin : OpenFile(argv[2], "rb");
+    Decode(fp, iLive);
+    if (!iLive)
+        fclose(fp);
+
+    if (s_u32MidLine)
+        fputs("\r\n", stdout);
+    fprintf(stderr, "%u frame(s), %u lost on the wire, %u message(s) dropped on the target, %u byte(s) skipped\n",
+            s_u32Frames, s_u32Lost, s_u32Dropped, s_u32Skipped);
+
+    return 0;
+}
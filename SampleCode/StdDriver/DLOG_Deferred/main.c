@@ -0,0 +1,235 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Log from interrupts in a few dozen cycles with the deferred binary
+ *           log, drained by PDMA over UART0 from the idle loop.
+ *
+ * @details  TIMER0 ticks at 1 kHz and runs a small control step. Every tenth
+ *           tick it logs the step with DLOG(), which stores the format
+ *           address and the arguments in the ring; the cycles the call took
+ *           are measured and reported each second. The main loop moves the
+ *           records to the UART0 TX ring with DLOG_Drain(), PDMA sends them,
+ *           and the CPU sleeps until the next interrupt.
+ *           The project defines DEBUG_DEFERRED_LOG, so printf() goes into the
+ *           same log as text instead of waiting on UART0.
+ *           Press 'b' for a burst of 400 messages, more than the ring holds,
+ *           to see the DROP record; 's' prints the log statistics.
+ *           UART0 carries binary frames: capture it raw and format it on the
+ *           host with the image just built:
+ *               ./dlog_decode DLOG_Deferred.elf - < /dev/ttyACM0
+ *           The host check of the log is SampleCode/HostSim/DLOG_Deferred.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define global variables and constants                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define RING_SIZE           1024            /* Words of the log ring */
+#define RX_SIZE             64
+#define TX_SIZE             1024
+#define DESC_NUM            4               /* Descriptors of the PDMA channel service */
+#define LOG_PERIOD          10              /* Ticks between control step messages */
+#define BURST_MSGS          400
+
+static uint32_t s_au32Ring[RING_SIZE];
+static uint8_t s_au8Rx[RX_SIZE];
+static uint8_t s_au8Tx[TX_SIZE];
+static DSCT_T s_asDesc[DESC_NUM];
+static PDMA_SVC_T s_sSvc;
+static UART_BUF_T s_sUart;
+
+static volatile uint32_t s_u32Ticks;
+static volatile uint32_t s_u32Burst;
+static volatile uint32_t s_u32LogMax;       /* Most cycles one DLOG() took in TMR0_IRQHandler() */
+static int32_t s_i32Out, s_i32Integ;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define functions prototype                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void);
+void SYS_Init(void);
+void UART0_Init(void);
+void TMR0_IRQHandler(void);
+void UART0_IRQHandler(void);
+void PDMA0_IRQHandler(void);
+
+
+/**
+ * @brief       IRQ Handler for Timer0 Interrupt
+ * @param       None
+ * @return      None
+ * @details     A PI step towards a set point that steps every second, logged every LOG_PERIOD ticks.
+ */
+void TMR0_IRQHandler(void)
+{
+    uint32_t u32Tick = ++s_u32Ticks, u32Start, u32Cycles, i;
+    int32_t i32Set = ((u32Tick / 1000) & 1) ? 1000 : -1000;
+    int32_t i32Err = i32Set - s_i32Out;
+
+    TIMER_ClearIntFlag(TIMER0);
+
+    s_i32Integ += i32Err;
+    s_i32Out += i32Err / 8 + s_i32Integ / 256;
+
+    if((u32Tick % LOG_PERIOD) == 0)
+    {
+        u32Start = DWT->CYCCNT;
+        DLOG("tick %u: set %d out %d err %d\n", u32Tick, i32Set, s_i32Out, i32Err);
+        u32Cycles = DWT->CYCCNT - u32Start;
+        if(u32Cycles > s_u32LogMax)
+            s_u32LogMax = u32Cycles;
+    }
+
+    if((u32Tick % 1000) == 0)
+    {
+        DLOG("%u s: DLOG() took %u cycles at most\n", u32Tick / 1000, s_u32LogMax);
+        s_u32LogMax = 0;
+    }
+
+    /* Far more than the UART can keep up with */
+    if(s_u32Burst)
+    {
+        s_u32Burst = 0;
+        for(i = 0; i < BURST_MSGS; i++)
+            DLOG("burst %u of %u at tick %u\n", i + 1, BURST_MSGS, u32Tick);
+    }
+}
+
+void UART0_IRQHandler(void)
+{
+    UART_BufIRQHandler(&s_sUart);
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+    UART_BufPdmaIRQHandler(&s_sUart);
+}
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Enable HIRC clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk);
+
+    /* Wait for HIRC clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable UART0, TIMER0 and PDMA0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(TMR0_MODULE);
+    CLK_EnableModuleClock(PDMA0_MODULE);
+
+    /* Select UART0 and TIMER0 module clock source as HIRC */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HIRC, 0);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+}
+
+void UART0_Init(void)
+{
+    UART_BUF_CFG_T sCfg = {0};
+
+    /* Reset UART0 */
+    SYS_ResetModule(UART0_RST);
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+
+    /* TX by a PDMA channel of the service, the keys by the RX FIFO interrupt */
+    PDMA_SvcInit(&s_sSvc, PDMA0, s_asDesc, DESC_NUM, PDMA_SCATBA_SET, 0, NULL);
+
+    sCfg.uart = UART0;
+    sCfg.psSvc = &s_sSvc;
+    sCfg.u32RxChFlags = UART_BUF_NO_PDMA;
+    sCfg.u32TxChFlags = PDMA_SVC_CH_ANY;
+    sCfg.pu8RxBuf = s_au8Rx;
+    sCfg.u32RxSize = RX_SIZE;
+    sCfg.pu8TxBuf = s_au8Tx;
+    sCfg.u32TxSize = TX_SIZE;
+    UART_BufOpen(&s_sUart, &sCfg);
+}
+
+static void PrintStats(void)
+{
+    DLOG_STAT_T sStat;
+
+    DLOG_GetStats(&sStat);
+    printf("Log: %u records sent, %u dropped, ring %u of %u words at most\n",
+           sStat.u32Drained, sStat.u32Dropped, sStat.u32MaxUsed, RING_SIZE);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    uint8_t u8Key;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Protected registers stay unlocked for CLK_Idle() */
+
+    /* Init the log before anything prints, then UART0 to send it */
+    DLOG_Init(s_au32Ring, RING_SIZE);
+    UART0_Init();
+
+    NVIC_SetPriority(TMR0_IRQn, 1);
+    NVIC_SetPriority(UART0_IRQn, 2);
+    NVIC_SetPriority(PDMA0_IRQn, 2);
+    NVIC_EnableIRQ(UART0_IRQn);
+    NVIC_EnableIRQ(PDMA0_IRQn);
+
+    printf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    printf("+------------------------------------------+\n");
+    printf("|      Deferred Binary Log Sample Code     |\n");
+    printf("+------------------------------------------+\n\n");
+    printf("Press 'b' for a burst, 's' for the statistics.\n");
+
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 1000);
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+    TIMER_Start(TIMER0);
+
+    while(1)
+    {
+        if(UART_BufRead(&s_sUart, &u8Key, 1) == 1)
+        {
+            if(u8Key == 'b')
+                s_u32Burst = 1;
+            else if(u8Key == 's')
+                PrintStats();
+        }
+
+        /*
+            The idle loop: what the interrupts logged goes to the TX ring, then sleep. A record
+            logged after the drain waits for the next wake-up, the next tick at the latest.
+        */
+        DLOG_Drain(&s_sUart);
+        CLK_Idle();
+    }
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
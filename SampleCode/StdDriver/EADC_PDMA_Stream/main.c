@@ -0,0 +1,296 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Continuous four-channel EADC acquisition into a ring of
+ *           timestamped PDMA blocks with the EADC_Stream API.
+ *
+ * @details  TIMER0 triggers sample modules 0~3 (EADC0_CH0~CH3) at 16 kHz.
+ *           PDMA0 channel 2 walks a circular chain of scatter-gather
+ *           descriptors, so acquisition never pauses between blocks. The main
+ *           loop fetches every completed 8 ms block, prints the channel means
+ *           once per second with the ring statistics, and stops after ten
+ *           seconds. Press a key during the run to stall the consumer for
+ *           100 ms and watch the overrun counter.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define global variables and constants                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define MODULE_CNT          4
+#define SAMPLE_RATE         16000
+#define BLOCK_FRAMES        128                             /* 8 ms per block */
+#define BLOCK_CNT           8
+#define BLOCKS_PER_SEC      (SAMPLE_RATE / BLOCK_FRAMES)
+#define RUN_SECONDS         10
+
+static uint16_t s_au16Buf[BLOCK_CNT * BLOCK_FRAMES * MODULE_CNT];
+static DSCT_T s_asDesc[BLOCK_CNT];
+static EADC_STREAM_BLK_T s_asBlk[BLOCK_CNT];
+static EADC_STREAM_T s_sStream;
+static const uint32_t s_au32Channel[MODULE_CNT] = {0, 1, 2, 3};
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define functions prototype                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void);
+void SYS_Init(void);
+void UART0_Init(void);
+void TIMER0_Init(void);
+void PDMA0_IRQHandler(void);
+
+
+static uint32_t GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+void SYS_Init(void)
+{
+
+    /* Set PF multi-function pins for XT1_OUT(PF.2) and XT1_IN(PF.3) */
+    SET_XT1_OUT_PF2();
+    SET_XT1_IN_PF3();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable EADC0 module clock */
+    CLK_EnableModuleClock(EADC0_MODULE);
+
+    /* Set EADC0 clock divider as 12 */
+    CLK_SetModuleClock(EADC0_MODULE, CLK_CLKSEL0_EADC0SEL_PLL_DIV2, CLK_CLKDIV0_EADC0(12));
+
+    /* Enable Timer 0 module clock */
+    CLK_EnableModuleClock(TMR0_MODULE);
+
+    /* Select timer 0 module clock source as HXT */
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HXT, 0);
+
+    /* Enable PDMA0 clock source */
+    CLK_EnableModuleClock(PDMA0_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Set multi-function pins for EADC0 channels. */
+    SET_EADC0_CH0_PB0();
+    SET_EADC0_CH1_PB1();
+    SET_EADC0_CH2_PB2();
+    SET_EADC0_CH3_PB3();
+
+    /* Disable digital input path of EADC analog pin to prevent leakage */
+    GPIO_DISABLE_DIGITAL_PATH(PB, BIT3 | BIT2 | BIT1 | BIT0);
+
+}
+
+void UART0_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init UART                                                                                               */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+void TIMER0_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init TIMER0                                                                                             */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* 16 kHz periodic time-out from the 12 MHz HXT */
+    TIMER_SET_CMP_VALUE(TIMER0, __HXT / SAMPLE_RATE);
+
+    /* Periodic mode, time-out event triggers EADC */
+    TIMER0->CTL = TIMER_PERIODIC_MODE | TIMER_CTL_OPMODE_Msk;
+    TIMER0->TRGCTL |= TIMER_TRGCTL_TRGEADC_Msk;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* PDMA interrupt handler                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+void PDMA0_IRQHandler(void)
+{
+    if (PDMA_GET_TD_STS(PDMA0) & (1UL << s_sStream.sCfg.u32PdmaCh))
+        EADC_StreamIRQHandler(&s_sStream);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    EADC_STREAM_CFG_T sCfg;
+    EADC_STREAM_BLK_T *psBlk;
+    uint32_t au32Sum[MODULE_CNT] = {0};
+    uint32_t u32Blocks = 0, u32Seconds = 0, u32Late = 0, u32Delay, f, m;
+    int32_t i32Err;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, IP clock and multi-function I/O */
+    SYS_Init();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    /* Init TIMER0 for EADC */
+    TIMER0_Init();
+
+    /* Cycle counter for the block timestamps */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* SAMPLE CODE                                                                                             */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    printf("\nSystem clock rate: %d Hz\n", SystemCoreClock);
+    printf("+----------------------------------------------------------------------+\n");
+    printf("|          EADC continuous acquisition with PDMA block ring            |\n");
+    printf("+----------------------------------------------------------------------+\n");
+    printf("EADC0_CH0~CH3 at %d Hz, %d frames per block, %d blocks in the ring.\n", SAMPLE_RATE, BLOCK_FRAMES, BLOCK_CNT);
+    printf("Press any key to stall the consumer for 100 ms.\n\n");
+
+    /* Set input mode as single-end and enable the A/D converter */
+    i32Err = EADC_Open(EADC0, EADC_CTL_DIFFEN_SINGLE_END);
+
+    /* Check EADC global error code. */
+    if (i32Err != 0)
+    {
+        if (i32Err == EADC_CAL_ERR)
+            printf("EADC has calibration error.\n");
+        else if (i32Err == EADC_CLKDIV_ERR)
+            printf("EADC clock frequency is configured error.\n");
+        else
+            printf("EADC has operation error.\n");
+
+        goto lexit;
+    }
+
+    sCfg.pdma = PDMA0;
+    sCfg.u32PdmaCh = 2;
+    sCfg.u32ModuleCnt = MODULE_CNT;
+    sCfg.pu32Channel = s_au32Channel;
+    sCfg.u32TriggerSrc = EADC_TIMER0_TRIGGER;
+    sCfg.u32BlockFrames = BLOCK_FRAMES;
+    sCfg.u32BlockCnt = BLOCK_CNT;
+    sCfg.pu16Buf = s_au16Buf;
+    sCfg.psDesc = s_asDesc;
+    sCfg.u32ScatMode = PDMA_SCATBA_SET;
+    sCfg.psBlk = s_asBlk;
+    sCfg.pfnGetTime = GetCycles;
+
+    if (EADC_StreamOpen(EADC0, &s_sStream, &sCfg) != 0)
+    {
+        printf("EADC_StreamOpen failed.\n");
+        goto lexit;
+    }
+
+    EADC_StreamStart(&s_sStream);
+    NVIC_EnableIRQ(PDMA0_IRQn);
+    TIMER_Start(TIMER0);
+
+    while (u32Seconds < RUN_SECONDS)
+    {
+        if ((psBlk = EADC_StreamGetBlock(&s_sStream)) == NULL)
+        {
+            if (!(UART0->FIFOSTS & UART_FIFOSTS_RXEMPTY_Msk))
+            {
+                (void)UART0->DAT;
+
+                /* Simulate a consumer that misses its deadline */
+                for (u32Delay = GetCycles(); GetCycles() - u32Delay < SystemCoreClock / 10;) {}
+            }
+
+            continue;
+        }
+
+        for (f = 0; f < BLOCK_FRAMES; f++)
+            for (m = 0; m < MODULE_CNT; m++)
+                au32Sum[m] += psBlk->pu16Data[f * MODULE_CNT + m] & EADC_DAT_RESULT_Msk;
+
+        if (EADC_StreamReleaseBlock(&s_sStream) != 0)
+            u32Late++;
+
+        if (++u32Blocks == BLOCKS_PER_SEC)
+        {
+            printf("[%2d s] mean %4d %4d %4d %4d | seq %6d overruns %d late %d fill %d/%d latency %d us trigger overruns %d merged %d\n",
+                   ++u32Seconds,
+                   au32Sum[0] / (BLOCKS_PER_SEC * BLOCK_FRAMES), au32Sum[1] / (BLOCKS_PER_SEC * BLOCK_FRAMES),
+                   au32Sum[2] / (BLOCKS_PER_SEC * BLOCK_FRAMES), au32Sum[3] / (BLOCKS_PER_SEC * BLOCK_FRAMES),
+                   psBlk->u32Seq, s_sStream.u32Overruns, s_sStream.u32LateBlocks, s_sStream.u32MaxFill,
+                   BLOCK_CNT - 1, s_sStream.u32MaxLatency / (SystemCoreClock / 1000000), s_sStream.u32TriggerOverruns,
+                   s_sStream.u32MergedBlocks);
+
+            for (m = 0; m < MODULE_CNT; m++)
+                au32Sum[m] = 0;
+
+            u32Blocks = 0;
+        }
+    }
+
+    TIMER_Stop(TIMER0);
+    EADC_StreamStop(&s_sStream);
+    NVIC_DisableIRQ(PDMA0_IRQn);
+
+    printf("\nDone. Late blocks reported by EADC_StreamReleaseBlock(): %d\n", u32Late);
+
+lexit:
+
+    /* Reset Timer0 module */
+    SYS_ResetModule(TMR0_RST);
+
+    /* Reset EADC module */
+    SYS_ResetModule(EADC0_RST);
+
+    /* Disable Timer0 IP clock */
+    CLK_DisableModuleClock(TMR0_MODULE);
+
+    /* Disable EADC IP clock */
+    CLK_DisableModuleClock(EADC0_MODULE);
+
+    printf("Exit EADC sample code\n");
+
+    while (1);
+}
@@ -0,0 +1,500 @@
+/**************************************************************************//**
+ * @file     abpatch.c
+ * @version  V1.00
+ * @brief    Host side of the FMC A/B update sample: builds full and delta
+ *           update packages for FMC_UpdWrite().
+ *
+ * @details  Build: gcc -O2 -o abpatch abpatch.c
+ *
+ *           ./abpatch full new.bin out.pkg [version]
+ *               Package of the whole image, insert records only; applies to
+ *               any running image.
+ *           ./abpatch delta old.bin new.bin out.pkg [version]
+ *               Package copying from old.bin, the running image, whatever
+ *               new.bin has in common with it; only the image whose SHA-256
+ *               is that of old.bin accepts it. Matches are searched at every
+ *               byte offset, so code moved by an inserted function is still
+ *               copied.
+ *           ./abpatch info in.pkg
+ *               Header, record counts and bytes.
+ *
+ *           The .bin files are the images as programmed (objcopy -O binary).
+ *           Define ABPATCH_NO_MAIN to link ABPATCH_Build() into another
+ *           program, as the HostSim check does.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "abpatch.h"
+
+/* Package layout, as FMC_UPD_PKG_T and FMC_UPD_REC_T of fmc.h */
+#define PKG_MAGIC           0x4B50554EUL
+#define PKG_DELTA           0x1UL
+#define PKG_HDR_SIZE        84
+#define REC_COPY            0x01UL
+#define REC_INSERT          0x02UL
+#define REC_HDR_SIZE        12
+
+/* Shortest copy worth a record, longest insert record: each record is checked before the next one */
+#define MIN_MATCH           32
+#define MAX_INSERT          4096
+
+/* Match index over 8-byte keys of the old image */
+#define HASH_BITS           18
+#define HASH_KEY            8
+#define MAX_CHAIN           64
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* SHA-256 and CRC-32                                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+static const uint32_t s_au32K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t au32H[8], const uint8_t *pu8Block)
+{
+    uint32_t au32W[64], au32V[8], t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        au32W[i] = ((uint32_t)pu8Block[4 * i] << 24) | ((uint32_t)pu8Block[4 * i + 1] << 16) |
+                   ((uint32_t)pu8Block[4 * i + 2] << 8) | pu8Block[4 * i + 3];
+    for (i = 16; i < 64; i++)
+        au32W[i] = (ROR(au32W[i - 2], 17) ^ ROR(au32W[i - 2], 19) ^ (au32W[i - 2] >> 10)) + au32W[i - 7] +
+                   (ROR(au32W[i - 15], 7) ^ ROR(au32W[i - 15], 18) ^ (au32W[i - 15] >> 3)) + au32W[i - 16];
+
+    memcpy(au32V, au32H, sizeof(au32V));
+    for (i = 0; i < 64; i++)
+    {
+        t1 = au32V[7] + (ROR(au32V[4], 6) ^ ROR(au32V[4], 11) ^ ROR(au32V[4], 25)) +
+             ((au32V[4] & au32V[5]) ^ (~au32V[4] & au32V[6])) + s_au32K[i] + au32W[i];
+        t2 = (ROR(au32V[0], 2) ^ ROR(au32V[0], 13) ^ ROR(au32V[0], 22)) +
+             ((au32V[0] & au32V[1]) ^ (au32V[0] & au32V[2]) ^ (au32V[1] & au32V[2]));
+        memmove(&au32V[1], &au32V[0], 7 * sizeof(uint32_t));
+        au32V[4] += t1;
+        au32V[0] = t1 + t2;
+    }
+
+    for (i = 0; i < 8; i++)
+        au32H[i] += au32V[i];
+}
+
+void ABPATCH_Sha256(const uint8_t *pu8Data, uint32_t u32Len, uint8_t au8Digest[32])
+{
+    uint32_t au32H[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    uint64_t u64Bits = (uint64_t)u32Len * 8;
+    uint8_t au8Tail[128];
+    uint32_t u32Tail, i;
+
+    for (; u32Len >= 64; u32Len -= 64, pu8Data += 64)
+        sha256_block(au32H, pu8Data);
+
+    memset(au8Tail, 0, sizeof(au8Tail));
+    memcpy(au8Tail, pu8Data, u32Len);
+    au8Tail[u32Len] = 0x80;
+    u32Tail = (u32Len < 56) ? 64 : 128;
+    for (i = 0; i < 8; i++)
+        au8Tail[u32Tail - 1 - i] = (uint8_t)(u64Bits >> (8 * i));
+
+    sha256_block(au32H, au8Tail);
+    if (u32Tail == 128)
+        sha256_block(au32H, au8Tail + 64);
+
+    for (i = 0; i < 32; i++)
+        au8Digest[i] = (uint8_t)(au32H[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+uint32_t ABPATCH_Crc32(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    static uint32_t s_au32Table[256];
+    uint32_t u32Crc = 0xFFFFFFFFUL, i, j;
+
+    if (s_au32Table[1] == 0)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            for (u32Crc = i, j = 0; j < 8; j++)
+                u32Crc = (u32Crc >> 1) ^ ((u32Crc & 1) ? 0xEDB88320UL : 0);
+            s_au32Table[i] = u32Crc;
+        }
+        u32Crc = 0xFFFFFFFFUL;
+    }
+
+    while (u32Len--)
+        u32Crc = (u32Crc >> 8) ^ s_au32Table[(u32Crc ^ *pu8Data++) & 0xFF];
+
+    return ~u32Crc;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Package writer                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef struct
+{
+    uint8_t *pu8Out;
+    uint32_t u32Max;
+    uint32_t u32Len;
+    int      iOverflow;
+    ABPATCH_STAT_T *psStat;
+} WRITER_T;
+
+static void put_bytes(WRITER_T *psW, const void *pvData, uint32_t u32Len)
+{
+    if (psW->iOverflow || (u32Len > psW->u32Max - psW->u32Len))
+    {
+        psW->iOverflow = 1;
+        return;
+    }
+
+    memcpy(psW->pu8Out + psW->u32Len, pvData, u32Len);
+    psW->u32Len += u32Len;
+}
+
+static void put_u32(uint8_t *pu8, uint32_t u32Val)
+{
+    pu8[0] = (uint8_t)u32Val;
+    pu8[1] = (uint8_t)(u32Val >> 8);
+    pu8[2] = (uint8_t)(u32Val >> 16);
+    pu8[3] = (uint8_t)(u32Val >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *pu8)
+{
+    return pu8[0] | ((uint32_t)pu8[1] << 8) | ((uint32_t)pu8[2] << 16) | ((uint32_t)pu8[3] << 24);
+}
+
+static void put_record(WRITER_T *psW, uint32_t u32Op, uint32_t u32Arg, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint8_t au8Rec[REC_HDR_SIZE];
+
+    put_u32(au8Rec, u32Op | (u32Len << 8));
+    put_u32(au8Rec + 4, u32Arg);
+    put_u32(au8Rec + 8, ABPATCH_Crc32(pu8Data, u32Len));
+    put_bytes(psW, au8Rec, sizeof(au8Rec));
+
+    if (u32Op == REC_INSERT)
+    {
+        put_bytes(psW, pu8Data, u32Len);
+        psW->psStat->u32Inserts++;
+        psW->psStat->u32InsertBytes += u32Len;
+    }
+    else
+    {
+        psW->psStat->u32Copies++;
+        psW->psStat->u32CopyBytes += u32Len;
+    }
+}
+
+static void put_inserts(WRITER_T *psW, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Cnt;
+
+    for (; u32Len; u32Len -= u32Cnt, pu8Data += u32Cnt)
+    {
+        u32Cnt = (u32Len < MAX_INSERT) ? u32Len : MAX_INSERT;
+        put_record(psW, REC_INSERT, 0, pu8Data, u32Cnt);
+    }
+}
+
+static uint32_t hash_key(const uint8_t *pu8)
+{
+    uint64_t u64Key;
+
+    memcpy(&u64Key, pu8, HASH_KEY);
+    return (uint32_t)((u64Key * 0x9E3779B97F4A7C15ULL) >> (64 - HASH_BITS));
+}
+
+static uint32_t match_len(const uint8_t *pu8A, const uint8_t *pu8B, uint32_t u32Max)
+{
+    uint32_t u32Len = 0;
+
+    while ((u32Len < u32Max) && (pu8A[u32Len] == pu8B[u32Len]))
+        u32Len++;
+
+    return u32Len;
+}
+
+/**
+  * @brief      Build an update package.
+  * @param[in]  pu8Old      Running image for a delta package, NULL for a full one.
+  * @param[in]  u32OldLen   Its size.
+  * @param[in]  pu8New      New image.
+  * @param[in]  u32NewLen   Its size.
+  * @param[in]  u32Version  Version kept in the trailer of the new image.
+  * @param[out] pu8Pkg      Package.
+  * @param[in]  u32PkgMax   Room for it.
+  * @param[out] psStat      Record counts, may be NULL.
+  * @return     Package size, 0 when it does not fit u32PkgMax or memory runs out.
+  */
+uint32_t ABPATCH_Build(const uint8_t *pu8Old, uint32_t u32OldLen, const uint8_t *pu8New, uint32_t u32NewLen,
+                       uint32_t u32Version, uint8_t *pu8Pkg, uint32_t u32PkgMax, ABPATCH_STAT_T *psStat)
+{
+    ABPATCH_STAT_T sStat;
+    WRITER_T sW;
+    uint8_t au8Hdr[PKG_HDR_SIZE];
+    int32_t *pi32Head = NULL, *pi32Prev = NULL, i32Cand;
+    uint32_t u32Pos, u32Lit, u32Best, u32BestSrc, u32Len, u32Chain, u32Next = 0, i;
+
+    memset(&sStat, 0, sizeof(sStat));
+    memset(&sW, 0, sizeof(sW));
+    sW.pu8Out = pu8Pkg;
+    sW.u32Max = u32PkgMax;
+    sW.psStat = &sStat;
+
+    memset(au8Hdr, 0, sizeof(au8Hdr));
+    put_u32(au8Hdr, PKG_MAGIC);
+    put_u32(au8Hdr + 4, pu8Old ? PKG_DELTA : 0);
+    put_u32(au8Hdr + 8, u32NewLen);
+    put_u32(au8Hdr + 12, u32Version);
+    if (pu8Old)
+        ABPATCH_Sha256(pu8Old, u32OldLen, au8Hdr + 16);
+    ABPATCH_Sha256(pu8New, u32NewLen, au8Hdr + 48);
+    put_u32(au8Hdr + 80, ABPATCH_Crc32(au8Hdr, 80));
+    put_bytes(&sW, au8Hdr, sizeof(au8Hdr));
+
+    if ((pu8Old == NULL) || (u32OldLen < HASH_KEY))
+    {
+        put_inserts(&sW, pu8New, u32NewLen);
+    }
+    else
+    {
+        pi32Head = malloc(sizeof(int32_t) << HASH_BITS);
+        pi32Prev = malloc(sizeof(int32_t) * u32OldLen);
+        if ((pi32Head == NULL) || (pi32Prev == NULL))
+        {
+            free(pi32Head);
+            free(pi32Prev);
+            return 0;
+        }
+
+        memset(pi32Head, 0xFF, sizeof(int32_t) << HASH_BITS);
+        for (i = 0; i + HASH_KEY <= u32OldLen; i++)
+        {
+            pi32Prev[i] = pi32Head[hash_key(pu8Old + i)];
+            pi32Head[hash_key(pu8Old + i)] = (int32_t)i;
+        }
+
+        /* Greedy: the longest match at each position, trying first where the last copy ended */
+        for (u32Pos = 0, u32Lit = 0; u32Pos < u32NewLen;)
+        {
+            u32Best = 0;
+            u32BestSrc = 0;
+
+            if (u32Next < u32OldLen)
+            {
+                u32Best = match_len(pu8Old + u32Next, pu8New + u32Pos,
+                                    (u32OldLen - u32Next < u32NewLen - u32Pos) ? u32OldLen - u32Next : u32NewLen - u32Pos);
+                u32BestSrc = u32Next;
+            }
+
+            if ((u32Best < MIN_MATCH) && (u32Pos + HASH_KEY <= u32NewLen))
+            {
+                for (i32Cand = pi32Head[hash_key(pu8New + u32Pos)], u32Chain = 0; (i32Cand >= 0) && (u32Chain < MAX_CHAIN);
+                        i32Cand = pi32Prev[i32Cand], u32Chain++)
+                {
+                    u32Len = match_len(pu8Old + i32Cand, pu8New + u32Pos,
+                                       (u32OldLen - (uint32_t)i32Cand < u32NewLen - u32Pos) ? u32OldLen - (uint32_t)i32Cand : u32NewLen - u32Pos);
+                    if (u32Len > u32Best)
+                    {
+                        u32Best = u32Len;
+                        u32BestSrc = (uint32_t)i32Cand;
+                    }
+                }
+            }
+
+            if (u32Best < MIN_MATCH)
+            {
+                u32Pos++;
+                u32Lit++;
+                continue;
+            }
+
+            put_inserts(&sW, pu8New + u32Pos - u32Lit, u32Lit);
+            u32Lit = 0;
+            while (u32Best)
+            {
+                u32Len = (u32Best < 0xFFFFFFUL) ? u32Best : 0xFFFFFFUL;
+                put_record(&sW, REC_COPY, u32BestSrc, pu8New + u32Pos, u32Len);
+                u32Pos += u32Len;
+                u32BestSrc += u32Len;
+                u32Best -= u32Len;
+            }
+            u32Next = u32BestSrc;
+        }
+        put_inserts(&sW, pu8New + u32Pos - u32Lit, u32Lit);
+
+        free(pi32Head);
+        free(pi32Prev);
+    }
+
+    sStat.u32PkgLen = sW.u32Len;
+    if (psStat)
+        *psStat = sStat;
+
+    return sW.iOverflow ? 0 : sW.u32Len;
+}
+
+#ifndef ABPATCH_NO_MAIN
+
+static uint8_t *load(const char *pcName, uint32_t *pu32Len)
+{
+    FILE *psFile = fopen(pcName, "rb");
+    uint8_t *pu8Data = NULL;
+    long lLen;
+
+    if (psFile == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", pcName);
+        return NULL;
+    }
+
+    if ((fseek(psFile, 0, SEEK_END) == 0) && ((lLen = ftell(psFile)) > 0) && (fseek(psFile, 0, SEEK_SET) == 0) &&
+            ((pu8Data = malloc((size_t)lLen)) != NULL) && (fread(pu8Data, 1, (size_t)lLen, psFile) == (size_t)lLen))
+    {
+        *pu32Len = (uint32_t)lLen;
+    }
+    else
+    {
+        fprintf(stderr, "cannot read %s\n", pcName);
+        free(pu8Data);
+        pu8Data = NULL;
+    }
+
+    fclose(psFile);
+    return pu8Data;
+}
+
+static int info(const char *pcName)
+{
+    const uint8_t *pu8Rec;
+    uint8_t *pu8Pkg;
+    uint32_t u32Len, u32Pos, u32Op, u32RecLen, u32Produced = 0;
+    ABPATCH_STAT_T sStat;
+    int i;
+
+    if ((pu8Pkg = load(pcName, &u32Len)) == NULL)
+        return 1;
+
+    if ((u32Len < PKG_HDR_SIZE) || (get_u32(pu8Pkg) != PKG_MAGIC) || (get_u32(pu8Pkg + 80) != ABPATCH_Crc32(pu8Pkg, 80)))
+    {
+        fprintf(stderr, "%s: bad header\n", pcName);
+        return 1;
+    }
+
+    memset(&sStat, 0, sizeof(sStat));
+    for (u32Pos = PKG_HDR_SIZE; u32Pos + REC_HDR_SIZE <= u32Len;)
+    {
+        pu8Rec = pu8Pkg + u32Pos;
+        u32Op = get_u32(pu8Rec) & 0xFF;
+        u32RecLen = get_u32(pu8Rec) >> 8;
+        u32Pos += REC_HDR_SIZE;
+        u32Produced += u32RecLen;
+        if (u32Op == REC_INSERT)
+        {
+            sStat.u32Inserts++;
+            sStat.u32InsertBytes += u32RecLen;
+            u32Pos += u32RecLen;
+        }
+        else
+        {
+            sStat.u32Copies++;
+            sStat.u32CopyBytes += u32RecLen;
+        }
+    }
+
+    printf("%s: %s package, %u bytes, version 0x%08X\n", pcName, (get_u32(pu8Pkg + 4) & PKG_DELTA) ? "delta" : "full",
+           u32Len, get_u32(pu8Pkg + 12));
+    printf("image      %u bytes, sha256 ", get_u32(pu8Pkg + 8));
+    for (i = 0; i < 32; i++)
+        printf("%02x", pu8Pkg[48 + i]);
+    printf("\n");
+    if (get_u32(pu8Pkg + 4) & PKG_DELTA)
+    {
+        printf("base       sha256 ");
+        for (i = 0; i < 32; i++)
+            printf("%02x", pu8Pkg[16 + i]);
+        printf("\n");
+    }
+    printf("copy       %u records, %u bytes\n", sStat.u32Copies, sStat.u32CopyBytes);
+    printf("insert     %u records, %u bytes\n", sStat.u32Inserts, sStat.u32InsertBytes);
+
+    if ((u32Pos != u32Len) || (u32Produced != get_u32(pu8Pkg + 8)))
+    {
+        fprintf(stderr, "%s: records do not add up to the image\n", pcName);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t *pu8Old = NULL, *pu8New, *pu8Pkg;
+    uint32_t u32OldLen = 0, u32NewLen, u32PkgMax, u32PkgLen, u32Version = 0;
+    ABPATCH_STAT_T sStat;
+    const char *pcOut;
+    FILE *psFile;
+    int iDelta;
+
+    if ((argc == 3) && !strcmp(argv[1], "info"))
+        return info(argv[2]);
+
+    iDelta = (argc >= 5) && !strcmp(argv[1], "delta");
+    if (!iDelta && !((argc >= 4) && !strcmp(argv[1], "full")))
+    {
+        fprintf(stderr, "usage: abpatch full new.bin out.pkg [version]\n"
+                "       abpatch delta old.bin new.bin out.pkg [version]\n"
+                "       abpatch info in.pkg\n");
+        return 2;
+    }
+
+    if (iDelta && ((pu8Old = load(argv[2], &u32OldLen)) == NULL))
+        return 1;
+    if ((pu8New = load(argv[iDelta ? 3 : 2], &u32NewLen)) == NULL)
+        return 1;
+    pcOut = argv[iDelta ? 4 : 3];
+    if (argc > (iDelta ? 5 : 4))
+        u32Version = (uint32_t)strtoul(argv[iDelta ? 5 : 4], NULL, 0);
+
+    /* Never more than the whole image in insert records */
+    u32PkgMax = PKG_HDR_SIZE + u32NewLen + (u32NewLen / MAX_INSERT + 1) * REC_HDR_SIZE;
+    if ((pu8Pkg = malloc(u32PkgMax)) == NULL)
+        return 1;
+
+    u32PkgLen = ABPATCH_Build(pu8Old, u32OldLen, pu8New, u32NewLen, u32Version, pu8Pkg, u32PkgMax, &sStat);
+    if (u32PkgLen == 0)
+    {
+        /* More records than a full package: send that instead */
+        u32PkgLen = ABPATCH_Build(NULL, 0, pu8New, u32NewLen, u32Version, pu8Pkg, u32PkgMax, &sStat);
+        fprintf(stderr, "no gain over a full package, writing a full one\n");
+    }
+
+    if (((psFile = fopen(pcOut, "wb")) == NULL) || (fwrite(pu8Pkg, 1, u32PkgLen, psFile) != u32PkgLen))
+    {
+        fprintf(stderr, "cannot write %s\n", pcOut);
+        return 1;
+    }
+    fclose(psFile);
+
+    printf("%s: %u bytes for a %u byte image (%u.%u%%), %u copy and %u insert records\n", pcOut, u32PkgLen, u32NewLen,
+           (uint32_t)(100ULL * u32PkgLen / u32NewLen), (uint32_t)(1000ULL * u32PkgLen / u32NewLen % 10),
+           sStat.u32Copies, sStat.u32Inserts);
+
+    return 0;
+}
+
+#endif /* ABPATCH_NO_MAIN */
@@ -0,0 +1,40 @@
+/**************************************************************************//**
+ * @file     abpatch.h
+ * @version  V1.00
+ * @brief    Update package builder of the FMC A/B update sample.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __ABPATCH_H__
+#define __ABPATCH_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+  * @brief   Records of a package ABPATCH_Build() wrote.
+  */
+typedef struct
+{
+    uint32_t u32PkgLen;             /*!< Package size */
+    uint32_t u32Copies;             /*!< Copy records */
+    uint32_t u32CopyBytes;          /*!< Image bytes taken from the running image */
+    uint32_t u32Inserts;            /*!< Insert records */
+    uint32_t u32InsertBytes;        /*!< Image bytes carried in the package */
+} ABPATCH_STAT_T;
+
+uint32_t ABPATCH_Build(const uint8_t *pu8Old, uint32_t u32OldLen, const uint8_t *pu8New, uint32_t u32NewLen,
+                       uint32_t u32Version, uint8_t *pu8Pkg, uint32_t u32PkgMax, ABPATCH_STAT_T *psStat);
+void     ABPATCH_Sha256(const uint8_t *pu8Data, uint32_t u32Len, uint8_t au8Digest[32]);
+uint32_t ABPATCH_Crc32(const uint8_t *pu8Data, uint32_t u32Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ABPATCH_H__ */
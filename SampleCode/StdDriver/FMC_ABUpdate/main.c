@@ -0,0 +1,239 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Dual bank firmware update over UART0 while the application runs,
+ *           with full and delta packages, trial boot and rollback.
+ *
+ * @details  The image is its own loader: at each boot FMC_UpdBoot() selects the
+ *           newest committed image and, when it lies in the other bank, a
+ *           routine in SRAM remaps the banks and resets the CPU. Each bank
+ *           holds an image of up to SLOT_SIZE - 4 KB (GCC/fmc_abupdate.ld,
+ *           KEIL/fmc_abupdate.sct, IAR/fmc_abupdate.icf) and its trailer page.
+ *           1. Program the image into bank 0 with the writer (no trailer: only a
+ *              full package updates it).
+ *           2. Build a package on the PC, from the .bin files of the images:
+ *                  HostTool/abpatch full new.bin new.pkg 2
+ *                  HostTool/abpatch delta running.bin new.bin new.pkg 3
+ *           3. Send 'u' and the package to UART0 at 115200 baud, e.g.
+ *                  stty -F /dev/ttyACM0 115200 raw && printf u > /dev/ttyACM0 &&
+ *                  cat new.pkg > /dev/ttyACM0
+ *              The application loop keeps counting while the package is
+ *              received, programmed and verified.
+ *           4. Send 'r' to boot the new image on trial, then 'c' to confirm it.
+ *              Reset without confirming and the previous image boots again.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#define SLOT_SIZE           0x40000UL       /* Image and trailer page in each bank, as the linker scripts */
+#define RX_BUF_SIZE         2048UL          /* Two flash pages of delta copies at 115200 baud */
+#define RX_IDLE_MS          3000UL          /* A package stalled this long is given up */
+
+static FMC_UPD_T s_sUpd;
+
+static volatile uint32_t s_u32Ms;
+static uint8_t s_au8RxBuf[RX_BUF_SIZE];
+static volatile uint32_t s_u32RxHead, s_u32RxTail, s_u32RxOverrun;
+
+void SysTick_Handler(void)
+{
+    s_u32Ms++;
+}
+
+void UART0_IRQHandler(void)
+{
+    uint32_t u32Next;
+
+    while(!(UART0->FIFOSTS & UART_FIFOSTS_RXEMPTY_Msk))
+    {
+        u32Next = (s_u32RxHead + 1UL) % RX_BUF_SIZE;
+        if(u32Next == s_u32RxTail)
+        {
+            (void)UART0->DAT;
+            s_u32RxOverrun++;
+        }
+        else
+        {
+            s_au8RxBuf[s_u32RxHead] = (uint8_t)UART0->DAT;
+            s_u32RxHead = u32Next;
+        }
+    }
+}
+
+static uint32_t GetTime(void)
+{
+    return s_u32Ms;
+}
+
+/* Remap from SRAM: the code in flash changes under the CPU. Never returns. */
+#if defined(__ICCARM__)
+#pragma inline=never
+__ramfunc static void SwitchBank(uint32_t u32Bank)
+#else
+__attribute__((section(".fastcode"), noinline)) static void SwitchBank(uint32_t u32Bank)
+#endif
+{
+    __disable_irq();
+
+    FMC->ISPCMD = FMC_ISPCMD_BANK_REMAP;
+    FMC->ISPADDR = u32Bank;
+    FMC->ISPDAT = 0x5AA55AA5UL;
+    FMC->ISPTRG = FMC_ISPTRG_ISPGO_Msk;
+    while(FMC->ISPTRG & FMC_ISPTRG_ISPGO_Msk) {}
+
+    SYS->IPRST0 |= SYS_IPRST0_CPURST_Msk;
+    while(1) {}
+}
+
+void SYS_Init(void)
+{
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* The update checks records with CRC and pages with the SHA engine of CRPT */
+    CLK_EnableModuleClock(CRC_MODULE);
+    CLK_EnableModuleClock(CRPT_MODULE);
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+}
+
+static void PrintStat(void)
+{
+    const FMC_UPD_STAT_T *psStat = &s_sUpd.sStat;
+
+    printf("  received     %u bytes, %u stalls, %u overruns\n", psStat->u32RxBytes, psStat->u32Stalls, s_u32RxOverrun);
+    printf("  image        %u bytes copied, %u bytes inserted\n", psStat->u32CopyBytes, psStat->u32InsertBytes);
+    printf("  flash        %u pages, %u erases, %u programs, %u double words kept\n",
+           psStat->u32Pages, psStat->u32Erases, psStat->u32Programs, psStat->u32Kept);
+    printf("  update time  %u ms\n", psStat->u32UpdateTime);
+}
+
+int32_t main(void)
+{
+    static const char *s_apcState[] = { "no committed image", "confirmed", "trial", "rolled back" };
+    FMC_UPD_TRAILER_T sTrl;
+    uint32_t u32Bank, u32Head, u32Loops = 0, u32LastRx = 0, u32Updating = 0;
+    int32_t i32Ret;
+    uint8_t u8Ch;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, IP clock and multi-function I/O. */
+    SYS_Init();
+
+    /* Enable ISP and APROM update */
+    FMC_ENABLE_ISP();
+    FMC_ENABLE_AP_UPDATE();
+
+    /* Select the image before anything else runs; a remap comes back here after the reset */
+    FMC_UpdInit(&s_sUpd, SLOT_SIZE, GetTime);
+    i32Ret = FMC_UpdBoot(&s_sUpd);
+    if((i32Ret >= 0) && ((uint32_t)i32Ret != (uint32_t)((FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos)))
+        SwitchBank((uint32_t)i32Ret);
+
+    SysTick_Config(SystemCoreClock / 1000UL);
+
+    /* Configure UART0: 115200, 8-bit word, no parity bit, 1 stop bit. */
+    UART_Open(UART0, 115200);
+    UART_SetTimeoutCnt(UART0, 40);
+    UART_EnableInt(UART0, UART_INTEN_RDAIEN_Msk | UART_INTEN_RXTOIEN_Msk);
+    NVIC_EnableIRQ(UART0_IRQn);
+
+    printf("\n\n");
+    printf("+-----------------------------------------------------------+\n");
+    printf("|          FMC Dual Bank Firmware Update Sample Code         |\n");
+    printf("+-----------------------------------------------------------+\n");
+    u32Bank = (uint32_t)((FMC->ISPSTS & FMC_ISPSTS_FBS_Msk) >> FMC_ISPSTS_FBS_Pos);
+    printf("Running bank %u, %s", u32Bank, s_apcState[s_sUpd.u32BootState]);
+    if(FMC_UpdReadTrailer(&s_sUpd, u32Bank, &sTrl) == FMC_UPD_OK)
+        printf(", version %u, sequence %u", sTrl.u32Version, sTrl.u32Seq);
+    printf("\n[u] receive a package  [c] confirm this image  [r] reset\n");
+
+    while(1)
+    {
+        /* The application: here only a loop counter, to show it keeps running */
+        u32Loops++;
+
+        u32Head = s_u32RxHead;
+        if(u32Head != s_u32RxTail)
+        {
+            u32LastRx = s_u32Ms;
+
+            if(u32Updating)
+            {
+                /* Contiguous part of the receive buffer */
+                i32Ret = FMC_UpdWrite(&s_sUpd, &s_au8RxBuf[s_u32RxTail],
+                                      ((u32Head > s_u32RxTail) ? u32Head : RX_BUF_SIZE) - s_u32RxTail);
+                if(i32Ret > 0)
+                    s_u32RxTail = (s_u32RxTail + (uint32_t)i32Ret) % RX_BUF_SIZE;
+            }
+            else
+            {
+                u8Ch = s_au8RxBuf[s_u32RxTail];
+                s_u32RxTail = (s_u32RxTail + 1UL) % RX_BUF_SIZE;
+
+                if(u8Ch == 'u')
+                {
+                    s_u32RxOverrun = 0;
+                    u32Loops = 0;
+                    u32Updating = (FMC_UpdBegin(&s_sUpd) == FMC_UPD_OK) ? 1UL : 0UL;
+                    printf("%s\n", u32Updating ? "Waiting for the package..." : "Cannot start the update");
+                }
+                else if(u8Ch == 'c')
+                {
+                    printf("Confirm: %s\n", (FMC_UpdConfirm(&s_sUpd) == FMC_UPD_OK) ? "done" : "failed");
+                }
+                else if(u8Ch == 'r')
+                {
+                    printf("Reset\n");
+                    UART_WAIT_TX_EMPTY(UART0);
+                    SYS_ResetCPU();
+                }
+            }
+        }
+
+        if(!u32Updating)
+            continue;
+
+        i32Ret = FMC_UpdPoll(&s_sUpd);
+        if((i32Ret == FMC_UPD_DONE) || (i32Ret < 0) || s_u32RxOverrun ||
+                ((i32Ret == FMC_UPD_OK) && (s_u32Ms - u32LastRx > RX_IDLE_MS)))
+        {
+            u32Updating = 0;
+
+            if(i32Ret == FMC_UPD_DONE)
+                printf("Update committed, version %u; [r] boots it on trial\n", s_sUpd.sPkg.u32Version);
+            else if(i32Ret < 0)
+                printf("Update failed: %d\n", i32Ret);
+            else
+                printf("Update given up: %s\n", s_u32RxOverrun ? "receive overrun" : "package incomplete");
+
+            PrintStat();
+            printf("  application  %u loops meanwhile\n", u32Loops);
+
+            /* Drop what is left of a package */
+            s_u32RxTail = s_u32RxHead;
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/**************************************************************************//**
+ * @file     cdc_bench.c
+ * @version  V1.00
+ * @brief    Host side of the HSUSBD CDC-ACM throughput sample (Linux).
+ *
+ * @details  Build: gcc -O2 -o cdc_bench cdc_bench.c
+ *
+ *           ./cdc_bench /dev/ttyACM0 loop    [seconds] [window]
+ *               Loopback throughput. Keeps up to "window" bytes (default 65536)
+ *               in flight, checks every echoed byte.
+ *           ./cdc_bench /dev/ttyACM0 stream  [seconds]
+ *               Sets the stream baud rate (921600) and DTR, measures the IN
+ *               rate and checks the incrementing pattern for lost bytes.
+ *           ./cdc_bench /dev/ttyACM0 latency [count] [size]
+ *               Round trip time of "size" byte messages (default 16), one at a
+ *               time, min/avg/max over "count" messages (default 1000).
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+#define BUF_SIZE    65536
+
+static uint8_t s_au8Buf[BUF_SIZE];
+static uint8_t s_au8Chk[BUF_SIZE];
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Loopback pattern, byte n of the stream */
+static uint8_t Pattern(uint64_t u64Pos)
+{
+    return (uint8_t)((u64Pos * 131) ^ (u64Pos >> 9));
+}
+
+static int OpenPort(const char *pcDev, speed_t tBaud)
+{
+    struct termios sTio;
+    int iFd, iBits = TIOCM_DTR | TIOCM_RTS;
+
+    iFd = open(pcDev, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (iFd < 0)
+    {
+        perror(pcDev);
+        exit(1);
+    }
+
+    /* The baud rate only reaches the device as SET_LINE_CODE, it selects the mode */
+    tcgetattr(iFd, &sTio);
+    cfmakeraw(&sTio);
+    cfsetispeed(&sTio, tBaud);
+    cfsetospeed(&sTio, tBaud);
+    sTio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(iFd, TCSANOW, &sTio);
+    ioctl(iFd, TIOCMBIS, &iBits);
+    tcflush(iFd, TCIOFLUSH);
+    return iFd;
+}
+
+static void Drain(int iFd)
+{
+    struct pollfd sPfd = { iFd, POLLIN, 0 };
+
+    while ((poll(&sPfd, 1, 100) > 0) && (read(iFd, s_au8Buf, sizeof(s_au8Buf)) > 0));
+}
+
+static int Loop(int iFd, double dSeconds, uint32_t u32Window)
+{
+    uint64_t u64Tx = 0, u64Rx = 0, u64LastRx = 0;
+    double dStart = Now(), dLast = dStart, dNow;
+    struct pollfd sPfd = { iFd, POLLIN, 0 };
+    ssize_t n;
+    size_t i, u32Len;
+
+    printf("loopback, window %u bytes, %.0f s\n", u32Window, dSeconds);
+    while ((dNow = Now()) - dStart < dSeconds)
+    {
+        sPfd.events = POLLIN | (((u64Tx - u64Rx) < u32Window) ? POLLOUT : 0);
+        if (poll(&sPfd, 1, 1000) <= 0)
+        {
+            printf("timeout, %llu bytes outstanding\n", (unsigned long long)(u64Tx - u64Rx));
+            return 1;
+        }
+
+        if (sPfd.revents & POLLOUT)
+        {
+            u32Len = u32Window - (size_t)(u64Tx - u64Rx);
+            if (u32Len > BUF_SIZE)
+                u32Len = BUF_SIZE;
+            for (i = 0; i < u32Len; i++)
+                s_au8Buf[i] = Pattern(u64Tx + i);
+            n = write(iFd, s_au8Buf, u32Len);
+            if (n > 0)
+                u64Tx += n;
+        }
+
+        if (sPfd.revents & POLLIN)
+        {
+            n = read(iFd, s_au8Chk, sizeof(s_au8Chk));
+            for (i = 0; i < (size_t)((n > 0) ? n : 0); i++)
+            {
+                if (s_au8Chk[i] != Pattern(u64Rx + i))
+                {
+                    printf("mismatch at byte %llu\n", (unsigned long long)(u64Rx + i));
+                    return 1;
+                }
+            }
+            if (n > 0)
+                u64Rx += n;
+        }
+
+        if (dNow - dLast >= 1.0)
+        {
+            printf("  %8.2f MB/s\n", (u64Rx - u64LastRx) / (dNow - dLast) / 1e6);
+            u64LastRx = u64Rx;
+            dLast = dNow;
+        }
+    }
+
+    printf("total %llu bytes echoed, %.2f MB/s each way, no error\n", (unsigned long long)u64Rx,
+           u64Rx / (Now() - dStart) / 1e6);
+    return 0;
+}
+
+static int Stream(int iFd, double dSeconds)
+{
+    uint64_t u64Rx = 0, u64LastRx = 0, u64Gaps = 0;
+    double dStart = Now(), dLast = dStart, dNow;
+    struct pollfd sPfd = { iFd, POLLIN, 0 };
+    int iHaveSeq = 0;
+    uint8_t u8Seq = 0;
+    ssize_t n, i;
+
+    printf("stream, %.0f s\n", dSeconds);
+    while ((dNow = Now()) - dStart < dSeconds)
+    {
+        if (poll(&sPfd, 1, 1000) <= 0)
+        {
+            printf("no data, is the device in stream mode?\n");
+            return 1;
+        }
+        n = read(iFd, s_au8Buf, sizeof(s_au8Buf));
+        for (i = 0; i < n; i++)
+        {
+            if (iHaveSeq && (s_au8Buf[i] != u8Seq))
+                u64Gaps++;
+            u8Seq = s_au8Buf[i] + 1;
+            iHaveSeq = 1;
+        }
+        if (n > 0)
+            u64Rx += n;
+
+        if (dNow - dLast >= 1.0)
+        {
+            printf("  %8.2f MB/s\n", (u64Rx - u64LastRx) / (dNow - dLast) / 1e6);
+            u64LastRx = u64Rx;
+            dLast = dNow;
+        }
+    }
+
+    printf("total %llu bytes, %.2f MB/s, %llu sequence break(s)\n", (unsigned long long)u64Rx,
+           u64Rx / (Now() - dStart) / 1e6, (unsigned long long)u64Gaps);
+    return u64Gaps ? 1 : 0;
+}
+
+static int Latency(int iFd, uint32_t u32Count, uint32_t u32Size)
+{
+    double dMin = 1e9, dMax = 0, dSum = 0, dT0, dRtt;
+    struct pollfd sPfd = { iFd, POLLIN, 0 };
+    uint32_t u32Msg, u32Got, i;
+    ssize_t n;
+
+    if (u32Size > BUF_SIZE)
+        u32Size = BUF_SIZE;
+    printf("latency, %u messages of %u bytes\n", u32Count, u32Size);
+
+    for (u32Msg = 0; u32Msg < u32Count; u32Msg++)
+    {
+        for (i = 0; i < u32Size; i++)
+            s_au8Buf[i] = (uint8_t)(u32Msg + i);
+
+        dT0 = Now();
+        if (write(iFd, s_au8Buf, u32Size) != (ssize_t)u32Size)
+        {
+            printf("write failed\n");
+            return 1;
+        }
+        for (u32Got = 0; u32Got < u32Size; u32Got += (uint32_t)n)
+        {
+            if (poll(&sPfd, 1, 1000) <= 0)
+            {
+                printf("message %u: echo timeout after %u bytes\n", u32Msg, u32Got);
+                return 1;
+            }
+            n = read(iFd, s_au8Chk + u32Got, u32Size - u32Got);
+            if (n < 0)
+                n = 0;
+        }
+        dRtt = Now() - dT0;
+
+        if (memcmp(s_au8Buf, s_au8Chk, u32Size))
+        {
+            printf("message %u: echo mismatch\n", u32Msg);
+            return 1;
+        }
+        dSum += dRtt;
+        if (dRtt < dMin)
+            dMin = dRtt;
+        if (dRtt > dMax)
+            dMax = dRtt;
+    }
+
+    printf("round trip min %.1f us, avg %.1f us, max %.1f us\n", dMin * 1e6, dSum / u32Count * 1e6, dMax * 1e6);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int iFd, iRet;
+
+    if (argc < 3)
+    {
+        printf("usage: %s <tty> loop [seconds] [window] | stream [seconds] | latency [count] [size]\n", argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[2], "stream") == 0)
+    {
+        iFd = OpenPort(argv[1], B921600);
+        iRet = Stream(iFd, (argc > 3) ? atof(argv[3]) : 10.0);
+    }
+    else
+    {
+        iFd = OpenPort(argv[1], B115200);
+        Drain(iFd);     /* leftovers of a previous stream run */
+        if (strcmp(argv[2], "loop") == 0)
+            iRet = Loop(iFd, (argc > 3) ? atof(argv[3]) : 10.0, (argc > 4) ? (uint32_t)atoi(argv[4]) : BUF_SIZE);
+        else if (strcmp(argv[2], "latency") == 0)
+            iRet = Latency(iFd, (argc > 3) ? (uint32_t)atoi(argv[3]) : 1000, (argc > 4) ? (uint32_t)atoi(argv[4]) : 16);
+        else
+        {
+            printf("unknown mode %s\n", argv[2]);
+            iRet = 2;
+        }
+    }
+
+    close(iFd);
+    return iRet;
+}
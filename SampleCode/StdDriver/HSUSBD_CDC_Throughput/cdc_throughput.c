@@ -0,0 +1,358 @@
+/***************************************************************************//**
+ * @file     cdc_throughput.c
+ * @version  V1.00
+ * @brief    HSUSBD interrupt handler and endpoint setup for the CDC-ACM throughput sample.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+
+/*!<Includes */
+#include <string.h>
+#include "NuMicro.h"
+#include "cdc_throughput.h"
+
+/*--------------------------------------------------------------------------*/
+void USBD20_IRQHandler(void)
+{
+    __IO uint32_t IrqStL, IrqSt;
+
+    IrqStL = HSUSBD->GINTSTS & HSUSBD->GINTEN;    /* get interrupt status */
+
+    if(!IrqStL)    return;
+
+    /* USB interrupt */
+    if(IrqStL & HSUSBD_GINTSTS_USBIF_Msk)
+    {
+        IrqSt = HSUSBD->BUSINTSTS & HSUSBD->BUSINTEN;
+
+        if(IrqSt & HSUSBD_BUSINTSTS_SOFIF_Msk)
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_SOFIF_Msk);
+
+        if(IrqSt & HSUSBD_BUSINTSTS_RSTIF_Msk)
+        {
+            HSUSBD_SwReset();
+
+            HSUSBD_ResetDMA();
+            HSUSBD->EP[EPA].EPRSPCTL = HSUSBD_EPRSPCTL_FLUSH_Msk;
+            HSUSBD->EP[EPB].EPRSPCTL = HSUSBD_EPRSPCTL_FLUSH_Msk;
+
+            if(HSUSBD->OPER & 0x04)   /* high speed */
+                CDC_InitForHighSpeed();
+            else                    /* full speed */
+                CDC_InitForFullSpeed();
+            HSUSBD_CDC_Reset(&g_sCdc);  /* max packet size follows the bus speed */
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            HSUSBD_SET_ADDR(0);
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_SUSPENDIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_RSTIF_Msk);
+            HSUSBD_CLR_CEP_INT_FLAG(0x1ffc);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_RESUMEIF_Msk)
+        {
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_SUSPENDIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_RESUMEIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_SUSPENDIF_Msk)
+        {
+            HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_SUSPENDIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_HISPDIF_Msk)
+        {
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_HISPDIF_Msk);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_DMADONEIF_Msk)
+        {
+            g_hsusbd_DmaDone = 1;
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_DMADONEIF_Msk);
+            HSUSBD_CDC_DmaDone(&g_sCdc);
+        }
+
+        if(IrqSt & HSUSBD_BUSINTSTS_PHYCLKVLDIF_Msk)
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_PHYCLKVLDIF_Msk);
+
+        if(IrqSt & HSUSBD_BUSINTSTS_VBUSDETIF_Msk)
+        {
+            if(HSUSBD_IS_ATTACHED())
+            {
+                /* USB Plug In */
+                HSUSBD_ENABLE_USB();
+            }
+            else
+            {
+                /* USB Un-plug */
+                HSUSBD_DISABLE_USB();
+            }
+            HSUSBD_CLR_BUS_INT_FLAG(HSUSBD_BUSINTSTS_VBUSDETIF_Msk);
+        }
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_CEPIF_Msk)
+    {
+        IrqSt = HSUSBD->CEPINTSTS & HSUSBD->CEPINTEN;
+
+        if(IrqSt & HSUSBD_CEPINTSTS_SETUPTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_SETUPTKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_SETUPPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_SETUPPKIF_Msk);
+            HSUSBD_ProcessSetupPacket();
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_OUTTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_OUTTKIF_Msk);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_INTKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+            if(!(IrqSt & HSUSBD_CEPINTSTS_STSDONEIF_Msk))
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_TXPKIEN_Msk);
+                HSUSBD_CtrlIn();
+            }
+            else
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_TXPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            }
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_PINGIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_PINGIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_TXPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+            HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+            if(g_hsusbd_CtrlInSize)
+            {
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_INTKIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_INTKIEN_Msk);
+            }
+            else
+            {
+                if(g_hsusbd_CtrlZero == 1)
+                    HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_ZEROLEN);
+                HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+                HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            }
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_TXPKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_RXPKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_RXPKIF_Msk);
+            HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_NAKCLR);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_NAKIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_NAKIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_STALLIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STALLIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_ERRIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_ERRIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_STSDONEIF_Msk)
+        {
+            HSUSBD_UpdateDeviceState();
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_STSDONEIF_Msk);
+            HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_BUFFULLIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_BUFFULLIF_Msk);
+            return;
+        }
+
+        if(IrqSt & HSUSBD_CEPINTSTS_BUFEMPTYIF_Msk)
+        {
+            HSUSBD_CLR_CEP_INT_FLAG(HSUSBD_CEPINTSTS_BUFEMPTYIF_Msk);
+            return;
+        }
+    }
+
+    /* bulk in */
+    if(IrqStL & HSUSBD_GINTSTS_EPAIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPA].EPINTSTS & HSUSBD->EP[EPA].EPINTEN;
+        HSUSBD_CDC_EpInHandler(&g_sCdc, IrqSt);
+    }
+    /* bulk out */
+    if(IrqStL & HSUSBD_GINTSTS_EPBIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPB].EPINTSTS & HSUSBD->EP[EPB].EPINTEN;
+        HSUSBD_CDC_EpOutHandler(&g_sCdc, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPCIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPC].EPINTSTS & HSUSBD->EP[EPC].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPC, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPDIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPD].EPINTSTS & HSUSBD->EP[EPD].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPD, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPEIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPE].EPINTSTS & HSUSBD->EP[EPE].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPE, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPFIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPF].EPINTSTS & HSUSBD->EP[EPF].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPF, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPGIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPG].EPINTSTS & HSUSBD->EP[EPG].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPG, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPHIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPH].EPINTSTS & HSUSBD->EP[EPH].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPH, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPIIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPI].EPINTSTS & HSUSBD->EP[EPI].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPI, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPJIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPJ].EPINTSTS & HSUSBD->EP[EPJ].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPJ, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPKIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPK].EPINTSTS & HSUSBD->EP[EPK].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPK, IrqSt);
+    }
+
+    if(IrqStL & HSUSBD_GINTSTS_EPLIF_Msk)
+    {
+        IrqSt = HSUSBD->EP[EPL].EPINTSTS & HSUSBD->EP[EPL].EPINTEN;
+        HSUSBD_CLR_EP_INT_FLAG(EPL, IrqSt);
+    }
+}
+
+
+void CDC_InitForHighSpeed(void)
+{
+    /*****************************************************/
+    /* EPA ==> Bulk IN endpoint, address 1 */
+    HSUSBD_SetEpBufAddr(EPA, EPA_BUF_BASE, EPA_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPA, EPA_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPA, BULK_IN_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_IN);
+
+    /* EPB ==> Bulk OUT endpoint, address 2 */
+    HSUSBD_SetEpBufAddr(EPB, EPB_BUF_BASE, EPB_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPB, EPB_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPB, BULK_OUT_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_OUT);
+
+    /* EPC ==> Interrupt IN endpoint, address 3 */
+    HSUSBD_SetEpBufAddr(EPC, EPC_BUF_BASE, EPC_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPC, EPC_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPC, INT_IN_EP_NUM, HSUSBD_EP_CFG_TYPE_INT, HSUSBD_EP_CFG_DIR_IN);
+}
+
+void CDC_InitForFullSpeed(void)
+{
+    /*****************************************************/
+    /* EPA ==> Bulk IN endpoint, address 1 */
+    HSUSBD_SetEpBufAddr(EPA, EPA_BUF_BASE, EPA_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPA, EPA_OTHER_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPA, BULK_IN_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_IN);
+
+    /* EPB ==> Bulk OUT endpoint, address 2 */
+    HSUSBD_SetEpBufAddr(EPB, EPB_BUF_BASE, EPB_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPB, EPB_OTHER_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPB, BULK_OUT_EP_NUM, HSUSBD_EP_CFG_TYPE_BULK, HSUSBD_EP_CFG_DIR_OUT);
+
+    /* EPC ==> Interrupt IN endpoint, address 3 */
+    HSUSBD_SetEpBufAddr(EPC, EPC_BUF_BASE, EPC_BUF_LEN);
+    HSUSBD_SET_MAX_PAYLOAD(EPC, EPC_OTHER_MAX_PKT_SIZE);
+    HSUSBD_ConfigEp(EPC, INT_IN_EP_NUM, HSUSBD_EP_CFG_TYPE_INT, HSUSBD_EP_CFG_DIR_IN);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+  * @brief  USBD Endpoint Config.
+  * @param  None.
+  * @retval None.
+  */
+void CDC_Init(void)
+{
+    /* Configure USB controller */
+    /* Enable USB BUS, CEP and EPA , EPB global interrupt */
+    HSUSBD_ENABLE_USB_INT(HSUSBD_GINTEN_USBIEN_Msk | HSUSBD_GINTEN_CEPIEN_Msk | HSUSBD_GINTEN_EPAIEN_Msk | HSUSBD_GINTEN_EPBIEN_Msk | HSUSBD_GINTEN_EPCIEN_Msk);
+    /* Enable BUS interrupt */
+    HSUSBD_ENABLE_BUS_INT(HSUSBD_BUSINTEN_DMADONEIEN_Msk | HSUSBD_BUSINTEN_RESUMEIEN_Msk | HSUSBD_BUSINTEN_RSTIEN_Msk | HSUSBD_BUSINTEN_VBUSDETIEN_Msk);
+    /* Reset Address to 0 */
+    HSUSBD_SET_ADDR(0);
+
+    /*****************************************************/
+    /* Control endpoint */
+    HSUSBD_SetEpBufAddr(CEP, CEP_BUF_BASE, CEP_BUF_LEN);
+    HSUSBD_ENABLE_CEP_INT(HSUSBD_CEPINTEN_SETUPPKIEN_Msk | HSUSBD_CEPINTEN_STSDONEIEN_Msk);
+
+    CDC_InitForHighSpeed();
+
+    /* Bulk IN on EPA, bulk OUT on EPB */
+    HSUSBD_CDC_Open(&g_sCdc, EPA, EPB, CDC_IF_NUM);
+}
+
+
+void CDC_ClassRequest(void)
+{
+    if(HSUSBD_CDC_ClassRequest(&g_sCdc) != 0)
+    {
+        /* Not for the CDC interface, stall the device */
+        HSUSBD_SET_CEP_STATE(HSUSBD_CEPCTL_STALLEN_Msk);
+    }
+}
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file     cdc_throughput.h
+ * @version  V1.00
+ * @brief    HSUSBD CDC-ACM throughput sample header file.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __CDC_THROUGHPUT_H__
+#define __CDC_THROUGHPUT_H__
+
+#include "cdc_acm.h"
+
+/* Define the vendor id and product id */
+#define USBD_VID        0x0416
+#define USBD_PID        0xB002
+
+/*-------------------------------------------------------------*/
+/* Define EP maximum packet size */
+#define CEP_MAX_PKT_SIZE        64
+#define CEP_OTHER_MAX_PKT_SIZE  64
+#define EPA_MAX_PKT_SIZE        512
+#define EPA_OTHER_MAX_PKT_SIZE  64
+#define EPB_MAX_PKT_SIZE        512
+#define EPB_OTHER_MAX_PKT_SIZE  64
+#define EPC_MAX_PKT_SIZE        64
+#define EPC_OTHER_MAX_PKT_SIZE  64
+
+#define CEP_BUF_BASE    0
+#define CEP_BUF_LEN     CEP_MAX_PKT_SIZE
+#define EPA_BUF_BASE    0x200
+#define EPA_BUF_LEN     EPA_MAX_PKT_SIZE
+#define EPB_BUF_BASE    0x400
+#define EPB_BUF_LEN     EPB_MAX_PKT_SIZE
+#define EPC_BUF_BASE    0x600
+#define EPC_BUF_LEN     EPC_MAX_PKT_SIZE
+
+/* Define the interrupt In EP number */
+#define BULK_IN_EP_NUM      0x01
+#define BULK_OUT_EP_NUM     0x02
+#define INT_IN_EP_NUM       0x03
+
+/* Define Descriptor information */
+#define USBD_SELF_POWERED               0
+#define USBD_REMOTE_WAKEUP              0
+#define USBD_MAX_POWER                  50  /* The unit is in 2mA. ex: 50 * 2mA = 100mA */
+
+/* Communication interface of the port, wIndex of its class requests */
+#define CDC_IF_NUM          0
+
+/* Ring sizes, power of two */
+#define CDC_TX_RING_SIZE    16384
+#define CDC_RX_RING_SIZE    16384
+
+/* Setting this baud rate from the host switches the device to stream mode */
+#define CDC_STREAM_BAUD     921600
+
+/*-------------------------------------------------------------*/
+extern CDC_ACM_T g_sCdc;
+
+/*-------------------------------------------------------------*/
+void CDC_Init(void);
+void CDC_InitForHighSpeed(void);
+void CDC_InitForFullSpeed(void);
+void CDC_ClassRequest(void);
+
+#endif  /* __CDC_THROUGHPUT_H__ */
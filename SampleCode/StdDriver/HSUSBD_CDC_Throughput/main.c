@@ -0,0 +1,228 @@
+/***************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Measure HSUSBD CDC-ACM throughput with the reusable CDC-ACM class.
+ *
+ * @details  Two modes, picked by the host through the line coding:
+ *             - Loopback (default): every byte received is sent back. The IN
+ *               side is flushed as soon as the RX ring runs empty, so single
+ *               short messages echo at once and bulk traffic still leaves in
+ *               full packets.
+ *             - Stream (baud rate CDC_STREAM_BAUD): while DTR is set, an
+ *               incrementing byte pattern is sent as fast as the host reads it.
+ *           Once per second the TX/RX rate and the class statistics are printed
+ *           on UART0. The host side is host/cdc_bench.c.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+#include "cdc_throughput.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Global variables                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+CDC_ACM_T g_sCdc;
+
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8TxRing[CDC_TX_RING_SIZE];
+#pragma data_alignment=4
+static uint8_t s_au8RxRing[CDC_RX_RING_SIZE];
+#pragma data_alignment=4
+static uint8_t s_au8Bounce[2 * EPA_MAX_PKT_SIZE];
+#else
+static uint8_t s_au8TxRing[CDC_TX_RING_SIZE] __attribute__((aligned(4)));
+static uint8_t s_au8RxRing[CDC_RX_RING_SIZE] __attribute__((aligned(4)));
+static uint8_t s_au8Bounce[2 * EPA_MAX_PKT_SIZE] __attribute__((aligned(4)));
+#endif
+
+static uint8_t s_au8Work[EPA_MAX_PKT_SIZE * 2];
+
+static volatile uint32_t s_u32Ticks = 0;
+static volatile uint8_t s_u8StreamMode = 0;
+
+/*--------------------------------------------------------------------------*/
+void SysTick_Handler(void)
+{
+    s_u32Ticks++;
+}
+
+/* SET_LINE_CODE, called from the USB interrupt */
+static void CDC_LineCodingChanged(CDC_ACM_T *psCdc)
+{
+    s_u8StreamMode = (psCdc->sLineCoding.u32DTERate == CDC_STREAM_BAUD) ? 1 : 0;
+}
+
+void SYS_Init(void)
+{
+    uint32_t volatile i;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 192MHz */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Select HSUSBD */
+    SYS->USBPHY &= ~SYS_USBPHY_HSUSBROLE_Msk;
+
+    /* Enable USB PHY */
+    SYS->USBPHY = (SYS->USBPHY & ~(SYS_USBPHY_HSUSBROLE_Msk | SYS_USBPHY_HSUSBACT_Msk)) | SYS_USBPHY_HSUSBEN_Msk;
+    for(i = 0; i < 0x1000; i++);   // delay > 10 us
+    SYS->USBPHY |= SYS_USBPHY_HSUSBACT_Msk;
+
+    /* Enable HSUSBD module clock */
+    CLK_EnableModuleClock(HSUSBD_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+static void CDC_Loopback(void)
+{
+    uint32_t u32Len;
+
+    /* Never take more than the TX ring can hold, the host is throttled by the RX hold instead */
+    u32Len = CDC_ACM_TxSpace(&g_sCdc);
+    if(u32Len > sizeof(s_au8Work))
+        u32Len = sizeof(s_au8Work);
+
+    u32Len = CDC_ACM_Read(&g_sCdc, s_au8Work, u32Len);
+    if(u32Len)
+        CDC_ACM_Write(&g_sCdc, s_au8Work, u32Len);
+
+    /* Host is waiting for the echo, do not hold the tail back */
+    if(u32Len && (CDC_ACM_RxCount(&g_sCdc) == 0))
+        CDC_ACM_Flush(&g_sCdc);
+}
+
+static void CDC_Stream(void)
+{
+    static uint8_t s_u8Seq = 0;
+    uint32_t i, u32Len;
+
+    /* Drop whatever the host sends in this mode */
+    CDC_ACM_Read(&g_sCdc, s_au8Work, sizeof(s_au8Work));
+
+    if((g_sCdc.u16CtrlSignal & 0x1) == 0)   /* DTR */
+        return;
+
+    u32Len = CDC_ACM_TxSpace(&g_sCdc);
+    if(u32Len > sizeof(s_au8Work))
+        u32Len = sizeof(s_au8Work);
+    for(i = 0; i < u32Len; i++)
+        s_au8Work[i] = s_u8Seq++;
+    CDC_ACM_Write(&g_sCdc, s_au8Work, u32Len);
+}
+
+static void CDC_Report(void)
+{
+    static CDC_ACM_STATS_T s_sLast;
+    CDC_ACM_STATS_T sNow = g_sCdc.sStats;
+
+    printf("[%s] TX %6u KB/s (%u xfers, %u ZLP, %u bounce)  RX %6u KB/s (%u hold, %u bounce)  overflow %u\n",
+           s_u8StreamMode ? "stream" : "loop",
+           (sNow.u32TxBytes - s_sLast.u32TxBytes) / 1024, sNow.u32TxXfers - s_sLast.u32TxXfers,
+           sNow.u32TxZlps - s_sLast.u32TxZlps, sNow.u32TxBounce - s_sLast.u32TxBounce,
+           (sNow.u32RxBytes - s_sLast.u32RxBytes) / 1024, sNow.u32RxHold - s_sLast.u32RxHold,
+           sNow.u32RxBounce - s_sLast.u32RxBounce, sNow.u32TxOverflow - s_sLast.u32TxOverflow);
+    s_sLast = sNow;
+}
+
+int32_t main(void)
+{
+    uint32_t u32LastTick = 0, u32LastReport = 0, u32Now;
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART to 115200-8n1 for print message */
+    UART_Open(UART0, 115200);
+
+    printf("\n");
+    printf("+--------------------------------------------------------+\n");
+    printf("|          NuMicro HSUSBD CDC-ACM Throughput             |\n");
+    printf("+--------------------------------------------------------+\n");
+    printf("  Loopback by default, stream mode when the host sets %u baud and DTR.\n", CDC_STREAM_BAUD);
+
+    CDC_ACM_Init(&g_sCdc, s_au8TxRing, CDC_TX_RING_SIZE, s_au8RxRing, CDC_RX_RING_SIZE, s_au8Bounce);
+    g_sCdc.u16FlushTicks = 2;       /* a partial packet waits at most 2 ms */
+    g_sCdc.pfnLineCoding = CDC_LineCodingChanged;
+
+    /* 1 ms tick for the IN hold timer and the report */
+    SysTick_Config(SystemCoreClock / 1000);
+
+    HSUSBD_Open(&gsHSInfo, CDC_ClassRequest, NULL);
+
+    /* Endpoint configuration */
+    CDC_Init();
+
+    /* Enable HSUSBD interrupt */
+    NVIC_EnableIRQ(USBD20_IRQn);
+
+    /* Start transaction */
+    while(1)
+    {
+        if(HSUSBD_IS_ATTACHED())
+        {
+            HSUSBD_Start();
+            break;
+        }
+    }
+
+    while(1)
+    {
+        if(s_u8StreamMode)
+            CDC_Stream();
+        else
+            CDC_Loopback();
+
+        /* The hold timer runs in thread context, the same side as CDC_ACM_Write() */
+        u32Now = s_u32Ticks;
+        if(u32Now != u32LastTick)
+        {
+            u32LastTick = u32Now;
+            CDC_ACM_Tick(&g_sCdc);
+        }
+
+        if((u32Now - u32LastReport) >= 1000)
+        {
+            u32LastReport = u32Now;
+            CDC_Report();
+        }
+    }
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * @file     hsusbd_msc.h
+ * @version  V1.00
+ * @brief    HSUSBD mass storage class with ping-pong DMA buffers header file.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __HSUSBD_MSC_H__
+#define __HSUSBD_MSC_H__
+
+/* Define the vendor id and product id */
+#define USBD_VID        0x0416
+#define USBD_PID        0x0480
+
+/* Define DMA Maximum Transfer length */
+#define USBD_MAX_DMA_LEN    0x1000
+
+/* Define sector size */
+#define USBD_SECTOR_SIZE    512
+
+/*
+ * Two ping-pong buffers of MSC_PP_BUF_LEN bytes each. While the HSUSBD DMA moves one buffer
+ * over the bus, the media backend reads into or writes from the other one.
+ * MSC_PP_BUF_LEN MUST be a multiple of USBD_MAX_DMA_LEN.
+ */
+#define MSC_PP_BUF_LEN      16384   /* unit is byte */
+#define MSC_PP_BUF_SECTOR   (MSC_PP_BUF_LEN / USBD_SECTOR_SIZE)
+#define MSC_SG_PER_BUF      (MSC_PP_BUF_LEN / USBD_MAX_DMA_LEN)
+
+/* HSUSBD scatter-gather descriptor COUNT field */
+#define MSC_SG_EOT          0x80000000UL    /* last descriptor of the chain */
+#define MSC_SG_DIR_IN       0x40000000UL    /* memory to USB (bulk in) */
+#define MSC_SG_DIR_OUT      0x00000000UL    /* USB to memory (bulk out) */
+
+/* Define EP maximum packet size */
+#define CEP_MAX_PKT_SIZE        64
+#define CEP_OTHER_MAX_PKT_SIZE  64
+#define EPA_MAX_PKT_SIZE        512
+#define EPA_OTHER_MAX_PKT_SIZE  64
+#define EPB_MAX_PKT_SIZE        512
+#define EPB_OTHER_MAX_PKT_SIZE  64
+
+#define CEP_BUF_BASE    0
+#define CEP_BUF_LEN     CEP_MAX_PKT_SIZE
+#define EPA_BUF_BASE    0x200
+#define EPA_BUF_LEN     EPA_MAX_PKT_SIZE
+#define EPB_BUF_BASE    0x400
+#define EPB_BUF_LEN     EPB_MAX_PKT_SIZE
+
+/* Define the interrupt In EP number */
+#define BULK_IN_EP_NUM      0x01
+#define BULK_OUT_EP_NUM     0x02
+
+/* Define Descriptor information */
+#define USBD_SELF_POWERED               1
+#define USBD_REMOTE_WAKEUP              0
+#define USBD_MAX_POWER                  50  /* The unit is in 2mA. ex: 50 * 2mA = 100mA */
+
+/*!<Define Mass Storage Class Specific Request */
+#define BULK_ONLY_MASS_STORAGE_RESET    0xFF
+#define GET_MAX_LUN                     0xFE
+
+/*!<Define Mass Storage Signature */
+#define CBW_SIGNATURE       0x43425355
+#define CSW_SIGNATURE       0x53425355
+
+/*!<Define Mass Storage UFI Command */
+#define UFI_TEST_UNIT_READY                     0x00
+#define UFI_REQUEST_SENSE                       0x03
+#define UFI_INQUIRY                             0x12
+#define UFI_MODE_SELECT_6                       0x15
+#define UFI_MODE_SENSE_6                        0x1A
+#define UFI_START_STOP                          0x1B
+#define UFI_PREVENT_ALLOW_MEDIUM_REMOVAL        0x1E
+#define UFI_READ_FORMAT_CAPACITY                0x23
+#define UFI_READ_CAPACITY                       0x25
+#define UFI_READ_10                             0x28
+#define UFI_READ_12                             0xA8
+#define UFI_READ_16                             0x9E
+#define UFI_WRITE_10                            0x2A
+#define UFI_WRITE_12                            0xAA
+#define UFI_VERIFY_10                           0x2F
+#define UFI_MODE_SELECT_10                      0x55
+#define UFI_MODE_SENSE_10                       0x5A
+
+/*-----------------------------------------*/
+#define BULK_CBW    0x00
+#define BULK_IN     0x01
+#define BULK_OUT    0x02
+#define BULK_CSW    0x04
+#define BULK_NORMAL 0xFF
+
+static __INLINE uint32_t get_be32(uint8_t *buf)
+{
+    return ((uint32_t) buf[0] << 24) | ((uint32_t) buf[1] << 16) |
+           ((uint32_t) buf[2] << 8) | ((uint32_t) buf[3]);
+}
+
+
+/******************************************************************************/
+/*                USBD Mass Storage Structure                                 */
+/******************************************************************************/
+
+/*!<USB Mass Storage Class - Command Block Wrapper Structure */
+struct CBW
+{
+    uint32_t  dCBWSignature;
+    uint32_t  dCBWTag;
+    uint32_t  dCBWDataTransferLength;
+    uint8_t   bmCBWFlags;
+    uint8_t   bCBWLUN;
+    uint8_t   bCBWCBLength;
+    uint8_t   u8OPCode;
+    uint8_t   u8LUN;
+    uint8_t   au8Data[14];
+};
+
+/*!<USB Mass Storage Class - Command Status Wrapper Structure */
+struct CSW
+{
+    uint32_t  dCSWSignature;
+    uint32_t  dCSWTag;
+    uint32_t  dCSWDataResidue;
+    uint8_t   bCSWStatus;
+};
+
+/*!<HSUSBD scatter-gather DMA descriptor */
+typedef struct
+{
+    uint32_t  u32Addr;      /* buffer address */
+    uint32_t  u32Count;     /* byte count | MSC_SG_DIR_IN | MSC_SG_EOT */
+} MSC_SG_DESC_T;
+
+/*!<Block media backend. Read/Write block the caller until the media access is finished
+    and return 0 on success. Sector size is USBD_SECTOR_SIZE. */
+typedef struct
+{
+    const char *pcName;
+    int32_t  (*pfnInit)(void);
+    int32_t  (*pfnIsReady)(void);
+    uint32_t (*pfnGetSectorCount)(void);
+    int32_t  (*pfnRead)(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf);
+    int32_t  (*pfnWrite)(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf);
+} MSC_MEDIA_T;
+
+/*!<Data stage statistics. Cycle counts come from DWT->CYCCNT. */
+typedef struct
+{
+    uint32_t  u32ReadBytes;         /* bytes sent by READ(10/12) */
+    uint32_t  u32ReadCycles;        /* cycles spent in READ data stages */
+    uint32_t  u32WriteBytes;        /* bytes received by WRITE(10/12) */
+    uint32_t  u32WriteCycles;       /* cycles spent in WRITE data stages */
+    uint32_t  u32MediaCycles;       /* cycles spent inside media read/write */
+    uint32_t  u32UsbWaitCycles;     /* cycles spent waiting on HSUSBD DMA with the media idle */
+} MSC_STATS_T;
+
+/* Media backends provided by msc_media.c */
+extern const MSC_MEDIA_T g_sMscMediaSD;
+extern const MSC_MEDIA_T g_sMscMediaSRAM;
+extern const MSC_MEDIA_T g_sMscMediaSPIM;
+
+/*-------------------------------------------------------------*/
+void MSC_Init(const MSC_MEDIA_T *psMedia);
+void MSC_InitForHighSpeed(void);
+void MSC_InitForFullSpeed(void);
+void MSC_ClassRequest(void);
+void MSC_RequestSense(void);
+void MSC_ReadFormatCapacity(void);
+void MSC_ReadCapacity(void);
+void MSC_ModeSense10(void);
+void MSC_ReceiveCBW(uint32_t u32Buf, uint32_t u32Len);
+void MSC_ProcessCmd(void);
+void MSC_ActiveDMA(uint32_t u32Addr, uint32_t u32Len);
+void MSC_BulkOut(uint32_t u32Addr, uint32_t u32Len);
+void MSC_BulkIn(uint32_t u32Addr, uint32_t u32Len);
+void MSC_AckCmd(void);
+void MSC_GetStats(MSC_STATS_T *psStats, int32_t i32Clear);
+
+#endif  /* __HSUSBD_MSC_H__ */
@@ -0,0 +1,267 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Simulate an USB pen drive whose media access overlaps HSUSBD DMA
+ *           through ping-pong buffers, and report the throughput in MB/s.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "hsusbd_msc.h"
+
+/* Back end storage media: g_sMscMediaSD, g_sMscMediaSRAM or g_sMscMediaSPIM */
+#define MSC_MEDIA       g_sMscMediaSD
+
+extern uint8_t volatile g_u8SdInitFlag;
+/*--------------------------------------------------------------------------*/
+
+void SDH0_IRQHandler(void)
+{
+    unsigned int volatile isr;
+    unsigned int volatile ier;
+
+    // FMI data abort interrupt
+    if(SDH0->GINTSTS & SDH_GINTSTS_DTAIF_Msk)
+    {
+        /* ResetAllEngine() */
+        SDH0->GCTL |= SDH_GCTL_GCTLRST_Msk;
+    }
+
+    //----- SD interrupt status
+    isr = SDH0->INTSTS;
+    if(isr & SDH_INTSTS_BLKDIF_Msk)
+    {
+        // block down
+        SD0.DataReadyFlag = TRUE;
+        SDH0->INTSTS = SDH_INTSTS_BLKDIF_Msk;
+    }
+
+    if(isr & SDH_INTSTS_CDIF_Msk)
+    {
+        // card detect
+        //----- SD interrupt status
+        // it is work to delay 50 times for SD_CLK = 200KHz
+        {
+            int volatile i;         // delay 30 fail, 50 OK
+            for(i = 0; i < 0x500; i++); // delay to make sure got updated value from REG_SDISR.
+            isr = SDH0->INTSTS;
+        }
+
+        if(isr & SDH_INTSTS_CDSTS_Msk)
+        {
+            printf("\n***** card remove !\n");
+            SD0.IsCardInsert = FALSE;   // SDISR_CD_Card = 1 means card remove for GPIO mode
+            memset(&SD0, 0, sizeof(SDH_INFO_T));
+        }
+        else
+        {
+            printf("***** card insert !\n");
+            SDH_Open(SDH0, CardDetect_From_GPIO);
+            if(SDH_Probe(SDH0))
+            {
+                g_u8SdInitFlag = 0;
+                printf("SD initial fail!!\n");
+            }
+            else
+                g_u8SdInitFlag = 1;
+        }
+        SDH0->INTSTS = SDH_INTSTS_CDIF_Msk;
+    }
+
+    // CRC error interrupt
+    if(isr & SDH_INTSTS_CRCIF_Msk)
+    {
+        if(!(isr & SDH_INTSTS_CRC16_Msk))
+        {
+            //printf("***** ISR sdioIntHandler(): CRC_16 error !\n");
+            // handle CRC error
+        }
+        else if(!(isr & SDH_INTSTS_CRC7_Msk))
+        {
+            if(!SD0.R3Flag)
+            {
+                //printf("***** ISR sdioIntHandler(): CRC_7 error !\n");
+                // handle CRC error
+            }
+        }
+        SDH0->INTSTS = SDH_INTSTS_CRCIF_Msk;      // clear interrupt flag
+    }
+
+    if(isr & SDH_INTSTS_DITOIF_Msk)
+    {
+        printf("***** ISR: data in timeout !\n");
+        SDH0->INTSTS |= SDH_INTSTS_DITOIF_Msk;
+    }
+
+    // Response in timeout interrupt
+    if(isr & SDH_INTSTS_RTOIF_Msk)
+    {
+        printf("***** ISR: response in timeout !\n");
+        SDH0->INTSTS |= SDH_INTSTS_RTOIF_Msk;
+    }
+}
+
+
+void SYS_Init(void)
+{
+    uint32_t volatile i;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 192MHz */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Select HSUSBD */
+    SYS->USBPHY &= ~SYS_USBPHY_HSUSBROLE_Msk;
+
+    /* Enable USB PHY */
+    SYS->USBPHY = (SYS->USBPHY & ~(SYS_USBPHY_HSUSBROLE_Msk | SYS_USBPHY_HSUSBACT_Msk)) | SYS_USBPHY_HSUSBEN_Msk;
+    for(i = 0; i < 0x1000; i++);   // delay > 10 us
+    SYS->USBPHY |= SYS_USBPHY_HSUSBACT_Msk;
+
+    /* Enable HSUSBD module clock */
+    CLK_EnableModuleClock(HSUSBD_MODULE);
+
+    /* Enable SDH0 module clock */
+    CLK_EnableModuleClock(SDH0_MODULE);
+
+    /* Select SDH0 module clock source as HCLK and SDH0 module clock divider as 10 */
+    CLK_SetModuleClock(SDH0_MODULE, CLK_CLKSEL0_SDH0SEL_HCLK, CLK_CLKDIV0_SDH0(10));
+
+    /* Enable SPIM module clock */
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Select multi-function pins for SD0 */
+    SET_SD0_DAT0_PE2();
+    SET_SD0_DAT1_PE3();
+    SET_SD0_DAT2_PE4();
+    SET_SD0_DAT3_PE5();
+    SET_SD0_CLK_PE6();
+    SET_SD0_CMD_PE7();
+    SET_SD0_nCD_PD13();
+
+    /* SD0 owns PE.2 ~ PE.7, so SPIM uses MOSI(PJ.1), MISO(PI.13), CLK(PJ.0), SS(PI.12), D3(PI.15), and D2(PI.14) */
+    SET_SPIM_MOSI_PJ1();
+    SET_SPIM_MISO_PI13();
+    SET_SPIM_CLK_PJ0();
+    SET_SPIM_SS_PI12();
+    SET_SPIM_D3_PI15();
+    SET_SPIM_D2_PI14();
+
+    PJ->SMTEN |= GPIO_SMTEN_SMTEN0_Msk;
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+static void PrintRate(const char *pcDir, uint32_t u32Bytes, uint32_t u32Cycles)
+{
+    uint32_t u32Rate;   /* unit is KB/s */
+
+    if((u32Bytes == 0) || (u32Cycles == 0))
+        return;
+
+    u32Rate = (uint32_t)(((uint64_t)u32Bytes * SystemCoreClock) / u32Cycles / 1024);
+    printf("%s %5d KB in %4d ms, %2d.%02d MB/s\n", pcDir, u32Bytes / 1024,
+           (uint32_t)(((uint64_t)u32Cycles * 1000) / SystemCoreClock), u32Rate / 1024, ((u32Rate % 1024) * 100) / 1024);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    MSC_STATS_T sStats;
+    uint32_t u32Busy;
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART to 115200-8n1 for print message */
+    UART_Open(UART0, 115200);
+
+    printf("NuMicro HSUSBD Mass Storage (ping-pong DMA)\n");
+
+    /* Init back end storage media */
+    if(MSC_MEDIA.pfnInit())
+        printf("%s initial fail!!\n", MSC_MEDIA.pcName);
+
+    HSUSBD_Open(&gsHSInfo, MSC_ClassRequest, NULL);
+
+    /* Endpoint configuration */
+    MSC_Init(&MSC_MEDIA);
+
+    /* Enable HSUSBD interrupt */
+    NVIC_EnableIRQ(USBD20_IRQn);
+
+    /* Start transaction */
+    while(1)
+    {
+        if(HSUSBD_IS_ATTACHED())
+        {
+            HSUSBD_Start();
+            break;
+        }
+    }
+
+    /* SysTick wraps once per second and paces the throughput report */
+    SysTick->LOAD = SystemCoreClock - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    while(1)
+    {
+        if(g_hsusbd_Configured)
+            MSC_ProcessCmd();
+
+        if(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)
+        {
+            MSC_GetStats(&sStats, 1);
+            PrintRate("Read ", sStats.u32ReadBytes, sStats.u32ReadCycles);
+            PrintRate("Write", sStats.u32WriteBytes, sStats.u32WriteCycles);
+
+            /* Share of the data stages in which the media was busy while the bus was idle or vice versa */
+            u32Busy = sStats.u32ReadCycles + sStats.u32WriteCycles;
+            if(u32Busy)
+                printf("      media %d%%, USB wait %d%%\n",
+                       (uint32_t)(((uint64_t)sStats.u32MediaCycles * 100) / u32Busy),
+                       (uint32_t)(((uint64_t)sStats.u32UsbWaitCycles * 100) / u32Busy));
+        }
+    }
+}
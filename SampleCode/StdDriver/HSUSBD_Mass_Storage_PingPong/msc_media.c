@@ -0,0 +1,184 @@
+/******************************************************************************
+ * @file     msc_media.c
+ * @version  V1.00
+ * @brief    Block media backends (SD, SRAM, SPIM flash) for the HSUSBD mass storage class.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+#include "hsusbd_msc.h"
+
+/*--------------------------------------------------------------------------*/
+/* SD card on SDH0                                                          */
+/*--------------------------------------------------------------------------*/
+uint8_t volatile g_u8SdInitFlag = 0;
+
+static int32_t SD_Init(void)
+{
+    SDH_Open(SDH0, CardDetect_From_GPIO);
+    if(SDH_Probe(SDH0))
+    {
+        g_u8SdInitFlag = 0;
+        return -1;
+    }
+    g_u8SdInitFlag = 1;
+    return 0;
+}
+
+static int32_t SD_IsReady(void)
+{
+    return (g_u8SdInitFlag && SD0.IsCardInsert) ? 1 : 0;
+}
+
+static uint32_t SD_GetSectorCount(void)
+{
+    return SD0.totalSectorN;
+}
+
+static int32_t SD_Read(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    return SDH_Read(SDH0, pu8Buf, u32Lba, u32Cnt) ? -1 : 0;
+}
+
+static int32_t SD_Write(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    return SDH_Write(SDH0, pu8Buf, u32Lba, u32Cnt) ? -1 : 0;
+}
+
+const MSC_MEDIA_T g_sMscMediaSD =
+{
+    "SD", SD_Init, SD_IsReady, SD_GetSectorCount, SD_Read, SD_Write
+};
+
+/*--------------------------------------------------------------------------*/
+/* RAM disk                                                                 */
+/*--------------------------------------------------------------------------*/
+#define MSC_SRAM_SIZE       (64 * 1024)     /* unit is byte */
+
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8RamDisk[MSC_SRAM_SIZE];
+#else
+static uint8_t s_au8RamDisk[MSC_SRAM_SIZE] __attribute__((aligned(4)));
+#endif
+
+static int32_t SRAM_Init(void)
+{
+    return 0;
+}
+
+static int32_t SRAM_IsReady(void)
+{
+    return 1;
+}
+
+static uint32_t SRAM_GetSectorCount(void)
+{
+    return MSC_SRAM_SIZE / USBD_SECTOR_SIZE;
+}
+
+static int32_t SRAM_Read(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    memcpy(pu8Buf, &s_au8RamDisk[u32Lba * USBD_SECTOR_SIZE], u32Cnt * USBD_SECTOR_SIZE);
+    return 0;
+}
+
+static int32_t SRAM_Write(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    memcpy(&s_au8RamDisk[u32Lba * USBD_SECTOR_SIZE], pu8Buf, u32Cnt * USBD_SECTOR_SIZE);
+    return 0;
+}
+
+const MSC_MEDIA_T g_sMscMediaSRAM =
+{
+    "SRAM", SRAM_Init, SRAM_IsReady, SRAM_GetSectorCount, SRAM_Read, SRAM_Write
+};
+
+/*--------------------------------------------------------------------------*/
+/* SPI NOR flash on SPIM                                                    */
+/*--------------------------------------------------------------------------*/
+#define MSC_SPIM_BASE       0x100000        /* disk offset inside the flash */
+#define MSC_SPIM_SIZE       (1024 * 1024)   /* unit is byte */
+#define MSC_SPIM_ERASE_SIZE 0x1000          /* 4 KB sector erase */
+
+static uint8_t s_u8SpimReady = 0;
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8EraseBuf[MSC_SPIM_ERASE_SIZE];
+#else
+static uint8_t s_au8EraseBuf[MSC_SPIM_ERASE_SIZE] __attribute__((aligned(4)));
+#endif
+
+static int32_t SPIM_MediaInit(void)
+{
+    SPIM_SET_CLOCK_DIVIDER(1);        /* Set SPIM clock as HCLK divided by 2 */
+    SPIM_SET_RXCLKDLY_RDDLYSEL(0);    /* Insert 0 delay cycle. Adjust the sampling clock of received data to latch the correct data. */
+    SPIM_SET_RXCLKDLY_RDEDGE();       /* Use SPI input clock rising edge to sample received data. */
+    SPIM_SET_DCNUM(8);                /* Set 8 dummy cycle. */
+
+    if(SPIM_InitFlash(1) != 0)        /* Initialized SPI flash */
+        return -1;
+
+    s_u8SpimReady = 1;
+    return 0;
+}
+
+static int32_t SPIM_MediaIsReady(void)
+{
+    return s_u8SpimReady;
+}
+
+static uint32_t SPIM_MediaGetSectorCount(void)
+{
+    return MSC_SPIM_SIZE / USBD_SECTOR_SIZE;
+}
+
+static int32_t SPIM_MediaRead(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    return SPIM_DMA_Read(MSC_SPIM_BASE + u32Lba * USBD_SECTOR_SIZE, 0, u32Cnt * USBD_SECTOR_SIZE,
+                         pu8Buf, CMD_DMA_FAST_READ, 1);
+}
+
+static int32_t SPIM_MediaWrite(uint32_t u32Lba, uint32_t u32Cnt, uint8_t *pu8Buf)
+{
+    uint32_t u32Addr = MSC_SPIM_BASE + u32Lba * USBD_SECTOR_SIZE;
+    uint32_t u32Len = u32Cnt * USBD_SECTOR_SIZE;
+    uint32_t u32Block, u32Offset, u32Size;
+
+    while(u32Len)
+    {
+        u32Block = u32Addr & ~(MSC_SPIM_ERASE_SIZE - 1);
+        u32Offset = u32Addr - u32Block;
+        u32Size = MSC_SPIM_ERASE_SIZE - u32Offset;
+        if(u32Size > u32Len)
+            u32Size = u32Len;
+
+        if(u32Size == MSC_SPIM_ERASE_SIZE)
+        {
+            /* Whole erase block is overwritten, program straight from the caller buffer */
+            SPIM_EraseBlock(u32Block, 0, OPCODE_SE_4K, 1, 1);
+            SPIM_DMA_Write(u32Block, 0, MSC_SPIM_ERASE_SIZE, pu8Buf, CMD_NORMAL_PAGE_PROGRAM);
+        }
+        else
+        {
+            /* Partial block, read-modify-write */
+            if(SPIM_DMA_Read(u32Block, 0, MSC_SPIM_ERASE_SIZE, s_au8EraseBuf, CMD_DMA_FAST_READ, 1) != 0)
+                return -1;
+            memcpy(&s_au8EraseBuf[u32Offset], pu8Buf, u32Size);
+            SPIM_EraseBlock(u32Block, 0, OPCODE_SE_4K, 1, 1);
+            SPIM_DMA_Write(u32Block, 0, MSC_SPIM_ERASE_SIZE, s_au8EraseBuf, CMD_NORMAL_PAGE_PROGRAM);
+        }
+
+        u32Addr += u32Size;
+        pu8Buf += u32Size;
+        u32Len -= u32Size;
+    }
+    return 0;
+}
+
+const MSC_MEDIA_T g_sMscMediaSPIM =
+{
+    "SPIM", SPIM_MediaInit, SPIM_MediaIsReady, SPIM_MediaGetSectorCount, SPIM_MediaRead, SPIM_MediaWrite
+};
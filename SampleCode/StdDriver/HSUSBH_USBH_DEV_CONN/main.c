@@ -49,9 +49,9 @@ uint32_t get_ticks(void)
 
 /*
  *  USB device connect callback function.
- *  User invokes usbh_pooling_hubs() to let USB core able to scan and handle events of
+ *  User invokes usbh_pooling_hubs_async() to let USB core able to scan and handle events of
  *  HSUSBH port, USBH port, and USB hub device ports. Once a new device connected, it
- *  will be detected and enumerated in the call to usbh_pooling_hubs(). This callback
+ *  will be detected and enumerated over the calls to usbh_pooling_hubs_async(). This callback
  *  will be invoked from USB core once a newly connected device was successfully enumerated.
  */
 void connect_func(struct udev_t *udev, int i8Param)
@@ -66,6 +66,7 @@ void connect_func(struct udev_t *udev, int i8Param)
     printf("Device [0x%x,0x%x] was connected.\n",
            udev->descriptor.idVendor, udev->descriptor.idProduct);
     printf("    Speed:    %s-speed\n", (udev->speed == SPEED_HIGH) ? "high" : ((udev->speed == SPEED_FULL) ? "full" : "low"));
+    printf("    Enumeration time: %d ms\n", udev->enum_time);
     printf("    Location: ");
 
     if(parent == NULL)
@@ -96,9 +97,9 @@ void connect_func(struct udev_t *udev, int i8Param)
 
 /*
  *  USB device disconnect callback function.
- *  User invokes usbh_pooling_hubs() to let USB core able to scan and handle events of
+ *  User invokes usbh_pooling_hubs_async() to let USB core able to scan and handle events of
  *  HSUSBH port, USBH port, and USB hub device ports. Once a device was disconnected, it
- *  will be detected and removed in the call to usbh_pooling_hubs(). This callback
+ *  will be detected and removed in the call to usbh_pooling_hubs_async(). This callback
  *  will be invoked from USB core prior to remove that device.
  */
 void disconnect_func(struct udev_t *udev, int i8Param)
@@ -229,7 +230,7 @@ int32_t main(void)
 
     while(1)
     {
-        if(usbh_pooling_hubs())              /* USB Host port detect polling and management */
+        if(usbh_pooling_hubs_async())        /* USB Host port detect polling and management */
         {
             // usbh_memory_used();           /* print out USB memory allocating information */
         }
@@ -0,0 +1,393 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Measure EHCI interrupt cost with many devices attached through hubs.
+ *           Every interrupt-in endpoint of every attached non-hub device is kept
+ *           polled, and the EHCI interrupt statistics are printed once a second.
+ *
+ * @details  The field configuration is 8 devices behind USB 2.0 hubs. Attach the
+ *           hubs and devices (keyboards, mice, or any device with interrupt-in
+ *           endpoints) to the HSUSBH port and watch the report. "QH/IRQ" is the
+ *           number of QHs the interrupt handler inspected per interrupt, compared
+ *           with "QHs" linked in the schedule; "cb-lat" is the longest time from
+ *           EHCI_IRQHandler entry to a transfer call back.
+ *
+ *           The projects define ENABLE_EHCI_IRQ_STATS, which UsbHostLib config.h
+ *           leaves off by default.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+
+#include "usb.h"
+#include "hub.h"
+#include "usbh_lib.h"
+
+#define BENCH_MAX_PIPES     16              /* maximum number of polled interrupt-in pipes */
+#define BENCH_BUFF_SIZE     64              /* receive buffer size of each pipe            */
+
+typedef struct
+{
+    IFACE_T     *iface;                     /* interface the pipe belongs to               */
+    EP_INFO_T   *ep;                        /* interrupt-in endpoint                       */
+    UTR_T       *utr;                       /* the UTR kept in flight                      */
+    uint32_t    u32XferCnt;                 /* completed transfers                         */
+    int         i32Err;                     /* last error, polling stops on error          */
+} BENCH_PIPE_T;
+
+static volatile uint32_t s_u32TickCnt;
+static BENCH_PIPE_T s_asPipe[BENCH_MAX_PIPES];
+static uint8_t s_au8PipeBuff[BENCH_MAX_PIPES][BENCH_BUFF_SIZE] __attribute__((aligned(32)));
+
+void SysTick_Handler(void);
+void enable_sys_tick(int ticks_per_second);
+void connect_func(struct udev_t *udev, int i8Param);
+void disconnect_func(struct udev_t *udev, int i8Param);
+void SYS_Init(void);
+void UART0_Init(void);
+
+void SysTick_Handler(void)
+{
+    s_u32TickCnt++;
+}
+
+void enable_sys_tick(int ticks_per_second)
+{
+    s_u32TickCnt = 0;
+    if(SysTick_Config(SystemCoreClock / (uint32_t)ticks_per_second))
+    {
+        /* Setup SysTick Timer for 1 second interrupts  */
+        printf("Set system tick error!!\n");
+        while(1);
+    }
+}
+
+uint32_t get_ticks(void)
+{
+    return s_u32TickCnt;
+}
+
+void connect_func(struct udev_t *udev, int i8Param)
+{
+    (void)i8Param;
+
+    printf("Device [0x%x,0x%x] connected, %s-speed, %s\n",
+           udev->descriptor.idVendor, udev->descriptor.idProduct,
+           (udev->speed == SPEED_HIGH) ? "high" : ((udev->speed == SPEED_FULL) ? "full" : "low"),
+           (udev->parent == NULL) ? "root port" : "hub port");
+}
+
+void disconnect_func(struct udev_t *udev, int i8Param)
+{
+    (void)i8Param;
+
+    printf("Device [0x%x,0x%x] disconnected.\n",
+           udev->descriptor.idVendor, udev->descriptor.idProduct);
+}
+
+/*---------------------------------------------------------------------------------------*/
+/*  Benchmark driver. Claims any non-hub interface having interrupt-in endpoints and     */
+/*  keeps one UTR in flight on each of them.                                             */
+/*---------------------------------------------------------------------------------------*/
+static void bench_int_done(UTR_T *utr)
+{
+    BENCH_PIPE_T *psPipe = (BENCH_PIPE_T *)utr->context;
+
+    if((utr->status != 0) || (psPipe->i32Err != 0))
+    {
+        if(psPipe->i32Err == 0)
+            psPipe->i32Err = utr->status;
+        return;
+    }
+    psPipe->u32XferCnt++;
+
+    utr->xfer_len = 0;
+    if(usbh_int_xfer(utr) < 0)
+        psPipe->i32Err = USBH_ERR_TRANSFER;
+}
+
+static int bench_probe(IFACE_T *iface)
+{
+    ALT_IFACE_T *aif = iface->aif;
+    BENCH_PIPE_T *psPipe;
+    UTR_T *utr;
+    int i, j, i32Claimed = 0;
+
+    if(aif->ifd->bInterfaceClass == USB_CLASS_HUB)
+        return USBH_ERR_NOT_MATCHED;
+
+    for(i = 0; i < aif->ifd->bNumEndpoints; i++)
+    {
+        if(((aif->ep[i].bmAttributes & EP_ATTR_TT_MASK) != EP_ATTR_TT_INT) ||
+                ((aif->ep[i].bEndpointAddress & EP_ADDR_DIR_MASK) != EP_ADDR_DIR_IN))
+            continue;
+
+        for(j = 0; j < BENCH_MAX_PIPES; j++)
+        {
+            if(s_asPipe[j].iface == NULL)
+                break;
+        }
+        if(j >= BENCH_MAX_PIPES)
+        {
+            printf("Too many interrupt-in pipes, ignore EP 0x%x.\n", aif->ep[i].bEndpointAddress);
+            break;
+        }
+
+        utr = alloc_utr(iface->udev);
+        if(utr == NULL)
+            break;
+
+        psPipe = &s_asPipe[j];
+        memset(psPipe, 0, sizeof(*psPipe));
+        psPipe->iface = iface;
+        psPipe->ep = &aif->ep[i];
+        psPipe->utr = utr;
+
+        utr->context = psPipe;
+        utr->ep = psPipe->ep;
+        utr->buff = s_au8PipeBuff[j];
+        utr->data_len = (psPipe->ep->wMaxPacketSize < BENCH_BUFF_SIZE) ? psPipe->ep->wMaxPacketSize : BENCH_BUFF_SIZE;
+        utr->xfer_len = 0;
+        utr->func = bench_int_done;
+
+        if(usbh_int_xfer(utr) < 0)
+        {
+            free_utr(utr);
+            psPipe->iface = NULL;
+            continue;
+        }
+        printf("    poll interface %d EP 0x%x, interval %d\n", aif->ifd->bInterfaceNumber,
+               psPipe->ep->bEndpointAddress, psPipe->ep->bInterval);
+        i32Claimed = 1;
+    }
+    return i32Claimed ? 0 : USBH_ERR_NOT_MATCHED;
+}
+
+static void bench_disconnect(IFACE_T *iface)
+{
+    int i;
+
+    for(i = 0; i < BENCH_MAX_PIPES; i++)
+    {
+        if(s_asPipe[i].iface != iface)
+            continue;
+
+        s_asPipe[i].i32Err = USBH_ERR_DISCONNECTED;  /* stop re-submitting         */
+        s_asPipe[i].utr->func = NULL;
+        usbh_quit_utr(s_asPipe[i].utr);     /* force to stop the transfer                  */
+        delay_us(32000);                    /* wait for IAA to abort it                    */
+        free_utr(s_asPipe[i].utr);
+        s_asPipe[i].iface = NULL;
+    }
+}
+
+static UDEV_DRV_T s_sBenchDriver =
+{
+    bench_probe,
+    bench_disconnect,
+    NULL,                       /* suspend */
+    NULL,                       /* resume */
+};
+
+/*
+ *  Count the EHCI QHs linked in the schedule, i.e. the endpoints of EHCI-attached
+ *  devices that have a host controller pipe.
+ */
+static uint32_t count_ehci_qh(uint32_t *pu32DevCnt)
+{
+    UDEV_T *udev;
+    IFACE_T *iface;
+    uint32_t u32QhCnt = 0, u32DevCnt = 0;
+    int i;
+
+    for(udev = g_udev_list; udev != NULL; udev = udev->next)
+    {
+        if(udev->hc_driver != &ehci_driver)
+            continue;
+        u32DevCnt++;
+
+        if(udev->ep0.hw_pipe != NULL)
+            u32QhCnt++;
+
+        for(iface = udev->iface_list; iface != NULL; iface = iface->next)
+        {
+            for(i = 0; i < iface->aif->ifd->bNumEndpoints; i++)
+            {
+                if(iface->aif->ep[i].hw_pipe != NULL)
+                    u32QhCnt++;
+            }
+        }
+    }
+    *pu32DevCnt = u32DevCnt;
+    return u32QhCnt;
+}
+
+static void bench_report(uint32_t u32Ticks)
+{
+    EHCI_IRQ_STATS_T sStats;
+    uint32_t u32CyclesPerUs = SystemCoreClock / 1000000;
+    uint32_t u32DevCnt, u32QhCnt, u32PipeCnt = 0, u32Irq;
+    int i;
+
+    if(usbh_ehci_irq_stats(&sStats, 1) != 0)
+    {
+        printf("ENABLE_EHCI_IRQ_STATS is not defined!\n");
+        return;
+    }
+
+    for(i = 0; i < BENCH_MAX_PIPES; i++)
+    {
+        if((s_asPipe[i].iface != NULL) && (s_asPipe[i].i32Err == 0))
+            u32PipeCnt++;
+    }
+    u32QhCnt = count_ehci_qh(&u32DevCnt);
+    u32Irq = (sStats.irq_cnt != 0) ? sStats.irq_cnt : 1;
+
+    printf("dev %2d QHs %2d pipes %2d | IRQ/s %5d avg %3d us max %3d us cb-lat %3d us | "
+           "QH/IRQ %d.%02d qTD/IRQ %d.%02d UTR/s %5d\n",
+           u32DevCnt, u32QhCnt, u32PipeCnt,
+           sStats.irq_cnt * 100 / u32Ticks,
+           sStats.irq_cycles / u32Irq / u32CyclesPerUs,
+           sStats.irq_cycles_max / u32CyclesPerUs,
+           sStats.cb_latency_max / u32CyclesPerUs,
+           sStats.qh_scanned / u32Irq, (sStats.qh_scanned * 100 / u32Irq) % 100,
+           sStats.qtd_retired / u32Irq, (sStats.qtd_retired * 100 / u32Irq) % 100,
+           sStats.utr_done * 100 / u32Ticks);
+}
+
+/*
+ *  This function is necessary for USB Host library.
+ */
+void delay_us(int usec)
+{
+    /*
+     *  Configure Timer0, clock source from XTL_12M. Prescale 12
+     */
+    /* TIMER0 clock from HXT */
+    CLK->CLKSEL1 = (CLK->CLKSEL1 & (~CLK_CLKSEL1_TMR0SEL_Msk)) | CLK_CLKSEL1_TMR0SEL_HXT;
+    CLK->APBCLK0 |= CLK_APBCLK0_TMR0CKEN_Msk;
+    TIMER0->CTL = 0;        /* disable timer */
+    TIMER0->INTSTS = (TIMER_INTSTS_TIF_Msk | TIMER_INTSTS_TWKF_Msk);   /* write 1 to clear for safety */
+    TIMER0->CMP = (uint32_t)usec;
+    TIMER0->CTL = (11 << TIMER_CTL_PSC_Pos) | TIMER_ONESHOT_MODE | TIMER_CTL_CNTEN_Msk;
+
+    while(!TIMER0->INTSTS);
+}
+
+void SYS_Init(void)
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 192MHz */
+    CLK_SetCoreClock(FREQ_192MHZ);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable USBH module clock */
+    CLK_EnableModuleClock(USBH_MODULE);
+
+    /* USB Host desired input clock is 48 MHz. */
+    /* Select USB module clock source as PLL/2 and USB module clock divider as 2 */
+    CLK_SetModuleClock(USBH_MODULE, CLK_CLKSEL0_USBSEL_PLL_DIV2, CLK_CLKDIV0_USB(2));
+
+    /* Set OTG as USB Host role */
+    SYS->USBPHY = SYS_USBPHY_HSUSBEN_Msk | (0x1 << SYS_USBPHY_HSUSBROLE_Pos) | SYS_USBPHY_USBEN_Msk | SYS_USBPHY_SBO_Msk | (0x1 << SYS_USBPHY_USBROLE_Pos);
+    delay_us(20);
+    SYS->USBPHY |= SYS_USBPHY_HSUSBACT_Msk;
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* USB_VBUS_EN (USB 1.1 VBUS power enable pin) multi-function pin - PB.15     */
+    SET_USB_VBUS_EN_PB15();
+
+    /* USB_VBUS_ST (USB 1.1 over-current detect pin) multi-function pin - PC.14   */
+    SET_USB_VBUS_ST_PC14();
+
+    /* HSUSB_VBUS_EN (USB 2.0 VBUS power enable pin) multi-function pin - PB.10   */
+    SET_HSUSB_VBUS_EN_PB10();
+
+    /* HSUSB_VBUS_ST (USB 2.0 over-current detect pin) multi-function pin - PB.11 */
+    SET_HSUSB_VBUS_ST_PB11();
+
+    /* USB 1.1 port multi-function pin VBUS, D+, D-, and ID pins */
+    SET_USB_VBUS_PA12();
+    SET_USB_D_N_PA13();
+    SET_USB_D_P_PA14();
+    SET_USB_OTG_ID_PA15();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+int32_t main(void)
+{
+    uint32_t u32Tick;
+
+    SYS_Init();                        /* Init System, IP clock and multi-function I/O */
+
+    UART0_Init();                      /* Initialize UART0 */
+
+    enable_sys_tick(100);
+
+    printf("\n\n");
+    printf("+--------------------------------------------+\n");
+    printf("|                                            |\n");
+    printf("|     USB Host EHCI interrupt benchmark      |\n");
+    printf("|                                            |\n");
+    printf("+--------------------------------------------+\n");
+
+    usbh_core_init();
+    usbh_register_driver(&s_sBenchDriver);
+    usbh_install_conn_callback(connect_func, disconnect_func);
+
+    u32Tick = get_ticks();
+    while(1)
+    {
+        usbh_pooling_hubs();           /* USB Host port detect polling and management */
+
+        if(get_ticks() - u32Tick >= 100)
+        {
+            bench_report(get_ticks() - u32Tick);
+            u32Tick = get_ticks();
+        }
+    }
+}
@@ -192,6 +192,64 @@ int lbk_bulk_read(uint8_t *data_buff, int data_len, int timeout_ticks)
     return ret;
 }
 
+/*
+ *  Allocate a bulk UTR for queued transfers. The UTR is not submitted. Bulk UTRs of the
+ *  same endpoint can be submitted back-to-back with lbk_bulk_submit() without waiting
+ *  for completion; the host controller driver queues them and completes them in order.
+ */
+UTR_T *lbk_bulk_alloc_utr(int is_in, uint8_t *data_buff, int data_len, void (*func)(UTR_T *))
+{
+    UTR_T *utr;
+
+    if((s_lbk_dev.udev == NULL) || (s_lbk_dev.ep_bulk_in == NULL) || (s_lbk_dev.ep_bulk_out == NULL))
+        return NULL;
+
+    utr = alloc_utr(s_lbk_dev.udev);
+    if(!utr)
+        return NULL;
+
+    utr->ep = is_in ? s_lbk_dev.ep_bulk_in : s_lbk_dev.ep_bulk_out;
+    utr->buff = data_buff;
+    utr->data_len = (uint32_t)data_len;
+    utr->func = func;
+    utr->bIsTransferDone = 1;   /* not in flight */
+    return utr;
+}
+
+/*
+ *  Queue a bulk UTR allocated by lbk_bulk_alloc_utr(). Returns without waiting.
+ */
+int lbk_bulk_submit(UTR_T *utr)
+{
+    int ret;
+
+    if(s_lbk_dev.udev == NULL)
+        return -1;
+
+    utr->xfer_len = 0;
+    utr->status = 0;
+    utr->bIsTransferDone = 0;
+
+    ret = usbh_bulk_xfer(utr);
+    if(ret < 0)
+        utr->bIsTransferDone = 1;
+    return ret;
+}
+
+/*
+ *  Abort all queued bulk UTRs of both bulk endpoints.
+ */
+void lbk_bulk_abort(void)
+{
+    if(s_lbk_dev.udev == NULL)
+        return;
+
+    if(s_lbk_dev.ep_bulk_out != NULL)
+        usbh_quit_xfer(s_lbk_dev.udev, s_lbk_dev.ep_bulk_out);
+    if(s_lbk_dev.ep_bulk_in != NULL)
+        usbh_quit_xfer(s_lbk_dev.udev, s_lbk_dev.ep_bulk_in);
+}
+
 static void int_in_done(UTR_T *utr)
 {
     int ret;
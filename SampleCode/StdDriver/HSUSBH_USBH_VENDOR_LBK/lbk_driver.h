@@ -35,6 +35,9 @@ extern int lbk_vendor_set_data(uint8_t *buff);
 extern int lbk_vendor_get_data(uint8_t *buff);
 extern int lbk_bulk_write(uint8_t *data_buff, int data_len, int timeout_ticks);
 extern int lbk_bulk_read(uint8_t *data_buff, int data_len, int timeout_ticks);
+extern UTR_T *lbk_bulk_alloc_utr(int is_in, uint8_t *data_buff, int data_len, void (*func)(UTR_T *));
+extern int lbk_bulk_submit(UTR_T *utr);
+extern void lbk_bulk_abort(void);
 extern int lbk_interrupt_in_start(INT_CB_FUNC *func);
 extern void lbk_interrupt_in_stop(void);
 extern int lbk_interrupt_out_start(INT_CB_FUNC *func);
@@ -28,6 +28,13 @@ static volatile int s_i8IntInCnt, s_i8IntOutCnt;
 static volatile int s_i8IsoInCnt, s_i8IsoOutCnt;
 static volatile uint32_t s_u32TickCnt;
 
+#define PIPE_UTR_SIZE       4096            /* data length of each queued bulk UTR         */
+#define PIPE_MAX_DEPTH      8               /* maximum number of UTRs in flight per pipe   */
+#define PIPE_RUN_TICKS      200             /* measure time of each depth, in ticks       */
+
+static uint32_t s_au32PipeOut[PIPE_MAX_DEPTH][PIPE_UTR_SIZE / 4];
+static uint32_t s_au32PipeIn[PIPE_MAX_DEPTH][PIPE_UTR_SIZE / 4];
+
 void SysTick_Handler(void);
 void enable_sys_tick(int ticks_per_second);
 void SYS_Init(void);
@@ -36,6 +43,7 @@ void connect_func(UDEV_T *udev, int param);
 void disconnect_func(UDEV_T *udev, int param);
 void demo_ctrl_xfer(void);
 void demo_bulk_xfer(void);
+void demo_bulk_pipeline(void);
 int int_in_callback(int status, uint8_t *rdata, int data_len);
 int int_out_callback(int status, uint8_t *rdata, int data_len);
 void demo_interrupt_xfer(void);
@@ -324,6 +332,205 @@ void demo_bulk_xfer(void)
     }
 }
 
+/*
+ *  Fill/check the loopback pattern of the u32Seq-th UTR. Each word carries the UTR
+ *  sequence number, so that out-of-order or lost UTRs are detected.
+ */
+static void pipe_fill(uint8_t *pu8Buf, uint32_t u32Seq)
+{
+    uint32_t i, *pu32 = (uint32_t *)pu8Buf;
+
+    for(i = 0; i < PIPE_UTR_SIZE / 4; i++)
+        pu32[i] = (u32Seq << 16) | i;
+}
+
+static int pipe_check(uint8_t *pu8Buf, uint32_t u32Seq)
+{
+    uint32_t i, *pu32 = (uint32_t *)pu8Buf;
+
+    for(i = 0; i < PIPE_UTR_SIZE / 4; i++)
+    {
+        if(pu32[i] != ((u32Seq << 16) | i))
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ *  Run bulk loopback with u32Depth bulk-out and u32Depth bulk-in UTRs kept in flight.
+ *  Returns the loopback throughput in KB/s, or a negative value on error.
+ */
+static int pipe_run(uint32_t u32Depth)
+{
+    UTR_T *apsOut[PIPE_MAX_DEPTH], *apsIn[PIPE_MAX_DEPTH];
+    uint32_t i, u32OutIdx, u32InIdx, u32OutSeq, u32OutDone, u32InSeq, u32InSubSeq;
+    uint32_t t0, u32LastTick, u32Bytes, u32Ticks;
+    int ret = 0, i32Stop = 0;
+
+    memset(apsOut, 0, sizeof(apsOut));
+    memset(apsIn, 0, sizeof(apsIn));
+
+    for(i = 0; i < u32Depth; i++)
+    {
+        apsOut[i] = lbk_bulk_alloc_utr(0, (uint8_t *)s_au32PipeOut[i], PIPE_UTR_SIZE, NULL);
+        apsIn[i] = lbk_bulk_alloc_utr(1, (uint8_t *)s_au32PipeIn[i], PIPE_UTR_SIZE, NULL);
+        if((apsOut[i] == NULL) || (apsIn[i] == NULL))
+        {
+            ret = USBH_ERR_MEMORY_OUT;
+            goto pipe_out;
+        }
+    }
+
+    /* Fill the pipes */
+    for(i = 0; i < u32Depth; i++)
+    {
+        pipe_fill((uint8_t *)s_au32PipeOut[i], i);
+        if((lbk_bulk_submit(apsIn[i]) < 0) || (lbk_bulk_submit(apsOut[i]) < 0))
+        {
+            ret = -1;
+            goto pipe_abort;
+        }
+    }
+
+    /*
+     *  u32OutSeq/u32InSubSeq: sequence number of the next bulk-out/bulk-in UTR to submit.
+     *  u32OutDone/u32InSeq:   number of bulk-out/bulk-in UTRs completed.
+     */
+    u32OutIdx = u32InIdx = 0;
+    u32OutSeq = u32InSubSeq = u32Depth;
+    u32OutDone = u32InSeq = 0;
+    u32Bytes = 0;
+    u32Ticks = PIPE_RUN_TICKS;
+    t0 = u32LastTick = get_ticks();
+
+    /* UTRs of an endpoint complete in order, so only the oldest one is polled */
+    while(1)
+    {
+        if(!i32Stop && (get_ticks() - t0 >= PIPE_RUN_TICKS))
+        {
+            i32Stop = 1;                    /* stop queuing, drain the pipes              */
+            u32Ticks = get_ticks() - t0;
+        }
+
+        if((u32OutDone < u32OutSeq) && apsOut[u32OutIdx]->bIsTransferDone)
+        {
+            if(apsOut[u32OutIdx]->status != 0)
+            {
+                printf("Bulk-out UTR error %d!\n", apsOut[u32OutIdx]->status);
+                ret = -1;
+                goto pipe_abort;
+            }
+            u32OutDone++;
+
+            /* After stop, bulk-out continues only to feed the bulk-in UTRs already queued */
+            if(!i32Stop || (u32OutSeq < u32InSubSeq))
+            {
+                pipe_fill(apsOut[u32OutIdx]->buff, u32OutSeq++);
+                if(lbk_bulk_submit(apsOut[u32OutIdx]) < 0)
+                {
+                    ret = -1;
+                    goto pipe_abort;
+                }
+            }
+            u32OutIdx = (u32OutIdx + 1) % u32Depth;
+            u32LastTick = get_ticks();
+        }
+
+        if((u32InSeq < u32InSubSeq) && apsIn[u32InIdx]->bIsTransferDone)
+        {
+            if((apsIn[u32InIdx]->status != 0) || (apsIn[u32InIdx]->xfer_len != PIPE_UTR_SIZE))
+            {
+                printf("Bulk-in UTR error %d, length %d!\n", apsIn[u32InIdx]->status, apsIn[u32InIdx]->xfer_len);
+                ret = -1;
+                goto pipe_abort;
+            }
+            if(pipe_check(apsIn[u32InIdx]->buff, u32InSeq) != 0)
+            {
+                printf("Bulk-in data compare error at UTR %d!\n", u32InSeq);
+                ret = -1;
+                goto pipe_abort;
+            }
+            u32InSeq++;
+            if(!i32Stop)
+                u32Bytes += PIPE_UTR_SIZE;
+
+            /* After stop, bulk-in continues only to drain the bulk-out UTRs already sent */
+            if(!i32Stop || (u32InSubSeq < u32OutSeq))
+            {
+                u32InSubSeq++;
+                if(lbk_bulk_submit(apsIn[u32InIdx]) < 0)
+                {
+                    ret = -1;
+                    goto pipe_abort;
+                }
+            }
+            u32InIdx = (u32InIdx + 1) % u32Depth;
+            u32LastTick = get_ticks();
+        }
+
+        if(i32Stop && (u32OutDone == u32OutSeq) && (u32InSeq == u32InSubSeq))
+            break;                          /* all data looped back                       */
+
+        if(get_ticks() - u32LastTick > 100)
+        {
+            printf("Bulk pipeline timeout!\n");
+            ret = USBH_ERR_TIMEOUT;
+            goto pipe_abort;
+        }
+
+        if(!lbk_device_is_connected())
+        {
+            ret = -1;
+            goto pipe_abort;
+        }
+    }
+
+    ret = (int)((u32Bytes / 1024) * 100 / u32Ticks);
+    goto pipe_out;
+
+pipe_abort:
+    lbk_bulk_abort();
+    t0 = get_ticks();
+    while(get_ticks() - t0 < 10);           /* let the aborted UTRs be called back        */
+
+pipe_out:
+    for(i = 0; i < u32Depth; i++)
+    {
+        if(apsOut[i])
+            free_utr(apsOut[i]);
+        if(apsIn[i])
+            free_utr(apsIn[i]);
+    }
+    return ret;
+}
+
+/*
+ *  Bulk loopback with 1, 2, 4 and 8 UTRs of 4096 bytes kept in flight on each bulk
+ *  endpoint. With a single UTR the pipe drains between transfers; with more UTRs the
+ *  host controller always has the next transfer linked when one completes.
+ */
+void demo_bulk_pipeline(void)
+{
+    uint32_t u32Depth;
+    int ret;
+
+    printf("\nBulk pipeline loopback, %d bytes per UTR\n", PIPE_UTR_SIZE);
+
+    for(u32Depth = 1; u32Depth <= PIPE_MAX_DEPTH; u32Depth *= 2)
+    {
+        if(!lbk_device_is_connected())
+            return;
+
+        ret = pipe_run(u32Depth);
+        if(ret < 0)
+        {
+            printf("Depth %d failed! (%d)\n", u32Depth, ret);
+            return;
+        }
+        printf("Depth %d: %d KB/s\n", u32Depth, ret);
+    }
+}
+
 int int_in_callback(int status, uint8_t *rdata, int data_len)
 {
     (void)rdata;
@@ -477,6 +684,7 @@ void vendor_lbk_demo(void)
         printf("| [2] Bulk transfer demo                   |\n");
         printf("| [3] Interrupt transfer demo              |\n");
         printf("| [4] Isochronous transfer demo            |\n");
+        printf("| [5] Bulk pipeline throughput             |\n");
         printf("+------------------------------------------+\n");
 
         usbh_memory_used();
@@ -505,6 +713,10 @@ void vendor_lbk_demo(void)
             case '4':
                 demo_isochronous_xfer();
                 break;
+
+            case '5':
+                demo_bulk_pipeline();
+                break;
         }
 
         usbh_pooling_hubs();
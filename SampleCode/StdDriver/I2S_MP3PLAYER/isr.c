@@ -19,12 +19,17 @@ void PDMA0_IRQHandler(void)
 {
     uint32_t u32Status = PDMA_GET_INT_STATUS(PDMA0);
 
+    TRACE_ENTER(I2S, TRACE_I2S_IRQ, u32Status);
+
     if(u32Status & 0x2)    /* done */
     {
         if(PDMA_GET_TD_STS(PDMA0) & 0x4)
         {
             if(aPCMBuffer_Full[u8PCMBuffer_Playing ^ 1] != 1)
+            {
+                TRACE_MARK(I2S, TRACE_I2S_UNDERRUN, u8PCMBuffer_Playing);
                 printf("underflow!!\n");
+            }
             aPCMBuffer_Full[u8PCMBuffer_Playing] = 0;       /* Set empty flag */
             u8PCMBuffer_Playing ^= 1;
         }
@@ -40,4 +45,6 @@ void PDMA0_IRQHandler(void)
         printf("0x%x\n", u32Status);
         //while(1);
     }
+
+    TRACE_EXIT(I2S, TRACE_I2S_IRQ, u32Status);
 }
@@ -51,6 +51,8 @@ void SDH0_IRQHandler(void)
     unsigned int volatile isr;
     unsigned int volatile ier;
 
+    TRACE_ENTER(SDH, TRACE_SDH_IRQ, 0);
+
     // FMI data abort interrupt
     if(SDH0->GINTSTS & SDH_GINTSTS_DTAIF_Msk)
     {
@@ -124,6 +126,8 @@ void SDH0_IRQHandler(void)
         printf("***** ISR: response in timeout !\n");
         SDH0->INTSTS |= SDH_INTSTS_RTOIF_Msk;
     }
+
+    TRACE_EXIT(SDH, TRACE_SDH_IRQ, isr);
 }
 
 void SD_Inits(void)
@@ -0,0 +1,309 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Measure where PDMA_MemCopy() overtakes memcpy() for SRAM,
+ *           HyperRAM and SPI flash (SPIM direct map) sources and targets.
+ *
+ * @details  For copies of 16 bytes to 16 KB the DWT cycle counter times
+ *           memcpy() against PDMA_MemCopy() followed by PDMA_CopyWait(), and
+ *           the cycles PDMA_MemCopy() alone keeps the CPU busy. The threshold
+ *           of the copy service is forced down so that every size goes to
+ *           PDMA. The first size at which PDMA finishes no later than the CPU
+ *           is printed per region as the suggested PDMA_CopySetThreshold()
+ *           value; above it the CPU is free for the rest of the copy as well.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define global variables and constants                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define MAX_SIZE            16384
+#define MIN_SIZE            16
+#define REPEAT              8
+#define POOL_SIZE           (PDMA_COPY_SLOTS * 2)
+#define SPIM_SRC_ADDR       0x10000                         /* Flash offset read through the direct map */
+
+typedef struct
+{
+    const char *pcName;
+    uint8_t *pu8Dst;
+    const uint8_t *pu8Src;
+} REGION_T;
+
+static uint32_t s_au32Src[MAX_SIZE / 4];
+static uint32_t s_au32Dst[MAX_SIZE / 4];
+static DSCT_T s_asPool[POOL_SIZE];
+static PDMA_SVC_T s_sSvc;
+static PDMA_COPY_T s_sCopy;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define functions prototype                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void);
+void SYS_Init(void);
+void UART0_Init(void);
+void PDMA0_IRQHandler(void);
+
+
+static uint32_t GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+void SYS_Init(void)
+{
+
+    /* Set PF multi-function pins for XT1_OUT(PF.2) and XT1_IN(PF.3) */
+    SET_XT1_OUT_PF2();
+    SET_XT1_IN_PF3();
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Enable HIRC and HXT clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk | CLK_PWRCTL_HXTEN_Msk);
+
+    /* Wait for HIRC and HXT clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk | CLK_STATUS_HXTSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable PDMA0, HBI and SPIM module clock */
+    CLK_EnableModuleClock(PDMA0_MODULE);
+    CLK_EnableModuleClock(HBI_MODULE);
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Set multi-function pins for HBI */
+    SET_HBI_D0_PJ6();
+    SET_HBI_D1_PJ5();
+    SET_HBI_D2_PJ4();
+    SET_HBI_D3_PJ3();
+    SET_HBI_D4_PH15();
+    SET_HBI_D5_PD7();
+    SET_HBI_D6_PD6();
+    SET_HBI_D7_PD5();
+
+    SET_HBI_RWDS_PH14();
+    SET_HBI_nRESET_PJ2();
+    SET_HBI_nCS_PJ7();
+    SET_HBI_CK_PH13();
+    SET_HBI_nCK_PH12();
+
+    /* Init SPIM multi-function pins, MOSI(PJ.1), MISO(PI.13), CLK(PJ.0), SS(PI.12), D3(PI.15), and D2(PI.14) */
+    SET_SPIM_MOSI_PJ1();
+    SET_SPIM_MISO_PI13();
+    SET_SPIM_CLK_PJ0();
+    SET_SPIM_SS_PI12();
+    SET_SPIM_D3_PI15();
+    SET_SPIM_D2_PI14();
+
+    PJ->SMTEN |= GPIO_SMTEN_SMTEN0_Msk;
+
+}
+
+void UART0_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init UART                                                                                               */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* PDMA interrupt handler                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Benchmark                                                                                               */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t TimeCpu(const REGION_T *psRegion, uint32_t u32Size)
+{
+    uint32_t u32Start, i;
+
+    u32Start = GetCycles();
+
+    for (i = 0; i < REPEAT; i++)
+        memcpy(psRegion->pu8Dst, psRegion->pu8Src, u32Size);
+
+    return (GetCycles() - u32Start) / REPEAT;
+}
+
+static uint32_t TimePdma(const REGION_T *psRegion, uint32_t u32Size, uint32_t *pu32Issue)
+{
+    uint32_t u32Start, u32Issued, u32Fence, u32Issue = 0, i;
+
+    u32Start = GetCycles();
+
+    for (i = 0; i < REPEAT; i++)
+    {
+        u32Issued = GetCycles();
+        u32Fence = PDMA_MemCopy(&s_sCopy, psRegion->pu8Dst, psRegion->pu8Src, u32Size);
+        u32Issue += GetCycles() - u32Issued;
+
+        if (PDMA_CopyWait(&s_sCopy, u32Fence) != 0)
+            printf("  PDMA copy of %d bytes failed\n", u32Size);
+    }
+
+    *pu32Issue = u32Issue / REPEAT;
+
+    return (GetCycles() - u32Start) / REPEAT;
+}
+
+static void RunRegion(const REGION_T *psRegion)
+{
+    uint32_t u32Size, u32Cpu, u32Pdma, u32Issue, u32Cross = 0;
+
+    printf("\n%s\n", psRegion->pcName);
+    printf("   bytes |   memcpy |  PDMA+wait |  PDMA issue\n");
+
+    for (u32Size = MIN_SIZE; u32Size <= MAX_SIZE; u32Size <<= 1)
+    {
+        u32Cpu = TimeCpu(psRegion, u32Size);
+        u32Pdma = TimePdma(psRegion, u32Size, &u32Issue);
+
+        if ((memcmp(psRegion->pu8Dst, psRegion->pu8Src, u32Size) != 0))
+            printf("  data mismatch at %d bytes\n", u32Size);
+
+        printf("  %6d | %8d | %10d | %11d\n", u32Size, u32Cpu, u32Pdma, u32Issue);
+
+        if ((u32Cross == 0) && (u32Pdma <= u32Cpu))
+            u32Cross = u32Size;
+    }
+
+    if (u32Cross)
+        printf("Suggested threshold: %d bytes\n", u32Cross);
+    else
+        printf("memcpy() is faster at every size; PDMA only pays off to free the CPU.\n");
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    uint8_t au8Id[3];
+    uint32_t i, r;
+    REGION_T asRegion[4];
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, IP clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    /* Cycle counter for the measurements */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* SAMPLE CODE                                                                                             */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    printf("\nSystem clock rate: %d Hz\n", SystemCoreClock);
+    printf("+----------------------------------------------------------------------+\n");
+    printf("|             PDMA_MemCopy() versus memcpy() cross-over                |\n");
+    printf("+----------------------------------------------------------------------+\n");
+
+    /* SPI flash in direct map mode, SPIM clock HCLK/4 */
+    SPIM_SET_CLOCK_DIVIDER(2);
+    SPIM_SET_RXCLKDLY_RDDLYSEL(0);
+    SPIM_SET_RXCLKDLY_RDEDGE();
+    SPIM_SET_DCNUM(8);
+
+    if (SPIM_InitFlash(1) != 0)
+    {
+        printf("SPIM flash initialize failed!\n");
+        goto lexit;
+    }
+
+    SPIM_ReadJedecId(au8Id, sizeof(au8Id), 1);
+    printf("SPIM JEDEC ID 0x%02X 0x%02X 0x%02X\n", au8Id[0], au8Id[1], au8Id[2]);
+    SPIM_DISABLE_CCM();
+    SPIM_ENABLE_CACHE();
+    SPIM_EnterDirectMapMode(0, CMD_DMA_FAST_READ, 8);
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+    for (i = 0; i < MAX_SIZE / 4; i++)
+        s_au32Src[i] = i * 0x9E3779B9UL;
+
+    if ((PDMA_SvcInit(&s_sSvc, PDMA0, s_asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, NULL) != 0) ||
+            (PDMA_CopyInit(&s_sCopy, &s_sSvc, 0) != 0))
+    {
+        printf("PDMA copy service init failed!\n");
+        goto lexit;
+    }
+
+    NVIC_EnableIRQ(PDMA0_IRQn);
+
+    /* Time every size on PDMA */
+    PDMA_CopySetThreshold(&s_sCopy, 4);
+
+    asRegion[0].pcName = "SRAM -> SRAM";
+    asRegion[0].pu8Dst = (uint8_t *)s_au32Dst;
+    asRegion[0].pu8Src = (const uint8_t *)s_au32Src;
+    asRegion[1].pcName = "SRAM -> HyperRAM";
+    asRegion[1].pu8Dst = (uint8_t *)HYPER_RAM_MEM_MAP;
+    asRegion[1].pu8Src = (const uint8_t *)s_au32Src;
+    asRegion[2].pcName = "HyperRAM -> SRAM";
+    asRegion[2].pu8Dst = (uint8_t *)s_au32Dst;
+    asRegion[2].pu8Src = (const uint8_t *)HYPER_RAM_MEM_MAP;
+    asRegion[3].pcName = "SPI flash (direct map) -> SRAM";
+    asRegion[3].pu8Dst = (uint8_t *)s_au32Dst;
+    asRegion[3].pu8Src = (const uint8_t *)(SPIM_DMM_MAP_ADDR + SPIM_SRC_ADDR);
+
+    for (r = 0; r < sizeof(asRegion) / sizeof(asRegion[0]); r++)
+        RunRegion(&asRegion[r]);
+
+    printf("\nCPU %d ops, PDMA %d ops, %d fallbacks\n", s_sCopy.u32CpuOps, s_sCopy.u32DmaOps, s_sCopy.u32Fallbacks);
+    PDMA_CopyDeInit(&s_sCopy);
+
+    SYS_UnlockReg();
+    SPIM_ExitDirectMapMode();
+
+lexit:
+
+    printf("\nDone.\n");
+
+    while (1);
+}
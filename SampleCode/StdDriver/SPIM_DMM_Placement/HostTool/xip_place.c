@@ -0,0 +1,503 @@
+/**************************************************************************//**
+ * @file     xip_place.c
+ * @version  V1.00
+ * @brief    Host side of the SPIM DMM placement sample: turns a PC-sampling
+ *           profile into a linker script and compares benchmark runs.
+ *
+ * @details  Build: gcc -O2 -o xip_place xip_place.c
+ *
+ *           Inputs are the UART output of the sample (XIP_PROF and XIP_BENCH
+ *           lines, other text is skipped) and the symbol table of the image
+ *           the profile was taken with:
+ *               arm-none-eabi-nm -S -n SPIM_DMM_Placement.elf > symbols.txt
+ *
+ *           ./xip_place hot symbols.txt uart.log [count]
+ *               Functions by samples (default the first 20), with the memory
+ *               each one ran from.
+ *           ./xip_place ldgen symbols.txt uart.log in.ld out.ld [sram [flash]]
+ *               Rewrites the XIP_PLACE marker blocks of the linker script.
+ *               Movable functions, those linked to SPIM or already listed in
+ *               a marker block, are taken by samples per byte: SRAM first up
+ *               to "sram" bytes (default 4096), then FLASH up to "flash" bytes
+ *               (default 16384). The sampled ones left over lead the SPIM
+ *               section, hottest first, so they share cache lines instead of
+ *               being spread between cold code. in.ld and out.ld may be the
+ *               same file.
+ *           ./xip_place compare before.log after.log
+ *               Cycles per benchmark case and the change; fails when the
+ *               checksums differ, i.e. the placement changed a result.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SPIM_DMM_MAP_ADDR   0x100000UL
+#define SPIM_DMM_SIZE       0x100000UL
+
+#define LINE_SIZE           512
+#define NAME_SIZE           128
+#define MAX_BENCH           64
+
+/* A function needs this share of the samples, in 1/1000, to count as sampled */
+#define MIN_SHARE           1
+
+#define PLACE_SPIM          0
+#define PLACE_SRAM          1
+#define PLACE_FLASH         2
+
+typedef struct
+{
+    uint32_t u32Addr;
+    uint32_t u32Size;
+    uint32_t u32Samples;
+    int      iMovable;
+    int      iPlace;
+    char     acName[NAME_SIZE];
+} FUNC_T;
+
+typedef struct
+{
+    char     acName[NAME_SIZE];
+    uint32_t u32Cycles;
+    uint32_t u32Sum;
+} BENCH_T;
+
+static FUNC_T  *s_psFunc;
+static uint32_t s_u32Funcs;
+static uint32_t s_u32Samples;       /* Samples taken */
+static uint32_t s_u32Dropped;       /* Samples the target could not store */
+static uint32_t s_u32Unknown;       /* Samples outside every function */
+
+static const char *s_apcMarker[] = { "SPIM", "SRAM", "FLASH" };
+
+static int ByAddr(const void *pvA, const void *pvB)
+{
+    const FUNC_T *psA = pvA, *psB = pvB;
+
+    return (psA->u32Addr > psB->u32Addr) - (psA->u32Addr < psB->u32Addr);
+}
+
+static int BySamples(const void *pvA, const void *pvB)
+{
+    const FUNC_T *psA = *(FUNC_T * const *)pvA, *psB = *(FUNC_T * const *)pvB;
+
+    return (psA->u32Samples < psB->u32Samples) - (psA->u32Samples > psB->u32Samples);
+}
+
+/* Samples per byte, highest first; the hotter function wins a tie */
+static int ByDensity(const void *pvA, const void *pvB)
+{
+    const FUNC_T *psA = *(FUNC_T * const *)pvA, *psB = *(FUNC_T * const *)pvB;
+    uint64_t u64A = (uint64_t)psA->u32Samples * psB->u32Size;
+    uint64_t u64B = (uint64_t)psB->u32Samples * psA->u32Size;
+
+    if (u64A != u64B)
+        return (u64A < u64B) ? 1 : -1;
+
+    return BySamples(pvA, pvB);
+}
+
+static FILE *OpenFile(const char *pcPath, const char *pcMode)
+{
+    FILE *fp = fopen(pcPath, pcMode);
+
+    if (fp == NULL)
+    {
+        perror(pcPath);
+        exit(1);
+    }
+
+    return fp;
+}
+
+static const char *Where(uint32_t u32Addr)
+{
+    if ((u32Addr >= SPIM_DMM_MAP_ADDR) && (u32Addr < (SPIM_DMM_MAP_ADDR + SPIM_DMM_SIZE)))
+        return "SPIM";
+    else if (u32Addr >= 0x20000000UL)
+        return "SRAM";
+    else
+        return "FLASH";
+}
+
+/*
+ *  Code symbols of "nm -S -n": address, size, type, name
+ */
+static void LoadSymbols(const char *pcPath)
+{
+    char acLine[LINE_SIZE], acName[NAME_SIZE];
+    uint32_t u32Addr, u32Size, u32Alloc = 0;
+    char cType;
+    FILE *fp = OpenFile(pcPath, "r");
+
+    while (fgets(acLine, sizeof(acLine), fp) != NULL)
+    {
+        if (sscanf(acLine, "%x %x %c %127s", &u32Addr, &u32Size, &cType, acName) != 4)
+            continue;
+        if ((strchr("tTwW", cType) == NULL) || (u32Size == 0))
+            continue;
+
+        if (s_u32Funcs == u32Alloc)
+        {
+            u32Alloc = u32Alloc ? (u32Alloc * 2) : 1024;
+            s_psFunc = realloc(s_psFunc, u32Alloc * sizeof(FUNC_T));
+            if (s_psFunc == NULL)
+            {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+            }
+        }
+
+        memset(&s_psFunc[s_u32Funcs], 0, sizeof(FUNC_T));
+        s_psFunc[s_u32Funcs].u32Addr = u32Addr & ~1UL;      /* Thumb bit */
+        s_psFunc[s_u32Funcs].u32Size = u32Size;
+        s_psFunc[s_u32Funcs].iMovable = (strcmp(Where(u32Addr), "SPIM") == 0);
+        strcpy(s_psFunc[s_u32Funcs].acName, acName);
+        s_u32Funcs++;
+    }
+    fclose(fp);
+
+    if (s_u32Funcs == 0)
+    {
+        fprintf(stderr, "%s: no function symbols, expected the output of nm -S\n", pcPath);
+        exit(1);
+    }
+
+    qsort(s_psFunc, s_u32Funcs, sizeof(FUNC_T), ByAddr);
+}
+
+static FUNC_T *FindFunc(uint32_t u32Pc)
+{
+    uint32_t u32Lo = 0, u32Hi = s_u32Funcs, u32Mid;
+
+    while (u32Lo < u32Hi)
+    {
+        u32Mid = (u32Lo + u32Hi) / 2;
+        if (u32Pc < s_psFunc[u32Mid].u32Addr)
+            u32Hi = u32Mid;
+        else if (u32Pc >= (s_psFunc[u32Mid].u32Addr + s_psFunc[u32Mid].u32Size))
+            u32Lo = u32Mid + 1;
+        else
+            return &s_psFunc[u32Mid];
+    }
+
+    return NULL;
+}
+
+static FUNC_T *FindName(const char *pcName)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32Funcs; i++)
+    {
+        if (strcmp(s_psFunc[i].acName, pcName) == 0)
+            return &s_psFunc[i];
+    }
+
+    return NULL;
+}
+
+/*
+ *  The first XIP_PROF block of the log
+ */
+static void LoadProfile(const char *pcPath)
+{
+    char acLine[LINE_SIZE], *pc;
+    uint32_t u32Pc, u32Cnt, u32Sum = 0;
+    int iIn = 0;
+    FUNC_T *psFunc;
+    FILE *fp = OpenFile(pcPath, "r");
+
+    while (fgets(acLine, sizeof(acLine), fp) != NULL)
+    {
+        if ((pc = strstr(acLine, "XIP_PROF ")) == NULL)
+            continue;
+        pc += 9;
+
+        if (!iIn)
+        {
+            iIn = (sscanf(pc, "BEGIN %u %u", &s_u32Samples, &s_u32Dropped) == 2);
+        }
+        else if (strncmp(pc, "END", 3) == 0)
+        {
+            break;
+        }
+        else if (sscanf(pc, "%x %u", &u32Pc, &u32Cnt) == 2)
+        {
+            if ((psFunc = FindFunc(u32Pc & ~1UL)) != NULL)
+                psFunc->u32Samples += u32Cnt;
+            else
+                s_u32Unknown += u32Cnt;
+            u32Sum += u32Cnt;
+        }
+    }
+    fclose(fp);
+
+    if (!iIn || (u32Sum == 0))
+    {
+        fprintf(stderr, "%s: no XIP_PROF samples\n", pcPath);
+        exit(1);
+    }
+
+    /* Lines lost on the UART show as a gap between the counts */
+    if ((u32Sum + s_u32Dropped) != s_u32Samples)
+        fprintf(stderr, "warning: %u samples listed, %u taken, %u dropped\n", u32Sum, s_u32Samples, s_u32Dropped);
+}
+
+static int Hot(int argc, char *argv[])
+{
+    FUNC_T **ppsRank;
+    uint32_t i, u32Count = (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : 20;
+
+    LoadSymbols(argv[2]);
+    LoadProfile(argv[3]);
+
+    ppsRank = malloc(s_u32Funcs * sizeof(FUNC_T *));
+    for (i = 0; i < s_u32Funcs; i++)
+        ppsRank[i] = &s_psFunc[i];
+    qsort(ppsRank, s_u32Funcs, sizeof(FUNC_T *), BySamples);
+
+    printf("%u samples, %u dropped, %u outside functions\n\n", s_u32Samples, s_u32Dropped, s_u32Unknown);
+    printf("samples     %%    bytes  memory  function\n");
+    for (i = 0; (i < u32Count) && (i < s_u32Funcs) && (ppsRank[i]->u32Samples != 0); i++)
+    {
+        printf("%7u  %5.1f  %6u  %-6s  %s\n", ppsRank[i]->u32Samples, ppsRank[i]->u32Samples * 100.0 / s_u32Samples,
+               ppsRank[i]->u32Size, Where(ppsRank[i]->u32Addr), ppsRank[i]->acName);
+    }
+
+    free(ppsRank);
+    return 0;
+}
+
+/*
+ *  Index of the placement a marker line opens or closes, -1 for other lines
+ */
+static int Marker(const char *pcLine, const char *pcEdge)
+{
+    char acTag[64];
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        snprintf(acTag, sizeof(acTag), "XIP_PLACE_%s_%s", s_apcMarker[i], pcEdge);
+        if (strstr(pcLine, acTag) != NULL)
+            return i;
+    }
+
+    return -1;
+}
+
+static int LdGen(int argc, char *argv[])
+{
+    char **ppcLine = NULL, acLine[LINE_SIZE], acName[NAME_SIZE], *pc;
+    uint32_t u32Lines = 0, u32Alloc = 0, i, j, u32Cand = 0, u32Min;
+    uint32_t au32Budget[3], au32Used[3] = { 0 }, au32Cnt[3] = { 0 }, au32Hits[3] = { 0 };
+    FUNC_T **ppsRank, *psFunc;
+    FILE *fp;
+    int iOpen = -1, iPlace;
+
+    au32Budget[PLACE_SPIM] = SPIM_DMM_SIZE;
+    au32Budget[PLACE_SRAM] = (argc > 6) ? (uint32_t)strtoul(argv[6], NULL, 0) : 4096;
+    au32Budget[PLACE_FLASH] = (argc > 7) ? (uint32_t)strtoul(argv[7], NULL, 0) : 16384;
+
+    LoadSymbols(argv[2]);
+    LoadProfile(argv[3]);
+
+    /* Read all of the script first, the output may replace it */
+    fp = OpenFile(argv[4], "r");
+    while (fgets(acLine, sizeof(acLine), fp) != NULL)
+    {
+        if (u32Lines == u32Alloc)
+        {
+            u32Alloc = u32Alloc ? (u32Alloc * 2) : 256;
+            ppcLine = realloc(ppcLine, u32Alloc * sizeof(char *));
+        }
+        ppcLine[u32Lines++] = strdup(acLine);
+
+        /* Functions placed by an earlier run stay movable */
+        if (iOpen >= 0)
+        {
+            if (Marker(acLine, "END") == iOpen)
+                iOpen = -1;
+            else if (((pc = strstr(acLine, "*(.text.")) != NULL) && (sscanf(pc + 8, "%127[^) ]", acName) == 1) &&
+                     ((psFunc = FindName(acName)) != NULL))
+                psFunc->iMovable = 1;
+        }
+        else
+        {
+            iOpen = Marker(acLine, "BEGIN");
+        }
+    }
+    fclose(fp);
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < u32Lines; j++)
+        {
+            if (Marker(ppcLine[j], "BEGIN") == (int)i)
+                break;
+        }
+        while ((j < u32Lines) && (Marker(ppcLine[j], "END") != (int)i))
+            j++;
+        if (j == u32Lines)
+        {
+            fprintf(stderr, "%s: no XIP_PLACE_%s_BEGIN and _END markers\n", argv[4], s_apcMarker[i]);
+            return 1;
+        }
+    }
+
+    /* Candidates by samples per byte; a handful of samples is noise */
+    u32Min = (s_u32Samples * MIN_SHARE) / 1000;
+    if (u32Min < 2)
+        u32Min = 2;
+
+    ppsRank = malloc(s_u32Funcs * sizeof(FUNC_T *));
+    for (i = 0; i < s_u32Funcs; i++)
+    {
+        if (s_psFunc[i].iMovable && (s_psFunc[i].u32Samples >= u32Min))
+            ppsRank[u32Cand++] = &s_psFunc[i];
+    }
+    qsort(ppsRank, u32Cand, sizeof(FUNC_T *), ByDensity);
+
+    for (i = 0; i < u32Cand; i++)
+    {
+        /* 8 bytes of slack per function for alignment and veneers */
+        for (iPlace = PLACE_SRAM; iPlace <= PLACE_FLASH; iPlace++)
+        {
+            if ((au32Used[iPlace] + ppsRank[i]->u32Size + 8) <= au32Budget[iPlace])
+                break;
+        }
+        if (iPlace > PLACE_FLASH)
+            iPlace = PLACE_SPIM;
+
+        ppsRank[i]->iPlace = iPlace;
+        au32Used[iPlace] += ppsRank[i]->u32Size + 8;
+        au32Cnt[iPlace]++;
+        au32Hits[iPlace] += ppsRank[i]->u32Samples;
+    }
+
+    /* The warm list in SPIM goes hottest first */
+    qsort(ppsRank, u32Cand, sizeof(FUNC_T *), BySamples);
+
+    fp = OpenFile(argv[5], "w");
+    for (j = 0; j < u32Lines; j++)
+    {
+        if ((iOpen = Marker(ppcLine[j], "BEGIN")) < 0)
+        {
+            fputs(ppcLine[j], fp);
+            continue;
+        }
+
+        fputs(ppcLine[j], fp);
+        for (i = 0; i < u32Cand; i++)
+        {
+            if (ppsRank[i]->iPlace != iOpen)
+                continue;
+            fprintf(fp, "%.*s*(.text.%s)\t/* %u samples, %u bytes */\n", (int)strspn(ppcLine[j], " \t"), ppcLine[j],
+                    ppsRank[i]->acName, ppsRank[i]->u32Samples, ppsRank[i]->u32Size);
+        }
+
+        /* Skip what an earlier run generated */
+        while (((j + 1) < u32Lines) && (Marker(ppcLine[j + 1], "END") != iOpen))
+            j++;
+    }
+    fclose(fp);
+
+    printf("%u samples, %u candidate functions with at least %u each\n", s_u32Samples, u32Cand, u32Min);
+    for (i = PLACE_SRAM; i <= PLACE_FLASH; i++)
+    {
+        printf("%-5s %3u functions, %6u of %6u bytes, %5.1f%% of the samples\n", s_apcMarker[i], au32Cnt[i],
+               au32Used[i], au32Budget[i], au32Hits[i] * 100.0 / s_u32Samples);
+    }
+    printf("SPIM  %3u sampled functions left, hottest first, %5.1f%% of the samples\n", au32Cnt[PLACE_SPIM],
+           au32Hits[PLACE_SPIM] * 100.0 / s_u32Samples);
+    printf("Wrote %s\n", argv[5]);
+
+    for (j = 0; j < u32Lines; j++)
+        free(ppcLine[j]);
+    free(ppcLine);
+    free(ppsRank);
+    return 0;
+}
+
+static uint32_t LoadBench(const char *pcPath, BENCH_T *psBench)
+{
+    char acLine[LINE_SIZE], *pc;
+    uint32_t n = 0;
+    FILE *fp = OpenFile(pcPath, "r");
+
+    while ((n < MAX_BENCH) && (fgets(acLine, sizeof(acLine), fp) != NULL))
+    {
+        if ((pc = strstr(acLine, "XIP_BENCH ")) == NULL)
+            continue;
+        if (sscanf(pc + 10, "%127s %u %x", psBench[n].acName, &psBench[n].u32Cycles, &psBench[n].u32Sum) == 3)
+            n++;
+    }
+    fclose(fp);
+
+    if (n == 0)
+    {
+        fprintf(stderr, "%s: no XIP_BENCH lines\n", pcPath);
+        exit(1);
+    }
+
+    return n;
+}
+
+static int Compare(char *argv[])
+{
+    static BENCH_T asBefore[MAX_BENCH], asAfter[MAX_BENCH];
+    uint32_t i, j, u32Before, u32After;
+    int iRet = 0;
+
+    u32Before = LoadBench(argv[2], asBefore);
+    u32After = LoadBench(argv[3], asAfter);
+
+    printf("case          before      after    change\n");
+    for (i = 0; i < u32Before; i++)
+    {
+        for (j = 0; (j < u32After) && (strcmp(asBefore[i].acName, asAfter[j].acName) != 0); j++)
+        {
+        }
+
+        if (j == u32After)
+        {
+            printf("%-10s %9u          -\n", asBefore[i].acName, asBefore[i].u32Cycles);
+            continue;
+        }
+
+        printf("%-10s %9u  %9u  %+7.1f%%  %.2fx", asBefore[i].acName, asBefore[i].u32Cycles, asAfter[j].u32Cycles,
+               (asAfter[j].u32Cycles * 100.0 / asBefore[i].u32Cycles) - 100.0,
+               asAfter[j].u32Cycles ? ((double)asBefore[i].u32Cycles / asAfter[j].u32Cycles) : 0.0);
+
+        if (asBefore[i].u32Sum != asAfter[j].u32Sum)
+        {
+            printf("  checksum %08X != %08X", asBefore[i].u32Sum, asAfter[j].u32Sum);
+            iRet = 1;
+        }
+        printf("\n");
+    }
+
+    return iRet;
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc >= 4) && (strcmp(argv[1], "hot") == 0))
+        return Hot(argc, argv);
+
+    if ((argc >= 6) && (strcmp(argv[1], "ldgen") == 0))
+        return LdGen(argc, argv);
+
+    if ((argc == 4) && (strcmp(argv[1], "compare") == 0))
+        return Compare(argv);
+
+    fprintf(stderr, "Usage: %s hot     symbols.txt uart.log [count]\n"
+            "       %s ldgen   symbols.txt uart.log in.ld out.ld [sram [flash]]\n"
+            "       %s compare before.log after.log\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,303 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Profile-guided code placement between internal memory and SPIM
+ *           direct-map (execute-in-place) flash, with a benchmark of the result.
+ *
+ * @details  GCC/spim_dmm_placement.ld keeps start-up, drivers, libraries and this
+ *           file in APROM and links the rest (workload.c) to SPIM DMM at 0x100000.
+ *           The SPIM part is stored in APROM as well; this sample copies it to the
+ *           SPI flash when it differs, then runs the benchmark and the profiler.
+ *           1. Build and run as shipped, save the UART output as base.log.
+ *           2. arm-none-eabi-nm -S -n SPIM_DMM_Placement.elf > symbols.txt
+ *           3. HostTool/xip_place ldgen symbols.txt base.log \
+ *                  GCC/spim_dmm_placement.ld GCC/spim_dmm_placement.ld
+ *              moves the hottest functions to SRAM and APROM within the budgets.
+ *           4. Rebuild and run, save placed.log, then
+ *              HostTool/xip_place compare base.log placed.log
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "xip_prof.h"
+#include "workload.h"
+
+#define USE_4_BYTES_MODE            0            /* W25Q20 does not support 4-bytes address mode. */
+#define MFP_SELECT                  0            /* Multi-function pin select                     */
+
+#define FLASH_BLOCK_SIZE            (64*1024)    /* Flash block size. Depend on the physical flash. */
+#define FLASH_PAGE_SIZE             256
+
+#define WORKLOAD_SEED               0x2023
+#define BENCH_CALLS                 200          /* Calls timed per benchmark case */
+#define PROFILE_FRAMES              20000        /* Frames run under the profiler */
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t (*pfnRun)(void);
+} BENCH_T;
+
+static const BENCH_T s_asBench[] =
+{
+    { "crc",    WL_Crc    },
+    { "fir",    WL_Fir    },
+    { "sort",   WL_Sort   },
+    { "format", WL_Format },
+    { "frame",  WL_Frame  },
+};
+
+/* SPIM part of the image: linked at SPIM_DMM_MAP_ADDR, stored in APROM behind the rest */
+extern uint32_t __spim_text_start__;
+extern uint32_t __spim_text_end__;
+extern uint32_t __spim_text_load__;
+
+static uint8_t s_au8Page[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(FREQ_200MHZ);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable SPIM module clock */
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+#if MFP_SELECT
+    /* Init SPIM multi-function pins, MOSI(PE.2), MISO(PE.3), CLK(PE.4), SS(PE.5), D3(PE.6), and D2(PE.7) */
+    SET_SPIM_MOSI_PE2();
+    SET_SPIM_MISO_PE3();
+    SET_SPIM_CLK_PE4();
+    SET_SPIM_SS_PE5();
+    SET_SPIM_D3_PE6();
+    SET_SPIM_D2_PE7();
+
+    PE->SMTEN |= GPIO_SMTEN_SMTEN4_Msk;
+
+    /* Set SPIM I/O pins as high slew rate up to 80 MHz. */
+    PE->SLEWCTL = (PE->SLEWCTL & 0xFFFF000F) |
+                  (0x1<<GPIO_SLEWCTL_HSREN2_Pos) | (0x1<<GPIO_SLEWCTL_HSREN3_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN4_Pos) | (0x1<<GPIO_SLEWCTL_HSREN5_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN6_Pos) | (0x1<<GPIO_SLEWCTL_HSREN7_Pos);
+#else
+    /* Init SPIM multi-function pins, MOSI(PJ.1), MISO(PI.13), CLK(PJ.0), SS(PI.12), D3(PI.15), and D2(PI.14) */
+    SET_SPIM_MOSI_PJ1();
+    SET_SPIM_MISO_PI13();
+    SET_SPIM_CLK_PJ0();
+    SET_SPIM_SS_PI12();
+    SET_SPIM_D3_PI15();
+    SET_SPIM_D2_PI14();
+
+    PJ->SMTEN |= GPIO_SMTEN_SMTEN0_Msk;
+
+    /* Set SPIM I/O pins as high slew rate up to 80 MHz. */
+    PI->SLEWCTL = (PE->SLEWCTL & 0x0CFFFFFF) |
+                  (0x1<<GPIO_SLEWCTL_HSREN12_Pos) | (0x1<<GPIO_SLEWCTL_HSREN14_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN15_Pos) ;
+    PJ->SLEWCTL = (PE->SLEWCTL & 0xF3FFFFF0) |
+                  (0x1<<GPIO_SLEWCTL_HSREN0_Pos) | (0x1<<GPIO_SLEWCTL_HSREN1_Pos) |
+                  (0x1<<GPIO_SLEWCTL_HSREN13_Pos) ;
+#endif
+
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+static const char *Where(uint32_t u32Addr)
+{
+    if ((u32Addr >= SPIM_DMM_MAP_ADDR) && (u32Addr < (SPIM_DMM_MAP_ADDR + SPIM_DMM_SIZE)))
+        return "SPIM";
+    else if (u32Addr >= 0x20000000)
+        return "SRAM";
+    else
+        return "APROM";
+}
+
+/*
+ *  Copy the SPIM part of the image to the SPI flash, unless it is there already
+ */
+static int32_t SpimImageSync(void)
+{
+    uint32_t u32Size = (uint32_t)&__spim_text_end__ - (uint32_t)&__spim_text_start__;
+    uint32_t u32Flash = (uint32_t)&__spim_text_start__ - SPIM_DMM_MAP_ADDR;
+    uint8_t *pu8Load = (uint8_t *)&__spim_text_load__;
+    uint32_t i, u32Len, u32Pass;
+
+    for (u32Pass = 0; u32Pass < 2; u32Pass++)
+    {
+        for (i = 0; i < u32Size; i += FLASH_PAGE_SIZE)
+        {
+            u32Len = ((u32Size - i) < FLASH_PAGE_SIZE) ? (u32Size - i) : FLASH_PAGE_SIZE;
+            SPIM_DMA_Read(u32Flash + i, USE_4_BYTES_MODE, u32Len, s_au8Page, CMD_DMA_FAST_READ, 1);
+            if (memcmp(s_au8Page, &pu8Load[i], u32Len) != 0)
+                break;
+        }
+
+        if (i >= u32Size)
+        {
+            printf("SPIM image: %u bytes at 0x%08X, %s\n", u32Size, (uint32_t)&__spim_text_start__,
+                   (u32Pass == 0) ? "up to date" : "programmed");
+            return 0;
+        }
+
+        if (u32Pass != 0)
+            break;
+
+        printf("SPIM image: programming %u bytes...", u32Size);
+        for (i = u32Flash & ~(FLASH_BLOCK_SIZE - 1); i < (u32Flash + u32Size); i += FLASH_BLOCK_SIZE)
+            SPIM_EraseBlock(i, USE_4_BYTES_MODE, OPCODE_BE_64K, 1, 1);
+
+        /* SPIM DMA reads SRAM: go through a page buffer */
+        for (i = 0; i < u32Size; i += FLASH_PAGE_SIZE)
+        {
+            u32Len = ((u32Size - i) < FLASH_PAGE_SIZE) ? (u32Size - i) : FLASH_PAGE_SIZE;
+            memcpy(s_au8Page, &pu8Load[i], u32Len);
+            SPIM_DMA_Write(u32Flash + i, USE_4_BYTES_MODE, u32Len, s_au8Page, CMD_NORMAL_PAGE_PROGRAM);
+        }
+        printf("done.\n");
+    }
+
+    printf("SPIM image: verify failed at offset 0x%X!\n", i);
+    return -1;
+}
+
+static void Benchmark(void)
+{
+    uint32_t i, j, u32Start, u32Cycles, u32Sum;
+
+    printf("\nFunction placement:\n");
+    for (i = 0; i < sizeof(s_asBench) / sizeof(s_asBench[0]); i++)
+        printf("  %-8s 0x%08X  %s\n", s_asBench[i].pcName, (uint32_t)s_asBench[i].pfnRun, Where((uint32_t)s_asBench[i].pfnRun));
+
+    printf("\nBenchmark, cycles per call (%u calls):\n", BENCH_CALLS);
+    for (i = 0; i < sizeof(s_asBench) / sizeof(s_asBench[0]); i++)
+    {
+        WL_Init(WORKLOAD_SEED);
+        u32Sum = s_asBench[i].pfnRun();     /* Warm the cache up */
+
+        u32Start = XIP_PROF_CYCLES();
+        for (j = 0; j < BENCH_CALLS; j++)
+            u32Sum += s_asBench[i].pfnRun();
+        u32Cycles = (XIP_PROF_CYCLES() - u32Start) / BENCH_CALLS;
+
+        /* The checksum must not depend on the placement */
+        printf("XIP_BENCH %s %u %08X\n", s_asBench[i].pcName, u32Cycles, u32Sum);
+    }
+}
+
+static void Profile(void)
+{
+    uint32_t i, u32Start;
+
+    printf("\nProfiling %u frames at %u Hz...\n", PROFILE_FRAMES, XIP_PROF_RATE);
+
+    WL_Init(WORKLOAD_SEED);
+    u32Start = XIP_PROF_CYCLES();
+    XIP_PROF_Start();
+    for (i = 0; i < PROFILE_FRAMES; i++)
+        WL_Frame();
+    XIP_PROF_Stop();
+    printf("%u cycles\n", XIP_PROF_CYCLES() - u32Start);
+
+    XIP_PROF_Dump();
+}
+
+int main()
+{
+    uint8_t     idBuf[3];
+
+    SYS_UnlockReg();                   /* Unlock protected registers */
+
+    SYS_Init();                        /* Init System, IP clock and multi-function I/O    */
+
+    UART0_Init();                      /* Initialize UART0                                */
+
+    printf("+--------------------------------------------------+\n");
+    printf("|    M460 SPIM DMM profile-guided code placement   |\n");
+    printf("+--------------------------------------------------+\n");
+
+    SPIM_SET_CLOCK_DIVIDER(2);        /* Set SPIM clock as HCLK divided by 4 */
+
+    SPIM_SET_RXCLKDLY_RDDLYSEL(0);    /* Insert 0 delay cycle. Adjust the sampling clock of received data to latch the correct data. */
+    SPIM_SET_RXCLKDLY_RDEDGE();       /* Use SPI input clock rising edge to sample received data. */
+
+    SPIM_SET_DCNUM(8);                /* 8 is the default value. */
+
+    if (SPIM_InitFlash(1) != 0)        /* Initialized SPI flash */
+    {
+        printf("SPIM flash initialize failed!\n");
+        goto lexit;
+    }
+
+    SPIM_ReadJedecId(idBuf, sizeof (idBuf), 1);
+    printf("SPIM get JEDEC ID=0x%02X, 0x%02X, 0x%02X\n", idBuf[0], idBuf[1], idBuf[2]);
+
+    SPIM_DISABLE_CCM();
+    SPIM_DISABLE_CIPHER();
+
+    if (SPIM_Enable_4Bytes_Mode(USE_4_BYTES_MODE, 1) != 0)
+    {
+        printf("SPIM_Enable_4Bytes_Mode failed!\n");
+        goto lexit;
+    }
+
+    if (SpimImageSync() != 0)
+        goto lexit;
+
+    SPIM_ENABLE_CACHE();
+    SPIM->CTL1 |= SPIM_CTL1_CDINVAL_Msk;        /* Invalidate the cache, the flash was rewritten */
+
+    SPIM_EnterDirectMapMode(USE_4_BYTES_MODE, CMD_DMA_FAST_READ, 0);
+
+    XIP_PROF_Init();
+
+    if (WL_Init(WORKLOAD_SEED) != 0)
+    {
+        printf("Workload self test failed!\n");
+        goto lexit;
+    }
+
+    Benchmark();
+    Profile();
+
+    printf("\nDone.\n");
+
+lexit:
+
+    SYS_LockReg();                     /* Lock protected registers */
+    while (1);
+}
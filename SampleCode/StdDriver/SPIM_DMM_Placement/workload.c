@@ -0,0 +1,224 @@
+/***************************************************************************//**
+ * @file     workload.c
+ * @version  V1.00
+ * @brief    Workload profiled and benchmarked by the SPIM DMM placement sample.
+ *
+ * @details  A frame of a small data path: checksum, filter, sort and report,
+ *           with housekeeping every few frames and set-up code that runs once.
+ *           Nothing here is pinned by the linker script: where each function
+ *           runs from is what the generated placement decides.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "workload.h"
+
+static uint8_t  s_au8Data[WL_BUF_SIZE];
+static int16_t  s_ai16In[WL_BUF_SIZE / 2];
+static int16_t  s_ai16Out[WL_BUF_SIZE / 2];
+static int16_t  s_ai16Coef[WL_FIR_TAPS];
+static int32_t  s_ai32Keys[WL_SORT_COUNT];
+static int32_t  s_ai32Sort[WL_SORT_COUNT];
+static char     s_acText[256];
+static uint32_t s_u32Seed;
+static uint32_t s_u32Frames;
+
+/*--------------------------------------------------------------------------*/
+static uint32_t Rand(void)
+{
+    s_u32Seed = s_u32Seed * 1664525UL + 1013904223UL;
+    return s_u32Seed;
+}
+
+/* Reflected CRC-32, bit by bit: small code, long loop */
+static uint32_t Crc32(const uint8_t *pu8Buf, uint32_t u32Len, uint32_t u32Crc)
+{
+    uint32_t i;
+
+    u32Crc = ~u32Crc;
+    while (u32Len--)
+    {
+        u32Crc ^= *pu8Buf++;
+        for (i = 0; i < 8; i++)
+            u32Crc = (u32Crc >> 1) ^ (0xEDB88320UL & (0UL - (u32Crc & 1UL)));
+    }
+
+    return ~u32Crc;
+}
+
+/* Q15 FIR over the input block */
+static void Fir(const int16_t *pi16In, int16_t *pi16Out, uint32_t u32Len)
+{
+    uint32_t i, j;
+    int32_t i32Acc;
+
+    for (i = WL_FIR_TAPS - 1; i < u32Len; i++)
+    {
+        i32Acc = 0;
+        for (j = 0; j < WL_FIR_TAPS; j++)
+            i32Acc += (int32_t)pi16In[i - j] * s_ai16Coef[j];
+
+        i32Acc >>= 15;
+        if (i32Acc > 32767)
+            i32Acc = 32767;
+        else if (i32Acc < -32768)
+            i32Acc = -32768;
+        pi16Out[i] = (int16_t)i32Acc;
+    }
+}
+
+/* Shell sort with Ciura's gaps */
+static void Sort(int32_t *pi32Buf, uint32_t u32Len)
+{
+    static const uint16_t au16Gap[] = { 57, 23, 10, 4, 1 };
+    uint32_t g, i, j, u32Gap;
+    int32_t i32Key;
+
+    for (g = 0; g < sizeof(au16Gap) / sizeof(au16Gap[0]); g++)
+    {
+        u32Gap = au16Gap[g];
+        for (i = u32Gap; i < u32Len; i++)
+        {
+            i32Key = pi32Buf[i];
+            for (j = i; (j >= u32Gap) && (pi32Buf[j - u32Gap] > i32Key); j -= u32Gap)
+                pi32Buf[j] = pi32Buf[j - u32Gap];
+            pi32Buf[j] = i32Key;
+        }
+    }
+}
+
+static char *PutDec(char *pcBuf, int32_t i32Val)
+{
+    char acTmp[12];
+    uint32_t u32Val, n = 0;
+
+    if (i32Val < 0)
+    {
+        *pcBuf++ = '-';
+        u32Val = 0UL - (uint32_t)i32Val;
+    }
+    else
+    {
+        u32Val = (uint32_t)i32Val;
+    }
+
+    do
+    {
+        acTmp[n++] = (char)('0' + (u32Val % 10));
+        u32Val /= 10;
+    } while (u32Val != 0);
+
+    while (n != 0)
+        *pcBuf++ = acTmp[--n];
+
+    return pcBuf;
+}
+
+static char *PutHex(char *pcBuf, uint32_t u32Val)
+{
+    static const char acDigit[] = "0123456789ABCDEF";
+    int32_t i;
+
+    for (i = 28; i >= 0; i -= 4)
+        *pcBuf++ = acDigit[(u32Val >> i) & 0xF];
+
+    return pcBuf;
+}
+
+/* Report line of the sorted keys: "min, median, max" and a checksum */
+static uint32_t Report(void)
+{
+    char *pc = s_acText;
+
+    memcpy(pc, "keys ", 5);
+    pc = PutDec(pc + 5, s_ai32Sort[0]);
+    *pc++ = ' ';
+    pc = PutDec(pc, s_ai32Sort[WL_SORT_COUNT / 2]);
+    *pc++ = ' ';
+    pc = PutDec(pc, s_ai32Sort[WL_SORT_COUNT - 1]);
+    memcpy(pc, " crc ", 5);
+    pc = PutHex(pc + 5, Crc32((const uint8_t *)s_ai32Sort, sizeof(s_ai32Sort), 0));
+    *pc = '\0';
+
+    return (uint32_t)(pc - s_acText);
+}
+
+/* Every few frames: age the coefficients and reseed part of the data */
+static void Housekeeping(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < WL_FIR_TAPS; i++)
+        s_ai16Coef[i] = (int16_t)((s_ai16Coef[i] * 31) / 32 + (int16_t)(Rand() >> 28));
+
+    for (i = 0; i < 64; i++)
+        s_au8Data[Rand() % WL_BUF_SIZE] = (uint8_t)Rand();
+}
+
+/*--------------------------------------------------------------------------*/
+/* Set-up: runs once, cold by construction */
+int32_t WL_Init(uint32_t u32Seed)
+{
+    uint32_t i;
+
+    s_u32Seed = u32Seed;
+    s_u32Frames = 0;
+
+    for (i = 0; i < WL_BUF_SIZE; i++)
+        s_au8Data[i] = (uint8_t)(Rand() >> 24);
+
+    for (i = 0; i < WL_BUF_SIZE / 2; i++)
+        s_ai16In[i] = (int16_t)(Rand() >> 16);
+
+    /* Low-pass window, sums to about 0.9 in Q15 */
+    for (i = 0; i < WL_FIR_TAPS; i++)
+        s_ai16Coef[i] = (int16_t)(1200 + 40 * ((i < WL_FIR_TAPS / 2) ? i : (WL_FIR_TAPS - 1 - i)));
+
+    for (i = 0; i < WL_SORT_COUNT; i++)
+        s_ai32Keys[i] = (int32_t)Rand();
+
+    /* Check value of the standard CRC-32 test vector */
+    return (Crc32((const uint8_t *)"123456789", 9, 0) == 0xCBF43926UL) ? 0 : -1;
+}
+
+uint32_t WL_Crc(void)
+{
+    return Crc32(s_au8Data, WL_BUF_SIZE, 0);
+}
+
+uint32_t WL_Fir(void)
+{
+    Fir(s_ai16In, s_ai16Out, WL_BUF_SIZE / 2);
+
+    return Crc32((const uint8_t *)&s_ai16Out[WL_FIR_TAPS - 1], 32, 0);
+}
+
+uint32_t WL_Sort(void)
+{
+    memcpy(s_ai32Sort, s_ai32Keys, sizeof(s_ai32Sort));
+    Sort(s_ai32Sort, WL_SORT_COUNT);
+
+    return (uint32_t)s_ai32Sort[WL_SORT_COUNT / 2];
+}
+
+uint32_t WL_Format(void)
+{
+    return Report();
+}
+
+/* One frame of the data path */
+uint32_t WL_Frame(void)
+{
+    uint32_t u32Sum;
+
+    if ((++s_u32Frames % 16) == 0)
+        Housekeeping();
+
+    u32Sum = WL_Crc();
+    u32Sum += WL_Fir();
+    u32Sum += WL_Sort();
+    u32Sum += WL_Format();
+
+    return u32Sum;
+}
@@ -0,0 +1,26 @@
+/***************************************************************************//**
+ * @file     workload.h
+ * @version  V1.00
+ * @brief    Workload profiled and benchmarked by the SPIM DMM placement sample.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __WORKLOAD_H__
+#define __WORKLOAD_H__
+
+#include <stdint.h>
+
+#define WL_BUF_SIZE         1024
+#define WL_FIR_TAPS         24
+#define WL_SORT_COUNT       128
+
+/*-------------------------------------------------------------*/
+int32_t WL_Init(uint32_t u32Seed);
+uint32_t WL_Crc(void);
+uint32_t WL_Fir(void);
+uint32_t WL_Sort(void);
+uint32_t WL_Format(void);
+uint32_t WL_Frame(void);
+
+#endif  /* __WORKLOAD_H__ */
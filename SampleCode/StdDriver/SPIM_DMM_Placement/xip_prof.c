@@ -0,0 +1,125 @@
+/***************************************************************************//**
+ * @file     xip_prof.c
+ * @version  V1.00
+ * @brief    PC-sampling profiler and DWT cycle counter of the SPIM DMM placement sample.
+ *
+ * @details  TIMER0 interrupts at XIP_PROF_RATE and records the PC the interrupt
+ *           stacked, one counter per distinct address. XIP_PROF_Dump() prints the
+ *           counters for HostTool/xip_place, which maps them to functions.
+ *           The linker script keeps this file in internal flash: a sampler that
+ *           ran from SPIM would skew the profile of the code it measures.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "xip_prof.h"
+
+/* Slots tried per sample: a long probe would cost the code being measured */
+#define XIP_PROF_PROBES     16
+
+typedef struct
+{
+    uint32_t u32Pc;
+    uint32_t u32Cnt;
+} XIP_PROF_SLOT_T;
+
+static XIP_PROF_SLOT_T s_asSlot[XIP_PROF_SLOTS];
+static volatile uint32_t s_u32Samples;
+static volatile uint32_t s_u32Dropped;
+
+/*--------------------------------------------------------------------------*/
+/* The stacked PC is at offset 24 of the exception frame, on the stack EXC_RETURN names */
+void TMR0_IRQHandler(void) __attribute__((naked));
+void TMR0_IRQHandler(void)
+{
+    __asm volatile(
+        "tst    lr, #4              \n"
+        "ite    eq                  \n"
+        "mrseq  r0, msp             \n"
+        "mrsne  r0, psp             \n"
+        "ldr    r0, [r0, #24]       \n"
+        "b      XIP_PROF_Sample     \n");
+}
+
+/* Tail of the interrupt handler; returns from the exception */
+void XIP_PROF_Sample(uint32_t u32Pc)
+{
+    uint32_t i, u32Idx;
+
+    TIMER_ClearIntFlag(TIMER0);
+
+    s_u32Samples++;
+
+    /* Open addressing on the halfword address */
+    u32Idx = ((u32Pc >> 1) * 2654435761UL) >> (32 - XIP_PROF_SLOT_BITS);
+    for (i = 0; i < XIP_PROF_PROBES; i++, u32Idx = (u32Idx + 1) & (XIP_PROF_SLOTS - 1))
+    {
+        if (s_asSlot[u32Idx].u32Pc == u32Pc)
+        {
+            s_asSlot[u32Idx].u32Cnt++;
+            return;
+        }
+        if (s_asSlot[u32Idx].u32Cnt == 0)
+        {
+            s_asSlot[u32Idx].u32Pc = u32Pc;
+            s_asSlot[u32Idx].u32Cnt = 1;
+            return;
+        }
+    }
+
+    s_u32Dropped++;
+}
+
+/*--------------------------------------------------------------------------*/
+void XIP_PROF_Init(void)
+{
+    /* DWT cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    CLK_EnableModuleClock(TMR0_MODULE);
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HIRC, 0);
+}
+
+void XIP_PROF_Start(void)
+{
+    memset(s_asSlot, 0, sizeof(s_asSlot));
+    s_u32Samples = 0;
+    s_u32Dropped = 0;
+
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, XIP_PROF_RATE);
+    TIMER_EnableInt(TIMER0);
+
+    /* Above everything else, so interrupt handlers are sampled as well */
+    NVIC_SetPriority(TMR0_IRQn, 0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+    TIMER_Start(TIMER0);
+}
+
+void XIP_PROF_Stop(void)
+{
+    TIMER_Stop(TIMER0);
+    NVIC_DisableIRQ(TMR0_IRQn);
+    TIMER_ClearIntFlag(TIMER0);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Format read by HostTool/xip_place: a BEGIN line, one line per address, an END line */
+void XIP_PROF_Dump(void)
+{
+    uint32_t i;
+
+    printf("XIP_PROF BEGIN %u %u\n", s_u32Samples, s_u32Dropped);
+
+    for (i = 0; i < XIP_PROF_SLOTS; i++)
+    {
+        if (s_asSlot[i].u32Cnt != 0)
+            printf("XIP_PROF %08X %u\n", s_asSlot[i].u32Pc, s_asSlot[i].u32Cnt);
+    }
+
+    printf("XIP_PROF END\n");
+}
@@ -0,0 +1,32 @@
+/***************************************************************************//**
+ * @file     xip_prof.h
+ * @version  V1.00
+ * @brief    PC-sampling profiler and DWT cycle counter of the SPIM DMM placement sample.
+ *
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ * @copyright Copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __XIP_PROF_H__
+#define __XIP_PROF_H__
+
+#include "NuMicro.h"
+
+/* Distinct sampled addresses kept; further ones are counted as dropped */
+#define XIP_PROF_SLOT_BITS  10
+#define XIP_PROF_SLOTS      (1 << XIP_PROF_SLOT_BITS)
+
+/* Sampling rate, not a divisor of common loop rates so samples do not lock onto one phase */
+#define XIP_PROF_RATE       9973
+
+/*-------------------------------------------------------------*/
+/* Cycle counter, running after XIP_PROF_Init() */
+#define XIP_PROF_CYCLES()   (DWT->CYCCNT)
+
+/*-------------------------------------------------------------*/
+void XIP_PROF_Init(void);
+void XIP_PROF_Start(void);
+void XIP_PROF_Stop(void);
+void XIP_PROF_Dump(void);
+void XIP_PROF_Sample(uint32_t u32Pc);
+
+#endif  /* __XIP_PROF_H__ */
@@ -0,0 +1,119 @@
+/*-----------------------------------------------------------------------*/
+/* Low level disk I/O module skeleton for FatFs     (C)ChaN, 2013        */
+/*-----------------------------------------------------------------------*/
+/* If a working storage control module is available, it should be        */
+/* attached to the FatFs via a glue function rather than modifying it.   */
+/* This is an example of glue functions to attach various exsisting      */
+/* storage control module to the FatFs module with a defined API.        */
+/*-----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "diskio.h"     /* FatFs lower layer API */
+#include "ff.h"
+
+#define SPIM_DRIVE      0        /* SPI NOR flash behind SPIM, through the FTL */
+
+/* Mounted by the application before f_mount() */
+extern SPIM_FTL_T *g_psFtl;
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    return disk_status(pdrv);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    if ((pdrv != SPIM_DRIVE) || (g_psFtl == NULL))
+        return STA_NODISK;
+
+    if (!g_psFtl->u32Mounted)
+        return STA_NOINIT;
+
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+
+    return (SPIM_FtlRead(g_psFtl, sector, buff, count) == SPIM_OK) ? RES_OK : RES_ERROR;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+
+    return (SPIM_FtlWrite(g_psFtl, sector, buff, count) == SPIM_OK) ? RES_OK : RES_ERROR;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE cmd,       /* Control code */
+    void *buff      /* Buffer to send/receive control data */
+)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        /* Writes are committed when disk_write() returns; this waits for the background erases */
+        return (SPIM_FtlSync(g_psFtl) == SPIM_OK) ? RES_OK : RES_ERROR;
+
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = SPIM_FtlGetSectorCount(g_psFtl);
+        return RES_OK;
+
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = SPIM_FTL_SECTOR_SIZE;
+        return RES_OK;
+
+    case GET_BLOCK_SIZE:
+        /* Sectors are remapped one by one, alignment does not matter */
+        *(DWORD *)buff = 1;
+        return RES_OK;
+
+    default:
+        return RES_PARERR;
+    }
+}
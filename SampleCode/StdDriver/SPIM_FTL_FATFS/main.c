@@ -0,0 +1,330 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    A FAT volume on the SPI NOR flash behind SPIM, through the wear
+ *           leveling flash translation layer.
+ *
+ * @details  diskio.c binds FatFs drive 0 to the FTL (SPIM_FtlRead(),
+ *           SPIM_FtlWrite(), SPIM_FtlSync()), which remaps each 512 byte
+ *           sector so the FAT and directory sectors are not erased in place
+ *           at each f_sync(). The FTL manages FTL_BLOCKS blocks of 4 KB from
+ *           FTL_BASE; a flash without a FAT volume there is formatted FAT12.
+ *           Each boot appends a line to BOOT.TXT. Keys:
+ *               'a'  append LOG_BURST records to LOG.CSV, each one synced
+ *               'r'  read LOG.CSV back and check the records
+ *               'd'  delete LOG.CSV
+ *               's'  FTL statistics and erase counts
+ *           The host check of the FTL and this diskio.c is
+ *           SampleCode/HostSim/SPIM_FTL.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "diskio.h"
+#include "ff.h"
+
+#define FTL_BASE            0x100000UL      /* Flash area of the FTL, block aligned */
+#define FTL_BLOCKS          256UL           /* 1 MB */
+#define FTL_SPARE           16UL            /* Blocks kept back for garbage collection */
+#define LOG_BURST           100UL
+#define REC_SIZE            32UL
+
+/* Engine, FTL and FatFs buffers are moved by SPIM DMA: keep them in SRAM */
+static SPIM_PRG_T s_sPrg;
+static SPIM_FTL_T s_sFtl;
+static FATFS s_sFs;
+static FIL s_sFile;
+#ifdef __ICCARM__
+#pragma data_alignment=4
+static uint8_t s_au8Sec[SPIM_FTL_SECTOR_SIZE];
+#else
+static uint8_t s_au8Sec[SPIM_FTL_SECTOR_SIZE] __attribute__((aligned(4)));
+#endif
+
+/* The FTL of drive 0, for diskio.c */
+SPIM_FTL_T *g_psFtl;
+
+void SYS_Init(void);
+void UART0_Init(void);
+
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 80MHz */
+    CLK_SetCoreClock(80000000);
+
+    /* Enable all GPIO clock */
+    CLK->AHBCLK0 |= CLK_AHBCLK0_GPACKEN_Msk | CLK_AHBCLK0_GPBCKEN_Msk | CLK_AHBCLK0_GPCCKEN_Msk | CLK_AHBCLK0_GPDCKEN_Msk |
+                    CLK_AHBCLK0_GPECKEN_Msk | CLK_AHBCLK0_GPFCKEN_Msk | CLK_AHBCLK0_GPGCKEN_Msk | CLK_AHBCLK0_GPHCKEN_Msk;
+    CLK->AHBCLK1 |= CLK_AHBCLK1_GPICKEN_Msk | CLK_AHBCLK1_GPJCKEN_Msk;
+
+    /* Enable UART0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+
+    /* Select UART0 module clock source as HIRC and UART0 module clock divider as 1 */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+
+    /* Enable SPIM module clock */
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+
+    /* Init SPIM multi-function pins, MOSI(PJ.1), MISO(PI.13), CLK(PJ.0), SS(PI.12), D3(PI.15), and D2(PI.14) */
+    SET_SPIM_MOSI_PJ1();
+    SET_SPIM_MISO_PI13();
+    SET_SPIM_CLK_PJ0();
+    SET_SPIM_SS_PI12();
+    SET_SPIM_D3_PI15();
+    SET_SPIM_D2_PI14();
+
+    PJ->SMTEN |= GPIO_SMTEN_SMTEN0_Msk;
+
+    /* Set SPIM I/O pins as high slew rate up to 80 MHz. */
+    PI->SLEWCTL = (PI->SLEWCTL & 0x0CFFFFFF) |
+                  (0x1 << GPIO_SLEWCTL_HSREN12_Pos) | (0x1 << GPIO_SLEWCTL_HSREN14_Pos) |
+                  (0x1 << GPIO_SLEWCTL_HSREN15_Pos);
+    PJ->SLEWCTL = (PJ->SLEWCTL & 0xFFFFFFF0) |
+                  (0x1 << GPIO_SLEWCTL_HSREN0_Pos) | (0x1 << GPIO_SLEWCTL_HSREN1_Pos);
+}
+
+void UART0_Init(void)
+{
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+DWORD get_fattime(void)
+{
+    /* No RTC: 2023-01-01 00:00:00 */
+    return ((DWORD)(2023 - 1980) << 25) | (1UL << 21) | (1UL << 16);
+}
+
+/* FatFs is built without f_mkfs(): lay out a FAT12 volume over all the sectors of the FTL */
+static int32_t Format(void)
+{
+    uint32_t u32Sectors = SPIM_FtlGetSectorCount(&s_sFtl);
+    uint32_t u32FatSz = ((u32Sectors + 2) * 3 / 2 + SPIM_FTL_SECTOR_SIZE - 1) / SPIM_FTL_SECTOR_SIZE;
+    uint32_t i;
+
+    memset(s_au8Sec, 0, SPIM_FTL_SECTOR_SIZE);
+    memcpy(&s_au8Sec[0], "\xEB\x3C\x90" "MSDOS5.0", 11);
+    s_au8Sec[11] = 0x00;
+    s_au8Sec[12] = 0x02;                    /* 512 bytes per sector */
+    s_au8Sec[13] = 1;                       /* 1 sector per cluster */
+    s_au8Sec[14] = 1;                       /* 1 reserved sector */
+    s_au8Sec[16] = 2;                       /* 2 FATs */
+    s_au8Sec[17] = 64;                      /* 64 root directory entries */
+    s_au8Sec[19] = (uint8_t)u32Sectors;
+    s_au8Sec[20] = (uint8_t)(u32Sectors >> 8);
+    s_au8Sec[21] = 0xF8;
+    s_au8Sec[22] = (uint8_t)u32FatSz;
+    s_au8Sec[24] = 63;
+    s_au8Sec[26] = 255;
+    s_au8Sec[36] = 0x80;
+    s_au8Sec[38] = 0x29;
+    memcpy(&s_au8Sec[43], "NO NAME    FAT12   ", 19);
+    s_au8Sec[510] = 0x55;
+    s_au8Sec[511] = 0xAA;
+    if(SPIM_FtlWrite(&s_sFtl, 0, s_au8Sec, 1) != SPIM_OK)
+        return SPIM_ERR_FAIL;
+
+    /* Both FATs and the root directory; the data area may stay as the FTL reads it */
+    for(i = 1; i < 1 + 2 * u32FatSz + 4; i++)
+    {
+        memset(s_au8Sec, 0, SPIM_FTL_SECTOR_SIZE);
+        if((i == 1) || (i == 1 + u32FatSz))
+            memcpy(s_au8Sec, "\xF8\xFF\xFF", 3);
+        if(SPIM_FtlWrite(&s_sFtl, i, s_au8Sec, 1) != SPIM_OK)
+            return SPIM_ERR_FAIL;
+    }
+
+    return SPIM_FtlSync(&s_sFtl);
+}
+
+static void Record(char *pcBuf, uint32_t u32Idx)
+{
+    sprintf(pcBuf, "%06u,%08X,sensor sample\n", u32Idx, u32Idx * 2654435761u);
+}
+
+static void AppendBoot(void)
+{
+    FILINFO sInfo;
+    char acLine[REC_SIZE];
+    UINT uLen;
+    uint32_t u32Boot = 1;
+
+    if(f_stat("0:/BOOT.TXT", &sInfo) == FR_OK)
+        u32Boot = (uint32_t)(sInfo.fsize / 12) + 1;
+
+    sprintf(acLine, "boot %06u\n", u32Boot);
+    if((f_open(&s_sFile, "0:/BOOT.TXT", FA_OPEN_APPEND | FA_WRITE) != FR_OK) ||
+            (f_write(&s_sFile, acLine, strlen(acLine), &uLen) != FR_OK) || (f_close(&s_sFile) != FR_OK))
+        printf("Cannot update BOOT.TXT\n");
+    else
+        printf("Boot %u of this volume\n", u32Boot);
+}
+
+static void AppendLog(void)
+{
+    char acRec[REC_SIZE];
+    uint32_t i, u32First, u32Writes;
+    UINT uLen;
+
+    if(f_open(&s_sFile, "0:/LOG.CSV", FA_OPEN_APPEND | FA_WRITE) != FR_OK)
+    {
+        printf("Cannot open LOG.CSV\n");
+        return;
+    }
+
+    Record(acRec, 0);
+    u32First = (uint32_t)(f_size(&s_sFile) / strlen(acRec));
+    u32Writes = s_sFtl.sStat.u32HostWrites;
+
+    /* A data logger: short records, each one on the flash before the next */
+    for(i = u32First; i < u32First + LOG_BURST; i++)
+    {
+        Record(acRec, i);
+        if((f_write(&s_sFile, acRec, strlen(acRec), &uLen) != FR_OK) || (uLen != strlen(acRec)) ||
+                (f_sync(&s_sFile) != FR_OK))
+        {
+            printf("Write of record %u failed\n", i);
+            break;
+        }
+    }
+    f_close(&s_sFile);
+
+    printf("Records %u..%u appended, %u sectors written\n", u32First, i - 1,
+           s_sFtl.sStat.u32HostWrites - u32Writes);
+}
+
+static void ReadLog(void)
+{
+    char acRec[REC_SIZE], acRd[REC_SIZE];
+    uint32_t i = 0, u32Bad = 0;
+    UINT uLen;
+
+    if(f_open(&s_sFile, "0:/LOG.CSV", FA_READ) != FR_OK)
+    {
+        printf("No LOG.CSV\n");
+        return;
+    }
+
+    for(;;)
+    {
+        Record(acRec, i);
+        if((f_read(&s_sFile, acRd, strlen(acRec), &uLen) != FR_OK) || (uLen == 0))
+            break;
+        if((uLen != strlen(acRec)) || (memcmp(acRd, acRec, uLen) != 0))
+            u32Bad++;
+        i++;
+    }
+    f_close(&s_sFile);
+
+    printf("%u records read, %u differ\n", i, u32Bad);
+}
+
+static void PrintStats(void)
+{
+    const SPIM_FTL_STAT_T *psStat = &s_sFtl.sStat;
+    uint32_t u32Min, u32Max;
+
+    SPIM_FtlGetWear(&s_sFtl, &u32Min, &u32Max);
+    printf("FTL since boot: %u sectors written, %u read, %u moved by GC (%u runs), %u by wear leveling,\n",
+           psStat->u32HostWrites, psStat->u32HostReads, psStat->u32GcCopies, psStat->u32GcRuns, psStat->u32WlMoves);
+    printf("                %u erases, %u errors; erase counts %u..%u\n",
+           psStat->u32Erases, psStat->u32Errors, u32Min, u32Max);
+}
+
+int32_t main(void)
+{
+    FRESULT eRes;
+    uint8_t u8Key;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, IP clock and multi-function I/O */
+    SYS_Init();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    printf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    printf("+-------------------------------------------+\n");
+    printf("|    SPIM Flash Translation Layer + FatFs   |\n");
+    printf("+-------------------------------------------+\n");
+
+    SPIM_SET_CLOCK_DIVIDER(1);          /* Set SPIM clock as HCLK divided by 2 */
+    SPIM_SET_RXCLKDLY_RDDLYSEL(0);      /* Insert 0 delay cycle. Adjust the sampling clock of received data to latch the correct data. */
+    SPIM_SET_RXCLKDLY_RDEDGE();         /* Use SPI input clock rising edge to sample received data. */
+    SPIM_SET_DCNUM(8);                  /* Set 8 dummy cycle. */
+
+    if(SPIM_InitFlash(1) != 0)
+    {
+        printf("SPIM flash initialize failed!\n");
+        while(1) {}
+    }
+
+    /* Rebuild the sector map from the block tags; erased flash mounts empty */
+    if((SPIM_PrgInit(&s_sPrg, 0, CMD_NORMAL_PAGE_PROGRAM, CMD_DMA_FAST_READ, NULL) != SPIM_OK) ||
+            (SPIM_FtlInit(&s_sFtl, &s_sPrg, FTL_BASE, FTL_BLOCKS, FTL_SPARE) != SPIM_OK) ||
+            (SPIM_FtlMount(&s_sFtl) != SPIM_OK))
+    {
+        printf("FTL mount failed!\n");
+        while(1) {}
+    }
+    g_psFtl = &s_sFtl;
+    printf("FTL: %u sectors of %u bytes at 0x%X\n", SPIM_FtlGetSectorCount(&s_sFtl), (uint32_t)SPIM_FTL_SECTOR_SIZE, (uint32_t)FTL_BASE);
+
+    eRes = f_mount(&s_sFs, "0:", 1);
+    if(eRes == FR_NO_FILESYSTEM)
+    {
+        printf("No FAT volume, formatting... ");
+        if(Format() != SPIM_OK)
+        {
+            printf("failed!\n");
+            while(1) {}
+        }
+        printf("done.\n");
+        eRes = f_mount(&s_sFs, "0:", 1);
+    }
+    if(eRes != FR_OK)
+    {
+        printf("f_mount failed (%d)!\n", eRes);
+        while(1) {}
+    }
+
+    AppendBoot();
+    printf("Press 'a' to append to LOG.CSV, 'r' to read it back, 'd' to delete it, 's' for the statistics.\n");
+
+    while(1)
+    {
+        u8Key = (uint8_t)getchar();
+
+        if(u8Key == 'a')
+            AppendLog();
+        else if(u8Key == 'r')
+            ReadLog();
+        else if(u8Key == 'd')
+            printf("Delete LOG.CSV: %s\n", (f_unlink("0:/LOG.CSV") == FR_OK) ? "done" : "failed");
+        else if(u8Key == 's')
+            PrintStats();
+    }
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/
@@ -0,0 +1,507 @@
+/**************************************************************************//**
+ * @file     trace_decode.c
+ * @version  V1.00
+ * @brief    Host side of the event trace: turns a TRACE_Dump() output into
+ *           per trace point timing, flame graph input and histograms.
+ *
+ * @details  Build: gcc -O2 -I../../../../Library/StdDriver/inc -o trace_decode trace_decode.c
+ *
+ *           The input is either the binary dump (TRACE_HDR_T and the records,
+ *           as written by SampleCode/HostSim/TRACE_Ring) or the UART output
+ *           of the TRACE_HotPath sample, whose TRACE_DUMP lines carry the same
+ *           bytes in hex; other text is skipped.
+ *
+ *           Records are paired on a stack: an EXIT closes the innermost open
+ *           ENTER of its point. Interrupts nest inside what they preempt, so a
+ *           span includes the interrupts taken during it and its self time
+ *           excludes them. EXITs without an ENTER are expected at the start of
+ *           a wrapped ring and are only counted. Timestamps are unwrapped on
+ *           the assumption that records are less than 2^32 cycles apart.
+ *
+ *           ./trace_decode summary dump
+ *               Calls, inclusive and self time, min/avg/p99/max duration per
+ *               trace point, marks, and the records lost on the target.
+ *           ./trace_decode folded dump > out.folded
+ *               Self cycles per stack, for flamegraph.pl out.folded > out.svg.
+ *               Time outside every span is "[thread]".
+ *           ./trace_decode hist dump [name]
+ *               Log2 histograms of duration and of the interval between
+ *               entries, of every trace point or of those containing name.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "trace.h"
+
+#define LINE_SIZE           512
+#define NAME_SIZE           32
+#define PATH_SIZE           512
+#define MAX_DEPTH           32
+#define MAX_MOD             64
+#define MAX_POINT           256
+#define MAX_PATHS           1024
+#define BUCKETS             33
+
+#define EVT_TYPE(e)         (((e) & TRACE_EVT_TYPE_Msk) >> TRACE_EVT_TYPE_Pos)
+#define EVT_MOD(e)          (((e) & TRACE_EVT_MOD_Msk) >> TRACE_EVT_MOD_Pos)
+#define EVT_POINT(e)        (((e) & TRACE_EVT_POINT_Msk) >> TRACE_EVT_POINT_Pos)
+
+typedef struct
+{
+    uint32_t u32Calls;
+    uint32_t u32Marks;
+    uint64_t u64Incl;
+    uint64_t u64Self;
+    uint64_t u64LastEnter;
+    uint32_t u32Durs, u32DurSize;
+    uint32_t *pu32Dur;                  /* Durations of the closed spans */
+    uint32_t au32DurHist[BUCKETS];
+    uint32_t au32GapHist[BUCKETS];
+} POINT_T;
+
+typedef struct
+{
+    POINT_T *psPoint;
+    uint32_t u32Mod, u32Point;
+    uint64_t u64Start;
+    uint64_t u64Child;                  /* Time of the spans nested in this one */
+} FRAME_T;
+
+typedef struct
+{
+    char acPath[PATH_SIZE];
+    uint64_t u64Cycles;
+} PATH_T;
+
+static const char *s_apcMod[] = { "APP", "EHCI", "PDMA", "I2S", "SDH", "CANFD" };
+
+static const char *s_apcPoint[][4] =
+{
+    { NULL },
+    { "EHCI_IRQ", "EHCI_UTR_DONE" },
+    { "PDMA_SVC_IRQ", "PDMA_XFER_DONE" },
+    { "I2S_IRQ", "I2S_UNDERRUN" },
+    { "SDH_IRQ", "SDH_READ", "SDH_WRITE" },
+    { "CANFD_IRQ", "CANFD_TX", "CANFD_RX_FIFO", "CANFD_RX_BUF" },
+};
+
+static TRACE_HDR_T s_sHdr;
+static TRACE_REC_T *s_psRec;
+static POINT_T *s_psPoint;              /* [MAX_MOD * MAX_POINT] */
+static uint64_t s_u64Start, s_u64End;
+static uint32_t s_u32Unmatched;         /* EXITs without an ENTER */
+static uint32_t s_u32Open;              /* ENTERs without an EXIT, at the end or closed by an outer EXIT */
+
+static PATH_T *s_psPath;
+static uint32_t s_u32Paths;
+
+static FILE *OpenFile(const char *pcPath, const char *pcMode)
+{
+    FILE *fp = fopen(pcPath, pcMode);
+
+    if (fp == NULL)
+    {
+        perror(pcPath);
+        exit(1);
+    }
+
+    return fp;
+}
+
+static const char *Name(uint32_t u32Mod, uint32_t u32Point)
+{
+    static char acName[NAME_SIZE];
+
+    if ((u32Mod < sizeof(s_apcMod) / sizeof(s_apcMod[0])) && (u32Point < 4) && (s_apcPoint[u32Mod][u32Point] != NULL))
+        return s_apcPoint[u32Mod][u32Point];
+
+    if (u32Mod < sizeof(s_apcMod) / sizeof(s_apcMod[0]))
+        snprintf(acName, sizeof(acName), "%s.%u", s_apcMod[u32Mod], u32Point);
+    else
+        snprintf(acName, sizeof(acName), "MOD%u.%u", u32Mod, u32Point);
+
+    return acName;
+}
+
+static double Us(uint64_t u64Cycles)
+{
+    return u64Cycles * 1e6 / s_sHdr.u32Freq;
+}
+
+static uint32_t Bucket(uint64_t u64Value)
+{
+    uint32_t u32Bucket = 0;
+
+    while ((u64Value > 1) && (u32Bucket < BUCKETS - 1))
+    {
+        u64Value >>= 1;
+        u32Bucket++;
+    }
+
+    return u32Bucket;
+}
+
+/*
+ *  The dump as bytes: the file itself, or the hex of its TRACE_DUMP lines
+ */
+static uint8_t *LoadBytes(const char *pcPath, uint32_t *pu32Len)
+{
+    char acLine[LINE_SIZE], *pc;
+    uint32_t u32Len = 0, u32Size = 0x10000, u32Byte;
+    uint8_t *pu8Buf = malloc(u32Size);
+    FILE *fp = OpenFile(pcPath, "rb");
+    size_t n;
+
+    /* Binary: starts with the magic word */
+    n = fread(pu8Buf, 1, 4, fp);
+    if ((n == 4) && (pu8Buf[0] | (pu8Buf[1] << 8) | (pu8Buf[2] << 16) | ((uint32_t)pu8Buf[3] << 24)) == TRACE_MAGIC)
+    {
+        u32Len = 4;
+        while ((n = fread(&pu8Buf[u32Len], 1, u32Size - u32Len, fp)) > 0)
+        {
+            u32Len += (uint32_t)n;
+            if (u32Len == u32Size)
+                pu8Buf = realloc(pu8Buf, u32Size *= 2);
+        }
+        fclose(fp);
+        *pu32Len = u32Len;
+        return pu8Buf;
+    }
+
+    /* UART log: "TRACE_DUMP" and hex bytes */
+    rewind(fp);
+    while (fgets(acLine, sizeof(acLine), fp) != NULL)
+    {
+        if ((pc = strstr(acLine, "TRACE_DUMP ")) == NULL)
+            continue;
+        pc += 11;
+
+        while (sscanf(pc, "%2x", &u32Byte) == 1)
+        {
+            if (u32Len == u32Size)
+                pu8Buf = realloc(pu8Buf, u32Size *= 2);
+            pu8Buf[u32Len++] = (uint8_t)u32Byte;
+            pc += 2;
+        }
+    }
+    fclose(fp);
+
+    *pu32Len = u32Len;
+    return pu8Buf;
+}
+
+static void LoadDump(const char *pcPath)
+{
+    uint32_t u32Len, u32Count;
+    uint8_t *pu8Buf = LoadBytes(pcPath, &u32Len);
+
+    if (u32Len < sizeof(TRACE_HDR_T))
+    {
+        fprintf(stderr, "%s: no trace dump\n", pcPath);
+        exit(1);
+    }
+
+    memcpy(&s_sHdr, pu8Buf, sizeof(s_sHdr));
+    if ((s_sHdr.u32Magic != TRACE_MAGIC) || (s_sHdr.u32Version != TRACE_VERSION) || (s_sHdr.u32Freq == 0))
+    {
+        fprintf(stderr, "%s: bad header (magic %08X, version %u)\n", pcPath, s_sHdr.u32Magic, s_sHdr.u32Version);
+        exit(1);
+    }
+
+    /* A dump cut short on the UART still decodes up to the last whole record */
+    u32Count = (u32Len - sizeof(TRACE_HDR_T)) / sizeof(TRACE_REC_T);
+    if (u32Count < s_sHdr.u32Count)
+    {
+        fprintf(stderr, "warning: %u records announced, %u present\n", s_sHdr.u32Count, u32Count);
+        s_sHdr.u32Count = u32Count;
+    }
+
+    s_psRec = malloc((s_sHdr.u32Count + 1) * sizeof(TRACE_REC_T));
+    memcpy(s_psRec, &pu8Buf[sizeof(TRACE_HDR_T)], s_sHdr.u32Count * sizeof(TRACE_REC_T));
+    free(pu8Buf);
+}
+
+/*
+ *  Self time of the current stack, for the folded output
+ */
+static void AddPath(const FRAME_T *psStack, uint32_t u32Depth, uint64_t u64Cycles)
+{
+    char acPath[PATH_SIZE];
+    uint32_t i;
+    int iLen;
+
+    if (u64Cycles == 0)
+        return;
+
+    iLen = snprintf(acPath, sizeof(acPath), "[thread]");
+    for (i = 0; (i < u32Depth) && (iLen < PATH_SIZE); i++)
+        iLen += snprintf(&acPath[iLen], sizeof(acPath) - iLen, ";%s", Name(psStack[i].u32Mod, psStack[i].u32Point));
+
+    for (i = 0; i < s_u32Paths; i++)
+    {
+        if (strcmp(s_psPath[i].acPath, acPath) == 0)
+        {
+            s_psPath[i].u64Cycles += u64Cycles;
+            return;
+        }
+    }
+
+    if (s_u32Paths < MAX_PATHS)
+    {
+        strcpy(s_psPath[s_u32Paths].acPath, acPath);
+        s_psPath[s_u32Paths++].u64Cycles = u64Cycles;
+    }
+}
+
+static void Close(FRAME_T *psStack, uint32_t *pu32Depth, uint64_t u64Now)
+{
+    FRAME_T *psFrame = &psStack[--*pu32Depth];
+    POINT_T *psPoint = psFrame->psPoint;
+    uint64_t u64Dur = u64Now - psFrame->u64Start;
+
+    psPoint->u32Calls++;
+    psPoint->u64Incl += u64Dur;
+    psPoint->u64Self += u64Dur - psFrame->u64Child;
+    psPoint->au32DurHist[Bucket(u64Dur)]++;
+
+    if (psPoint->u32Durs == psPoint->u32DurSize)
+    {
+        psPoint->u32DurSize = psPoint->u32DurSize ? psPoint->u32DurSize * 2 : 64;
+        psPoint->pu32Dur = realloc(psPoint->pu32Dur, psPoint->u32DurSize * sizeof(uint32_t));
+    }
+    psPoint->pu32Dur[psPoint->u32Durs++] = (u64Dur > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t)u64Dur;
+
+    if (*pu32Depth != 0)
+        psStack[*pu32Depth - 1].u64Child += u64Dur;
+}
+
+static void Analyse(void)
+{
+    FRAME_T asStack[MAX_DEPTH];
+    uint32_t i, u32Depth = 0, u32Type, u32Mod, u32Point;
+    uint64_t u64Now, u64Prev;
+    POINT_T *psPoint;
+    int j;
+
+    s_psPoint = calloc(MAX_MOD * MAX_POINT, sizeof(POINT_T));
+    s_psPath = calloc(MAX_PATHS, sizeof(PATH_T));
+    if (s_sHdr.u32Count == 0)
+        return;
+
+    u64Now = u64Prev = s_u64Start = s_psRec[0].u32Cycles;
+    for (i = 0; i < s_sHdr.u32Count; i++)
+    {
+        if (i != 0)
+            u64Now += (uint32_t)(s_psRec[i].u32Cycles - s_psRec[i - 1].u32Cycles);
+
+        AddPath(asStack, u32Depth, u64Now - u64Prev);
+        u64Prev = u64Now;
+
+        u32Type = EVT_TYPE(s_psRec[i].u32Event);
+        u32Mod = EVT_MOD(s_psRec[i].u32Event);
+        u32Point = EVT_POINT(s_psRec[i].u32Event);
+        psPoint = &s_psPoint[u32Mod * MAX_POINT + u32Point];
+
+        if (u32Type == TRACE_TYPE_MARK)
+        {
+            psPoint->u32Marks++;
+        }
+        else if (u32Type == TRACE_TYPE_ENTER)
+        {
+            if (psPoint->u64LastEnter != 0)
+                psPoint->au32GapHist[Bucket(u64Now - psPoint->u64LastEnter)]++;
+            psPoint->u64LastEnter = u64Now;
+
+            if (u32Depth == MAX_DEPTH)
+            {
+                s_u32Open++;
+                continue;
+            }
+            asStack[u32Depth].psPoint = psPoint;
+            asStack[u32Depth].u32Mod = u32Mod;
+            asStack[u32Depth].u32Point = u32Point;
+            asStack[u32Depth].u64Start = u64Now;
+            asStack[u32Depth].u64Child = 0;
+            u32Depth++;
+        }
+        else if (u32Type == TRACE_TYPE_EXIT)
+        {
+            /* The innermost open span of the point; spans above it lost their EXIT */
+            for (j = (int)u32Depth - 1; (j >= 0) && (asStack[j].psPoint != psPoint); j--) {}
+
+            if (j < 0)
+            {
+                s_u32Unmatched++;
+                continue;
+            }
+            while (u32Depth > (uint32_t)j + 1)
+            {
+                s_u32Open++;
+                u32Depth--;
+            }
+            Close(asStack, &u32Depth, u64Now);
+        }
+    }
+
+    s_u64End = u64Now;
+    s_u32Open += u32Depth;
+}
+
+static int ByU32(const void *pvA, const void *pvB)
+{
+    uint32_t u32A = *(const uint32_t *)pvA, u32B = *(const uint32_t *)pvB;
+
+    return (u32A > u32B) - (u32A < u32B);
+}
+
+static int ByIncl(const void *pvA, const void *pvB)
+{
+    const POINT_T *psA = *(POINT_T * const *)pvA, *psB = *(POINT_T * const *)pvB;
+
+    return (psA->u64Incl < psB->u64Incl) - (psA->u64Incl > psB->u64Incl);
+}
+
+static void Header(void)
+{
+    printf("%u records over %.1f us at %u Hz, %u lost on the target, %u EXIT(s) without ENTER, %u span(s) left open\n\n",
+           s_sHdr.u32Count, Us(s_u64End - s_u64Start), s_sHdr.u32Freq, s_sHdr.u32Lost, s_u32Unmatched, s_u32Open);
+}
+
+static int Summary(void)
+{
+    POINT_T **ppsRank = malloc(MAX_MOD * MAX_POINT * sizeof(POINT_T *));
+    POINT_T *psPoint;
+    uint32_t i, u32Ranked = 0, u32Idx;
+    uint64_t u64Span = (s_u64End > s_u64Start) ? (s_u64End - s_u64Start) : 1;
+
+    Header();
+    for (i = 0; i < MAX_MOD * MAX_POINT; i++)
+    {
+        if (s_psPoint[i].u32Calls || s_psPoint[i].u32Marks)
+            ppsRank[u32Ranked++] = &s_psPoint[i];
+    }
+    qsort(ppsRank, u32Ranked, sizeof(POINT_T *), ByIncl);
+
+    printf("trace point          calls  incl %%  self %%     min us     avg us     p99 us     max us   marks\n");
+    for (i = 0; i < u32Ranked; i++)
+    {
+        psPoint = ppsRank[i];
+        u32Idx = (uint32_t)(psPoint - s_psPoint);
+        printf("%-18s %7u", Name(u32Idx / MAX_POINT, u32Idx % MAX_POINT), psPoint->u32Calls);
+
+        if (psPoint->u32Calls != 0)
+        {
+            qsort(psPoint->pu32Dur, psPoint->u32Durs, sizeof(uint32_t), ByU32);
+            printf("  %6.2f  %6.2f %10.2f %10.2f %10.2f %10.2f", psPoint->u64Incl * 100.0 / u64Span,
+                   psPoint->u64Self * 100.0 / u64Span, Us(psPoint->pu32Dur[0]),
+                   Us(psPoint->u64Incl) / psPoint->u32Calls, Us(psPoint->pu32Dur[(psPoint->u32Durs - 1) * 99 / 100]),
+                   Us(psPoint->pu32Dur[psPoint->u32Durs - 1]));
+        }
+        else
+        {
+            printf("  %6s  %6s %10s %10s %10s %10s", "-", "-", "-", "-", "-", "-");
+        }
+        printf(" %7u\n", psPoint->u32Marks);
+    }
+
+    free(ppsRank);
+    return 0;
+}
+
+static int Folded(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_u32Paths; i++)
+        printf("%s %llu\n", s_psPath[i].acPath, (unsigned long long)s_psPath[i].u64Cycles);
+
+    if (s_u32Paths == MAX_PATHS)
+        fprintf(stderr, "warning: more than %u stacks, the rest is left out\n", MAX_PATHS);
+
+    return 0;
+}
+
+static void PrintHist(const char *pcTitle, const uint32_t *pu32Hist)
+{
+    uint32_t i, u32First = BUCKETS, u32Last = 0, u32Max = 0;
+
+    for (i = 0; i < BUCKETS; i++)
+    {
+        if (pu32Hist[i] == 0)
+            continue;
+        if (u32First == BUCKETS)
+            u32First = i;
+        u32Last = i;
+        if (pu32Hist[i] > u32Max)
+            u32Max = pu32Hist[i];
+    }
+    if (u32Max == 0)
+        return;
+
+    printf("  %s\n", pcTitle);
+    for (i = u32First; i <= u32Last; i++)
+    {
+        printf("  %10.2f us %7u |%.*s\n", Us(1ull << i), pu32Hist[i], (int)((pu32Hist[i] * 50 + u32Max - 1) / u32Max),
+               "##################################################");
+    }
+}
+
+static int Hist(const char *pcFilter)
+{
+    uint32_t i;
+    const char *pcName;
+
+    Header();
+    for (i = 0; i < MAX_MOD * MAX_POINT; i++)
+    {
+        if (s_psPoint[i].u32Calls == 0)
+            continue;
+
+        pcName = Name(i / MAX_POINT, i % MAX_POINT);
+        if ((pcFilter != NULL) && (strstr(pcName, pcFilter) == NULL))
+            continue;
+
+        printf("%s: %u calls\n", pcName, s_psPoint[i].u32Calls);
+        PrintHist("duration, from", s_psPoint[i].au32DurHist);
+        PrintHist("interval between entries, from", s_psPoint[i].au32GapHist);
+        printf("\n");
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc >= 3) && (argc <= 4))
+    {
+        if ((argc == 3) && (strcmp(argv[1], "summary") == 0))
+        {
+            LoadDump(argv[2]);
+            Analyse();
+            return Summary();
+        }
+
+        if ((argc == 3) && (strcmp(argv[1], "folded") == 0))
+        {
+            LoadDump(argv[2]);
+            Analyse();
+            return Folded();
+        }
+
+        if (strcmp(argv[1], "hist") == 0)
+        {
+            LoadDump(argv[2]);
+            Analyse();
+            return Hist((argc == 4) ? argv[3] : NULL);
+        }
+    }
+
+    fprintf(stderr, "Usage: %s summary dump\n"
+            "       %s folded  dump > out.folded\n"
+            "       %s hist    dump [name]\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,321 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @version  V1.00
+ * @brief    Trace the interrupt hot paths of a PDMA and CAN FD workload with
+ *           the cycle-stamped event ring and dump it for the host decoder.
+ *
+ * @details  TIMER0 ticks at 1 kHz: each tick submits a 4 KB memory copy to the
+ *           PDMA channel service and every fifth one sends a CAN FD frame on
+ *           CANFD0 in internal loopback. The CAN FD interrupt, above TIMER0
+ *           above PDMA, reads the frame from Rx FIFO 1. The main loop checks
+ *           the copies, one traced span per pass.
+ *           The project defines TRACE_MODULES as 0x25 (APP, PDMA and CAN FD),
+ *           so pdma.c and canfd.c record their trace points and the other
+ *           drivers build without them. The ring keeps the newest 2048 records.
+ *           Press 'd' to dump it as TRACE_DUMP lines; save the UART output and
+ *           run HostTool/trace_decode on it:
+ *               ./trace_decode summary uart.log
+ *               ./trace_decode folded uart.log > hot.folded
+ *               ./trace_decode hist uart.log CANFD
+ *           The host check of the ring is SampleCode/HostSim/TRACE_Ring.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include "NuMicro.h"
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define global variables and constants                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define RING_SIZE           2048
+#define POOL_SIZE           4
+#define COPY_SIZE           4096
+#define CAN_PERIOD_MS       5
+#define DUMP_LINE           32
+
+/* Application trace points */
+#define APP_TICK            0               /* TMR0_IRQHandler(), argument tick */
+#define APP_CHECK           1               /* Copy check of the main loop, argument errors so far */
+#define APP_COPY_BUSY       2               /* Mark: previous copy still running at the tick */
+
+#define MEM_CTL             (PDMA_WIDTH_32 | PDMA_SAR_INC | PDMA_DAR_INC | PDMA_REQ_BURST | PDMA_BURST_128)
+
+static TRACE_REC_T s_asRing[RING_SIZE];
+static DSCT_T s_asPool[POOL_SIZE];
+static PDMA_SVC_T s_sSvc;
+static PDMA_SEG_T s_sSeg;
+static PDMA_XFER_T s_sXfer;
+static uint32_t s_u32Ch;
+
+static uint32_t s_au32Src[COPY_SIZE / 4];
+static uint32_t s_au32Dst[COPY_SIZE / 4];
+
+static CANFD_FD_MSG_T s_sTxMsg;
+static CANFD_FD_MSG_T s_sRxMsg;
+
+static volatile uint32_t s_u32Ticks;
+static volatile uint32_t s_u32CopyBusy;
+static volatile uint32_t s_u32Copies;       /* Copies done */
+static volatile uint32_t s_u32RxFrames;
+static uint32_t s_u32Errors;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Define functions prototype                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void);
+void SYS_Init(void);
+void UART0_Init(void);
+void TMR0_IRQHandler(void);
+void PDMA0_IRQHandler(void);
+void CANFD00_IRQHandler(void);
+
+
+static void CopyDone(PDMA_XFER_T *psXfer, int32_t i32Status)
+{
+    (void)psXfer;
+
+    if(i32Status != 0)
+        s_u32Errors++;
+
+    s_u32CopyBusy = 0;
+    s_u32Copies++;
+}
+
+/**
+ * @brief       IRQ Handler for Timer0 Interrupt
+ * @param       None
+ * @return      None
+ * @details     Submits a copy every tick and sends a CAN FD frame every CAN_PERIOD_MS ticks.
+ */
+void TMR0_IRQHandler(void)
+{
+    uint32_t u32Tick = ++s_u32Ticks;
+
+    TRACE_ENTER(APP, APP_TICK, u32Tick);
+    TIMER_ClearIntFlag(TIMER0);
+
+    if(s_u32CopyBusy)
+    {
+        TRACE_MARK(APP, APP_COPY_BUSY, u32Tick);
+    }
+    else
+    {
+        s_u32CopyBusy = 1;
+        s_au32Src[0] = u32Tick;
+        PDMA_SvcSubmit(&s_sSvc, s_u32Ch, &s_sXfer);
+    }
+
+    if((u32Tick % CAN_PERIOD_MS) == 0)
+    {
+        s_sTxMsg.au8Data[0] = (uint8_t)u32Tick;
+        CANFD_TransmitTxMsg(CANFD0, 0, &s_sTxMsg);
+    }
+
+    TRACE_EXIT(APP, APP_TICK, u32Tick);
+}
+
+void PDMA0_IRQHandler(void)
+{
+    PDMA_SvcIRQHandler(&s_sSvc);
+}
+
+/**
+ * @brief       IRQ Handler for CAN FD0 Line0 Interrupt
+ * @param       None
+ * @return      None
+ * @details     Reads the frame received in Rx FIFO 1.
+ */
+void CANFD00_IRQHandler(void)
+{
+    TRACE_ENTER(CANFD, TRACE_CANFD_IRQ, 0);
+
+    CANFD_ClearStatusFlag(CANFD0, CANFD_IR_TOO_Msk | CANFD_IR_RF1N_Msk);
+    if(CANFD_ReadRxFifoMsg(CANFD0, 1, &s_sRxMsg))
+        s_u32RxFrames++;
+
+    TRACE_EXIT(CANFD, TRACE_CANFD_IRQ, s_sRxMsg.u32Id);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Trace dump on UART0                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+static void DumpPut(void *pvPriv, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t i;
+
+    (void)pvPriv;
+
+    for(i = 0; i < u32Len; i++)
+    {
+        if((i % DUMP_LINE) == 0)
+            printf("TRACE_DUMP ");
+        printf("%02X", pu8Data[i]);
+        if(((i % DUMP_LINE) == (DUMP_LINE - 1)) || (i == u32Len - 1))
+            printf("\n");
+    }
+}
+
+static void Dump(void)
+{
+    uint32_t u32Count;
+
+    /* Stopped while the lines go out, which takes far longer than the ring covers */
+    TRACE_Stop();
+    printf("\nTrace of ticks up to %u, %u frames received, %u copy errors:\n", s_u32Ticks, s_u32RxFrames, s_u32Errors);
+    u32Count = TRACE_Dump(DumpPut, NULL);
+    printf("%u records dumped\n\n", u32Count);
+    TRACE_Start();
+}
+
+void SYS_Init(void)
+{
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init System Clock                                                                                       */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Enable HIRC clock */
+    CLK_EnableXtalRC(CLK_PWRCTL_HIRCEN_Msk);
+
+    /* Wait for HIRC clock ready */
+    CLK_WaitClockReady(CLK_STATUS_HIRCSTB_Msk);
+
+    /* Set PCLK0 and PCLK1 to HCLK/2 */
+    CLK->PCLKDIV = (CLK_PCLKDIV_APB0DIV_DIV2 | CLK_PCLKDIV_APB1DIV_DIV2);
+
+    /* Set core clock to 200MHz */
+    CLK_SetCoreClock(200000000);
+
+    /* Enable UART0, TIMER0, PDMA0 and CAN FD0 module clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_EnableModuleClock(TMR0_MODULE);
+    CLK_EnableModuleClock(PDMA0_MODULE);
+    CLK_EnableModuleClock(CANFD0_MODULE);
+
+    /* Select UART0 and TIMER0 module clock source as HIRC, CAN FD0 as HCLK */
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HIRC, CLK_CLKDIV0_UART0(1));
+    CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HIRC, 0);
+    CLK_SetModuleClock(CANFD0_MODULE, CLK_CLKSEL0_CANFD0SEL_HCLK, CLK_CLKDIV5_CANFD0(1));
+
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Init I/O Multi-function                                                                                 */
+    /*---------------------------------------------------------------------------------------------------------*/
+    /* Set multi-function pins for UART0 RXD and TXD */
+    SET_UART0_RXD_PB12();
+    SET_UART0_TXD_PB13();
+}
+
+void UART0_Init(void)
+{
+    /* Reset UART0 */
+    SYS_ResetModule(UART0_RST);
+
+    /* Configure UART0 and set UART0 baud rate */
+    UART_Open(UART0, 115200);
+}
+
+static void CANFD_Init(void)
+{
+    CANFD_FD_T sConfig;
+
+    CANFD_GetDefaultConfig(&sConfig, CANFD_OP_CAN_FD_MODE);
+    sConfig.sBtConfig.bEnableLoopBack = TRUE;
+    sConfig.sBtConfig.sNormBitRate.u32BitRate = 1000000;
+    sConfig.sBtConfig.sDataBitRate.u32BitRate = 4000000;
+    CANFD_Open(CANFD0, &sConfig);
+
+    /* Receive 0x110 ~ 0x11F in Rx FIFO 1, reject the rest */
+    CANFD_SetSIDFltr(CANFD0, 0, CANFD_RX_FIFO1_STD_MASK(0x110, 0x7F0));
+    CANFD_SetGFC(CANFD0, eCANFD_REJ_NON_MATCH_FRM, eCANFD_REJ_NON_MATCH_FRM, 1, 1);
+
+    /* Rx FIFO 1 new message interrupt on line 0 */
+    CANFD_EnableInt(CANFD0, (CANFD_IE_TOOE_Msk | CANFD_IE_RF1NE_Msk), 0, 0, 0);
+    CANFD_RunToNormal(CANFD0, TRUE);
+
+    s_sTxMsg.u32Id = 0x111;
+    s_sTxMsg.eIdType = eCANFD_SID;
+    s_sTxMsg.bFDFormat = 1;
+    s_sTxMsg.bBitRateSwitch = 1;
+    s_sTxMsg.u32DLC = 64;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Main Function                                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    uint32_t i, u32Checked = 0;
+
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Init System, peripheral clock and multi-function I/O */
+    SYS_Init();
+
+    /* Lock protected registers */
+    SYS_LockReg();
+
+    /* Init UART0 for printf */
+    UART0_Init();
+
+    printf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    printf("+------------------------------------------+\n");
+    printf("|      Event Trace Hot Path Sample Code    |\n");
+    printf("+------------------------------------------+\n\n");
+    printf("Press 'd' to dump the trace ring.\n");
+
+    if((TRACE_Init(s_asRing, RING_SIZE, TRACE_MODE_WRAP) != TRACE_OK) ||
+            (PDMA_SvcInit(&s_sSvc, PDMA0, s_asPool, POOL_SIZE, PDMA_SCATBA_SET, 0, NULL) != 0) ||
+            ((int32_t)(s_u32Ch = (uint32_t)PDMA_SvcAllocCh(&s_sSvc, PDMA_SVC_CH_ANY)) < 0))
+    {
+        printf("Init failed\n");
+        while(1) {}
+    }
+
+    for(i = 0; i < COPY_SIZE / 4; i++)
+        s_au32Src[i] = i * 0x01010101;
+    s_sSeg.u32SrcAddr = (uint32_t)s_au32Src;
+    s_sSeg.u32DstAddr = (uint32_t)s_au32Dst;
+    s_sSeg.u32TransCount = COPY_SIZE / 4;
+    PDMA_SvcInitXfer(&s_sXfer, &s_sSeg, 1, PDMA_MEM, MEM_CTL, CopyDone, NULL);
+
+    CANFD_Init();
+
+    /* CAN FD preempts TIMER0, which preempts PDMA */
+    NVIC_SetPriority(CANFD00_IRQn, 1);
+    NVIC_SetPriority(TMR0_IRQn, 2);
+    NVIC_SetPriority(PDMA0_IRQn, 3);
+    NVIC_EnableIRQ(CANFD00_IRQn);
+    NVIC_EnableIRQ(PDMA0_IRQn);
+
+    TRACE_Start();
+
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 1000);
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+    TIMER_Start(TIMER0);
+
+    while(1)
+    {
+        if(!UART_GET_RX_EMPTY(UART0) && (UART_READ(UART0) == 'd'))
+            Dump();
+
+        if(s_u32Copies == u32Checked)
+            continue;
+        u32Checked = s_u32Copies;
+
+        /* Check the copy; a tick may start the next one meanwhile, which only changes word 0 */
+        TRACE_ENTER(APP, APP_CHECK, s_u32Errors);
+        for(i = 1; i < COPY_SIZE / 4; i++)
+        {
+            if(s_au32Dst[i] != s_au32Src[i])
+            {
+                s_u32Errors++;
+                break;
+            }
+        }
+        TRACE_EXIT(APP, APP_CHECK, s_u32Errors);
+    }
+}
+
+/*** (C) COPYRIGHT 2023 Nuvoton Technology Corp. ***/